@@ -22,6 +22,8 @@
 
 #include <TelepathyQt/AbstractClient>
 
+#include <QMetaObject>
+#include <QPointer>
 #include <QSharedData>
 #include <QString>
 
@@ -33,11 +35,32 @@ namespace Tp
 struct TP_QT_NO_EXPORT AbstractClient::Private
 {
     Private()
-        : registered(false)
+        : registered(false),
+          dispatchOrdering(AbstractClient::DispatchInOrder),
+          maxPendingDispatches(0)
     {
+        resetDispatchStatistics();
+    }
+
+    void resetDispatchStatistics()
+    {
+        dispatchCount = 0;
+        totalPreparationTime = 0;
+        totalQueueWaitTime = 0;
+        maxQueueWaitTime = 0;
     }
 
     bool registered;
+
+    AbstractClient::DispatchOrdering dispatchOrdering;
+    int maxPendingDispatches;
+    // The adaptors queueing the invocations of this client
+    QList<QPointer<QObject> > dispatchQueues;
+
+    uint dispatchCount;
+    qint64 totalPreparationTime;
+    qint64 totalQueueWaitTime;
+    int maxQueueWaitTime;
 };
 
 
@@ -118,6 +141,189 @@ void AbstractClient::setRegistered(bool registered)
     mPriv->registered = registered;
 }
 
+/**
+ * \enum AbstractClient::DispatchOrdering
+ *
+ * Specifies in which order the observeChannels(), addDispatchOperation() and handleChannels()
+ * invocations of a client are delivered, relative to the order in which the channel dispatcher
+ * called the client.
+ *
+ * Before a client is invoked, the proxies passed to it are made ready with the features set on the
+ * factories of the ClientRegistrar. This can take a while for some channels, for instance a big
+ * chat room whose members need to be introspected.
+ *
+ * \sa setDispatchOrdering()
+ */
+
+/**
+ * \var AbstractClient::DispatchOrdering AbstractClient::DispatchInOrder
+ *
+ * Invocations are delivered in exactly the order they were received in. An invocation whose
+ * proxies take long to become ready delays all invocations received after it. This is the default.
+ */
+
+/**
+ * \var AbstractClient::DispatchOrdering AbstractClient::DispatchInOrderPerAccount
+ *
+ * Invocations for the same account are delivered in the order they were received in, but an
+ * invocation whose proxies take long to become ready doesn't delay invocations for other
+ * accounts.
+ */
+
+/**
+ * \var AbstractClient::DispatchOrdering AbstractClient::DispatchUnordered
+ *
+ * Every invocation is delivered as soon as its proxies are ready, regardless of the order they
+ * were received in.
+ */
+
+/**
+ * Return the order in which the invocations of this client are delivered.
+ *
+ * \return The ordering as #DispatchOrdering.
+ * \sa setDispatchOrdering()
+ */
+AbstractClient::DispatchOrdering AbstractClient::dispatchOrdering() const
+{
+    return mPriv->dispatchOrdering;
+}
+
+/**
+ * Set the order in which the invocations of this client are delivered.
+ *
+ * The default is #DispatchInOrder. Clients which don't depend on the relative order of their
+ * invocations, e.g. because they treat every account independently, can relax it so that slow
+ * channels don't hold back unrelated ones.
+ *
+ * The ordering should be set before the client is registered, but changing it later takes effect
+ * for the invocations which are pending at that point as well: the ones which were only held back
+ * by the previous ordering are delivered from the event loop.
+ *
+ * \param ordering The ordering as #DispatchOrdering.
+ * \sa dispatchOrdering()
+ */
+void AbstractClient::setDispatchOrdering(DispatchOrdering ordering)
+{
+    if (mPriv->dispatchOrdering == ordering) {
+        return;
+    }
+
+    mPriv->dispatchOrdering = ordering;
+    foreach (const QPointer<QObject> &queue, mPriv->dispatchQueues) {
+        if (queue) {
+            QMetaObject::invokeMethod(queue, "deliverInvocations", Qt::QueuedConnection);
+        }
+    }
+}
+
+/**
+ * Return the maximum number of invocations of this client which can be pending at the same time,
+ * per client interface.
+ *
+ * \return The maximum number of pending invocations, or 0 if unlimited.
+ * \sa setMaxPendingDispatches()
+ */
+int AbstractClient::maxPendingDispatches() const
+{
+    return mPriv->maxPendingDispatches;
+}
+
+/**
+ * Set the maximum number of invocations of this client which can be pending at the same time,
+ * per client interface.
+ *
+ * An invocation is pending while its proxies are being made ready or while it waits for earlier
+ * invocations to be delivered, as specified by dispatchOrdering(). When the limit is reached,
+ * further invocations are failed with #TP_QT_ERROR_BUSY right away, which makes the channel
+ * dispatcher try another client or close the channels.
+ *
+ * The default is 0, meaning no limit.
+ *
+ * \param max The maximum number of pending invocations, or 0 for no limit.
+ * \sa maxPendingDispatches()
+ */
+void AbstractClient::setMaxPendingDispatches(int max)
+{
+    mPriv->maxPendingDispatches = qMax(max, 0);
+}
+
+/**
+ * Return the number of invocations delivered to this client since it was created or since the
+ * last call to resetDispatchStatistics().
+ *
+ * Invocations which failed because their proxies couldn't be made ready are not counted.
+ *
+ * \return The number of delivered invocations.
+ * \sa totalPreparationTime(), totalQueueWaitTime()
+ */
+uint AbstractClient::dispatchCount() const
+{
+    return mPriv->dispatchCount;
+}
+
+/**
+ * Return the time spent making the proxies passed to the delivered invocations ready, in
+ * milliseconds.
+ *
+ * The time of each invocation is measured from when it was received from the channel dispatcher
+ * until all its proxies were ready, and the times are summed up.
+ *
+ * \return The total preparation time in milliseconds.
+ * \sa dispatchCount(), totalQueueWaitTime()
+ */
+qint64 AbstractClient::totalPreparationTime() const
+{
+    return mPriv->totalPreparationTime;
+}
+
+/**
+ * Return the time the delivered invocations spent waiting for earlier invocations after their
+ * proxies were ready, in milliseconds.
+ *
+ * This is the delay caused by dispatchOrdering(), and is always 0 for #DispatchUnordered.
+ *
+ * \return The total queue wait time in milliseconds.
+ * \sa maxQueueWaitTime(), dispatchCount(), totalPreparationTime()
+ */
+qint64 AbstractClient::totalQueueWaitTime() const
+{
+    return mPriv->totalQueueWaitTime;
+}
+
+/**
+ * Return the longest time a single delivered invocation spent waiting for earlier invocations
+ * after its proxies were ready, in milliseconds.
+ *
+ * \return The maximum queue wait time in milliseconds.
+ * \sa totalQueueWaitTime()
+ */
+int AbstractClient::maxQueueWaitTime() const
+{
+    return mPriv->maxQueueWaitTime;
+}
+
+/**
+ * Reset dispatchCount(), totalPreparationTime(), totalQueueWaitTime() and maxQueueWaitTime() to 0.
+ */
+void AbstractClient::resetDispatchStatistics()
+{
+    mPriv->resetDispatchStatistics();
+}
+
+void AbstractClient::addDispatchQueue(QObject *adaptor)
+{
+    mPriv->dispatchQueues.removeAll(QPointer<QObject>());
+    mPriv->dispatchQueues.append(QPointer<QObject>(adaptor));
+}
+
+void AbstractClient::recordDispatch(int preparationTime, int queueWaitTime)
+{
+    ++mPriv->dispatchCount;
+    mPriv->totalPreparationTime += preparationTime;
+    mPriv->totalQueueWaitTime += queueWaitTime;
+    mPriv->maxQueueWaitTime = qMax(mPriv->maxQueueWaitTime, queueWaitTime);
+}
+
 struct TP_QT_NO_EXPORT AbstractClientObserver::Private
 {
     Private(const ChannelClassList &channelFilter, bool shouldRecover)
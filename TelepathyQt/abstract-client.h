@@ -51,12 +51,35 @@ public:
     AbstractClient();
     virtual ~AbstractClient();
 
+    enum DispatchOrdering {
+        DispatchInOrder = 0,
+        DispatchInOrderPerAccount = 1,
+        DispatchUnordered = 2
+    };
+
     bool isRegistered() const;
 
+    DispatchOrdering dispatchOrdering() const;
+    void setDispatchOrdering(DispatchOrdering ordering);
+
+    int maxPendingDispatches() const;
+    void setMaxPendingDispatches(int max);
+
+    uint dispatchCount() const;
+    qint64 totalPreparationTime() const;
+    qint64 totalQueueWaitTime() const;
+    int maxQueueWaitTime() const;
+    void resetDispatchStatistics();
+
 private:
     friend class ClientRegistrar;
+    friend class ClientObserverAdaptor;
+    friend class ClientApproverAdaptor;
+    friend class ClientHandlerAdaptor;
 
     void setRegistered(bool registered);
+    void addDispatchQueue(QObject *adaptor);
+    void recordDispatch(int preparationTime, int queueWaitTime);
 
     struct Private;
     friend struct Private;
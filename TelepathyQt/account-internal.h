@@ -0,0 +1,96 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_account_internal_h_HEADER_GUARD_
+#define _TelepathyQt_account_internal_h_HEADER_GUARD_
+
+#include <TelepathyQt/Account>
+#include <TelepathyQt/PendingOperation>
+
+#include <QDBusConnection>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QString>
+#include <QVariantMap>
+
+class QDBusPendingCallWatcher;
+
+namespace Tp
+{
+
+class TP_QT_NO_EXPORT PendingAccountProperties : public PendingOperation
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PendingAccountProperties)
+
+public:
+    PendingAccountProperties(const AccountPtr &account);
+    ~PendingAccountProperties();
+
+    QString busName() const { return mBusName; }
+    QVariantMap result() const { return mResult; }
+
+private:
+    friend class AccountPropertiesBatch;
+
+    void setResult(const QVariantMap &result);
+    void setError(const QDBusError &error);
+
+    QString mBusName;
+    QVariantMap mResult;
+};
+
+// Retrieves the main properties of all the accounts on a bus, with a bounded number of calls in
+// flight. It only lives while there are requests to serve.
+class TP_QT_NO_EXPORT AccountPropertiesBatch : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AccountPropertiesBatch)
+
+public:
+    static AccountPropertiesBatch *forBus(const QDBusConnection &bus);
+
+    ~AccountPropertiesBatch();
+
+    PendingAccountProperties *requestProperties(const AccountPtr &account);
+
+private Q_SLOTS:
+    void gotProperties(QDBusPendingCallWatcher *watcher);
+
+private:
+    AccountPropertiesBatch(const QDBusConnection &bus);
+
+    void sendRequests();
+    void finishRequests(const QString &objectPath, const QVariantMap &props);
+    void releaseIfIdle();
+
+    static QHash<QString, AccountPropertiesBatch *> batches;
+
+    QDBusConnection mBus;
+    QHash<QString, QList<PendingAccountProperties *> > mRequests;
+    QQueue<QString> mQueue;
+    QHash<QDBusPendingCallWatcher *, QString> mCalls;
+};
+
+} // Tp
+
+#endif
@@ -26,6 +26,7 @@
 #include "TelepathyQt/_gen/cli-account-manager.moc.hpp"
 #include "TelepathyQt/_gen/cli-account-manager-body.hpp"
 
+#include "TelepathyQt/account-set-internal.h"
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/AccountCapabilityFilter>
@@ -84,6 +85,15 @@ struct TP_QT_NO_EXPORT AccountManager::Private
     QHash<QString, AccountPtr> incompleteAccounts;
     QHash<QString, AccountPtr> accounts;
     QStringList supportedAccountProperties;
+
+    // Shared by all the AccountSets filtering the accounts
+    AccountSetIndex *accountSetIndex;
+
+    // account change notification coalescing
+    int changesBatchInterval;
+    bool changesBatchScheduled;
+    QList<AccountPtr> changedAccounts;
+    QHash<QString, QStringList> accountChanges;
 };
 
 static const int maxReintrospectionRetries = 5;
@@ -101,9 +111,12 @@ AccountManager::Private::Private(AccountManager *parent,
       chanFactory(chanFactory),
       contactFactory(contactFactory),
       reintrospectionRetries(0),
-      gotInitialAccounts(false)
+      gotInitialAccounts(false),
+      accountSetIndex(0),
+      changesBatchInterval(-1),
+      changesBatchScheduled(false)
 {
-    debug() << "Creating new AccountManager:" << parent->busName();
+    tpDebug() << "Creating new AccountManager:" << parent->busName();
 
     if (accFactory->dbusConnection().name() != parent->dbusConnection().name()) {
         warning() << "  The D-Bus connection in the account factory is not the proxy connection";
@@ -136,9 +149,19 @@ AccountManager::Private::Private(AccountManager *parent,
 
 AccountManager::Private::~Private()
 {
+    delete accountSetIndex;
     delete baseInterface;
 }
 
+AccountSetIndex *AccountSetIndex::forAccountManager(AccountManager *accountManager)
+{
+    AccountSetIndex *&index = accountManager->mPriv->accountSetIndex;
+    if (!index) {
+        index = new AccountSetIndex(accountManager);
+    }
+    return index;
+}
+
 void AccountManager::Private::init()
 {
     if (!parent->isValid()) {
@@ -155,7 +178,7 @@ void AccountManager::Private::init()
 
 void AccountManager::Private::introspectMain(AccountManager::Private *self)
 {
-    debug() << "Calling Properties::GetAll(AccountManager)";
+    tpDebug() << "Calling Properties::GetAll(AccountManager)";
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
             self->properties->GetAll(
                 TP_QT_IFACE_ACCOUNT_MANAGER),
@@ -857,6 +880,9 @@ AccountSetPtr AccountManager::accountsByProtocol(
  *
  * See AccountSet documentation for more details.
  *
+ * Each call returns a new AccountSet. The sets filtering the accounts of an AccountManager share
+ * the work of tracking account changes, so having many of them alive is cheap.
+ *
  * This method requires AccountManager::FeatureCore to be ready.
  *
  * \param filter The desired filter.
@@ -913,6 +939,9 @@ AccountSetPtr AccountManager::filterAccounts(const AccountFilterConstPtr &filter
  *
  * See AccountSet documentation for more details.
  *
+ * Each call returns a new AccountSet. The sets filtering the accounts of an AccountManager share
+ * the work of tracking account changes, so having many of them alive is cheap.
+ *
  * This method requires AccountManager::FeatureCore to be ready.
  *
  * \param filter The desired filter.
@@ -1030,6 +1059,40 @@ PendingAccount *AccountManager::createAccount(const QString &connectionManager,
             protocol, displayName, parameters, properties);
 }
 
+/**
+ * Return the interval used to coalesce account change notifications, in milliseconds.
+ *
+ * \return The coalescing interval, or a negative value if coalescing is disabled.
+ * \sa setAccountChangesCoalescingInterval()
+ */
+int AccountManager::accountChangesCoalescingInterval() const
+{
+    return mPriv->changesBatchInterval;
+}
+
+/**
+ * Set the interval used to coalesce account change notifications to \a msecs.
+ *
+ * When enabled, the property changes of the accounts of this account manager are collected for
+ * the given interval and then reported by a few accountsChanged() signals, one for each set of
+ * changed properties, in addition to the Account::propertyChanged() signal and the
+ * specific change notification signals of each account.
+ *
+ * A value of 0 reports the changes made within the same main loop iteration. The default
+ * value of -1 disables coalescing, and accountsChanged() is not emitted at all.
+ *
+ * \param msecs The coalescing interval in milliseconds.
+ * \sa accountChangesCoalescingInterval(), accountsChanged()
+ */
+void AccountManager::setAccountChangesCoalescingInterval(int msecs)
+{
+    mPriv->changesBatchInterval = msecs;
+    if (msecs < 0) {
+        mPriv->changedAccounts.clear();
+        mPriv->accountChanges.clear();
+    }
+}
+
 /**
  * Return the Client::AccountManagerInterface interface proxy object for this
  * account manager. This method is protected since the convenience methods
@@ -1057,7 +1120,7 @@ void AccountManager::gotMainProperties(QDBusPendingCallWatcher *watcher)
     if (!reply.isError()) {
         mPriv->gotInitialAccounts = true;
 
-        debug() << "Got reply to Properties.GetAll(AccountManager)";
+        tpDebug() << "Got reply to Properties.GetAll(AccountManager)";
         props = reply.value();
 
         if (props.contains(QLatin1String("Interfaces"))) {
@@ -1113,6 +1176,9 @@ void AccountManager::onAccountReady(Tp::PendingOperation *op)
     // emitted twice for an account, and AccountSets getting confused as a result
     Q_ASSERT(!mPriv->accounts.contains(path));
     mPriv->accounts.insert(path, account);
+    connect(account.data(),
+            SIGNAL(propertyChanged(QString)),
+            SLOT(onAccountPropertyChanged(QString)));
 
     if (isReady(FeatureCore)) {
         emit newAccount(account);
@@ -1132,7 +1198,7 @@ void AccountManager::onAccountValidityChanged(const QDBusObjectPath &objectPath,
 
     if (!mPriv->incompleteAccounts.contains(path) &&
         !mPriv->accounts.contains(path)) {
-        debug() << "New account" << path;
+        tpDebug() << "New account" << path;
         mPriv->addAccountForPath(path);
     }
 }
@@ -1147,20 +1213,77 @@ void AccountManager::onAccountRemoved(const QDBusObjectPath &objectPath)
 
     /* the account is either in mPriv->incompleteAccounts or mPriv->accounts */
     if (mPriv->accounts.contains(path)) {
-        mPriv->accounts.remove(path);
+        AccountPtr account = mPriv->accounts.take(path);
+        account->disconnect(this);
+        if (mPriv->accountChanges.remove(path)) {
+            mPriv->changedAccounts.removeOne(account);
+        }
 
         if (isReady(FeatureCore)) {
-            debug() << "Account" << path << "removed";
+            tpDebug() << "Account" << path << "removed";
         } else {
-            debug() << "Account" << path << "removed while the AM "
+            tpDebug() << "Account" << path << "removed while the AM "
                 "was not completely introspected";
         }
     } else if (mPriv->incompleteAccounts.contains(path)) {
         mPriv->incompleteAccounts.remove(path);
-        debug() << "Account" << path << "was removed, but it was "
+        tpDebug() << "Account" << path << "was removed, but it was "
             "not completely introspected, ignoring";
     } else {
-        debug() << "Got AccountRemoved for unknown account" << path << ", ignoring";
+        tpDebug() << "Got AccountRemoved for unknown account" << path << ", ignoring";
+    }
+}
+
+void AccountManager::onAccountPropertyChanged(const QString &propertyName)
+{
+    if (mPriv->changesBatchInterval < 0) {
+        return;
+    }
+
+    Account *account = qobject_cast<Account *>(sender());
+    Q_ASSERT(account != 0);
+
+    QHash<QString, QStringList>::iterator i = mPriv->accountChanges.find(account->objectPath());
+    if (i == mPriv->accountChanges.end()) {
+        mPriv->accountChanges.insert(account->objectPath(), QStringList() << propertyName);
+        mPriv->changedAccounts.append(AccountPtr(account));
+    } else if (!i.value().contains(propertyName)) {
+        i.value().append(propertyName);
+    }
+
+    if (!mPriv->changesBatchScheduled) {
+        mPriv->changesBatchScheduled = true;
+        QTimer::singleShot(mPriv->changesBatchInterval, this, SLOT(doEmitAccountsChanged()));
+    }
+}
+
+void AccountManager::doEmitAccountsChanged()
+{
+    mPriv->changesBatchScheduled = false;
+
+    QList<AccountPtr> accounts = mPriv->changedAccounts;
+    QHash<QString, QStringList> changes = mPriv->accountChanges;
+    mPriv->changedAccounts.clear();
+    mPriv->accountChanges.clear();
+
+    // Emit once for each set of changed properties, keeping the order in which accounts first
+    // changed
+    QList<QStringList> propertyNameSets;
+    QList<QList<AccountPtr> > accountsByPropertyNames;
+    foreach (const AccountPtr &account, accounts) {
+        QStringList propertyNames = changes.value(account->objectPath());
+        propertyNames.sort();
+        int index = propertyNameSets.indexOf(propertyNames);
+        if (index < 0) {
+            propertyNameSets.append(propertyNames);
+            accountsByPropertyNames.append(QList<AccountPtr>() << account);
+        } else {
+            accountsByPropertyNames[index].append(account);
+        }
+    }
+
+    for (int i = 0; i < propertyNameSets.size(); ++i) {
+        emit accountsChanged(accountsByPropertyNames.at(i), propertyNameSets.at(i));
     }
 }
 
@@ -1176,4 +1299,17 @@ void AccountManager::onAccountRemoved(const QDBusObjectPath &objectPath)
  * \param account The newly created account.
  */
 
+/**
+ * \fn void AccountManager::accountsChanged(const QList<Tp::AccountPtr> &accounts,
+ *          const QStringList &propertyNames)
+ *
+ * Emitted when account change notifications are being coalesced, after the coalescing interval
+ * elapsed, with the accounts whose properties changed in the meantime.
+ *
+ * \param accounts The accounts which changed.
+ * \param propertyNames The names of the properties which changed for all of \a accounts, as
+ *                      reported by Account::propertyChanged().
+ * \sa setAccountChangesCoalescingInterval()
+ */
+
 } // Tp
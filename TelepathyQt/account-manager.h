@@ -123,8 +123,13 @@ public:
             const QVariantMap &parameters,
             const QVariantMap &properties = QVariantMap());
 
+    int accountChangesCoalescingInterval() const;
+    void setAccountChangesCoalescingInterval(int msecs);
+
 Q_SIGNALS:
     void newAccount(const Tp::AccountPtr &account);
+    void accountsChanged(const QList<Tp::AccountPtr> &accounts,
+            const QStringList &propertyNames);
 
 protected:
     AccountManager(const QDBusConnection &bus,
@@ -143,8 +148,11 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onAccountValidityChanged(const QDBusObjectPath &objectPath,
             bool valid);
     TP_QT_NO_EXPORT void onAccountRemoved(const QDBusObjectPath &objectPath);
+    TP_QT_NO_EXPORT void onAccountPropertyChanged(const QString &propertyName);
+    TP_QT_NO_EXPORT void doEmitAccountsChanged();
 
 private:
+    friend class AccountSetIndex;
     friend class PendingAccount;
 
     struct Private;
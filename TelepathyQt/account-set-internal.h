@@ -21,10 +21,12 @@
  */
 
 #include <TelepathyQt/AccountPropertyFilter>
+#include <TelepathyQt/AccountSet>
 
 namespace Tp
 {
 
+class AccountSetIndex;
 class ConnectionCapabilities;
 
 struct TP_QT_NO_EXPORT AccountSet::Private
@@ -36,19 +38,19 @@ struct TP_QT_NO_EXPORT AccountSet::Private
     Private(AccountSet *parent, const AccountManagerPtr &accountManager,
             const QVariantMap &filter);
 
+    ~Private();
+
     void init();
-    void connectSignals();
     void insertAccounts();
     void insertAccount(const AccountPtr &account);
     void removeAccount(const AccountPtr &account);
-    void wrapAccount(const AccountPtr &account);
     void filterAccount(const AccountPtr &account);
-    bool accountMatchFilter(AccountWrapper *account);
+    bool accountMatchFilter(const AccountPtr &account);
 
     AccountSet *parent;
     AccountManagerPtr accountManager;
     AccountFilterConstPtr filter;
-    QHash<QString, AccountWrapper *> wrappers;
+    AccountSetIndex *index;
     QHash<QString, AccountPtr> accounts;
     bool ready;
 };
@@ -79,4 +81,39 @@ private:
     AccountPtr mAccount;
 };
 
+// Each AccountManager has a single index shared by all the AccountSets filtering its accounts. The
+// index listens to the accounts once, and only re-evaluates the sets whose filter depends on the
+// property which changed.
+class TP_QT_NO_EXPORT AccountSetIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static AccountSetIndex *forAccountManager(AccountManager *accountManager);
+
+    AccountSetIndex(AccountManager *accountManager);
+    ~AccountSetIndex();
+
+    void addSet(AccountSet::Private *set);
+    void removeSet(AccountSet::Private *set);
+
+private Q_SLOTS:
+    TP_QT_NO_EXPORT void onNewAccount(const Tp::AccountPtr &account);
+    TP_QT_NO_EXPORT void onAccountRemoved(const Tp::AccountPtr &account);
+    TP_QT_NO_EXPORT void onAccountPropertyChanged(const Tp::AccountPtr &account,
+            const QString &propertyName);
+    TP_QT_NO_EXPORT void onAccountCapabilitiesChanged(const Tp::AccountPtr &account);
+
+private:
+    void wrapAccount(const AccountPtr &account);
+    void filterAccount(const AccountPtr &account, const QList<AccountSet::Private *> &sets);
+
+    AccountManager *mAccountManager;
+    QHash<QString, AccountSet::Private::AccountWrapper *> mWrappers;
+    QList<AccountSet::Private *> mSets;
+    QHash<QString, QList<AccountSet::Private *> > mSetsByProperty;
+    // Sets whose filter can't be inspected, which need to be checked on any change
+    QList<AccountSet::Private *> mUnindexedSets;
+};
+
 } // Tp
@@ -29,10 +29,16 @@
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/Account>
+#include <TelepathyQt/AccountCapabilityFilter>
 #include <TelepathyQt/AccountFilter>
 #include <TelepathyQt/AccountManager>
+#include <TelepathyQt/AndFilter>
 #include <TelepathyQt/ConnectionCapabilities>
 #include <TelepathyQt/ConnectionManager>
+#include <TelepathyQt/NotFilter>
+#include <TelepathyQt/OrFilter>
+
+#include <QSet>
 
 namespace Tp
 {
@@ -43,6 +49,7 @@ AccountSet::Private::Private(AccountSet *parent,
     : parent(parent),
       accountManager(accountManager),
       filter(filter),
+      index(0),
       ready(false)
 {
     init();
@@ -53,6 +60,7 @@ AccountSet::Private::Private(AccountSet *parent,
         const QVariantMap &filterMap)
     : parent(parent),
       accountManager(accountManager),
+      index(0),
       ready(false)
 {
     AccountPropertyFilterPtr propertyFilter = AccountPropertyFilter::create();
@@ -64,22 +72,23 @@ AccountSet::Private::Private(AccountSet *parent,
     init();
 }
 
+AccountSet::Private::~Private()
+{
+    if (ready) {
+        index->removeSet(this);
+    }
+}
+
 void AccountSet::Private::init()
 {
     if (filter->isValid()) {
-        connectSignals();
+        index = AccountSetIndex::forAccountManager(accountManager.data());
+        index->addSet(this);
         insertAccounts();
         ready = true;
     }
 }
 
-void AccountSet::Private::connectSignals()
-{
-    parent->connect(accountManager.data(),
-            SIGNAL(newAccount(Tp::AccountPtr)),
-            SLOT(onNewAccount(Tp::AccountPtr)));
-}
-
 void AccountSet::Private::insertAccounts()
 {
     foreach (const Tp::AccountPtr &account, accountManager->allAccounts()) {
@@ -89,48 +98,21 @@ void AccountSet::Private::insertAccounts()
 
 void AccountSet::Private::insertAccount(const Tp::AccountPtr &account)
 {
-    QString accountPath = account->objectPath();
-    Q_ASSERT(!wrappers.contains(accountPath));
-    wrapAccount(account);
     filterAccount(account);
 }
 
 void AccountSet::Private::removeAccount(const Tp::AccountPtr &account)
 {
     QString accountPath = account->objectPath();
-    Q_ASSERT(wrappers.contains(accountPath));
     accounts.remove(accountPath);
 
-    AccountWrapper *wrapper = wrappers.take(accountPath);
-    Q_ASSERT(wrapper->disconnect(parent));
-    wrapper->deleteLater();
-
     emit parent->accountRemoved(account);
 }
 
-void AccountSet::Private::wrapAccount(const AccountPtr &account)
-{
-    AccountWrapper *wrapper = new AccountWrapper(account, parent);
-    parent->connect(wrapper,
-            SIGNAL(accountRemoved(Tp::AccountPtr)),
-            SLOT(onAccountRemoved(Tp::AccountPtr)));
-    parent->connect(wrapper,
-            SIGNAL(accountPropertyChanged(Tp::AccountPtr,QString)),
-            SLOT(onAccountChanged(Tp::AccountPtr)));
-    parent->connect(wrapper,
-            SIGNAL(accountCapabilitiesChanged(Tp::AccountPtr,Tp::ConnectionCapabilities)),
-            SLOT(onAccountChanged(Tp::AccountPtr)));
-    wrappers.insert(account->objectPath(), wrapper);
-}
-
 void AccountSet::Private::filterAccount(const AccountPtr &account)
 {
-    QString accountPath = account->objectPath();
-    Q_ASSERT(wrappers.contains(accountPath));
-    AccountWrapper *wrapper = wrappers[accountPath];
-
     /* account changed, let's check if it matches filter */
-    if (accountMatchFilter(wrapper)) {
+    if (accountMatchFilter(account)) {
         if (!accounts.contains(account->objectPath())) {
             accounts.insert(account->objectPath(), account);
             if (ready) {
@@ -147,13 +129,13 @@ void AccountSet::Private::filterAccount(const AccountPtr &account)
     }
 }
 
-bool AccountSet::Private::accountMatchFilter(AccountWrapper *wrapper)
+bool AccountSet::Private::accountMatchFilter(const AccountPtr &account)
 {
     if (!filter) {
         return true;
     }
 
-    return filter->matches(wrapper->account());
+    return filter->matches(account);
 }
 
 AccountSet::Private::AccountWrapper::AccountWrapper(
@@ -193,6 +175,168 @@ void AccountSet::Private::AccountWrapper::onAccountCapalitiesChanged(
     emit accountCapabilitiesChanged(mAccount, caps);
 }
 
+// Collect the names of the account properties a filter looks at, returning false if the filter
+// is not one of the filters provided by the library, which may look at anything
+static bool collectDependencies(const AccountFilterConstPtr &filter,
+        QSet<QString> *propertyNames)
+{
+    if (!filter) {
+        return true;
+    }
+
+    const AccountFilter *f = filter.data();
+    if (const AccountPropertyFilter *propertyFilter =
+            dynamic_cast<const AccountPropertyFilter *>(f)) {
+        foreach (const QString &propertyName, propertyFilter->filter().keys()) {
+            propertyNames->insert(propertyName);
+        }
+        return true;
+    } else if (dynamic_cast<const AccountCapabilityFilter *>(f)) {
+        propertyNames->insert(QLatin1String("capabilities"));
+        return true;
+    } else if (const AndFilter<Account> *andFilter = dynamic_cast<const AndFilter<Account> *>(f)) {
+        foreach (const AccountFilterConstPtr &subFilter, andFilter->filters()) {
+            if (!collectDependencies(subFilter, propertyNames)) {
+                return false;
+            }
+        }
+        return true;
+    } else if (const OrFilter<Account> *orFilter = dynamic_cast<const OrFilter<Account> *>(f)) {
+        foreach (const AccountFilterConstPtr &subFilter, orFilter->filters()) {
+            if (!collectDependencies(subFilter, propertyNames)) {
+                return false;
+            }
+        }
+        return true;
+    } else if (const NotFilter<Account> *notFilter = dynamic_cast<const NotFilter<Account> *>(f)) {
+        return collectDependencies(notFilter->filter(), propertyNames);
+    }
+
+    return false;
+}
+
+AccountSetIndex::AccountSetIndex(AccountManager *accountManager)
+    : QObject(),
+      mAccountManager(accountManager)
+{
+    connect(accountManager,
+            SIGNAL(newAccount(Tp::AccountPtr)),
+            SLOT(onNewAccount(Tp::AccountPtr)));
+
+    foreach (const AccountPtr &account, accountManager->allAccounts()) {
+        wrapAccount(account);
+    }
+}
+
+AccountSetIndex::~AccountSetIndex()
+{
+    Q_ASSERT(mSets.isEmpty());
+    qDeleteAll(mWrappers);
+}
+
+void AccountSetIndex::addSet(AccountSet::Private *set)
+{
+    mSets.append(set);
+
+    QSet<QString> propertyNames;
+    if (!collectDependencies(set->filter, &propertyNames)) {
+        mUnindexedSets.append(set);
+        return;
+    }
+
+    // Note that the dependencies are only looked at when the set is created, in the same way a
+    // set's filter is not supposed to be changed after that
+    foreach (const QString &propertyName, propertyNames) {
+        mSetsByProperty[propertyName].append(set);
+    }
+}
+
+void AccountSetIndex::removeSet(AccountSet::Private *set)
+{
+    mSets.removeOne(set);
+    mUnindexedSets.removeOne(set);
+
+    QHash<QString, QList<AccountSet::Private *> >::iterator i = mSetsByProperty.begin();
+    while (i != mSetsByProperty.end()) {
+        i.value().removeOne(set);
+        if (i.value().isEmpty()) {
+            i = mSetsByProperty.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void AccountSetIndex::wrapAccount(const AccountPtr &account)
+{
+    AccountSet::Private::AccountWrapper *wrapper =
+        new AccountSet::Private::AccountWrapper(account, this);
+    connect(wrapper,
+            SIGNAL(accountRemoved(Tp::AccountPtr)),
+            SLOT(onAccountRemoved(Tp::AccountPtr)));
+    connect(wrapper,
+            SIGNAL(accountPropertyChanged(Tp::AccountPtr,QString)),
+            SLOT(onAccountPropertyChanged(Tp::AccountPtr,QString)));
+    connect(wrapper,
+            SIGNAL(accountCapabilitiesChanged(Tp::AccountPtr,Tp::ConnectionCapabilities)),
+            SLOT(onAccountCapabilitiesChanged(Tp::AccountPtr)));
+    mWrappers.insert(account->objectPath(), wrapper);
+}
+
+void AccountSetIndex::filterAccount(const AccountPtr &account,
+        const QList<AccountSet::Private *> &sets)
+{
+    foreach (AccountSet::Private *set, sets) {
+        // a handler may have dropped the last reference to one of the sets
+        if (mSets.contains(set)) {
+            set->filterAccount(account);
+        }
+    }
+}
+
+void AccountSetIndex::onNewAccount(const AccountPtr &account)
+{
+    if (mWrappers.contains(account->objectPath())) {
+        return;
+    }
+
+    wrapAccount(account);
+
+    QList<AccountSet::Private *> sets = mSets;
+    foreach (AccountSet::Private *set, sets) {
+        if (mSets.contains(set)) {
+            set->insertAccount(account);
+        }
+    }
+}
+
+void AccountSetIndex::onAccountRemoved(const AccountPtr &account)
+{
+    AccountSet::Private::AccountWrapper *wrapper = mWrappers.take(account->objectPath());
+    Q_ASSERT(wrapper);
+    wrapper->deleteLater();
+
+    QList<AccountSet::Private *> sets = mSets;
+    foreach (AccountSet::Private *set, sets) {
+        if (mSets.contains(set)) {
+            set->removeAccount(account);
+        }
+    }
+}
+
+void AccountSetIndex::onAccountPropertyChanged(const AccountPtr &account,
+        const QString &propertyName)
+{
+    filterAccount(account, mSetsByProperty.value(propertyName));
+    filterAccount(account, mUnindexedSets);
+}
+
+void AccountSetIndex::onAccountCapabilitiesChanged(const AccountPtr &account)
+{
+    filterAccount(account, mSetsByProperty.value(QLatin1String("capabilities")));
+    filterAccount(account, mUnindexedSets);
+}
+
 /**
  * \class AccountSet
  * \ingroup clientaccount
@@ -69,6 +69,8 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onAccountChanged(const Tp::AccountPtr &account);
 
 private:
+    friend class AccountSetIndex;
+
     struct Private;
     friend struct Private;
     Private *mPriv;
@@ -21,8 +21,10 @@
  */
 
 #include <TelepathyQt/Account>
+#include "TelepathyQt/account-internal.h"
 
 #include "TelepathyQt/_gen/account.moc.hpp"
+#include "TelepathyQt/_gen/account-internal.moc.hpp"
 #include "TelepathyQt/_gen/cli-account.moc.hpp"
 #include "TelepathyQt/_gen/cli-account-body.hpp"
 
@@ -48,6 +50,8 @@
 #include <TelepathyQt/Constants>
 #include <TelepathyQt/Debug>
 
+#include <QDBusArgument>
+#include <QDBusMessage>
 #include <QQueue>
 #include <QRegExp>
 #include <QSharedPointer>
@@ -572,6 +576,7 @@ struct TP_QT_NO_EXPORT Account::Private
     static void introspectProtocolInfo(Private *self);
     static void introspectCapabilities(Private *self);
 
+    void finishMainIntrospection();
     void updateProperties(const QVariantMap &props);
     void retrieveAvatar();
     bool processConnQueue();
@@ -612,6 +617,9 @@ struct TP_QT_NO_EXPORT Account::Private
     QString iconName;
     QQueue<QString> connObjPathQueue;
     ConnectionPtr connection;
+    bool dispatcherIntrospected, mainPropertiesRetrieved;
+    QVariantMap mainProperties;
+    QString mainPropertiesErrorName, mainPropertiesErrorMessage;
     bool mayFinishCore, coreFinished;
     QString normalizedName;
     Avatar avatar;
@@ -669,6 +677,8 @@ Account::Private::Private(Account *parent, const ConnectionFactoryConstPtr &conn
       connectsAutomatically(false),
       hasBeenOnline(false),
       changingPresence(false),
+      dispatcherIntrospected(false),
+      mainPropertiesRetrieved(false),
       mayFinishCore(false),
       coreFinished(false),
       connectionStatus(ConnectionStatusDisconnected),
@@ -803,6 +813,130 @@ QString Account::Private::connectionObjectPath() const
 
 QHash<QString, QSharedPointer<Account::Private::DispatcherContext> > Account::Private::dispatcherContexts;
 
+// Maximum number of Properties.GetAll calls in flight at once when introspecting accounts, so
+// starting up with hundreds of accounts doesn't flood the bus and the account manager
+static const int maxAccountPropertiesCallsInFlight = 16;
+
+PendingAccountProperties::PendingAccountProperties(const AccountPtr &account)
+    : PendingOperation(account),
+      mBusName(account->busName())
+{
+}
+
+PendingAccountProperties::~PendingAccountProperties()
+{
+}
+
+void PendingAccountProperties::setResult(const QVariantMap &result)
+{
+    mResult = result;
+    setFinished();
+}
+
+void PendingAccountProperties::setError(const QDBusError &error)
+{
+    setFinishedWithError(error);
+}
+
+QHash<QString, AccountPropertiesBatch *> AccountPropertiesBatch::batches;
+
+AccountPropertiesBatch *AccountPropertiesBatch::forBus(const QDBusConnection &bus)
+{
+    AccountPropertiesBatch *batch = batches.value(bus.name());
+    if (!batch) {
+        batch = new AccountPropertiesBatch(bus);
+        batches.insert(bus.name(), batch);
+    }
+    return batch;
+}
+
+AccountPropertiesBatch::AccountPropertiesBatch(const QDBusConnection &bus)
+    : mBus(bus)
+{
+}
+
+AccountPropertiesBatch::~AccountPropertiesBatch()
+{
+}
+
+PendingAccountProperties *AccountPropertiesBatch::requestProperties(const AccountPtr &account)
+{
+    PendingAccountProperties *op = new PendingAccountProperties(account);
+    QString objectPath = account->objectPath();
+
+    // if a call is already queued or in flight for this account, its reply will do
+    bool pending = mRequests.contains(objectPath);
+    mRequests[objectPath].append(op);
+    if (!pending) {
+        mQueue.enqueue(objectPath);
+        sendRequests();
+    }
+
+    return op;
+}
+
+void AccountPropertiesBatch::sendRequests()
+{
+    while (mCalls.size() < maxAccountPropertiesCallsInFlight && !mQueue.isEmpty()) {
+        QString objectPath = mQueue.dequeue();
+        if (!mRequests.contains(objectPath)) {
+            continue;
+        }
+
+        tpDebug() << "Calling Properties::GetAll(Account) on" << objectPath;
+        QDBusMessage msg = QDBusMessage::createMethodCall(
+                mRequests[objectPath].first()->busName(), objectPath,
+                QLatin1String("org.freedesktop.DBus.Properties"),
+                QLatin1String("GetAll"));
+        msg << TP_QT_IFACE_ACCOUNT;
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(mBus.asyncCall(msg), this);
+        connect(watcher,
+                SIGNAL(finished(QDBusPendingCallWatcher*)),
+                SLOT(gotProperties(QDBusPendingCallWatcher*)));
+        mCalls.insert(watcher, objectPath);
+    }
+}
+
+void AccountPropertiesBatch::finishRequests(const QString &objectPath, const QVariantMap &props)
+{
+    foreach (PendingAccountProperties *op, mRequests.take(objectPath)) {
+        op->setResult(props);
+    }
+}
+
+void AccountPropertiesBatch::releaseIfIdle()
+{
+    if (!mRequests.isEmpty() || !mCalls.isEmpty()) {
+        return;
+    }
+
+    // Nothing left to do, the next request will create a new batch
+    if (batches.value(mBus.name()) == this) {
+        batches.remove(mBus.name());
+    }
+    deleteLater();
+}
+
+void AccountPropertiesBatch::gotProperties(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<QVariantMap> reply = *watcher;
+    QString objectPath = mCalls.take(watcher);
+
+    if (!reply.isError()) {
+        tpDebug() << "Got reply to Properties.GetAll(Account) for" << objectPath;
+        finishRequests(objectPath, reply.value());
+    } else {
+        foreach (PendingAccountProperties *op, mRequests.take(objectPath)) {
+            op->setError(reply.error());
+        }
+    }
+
+    sendRequests();
+    releaseIfIdle();
+
+    watcher->deleteLater();
+}
+
 /**
  * \class Account
  * \ingroup clientaccount
@@ -4115,13 +4249,21 @@ void Account::Private::init()
 
 void Account::Private::introspectMain(Account::Private *self)
 {
+    // The properties are retrieved while the channel dispatcher is being introspected, along with
+    // the ones of the other accounts on the bus
+    self->parent->connect(
+            AccountPropertiesBatch::forBus(self->parent->dbusConnection())->requestProperties(
+                AccountPtr(self->parent)),
+            SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(gotMainProperties(Tp::PendingOperation*)));
+
     if (self->dispatcherContext->introspected) {
         self->parent->onDispatcherIntrospected(0);
         return;
     }
 
     if (!self->dispatcherContext->introspectOp) {
-        debug() << "Discovering if the Channel Dispatcher supports request hints";
+        tpDebug() << "Discovering if the Channel Dispatcher supports request hints";
         self->dispatcherContext->introspectOp =
             self->dispatcherContext->iface->requestPropertySupportsRequestHints();
     }
@@ -4134,7 +4276,7 @@ void Account::Private::introspectMain(Account::Private *self)
 
 void Account::Private::introspectAvatar(Account::Private *self)
 {
-    debug() << "Calling GetAvatar(Account)";
+    tpDebug() << "Calling GetAvatar(Account)";
     // we already checked if avatar interface exists, so bypass avatar interface
     // checking
     Client::AccountInterfaceAvatarInterface *iface =
@@ -4175,13 +4317,43 @@ void Account::Private::introspectCapabilities(Account::Private *self)
             SLOT(onConnectionReady(Tp::PendingOperation*)));
 }
 
+void Account::Private::finishMainIntrospection()
+{
+    if (!dispatcherIntrospected || !mainPropertiesRetrieved) {
+        return;
+    }
+
+    if (!mainPropertiesErrorName.isEmpty()) {
+        warning().nospace() <<
+            "GetAll(Account) failed: " <<
+            mainPropertiesErrorName << ": " << mainPropertiesErrorMessage;
+        readinessHelper->setIntrospectCompleted(FeatureCore, false,
+                mainPropertiesErrorName, mainPropertiesErrorMessage);
+        return;
+    }
+
+    updateProperties(mainProperties);
+    mainProperties.clear();
+
+    readinessHelper->setInterfaces(parent->interfaces());
+    mayFinishCore = true;
+
+    if (connObjPathQueue.isEmpty()) {
+        tpDebug() << "Account basic functionality is ready";
+        coreFinished = true;
+        readinessHelper->setIntrospectCompleted(FeatureCore, true);
+    } else {
+        tpDebug() << "Deferring finishing Account::FeatureCore until the connection is built";
+    }
+}
+
 void Account::Private::updateProperties(const QVariantMap &props)
 {
-    debug() << "Account::updateProperties: changed:";
+    tpDebug() << "Account::updateProperties: changed:";
 
     if (props.contains(QLatin1String("Interfaces"))) {
         parent->setInterfaces(qdbus_cast<QStringList>(props[QLatin1String("Interfaces")]));
-        debug() << " Interfaces:" << parent->interfaces();
+        tpDebug() << " Interfaces:" << parent->interfaces();
     }
 
     QString oldIconName = parent->iconName();
@@ -4191,7 +4363,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
         serviceName != qdbus_cast<QString>(props[QLatin1String("Service")])) {
         serviceNameChanged = true;
         serviceName = qdbus_cast<QString>(props[QLatin1String("Service")]);
-        debug() << " Service Name:" << parent->serviceName();
+        tpDebug() << " Service Name:" << parent->serviceName();
         /* use parent->serviceName() here as if the service name is empty we are going to use the
          * protocol name */
         emit parent->serviceNameChanged(parent->serviceName());
@@ -4210,7 +4382,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
     if (props.contains(QLatin1String("DisplayName")) &&
         displayName != qdbus_cast<QString>(props[QLatin1String("DisplayName")])) {
         displayName = qdbus_cast<QString>(props[QLatin1String("DisplayName")]);
-        debug() << " Display Name:" << displayName;
+        tpDebug() << " Display Name:" << displayName;
         emit parent->displayNameChanged(displayName);
         parent->notify("displayName");
     }
@@ -4225,7 +4397,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
 
         QString newIconName = parent->iconName();
         if (oldIconName != newIconName) {
-            debug() << " Icon:" << newIconName;
+            tpDebug() << " Icon:" << newIconName;
             emit parent->iconNameChanged(newIconName);
             parent->notify("iconName");
         }
@@ -4234,7 +4406,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
     if (props.contains(QLatin1String("Nickname")) &&
         nickname != qdbus_cast<QString>(props[QLatin1String("Nickname")])) {
         nickname = qdbus_cast<QString>(props[QLatin1String("Nickname")]);
-        debug() << " Nickname:" << nickname;
+        tpDebug() << " Nickname:" << nickname;
         emit parent->nicknameChanged(nickname);
         parent->notify("nickname");
     }
@@ -4242,7 +4414,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
     if (props.contains(QLatin1String("NormalizedName")) &&
         normalizedName != qdbus_cast<QString>(props[QLatin1String("NormalizedName")])) {
         normalizedName = qdbus_cast<QString>(props[QLatin1String("NormalizedName")]);
-        debug() << " Normalized Name:" << normalizedName;
+        tpDebug() << " Normalized Name:" << normalizedName;
         emit parent->normalizedNameChanged(normalizedName);
         parent->notify("normalizedName");
     }
@@ -4250,7 +4422,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
     if (props.contains(QLatin1String("Valid")) &&
         valid != qdbus_cast<bool>(props[QLatin1String("Valid")])) {
         valid = qdbus_cast<bool>(props[QLatin1String("Valid")]);
-        debug() << " Valid:" << (valid ? "true" : "false");
+        tpDebug() << " Valid:" << (valid ? "true" : "false");
         emit parent->validityChanged(valid);
         parent->notify("valid");
     }
@@ -4258,7 +4430,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
     if (props.contains(QLatin1String("Enabled")) &&
         enabled != qdbus_cast<bool>(props[QLatin1String("Enabled")])) {
         enabled = qdbus_cast<bool>(props[QLatin1String("Enabled")]);
-        debug() << " Enabled:" << (enabled ? "true" : "false");
+        tpDebug() << " Enabled:" << (enabled ? "true" : "false");
         emit parent->stateChanged(enabled);
         parent->notify("enabled");
     }
@@ -4268,7 +4440,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                 qdbus_cast<bool>(props[QLatin1String("ConnectAutomatically")])) {
         connectsAutomatically =
                 qdbus_cast<bool>(props[QLatin1String("ConnectAutomatically")]);
-        debug() << " Connects Automatically:" << (connectsAutomatically ? "true" : "false");
+        tpDebug() << " Connects Automatically:" << (connectsAutomatically ? "true" : "false");
         emit parent->connectsAutomaticallyPropertyChanged(connectsAutomatically);
         parent->notify("connectsAutomatically");
     }
@@ -4277,7 +4449,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
         !hasBeenOnline &&
         qdbus_cast<bool>(props[QLatin1String("HasBeenOnline")])) {
         hasBeenOnline = true;
-        debug() << " HasBeenOnline changed to true";
+        tpDebug() << " HasBeenOnline changed to true";
         // don't emit firstOnline unless we're already ready, that would be
         // misleading - we'd emit it just before any already-used account
         // became ready
@@ -4299,7 +4471,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                 props[QLatin1String("AutomaticPresence")])) {
         automaticPresence = Presence(qdbus_cast<SimplePresence>(
                 props[QLatin1String("AutomaticPresence")]));
-        debug() << " Automatic Presence:" << automaticPresence.type() <<
+        tpDebug() << " Automatic Presence:" << automaticPresence.type() <<
             "-" << automaticPresence.status();
         emit parent->automaticPresenceChanged(automaticPresence);
         parent->notify("automaticPresence");
@@ -4310,7 +4482,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                 props[QLatin1String("CurrentPresence")])) {
         currentPresence = Presence(qdbus_cast<SimplePresence>(
                 props[QLatin1String("CurrentPresence")]));
-        debug() << " Current Presence:" << currentPresence.type() <<
+        tpDebug() << " Current Presence:" << currentPresence.type() <<
             "-" << currentPresence.status();
         emit parent->currentPresenceChanged(currentPresence);
         parent->notify("currentPresence");
@@ -4323,7 +4495,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                 props[QLatin1String("RequestedPresence")])) {
         requestedPresence = Presence(qdbus_cast<SimplePresence>(
                 props[QLatin1String("RequestedPresence")]));
-        debug() << " Requested Presence:" << requestedPresence.type() <<
+        tpDebug() << " Requested Presence:" << requestedPresence.type() <<
             "-" << requestedPresence.status();
         emit parent->requestedPresenceChanged(requestedPresence);
         parent->notify("requestedPresence");
@@ -4334,7 +4506,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                 props[QLatin1String("ChangingPresence")])) {
         changingPresence = qdbus_cast<bool>(
                 props[QLatin1String("ChangingPresence")]);
-        debug() << " Changing Presence:" << changingPresence;
+        tpDebug() << " Changing Presence:" << changingPresence;
         emit parent->changingPresence(changingPresence);
         parent->notify("changingPresence");
     }
@@ -4342,12 +4514,12 @@ void Account::Private::updateProperties(const QVariantMap &props)
     if (props.contains(QLatin1String("Connection"))) {
         QString path = qdbus_cast<QDBusObjectPath>(props[QLatin1String("Connection")]).path();
         if (path.isEmpty()) {
-            debug() << " The map contains \"Connection\" but it's empty as a QDBusObjectPath!";
-            debug() << " Trying QString (known bug in some MC/dbus-glib versions)";
+            tpDebug() << " The map contains \"Connection\" but it's empty as a QDBusObjectPath!";
+            tpDebug() << " Trying QString (known bug in some MC/dbus-glib versions)";
             path = qdbus_cast<QString>(props[QLatin1String("Connection")]);
         }
 
-        debug() << " Connection Object Path:" << path;
+        tpDebug() << " Connection Object Path:" << path;
         if (path == QLatin1String("/")) {
             path = QString();
         }
@@ -4374,7 +4546,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                     qdbus_cast<uint>(props[QLatin1String("ConnectionStatus")]))) {
             connectionStatus = ConnectionStatus(
                     qdbus_cast<uint>(props[QLatin1String("ConnectionStatus")]));
-            debug() << " Connection Status:" << connectionStatus;
+            tpDebug() << " Connection Status:" << connectionStatus;
             connectionStatusChanged = true;
         }
 
@@ -4383,7 +4555,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                     qdbus_cast<uint>(props[QLatin1String("ConnectionStatusReason")]))) {
             connectionStatusReason = ConnectionStatusReason(
                     qdbus_cast<uint>(props[QLatin1String("ConnectionStatusReason")]));
-            debug() << " Connection StatusReason:" << connectionStatusReason;
+            tpDebug() << " Connection StatusReason:" << connectionStatusReason;
             connectionStatusChanged = true;
         }
 
@@ -4397,7 +4569,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                 props[QLatin1String("ConnectionError")])) {
             connectionError = qdbus_cast<QString>(
                     props[QLatin1String("ConnectionError")]);
-            debug() << " Connection Error:" << connectionError;
+            tpDebug() << " Connection Error:" << connectionError;
             connectionStatusChanged = true;
         }
 
@@ -4406,7 +4578,7 @@ void Account::Private::updateProperties(const QVariantMap &props)
                 props[QLatin1String("ConnectionErrorDetails")])) {
             connectionErrorDetails = Connection::ErrorDetails(qdbus_cast<QVariantMap>(
                     props[QLatin1String("ConnectionErrorDetails")]));
-            debug() << " Connection Error Details:" << connectionErrorDetails.allDetails();
+            tpDebug() << " Connection Error Details:" << connectionErrorDetails.allDetails();
             connectionStatusChanged = true;
         }
 
@@ -4460,7 +4632,7 @@ bool Account::Private::processConnQueue()
         QString path = connObjPathQueue.head();
         if (path.isEmpty()) {
             if (!connection.isNull()) {
-                debug() << "Dropping connection for account" << parent->objectPath();
+                tpDebug() << "Dropping connection for account" << parent->objectPath();
 
                 connection.reset();
                 emit parent->connectionChanged(connection);
@@ -4470,10 +4642,10 @@ bool Account::Private::processConnQueue()
 
             connObjPathQueue.dequeue();
         } else {
-            debug() << "Building connection" << path << "for account" << parent->objectPath();
+            tpDebug() << "Building connection" << path << "for account" << parent->objectPath();
 
             if (connection && connection->objectPath() == path) {
-                debug() << "  Connection already built";
+                tpDebug() << "  Connection already built";
                 connObjPathQueue.dequeue();
                 continue;
             }
@@ -4504,11 +4676,11 @@ void Account::onDispatcherIntrospected(Tp::PendingOperation *op)
 
         if (pv->isValid()) {
             mPriv->dispatcherContext->supportsHints = qdbus_cast<bool>(pv->result());
-            debug() << "Discovered channel dispatcher support for request hints: "
+            tpDebug() << "Discovered channel dispatcher support for request hints: "
                 << mPriv->dispatcherContext->supportsHints;
         } else {
             if (pv->errorName() == TP_QT_ERROR_NOT_IMPLEMENTED) {
-                debug() << "Channel Dispatcher does not implement support for request hints";
+                tpDebug() << "Channel Dispatcher does not implement support for request hints";
             } else {
                 warning() << "(Too old?) Channel Dispatcher failed to tell us whether"
                     << "it supports request hints, assuming it doesn't:"
@@ -4518,42 +4690,25 @@ void Account::onDispatcherIntrospected(Tp::PendingOperation *op)
         }
     }
 
-    debug() << "Calling Properties::GetAll(Account) on " << objectPath();
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
-            mPriv->properties->GetAll(
-                TP_QT_IFACE_ACCOUNT), this);
-    connect(watcher,
-            SIGNAL(finished(QDBusPendingCallWatcher*)),
-            SLOT(gotMainProperties(QDBusPendingCallWatcher*)));
+    mPriv->dispatcherIntrospected = true;
+    mPriv->finishMainIntrospection();
 }
 
-void Account::gotMainProperties(QDBusPendingCallWatcher *watcher)
+void Account::gotMainProperties(Tp::PendingOperation *op)
 {
-    QDBusPendingReply<QVariantMap> reply = *watcher;
-
-    if (!reply.isError()) {
-        debug() << "Got reply to Properties.GetAll(Account) for" << objectPath();
-        mPriv->updateProperties(reply.value());
+    PendingAccountProperties *pp = qobject_cast<PendingAccountProperties *>(op);
+    Q_ASSERT(pp != NULL);
 
-        mPriv->readinessHelper->setInterfaces(interfaces());
-        mPriv->mayFinishCore = true;
-
-        if (mPriv->connObjPathQueue.isEmpty()) {
-            debug() << "Account basic functionality is ready";
-            mPriv->coreFinished = true;
-            mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
-        } else {
-            debug() << "Deferring finishing Account::FeatureCore until the connection is built";
-        }
+    mPriv->mainPropertiesRetrieved = true;
+    if (!op->isError()) {
+        tpDebug() << "Got the main properties of" << objectPath();
+        mPriv->mainProperties = pp->result();
     } else {
-        mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, false, reply.error());
-
-        warning().nospace() <<
-            "GetAll(Account) failed: " <<
-            reply.error().name() << ": " << reply.error().message();
+        mPriv->mainPropertiesErrorName = op->errorName();
+        mPriv->mainPropertiesErrorMessage = op->errorMessage();
     }
 
-    watcher->deleteLater();
+    mPriv->finishMainIntrospection();
 }
 
 void Account::gotAvatar(QDBusPendingCallWatcher *watcher)
@@ -4561,7 +4716,7 @@ void Account::gotAvatar(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QVariant> reply = *watcher;
 
     if (!reply.isError()) {
-        debug() << "Got reply to GetAvatar(Account)";
+        tpDebug() << "Got reply to GetAvatar(Account)";
         mPriv->avatar = qdbus_cast<Avatar>(reply);
 
         // It could be in either of actual or missing from the first time in corner cases like the
@@ -4594,7 +4749,7 @@ void Account::gotAvatar(QDBusPendingCallWatcher *watcher)
 
 void Account::onAvatarChanged()
 {
-    debug() << "Avatar changed, retrieving it";
+    tpDebug() << "Avatar changed, retrieving it";
     mPriv->retrieveAvatar();
 }
 
@@ -4665,7 +4820,7 @@ void Account::onConnectionBuilt(PendingOperation *op)
         mPriv->connection = ConnectionPtr::qObjectCast(readyOp->proxy());
         Q_ASSERT(mPriv->connection);
 
-        debug() << "Connection" << mPriv->connectionObjectPath() << "built for" << objectPath();
+        tpDebug() << "Connection" << mPriv->connectionObjectPath() << "built for" << objectPath();
 
         if (prevConn != mPriv->connection) {
             notify("connection");
@@ -4680,7 +4835,8 @@ void Account::onConnectionBuilt(PendingOperation *op)
     mPriv->connObjPathQueue.dequeue();
 
     if (mPriv->processConnQueue() && !mPriv->coreFinished && mPriv->mayFinishCore) {
-        debug() << "Account" << objectPath() << "basic functionality is ready (connections built)";
+        tpDebug() << "Account" << objectPath() <<
+            "basic functionality is ready (connections built)";
         mPriv->coreFinished = true;
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
     }
@@ -565,7 +565,7 @@ protected:
 
 private Q_SLOTS:
     TP_QT_NO_EXPORT void onDispatcherIntrospected(Tp::PendingOperation *op);
-    TP_QT_NO_EXPORT void gotMainProperties(QDBusPendingCallWatcher *);
+    TP_QT_NO_EXPORT void gotMainProperties(Tp::PendingOperation *);
     TP_QT_NO_EXPORT void gotAvatar(QDBusPendingCallWatcher *);
     TP_QT_NO_EXPORT void onAvatarChanged();
     TP_QT_NO_EXPORT void onConnectionManagerReady(Tp::PendingOperation *);
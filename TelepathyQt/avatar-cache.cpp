@@ -0,0 +1,384 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/avatar-cache.h"
+
+#include "TelepathyQt/cache-file.h"
+#include "TelepathyQt/debug-internal.h"
+
+#include <TelepathyQt/Utils>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+
+namespace Tp
+{
+
+// The avatars themselves are still stored as one file per token, plus a separate file holding
+// the MIME type, as other Telepathy clients share the same directory and AvatarData hands out
+// file names. The index keeps the MIME type, size and last use of every avatar, so a lookup only
+// needs to check that the avatar file is still there the first time it finds it.
+static const char indexFileName[] = ".tpqt-avatar-index";
+static const quint32 indexMagic = 0x54504149; // "TPAI"
+static const quint32 indexVersion = 1;
+
+// The last use of an avatar is only used to order evictions, so it's only refreshed once it's
+// this old, rather than making every lookup rewrite the index
+static const uint lastUsedGranularity = 60 * 60;
+
+struct TP_QT_NO_EXPORT AvatarCache::Private
+{
+    struct Entry
+    {
+        Entry() : size(0), lastUsed(0), written(false), verified(false) {}
+        Entry(const QString &mimeType, qint64 size, uint lastUsed)
+            : mimeType(mimeType), size(size), lastUsed(lastUsed), written(false),
+              verified(false) {}
+
+        QString mimeType;
+        qint64 size;
+        uint lastUsed;
+        // Not saved in the index: whether the avatar was written by this cache, and whether its
+        // file was found to be there since the cache was loaded
+        bool written;
+        bool verified;
+    };
+
+    Private(const QString &path);
+
+    void ensureLoaded();
+    bool readIndex();
+    void migrate();
+    void removeEntry(const QString &name);
+
+    QString filePath(const QString &name) const
+    {
+        return path + QLatin1Char('/') + name;
+    }
+
+    QString path;
+    bool loaded;
+    bool modified;
+    qint64 totalSize;
+    qint64 sizeLimit;
+    QHash<QString, Entry> entries;
+};
+
+AvatarCache::Private::Private(const QString &path)
+    : path(path),
+      loaded(false),
+      modified(false),
+      totalSize(0),
+      sizeLimit(0)
+{
+}
+
+void AvatarCache::Private::ensureLoaded()
+{
+    if (loaded) {
+        return;
+    }
+
+    loaded = true;
+    if (!readIndex()) {
+        migrate();
+    }
+}
+
+bool AvatarCache::Private::readIndex()
+{
+    QFile file(filePath(QLatin1String(indexFileName)));
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    qint64 fileSize = file.size();
+    uchar *mapped = fileSize > 0 ? file.map(0, fileSize) : 0;
+    QByteArray data;
+    if (mapped) {
+        data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), fileSize);
+    } else {
+        data = file.readAll();
+    }
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    bool ret = (in.status() == QDataStream::Ok && magic == indexMagic &&
+            version == indexVersion);
+    if (ret) {
+        entries.reserve(count);
+        QString name;
+        Entry entry;
+        for (quint32 i = 0; i < count; ++i) {
+            in >> name >> entry.mimeType >> entry.size >> entry.lastUsed;
+            if (in.status() != QDataStream::Ok) {
+                ret = false;
+                break;
+            }
+            entries.insert(name, entry);
+            totalSize += entry.size;
+        }
+    }
+
+    if (mapped) {
+        file.unmap(mapped);
+    }
+
+    if (!ret) {
+        warning() << "Ignoring invalid avatar cache index in" << path;
+        entries.clear();
+        totalSize = 0;
+    }
+
+    return ret;
+}
+
+void AvatarCache::Private::migrate()
+{
+    // Build the index from the avatars stored by older versions or by other clients, using
+    // the modification time as an approximation of the last use
+    QDir dir(path);
+    if (!dir.exists()) {
+        return;
+    }
+
+    QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    foreach (const QFileInfo &info, files) {
+        QString name = info.fileName();
+        if (name.endsWith(QLatin1String(".mime"))) {
+            continue;
+        }
+
+        QFile mimeTypeFile(filePath(name) + QLatin1String(".mime"));
+        if (!mimeTypeFile.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QString mimeType = QString(QLatin1String(mimeTypeFile.readAll()));
+        mimeTypeFile.close();
+
+        entries.insert(name, Entry(mimeType, info.size(), info.lastModified().toTime_t()));
+        totalSize += info.size();
+    }
+
+    tpDebug() << "Indexed" << entries.size() << "avatars found in" << path;
+    modified = true;
+}
+
+void AvatarCache::Private::removeEntry(const QString &name)
+{
+    QHash<QString, Entry>::iterator i = entries.find(name);
+    if (i == entries.end()) {
+        return;
+    }
+
+    totalSize -= i.value().size;
+    entries.erase(i);
+    modified = true;
+}
+
+AvatarCache::AvatarCache(const QString &path)
+    : mPriv(new Private(path))
+{
+}
+
+AvatarCache::~AvatarCache()
+{
+    sync();
+    delete mPriv;
+}
+
+QString AvatarCache::path() const
+{
+    return mPriv->path;
+}
+
+bool AvatarCache::lookup(const QString &token, QString &fileName, QString &mimeType)
+{
+    mPriv->ensureLoaded();
+
+    QString name = escapeAsIdentifier(token);
+    QHash<QString, Private::Entry>::iterator i = mPriv->entries.find(name);
+    if (i == mPriv->entries.end()) {
+        return false;
+    }
+
+    // The avatar may have been removed behind our back, e.g. by another client sharing the
+    // directory, in which case the index entry is stale
+    if (!i.value().verified) {
+        if (!QFile::exists(mPriv->filePath(name))) {
+            tpDebug() << "Avatar" << name << "is gone from" << mPriv->path << "- dropping it";
+            mPriv->removeEntry(name);
+            return false;
+        }
+        i.value().verified = true;
+    }
+
+    uint now = QDateTime::currentDateTime().toTime_t();
+    if (now - i.value().lastUsed >= lastUsedGranularity) {
+        i.value().lastUsed = now;
+        mPriv->modified = true;
+    }
+
+    fileName = mPriv->filePath(name);
+    mimeType = i.value().mimeType;
+    return true;
+}
+
+bool AvatarCache::insert(const QString &token, const QByteArray &data, const QString &mimeType,
+        QString &fileName)
+{
+    mPriv->ensureLoaded();
+
+    if (!QDir().mkpath(mPriv->path)) {
+        return false;
+    }
+
+    QString name = escapeAsIdentifier(token);
+    fileName = mPriv->filePath(name);
+    QString mimeTypeFileName = fileName + QLatin1String(".mime");
+
+    if (!QFile::exists(mimeTypeFileName) &&
+            !saveCacheFile(mimeTypeFileName, mimeType.toLatin1())) {
+        return false;
+    }
+
+    bool written = false;
+    if (!QFile::exists(fileName)) {
+        if (!saveCacheFile(fileName, data)) {
+            return false;
+        }
+        written = true;
+    }
+
+    Private::Entry &entry = mPriv->entries[name];
+    written = written || entry.written;
+    mPriv->totalSize += data.size() - entry.size;
+    entry = Private::Entry(mimeType, data.size(), QDateTime::currentDateTime().toTime_t());
+    entry.written = written;
+    entry.verified = true;
+    mPriv->modified = true;
+    return true;
+}
+
+int AvatarCache::count() const
+{
+    mPriv->ensureLoaded();
+    return mPriv->entries.size();
+}
+
+qint64 AvatarCache::size() const
+{
+    mPriv->ensureLoaded();
+    return mPriv->totalSize;
+}
+
+qint64 AvatarCache::sizeLimit() const
+{
+    return mPriv->sizeLimit;
+}
+
+void AvatarCache::setSizeLimit(qint64 bytes)
+{
+    mPriv->sizeLimit = bytes;
+}
+
+/*
+ * Remove the least recently used avatars until the cache fits within the size limit.
+ *
+ * The directory is shared with other clients, and AvatarData hands out the file names, so only
+ * the avatars written by this cache are removed, and never those in \a fileNamesInUse. The
+ * cache may therefore stay over the limit.
+ */
+void AvatarCache::evict(const QSet<QString> &fileNamesInUse)
+{
+    if (mPriv->sizeLimit <= 0 || !mPriv->loaded || mPriv->totalSize <= mPriv->sizeLimit) {
+        return;
+    }
+
+    QMultiMap<uint, QString> byLastUse;
+    for (QHash<QString, Private::Entry>::const_iterator i = mPriv->entries.constBegin();
+            i != mPriv->entries.constEnd(); ++i) {
+        if (i.value().written && !fileNamesInUse.contains(mPriv->filePath(i.key()))) {
+            byLastUse.insert(i.value().lastUsed, i.key());
+        }
+    }
+
+    int evicted = 0;
+    for (QMultiMap<uint, QString>::const_iterator i = byLastUse.constBegin();
+            i != byLastUse.constEnd() && mPriv->totalSize > mPriv->sizeLimit; ++i) {
+        QString fileName = mPriv->filePath(i.value());
+        QFile::remove(fileName);
+        QFile::remove(fileName + QLatin1String(".mime"));
+        mPriv->removeEntry(i.value());
+        evicted++;
+    }
+
+    tpDebug() << "Evicted" << evicted << "avatars from" << mPriv->path;
+    if (mPriv->totalSize > mPriv->sizeLimit) {
+        tpDebug() << "Avatar cache" << mPriv->path << "is still over its size limit, the "
+            "remaining avatars are either in use or not ours";
+    }
+}
+
+bool AvatarCache::isModified() const
+{
+    return mPriv->modified;
+}
+
+bool AvatarCache::sync()
+{
+    if (!mPriv->modified) {
+        return true;
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << indexMagic << indexVersion << static_cast<quint32>(mPriv->entries.size());
+    for (QHash<QString, Private::Entry>::const_iterator i = mPriv->entries.constBegin();
+            i != mPriv->entries.constEnd(); ++i) {
+        out << i.key() << i.value().mimeType << i.value().size << i.value().lastUsed;
+    }
+
+    QString indexPath = mPriv->filePath(QLatin1String(indexFileName));
+    if (out.status() != QDataStream::Ok) {
+        warning() << "Error serializing avatar cache index" << indexPath;
+        return false;
+    }
+
+    if (!saveCacheFile(indexPath, data)) {
+        return false;
+    }
+
+    mPriv->modified = false;
+    return true;
+}
+
+} // Tp
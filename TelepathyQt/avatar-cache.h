@@ -0,0 +1,70 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_avatar_cache_h_HEADER_GUARD_
+#define _TelepathyQt_avatar_cache_h_HEADER_GUARD_
+
+#include <TelepathyQt/Global>
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace Tp
+{
+
+class TP_QT_NO_EXPORT AvatarCache
+{
+public:
+    AvatarCache(const QString &path);
+    ~AvatarCache();
+
+    QString path() const;
+
+    bool lookup(const QString &token, QString &fileName, QString &mimeType);
+    bool insert(const QString &token, const QByteArray &data, const QString &mimeType,
+            QString &fileName);
+
+    int count() const;
+    qint64 size() const;
+
+    qint64 sizeLimit() const;
+    void setSizeLimit(qint64 bytes);
+    void evict(const QSet<QString> &fileNamesInUse);
+
+    bool isModified() const;
+    bool sync();
+
+private:
+    Q_DISABLE_COPY(AvatarCache)
+
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+}
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+#endif
@@ -0,0 +1,1385 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <TelepathyQt/BaseChannel>
+#include "TelepathyQt/base-channel-internal.h"
+
+#include "TelepathyQt/_gen/base-channel.moc.hpp"
+#include "TelepathyQt/_gen/base-channel-internal.moc.hpp"
+
+#include "TelepathyQt/debug-internal.h"
+
+#include <TelepathyQt/Constants>
+#include <TelepathyQt/DBusObject>
+
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+namespace Tp
+{
+
+struct TP_QT_NO_EXPORT BaseChannel::Private
+{
+    Private(BaseChannel *parent, const QDBusConnection &dbusConnection,
+            BaseConnection *connection, const QString &channelType,
+            uint targetHandle, HandleType targetHandleType)
+        : parent(parent),
+          connection(connection),
+          channelType(channelType),
+          targetHandle(targetHandle),
+          targetHandleType(targetHandleType),
+          requested(true),
+          initiatorHandle(0),
+          adaptee(new BaseChannel::Adaptee(dbusConnection, parent))
+    {
+    }
+
+    BaseChannel *parent;
+    BaseConnection *connection;
+    QString channelType;
+    uint targetHandle;
+    HandleType targetHandleType;
+    QString targetID;
+    bool requested;
+    uint initiatorHandle;
+    QString initiatorID;
+
+    BaseChannel::Adaptee *adaptee;
+
+    QHash<QString, AbstractChannelInterfacePtr> interfaces;
+};
+
+BaseChannel::Adaptee::Adaptee(const QDBusConnection &dbusConnection, BaseChannel *channel)
+    : QObject(channel),
+      mChannel(channel)
+{
+    (void) new Service::ChannelAdaptor(dbusConnection, this, channel->dbusObject());
+    connect(channel, SIGNAL(closed()), SIGNAL(closed()));
+}
+
+BaseChannel::Adaptee::~Adaptee()
+{
+}
+
+QString BaseChannel::Adaptee::channelType() const
+{
+    return mChannel->channelType();
+}
+
+QStringList BaseChannel::Adaptee::interfaces() const
+{
+    QStringList ret;
+    foreach (const AbstractChannelInterfacePtr &iface, mChannel->interfaces()) {
+        // the type interface is implemented by the channel but not listed as one of its
+        // interfaces
+        if (iface->interfaceName() != mChannel->channelType()) {
+            ret << iface->interfaceName();
+        }
+    }
+    return ret;
+}
+
+uint BaseChannel::Adaptee::targetHandle() const
+{
+    return mChannel->targetHandle();
+}
+
+QString BaseChannel::Adaptee::targetID() const
+{
+    return mChannel->targetID();
+}
+
+uint BaseChannel::Adaptee::targetHandleType() const
+{
+    return mChannel->targetHandleType();
+}
+
+bool BaseChannel::Adaptee::requested() const
+{
+    return mChannel->requested();
+}
+
+uint BaseChannel::Adaptee::initiatorHandle() const
+{
+    return mChannel->initiatorHandle();
+}
+
+QString BaseChannel::Adaptee::initiatorID() const
+{
+    return mChannel->initiatorID();
+}
+
+void BaseChannel::Adaptee::close(
+        const Tp::Service::ChannelAdaptor::CloseContextPtr &context)
+{
+    mChannel->close();
+    context->setFinished();
+}
+
+void BaseChannel::Adaptee::getChannelType(
+        const Tp::Service::ChannelAdaptor::GetChannelTypeContextPtr &context)
+{
+    context->setFinished(channelType());
+}
+
+void BaseChannel::Adaptee::getHandle(
+        const Tp::Service::ChannelAdaptor::GetHandleContextPtr &context)
+{
+    context->setFinished(targetHandleType(), targetHandle());
+}
+
+void BaseChannel::Adaptee::getInterfaces(
+        const Tp::Service::ChannelAdaptor::GetInterfacesContextPtr &context)
+{
+    context->setFinished(interfaces());
+}
+
+/**
+ * \class BaseChannel
+ * \ingroup servicechannel
+ * \headerfile TelepathyQt/base-channel.h <TelepathyQt/BaseChannel>
+ *
+ * \brief Base class for Channel implementations.
+ *
+ * A BaseChannel implements the org.freedesktop.Telepathy.Channel interface. The
+ * interface of its channel type, for instance BaseChannelTextType, and any other
+ * interface are plugged into it with plugInterface() before it is registered on
+ * the bus with registerObject().
+ *
+ * The channel is exported on the same bus name as the BaseConnection it belongs to,
+ * which must have been registered first. Announcing the channel to clients is left
+ * to the connection implementation.
+ */
+
+/**
+ * Construct a BaseChannel.
+ *
+ * \param dbusConnection The D-Bus connection that will be used by this object.
+ * \param connection The connection this channel belongs to.
+ * \param channelType The D-Bus interface name of the type of this channel,
+ * ex. TP_QT_IFACE_CHANNEL_TYPE_TEXT.
+ * \param targetHandle The handle of the entity this channel communicates with,
+ * or 0 if \a targetHandleType is HandleTypeNone.
+ * \param targetHandleType The type of \a targetHandle.
+ */
+BaseChannel::BaseChannel(const QDBusConnection &dbusConnection, BaseConnection *connection,
+        const QString &channelType, uint targetHandle, HandleType targetHandleType)
+    : DBusService(dbusConnection),
+      mPriv(new Private(this, dbusConnection, connection,
+                  channelType, targetHandle, targetHandleType))
+{
+}
+
+/**
+ * Class destructor.
+ */
+BaseChannel::~BaseChannel()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the connection this channel belongs to.
+ *
+ * \return A pointer to the BaseConnection this channel belongs to.
+ */
+BaseConnection *BaseChannel::connection() const
+{
+    return mPriv->connection;
+}
+
+/**
+ * Return the immutable properties of this channel object, including the ones
+ * of the interfaces plugged into it.
+ *
+ * Immutable properties cannot change after the object has been registered
+ * on the bus with registerObject().
+ *
+ * \return The immutable properties of this channel object.
+ */
+QVariantMap BaseChannel::immutableProperties() const
+{
+    QVariantMap ret;
+    foreach (const AbstractChannelInterfacePtr &iface, mPriv->interfaces) {
+        ret.unite(iface->immutableProperties());
+    }
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
+            QVariant::fromValue(mPriv->adaptee->channelType()));
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".Interfaces"),
+            QVariant::fromValue(mPriv->adaptee->interfaces()));
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandle"),
+            QVariant::fromValue(mPriv->adaptee->targetHandle()));
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetID"),
+            QVariant::fromValue(mPriv->adaptee->targetID()));
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"),
+            QVariant::fromValue(mPriv->adaptee->targetHandleType()));
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".Requested"),
+            QVariant::fromValue(mPriv->adaptee->requested()));
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorHandle"),
+            QVariant::fromValue(mPriv->adaptee->initiatorHandle()));
+    ret.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorID"),
+            QVariant::fromValue(mPriv->adaptee->initiatorID()));
+    return ret;
+}
+
+/**
+ * Return a unique name for this channel.
+ *
+ * The name is used as the last element of the object path of this channel,
+ * below the object path of its connection.
+ *
+ * \return A unique name for this channel.
+ */
+QString BaseChannel::uniqueName() const
+{
+    return QString(QLatin1String("_%1")).arg((quintptr) this, 0, 16);
+}
+
+/**
+ * Register this channel object on the bus.
+ *
+ * The connection this channel belongs to must have been registered already.
+ *
+ * If \a error is passed, any D-Bus error that may occur will
+ * be stored there.
+ *
+ * \param error A pointer to an empty DBusError where any
+ * possible D-Bus error will be stored.
+ * \return \c true on success and \c false if there was an error
+ * or this channel object is already registered.
+ * \sa isRegistered()
+ */
+bool BaseChannel::registerObject(DBusError *error)
+{
+    if (isRegistered()) {
+        return true;
+    }
+
+    if (!mPriv->connection->isRegistered()) {
+        if (error) {
+            error->set(TP_QT_ERROR_NOT_AVAILABLE,
+                QLatin1String("The connection of this channel is not registered"));
+        }
+        tpDebug() << "Unable to register channel - connection not registered";
+        return false;
+    }
+
+    QString objectPath = QString(QLatin1String("%1/%2"))
+        .arg(mPriv->connection->objectPath(), uniqueName());
+    DBusError _error;
+    bool ret = registerObject(mPriv->connection->busName(), objectPath, &_error);
+    if (!ret && error) {
+        error->set(_error.name(), _error.message());
+    }
+    return ret;
+}
+
+/**
+ * Reimplemented from DBusService.
+ */
+bool BaseChannel::registerObject(const QString &busName,
+        const QString &objectPath, DBusError *error)
+{
+    if (isRegistered()) {
+        return true;
+    }
+
+    foreach (const AbstractChannelInterfacePtr &iface, mPriv->interfaces) {
+        if (!iface->registerInterface(dbusObject())) {
+            // lets not fail if an optional interface fails registering, lets warn only
+            warning() << "Unable to register interface" << iface->interfaceName() <<
+                "for channel" << objectPath;
+        }
+    }
+    return DBusService::registerObject(busName, objectPath, error);
+}
+
+/**
+ * Return the D-Bus interface name of the type of this channel.
+ *
+ * \return The channel type, ex. TP_QT_IFACE_CHANNEL_TYPE_TEXT.
+ */
+QString BaseChannel::channelType() const
+{
+    return mPriv->channelType;
+}
+
+/**
+ * Return the handle of the entity this channel communicates with.
+ *
+ * \return The target handle, or 0 if targetHandleType() is HandleTypeNone.
+ */
+uint BaseChannel::targetHandle() const
+{
+    return mPriv->targetHandle;
+}
+
+/**
+ * Return the type of the handle returned by targetHandle().
+ *
+ * \return The target handle type as #HandleType.
+ */
+HandleType BaseChannel::targetHandleType() const
+{
+    return mPriv->targetHandleType;
+}
+
+/**
+ * Return the identifier of the entity this channel communicates with.
+ *
+ * \return The target identifier that has been set with setTargetID().
+ * \sa setTargetID()
+ */
+QString BaseChannel::targetID() const
+{
+    return mPriv->targetID;
+}
+
+/**
+ * Set the identifier of the entity this channel communicates with, which
+ * corresponds to targetHandle().
+ *
+ * This property is immutable and cannot change after this Channel
+ * object has been registered on the bus with registerObject().
+ *
+ * \param targetID The identifier to set.
+ * \sa targetID()
+ */
+void BaseChannel::setTargetID(const QString &targetID)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannel::setTargetID: cannot change property after "
+            "registration, immutable property";
+        return;
+    }
+    mPriv->targetID = targetID;
+}
+
+/**
+ * Return whether this channel was created in response to a request from
+ * the local user.
+ *
+ * \return \c true if the channel was requested, \c false otherwise.
+ * \sa setRequested()
+ */
+bool BaseChannel::requested() const
+{
+    return mPriv->requested;
+}
+
+/**
+ * Set whether this channel was created in response to a request from the local
+ * user. Channels are taken to be requested unless this is set to \c false.
+ *
+ * This property is immutable and cannot change after this Channel
+ * object has been registered on the bus with registerObject().
+ *
+ * \param requested Whether the channel was requested.
+ * \sa requested()
+ */
+void BaseChannel::setRequested(bool requested)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannel::setRequested: cannot change property after "
+            "registration, immutable property";
+        return;
+    }
+    mPriv->requested = requested;
+}
+
+/**
+ * Return the handle of the contact who initiated this channel.
+ *
+ * \return The initiator handle that has been set with setInitiatorHandle().
+ * \sa setInitiatorHandle()
+ */
+uint BaseChannel::initiatorHandle() const
+{
+    return mPriv->initiatorHandle;
+}
+
+/**
+ * Set the handle of the contact who initiated this channel.
+ *
+ * This property is immutable and cannot change after this Channel
+ * object has been registered on the bus with registerObject().
+ *
+ * \param initiatorHandle The handle to set.
+ * \sa initiatorHandle()
+ */
+void BaseChannel::setInitiatorHandle(uint initiatorHandle)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannel::setInitiatorHandle: cannot change property after "
+            "registration, immutable property";
+        return;
+    }
+    mPriv->initiatorHandle = initiatorHandle;
+}
+
+/**
+ * Return the identifier of the contact who initiated this channel.
+ *
+ * \return The initiator identifier that has been set with setInitiatorID().
+ * \sa setInitiatorID()
+ */
+QString BaseChannel::initiatorID() const
+{
+    return mPriv->initiatorID;
+}
+
+/**
+ * Set the identifier of the contact who initiated this channel, which
+ * corresponds to initiatorHandle().
+ *
+ * This property is immutable and cannot change after this Channel
+ * object has been registered on the bus with registerObject().
+ *
+ * \param initiatorID The identifier to set.
+ * \sa initiatorID()
+ */
+void BaseChannel::setInitiatorID(const QString &initiatorID)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannel::setInitiatorID: cannot change property after "
+            "registration, immutable property";
+        return;
+    }
+    mPriv->initiatorID = initiatorID;
+}
+
+/**
+ * Return a list of interfaces that have been plugged into this Channel
+ * D-Bus object with plugInterface(), including the one of the channel type.
+ *
+ * \return A list containing all the Channel interface implementation objects.
+ * \sa plugInterface(), interface()
+ */
+QList<AbstractChannelInterfacePtr> BaseChannel::interfaces() const
+{
+    return mPriv->interfaces.values();
+}
+
+/**
+ * Return a pointer to the interface with the given name.
+ *
+ * \param interfaceName The D-Bus name of the interface,
+ * ex. TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES.
+ * \return A pointer to the AbstractChannelInterface object that implements
+ * the D-Bus interface with the given name, or a null pointer if such an interface
+ * has not been plugged into this object.
+ * \sa plugInterface(), interfaces()
+ */
+AbstractChannelInterfacePtr BaseChannel::interface(const QString &interfaceName) const
+{
+    return mPriv->interfaces.value(interfaceName);
+}
+
+/**
+ * Plug a new interface into this Channel D-Bus object.
+ *
+ * This property is immutable and cannot change after this Channel
+ * object has been registered on the bus with registerObject().
+ *
+ * \param interface An AbstractChannelInterface instance that implements
+ * the interface that is to be plugged.
+ * \return \c true on success or \c false otherwise
+ * \sa interfaces(), interface()
+ */
+bool BaseChannel::plugInterface(const AbstractChannelInterfacePtr &interface)
+{
+    if (isRegistered()) {
+        warning() << "Unable to plug channel interface " << interface->interfaceName() <<
+            "- channel already registered";
+        return false;
+    }
+
+    if (interface->isRegistered()) {
+        warning() << "Unable to plug channel interface" << interface->interfaceName() <<
+            "- interface already registered";
+        return false;
+    }
+
+    if (mPriv->interfaces.contains(interface->interfaceName())) {
+        warning() << "Unable to plug channel interface" << interface->interfaceName() <<
+            "- another interface with same name already plugged";
+        return false;
+    }
+
+    tpDebug() << "Interface" << interface->interfaceName() << "plugged";
+    mPriv->interfaces.insert(interface->interfaceName(), interface);
+    return true;
+}
+
+/**
+ * Close this channel.
+ *
+ * This emits the Closed signal on the bus and closed(). This method is called
+ * when a client calls Close on the channel, and may also be called by the
+ * connection implementation itself.
+ */
+void BaseChannel::close()
+{
+    emit closed();
+}
+
+/**
+ * \fn void BaseChannel::closed()
+ *
+ * Emitted when this channel has been closed with close().
+ */
+
+/**
+ * \class AbstractChannelInterface
+ * \ingroup servicechannel
+ * \headerfile TelepathyQt/base-channel.h <TelepathyQt/AbstractChannelInterface>
+ *
+ * \brief Base class for all the Channel object interface implementations.
+ */
+
+// AbstractChannelInterface
+AbstractChannelInterface::AbstractChannelInterface(const QString &interfaceName)
+    : AbstractDBusServiceInterface(interfaceName)
+{
+}
+
+AbstractChannelInterface::~AbstractChannelInterface()
+{
+}
+
+// Chan.T.Text
+namespace
+{
+
+// Messages are announced from the event loop in chunks of this size, so that a connection
+// receiving a long burst still gets to process the method calls in between
+const int maxMessagesPerFlush = 512;
+
+// The pending messages, indexed by id, and their ids in the order they were received. Acknowledged
+// ids are left behind in the order until they outnumber the pending messages, at which point it is
+// compacted, so a message which is never acknowledged doesn't make the queue grow without bound.
+class PendingMessageQueue
+{
+public:
+    PendingMessageQueue()
+        : mNextId(0)
+    {
+    }
+
+    uint nextId() const { return mNextId; }
+    int size() const { return mMessages.size(); }
+
+    // The ids of the pending messages, oldest first
+    UIntList ids() const
+    {
+        UIntList ret;
+        foreach (uint id, mOrder) {
+            if (mMessages.contains(id)) {
+                ret << id;
+            }
+        }
+        return ret;
+    }
+
+    uint append(const MessagePartList &message)
+    {
+        uint id = mNextId++;
+        mMessages.insert(id, message);
+        mOrder.append(id);
+        return id;
+    }
+
+    const MessagePartList *find(uint id) const
+    {
+        QHash<uint, MessagePartList>::const_iterator i = mMessages.constFind(id);
+        return i != mMessages.constEnd() ? &i.value() : 0;
+    }
+
+    bool remove(uint id)
+    {
+        if (!mMessages.remove(id)) {
+            return false;
+        }
+
+        // at least as many messages are removed between two compactions as are left, so this is
+        // O(1) amortized
+        if (mOrder.size() > 2 * mMessages.size() + 16) {
+            QVector<uint> order;
+            order.reserve(mMessages.size());
+            foreach (uint pendingId, mOrder) {
+                if (mMessages.contains(pendingId)) {
+                    order.append(pendingId);
+                }
+            }
+            mOrder = order;
+        }
+        return true;
+    }
+
+private:
+    QHash<uint, MessagePartList> mMessages;
+    QVector<uint> mOrder;
+    uint mNextId;
+};
+
+QVariant headerValue(const MessagePartList &message, const char *key)
+{
+    if (message.isEmpty()) {
+        return QVariant();
+    }
+    return message.first().value(QLatin1String(key)).variant();
+}
+
+// The Channel.Type.Text view of a message, as used by the Received signal
+PendingTextMessage textMessage(uint id, const MessagePartList &message)
+{
+    PendingTextMessage ret;
+    ret.identifier = id;
+    QVariant timestamp = headerValue(message, "message-received");
+    if (!timestamp.isValid()) {
+        timestamp = headerValue(message, "message-sent");
+    }
+    ret.unixTimestamp = timestamp.toUInt();
+    ret.sender = headerValue(message, "message-sender").toUInt();
+    ret.messageType = headerValue(message, "message-type").toUInt();
+    ret.flags = 0;
+    if (headerValue(message, "scrollback").toBool()) {
+        ret.flags |= ChannelTextMessageFlagScrollback;
+    }
+    if (headerValue(message, "rescued").toBool()) {
+        ret.flags |= ChannelTextMessageFlagRescued;
+    }
+
+    QSet<QString> textAlternatives;
+    bool hasNonTextContent = false;
+    for (int i = 1; i < message.size(); ++i) {
+        const MessagePart &part = message.at(i);
+        QString alternative = part.value(QLatin1String("alternative")).variant().toString();
+        if (part.value(QLatin1String("content-type")).variant().toString() ==
+                QLatin1String("text/plain")) {
+            if (!alternative.isEmpty()) {
+                if (textAlternatives.contains(alternative)) {
+                    continue;
+                }
+                textAlternatives.insert(alternative);
+            }
+            ret.text += part.value(QLatin1String("content")).variant().toString();
+            if (part.value(QLatin1String("truncated")).variant().toBool()) {
+                ret.flags |= ChannelTextMessageFlagTruncated;
+            }
+        } else if (alternative.isEmpty() || !textAlternatives.contains(alternative)) {
+            hasNonTextContent = true;
+        }
+    }
+    if (hasNonTextContent) {
+        ret.flags |= ChannelTextMessageFlagNonTextContent;
+    }
+    return ret;
+}
+
+}
+
+struct TP_QT_NO_EXPORT BaseChannelTextType::Private
+{
+    Private(BaseChannelTextType *parent)
+        : parent(parent),
+          adaptee(new BaseChannelTextType::Adaptee(parent)),
+          nextAnnouncedId(0),
+          flushScheduled(false)
+    {
+        messageTypes << ChannelTextMessageTypeNormal << ChannelTextMessageTypeAction <<
+            ChannelTextMessageTypeNotice;
+    }
+
+    BaseChannelTextType *parent;
+    BaseChannelTextType::Adaptee *adaptee;
+    UIntList messageTypes;
+    SendMessageCallback sendMessageCb;
+
+    PendingMessageQueue pending;
+    // Received messages with ids from here up to pending.nextId() have not been announced yet
+    uint nextAnnouncedId;
+    bool flushScheduled;
+};
+
+BaseChannelTextType::Adaptee::Adaptee(BaseChannelTextType *interface)
+    : QObject(interface),
+      mInterface(interface)
+{
+    connect(interface, SIGNAL(messageSent(Tp::MessagePartList,uint,QString)),
+            SLOT(onMessageSent(Tp::MessagePartList,uint,QString)));
+}
+
+BaseChannelTextType::Adaptee::~Adaptee()
+{
+}
+
+void BaseChannelTextType::Adaptee::announceReceived(bool all)
+{
+    BaseChannelTextType::Private *priv = mInterface->mPriv;
+    int count = 0;
+    while (priv->nextAnnouncedId != priv->pending.nextId() &&
+            (all || count < maxMessagesPerFlush)) {
+        uint id = priv->nextAnnouncedId++;
+        // the connection may have acknowledged it already
+        const MessagePartList *message = priv->pending.find(id);
+        if (!message) {
+            continue;
+        }
+
+        PendingTextMessage text = textMessage(id, *message);
+        emit received(text.identifier, text.unixTimestamp, text.sender,
+                text.messageType, text.flags, text.text);
+        emit mInterface->messageReceived(*message);
+        ++count;
+    }
+
+    if (priv->nextAnnouncedId != priv->pending.nextId() && !priv->flushScheduled) {
+        priv->flushScheduled = true;
+        QTimer::singleShot(0, this, SLOT(flushReceived()));
+    }
+}
+
+void BaseChannelTextType::Adaptee::acknowledgePendingMessages(const Tp::UIntList &IDs,
+        const Tp::Service::ChannelTypeTextAdaptor::AcknowledgePendingMessagesContextPtr &context)
+{
+    DBusError error;
+    if (!mInterface->acknowledgePendingMessages(IDs, &error)) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished();
+}
+
+void BaseChannelTextType::Adaptee::getMessageTypes(
+        const Tp::Service::ChannelTypeTextAdaptor::GetMessageTypesContextPtr &context)
+{
+    context->setFinished(mInterface->messageTypes());
+}
+
+void BaseChannelTextType::Adaptee::listPendingMessages(bool clear,
+        const Tp::Service::ChannelTypeTextAdaptor::ListPendingMessagesContextPtr &context)
+{
+    // make sure the client has seen every message it gets here
+    announceReceived(true);
+
+    const PendingMessageQueue &pending = mInterface->mPriv->pending;
+    PendingTextMessageList ret;
+    UIntList ids;
+    foreach (uint id, pending.ids()) {
+        ret << textMessage(id, *pending.find(id));
+        ids << id;
+    }
+
+    if (clear && !ids.isEmpty()) {
+        mInterface->acknowledgePendingMessages(ids, 0);
+    }
+    context->setFinished(ret);
+}
+
+void BaseChannelTextType::Adaptee::send(uint type, const QString &text,
+        const Tp::Service::ChannelTypeTextAdaptor::SendContextPtr &context)
+{
+    MessagePartList message;
+    MessagePart header;
+    header.insert(QLatin1String("message-type"), QDBusVariant(type));
+    MessagePart body;
+    body.insert(QLatin1String("content-type"), QDBusVariant(QLatin1String("text/plain")));
+    body.insert(QLatin1String("content"), QDBusVariant(text));
+    message << header << body;
+
+    DBusError error;
+    mInterface->sendMessage(message, 0, &error);
+    if (error.isValid()) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished();
+}
+
+void BaseChannelTextType::Adaptee::flushReceived()
+{
+    mInterface->mPriv->flushScheduled = false;
+    announceReceived(false);
+}
+
+void BaseChannelTextType::Adaptee::onMessageSent(const Tp::MessagePartList &content,
+        uint flags, const QString &messageToken)
+{
+    Q_UNUSED(flags);
+    Q_UNUSED(messageToken);
+
+    PendingTextMessage text = textMessage(0, content);
+    emit sent(QDateTime::currentDateTime().toTime_t(), text.messageType, text.text);
+}
+
+/**
+ * \class BaseChannelTextType
+ * \ingroup servicechannel
+ * \headerfile TelepathyQt/base-channel.h <TelepathyQt/BaseChannelTextType>
+ *
+ * \brief Base class for implementations of Channel.Type.Text
+ *
+ * BaseChannelTextType keeps the queue of pending messages of a text channel.
+ * Messages received by the connection are added to it with addReceivedMessage()
+ * and stay there until a client acknowledges them.
+ *
+ * Adding a message is cheap: the D-Bus signals announcing new messages are not
+ * sent right away, but from the event loop, for all the messages received since
+ * the last time it ran. Looking up and acknowledging a message take constant time
+ * regardless of the number of messages that are pending.
+ *
+ * To support the Messages interface, which all text channels should, plug a
+ * BaseChannelMessagesInterface created for this object into the channel as well.
+ */
+
+/**
+ * Class constructor.
+ */
+BaseChannelTextType::BaseChannelTextType()
+    : AbstractChannelInterface(TP_QT_IFACE_CHANNEL_TYPE_TEXT),
+      mPriv(new Private(this))
+{
+}
+
+/**
+ * Class destructor.
+ */
+BaseChannelTextType::~BaseChannelTextType()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the immutable properties of this interface.
+ *
+ * Immutable properties cannot change after the interface has been registered
+ * on a service on the bus with registerInterface().
+ *
+ * \return The immutable properties of this interface.
+ */
+QVariantMap BaseChannelTextType::immutableProperties() const
+{
+    // no immutable property
+    return QVariantMap();
+}
+
+/**
+ * Return the message types that have been set with setMessageTypes().
+ *
+ * By default these are #ChannelTextMessageTypeNormal, #ChannelTextMessageTypeAction
+ * and #ChannelTextMessageTypeNotice.
+ *
+ * \return The list of #ChannelTextMessageType that may be sent on this channel.
+ * \sa setMessageTypes()
+ */
+UIntList BaseChannelTextType::messageTypes() const
+{
+    return mPriv->messageTypes;
+}
+
+/**
+ * Set the message types that may be sent on this channel.
+ *
+ * This is exposed by the GetMessageTypes method and as the MessageTypes
+ * property of the Messages interface.
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on the bus.
+ *
+ * \param messageTypes The list of #ChannelTextMessageType to set.
+ * \sa messageTypes()
+ */
+void BaseChannelTextType::setMessageTypes(const UIntList &messageTypes)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannelTextType::setMessageTypes: cannot change property after "
+            "registration, immutable property";
+        return;
+    }
+    mPriv->messageTypes = messageTypes;
+}
+
+/**
+ * Set a callback that will be called to send a message, when this has been
+ * requested by a client.
+ *
+ * The callback receives the message and the #MessageSendingFlag flags, and returns
+ * the token of the sent message, which may be empty.
+ *
+ * \param cb The callback to set.
+ * \sa sendMessage()
+ */
+void BaseChannelTextType::setSendMessageCallback(const SendMessageCallback &cb)
+{
+    mPriv->sendMessageCb = cb;
+}
+
+/**
+ * Send a message using the callback set with setSendMessageCallback().
+ *
+ * This method is called when a client calls Send on Channel.Type.Text or
+ * SendMessage on Channel.Interface.Messages. If the message was sent, this
+ * emits the corresponding Sent and MessageSent signals.
+ *
+ * \param message The message to send.
+ * \param flags The #MessageSendingFlag flags for sending \a message.
+ * \param error A pointer to an empty DBusError where any
+ * possible error will be stored, or 0.
+ * \return The token of the sent message.
+ * \sa setSendMessageCallback()
+ */
+QString BaseChannelTextType::sendMessage(const MessagePartList &message, uint flags,
+        DBusError *error)
+{
+    if (!mPriv->sendMessageCb.isValid()) {
+        if (error) {
+            error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
+        }
+        return QString();
+    }
+
+    // the callback needs somewhere to report errors, and we need to know whether it did
+    DBusError localError;
+    if (!error) {
+        error = &localError;
+    }
+
+    QString token = mPriv->sendMessageCb(message, flags, error);
+    if (error->isValid()) {
+        return QString();
+    }
+
+    emit messageSent(message, flags, token);
+    return token;
+}
+
+/**
+ * Add a message received by the connection to the queue of pending messages.
+ *
+ * The message is given an id, which is set as its "pending-message-id" header,
+ * and announced to clients with the Received and MessageReceived signals once
+ * the event loop runs.
+ *
+ * \param message The message that was received.
+ * \return The id of the message.
+ * \sa acknowledgePendingMessages()
+ */
+uint BaseChannelTextType::addReceivedMessage(const MessagePartList &message)
+{
+    MessagePartList pending(message);
+    if (pending.isEmpty()) {
+        pending << MessagePart();
+    }
+    uint id = mPriv->pending.nextId();
+    pending[0].insert(QLatin1String("pending-message-id"), QDBusVariant(id));
+    mPriv->pending.append(pending);
+
+    if (!mPriv->flushScheduled) {
+        mPriv->flushScheduled = true;
+        QTimer::singleShot(0, mPriv->adaptee, SLOT(flushReceived()));
+    }
+    return id;
+}
+
+/**
+ * Return the number of messages which have not been acknowledged yet.
+ *
+ * \return The number of pending messages.
+ */
+int BaseChannelTextType::pendingMessageCount() const
+{
+    return mPriv->pending.size();
+}
+
+/**
+ * Return the messages which have not been acknowledged yet, oldest first.
+ *
+ * Messages which have not been announced on the bus yet are announced first,
+ * as this is also what clients reading the pending messages get.
+ *
+ * \return The list of pending messages.
+ */
+MessagePartListList BaseChannelTextType::pendingMessages() const
+{
+    mPriv->adaptee->announceReceived(true);
+
+    MessagePartListList ret;
+    const PendingMessageQueue &pending = mPriv->pending;
+    foreach (uint id, pending.ids()) {
+        ret << *pending.find(id);
+    }
+    return ret;
+}
+
+/**
+ * Return the pending message with the given id.
+ *
+ * Like pendingMessages(), this announces the messages which have not been
+ * announced on the bus yet first.
+ *
+ * \param messageId The id of the message.
+ * \return The message, or an empty list if there is no pending message with
+ * the given id.
+ */
+MessagePartList BaseChannelTextType::pendingMessage(uint messageId) const
+{
+    mPriv->adaptee->announceReceived(true);
+
+    const MessagePartList *message = mPriv->pending.find(messageId);
+    return message ? *message : MessagePartList();
+}
+
+/**
+ * Remove the messages with the given ids from the queue of pending messages.
+ *
+ * This method is called when a client calls AcknowledgePendingMessages, and
+ * emits the PendingMessagesRemoved signal for the removed messages. If any of
+ * the ids is not the one of a pending message, no message is removed.
+ *
+ * \param messageIds The ids of the messages to remove.
+ * \param error A pointer to an empty DBusError where any
+ * possible error will be stored.
+ * \return \c true on success or \c false otherwise.
+ */
+bool BaseChannelTextType::acknowledgePendingMessages(const UIntList &messageIds,
+        DBusError *error)
+{
+    foreach (uint id, messageIds) {
+        if (!mPriv->pending.find(id)) {
+            if (error) {
+                error->set(TP_QT_ERROR_INVALID_ARGUMENT,
+                        QString(QLatin1String("Message %1 is not pending")).arg(id));
+            }
+            return false;
+        }
+    }
+
+    // don't let clients see a message removed before it was announced
+    mPriv->adaptee->announceReceived(true);
+
+    UIntList removed;
+    foreach (uint id, messageIds) {
+        if (mPriv->pending.remove(id)) {
+            removed << id;
+        }
+    }
+    if (!removed.isEmpty()) {
+        emit pendingMessagesRemoved(removed);
+    }
+    return true;
+}
+
+void BaseChannelTextType::createAdaptor()
+{
+    (void) new Service::ChannelTypeTextAdaptor(dbusObject()->dbusConnection(),
+            mPriv->adaptee, dbusObject());
+}
+
+/**
+ * \fn void BaseChannelTextType::messageReceived(const Tp::MessagePartList &message)
+ *
+ * Emitted when a message added with addReceivedMessage() has been announced on the bus.
+ *
+ * \param message The message.
+ */
+
+/**
+ * \fn void BaseChannelTextType::pendingMessagesRemoved(const Tp::UIntList &messageIds)
+ *
+ * Emitted when pending messages have been acknowledged.
+ *
+ * \param messageIds The ids of the messages which were removed.
+ */
+
+/**
+ * \fn void BaseChannelTextType::messageSent(const Tp::MessagePartList &content,
+ *     uint flags, const QString &messageToken)
+ *
+ * Emitted when a message has been sent with sendMessage().
+ *
+ * \param content The message.
+ * \param flags The #MessageSendingFlag flags the message was sent with.
+ * \param messageToken The token returned by the send callback.
+ */
+
+// Chan.I.Messages
+BaseChannelMessagesInterface::Adaptee::Adaptee(BaseChannelMessagesInterface *interface)
+    : QObject(interface),
+      mInterface(interface)
+{
+}
+
+BaseChannelMessagesInterface::Adaptee::~Adaptee()
+{
+}
+
+QStringList BaseChannelMessagesInterface::Adaptee::supportedContentTypes() const
+{
+    return mInterface->supportedContentTypes();
+}
+
+Tp::UIntList BaseChannelMessagesInterface::Adaptee::messageTypes() const
+{
+    return mInterface->textType()->messageTypes();
+}
+
+uint BaseChannelMessagesInterface::Adaptee::messagePartSupportFlags() const
+{
+    return mInterface->messagePartSupportFlags();
+}
+
+Tp::MessagePartListList BaseChannelMessagesInterface::Adaptee::pendingMessages() const
+{
+    return mInterface->textType()->pendingMessages();
+}
+
+uint BaseChannelMessagesInterface::Adaptee::deliveryReportingSupport() const
+{
+    return mInterface->deliveryReportingSupport();
+}
+
+void BaseChannelMessagesInterface::Adaptee::sendMessage(const Tp::MessagePartList &message,
+        uint flags,
+        const Tp::Service::ChannelInterfaceMessagesAdaptor::SendMessageContextPtr &context)
+{
+    DBusError error;
+    QString token = mInterface->textType()->sendMessage(message, flags, &error);
+    if (error.isValid()) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished(token);
+}
+
+void BaseChannelMessagesInterface::Adaptee::getPendingMessageContent(uint messageID,
+        const Tp::UIntList &parts,
+        const Tp::Service::ChannelInterfaceMessagesAdaptor::GetPendingMessageContentContextPtr &context)
+{
+    MessagePartList message = mInterface->textType()->pendingMessage(messageID);
+    if (message.isEmpty()) {
+        context->setFinishedWithError(TP_QT_ERROR_INVALID_ARGUMENT,
+                QString(QLatin1String("Message %1 is not pending")).arg(messageID));
+        return;
+    }
+
+    MessagePartContentMap ret;
+    foreach (uint part, parts) {
+        // part 0 is the header, which has no content
+        if (part == 0 || part >= (uint) message.size()) {
+            context->setFinishedWithError(TP_QT_ERROR_INVALID_ARGUMENT,
+                    QString(QLatin1String("Message %1 has no part %2")).arg(messageID).arg(part));
+            return;
+        }
+        ret.insert(part, message.at(part).value(QLatin1String("content")));
+    }
+    context->setFinished(ret);
+}
+
+struct TP_QT_NO_EXPORT BaseChannelMessagesInterface::Private
+{
+    Private(BaseChannelMessagesInterface *parent, const BaseChannelTextTypePtr &textType)
+        : textType(textType),
+          messagePartSupportFlags(0),
+          deliveryReportingSupport(0),
+          adaptee(new BaseChannelMessagesInterface::Adaptee(parent))
+    {
+    }
+
+    BaseChannelTextTypePtr textType;
+    QStringList supportedContentTypes;
+    uint messagePartSupportFlags;
+    uint deliveryReportingSupport;
+    BaseChannelMessagesInterface::Adaptee *adaptee;
+};
+
+/**
+ * \class BaseChannelMessagesInterface
+ * \ingroup servicechannel
+ * \headerfile TelepathyQt/base-channel.h <TelepathyQt/BaseChannelMessagesInterface>
+ *
+ * \brief Base class for implementations of Channel.Interface.Messages
+ *
+ * The pending messages and the sending of messages are shared with the
+ * BaseChannelTextType this interface is created for.
+ */
+
+/**
+ * Class constructor.
+ *
+ * \param textType The text type interface of the channel this interface is plugged into.
+ */
+BaseChannelMessagesInterface::BaseChannelMessagesInterface(
+        const BaseChannelTextTypePtr &textType)
+    : AbstractChannelInterface(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES),
+      mPriv(new Private(this, textType))
+{
+    connect(textType.data(), SIGNAL(messageReceived(Tp::MessagePartList)),
+            mPriv->adaptee, SIGNAL(messageReceived(Tp::MessagePartList)));
+    connect(textType.data(), SIGNAL(pendingMessagesRemoved(Tp::UIntList)),
+            mPriv->adaptee, SIGNAL(pendingMessagesRemoved(Tp::UIntList)));
+    connect(textType.data(), SIGNAL(messageSent(Tp::MessagePartList,uint,QString)),
+            mPriv->adaptee, SIGNAL(messageSent(Tp::MessagePartList,uint,QString)));
+}
+
+/**
+ * Class destructor.
+ */
+BaseChannelMessagesInterface::~BaseChannelMessagesInterface()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the immutable properties of this interface.
+ *
+ * Immutable properties cannot change after the interface has been registered
+ * on a service on the bus with registerInterface().
+ *
+ * \return The immutable properties of this interface.
+ */
+QVariantMap BaseChannelMessagesInterface::immutableProperties() const
+{
+    QVariantMap map;
+    map.insert(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES + QLatin1String(".SupportedContentTypes"),
+            QVariant::fromValue(mPriv->adaptee->supportedContentTypes()));
+    map.insert(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES + QLatin1String(".MessageTypes"),
+            QVariant::fromValue(mPriv->adaptee->messageTypes()));
+    map.insert(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES + QLatin1String(".MessagePartSupportFlags"),
+            QVariant::fromValue(mPriv->adaptee->messagePartSupportFlags()));
+    map.insert(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES + QLatin1String(".DeliveryReportingSupport"),
+            QVariant::fromValue(mPriv->adaptee->deliveryReportingSupport()));
+    return map;
+}
+
+/**
+ * Return the text type interface this interface was created for.
+ *
+ * \return A pointer to the BaseChannelTextType object.
+ */
+BaseChannelTextTypePtr BaseChannelMessagesInterface::textType() const
+{
+    return mPriv->textType;
+}
+
+/**
+ * Return the content types that have been set with setSupportedContentTypes().
+ *
+ * \return The list of MIME types supported by this channel.
+ * \sa setSupportedContentTypes()
+ */
+QStringList BaseChannelMessagesInterface::supportedContentTypes() const
+{
+    return mPriv->supportedContentTypes;
+}
+
+/**
+ * Set the MIME types supported by this channel, with the most preferred first.
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on the bus.
+ *
+ * \param supportedContentTypes The list of MIME types to set.
+ * \sa supportedContentTypes()
+ */
+void BaseChannelMessagesInterface::setSupportedContentTypes(
+        const QStringList &supportedContentTypes)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannelMessagesInterface::setSupportedContentTypes: cannot change "
+            "property after registration, immutable property";
+        return;
+    }
+    mPriv->supportedContentTypes = supportedContentTypes;
+}
+
+/**
+ * Return the flags that have been set with setMessagePartSupportFlags().
+ *
+ * \return The #MessagePartSupportFlag flags of this channel.
+ * \sa setMessagePartSupportFlags()
+ */
+uint BaseChannelMessagesInterface::messagePartSupportFlags() const
+{
+    return mPriv->messagePartSupportFlags;
+}
+
+/**
+ * Set the flags describing the multipart messages this channel can send.
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on the bus.
+ *
+ * \param messagePartSupportFlags The #MessagePartSupportFlag flags to set.
+ * \sa messagePartSupportFlags()
+ */
+void BaseChannelMessagesInterface::setMessagePartSupportFlags(uint messagePartSupportFlags)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannelMessagesInterface::setMessagePartSupportFlags: cannot change "
+            "property after registration, immutable property";
+        return;
+    }
+    mPriv->messagePartSupportFlags = messagePartSupportFlags;
+}
+
+/**
+ * Return the flags that have been set with setDeliveryReportingSupport().
+ *
+ * \return The #DeliveryReportingSupportFlag flags of this channel.
+ * \sa setDeliveryReportingSupport()
+ */
+uint BaseChannelMessagesInterface::deliveryReportingSupport() const
+{
+    return mPriv->deliveryReportingSupport;
+}
+
+/**
+ * Set the flags describing the delivery reports this channel supports.
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on the bus.
+ *
+ * \param deliveryReportingSupport The #DeliveryReportingSupportFlag flags to set.
+ * \sa deliveryReportingSupport()
+ */
+void BaseChannelMessagesInterface::setDeliveryReportingSupport(uint deliveryReportingSupport)
+{
+    if (isRegistered()) {
+        warning() << "BaseChannelMessagesInterface::setDeliveryReportingSupport: cannot change "
+            "property after registration, immutable property";
+        return;
+    }
+    mPriv->deliveryReportingSupport = deliveryReportingSupport;
+}
+
+void BaseChannelMessagesInterface::createAdaptor()
+{
+    (void) new Service::ChannelInterfaceMessagesAdaptor(dbusObject()->dbusConnection(),
+            mPriv->adaptee, dbusObject());
+}
+
+}
@@ -0,0 +1,233 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_base_channel_h_HEADER_GUARD_
+#define _TelepathyQt_base_channel_h_HEADER_GUARD_
+
+#ifndef IN_TP_QT_HEADER
+#error IN_TP_QT_HEADER
+#endif
+
+#include <TelepathyQt/BaseConnection>
+#include <TelepathyQt/Callbacks>
+#include <TelepathyQt/Constants>
+#include <TelepathyQt/DBusService>
+#include <TelepathyQt/Global>
+#include <TelepathyQt/Types>
+
+#include <QDBusConnection>
+
+class QString;
+class QStringList;
+
+namespace Tp
+{
+
+class TP_QT_EXPORT BaseChannel : public DBusService
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BaseChannel)
+
+public:
+    static BaseChannelPtr create(BaseConnection *connection, const QString &channelType,
+            uint targetHandle = 0, HandleType targetHandleType = HandleTypeNone)
+    {
+        return BaseChannelPtr(new BaseChannel(connection->dbusConnection(), connection,
+                    channelType, targetHandle, targetHandleType));
+    }
+    template<typename BaseChannelSubclass>
+    static SharedPtr<BaseChannelSubclass> create(BaseConnection *connection,
+            const QString &channelType, uint targetHandle = 0,
+            HandleType targetHandleType = HandleTypeNone)
+    {
+        return SharedPtr<BaseChannelSubclass>(new BaseChannelSubclass(
+                    connection->dbusConnection(), connection,
+                    channelType, targetHandle, targetHandleType));
+    }
+
+    virtual ~BaseChannel();
+
+    BaseConnection *connection() const;
+
+    QVariantMap immutableProperties() const;
+
+    virtual QString uniqueName() const;
+    bool registerObject(DBusError *error = NULL);
+
+    QString channelType() const;
+    uint targetHandle() const;
+    HandleType targetHandleType() const;
+
+    QString targetID() const;
+    void setTargetID(const QString &targetID);
+
+    bool requested() const;
+    void setRequested(bool requested);
+
+    uint initiatorHandle() const;
+    void setInitiatorHandle(uint initiatorHandle);
+
+    QString initiatorID() const;
+    void setInitiatorID(const QString &initiatorID);
+
+    QList<AbstractChannelInterfacePtr> interfaces() const;
+    AbstractChannelInterfacePtr interface(const QString &interfaceName) const;
+    bool plugInterface(const AbstractChannelInterfacePtr &interface);
+
+    void close();
+
+Q_SIGNALS:
+    void closed();
+
+protected:
+    BaseChannel(const QDBusConnection &dbusConnection, BaseConnection *connection,
+            const QString &channelType, uint targetHandle, HandleType targetHandleType);
+
+    virtual bool registerObject(const QString &busName, const QString &objectPath,
+            DBusError *error);
+
+private:
+    class Adaptee;
+    friend class Adaptee;
+    class Private;
+    friend class Private;
+    Private *mPriv;
+};
+
+class TP_QT_EXPORT AbstractChannelInterface : public AbstractDBusServiceInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AbstractChannelInterface)
+
+public:
+    AbstractChannelInterface(const QString &interfaceName);
+    virtual ~AbstractChannelInterface();
+
+private:
+    friend class BaseChannel;
+
+    class Private;
+    friend class Private;
+    Private *mPriv;
+};
+
+class TP_QT_EXPORT BaseChannelTextType : public AbstractChannelInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BaseChannelTextType)
+
+public:
+    static BaseChannelTextTypePtr create()
+    {
+        return BaseChannelTextTypePtr(new BaseChannelTextType());
+    }
+    template<typename BaseChannelTextTypeSubclass>
+    static SharedPtr<BaseChannelTextTypeSubclass> create()
+    {
+        return SharedPtr<BaseChannelTextTypeSubclass>(
+                new BaseChannelTextTypeSubclass());
+    }
+
+    virtual ~BaseChannelTextType();
+
+    QVariantMap immutableProperties() const;
+
+    UIntList messageTypes() const;
+    void setMessageTypes(const UIntList &messageTypes);
+
+    typedef Callback3<QString, const MessagePartList &, uint, DBusError*> SendMessageCallback;
+    void setSendMessageCallback(const SendMessageCallback &cb);
+    QString sendMessage(const MessagePartList &message, uint flags, DBusError *error);
+
+    uint addReceivedMessage(const MessagePartList &message);
+    int pendingMessageCount() const;
+    MessagePartListList pendingMessages() const;
+    MessagePartList pendingMessage(uint messageId) const;
+    bool acknowledgePendingMessages(const UIntList &messageIds, DBusError *error);
+
+Q_SIGNALS:
+    void messageReceived(const Tp::MessagePartList &message);
+    void pendingMessagesRemoved(const Tp::UIntList &messageIds);
+    void messageSent(const Tp::MessagePartList &content, uint flags,
+            const QString &messageToken);
+
+protected:
+    BaseChannelTextType();
+
+private:
+    void createAdaptor();
+
+    class Adaptee;
+    friend class Adaptee;
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+class TP_QT_EXPORT BaseChannelMessagesInterface : public AbstractChannelInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BaseChannelMessagesInterface)
+
+public:
+    static BaseChannelMessagesInterfacePtr create(const BaseChannelTextTypePtr &textType)
+    {
+        return BaseChannelMessagesInterfacePtr(new BaseChannelMessagesInterface(textType));
+    }
+    template<typename BaseChannelMessagesInterfaceSubclass>
+    static SharedPtr<BaseChannelMessagesInterfaceSubclass> create(
+            const BaseChannelTextTypePtr &textType)
+    {
+        return SharedPtr<BaseChannelMessagesInterfaceSubclass>(
+                new BaseChannelMessagesInterfaceSubclass(textType));
+    }
+
+    virtual ~BaseChannelMessagesInterface();
+
+    QVariantMap immutableProperties() const;
+
+    BaseChannelTextTypePtr textType() const;
+
+    QStringList supportedContentTypes() const;
+    void setSupportedContentTypes(const QStringList &supportedContentTypes);
+
+    uint messagePartSupportFlags() const;
+    void setMessagePartSupportFlags(uint messagePartSupportFlags);
+
+    uint deliveryReportingSupport() const;
+    void setDeliveryReportingSupport(uint deliveryReportingSupport);
+
+protected:
+    BaseChannelMessagesInterface(const BaseChannelTextTypePtr &textType);
+
+private:
+    void createAdaptor();
+
+    class Adaptee;
+    friend class Adaptee;
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+}
+
+#endif
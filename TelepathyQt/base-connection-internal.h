@@ -26,20 +26,162 @@
 #include <TelepathyQt/MethodInvocationContext>
 #include <TelepathyQt/Types>
 
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
 namespace Tp
 {
 
 class TP_QT_NO_EXPORT BaseConnection::Adaptee : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(QStringList interfaces READ interfaces)
+    Q_PROPERTY(uint selfHandle READ selfHandle)
+    Q_PROPERTY(bool hasImmortalHandles READ hasImmortalHandles)
 
 public:
     Adaptee(const QDBusConnection &dbusConnection, BaseConnection *cm);
     ~Adaptee();
 
+    QStringList interfaces() const;
+    uint selfHandle() const;
+    bool hasImmortalHandles() const;
+
+private Q_SLOTS:
+    void getInterfaces(const Tp::Service::ConnectionAdaptor::GetInterfacesContextPtr &context);
+    void getProtocol(const Tp::Service::ConnectionAdaptor::GetProtocolContextPtr &context);
+    void getSelfHandle(const Tp::Service::ConnectionAdaptor::GetSelfHandleContextPtr &context);
+    void holdHandles(uint handleType, const Tp::UIntList &handles,
+            const Tp::Service::ConnectionAdaptor::HoldHandlesContextPtr &context);
+    void inspectHandles(uint handleType, const Tp::UIntList &handles,
+            const Tp::Service::ConnectionAdaptor::InspectHandlesContextPtr &context);
+    void releaseHandles(uint handleType, const Tp::UIntList &handles,
+            const Tp::Service::ConnectionAdaptor::ReleaseHandlesContextPtr &context);
+    void requestHandles(uint handleType, const QStringList &identifiers,
+            const Tp::Service::ConnectionAdaptor::RequestHandlesContextPtr &context);
+
+Q_SIGNALS:
+    void selfHandleChanged(uint selfHandle);
+
 public:
     BaseConnection *mConnection;
     Service::ConnectionAdaptor *mAdaptor;
 };
 
+class TP_QT_NO_EXPORT BaseConnectionContactsInterface::Adaptee : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList contactAttributeInterfaces READ contactAttributeInterfaces)
+
+public:
+    Adaptee(BaseConnectionContactsInterface *interface);
+    ~Adaptee();
+
+    QStringList contactAttributeInterfaces() const;
+
+private Q_SLOTS:
+    void getContactAttributes(const Tp::UIntList &handles, const QStringList &interfaces,
+            bool hold,
+            const Tp::Service::ConnectionInterfaceContactsAdaptor::GetContactAttributesContextPtr &context);
+
+public:
+    BaseConnectionContactsInterface *mInterface;
+};
+
+class TP_QT_NO_EXPORT BaseConnectionSimplePresenceInterface::Adaptee : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(Tp::SimpleStatusSpecMap statuses READ statuses)
+    Q_PROPERTY(uint maximumStatusMessageLength READ maximumStatusMessageLength)
+
+public:
+    Adaptee(BaseConnectionSimplePresenceInterface *interface);
+    ~Adaptee();
+
+    SimpleStatusSpecMap statuses() const;
+    uint maximumStatusMessageLength() const;
+
+private Q_SLOTS:
+    void setPresence(const QString &status, const QString &statusMessage,
+            const Tp::Service::ConnectionInterfaceSimplePresenceAdaptor::SetPresenceContextPtr &context);
+    void getPresences(const Tp::UIntList &contacts,
+            const Tp::Service::ConnectionInterfaceSimplePresenceAdaptor::GetPresencesContextPtr &context);
+
+    void flushChanges();
+
+Q_SIGNALS:
+    void presencesChanged(const Tp::SimpleContactPresences &presence);
+
+public:
+    BaseConnectionSimplePresenceInterface *mInterface;
+};
+
+class TP_QT_NO_EXPORT BaseConnectionAliasingInterface::Adaptee : public QObject
+{
+    Q_OBJECT
+
+public:
+    Adaptee(BaseConnectionAliasingInterface *interface);
+    ~Adaptee();
+
+private Q_SLOTS:
+    void getAliasFlags(
+            const Tp::Service::ConnectionInterfaceAliasingAdaptor::GetAliasFlagsContextPtr &context);
+    void requestAliases(const Tp::UIntList &contacts,
+            const Tp::Service::ConnectionInterfaceAliasingAdaptor::RequestAliasesContextPtr &context);
+    void getAliases(const Tp::UIntList &contacts,
+            const Tp::Service::ConnectionInterfaceAliasingAdaptor::GetAliasesContextPtr &context);
+    void setAliases(const Tp::AliasMap &aliases,
+            const Tp::Service::ConnectionInterfaceAliasingAdaptor::SetAliasesContextPtr &context);
+
+    void flushChanges();
+
+Q_SIGNALS:
+    void aliasesChanged(const Tp::AliasPairList &aliases);
+
+public:
+    BaseConnectionAliasingInterface *mInterface;
+};
+
+class TP_QT_NO_EXPORT BaseConnectionAvatarsInterface::Adaptee : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList supportedAvatarMIMETypes READ supportedAvatarMIMETypes)
+    Q_PROPERTY(uint minimumAvatarHeight READ minimumAvatarHeight)
+    Q_PROPERTY(uint minimumAvatarWidth READ minimumAvatarWidth)
+    Q_PROPERTY(uint recommendedAvatarHeight READ recommendedAvatarHeight)
+    Q_PROPERTY(uint recommendedAvatarWidth READ recommendedAvatarWidth)
+    Q_PROPERTY(uint maximumAvatarHeight READ maximumAvatarHeight)
+    Q_PROPERTY(uint maximumAvatarWidth READ maximumAvatarWidth)
+    Q_PROPERTY(uint maximumAvatarBytes READ maximumAvatarBytes)
+
+public:
+    Adaptee(BaseConnectionAvatarsInterface *interface);
+    ~Adaptee();
+
+    QStringList supportedAvatarMIMETypes() const;
+    uint minimumAvatarHeight() const;
+    uint minimumAvatarWidth() const;
+    uint recommendedAvatarHeight() const;
+    uint recommendedAvatarWidth() const;
+    uint maximumAvatarHeight() const;
+    uint maximumAvatarWidth() const;
+    uint maximumAvatarBytes() const;
+
+private Q_SLOTS:
+    void getAvatarRequirements(
+            const Tp::Service::ConnectionInterfaceAvatarsAdaptor::GetAvatarRequirementsContextPtr &context);
+    void getKnownAvatarTokens(const Tp::UIntList &contacts,
+            const Tp::Service::ConnectionInterfaceAvatarsAdaptor::GetKnownAvatarTokensContextPtr &context);
+
+    void flushChanges();
+
+Q_SIGNALS:
+    void avatarUpdated(uint contact, const QString &newAvatarToken);
+
+public:
+    BaseConnectionAvatarsInterface *mInterface;
+};
+
 }
@@ -32,12 +32,230 @@
 #include <TelepathyQt/DBusObject>
 #include <TelepathyQt/Utils>
 
+#include <QHash>
+#include <QPair>
+#include <QSet>
 #include <QString>
+#include <QStringList>
+#include <QTimer>
 #include <QVariantMap>
+#include <QVector>
 
 namespace Tp
 {
 
+namespace
+{
+
+// The handles of one type. Handles are immortal and handed out one after the other from 1, so
+// the identifier of a handle is found by index. Each identifier is stored once, the index from
+// identifiers to handles sharing its data with the table.
+class HandleRepository
+{
+public:
+    int size() const { return mIdentifiers.size(); }
+
+    bool isValid(uint handle) const
+    {
+        return handle > 0 && handle <= (uint) mIdentifiers.size();
+    }
+
+    QString identifier(uint handle) const
+    {
+        return isValid(handle) ? mIdentifiers.at(handle - 1) : QString();
+    }
+
+    uint handle(const QString &identifier) const
+    {
+        return mHandles.value(identifier);
+    }
+
+    uint ensureHandle(const QString &identifier)
+    {
+        uint &handle = mHandles[identifier];
+        if (!handle) {
+            mIdentifiers.append(identifier);
+            handle = mIdentifiers.size();
+        }
+        return handle;
+    }
+
+private:
+    QVector<QString> mIdentifiers;
+    QHash<QString, uint> mHandles;
+};
+
+// The contact attributes, as a table with a row per contact handle and a column per attribute
+// name. Every name is stored once whatever the number of contacts, and the maps built from the
+// table share it as their keys.
+class ContactAttributeStore
+{
+public:
+    void set(uint handle, const QString &name, const QVariant &value)
+    {
+        // an invalid value unsets the attribute, which never needs to grow the table
+        int column = mColumns.value(name, -1);
+        if (column < 0) {
+            if (!value.isValid()) {
+                return;
+            }
+            column = mNames.size();
+            mNames.append(name);
+            mInterfaces.append(name.left(name.lastIndexOf(QLatin1Char('/'))));
+            mColumns.insert(name, column);
+        }
+
+        if ((uint) mRows.size() < handle) {
+            if (!value.isValid()) {
+                return;
+            }
+            mRows.resize(handle);
+        }
+
+        QVector<QVariant> &row = mRows[handle - 1];
+        if (row.size() <= column) {
+            if (!value.isValid()) {
+                return;
+            }
+            row.resize(column + 1);
+        }
+        row[column] = value;
+    }
+
+    QVariant value(uint handle, const QString &name) const
+    {
+        int column = mColumns.value(name, -1);
+        if (column < 0 || handle == 0 || (uint) mRows.size() < handle) {
+            return QVariant();
+        }
+        return mRows.at(handle - 1).value(column);
+    }
+
+    QList<int> columns(const QSet<QString> &interfaces) const
+    {
+        QList<int> ret;
+        for (int i = 0; i < mInterfaces.size(); ++i) {
+            if (interfaces.contains(mInterfaces.at(i))) {
+                ret << i;
+            }
+        }
+        return ret;
+    }
+
+    void fill(uint handle, const QList<int> &columns, QVariantMap &attributes) const
+    {
+        if (handle == 0 || (uint) mRows.size() < handle) {
+            return;
+        }
+
+        const QVector<QVariant> &row = mRows.at(handle - 1);
+        foreach (int column, columns) {
+            if (column < row.size() && row.at(column).isValid()) {
+                attributes.insert(mNames.at(column), row.at(column));
+            }
+        }
+    }
+
+private:
+    QStringList mNames;
+    QStringList mInterfaces;
+    QHash<QString, int> mColumns;
+    QVector<QVector<QVariant> > mRows;
+};
+
+// How long changes to contacts are collected by default before being announced, in milliseconds
+const int defaultEmissionWindow = 100;
+
+// Changes to contacts waiting to be announced on the bus. A change replaces the pending change to
+// the same contact if there is one, and the contacts keep the order of their first change. All the
+// changes are announced together once the emission window after the first of them has elapsed,
+// which bounds the delay of every change to one window.
+template<typename T>
+class PendingContactChanges
+{
+public:
+    typedef QPair<uint, T> Change;
+
+    PendingContactChanges(QObject *receiver, const char *flushSlot)
+        : mTimer(new QTimer(receiver))
+    {
+        mTimer->setSingleShot(true);
+        mTimer->setInterval(defaultEmissionWindow);
+        QObject::connect(mTimer, SIGNAL(timeout()), receiver, flushSlot);
+    }
+
+    int window() const { return mTimer->interval(); }
+    void setWindow(int msec) { mTimer->setInterval(msec); }
+    ContactChangeStats stats() const { return mStats; }
+
+    void add(uint handle, const T &value)
+    {
+        ++mStats.updates;
+
+        QHash<uint, int>::const_iterator i = mIndex.constFind(handle);
+        if (i != mIndex.constEnd()) {
+            mChanges[i.value()].second = value;
+            ++mStats.mergedUpdates;
+            return;
+        }
+
+        mIndex.insert(handle, mChanges.size());
+        mChanges.append(Change(handle, value));
+        if (!mTimer->isActive()) {
+            mTimer->start();
+        }
+    }
+
+    QList<Change> take()
+    {
+        QList<Change> ret = mChanges;
+        mChanges.clear();
+        mIndex.clear();
+        if (!ret.isEmpty()) {
+            ++mStats.batches;
+        }
+        return ret;
+    }
+
+private:
+    QTimer *mTimer;
+    QList<Change> mChanges;
+    QHash<uint, int> mIndex;
+    ContactChangeStats mStats;
+};
+
+typedef PendingContactChanges<SimplePresence> PendingPresences;
+typedef PendingContactChanges<QString> PendingStrings;
+
+QString contactIdAttribute()
+{
+    static const QString name = TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id");
+    return name;
+}
+
+QString presenceAttribute()
+{
+    static const QString name = TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE +
+        QLatin1String("/presence");
+    return name;
+}
+
+QString aliasAttribute()
+{
+    static const QString name = TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING +
+        QLatin1String("/alias");
+    return name;
+}
+
+QString avatarTokenAttribute()
+{
+    static const QString name = TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS +
+        QLatin1String("/token");
+    return name;
+}
+
+}
+
 struct TP_QT_NO_EXPORT BaseConnection::Private
 {
     Private(BaseConnection *parent, const QDBusConnection &dbusConnection,
@@ -47,16 +265,44 @@ struct TP_QT_NO_EXPORT BaseConnection::Private
           cmName(cmName),
           protocolName(protocolName),
           parameters(parameters),
+          selfHandle(0),
           adaptee(new BaseConnection::Adaptee(dbusConnection, parent))
     {
     }
 
+    HandleRepository *handles(HandleType handleType)
+    {
+        switch (handleType) {
+        case HandleTypeContact:
+            return &contactHandles;
+        case HandleTypeRoom:
+            return &roomHandles;
+        default:
+            return 0;
+        }
+    }
+
+    const HandleRepository *handles(HandleType handleType) const
+    {
+        return const_cast<Private *>(this)->handles(handleType);
+    }
+
     BaseConnection *parent;
     QString cmName;
     QString protocolName;
     QVariantMap parameters;
+    uint selfHandle;
+
+    NormalizeContactCallback normalizeContactCb;
+    HandleRepository contactHandles;
+    HandleRepository roomHandles;
+
+    QStringList contactAttributeInterfaces;
+    ContactAttributeStore contactAttributes;
 
     BaseConnection::Adaptee *adaptee;
+
+    QHash<QString, AbstractConnectionInterfacePtr> interfaces;
 };
 
 BaseConnection::Adaptee::Adaptee(const QDBusConnection &dbusConnection,
@@ -65,18 +311,114 @@ BaseConnection::Adaptee::Adaptee(const QDBusConnection &dbusConnection,
       mConnection(connection)
 {
     mAdaptor = new Service::ConnectionAdaptor(dbusConnection, this, connection->dbusObject());
+    connect(connection, SIGNAL(selfHandleChanged(uint)), SIGNAL(selfHandleChanged(uint)));
 }
 
 BaseConnection::Adaptee::~Adaptee()
 {
 }
 
+QStringList BaseConnection::Adaptee::interfaces() const
+{
+    QStringList ret;
+    foreach (const AbstractConnectionInterfacePtr &iface, mConnection->interfaces()) {
+        ret << iface->interfaceName();
+    }
+    return ret;
+}
+
+uint BaseConnection::Adaptee::selfHandle() const
+{
+    return mConnection->selfHandle();
+}
+
+bool BaseConnection::Adaptee::hasImmortalHandles() const
+{
+    return true;
+}
+
+void BaseConnection::Adaptee::getInterfaces(
+        const Tp::Service::ConnectionAdaptor::GetInterfacesContextPtr &context)
+{
+    context->setFinished(interfaces());
+}
+
+void BaseConnection::Adaptee::getProtocol(
+        const Tp::Service::ConnectionAdaptor::GetProtocolContextPtr &context)
+{
+    context->setFinished(mConnection->protocolName());
+}
+
+void BaseConnection::Adaptee::getSelfHandle(
+        const Tp::Service::ConnectionAdaptor::GetSelfHandleContextPtr &context)
+{
+    context->setFinished(selfHandle());
+}
+
+void BaseConnection::Adaptee::holdHandles(uint handleType, const Tp::UIntList &handles,
+        const Tp::Service::ConnectionAdaptor::HoldHandlesContextPtr &context)
+{
+    // handles are immortal, so there is nothing to hold, but invalid handles are still an error
+    DBusError error;
+    if (!mConnection->checkHandles((HandleType) handleType, handles, &error)) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished();
+}
+
+void BaseConnection::Adaptee::inspectHandles(uint handleType, const Tp::UIntList &handles,
+        const Tp::Service::ConnectionAdaptor::InspectHandlesContextPtr &context)
+{
+    DBusError error;
+    QStringList identifiers = mConnection->inspectHandles((HandleType) handleType, handles,
+            &error);
+    if (error.isValid()) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished(identifiers);
+}
+
+void BaseConnection::Adaptee::releaseHandles(uint handleType, const Tp::UIntList &handles,
+        const Tp::Service::ConnectionAdaptor::ReleaseHandlesContextPtr &context)
+{
+    DBusError error;
+    if (!mConnection->checkHandles((HandleType) handleType, handles, &error)) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished();
+}
+
+void BaseConnection::Adaptee::requestHandles(uint handleType, const QStringList &identifiers,
+        const Tp::Service::ConnectionAdaptor::RequestHandlesContextPtr &context)
+{
+    DBusError error;
+    UIntList handles = mConnection->ensureHandles((HandleType) handleType, identifiers, &error);
+    if (error.isValid()) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished(handles);
+}
+
 /**
  * \class BaseConnection
  * \ingroup serviceconn
  * \headerfile TelepathyQt/base-connection.h <TelepathyQt/BaseConnection>
  *
  * \brief Base class for Connection implementations.
+ *
+ * A BaseConnection implements the org.freedesktop.Telepathy.Connection interface,
+ * and any other interface is plugged into it with plugInterface() before it is
+ * registered on the bus with registerObject().
+ *
+ * The connection keeps the handles of contacts and rooms itself, see ensureHandles().
+ * Handles are immortal: once given to an identifier, a handle stays valid for as long as
+ * the connection exists. The connection also stores the attributes of the contacts set
+ * with setContactAttributes(), from which BaseConnectionContactsInterface answers the
+ * requests of clients.
  */
 
 /**
@@ -143,8 +485,11 @@ QVariantMap BaseConnection::parameters() const
  */
 QVariantMap BaseConnection::immutableProperties() const
 {
-    // FIXME
-    return QVariantMap();
+    QVariantMap ret;
+    foreach (const AbstractConnectionInterfacePtr &iface, mPriv->interfaces) {
+        ret.unite(iface->immutableProperties());
+    }
+    return ret;
 }
 
 /**
@@ -175,21 +520,21 @@ bool BaseConnection::registerObject(DBusError *error)
         return true;
     }
 
-    if (checkValidProtocolName(mPriv->protocolName)) {
+    if (!checkValidProtocolName(mPriv->protocolName)) {
         if (error) {
             error->set(TP_QT_ERROR_INVALID_ARGUMENT,
-                mPriv->protocolName + QLatin1String("is not a valid protocol name"));
+                mPriv->protocolName + QLatin1String(" is not a valid protocol name"));
         }
-        debug() << "Unable to register connection - invalid protocol name";
+        tpDebug() << "Unable to register connection - invalid protocol name";
         return false;
     }
 
     QString escapedProtocolName = mPriv->protocolName;
     escapedProtocolName.replace(QLatin1Char('-'), QLatin1Char('_'));
     QString name = uniqueName();
-    QString busName = QString(QLatin1String("%1.%2.%3.%4"))
+    QString busName = QString(QLatin1String("%1%2.%3.%4"))
         .arg(TP_QT_CONNECTION_BUS_NAME_BASE, mPriv->cmName, escapedProtocolName, name);
-    QString objectPath = QString(QLatin1String("%1/%2/%3/%4"))
+    QString objectPath = QString(QLatin1String("%1%2/%3/%4"))
         .arg(TP_QT_CONNECTION_OBJECT_PATH_BASE, mPriv->cmName, escapedProtocolName, name);
     DBusError _error;
     bool ret = registerObject(busName, objectPath, &_error);
@@ -205,13 +550,1475 @@ bool BaseConnection::registerObject(DBusError *error)
 bool BaseConnection::registerObject(const QString &busName,
         const QString &objectPath, DBusError *error)
 {
+    if (isRegistered()) {
+        return true;
+    }
+
+    foreach (const AbstractConnectionInterfacePtr &iface, mPriv->interfaces) {
+        if (!iface->registerInterface(dbusObject())) {
+            // lets not fail if an optional interface fails registering, lets warn only
+            warning() << "Unable to register interface" << iface->interfaceName() <<
+                "for connection" << objectPath;
+        }
+    }
     return DBusService::registerObject(busName, objectPath, error);
 }
 
 /**
- * \fn void BaseConnection::disconnected()
+ * Return the handle of the contact the user is on this connection.
  *
- * Emitted when this connection has been disconnected.
+ * \return The handle of the user, or 0 if it is not known yet.
+ * \sa setSelfHandle()
+ */
+uint BaseConnection::selfHandle() const
+{
+    return mPriv->selfHandle;
+}
+
+/**
+ * Set the handle of the contact the user is on this connection.
+ *
+ * This emits selfHandleChanged() and the SelfHandleChanged signal on the bus
+ * if the handle changes.
+ *
+ * \param selfHandle A contact handle, as returned by ensureHandles().
+ * \sa selfHandle()
+ */
+void BaseConnection::setSelfHandle(uint selfHandle)
+{
+    if (mPriv->selfHandle == selfHandle) {
+        return;
+    }
+
+    mPriv->selfHandle = selfHandle;
+    emit selfHandleChanged(selfHandle);
+}
+
+/**
+ * Set a callback that will be called to normalize contact identifiers before
+ * handles are given to them.
+ *
+ * A connection created by BaseProtocol::createConnection() which has no such
+ * callback uses the one of the protocol, set with
+ * BaseProtocol::setNormalizeContactCallback(). Without any callback, the contact
+ * identifiers are used as they are.
+ *
+ * The callback is expected to return identifiers which are already normalized
+ * unchanged, so that it is not called again for them.
+ *
+ * \param cb The callback to set.
+ * \sa ensureHandles()
+ */
+void BaseConnection::setNormalizeContactCallback(const NormalizeContactCallback &cb)
+{
+    mPriv->normalizeContactCb = cb;
+}
+
+void BaseConnection::setDefaultNormalizeContactCallback(const NormalizeContactCallback &cb)
+{
+    if (!mPriv->normalizeContactCb.isValid()) {
+        mPriv->normalizeContactCb = cb;
+    }
+}
+
+/**
+ * Return the handles of the given identifiers, creating the ones which do not exist yet.
+ *
+ * This is how the RequestHandles method on the bus is answered. Contact identifiers
+ * are normalized with the callback set with setNormalizeContactCallback(), which is
+ * called once per distinct identifier that has no handle already. Room identifiers
+ * are used as they are.
+ *
+ * \param handleType The type of the handles, either HandleTypeContact or HandleTypeRoom.
+ * \param identifiers The identifiers of the entities.
+ * \param error A pointer to a DBusError instance where any possible error
+ * will be stored.
+ * \return The handles, in the order of \a identifiers, or an empty list
+ * if any of the identifiers is invalid, in which case \a error will contain an
+ * appropriate error.
+ * \sa inspectHandles()
+ */
+UIntList BaseConnection::ensureHandles(HandleType handleType, const QStringList &identifiers,
+        DBusError *error)
+{
+    HandleRepository *repository = mPriv->handles(handleType);
+    if (!repository) {
+        error->set(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Unsupported handle type"));
+        return UIntList();
+    }
+
+    bool normalize = handleType == HandleTypeContact && mPriv->normalizeContactCb.isValid();
+    // identifiers which have been normalized already in this call
+    QHash<QString, uint> normalized;
+    UIntList ret;
+    ret.reserve(identifiers.size());
+    foreach (const QString &identifier, identifiers) {
+        uint handle = repository->handle(identifier);
+        if (!handle && normalize) {
+            handle = normalized.value(identifier);
+        }
+
+        if (!handle) {
+            QString id = identifier;
+            if (normalize) {
+                id = mPriv->normalizeContactCb(identifier, error);
+                if (error->isValid()) {
+                    return UIntList();
+                }
+            }
+
+            if (id.isEmpty()) {
+                error->set(TP_QT_ERROR_INVALID_HANDLE,
+                        QString(QLatin1String("Invalid identifier \"%1\"")).arg(identifier));
+                return UIntList();
+            }
+
+            handle = repository->ensureHandle(id);
+            if (normalize) {
+                normalized.insert(identifier, handle);
+            }
+        }
+
+        ret << handle;
+    }
+    return ret;
+}
+
+/**
+ * Return the handle of the given identifier, creating it if it does not exist yet.
+ *
+ * This is a convenience method calling ensureHandles() with a single identifier.
+ *
+ * \param handleType The type of the handle, either HandleTypeContact or HandleTypeRoom.
+ * \param identifier The identifier of the entity.
+ * \param error A pointer to a DBusError instance where any possible error
+ * will be stored.
+ * \return The handle, or 0 if \a identifier is invalid, in which case \a error
+ * will contain an appropriate error.
+ */
+uint BaseConnection::ensureHandle(HandleType handleType, const QString &identifier,
+        DBusError *error)
+{
+    UIntList handles = ensureHandles(handleType, QStringList() << identifier, error);
+    return handles.isEmpty() ? 0 : handles.first();
+}
+
+/**
+ * Return the identifiers of the given handles.
+ *
+ * This is how the InspectHandles method on the bus is answered.
+ *
+ * \param handleType The type of the handles, either HandleTypeContact or HandleTypeRoom.
+ * \param handles The handles to inspect.
+ * \param error A pointer to a DBusError instance where any possible error
+ * will be stored.
+ * \return The normalized identifiers, in the order of \a handles, or an empty list
+ * if any of the handles is invalid, in which case \a error will contain an
+ * appropriate error.
+ * \sa ensureHandles()
+ */
+QStringList BaseConnection::inspectHandles(HandleType handleType, const UIntList &handles,
+        DBusError *error) const
+{
+    if (!checkHandles(handleType, handles, error)) {
+        return QStringList();
+    }
+
+    const HandleRepository *repository = mPriv->handles(handleType);
+    QStringList ret;
+    ret.reserve(handles.size());
+    foreach (uint handle, handles) {
+        ret << repository->identifier(handle);
+    }
+    return ret;
+}
+
+/**
+ * Check that all the given handles are valid.
+ *
+ * \param handleType The type of the handles, either HandleTypeContact or HandleTypeRoom.
+ * \param handles The handles to check.
+ * \param error A pointer to a DBusError instance where any possible error
+ * will be stored.
+ * \return \c true if all the handles are valid, \c false otherwise, in which case
+ * \a error will contain an appropriate error.
+ */
+bool BaseConnection::checkHandles(HandleType handleType, const UIntList &handles,
+        DBusError *error) const
+{
+    const HandleRepository *repository = mPriv->handles(handleType);
+    if (!repository) {
+        error->set(TP_QT_ERROR_INVALID_ARGUMENT, QLatin1String("Unsupported handle type"));
+        return false;
+    }
+
+    foreach (uint handle, handles) {
+        if (!repository->isValid(handle)) {
+            error->set(TP_QT_ERROR_INVALID_HANDLE,
+                    QString(QLatin1String("Invalid handle %1")).arg(handle));
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Return the D-Bus interfaces whose contact attributes can be requested from this
+ * connection.
+ *
+ * \return The list of interface names.
+ * \sa setContactAttributeInterfaces()
+ */
+QStringList BaseConnection::contactAttributeInterfaces() const
+{
+    return mPriv->contactAttributeInterfaces;
+}
+
+/**
+ * Set the D-Bus interfaces whose contact attributes can be requested from this
+ * connection, as published by the ContactAttributeInterfaces property of
+ * BaseConnectionContactsInterface.
+ *
+ * This property cannot change after this connection object has been registered
+ * on the bus with registerObject().
+ *
+ * \param contactAttributeInterfaces The list of interface names.
+ * \sa contactAttributeInterfaces()
+ */
+void BaseConnection::setContactAttributeInterfaces(const QStringList &contactAttributeInterfaces)
+{
+    if (isRegistered()) {
+        warning() << "BaseConnection::setContactAttributeInterfaces: cannot change property "
+            "after registration";
+        return;
+    }
+    mPriv->contactAttributeInterfaces = contactAttributeInterfaces;
+}
+
+/**
+ * Return an attribute of a contact.
+ *
+ * \param handle The handle of the contact.
+ * \param name The full name of the attribute, ex.
+ * <tt>org.freedesktop.Telepathy.Connection.Interface.Aliasing/alias</tt>.
+ * \return The value of the attribute, or an invalid QVariant if it has not been set.
+ * \sa setContactAttribute()
+ */
+QVariant BaseConnection::contactAttribute(uint handle, const QString &name) const
+{
+    return mPriv->contactAttributes.value(handle, name);
+}
+
+/**
+ * Set an attribute of a contact.
+ *
+ * \param handle The handle of the contact.
+ * \param name The full name of the attribute, made of the name of the interface it
+ * belongs to and the attribute name, ex.
+ * <tt>org.freedesktop.Telepathy.Connection.Interface.SimplePresence/presence</tt>.
+ * \param value The value of the attribute, or an invalid QVariant to unset it.
+ * \return \c true if the attribute has been set, \c false if \a handle or
+ * \a name is invalid.
+ * \sa setContactAttributes(), contactAttributes()
+ */
+bool BaseConnection::setContactAttribute(uint handle, const QString &name,
+        const QVariant &value)
+{
+    if (!mPriv->contactHandles.isValid(handle)) {
+        warning() << "BaseConnection::setContactAttribute: invalid handle" << handle;
+        return false;
+    }
+
+    if (!name.contains(QLatin1Char('/'))) {
+        warning() << "BaseConnection::setContactAttribute: invalid attribute name" << name;
+        return false;
+    }
+
+    mPriv->contactAttributes.set(handle, name, value);
+    return true;
+}
+
+/**
+ * Set a number of attributes of a contact.
+ *
+ * \param handle The handle of the contact.
+ * \param attributes A map from the full names of the attributes to their values.
+ * \sa setContactAttribute(), contactAttributes()
+ */
+void BaseConnection::setContactAttributes(uint handle, const QVariantMap &attributes)
+{
+    for (QVariantMap::const_iterator i = attributes.constBegin();
+            i != attributes.constEnd(); ++i) {
+        setContactAttribute(handle, i.key(), i.value());
+    }
+}
+
+/**
+ * Return the attributes of the given contacts.
+ *
+ * This is how the GetContactAttributes method on the bus is answered, from the
+ * attributes set with setContactAttributes() and without calling back into the
+ * connection implementation.
+ *
+ * \param handles The handles of the contacts. Invalid handles are left out of the result.
+ * \param interfaces The interfaces whose attributes are requested. The attributes
+ * of the Connection interface, including the contact identifier, are always returned.
+ * \return A map from the contact handles to their attributes.
+ * \sa setContactAttributes()
  */
+ContactAttributesMap BaseConnection::contactAttributes(const UIntList &handles,
+        const QStringList &interfaces) const
+{
+    QSet<QString> requested = interfaces.toSet();
+    requested.insert(TP_QT_IFACE_CONNECTION);
+    // the attributes to return are the same for every contact
+    QList<int> columns = mPriv->contactAttributes.columns(requested);
+
+    ContactAttributesMap ret;
+    foreach (uint handle, handles) {
+        if (!mPriv->contactHandles.isValid(handle) || ret.contains(handle)) {
+            continue;
+        }
+
+        QVariantMap attributes;
+        attributes.insert(contactIdAttribute(), mPriv->contactHandles.identifier(handle));
+        mPriv->contactAttributes.fill(handle, columns, attributes);
+        ret.insert(handle, attributes);
+    }
+    return ret;
+}
+
+/**
+ * Return a list of interfaces that have been plugged into this Connection
+ * D-Bus object with plugInterface().
+ *
+ * \return A list containing all the Connection interface implementation objects.
+ * \sa plugInterface(), interface()
+ */
+QList<AbstractConnectionInterfacePtr> BaseConnection::interfaces() const
+{
+    return mPriv->interfaces.values();
+}
+
+/**
+ * Return a pointer to the interface with the given name.
+ *
+ * \param interfaceName The D-Bus name of the interface,
+ * ex. TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS.
+ * \return A pointer to the AbstractConnectionInterface object that implements
+ * the D-Bus interface with the given name, or a null pointer if such an interface
+ * has not been plugged into this object.
+ * \sa plugInterface(), interfaces()
+ */
+AbstractConnectionInterfacePtr BaseConnection::interface(const QString &interfaceName) const
+{
+    return mPriv->interfaces.value(interfaceName);
+}
+
+/**
+ * Plug a new interface into this Connection D-Bus object.
+ *
+ * This property is immutable and cannot change after this Connection
+ * object has been registered on the bus with registerObject().
+ *
+ * \param interface An AbstractConnectionInterface instance that implements
+ * the interface that is to be plugged.
+ * \return \c true on success or \c false otherwise
+ * \sa interfaces(), interface()
+ */
+bool BaseConnection::plugInterface(const AbstractConnectionInterfacePtr &interface)
+{
+    if (isRegistered()) {
+        warning() << "Unable to plug connection interface " << interface->interfaceName() <<
+            "- connection already registered";
+        return false;
+    }
+
+    if (interface->isRegistered()) {
+        warning() << "Unable to plug connection interface" << interface->interfaceName() <<
+            "- interface already registered";
+        return false;
+    }
+
+    if (mPriv->interfaces.contains(interface->interfaceName())) {
+        warning() << "Unable to plug connection interface" << interface->interfaceName() <<
+            "- another interface with same name already plugged";
+        return false;
+    }
+
+    tpDebug() << "Interface" << interface->interfaceName() << "plugged";
+    interface->mPriv->connection = this;
+    mPriv->interfaces.insert(interface->interfaceName(), interface);
+    return true;
+}
+
+/**
+ * \fn void BaseConnection::disconnected()
+ *
+ * Emitted when this connection has been disconnected.
+ */
+
+/**
+ * \fn void BaseConnection::selfHandleChanged(uint selfHandle)
+ *
+ * Emitted when the handle of the user has been changed with setSelfHandle().
+ *
+ * \param selfHandle The new handle of the user.
+ */
+
+/**
+ * \class AbstractConnectionInterface
+ * \ingroup serviceconn
+ * \headerfile TelepathyQt/base-connection.h <TelepathyQt/AbstractConnectionInterface>
+ *
+ * \brief Base class for all the Connection object interface implementations.
+ */
+
+struct TP_QT_NO_EXPORT AbstractConnectionInterface::Private
+{
+    Private()
+        : connection(0)
+    {
+    }
+
+    BaseConnection *connection;
+};
+
+// AbstractConnectionInterface
+AbstractConnectionInterface::AbstractConnectionInterface(const QString &interfaceName)
+    : AbstractDBusServiceInterface(interfaceName),
+      mPriv(new Private)
+{
+}
+
+AbstractConnectionInterface::~AbstractConnectionInterface()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the connection this interface has been plugged into.
+ *
+ * \return A pointer to the BaseConnection, or 0 if this interface has not been
+ * plugged with BaseConnection::plugInterface() yet.
+ */
+BaseConnection *AbstractConnectionInterface::connection() const
+{
+    return mPriv->connection;
+}
+
+// Conn.I.Contacts
+BaseConnectionContactsInterface::Adaptee::Adaptee(BaseConnectionContactsInterface *interface)
+    : QObject(interface),
+      mInterface(interface)
+{
+}
+
+BaseConnectionContactsInterface::Adaptee::~Adaptee()
+{
+}
+
+QStringList BaseConnectionContactsInterface::Adaptee::contactAttributeInterfaces() const
+{
+    return mInterface->connection()->contactAttributeInterfaces();
+}
+
+void BaseConnectionContactsInterface::Adaptee::getContactAttributes(const Tp::UIntList &handles,
+        const QStringList &interfaces, bool hold,
+        const Tp::Service::ConnectionInterfaceContactsAdaptor::GetContactAttributesContextPtr &context)
+{
+    // handles are immortal, so holding them has no effect
+    Q_UNUSED(hold);
+    context->setFinished(mInterface->connection()->contactAttributes(handles, interfaces));
+}
+
+struct TP_QT_NO_EXPORT BaseConnectionContactsInterface::Private
+{
+    Private(BaseConnectionContactsInterface *parent)
+        : adaptee(new BaseConnectionContactsInterface::Adaptee(parent))
+    {
+    }
+
+    BaseConnectionContactsInterface::Adaptee *adaptee;
+};
+
+/**
+ * \class BaseConnectionContactsInterface
+ * \ingroup serviceconn
+ * \headerfile TelepathyQt/base-connection.h <TelepathyQt/BaseConnectionContactsInterface>
+ *
+ * \brief Base class for implementations of Connection.Interface.Contacts
+ *
+ * The contact attributes are the ones stored on the connection this interface is
+ * plugged into, see BaseConnection::setContactAttributes() and
+ * BaseConnection::setContactAttributeInterfaces().
+ */
+
+/**
+ * Class constructor.
+ */
+BaseConnectionContactsInterface::BaseConnectionContactsInterface()
+    : AbstractConnectionInterface(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS),
+      mPriv(new Private(this))
+{
+}
+
+/**
+ * Class destructor.
+ */
+BaseConnectionContactsInterface::~BaseConnectionContactsInterface()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the immutable properties of this interface.
+ *
+ * Immutable properties cannot change after the interface has been registered
+ * on a service on the bus with registerInterface().
+ *
+ * \return The immutable properties of this interface.
+ */
+QVariantMap BaseConnectionContactsInterface::immutableProperties() const
+{
+    QVariantMap map;
+    if (connection()) {
+        map.insert(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS +
+                    QLatin1String(".ContactAttributeInterfaces"),
+                QVariant::fromValue(mPriv->adaptee->contactAttributeInterfaces()));
+    }
+    return map;
+}
+
+void BaseConnectionContactsInterface::createAdaptor()
+{
+    (void) new Service::ConnectionInterfaceContactsAdaptor(dbusObject()->dbusConnection(),
+            mPriv->adaptee, dbusObject());
+}
+
+/**
+ * \struct ContactChangeStats
+ * \ingroup serviceconn
+ * \headerfile TelepathyQt/base-connection.h <TelepathyQt/BaseConnection>
+ *
+ * \brief Counters of the changes to contacts announced by a connection interface.
+ *
+ * BaseConnectionSimplePresenceInterface, BaseConnectionAliasingInterface and
+ * BaseConnectionAvatarsInterface collect the changes to contacts for an emission
+ * window and announce them together, keeping only the latest change to each contact.
+ * These counters tell how much this saves.
+ */
+
+/**
+ * \var uint ContactChangeStats::updates
+ * The number of changes to contacts handed to the interface.
+ */
+
+/**
+ * \var uint ContactChangeStats::mergedUpdates
+ * The number of changes which replaced a pending change to the same contact, and so
+ * were never announced on their own.
+ */
+
+/**
+ * \var uint ContactChangeStats::batches
+ * The number of times the pending changes have been announced.
+ */
+
+// Conn.I.SimplePresence
+struct TP_QT_NO_EXPORT BaseConnectionSimplePresenceInterface::Private
+{
+    Private(BaseConnectionSimplePresenceInterface *parent)
+        : maximumStatusMessageLength(0),
+          adaptee(new BaseConnectionSimplePresenceInterface::Adaptee(parent)),
+          changes(adaptee, SLOT(flushChanges()))
+    {
+    }
+
+    PresenceSpecList statuses;
+    uint maximumStatusMessageLength;
+    SetPresenceCallback setPresenceCb;
+    BaseConnectionSimplePresenceInterface::Adaptee *adaptee;
+    PendingPresences changes;
+};
+
+BaseConnectionSimplePresenceInterface::Adaptee::Adaptee(
+        BaseConnectionSimplePresenceInterface *interface)
+    : QObject(interface),
+      mInterface(interface)
+{
+}
+
+BaseConnectionSimplePresenceInterface::Adaptee::~Adaptee()
+{
+}
+
+SimpleStatusSpecMap BaseConnectionSimplePresenceInterface::Adaptee::statuses() const
+{
+    return mInterface->statuses().bareSpecs();
+}
+
+uint BaseConnectionSimplePresenceInterface::Adaptee::maximumStatusMessageLength() const
+{
+    return mInterface->maximumStatusMessageLength();
+}
+
+void BaseConnectionSimplePresenceInterface::Adaptee::setPresence(const QString &status,
+        const QString &statusMessage,
+        const Tp::Service::ConnectionInterfaceSimplePresenceAdaptor::SetPresenceContextPtr &context)
+{
+    DBusError error;
+    mInterface->setPresence(status, statusMessage, &error);
+    if (error.isValid()) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished();
+}
+
+void BaseConnectionSimplePresenceInterface::Adaptee::getPresences(const Tp::UIntList &contacts,
+        const Tp::Service::ConnectionInterfaceSimplePresenceAdaptor::GetPresencesContextPtr &context)
+{
+    DBusError error;
+    if (!mInterface->connection()->checkHandles(HandleTypeContact, contacts, &error)) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished(mInterface->presences(contacts));
+}
+
+void BaseConnectionSimplePresenceInterface::Adaptee::flushChanges()
+{
+    SimpleContactPresences presences;
+    foreach (const PendingPresences::Change &change, mInterface->mPriv->changes.take()) {
+        presences.insert(change.first, change.second);
+    }
+
+    if (!presences.isEmpty()) {
+        emit presencesChanged(presences);
+    }
+}
+
+/**
+ * \class BaseConnectionSimplePresenceInterface
+ * \ingroup serviceconn
+ * \headerfile TelepathyQt/base-connection.h <TelepathyQt/BaseConnectionSimplePresenceInterface>
+ *
+ * \brief Base class for implementations of Connection.Interface.SimplePresence
+ *
+ * The presences of the contacts are kept as contact attributes of the connection this
+ * interface is plugged into. They are changed with updatePresences(), which announces
+ * the changes with a single PresencesChanged signal per emission window, see
+ * setEmissionWindow().
+ */
+
+/**
+ * Class constructor.
+ */
+BaseConnectionSimplePresenceInterface::BaseConnectionSimplePresenceInterface()
+    : AbstractConnectionInterface(TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE),
+      mPriv(new Private(this))
+{
+}
+
+/**
+ * Class destructor.
+ */
+BaseConnectionSimplePresenceInterface::~BaseConnectionSimplePresenceInterface()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the immutable properties of this interface.
+ *
+ * Immutable properties cannot change after the interface has been registered
+ * on a service on the bus with registerInterface().
+ *
+ * \return The immutable properties of this interface.
+ */
+QVariantMap BaseConnectionSimplePresenceInterface::immutableProperties() const
+{
+    QVariantMap map;
+    map.insert(TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE + QLatin1String(".Statuses"),
+            QVariant::fromValue(mPriv->adaptee->statuses()));
+    map.insert(TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE +
+                QLatin1String(".MaximumStatusMessageLength"),
+            QVariant::fromValue(mPriv->adaptee->maximumStatusMessageLength()));
+    return map;
+}
+
+/**
+ * Return the list of presence statuses that have been set with setStatuses().
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on an object on the bus with registerInterface().
+ *
+ * \return The list of presence statuses that have been set with setStatuses().
+ * \sa setStatuses()
+ */
+PresenceSpecList BaseConnectionSimplePresenceInterface::statuses() const
+{
+    return mPriv->statuses;
+}
+
+/**
+ * Set the list of statuses that contacts, and the user, can have on this connection.
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on an object on the bus with registerInterface().
+ *
+ * \param statuses The statuses list to set.
+ * \sa statuses()
+ */
+void BaseConnectionSimplePresenceInterface::setStatuses(const PresenceSpecList &statuses)
+{
+    if (isRegistered()) {
+        warning() << "BaseConnectionSimplePresenceInterface::setStatuses: cannot change "
+            "property after registration, immutable property";
+        return;
+    }
+    mPriv->statuses = statuses;
+}
+
+/**
+ * Return the maximum length of the status message of the user.
+ *
+ * \return The maximum length in characters, or 0 if there is no limit.
+ * \sa setMaximumStatusMessageLength()
+ */
+uint BaseConnectionSimplePresenceInterface::maximumStatusMessageLength() const
+{
+    return mPriv->maximumStatusMessageLength;
+}
+
+/**
+ * Set the maximum length of the status message of the user.
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on an object on the bus with registerInterface().
+ *
+ * \param maximumStatusMessageLength The maximum length in characters, or 0 if there
+ * is no limit.
+ * \sa maximumStatusMessageLength()
+ */
+void BaseConnectionSimplePresenceInterface::setMaximumStatusMessageLength(
+        uint maximumStatusMessageLength)
+{
+    if (isRegistered()) {
+        warning() << "BaseConnectionSimplePresenceInterface::setMaximumStatusMessageLength: "
+            "cannot change property after registration, immutable property";
+        return;
+    }
+    mPriv->maximumStatusMessageLength = maximumStatusMessageLength;
+}
+
+/**
+ * Set a callback that will be called to change the presence of the user.
+ *
+ * \param cb The callback to set.
+ * \sa setPresence()
+ */
+void BaseConnectionSimplePresenceInterface::setSetPresenceCallback(
+        const SetPresenceCallback &cb)
+{
+    mPriv->setPresenceCb = cb;
+}
+
+/**
+ * Change the presence of the user by calling the callback that has been set with
+ * setSetPresenceCallback().
+ *
+ * This is how the SetPresence method on the bus is answered. The new presence of
+ * the user is to be announced with updatePresences(), like for any other contact.
+ *
+ * \param status The new status, one of statuses() which may be set on the user.
+ * \param statusMessage The new status message.
+ * \param error A pointer to a DBusError instance where any possible error
+ * will be stored.
+ */
+void BaseConnectionSimplePresenceInterface::setPresence(const QString &status,
+        const QString &statusMessage, DBusError *error)
+{
+    PresenceSpec spec = mPriv->statuses.toMap().value(status);
+    if (!spec.isValid() || !spec.maySetOnSelf()) {
+        error->set(TP_QT_ERROR_INVALID_ARGUMENT,
+                QString(QLatin1String("Status \"%1\" cannot be set")).arg(status));
+        return;
+    }
+
+    if (!mPriv->setPresenceCb.isValid()) {
+        error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
+        return;
+    }
+    mPriv->setPresenceCb(status, statusMessage, error);
+}
+
+/**
+ * Return the presences of the given contacts.
+ *
+ * \param contacts The handles of the contacts.
+ * \return The presences set with updatePresences(), with an unknown presence for the
+ * contacts whose presence has never been set.
+ */
+SimpleContactPresences BaseConnectionSimplePresenceInterface::presences(
+        const UIntList &contacts) const
+{
+    SimpleContactPresences ret;
+    if (!connection()) {
+        return ret;
+    }
+
+    foreach (uint contact, contacts) {
+        QVariant presence = connection()->contactAttribute(contact, presenceAttribute());
+        if (presence.isValid()) {
+            ret.insert(contact, qvariant_cast<SimplePresence>(presence));
+        } else {
+            SimplePresence unknown;
+            unknown.type = ConnectionPresenceTypeUnknown;
+            unknown.status = QLatin1String("unknown");
+            ret.insert(contact, unknown);
+        }
+    }
+    return ret;
+}
+
+/**
+ * Change the presences of contacts.
+ *
+ * The presences are stored as contact attributes of the connection straight away.
+ * The changes are announced with the PresencesChanged signal once the emission
+ * window has elapsed, along with the other changes made meanwhile, with only the
+ * latest presence of each contact.
+ *
+ * \param presences The new presences of the contacts.
+ * \sa presences(), setEmissionWindow()
+ */
+void BaseConnectionSimplePresenceInterface::updatePresences(
+        const SimpleContactPresences &presences)
+{
+    if (!connection()) {
+        warning() << "BaseConnectionSimplePresenceInterface::updatePresences: interface "
+            "not plugged into a connection";
+        return;
+    }
+
+    for (SimpleContactPresences::const_iterator i = presences.constBegin();
+            i != presences.constEnd(); ++i) {
+        if (connection()->setContactAttribute(i.key(), presenceAttribute(),
+                    QVariant::fromValue(i.value()))) {
+            mPriv->changes.add(i.key(), i.value());
+        }
+    }
+}
+
+/**
+ * Return for how long changes to presences are collected before being announced.
+ *
+ * \return The emission window in milliseconds.
+ * \sa setEmissionWindow()
+ */
+int BaseConnectionSimplePresenceInterface::emissionWindow() const
+{
+    return mPriv->changes.window();
+}
+
+/**
+ * Set for how long changes to presences are collected before being announced.
+ *
+ * The window starts with the first change which is not announced yet, so no change
+ * is delayed by more than one window. The default is 100 milliseconds, and 0 announces
+ * the changes as soon as control returns to the event loop.
+ *
+ * \param msec The emission window in milliseconds.
+ * \sa emissionWindow(), changeStats()
+ */
+void BaseConnectionSimplePresenceInterface::setEmissionWindow(int msec)
+{
+    mPriv->changes.setWindow(msec);
+}
+
+/**
+ * Return how many changes to presences have been made and how many of them have
+ * been merged.
+ *
+ * \return The counters of changes to presences.
+ * \sa setEmissionWindow()
+ */
+ContactChangeStats BaseConnectionSimplePresenceInterface::changeStats() const
+{
+    return mPriv->changes.stats();
+}
+
+void BaseConnectionSimplePresenceInterface::createAdaptor()
+{
+    (void) new Service::ConnectionInterfaceSimplePresenceAdaptor(
+            dbusObject()->dbusConnection(), mPriv->adaptee, dbusObject());
+}
+
+// Conn.I.Aliasing
+struct TP_QT_NO_EXPORT BaseConnectionAliasingInterface::Private
+{
+    Private(BaseConnectionAliasingInterface *parent)
+        : adaptee(new BaseConnectionAliasingInterface::Adaptee(parent)),
+          changes(adaptee, SLOT(flushChanges()))
+    {
+    }
+
+    ConnectionAliasFlags aliasFlags;
+    SetAliasesCallback setAliasesCb;
+    BaseConnectionAliasingInterface::Adaptee *adaptee;
+    PendingStrings changes;
+};
+
+BaseConnectionAliasingInterface::Adaptee::Adaptee(BaseConnectionAliasingInterface *interface)
+    : QObject(interface),
+      mInterface(interface)
+{
+}
+
+BaseConnectionAliasingInterface::Adaptee::~Adaptee()
+{
+}
+
+void BaseConnectionAliasingInterface::Adaptee::getAliasFlags(
+        const Tp::Service::ConnectionInterfaceAliasingAdaptor::GetAliasFlagsContextPtr &context)
+{
+    context->setFinished((uint) mInterface->aliasFlags());
+}
+
+void BaseConnectionAliasingInterface::Adaptee::requestAliases(const Tp::UIntList &contacts,
+        const Tp::Service::ConnectionInterfaceAliasingAdaptor::RequestAliasesContextPtr &context)
+{
+    DBusError error;
+    if (!mInterface->connection()->checkHandles(HandleTypeContact, contacts, &error)) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+
+    AliasMap aliases = mInterface->aliases(contacts);
+    QStringList ret;
+    foreach (uint contact, contacts) {
+        ret << aliases.value(contact);
+    }
+    context->setFinished(ret);
+}
+
+void BaseConnectionAliasingInterface::Adaptee::getAliases(const Tp::UIntList &contacts,
+        const Tp::Service::ConnectionInterfaceAliasingAdaptor::GetAliasesContextPtr &context)
+{
+    DBusError error;
+    if (!mInterface->connection()->checkHandles(HandleTypeContact, contacts, &error)) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished(mInterface->aliases(contacts));
+}
+
+void BaseConnectionAliasingInterface::Adaptee::setAliases(const Tp::AliasMap &aliases,
+        const Tp::Service::ConnectionInterfaceAliasingAdaptor::SetAliasesContextPtr &context)
+{
+    DBusError error;
+    mInterface->setAliases(aliases, &error);
+    if (error.isValid()) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished();
+}
+
+void BaseConnectionAliasingInterface::Adaptee::flushChanges()
+{
+    AliasPairList aliases;
+    foreach (const PendingStrings::Change &change, mInterface->mPriv->changes.take()) {
+        AliasPair pair;
+        pair.handle = change.first;
+        pair.alias = change.second;
+        aliases << pair;
+    }
+
+    if (!aliases.isEmpty()) {
+        emit aliasesChanged(aliases);
+    }
+}
+
+/**
+ * \class BaseConnectionAliasingInterface
+ * \ingroup serviceconn
+ * \headerfile TelepathyQt/base-connection.h <TelepathyQt/BaseConnectionAliasingInterface>
+ *
+ * \brief Base class for implementations of Connection.Interface.Aliasing
+ *
+ * The aliases of the contacts are kept as contact attributes of the connection this
+ * interface is plugged into. They are changed with updateAliases(), which announces
+ * the changes with a single AliasesChanged signal per emission window, see
+ * setEmissionWindow().
+ */
+
+/**
+ * Class constructor.
+ */
+BaseConnectionAliasingInterface::BaseConnectionAliasingInterface()
+    : AbstractConnectionInterface(TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING),
+      mPriv(new Private(this))
+{
+}
+
+/**
+ * Class destructor.
+ */
+BaseConnectionAliasingInterface::~BaseConnectionAliasingInterface()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the immutable properties of this interface.
+ *
+ * Immutable properties cannot change after the interface has been registered
+ * on a service on the bus with registerInterface().
+ *
+ * \return The immutable properties of this interface.
+ */
+QVariantMap BaseConnectionAliasingInterface::immutableProperties() const
+{
+    // Conn.I.Aliasing has no properties
+    return QVariantMap();
+}
+
+/**
+ * Return the flags describing how the aliases of this connection behave.
+ *
+ * \return The alias flags.
+ * \sa setAliasFlags()
+ */
+ConnectionAliasFlags BaseConnectionAliasingInterface::aliasFlags() const
+{
+    return mPriv->aliasFlags;
+}
+
+/**
+ * Set the flags describing how the aliases of this connection behave, as returned
+ * by the GetAliasFlags method on the bus.
+ *
+ * \param aliasFlags The alias flags.
+ * \sa aliasFlags()
+ */
+void BaseConnectionAliasingInterface::setAliasFlags(ConnectionAliasFlags aliasFlags)
+{
+    mPriv->aliasFlags = aliasFlags;
+}
+
+/**
+ * Set a callback that will be called to change the aliases of contacts, when
+ * this has been requested by a client.
+ *
+ * \param cb The callback to set.
+ * \sa setAliases()
+ */
+void BaseConnectionAliasingInterface::setSetAliasesCallback(const SetAliasesCallback &cb)
+{
+    mPriv->setAliasesCb = cb;
+}
+
+/**
+ * Change the aliases of contacts by calling the callback that has been set with
+ * setSetAliasesCallback().
+ *
+ * This is how the SetAliases method on the bus is answered. The new aliases are
+ * to be announced with updateAliases().
+ *
+ * \param aliases A map from the handles of the contacts to their new aliases.
+ * \param error A pointer to a DBusError instance where any possible error
+ * will be stored.
+ */
+void BaseConnectionAliasingInterface::setAliases(const AliasMap &aliases, DBusError *error)
+{
+    if (!connection()->checkHandles(HandleTypeContact, aliases.keys(), error)) {
+        return;
+    }
+
+    if (!mPriv->setAliasesCb.isValid()) {
+        error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
+        return;
+    }
+    mPriv->setAliasesCb(aliases, error);
+}
+
+/**
+ * Return the aliases of the given contacts.
+ *
+ * \param contacts The handles of the contacts.
+ * \return The aliases set with updateAliases(), with the identifier of the contact as
+ * the alias of the contacts whose alias has never been set. Invalid handles are left out.
+ */
+AliasMap BaseConnectionAliasingInterface::aliases(const UIntList &contacts) const
+{
+    AliasMap ret;
+    if (!connection()) {
+        return ret;
+    }
+
+    ContactAttributesMap attributes = connection()->contactAttributes(contacts,
+            QStringList() << TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING);
+    for (ContactAttributesMap::const_iterator i = attributes.constBegin();
+            i != attributes.constEnd(); ++i) {
+        QVariant alias = i.value().value(aliasAttribute());
+        if (!alias.isValid()) {
+            alias = i.value().value(contactIdAttribute());
+        }
+        ret.insert(i.key(), alias.toString());
+    }
+    return ret;
+}
+
+/**
+ * Change the aliases of contacts.
+ *
+ * The aliases are stored as contact attributes of the connection straight away.
+ * The changes are announced with the AliasesChanged signal once the emission
+ * window has elapsed, along with the other changes made meanwhile, with only the
+ * latest alias of each contact.
+ *
+ * \param aliases A map from the handles of the contacts to their new aliases.
+ * \sa aliases(), setEmissionWindow()
+ */
+void BaseConnectionAliasingInterface::updateAliases(const AliasMap &aliases)
+{
+    if (!connection()) {
+        warning() << "BaseConnectionAliasingInterface::updateAliases: interface "
+            "not plugged into a connection";
+        return;
+    }
+
+    for (AliasMap::const_iterator i = aliases.constBegin(); i != aliases.constEnd(); ++i) {
+        if (connection()->setContactAttribute(i.key(), aliasAttribute(), i.value())) {
+            mPriv->changes.add(i.key(), i.value());
+        }
+    }
+}
+
+/**
+ * Return for how long changes to aliases are collected before being announced.
+ *
+ * \return The emission window in milliseconds.
+ * \sa setEmissionWindow()
+ */
+int BaseConnectionAliasingInterface::emissionWindow() const
+{
+    return mPriv->changes.window();
+}
+
+/**
+ * Set for how long changes to aliases are collected before being announced.
+ *
+ * This works as BaseConnectionSimplePresenceInterface::setEmissionWindow() does.
+ *
+ * \param msec The emission window in milliseconds.
+ * \sa emissionWindow(), changeStats()
+ */
+void BaseConnectionAliasingInterface::setEmissionWindow(int msec)
+{
+    mPriv->changes.setWindow(msec);
+}
+
+/**
+ * Return how many changes to aliases have been made and how many of them have
+ * been merged.
+ *
+ * \return The counters of changes to aliases.
+ * \sa setEmissionWindow()
+ */
+ContactChangeStats BaseConnectionAliasingInterface::changeStats() const
+{
+    return mPriv->changes.stats();
+}
+
+void BaseConnectionAliasingInterface::createAdaptor()
+{
+    (void) new Service::ConnectionInterfaceAliasingAdaptor(dbusObject()->dbusConnection(),
+            mPriv->adaptee, dbusObject());
+}
+
+// Conn.I.Avatars
+struct TP_QT_NO_EXPORT BaseConnectionAvatarsInterface::Private
+{
+    Private(BaseConnectionAvatarsInterface *parent)
+        : adaptee(new BaseConnectionAvatarsInterface::Adaptee(parent)),
+          changes(adaptee, SLOT(flushChanges()))
+    {
+    }
+
+    AvatarSpec avatarDetails;
+    BaseConnectionAvatarsInterface::Adaptee *adaptee;
+    PendingStrings changes;
+};
+
+BaseConnectionAvatarsInterface::Adaptee::Adaptee(BaseConnectionAvatarsInterface *interface)
+    : QObject(interface),
+      mInterface(interface)
+{
+}
+
+BaseConnectionAvatarsInterface::Adaptee::~Adaptee()
+{
+}
+
+QStringList BaseConnectionAvatarsInterface::Adaptee::supportedAvatarMIMETypes() const
+{
+    return mInterface->avatarDetails().supportedMimeTypes();
+}
+
+uint BaseConnectionAvatarsInterface::Adaptee::minimumAvatarHeight() const
+{
+    return mInterface->avatarDetails().minimumHeight();
+}
+
+uint BaseConnectionAvatarsInterface::Adaptee::minimumAvatarWidth() const
+{
+    return mInterface->avatarDetails().minimumWidth();
+}
+
+uint BaseConnectionAvatarsInterface::Adaptee::recommendedAvatarHeight() const
+{
+    return mInterface->avatarDetails().recommendedHeight();
+}
+
+uint BaseConnectionAvatarsInterface::Adaptee::recommendedAvatarWidth() const
+{
+    return mInterface->avatarDetails().recommendedWidth();
+}
+
+uint BaseConnectionAvatarsInterface::Adaptee::maximumAvatarHeight() const
+{
+    return mInterface->avatarDetails().maximumHeight();
+}
+
+uint BaseConnectionAvatarsInterface::Adaptee::maximumAvatarWidth() const
+{
+    return mInterface->avatarDetails().maximumWidth();
+}
+
+uint BaseConnectionAvatarsInterface::Adaptee::maximumAvatarBytes() const
+{
+    return mInterface->avatarDetails().maximumBytes();
+}
+
+void BaseConnectionAvatarsInterface::Adaptee::getAvatarRequirements(
+        const Tp::Service::ConnectionInterfaceAvatarsAdaptor::GetAvatarRequirementsContextPtr &context)
+{
+    context->setFinished(supportedAvatarMIMETypes(),
+            (ushort) minimumAvatarWidth(), (ushort) minimumAvatarHeight(),
+            (ushort) maximumAvatarWidth(), (ushort) maximumAvatarHeight(),
+            maximumAvatarBytes());
+}
+
+void BaseConnectionAvatarsInterface::Adaptee::getKnownAvatarTokens(const Tp::UIntList &contacts,
+        const Tp::Service::ConnectionInterfaceAvatarsAdaptor::GetKnownAvatarTokensContextPtr &context)
+{
+    DBusError error;
+    if (!mInterface->connection()->checkHandles(HandleTypeContact, contacts, &error)) {
+        context->setFinishedWithError(error.name(), error.message());
+        return;
+    }
+    context->setFinished(mInterface->avatarTokens(contacts));
+}
+
+void BaseConnectionAvatarsInterface::Adaptee::flushChanges()
+{
+    // AvatarUpdated is about a single contact, so merging the changes to each contact is
+    // all that can be done here
+    foreach (const PendingStrings::Change &change, mInterface->mPriv->changes.take()) {
+        emit avatarUpdated(change.first, change.second);
+    }
+}
+
+/**
+ * \class BaseConnectionAvatarsInterface
+ * \ingroup serviceconn
+ * \headerfile TelepathyQt/base-connection.h <TelepathyQt/BaseConnectionAvatarsInterface>
+ *
+ * \brief Base class for implementations of Connection.Interface.Avatars
+ *
+ * The avatar tokens of the contacts are kept as contact attributes of the connection
+ * this interface is plugged into. They are changed with updateAvatarTokens(), which
+ * announces the changes once per emission window, see setEmissionWindow().
+ */
+
+/**
+ * Class constructor.
+ */
+BaseConnectionAvatarsInterface::BaseConnectionAvatarsInterface()
+    : AbstractConnectionInterface(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS),
+      mPriv(new Private(this))
+{
+}
+
+/**
+ * Class destructor.
+ */
+BaseConnectionAvatarsInterface::~BaseConnectionAvatarsInterface()
+{
+    delete mPriv;
+}
+
+/**
+ * Return the immutable properties of this interface.
+ *
+ * Immutable properties cannot change after the interface has been registered
+ * on a service on the bus with registerInterface().
+ *
+ * \return The immutable properties of this interface.
+ */
+QVariantMap BaseConnectionAvatarsInterface::immutableProperties() const
+{
+    QVariantMap ret;
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS +
+                QLatin1String(".SupportedAvatarMIMETypes"),
+            QVariant::fromValue(mPriv->adaptee->supportedAvatarMIMETypes()));
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String(".MinimumAvatarHeight"),
+            QVariant::fromValue(mPriv->adaptee->minimumAvatarHeight()));
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String(".MinimumAvatarWidth"),
+            QVariant::fromValue(mPriv->adaptee->minimumAvatarWidth()));
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS +
+                QLatin1String(".RecommendedAvatarHeight"),
+            QVariant::fromValue(mPriv->adaptee->recommendedAvatarHeight()));
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS +
+                QLatin1String(".RecommendedAvatarWidth"),
+            QVariant::fromValue(mPriv->adaptee->recommendedAvatarWidth()));
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String(".MaximumAvatarHeight"),
+            QVariant::fromValue(mPriv->adaptee->maximumAvatarHeight()));
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String(".MaximumAvatarWidth"),
+            QVariant::fromValue(mPriv->adaptee->maximumAvatarWidth()));
+    ret.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String(".MaximumAvatarBytes"),
+            QVariant::fromValue(mPriv->adaptee->maximumAvatarBytes()));
+    return ret;
+}
+
+/**
+ * Return the AvatarSpec that has been set with setAvatarDetails().
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on an object on the bus with registerInterface().
+ *
+ * \return The AvatarSpec that has been set with setAvatarDetails().
+ * \sa setAvatarDetails()
+ */
+AvatarSpec BaseConnectionAvatarsInterface::avatarDetails() const
+{
+    return mPriv->avatarDetails;
+}
+
+/**
+ * Set the requirements on the avatar of the user that will be exposed on the
+ * properties of this interface on the bus.
+ *
+ * This property is immutable and cannot change after this interface
+ * has been registered on an object on the bus with registerInterface().
+ *
+ * \param details The details to set.
+ * \sa avatarDetails()
+ */
+void BaseConnectionAvatarsInterface::setAvatarDetails(const AvatarSpec &details)
+{
+    if (isRegistered()) {
+        warning() << "BaseConnectionAvatarsInterface::setAvatarDetails: cannot change "
+            "property after registration, immutable property";
+        return;
+    }
+    mPriv->avatarDetails = details;
+}
+
+/**
+ * Return the known avatar tokens of the given contacts.
+ *
+ * \param contacts The handles of the contacts.
+ * \return The tokens set with updateAvatarTokens(). The contacts whose token has
+ * never been set are left out.
+ */
+AvatarTokenMap BaseConnectionAvatarsInterface::avatarTokens(const UIntList &contacts) const
+{
+    AvatarTokenMap ret;
+    if (!connection()) {
+        return ret;
+    }
+
+    foreach (uint contact, contacts) {
+        QVariant token = connection()->contactAttribute(contact, avatarTokenAttribute());
+        if (token.isValid()) {
+            ret.insert(contact, token.toString());
+        }
+    }
+    return ret;
+}
+
+/**
+ * Change the avatar tokens of contacts.
+ *
+ * The tokens are stored as contact attributes of the connection straight away.
+ * The changes are announced once the emission window has elapsed, along with the
+ * other changes made meanwhile, with an AvatarUpdated signal carrying the latest
+ * token of each contact.
+ *
+ * \param tokens A map from the handles of the contacts to their new avatar tokens,
+ * empty for contacts who have no avatar.
+ * \sa avatarTokens(), setEmissionWindow()
+ */
+void BaseConnectionAvatarsInterface::updateAvatarTokens(const AvatarTokenMap &tokens)
+{
+    if (!connection()) {
+        warning() << "BaseConnectionAvatarsInterface::updateAvatarTokens: interface "
+            "not plugged into a connection";
+        return;
+    }
+
+    for (AvatarTokenMap::const_iterator i = tokens.constBegin(); i != tokens.constEnd(); ++i) {
+        if (connection()->setContactAttribute(i.key(), avatarTokenAttribute(), i.value())) {
+            mPriv->changes.add(i.key(), i.value());
+        }
+    }
+}
+
+/**
+ * Return for how long changes to avatar tokens are collected before being announced.
+ *
+ * \return The emission window in milliseconds.
+ * \sa setEmissionWindow()
+ */
+int BaseConnectionAvatarsInterface::emissionWindow() const
+{
+    return mPriv->changes.window();
+}
+
+/**
+ * Set for how long changes to avatar tokens are collected before being announced.
+ *
+ * This works as BaseConnectionSimplePresenceInterface::setEmissionWindow() does.
+ *
+ * \param msec The emission window in milliseconds.
+ * \sa emissionWindow(), changeStats()
+ */
+void BaseConnectionAvatarsInterface::setEmissionWindow(int msec)
+{
+    mPriv->changes.setWindow(msec);
+}
+
+/**
+ * Return how many changes to avatar tokens have been made and how many of them have
+ * been merged.
+ *
+ * \return The counters of changes to avatar tokens.
+ * \sa setEmissionWindow()
+ */
+ContactChangeStats BaseConnectionAvatarsInterface::changeStats() const
+{
+    return mPriv->changes.stats();
+}
+
+void BaseConnectionAvatarsInterface::createAdaptor()
+{
+    (void) new Service::ConnectionInterfaceAvatarsAdaptor(dbusObject()->dbusConnection(),
+            mPriv->adaptee, dbusObject());
+}
 
 }
@@ -27,13 +27,18 @@
 #error IN_TP_QT_HEADER
 #endif
 
+#include <TelepathyQt/AvatarSpec>
+#include <TelepathyQt/Callbacks>
+#include <TelepathyQt/Constants>
 #include <TelepathyQt/DBusService>
 #include <TelepathyQt/Global>
+#include <TelepathyQt/PresenceSpecList>
 #include <TelepathyQt/Types>
 
 #include <QDBusConnection>
 
 class QString;
+class QStringList;
 
 namespace Tp
 {
@@ -84,8 +89,34 @@ public:
     virtual QString uniqueName() const;
     bool registerObject(DBusError *error = NULL);
 
+    uint selfHandle() const;
+    void setSelfHandle(uint selfHandle);
+
+    typedef Callback2<QString, const QString &, DBusError*> NormalizeContactCallback;
+    void setNormalizeContactCallback(const NormalizeContactCallback &cb);
+
+    UIntList ensureHandles(HandleType handleType, const QStringList &identifiers,
+            DBusError *error);
+    uint ensureHandle(HandleType handleType, const QString &identifier, DBusError *error);
+    QStringList inspectHandles(HandleType handleType, const UIntList &handles,
+            DBusError *error) const;
+    bool checkHandles(HandleType handleType, const UIntList &handles, DBusError *error) const;
+
+    QStringList contactAttributeInterfaces() const;
+    void setContactAttributeInterfaces(const QStringList &contactAttributeInterfaces);
+    QVariant contactAttribute(uint handle, const QString &name) const;
+    bool setContactAttribute(uint handle, const QString &name, const QVariant &value);
+    void setContactAttributes(uint handle, const QVariantMap &attributes);
+    ContactAttributesMap contactAttributes(const UIntList &handles,
+            const QStringList &interfaces) const;
+
+    QList<AbstractConnectionInterfacePtr> interfaces() const;
+    AbstractConnectionInterfacePtr interface(const QString &interfaceName) const;
+    bool plugInterface(const AbstractConnectionInterfacePtr &interface);
+
 Q_SIGNALS:
     void disconnected();
+    void selfHandleChanged(uint selfHandle);
 
 protected:
     BaseConnection(const QDBusConnection &dbusConnection,
@@ -96,6 +127,9 @@ protected:
             DBusError *error);
 
 private:
+    friend class BaseProtocol;
+    void setDefaultNormalizeContactCallback(const NormalizeContactCallback &cb);
+
     class Adaptee;
     friend class Adaptee;
     class Private;
@@ -103,6 +137,217 @@ private:
     Private *mPriv;
 };
 
+class TP_QT_EXPORT AbstractConnectionInterface : public AbstractDBusServiceInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AbstractConnectionInterface)
+
+public:
+    AbstractConnectionInterface(const QString &interfaceName);
+    virtual ~AbstractConnectionInterface();
+
+    BaseConnection *connection() const;
+
+private:
+    friend class BaseConnection;
+
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+class TP_QT_EXPORT BaseConnectionContactsInterface : public AbstractConnectionInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BaseConnectionContactsInterface)
+
+public:
+    static BaseConnectionContactsInterfacePtr create()
+    {
+        return BaseConnectionContactsInterfacePtr(new BaseConnectionContactsInterface());
+    }
+    template<typename BaseConnectionContactsInterfaceSubclass>
+    static SharedPtr<BaseConnectionContactsInterfaceSubclass> create()
+    {
+        return SharedPtr<BaseConnectionContactsInterfaceSubclass>(
+                new BaseConnectionContactsInterfaceSubclass());
+    }
+
+    virtual ~BaseConnectionContactsInterface();
+
+    QVariantMap immutableProperties() const;
+
+protected:
+    BaseConnectionContactsInterface();
+
+private:
+    void createAdaptor();
+
+    class Adaptee;
+    friend class Adaptee;
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+struct ContactChangeStats
+{
+    ContactChangeStats()
+        : updates(0),
+          mergedUpdates(0),
+          batches(0)
+    {
+    }
+
+    uint updates;
+    uint mergedUpdates;
+    uint batches;
+};
+
+class TP_QT_EXPORT BaseConnectionSimplePresenceInterface : public AbstractConnectionInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BaseConnectionSimplePresenceInterface)
+
+public:
+    static BaseConnectionSimplePresenceInterfacePtr create()
+    {
+        return BaseConnectionSimplePresenceInterfacePtr(
+                new BaseConnectionSimplePresenceInterface());
+    }
+    template<typename BaseConnectionSimplePresenceInterfaceSubclass>
+    static SharedPtr<BaseConnectionSimplePresenceInterfaceSubclass> create()
+    {
+        return SharedPtr<BaseConnectionSimplePresenceInterfaceSubclass>(
+                new BaseConnectionSimplePresenceInterfaceSubclass());
+    }
+
+    virtual ~BaseConnectionSimplePresenceInterface();
+
+    QVariantMap immutableProperties() const;
+
+    PresenceSpecList statuses() const;
+    void setStatuses(const PresenceSpecList &statuses);
+
+    uint maximumStatusMessageLength() const;
+    void setMaximumStatusMessageLength(uint maximumStatusMessageLength);
+
+    typedef Callback3<void, const QString &, const QString &, DBusError*> SetPresenceCallback;
+    void setSetPresenceCallback(const SetPresenceCallback &cb);
+    void setPresence(const QString &status, const QString &statusMessage, DBusError *error);
+
+    SimpleContactPresences presences(const UIntList &contacts) const;
+    void updatePresences(const SimpleContactPresences &presences);
+
+    int emissionWindow() const;
+    void setEmissionWindow(int msec);
+    ContactChangeStats changeStats() const;
+
+protected:
+    BaseConnectionSimplePresenceInterface();
+
+private:
+    void createAdaptor();
+
+    class Adaptee;
+    friend class Adaptee;
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+class TP_QT_EXPORT BaseConnectionAliasingInterface : public AbstractConnectionInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BaseConnectionAliasingInterface)
+
+public:
+    static BaseConnectionAliasingInterfacePtr create()
+    {
+        return BaseConnectionAliasingInterfacePtr(new BaseConnectionAliasingInterface());
+    }
+    template<typename BaseConnectionAliasingInterfaceSubclass>
+    static SharedPtr<BaseConnectionAliasingInterfaceSubclass> create()
+    {
+        return SharedPtr<BaseConnectionAliasingInterfaceSubclass>(
+                new BaseConnectionAliasingInterfaceSubclass());
+    }
+
+    virtual ~BaseConnectionAliasingInterface();
+
+    QVariantMap immutableProperties() const;
+
+    ConnectionAliasFlags aliasFlags() const;
+    void setAliasFlags(ConnectionAliasFlags aliasFlags);
+
+    typedef Callback2<void, const AliasMap &, DBusError*> SetAliasesCallback;
+    void setSetAliasesCallback(const SetAliasesCallback &cb);
+    void setAliases(const AliasMap &aliases, DBusError *error);
+
+    AliasMap aliases(const UIntList &contacts) const;
+    void updateAliases(const AliasMap &aliases);
+
+    int emissionWindow() const;
+    void setEmissionWindow(int msec);
+    ContactChangeStats changeStats() const;
+
+protected:
+    BaseConnectionAliasingInterface();
+
+private:
+    void createAdaptor();
+
+    class Adaptee;
+    friend class Adaptee;
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+class TP_QT_EXPORT BaseConnectionAvatarsInterface : public AbstractConnectionInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BaseConnectionAvatarsInterface)
+
+public:
+    static BaseConnectionAvatarsInterfacePtr create()
+    {
+        return BaseConnectionAvatarsInterfacePtr(new BaseConnectionAvatarsInterface());
+    }
+    template<typename BaseConnectionAvatarsInterfaceSubclass>
+    static SharedPtr<BaseConnectionAvatarsInterfaceSubclass> create()
+    {
+        return SharedPtr<BaseConnectionAvatarsInterfaceSubclass>(
+                new BaseConnectionAvatarsInterfaceSubclass());
+    }
+
+    virtual ~BaseConnectionAvatarsInterface();
+
+    QVariantMap immutableProperties() const;
+
+    AvatarSpec avatarDetails() const;
+    void setAvatarDetails(const AvatarSpec &spec);
+
+    AvatarTokenMap avatarTokens(const UIntList &contacts) const;
+    void updateAvatarTokens(const AvatarTokenMap &tokens);
+
+    int emissionWindow() const;
+    void setEmissionWindow(int msec);
+    ContactChangeStats changeStats() const;
+
+protected:
+    BaseConnectionAvatarsInterface();
+
+private:
+    void createAdaptor();
+
+    class Adaptee;
+    friend class Adaptee;
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
 }
 
 #endif
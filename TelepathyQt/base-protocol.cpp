@@ -537,6 +537,9 @@ void BaseProtocol::setCreateConnectionCallback(const CreateConnectionCallback &c
  * Create a new connection object by calling the callback that has been set
  * with setCreateConnectionCallback().
  *
+ * The new connection normalizes contact identifiers with the callback set with
+ * setNormalizeContactCallback(), unless it has been given one of its own.
+ *
  * \param parameters The connection parameters.
  * \param error A pointer to a DBusError instance where any possible error
  * will be stored.
@@ -551,7 +554,12 @@ BaseConnectionPtr BaseProtocol::createConnection(const QVariantMap &parameters,
         error->set(TP_QT_ERROR_NOT_IMPLEMENTED, QLatin1String("Not implemented"));
         return BaseConnectionPtr();
     }
-    return mPriv->createConnectionCb(parameters, error);
+
+    BaseConnectionPtr connection = mPriv->createConnectionCb(parameters, error);
+    if (connection) {
+        connection->setDefaultNormalizeContactCallback(mPriv->normalizeContactCb);
+    }
+    return connection;
 }
 
 /**
@@ -683,7 +691,7 @@ bool BaseProtocol::plugInterface(const AbstractProtocolInterfacePtr &interface)
         return false;
     }
 
-    debug() << "Interface" << interface->interfaceName() << "plugged";
+    tpDebug() << "Interface" << interface->interfaceName() << "plugged";
     mPriv->interfaces.insert(interface->interfaceName(), interface);
     return true;
 }
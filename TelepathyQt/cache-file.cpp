@@ -0,0 +1,166 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/cache-file.h"
+
+#include "TelepathyQt/debug-internal.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QString>
+#include <QtCore/QTemporaryFile>
+
+#include <stdio.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+namespace Tp
+{
+
+/*
+ * Replace the contents of the cache file \a fileName with \a contents, creating the directory it
+ * lives in if needed.
+ *
+ * The contents are written to a uniquely named temporary file in the same directory, which is then
+ * renamed over the cache. Readers never see a partially written cache, and processes saving the
+ * same cache at the same time don't clobber each other's temporary file: the last one to finish
+ * wins.
+ */
+bool saveCacheFile(const QString &fileName, const QByteArray &contents)
+{
+    QString dirName = QFileInfo(fileName).absolutePath();
+    if (!QDir().mkpath(dirName)) {
+        warning() << "Unable to create cache directory" << dirName;
+        return false;
+    }
+
+    QTemporaryFile file(fileName);
+    if (!file.open()) {
+        warning() << "Unable to create a temporary file to save cache" << fileName;
+        return false;
+    }
+
+    if (file.write(contents) != contents.size() || !file.flush()) {
+        warning() << "Error writing cache" << file.fileName();
+        return false;
+    }
+    file.close();
+
+#ifdef Q_OS_UNIX
+    // QFile::rename() refuses to replace an existing file, while rename() replaces it atomically
+    bool renamed = ::rename(QFile::encodeName(file.fileName()).constData(),
+            QFile::encodeName(fileName).constData()) == 0;
+#else
+    QFile::remove(fileName);
+    bool renamed = QFile::rename(file.fileName(), fileName);
+#endif
+    if (!renamed) {
+        warning() << "Unable to replace cache" << fileName;
+        return false;
+    }
+
+    file.setAutoRemove(false);
+    return true;
+}
+
+/*
+ * What tells whether a file changed since it was last read. The modification time alone has a
+ * resolution of a second on some file systems, so a file rewritten twice within the same second
+ * keeping its size would go unnoticed. Where available, the nanoseconds of the modification time
+ * and the inode are compared too, the latter catching files replaced by renaming a new one over
+ * them.
+ */
+FileStamp::FileStamp()
+    : valid(false),
+      device(0),
+      inode(0),
+      size(0),
+      modified(0),
+      modifiedNsec(0)
+{
+}
+
+FileStamp FileStamp::forFile(const QString &fileName)
+{
+    FileStamp stamp;
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(fileName).constData(), &st) != 0) {
+        return stamp;
+    }
+
+    stamp.valid = true;
+    stamp.device = st.st_dev;
+    stamp.inode = st.st_ino;
+    stamp.size = st.st_size;
+    stamp.modified = st.st_mtime;
+#if defined(Q_OS_LINUX)
+    stamp.modifiedNsec = st.st_mtim.tv_nsec;
+#elif defined(Q_OS_MAC)
+    stamp.modifiedNsec = st.st_mtimespec.tv_nsec;
+#endif
+#else
+    QFileInfo fileInfo(fileName);
+    if (!fileInfo.exists()) {
+        return stamp;
+    }
+
+    stamp.valid = true;
+    stamp.size = fileInfo.size();
+    QDateTime lastModified = fileInfo.lastModified().toUTC();
+    stamp.modified = lastModified.toTime_t();
+    stamp.modifiedNsec = lastModified.time().msec() * Q_INT64_C(1000000);
+#endif
+    return stamp;
+}
+
+bool FileStamp::operator==(const FileStamp &other) const
+{
+    return valid == other.valid && device == other.device && inode == other.inode &&
+        size == other.size && modified == other.modified && modifiedNsec == other.modifiedNsec;
+}
+
+/*
+ * Stamps are stored along with the caches built from the files they describe, so a cache can tell
+ * whether it is still up-to-date after being loaded by another process.
+ */
+QDataStream &operator<<(QDataStream &out, const FileStamp &stamp)
+{
+    out << stamp.valid << stamp.device << stamp.inode << stamp.size << stamp.modified <<
+        stamp.modifiedNsec;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, FileStamp &stamp)
+{
+    in >> stamp.valid >> stamp.device >> stamp.inode >> stamp.size >> stamp.modified >>
+        stamp.modifiedNsec;
+    return in;
+}
+
+} // Tp
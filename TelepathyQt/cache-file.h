@@ -0,0 +1,64 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_cache_file_h_HEADER_GUARD_
+#define _TelepathyQt_cache_file_h_HEADER_GUARD_
+
+#include <TelepathyQt/Global>
+
+class QByteArray;
+class QDataStream;
+class QString;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace Tp
+{
+
+TP_QT_NO_EXPORT bool saveCacheFile(const QString &fileName, const QByteArray &contents);
+
+struct TP_QT_NO_EXPORT FileStamp
+{
+    FileStamp();
+
+    static FileStamp forFile(const QString &fileName);
+
+    bool isValid() const { return valid; }
+
+    bool operator==(const FileStamp &other) const;
+    bool operator!=(const FileStamp &other) const { return !(*this == other); }
+
+    bool valid;
+    quint64 device;
+    quint64 inode;
+    qint64 size;
+    qint64 modified;
+    qint64 modifiedNsec;
+};
+
+TP_QT_NO_EXPORT QDataStream &operator<<(QDataStream &out, const FileStamp &stamp);
+TP_QT_NO_EXPORT QDataStream &operator>>(QDataStream &in, FileStamp &stamp);
+
+} // Tp
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+#endif
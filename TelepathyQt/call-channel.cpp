@@ -204,7 +204,7 @@ void CallChannel::Private::introspectCore(CallChannel::Private *self)
     }
 
     if (needIntrospectMainProps) {
-        debug() << "Introspecting immutable properties of CallChannel";
+        tpDebug() << "Introspecting immutable properties of CallChannel";
 
         parent->connect(self->callInterface->requestAllProperties(),
                 SIGNAL(finished(Tp::PendingOperation*)),
@@ -848,7 +848,7 @@ void CallChannel::gotMainProperties(PendingOperation *op)
         return;
     }
 
-    debug() << "Got reply to CallInterface::requestAllProperties()";
+    tpDebug() << "Got reply to CallInterface::requestAllProperties()";
 
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
     Q_ASSERT(pvm);
@@ -876,7 +876,7 @@ void CallChannel::gotCallState(PendingOperation *op)
         return;
     }
 
-    debug() << "Got reply to CallInterface::requestAllProperties()";
+    tpDebug() << "Got reply to CallInterface::requestAllProperties()";
 
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
     Q_ASSERT(pvm);
@@ -927,7 +927,7 @@ void CallChannel::gotCallMembers(PendingOperation *op)
         return;
     }
 
-    debug() << "Got reply to CallInterface::requestAllProperties()";
+    tpDebug() << "Got reply to CallInterface::requestAllProperties()";
 
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
     Q_ASSERT(pvm);
@@ -1023,11 +1023,11 @@ void CallChannel::onCallMembersChanged(const CallMemberMap &updates,
         const CallStateReason &reason)
 {
     if (updates.isEmpty() && removed.isEmpty()) {
-        debug() << "Received Call::CallMembersChanged with 0 removals and updates, skipping it";
+        tpDebug() << "Received Call::CallMembersChanged with 0 removals and updates, skipping it";
         return;
     }
 
-    debug() << "Received Call::CallMembersChanged with" << updates.size() <<
+    tpDebug() << "Received Call::CallMembersChanged with" << updates.size() <<
         "updated and" << removed.size() << "removed";
     mPriv->callMembersChangedQueue.enqueue(
             Private::CallMembersChangedInfo::create(updates, identifiers, removed, reason));
@@ -1044,7 +1044,7 @@ void CallChannel::gotContents(PendingOperation *op)
         return;
     }
 
-    debug() << "Got reply to CallInterface::requestPropertyContents()";
+    tpDebug() << "Got reply to CallInterface::requestPropertyContents()";
 
     PendingVariant *pv = qobject_cast<PendingVariant*>(op);
     Q_ASSERT(pv);
@@ -1064,10 +1064,10 @@ void CallChannel::gotContents(PendingOperation *op)
 
 void CallChannel::onContentAdded(const QDBusObjectPath &contentPath)
 {
-    debug() << "Received Call::ContentAdded for content" << contentPath.path();
+    tpDebug() << "Received Call::ContentAdded for content" << contentPath.path();
 
     if (lookupContent(contentPath)) {
-        debug() << "Content already exists, ignoring";
+        tpDebug() << "Content already exists, ignoring";
         return;
     }
 
@@ -1077,11 +1077,11 @@ void CallChannel::onContentAdded(const QDBusObjectPath &contentPath)
 void CallChannel::onContentRemoved(const QDBusObjectPath &contentPath,
         const CallStateReason &reason)
 {
-    debug() << "Received Call::ContentRemoved for content" << contentPath.path();
+    tpDebug() << "Received Call::ContentRemoved for content" << contentPath.path();
 
     CallContentPtr content = lookupContent(contentPath);
     if (!content) {
-        debug() << "Content does not exist, ignoring";
+        tpDebug() << "Content does not exist, ignoring";
         return;
     }
 
@@ -1145,13 +1145,13 @@ void CallChannel::gotLocalHoldState(QDBusPendingCallWatcher *watcher)
     if (reply.isError()) {
         warning().nospace() << "Call::Hold::GetHoldState() failed with " <<
             reply.error().name() << ": " << reply.error().message();
-        debug() << "Ignoring error getting hold state and assuming we're not on hold";
+        tpDebug() << "Ignoring error getting hold state and assuming we're not on hold";
         onLocalHoldStateChanged(mPriv->localHoldState, mPriv->localHoldStateReason);
         watcher->deleteLater();
         return;
     }
 
-    debug() << "Got reply to Call::Hold::GetHoldState()";
+    tpDebug() << "Got reply to Call::Hold::GetHoldState()";
     onLocalHoldStateChanged(reply.argumentAt<0>(), reply.argumentAt<1>());
     watcher->deleteLater();
 }
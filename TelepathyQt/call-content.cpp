@@ -330,7 +330,7 @@ void CallContent::gotMainProperties(PendingOperation *op)
         return;
     }
 
-    debug() << "Got reply to CallContentInterface::requestAllProperties()";
+    tpDebug() << "Got reply to CallContentInterface::requestAllProperties()";
 
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
     Q_ASSERT(pvm);
@@ -357,10 +357,10 @@ void CallContent::gotMainProperties(PendingOperation *op)
 void CallContent::onStreamsAdded(const ObjectPathList &streamsPaths)
 {
     foreach (const QDBusObjectPath &streamPath, streamsPaths) {
-        debug() << "Received Call::Content::StreamAdded for stream" << streamPath.path();
+        tpDebug() << "Received Call::Content::StreamAdded for stream" << streamPath.path();
 
         if (mPriv->lookupStream(streamPath)) {
-            debug() << "Stream already exists, ignoring";
+            tpDebug() << "Stream already exists, ignoring";
             return;
         }
 
@@ -372,11 +372,11 @@ void CallContent::onStreamsRemoved(const ObjectPathList &streamsPaths,
         const CallStateReason &reason)
 {
     foreach (const QDBusObjectPath &streamPath, streamsPaths) {
-        debug() << "Received Call::Content::StreamRemoved for stream" << streamPath.path();
+        tpDebug() << "Received Call::Content::StreamRemoved for stream" << streamPath.path();
 
         CallStreamPtr stream = mPriv->lookupStream(streamPath);
         if (!stream) {
-            debug() << "Stream does not exist, ignoring";
+            tpDebug() << "Stream does not exist, ignoring";
             return;
         }
 
@@ -344,7 +344,7 @@ void CallStream::gotMainProperties(PendingOperation *op)
         return;
     }
 
-    debug() << "Got reply to CallStreamInterface::requestAllProperties()";
+    tpDebug() << "Got reply to CallStreamInterface::requestAllProperties()";
 
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
     Q_ASSERT(pvm);
@@ -452,12 +452,12 @@ void CallStream::onRemoteMembersChanged(const ContactSendingStateMap &updates,
         const CallStateReason &reason)
 {
     if (updates.isEmpty() && removed.isEmpty()) {
-        debug() << "Received Call::Stream::RemoteMembersChanged with 0 removals and "
+        tpDebug() << "Received Call::Stream::RemoteMembersChanged with 0 removals and "
             "updates, skipping it";
         return;
     }
 
-    debug() << "Received Call::Stream::RemoteMembersChanged with" << updates.size() <<
+    tpDebug() << "Received Call::Stream::RemoteMembersChanged with" << updates.size() <<
         "updated and" << removed.size() << "removed";
     mPriv->remoteMembersChangedQueue.enqueue(
             Private::RemoteMembersChangedInfo::create(updates, identifiers, removed, reason));
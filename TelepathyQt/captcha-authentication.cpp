@@ -45,7 +45,7 @@ PendingCaptchaAnswer::PendingCaptchaAnswer(const QDBusPendingCall &call,
       mCaptcha(object),
       mChannel(mCaptcha->channel())
 {
-    debug() << "Calling Captcha.Answer";
+    tpDebug() << "Calling Captcha.Answer";
     if (mWatcher->isFinished()) {
         onAnswerFinished();
     } else {
@@ -69,12 +69,12 @@ void PendingCaptchaAnswer::onAnswerFinished()
         return;
     }
 
-    debug() << "Captcha.Answer returned successfully";
+    tpDebug() << "Captcha.Answer returned successfully";
 
     // It might have been already opened - check
     if (mCaptcha->status() == CaptchaStatusLocalPending ||
             mCaptcha->status() == CaptchaStatusRemotePending) {
-        debug() << "Awaiting captcha to be answered from server";
+        tpDebug() << "Awaiting captcha to be answered from server";
         // Wait until status becomes relevant
         connect(mCaptcha.data(),
                 SIGNAL(statusChanged(Tp::CaptchaStatus)),
@@ -114,7 +114,7 @@ PendingCaptchaCancel::PendingCaptchaCancel(const QDBusPendingCall &call,
       mCaptcha(object),
       mChannel(mCaptcha->channel())
 {
-    debug() << "Calling Captcha.Cancel";
+    tpDebug() << "Calling Captcha.Cancel";
     if (mWatcher->isFinished()) {
         onCancelFinished();
     } else {
@@ -138,7 +138,7 @@ void PendingCaptchaCancel::onCancelFinished()
         return;
     }
 
-    debug() << "Captcha.Cancel returned successfully";
+    tpDebug() << "Captcha.Cancel returned successfully";
 
     // Perfect. Close the channel now.
     connect(mChannel->requestClose(),
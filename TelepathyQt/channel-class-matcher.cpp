@@ -0,0 +1,223 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/channel-class-matcher.h"
+
+#include <TelepathyQt/Constants>
+
+#include <QtAlgorithms>
+
+namespace Tp
+{
+
+// ChannelClassMatcher answers "which of these specs is a subset of this channel class" without
+// comparing against every spec. Nearly all specs fix ChannelType and TargetHandleType, so the
+// specs are bucketed by those two values and a lookup only visits the buckets the channel's
+// values select, plus the specs which leave one or both of them unset. Only the properties
+// left in a spec after taking out the indexed ones are compared one by one.
+//
+// Within each bucket the entries are kept in the order of the specs given to the constructor,
+// which lets firstMatch() honour that order while checking each bucket only up to its first hit.
+
+ChannelClassMatcher::ChannelClassMatcher()
+    : mChannelTypeName(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")),
+      mTargetHandleTypeName(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"))
+{
+}
+
+ChannelClassMatcher::ChannelClassMatcher(const QList<ChannelClassSpec> &specs)
+    : mChannelTypeName(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")),
+      mTargetHandleTypeName(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"))
+{
+    for (int i = 0; i < specs.size(); ++i) {
+        Entry entry;
+        entry.index = i;
+        entry.remaining = specs.at(i).allProperties();
+        mAll.append(entry);
+
+        // Values of unexpected types are left to the QVariant comparison, which may convert them
+        QVariantMap::iterator type = entry.remaining.find(mChannelTypeName);
+        bool hasType = type != entry.remaining.end() && type->type() == QVariant::String;
+        QString channelType;
+        if (hasType) {
+            channelType = type->toString();
+            entry.remaining.erase(type);
+        }
+
+        QVariantMap::iterator handleType = entry.remaining.find(mTargetHandleTypeName);
+        bool hasHandleType = handleType != entry.remaining.end() &&
+            handleType->type() == QVariant::UInt;
+        uint targetHandleType = 0;
+        if (hasHandleType) {
+            targetHandleType = handleType->toUInt();
+            entry.remaining.erase(handleType);
+        }
+
+        if (hasType && hasHandleType) {
+            mExact[qMakePair(channelType, targetHandleType)].append(entry);
+        } else if (hasType) {
+            mByChannelType[channelType].append(entry);
+        } else if (hasHandleType) {
+            mByTargetHandleType[targetHandleType].append(entry);
+        } else {
+            mOthers.append(entry);
+        }
+    }
+}
+
+QList<int> ChannelClassMatcher::matches(const ChannelClassSpec &spec) const
+{
+    return matches(spec.allProperties(), false);
+}
+
+int ChannelClassMatcher::firstMatch(const ChannelClassSpec &spec) const
+{
+    return firstMatch(spec.allProperties(), false);
+}
+
+QList<int> ChannelClassMatcher::matchesChannel(const QVariantMap &immutableProperties) const
+{
+    return matches(immutableProperties, true);
+}
+
+int ChannelClassMatcher::firstMatchForChannel(const QVariantMap &immutableProperties) const
+{
+    return firstMatch(immutableProperties, true);
+}
+
+QList<const ChannelClassMatcher::Bucket *> ChannelClassMatcher::candidates(
+        const QVariantMap &props, bool channel) const
+{
+    QList<const Bucket *> ret;
+
+    QVariant type;
+    QVariant handleType;
+    bool hasType = lookup(props, mChannelTypeName, channel, &type);
+    bool hasHandleType = lookup(props, mTargetHandleTypeName, channel, &handleType);
+
+    if ((hasType && type.type() != QVariant::String) ||
+        (hasHandleType && handleType.type() != QVariant::UInt)) {
+        // Can't use the index for these, compare against everything
+        ret << &mAll;
+        return ret;
+    }
+
+    ret << &mOthers;
+
+    if (hasType) {
+        QHash<QString, Bucket>::const_iterator i = mByChannelType.constFind(type.toString());
+        if (i != mByChannelType.constEnd()) {
+            ret << &i.value();
+        }
+    }
+
+    if (hasHandleType) {
+        QHash<uint, Bucket>::const_iterator i =
+            mByTargetHandleType.constFind(handleType.toUInt());
+        if (i != mByTargetHandleType.constEnd()) {
+            ret << &i.value();
+        }
+    }
+
+    if (hasType && hasHandleType) {
+        QHash<QPair<QString, uint>, Bucket>::const_iterator i =
+            mExact.constFind(qMakePair(type.toString(), handleType.toUInt()));
+        if (i != mExact.constEnd()) {
+            ret << &i.value();
+        }
+    }
+
+    return ret;
+}
+
+bool ChannelClassMatcher::lookup(const QVariantMap &props, const QString &name, bool channel,
+        QVariant *value) const
+{
+    QVariantMap::const_iterator i = props.constFind(name);
+    if (i != props.constEnd()) {
+        *value = i.value();
+        return true;
+    }
+
+    if (channel) {
+        // ChannelClassSpec(immutableProperties) always sets these two, so it does so here too
+        if (name == mChannelTypeName) {
+            *value = QVariant::fromValue(QString());
+            return true;
+        } else if (name == mTargetHandleTypeName) {
+            *value = QVariant::fromValue((uint) 0);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ChannelClassMatcher::entryMatches(const Entry &entry, const QVariantMap &props,
+        bool channel) const
+{
+    QVariant value;
+    QVariantMap::const_iterator i;
+    for (i = entry.remaining.constBegin(); i != entry.remaining.constEnd(); ++i) {
+        if (!lookup(props, i.key(), channel, &value) || i.value() != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<int> ChannelClassMatcher::matches(const QVariantMap &props, bool channel) const
+{
+    QList<int> ret;
+
+    foreach (const Bucket *bucket, candidates(props, channel)) {
+        foreach (const Entry &entry, *bucket) {
+            if (entryMatches(entry, props, channel)) {
+                ret << entry.index;
+            }
+        }
+    }
+
+    qSort(ret);
+    return ret;
+}
+
+int ChannelClassMatcher::firstMatch(const QVariantMap &props, bool channel) const
+{
+    int ret = -1;
+
+    foreach (const Bucket *bucket, candidates(props, channel)) {
+        foreach (const Entry &entry, *bucket) {
+            if (ret != -1 && entry.index > ret) {
+                break;
+            }
+
+            if (entryMatches(entry, props, channel)) {
+                ret = entry.index;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
+} // Tp
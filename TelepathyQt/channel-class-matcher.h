@@ -0,0 +1,85 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_channel_class_matcher_h_HEADER_GUARD_
+#define _TelepathyQt_channel_class_matcher_h_HEADER_GUARD_
+
+#include <TelepathyQt/ChannelClassSpec>
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVariantMap>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace Tp
+{
+
+class TP_QT_NO_EXPORT ChannelClassMatcher
+{
+public:
+    ChannelClassMatcher();
+    ChannelClassMatcher(const QList<ChannelClassSpec> &specs);
+
+    bool isEmpty() const { return mAll.isEmpty(); }
+    int size() const { return mAll.size(); }
+
+    // Indices of the specs which are a subset of spec, in ascending order
+    QList<int> matches(const ChannelClassSpec &spec) const;
+    int firstMatch(const ChannelClassSpec &spec) const;
+
+    // Same as above, for the specs which ChannelClassSpec::matches() the given immutable properties
+    QList<int> matchesChannel(const QVariantMap &immutableProperties) const;
+    int firstMatchForChannel(const QVariantMap &immutableProperties) const;
+
+private:
+    struct Entry
+    {
+        int index;
+        QVariantMap remaining;
+    };
+    typedef QList<Entry> Bucket;
+
+    QList<const Bucket *> candidates(const QVariantMap &props, bool channel) const;
+    bool lookup(const QVariantMap &props, const QString &name, bool channel,
+            QVariant *value) const;
+    bool entryMatches(const Entry &entry, const QVariantMap &props, bool channel) const;
+
+    QList<int> matches(const QVariantMap &props, bool channel) const;
+    int firstMatch(const QVariantMap &props, bool channel) const;
+
+    QString mChannelTypeName;
+    QString mTargetHandleTypeName;
+
+    QHash<QPair<QString, uint>, Bucket> mExact;
+    QHash<QString, Bucket> mByChannelType;
+    QHash<uint, Bucket> mByTargetHandleType;
+    Bucket mOthers;
+    Bucket mAll;
+};
+
+} // Tp
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+#endif
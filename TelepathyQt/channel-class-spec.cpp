@@ -146,9 +146,32 @@ bool ChannelClassSpec::isSubsetOf(const ChannelClassSpec &other) const
 
 bool ChannelClassSpec::matches(const QVariantMap &immutableProperties) const
 {
-    // We construct a ChannelClassSpec for comparison so the StreamedMedia props are normalized
-    // consistently etc
-    return this->isSubsetOf(ChannelClassSpec(immutableProperties));
+    if (!mPriv) {
+        return true;
+    }
+
+    // Same as isSubsetOf(ChannelClassSpec(immutableProperties)), without building the spec: it
+    // only adds an empty ChannelType and a zero TargetHandleType when they are missing
+    QVariantMap::const_iterator i;
+    for (i = mPriv->props.constBegin(); i != mPriv->props.constEnd(); ++i) {
+        QVariantMap::const_iterator found = immutableProperties.constFind(i.key());
+        QVariant value;
+        if (found != immutableProperties.constEnd()) {
+            value = found.value();
+        } else if (i.key() == TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")) {
+            value = QVariant::fromValue(QString());
+        } else if (i.key() == TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType")) {
+            value = QVariant::fromValue((uint) 0);
+        } else {
+            return false;
+        }
+
+        if (i.value() != value) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 bool ChannelClassSpec::hasProperty(const QString &qualifiedName) const
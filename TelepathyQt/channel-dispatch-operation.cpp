@@ -88,7 +88,7 @@ ChannelDispatchOperation::Private::Private(ChannelDispatchOperation *parent)
       readinessHelper(parent->readinessHelper()),
       gotPossibleHandlers(false)
 {
-    debug() << "Creating new ChannelDispatchOperation:" << parent->objectPath();
+    tpDebug() << "Creating new ChannelDispatchOperation:" << parent->objectPath();
 
     parent->connect(baseInterface,
             SIGNAL(Finished()),
@@ -132,13 +132,13 @@ void ChannelDispatchOperation::Private::introspectMain(ChannelDispatchOperation:
             && mainProps.contains(QLatin1String("Connection"))
             && mainProps.contains(QLatin1String("Interfaces"))
             && mainProps.contains(QLatin1String("PossibleHandlers"))) {
-        debug() << "Supplied properties were sufficient, not introspecting"
+        tpDebug() << "Supplied properties were sufficient, not introspecting"
             << self->parent->objectPath();
         self->extractMainProps(mainProps, true);
         return;
     }
 
-    debug() << "Calling Properties::GetAll(ChannelDispatchOperation)";
+    tpDebug() << "Calling Properties::GetAll(ChannelDispatchOperation)";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(
                 self->properties->GetAll(TP_QT_IFACE_CHANNEL_DISPATCH_OPERATION),
@@ -210,7 +210,7 @@ void ChannelDispatchOperation::Private::extractMainProps(const QVariantMap &prop
     }
 
     if (readyOps.isEmpty()) {
-        debug() << "No proxies to prepare for CDO" << parent->objectPath();
+        tpDebug() << "No proxies to prepare for CDO" << parent->objectPath();
         readinessHelper->setIntrospectCompleted(FeatureCore, true);
     } else {
         parent->connect(new PendingComposite(readyOps, ChannelDispatchOperationPtr(parent)),
@@ -225,7 +225,7 @@ ChannelDispatchOperation::PendingClaim::PendingClaim(const ChannelDispatchOperat
       mDispatchOp(op),
       mHandler(handler)
 {
-    debug() << "Invoking CDO.Claim";
+    tpDebug() << "Invoking CDO.Claim";
     connect(new PendingVoid(op->baseInterface()->Claim(), op),
             SIGNAL(finished(Tp::PendingOperation*)),
             SLOT(onClaimFinished(Tp::PendingOperation*)));
@@ -239,7 +239,7 @@ void ChannelDispatchOperation::PendingClaim::onClaimFinished(
         PendingOperation *op)
 {
     if (!op->isError()) {
-        debug() << "CDO.Claim returned successfully, updating HandledChannels";
+        tpDebug() << "CDO.Claim returned successfully, updating HandledChannels";
         if (mHandler) {
             // register the channels in HandledChannels
             FakeHandlerManager::instance()->registerChannels(
@@ -573,7 +573,7 @@ Client::ChannelDispatchOperationInterface *ChannelDispatchOperation::baseInterfa
 
 void ChannelDispatchOperation::onFinished()
 {
-    debug() << "ChannelDispatchOperation finished and was removed";
+    tpDebug() << "ChannelDispatchOperation finished and was removed";
     invalidate(TP_QT_ERROR_OBJECT_REMOVED,
                QLatin1String("ChannelDispatchOperation finished and was removed"));
 }
@@ -584,7 +584,7 @@ void ChannelDispatchOperation::gotMainProperties(QDBusPendingCallWatcher *watche
 
     // Watcher is NULL if we didn't have to introspect at all
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(ChannelDispatchOperation)";
+        tpDebug() << "Got reply to Properties::GetAll(ChannelDispatchOperation)";
         mPriv->extractMainProps(reply.value(), false);
     } else {
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore,
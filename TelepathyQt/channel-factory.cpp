@@ -26,6 +26,8 @@
 
 #include "TelepathyQt/_gen/future-constants.h"
 
+#include "TelepathyQt/channel-class-matcher.h"
+#include "TelepathyQt/channel-internal.h"
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/CallChannel>
@@ -55,14 +57,53 @@ struct TP_QT_NO_EXPORT ChannelFactory::Private
 {
     Private();
 
+    const ChannelClassMatcher &featuresMatcher();
+    const ChannelClassMatcher &ctorsMatcher();
+
     QList<ChannelClassFeatures> features;
 
     typedef QPair<ChannelClassSpec, ConstructorConstPtr> CtorPair;
     QList<CtorPair> ctors;
+
+    // Rebuilt on the next lookup after features or ctors change
+    ChannelClassMatcher featuresIndex;
+    bool featuresIndexDirty;
+    ChannelClassMatcher ctorsIndex;
+    bool ctorsIndexDirty;
 };
 
 ChannelFactory::Private::Private()
+    : featuresIndexDirty(true),
+      ctorsIndexDirty(true)
+{
+}
+
+const ChannelClassMatcher &ChannelFactory::Private::featuresMatcher()
+{
+    if (featuresIndexDirty) {
+        QList<ChannelClassSpec> specs;
+        foreach (const ChannelClassFeatures &pair, features) {
+            specs << pair.first;
+        }
+        featuresIndex = ChannelClassMatcher(specs);
+        featuresIndexDirty = false;
+    }
+
+    return featuresIndex;
+}
+
+const ChannelClassMatcher &ChannelFactory::Private::ctorsMatcher()
 {
+    if (ctorsIndexDirty) {
+        QList<ChannelClassSpec> specs;
+        foreach (const CtorPair &pair, ctors) {
+            specs << pair.first;
+        }
+        ctorsIndex = ChannelClassMatcher(specs);
+        ctorsIndexDirty = false;
+    }
+
+    return ctorsIndex;
 }
 
 /**
@@ -548,10 +589,8 @@ Features ChannelFactory::featuresFor(const ChannelClassSpec &channelClass) const
 {
     Features features;
 
-    foreach (const ChannelClassFeatures &pair, mPriv->features) {
-        if (pair.first.isSubsetOf(channelClass)) {
-            features.unite(pair.second);
-        }
+    foreach (int i, mPriv->featuresMatcher().matches(channelClass)) {
+        features.unite(mPriv->features.at(i).second);
     }
 
     return features;
@@ -574,15 +613,14 @@ void ChannelFactory::addFeaturesFor(const ChannelClassSpec &channelClass, const
     // We ran out of feature specifications (for the given size/specificity of a channel class)
     // before finding a matching one, so let's create a new entry
     mPriv->features.insert(i, qMakePair(channelClass, features));
+    mPriv->featuresIndexDirty = true;
 }
 
 ChannelFactory::ConstructorConstPtr ChannelFactory::constructorFor(const ChannelClassSpec &cc) const
 {
-    QList<Private::CtorPair>::iterator i;
-    for (i = mPriv->ctors.begin(); i != mPriv->ctors.end(); ++i) {
-        if (i->first.isSubsetOf(cc)) {
-            return i->second;
-        }
+    int i = mPriv->ctorsMatcher().firstMatch(cc);
+    if (i != -1) {
+        return mPriv->ctors.at(i).second;
     }
 
     // If this is reached, we didn't have a proper fallback constructor
@@ -615,6 +653,7 @@ void ChannelFactory::setConstructorFor(const ChannelClassSpec &channelClass,
     // We ran out of constructors (for the given size/specificity of a channel class)
     // before finding a matching one, so let's create a new entry
     mPriv->ctors.insert(i, qMakePair(channelClass, ctor));
+    mPriv->ctorsIndexDirty = true;
 }
 
 /**
@@ -637,13 +676,43 @@ PendingReady *ChannelFactory::proxy(const ConnectionPtr &connection, const QStri
 {
     DBusProxyPtr proxy = cachedProxy(connection->busName(), channelPath);
     if (proxy.isNull()) {
-        proxy = constructorFor(ChannelClassSpec(immutableProperties))->construct(connection,
-                channelPath, immutableProperties);
+        int i = mPriv->ctorsMatcher().firstMatchForChannel(immutableProperties);
+        // The fallback constructor matches any channel
+        Q_ASSERT(i != -1);
+        proxy = mPriv->ctors.at(i).second->construct(connection, channelPath,
+                immutableProperties);
     }
 
     return nowHaveProxy(proxy);
 }
 
+/**
+ * Return how many D-Bus round trips were avoided while making channels ready, by channel type.
+ *
+ * When the immutable properties given to proxy() (or to the Channel constructor) contain all of
+ * the Channel properties, they're used for Channel::FeatureCore instead of retrieving them again.
+ * Each introspection call skipped that way is counted here, keyed by the channel type, for all the
+ * channels in this process.
+ *
+ * The Channel.Interface.Group properties and the Channels property of
+ * Channel.Interface.Conference can change, so they're always retrieved.
+ *
+ * \return The number of avoided round trips for each channel type.
+ * \sa resetAvoidedRoundTrips()
+ */
+QHash<QString, uint> ChannelFactory::avoidedRoundTrips()
+{
+    return ChannelRoundTripCounters::avoided();
+}
+
+/**
+ * Reset the counters returned by avoidedRoundTrips() to zero.
+ */
+void ChannelFactory::resetAvoidedRoundTrips()
+{
+    ChannelRoundTripCounters::reset();
+}
+
 /**
  * Transforms well-known names to the corresponding unique names, as is appropriate for Channel
  *
@@ -667,7 +736,13 @@ Features ChannelFactory::featuresFor(const DBusProxyPtr &proxy) const
     ChannelPtr chan = ChannelPtr::qObjectCast(proxy);
     Q_ASSERT(!chan.isNull());
 
-    return featuresFor(ChannelClassSpec(chan->immutableProperties()));
+    Features features;
+
+    foreach (int i, mPriv->featuresMatcher().matchesChannel(chan->immutableProperties())) {
+        features.unite(mPriv->features.at(i).second);
+    }
+
+    return features;
 }
 
 } // Tp
@@ -33,6 +33,7 @@
 
 // For Q_DISABLE_COPY
 #include <QtGlobal>
+#include <QHash>
 #include <QString>
 #include <QVariantMap>
 
@@ -362,6 +363,9 @@ public:
     PendingReady *proxy(const ConnectionPtr &connection, const QString &channelPath,
             const QVariantMap &immutableProperties) const;
 
+    static QHash<QString, uint> avoidedRoundTrips();
+    static void resetAvoidedRoundTrips();
+
 protected:
     ChannelFactory(const QDBusConnection &bus);
 
@@ -26,9 +26,22 @@
 #include <TelepathyQt/Channel>
 #include <TelepathyQt/PendingOperation>
 
+#include <QHash>
+
 namespace Tp
 {
 
+class TP_QT_NO_EXPORT ChannelRoundTripCounters
+{
+public:
+    static void recordAvoided(const QString &channelType);
+    static QHash<QString, uint> avoided();
+    static void reset();
+
+private:
+    static QHash<QString, uint> &counters();
+};
+
 class TP_QT_NO_EXPORT Channel::PendingLeave : public PendingOperation
 {
     Q_OBJECT
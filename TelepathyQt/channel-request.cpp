@@ -102,7 +102,7 @@ ChannelRequest::Private::Private(ChannelRequest *parent,
       propertiesDone(false),
       gotSWC(false)
 {
-    debug() << "Creating new ChannelRequest:" << parent->objectPath();
+    tpDebug() << "Creating new ChannelRequest:" << parent->objectPath();
 
     parent->connect(baseInterface,
             SIGNAL(Failed(QString,QString)),
@@ -166,7 +166,7 @@ void ChannelRequest::Private::introspectMain(ChannelRequest::Private *self)
     }
 
     if (needIntrospectMainProps) {
-        debug() << "Calling Properties::GetAll(ChannelRequest)";
+        tpDebug() << "Calling Properties::GetAll(ChannelRequest)";
         QDBusPendingCallWatcher *watcher =
             new QDBusPendingCallWatcher(
                     self->properties->GetAll(TP_QT_IFACE_CHANNEL_REQUEST),
@@ -590,7 +590,7 @@ void ChannelRequest::gotMainProperties(QDBusPendingCallWatcher *watcher)
     QVariantMap props;
 
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(ChannelRequest)";
+        tpDebug() << "Got reply to Properties::GetAll(ChannelRequest)";
         props = reply.value();
 
         mPriv->extractMainProps(props, true);
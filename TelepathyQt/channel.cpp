@@ -57,6 +57,27 @@ namespace Tp
 using TpFuture::Client::ChannelInterfaceMergeableConferenceInterface;
 using TpFuture::Client::ChannelInterfaceSplittableInterface;
 
+QHash<QString, uint> &ChannelRoundTripCounters::counters()
+{
+    static QHash<QString, uint> counters;
+    return counters;
+}
+
+void ChannelRoundTripCounters::recordAvoided(const QString &channelType)
+{
+    ++counters()[channelType];
+}
+
+QHash<QString, uint> ChannelRoundTripCounters::avoided()
+{
+    return counters();
+}
+
+void ChannelRoundTripCounters::reset()
+{
+    counters().clear();
+}
+
 struct TP_QT_NO_EXPORT Channel::Private
 {
     Private(Channel *parent, const ConnectionPtr &connection,
@@ -78,21 +99,33 @@ struct TP_QT_NO_EXPORT Channel::Private
     static void introspectConferenceInitialInviteeContacts(Private *self);
 
     void continueIntrospection();
+    void introspectStepFinished();
+    static bool canIntrospectConcurrently(void (Private::*step)());
+
+    void recordAvoidedRoundTrip();
 
     void extractMainProps(const QVariantMap &props);
     void extract0176GroupProps(const QVariantMap &props);
+    void extractConferenceProps(const QVariantMap &props);
 
     void nowHaveInterfaces();
     void nowHaveInitialMembers();
 
     bool setGroupFlags(uint groupFlags);
 
+    UIntList handlesToBuild() const;
     void buildContacts();
+    bool lookupPrefetchedContacts(QList<ContactPtr> &contacts) const;
     void doMembersChangedDetailed(const UIntList &, const UIntList &, const UIntList &,
             const UIntList &, const QVariantMap &);
     void processMembersChanged();
     void updateContacts(const QList<ContactPtr> &contacts =
             QList<ContactPtr>());
+    void applyMembersChanged(const QList<ContactPtr> &contacts);
+    void emitGroupMembersChanged(const Contacts &added, const Contacts &localPendingAdded,
+            const Contacts &remotePendingAdded, const Contacts &removed,
+            const GroupMemberChangeDetails &details);
+    void flushGroupMembersChanged();
     bool fakeGroupInterfaceIfNeeded();
     void setReady();
 
@@ -139,6 +172,7 @@ struct TP_QT_NO_EXPORT Channel::Private
 
     // Introspection
     QQueue<void (Private::*)()> introspectQueue;
+    int introspectStepsInFlight;
 
     // Introspected properties
 
@@ -164,6 +198,18 @@ struct TP_QT_NO_EXPORT Channel::Private
     QQueue<GroupMembersChangedInfo *> groupMembersChangedQueue;
     GroupMembersChangedInfo *currentGroupMembersChangedInfo;
 
+    // MCD queue lookahead - contacts built ahead of time for the queued MCD signals and
+    // groupMembersChanged() emission being coalesced
+    bool groupMembersChangedBatching;
+    QHash<uint, ContactPtr> groupPrefetchedContacts;
+    QSet<uint> groupPrefetchedInvalidHandles;
+    bool groupMembersChangedSignalPending;
+    Contacts groupSignalMembersAdded;
+    Contacts groupSignalLocalPendingMembersAdded;
+    Contacts groupSignalRemotePendingMembersAdded;
+    Contacts groupSignalMembersRemoved;
+    GroupMemberChangeDetails groupSignalDetails;
+
     // Pending from the MCD signal currently processed, but contacts not yet built
     QSet<uint> pendingGroupMembers;
     QSet<uint> pendingGroupLocalPendingMembers;
@@ -269,6 +315,7 @@ Channel::Private::Private(Channel *parent, const ConnectionPtr &connection,
       group(0),
       conference(0),
       readinessHelper(parent->readinessHelper()),
+      introspectStepsInFlight(0),
       targetHandleType(0),
       targetHandle(0),
       requested(false),
@@ -278,6 +325,8 @@ Channel::Private::Private(Channel *parent, const ConnectionPtr &connection,
       groupHaveMembers(false),
       buildingContacts(false),
       currentGroupMembersChangedInfo(0),
+      groupMembersChangedBatching(false),
+      groupMembersChangedSignalPending(false),
       groupAreHandleOwnersAvailable(false),
       pendingRetrieveGroupSelfContact(false),
       groupIsSelfHandleTracked(false),
@@ -285,15 +334,15 @@ Channel::Private::Private(Channel *parent, const ConnectionPtr &connection,
       introspectingConference(false),
       buildingConferenceChannelRemovedActorContact(false)
 {
-    debug() << "Creating new Channel:" << parent->objectPath();
+    tpDebug() << "Creating new Channel:" << parent->objectPath();
 
     if (connection->isValid()) {
-        debug() << " Connecting to Channel::Closed() signal";
+        tpDebug() << " Connecting to Channel::Closed() signal";
         parent->connect(baseInterface,
                         SIGNAL(Closed()),
                         SLOT(onClosed()));
 
-        debug() << " Connection to owning connection's lifetime signals";
+        tpDebug() << " Connection to owning connection's lifetime signals";
         parent->connect(connection.data(),
                         SIGNAL(invalidated(Tp::DBusProxy*,QString,QString)),
                         SLOT(onConnectionInvalidated()));
@@ -344,7 +393,7 @@ void Channel::Private::introspectMain(Channel::Private *self)
 {
     // Make sure connection object is ready, as we need to use some methods that
     // are only available after connection object gets ready.
-    debug() << "Calling Connection::becomeReady()";
+    tpDebug() << "Calling Connection::becomeReady()";
     self->parent->connect(self->connection->becomeReady(),
             SIGNAL(finished(Tp::PendingOperation*)),
             SLOT(onConnectionReady(Tp::PendingOperation*)));
@@ -396,7 +445,7 @@ void Channel::Private::introspectMainProperties()
     }
 
     if (needIntrospectMainProps) {
-        debug() << "Calling Properties::GetAll(Channel)";
+        tpDebug() << "Calling Properties::GetAll(Channel)";
         QDBusPendingCallWatcher *watcher =
             new QDBusPendingCallWatcher(
                     properties->GetAll(TP_QT_IFACE_CHANNEL),
@@ -406,13 +455,16 @@ void Channel::Private::introspectMainProperties()
                 SLOT(gotMainProperties(QDBusPendingCallWatcher*)));
     } else {
         extractMainProps(props);
+        if (!channelType.isEmpty()) {
+            recordAvoidedRoundTrip();
+        }
         continueIntrospection();
     }
 }
 
 void Channel::Private::introspectMainFallbackChannelType()
 {
-    debug() << "Calling Channel::GetChannelType()";
+    tpDebug() << "Calling Channel::GetChannelType()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetChannelType(), parent);
     parent->connect(watcher,
@@ -422,7 +474,7 @@ void Channel::Private::introspectMainFallbackChannelType()
 
 void Channel::Private::introspectMainFallbackHandle()
 {
-    debug() << "Calling Channel::GetHandle()";
+    tpDebug() << "Calling Channel::GetHandle()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetHandle(), parent);
     parent->connect(watcher,
@@ -432,7 +484,7 @@ void Channel::Private::introspectMainFallbackHandle()
 
 void Channel::Private::introspectMainFallbackInterfaces()
 {
-    debug() << "Calling Channel::GetInterfaces()";
+    tpDebug() << "Calling Channel::GetInterfaces()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetInterfaces(), parent);
     parent->connect(watcher,
@@ -449,7 +501,7 @@ void Channel::Private::introspectGroup()
         Q_ASSERT(group != 0);
     }
 
-    debug() << "Introspecting Channel.Interface.Group for" << parent->objectPath();
+    tpDebug() << "Introspecting Channel.Interface.Group for" << parent->objectPath();
 
     parent->connect(group,
                     SIGNAL(GroupFlagsChanged(uint,uint)),
@@ -480,7 +532,9 @@ void Channel::Private::introspectGroup()
                     SIGNAL(SelfHandleChanged(uint)),
                     SLOT(onSelfHandleChanged(uint)));
 
-    debug() << "Calling Properties::GetAll(Channel.Interface.Group)";
+    // All of the Group properties can change, so the ones which might have been supplied with the
+    // channel may already be stale and the change signals for them could have been missed
+    tpDebug() << "Calling Properties::GetAll(Channel.Interface.Group)";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(
                 properties->GetAll(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP),
@@ -494,7 +548,7 @@ void Channel::Private::introspectGroupFallbackFlags()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetGroupFlags()";
+    tpDebug() << "Calling Channel.Interface.Group::GetGroupFlags()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetGroupFlags(), parent);
     parent->connect(watcher,
@@ -506,7 +560,7 @@ void Channel::Private::introspectGroupFallbackMembers()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetAllMembers()";
+    tpDebug() << "Calling Channel.Interface.Group::GetAllMembers()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetAllMembers(), parent);
     parent->connect(watcher,
@@ -518,7 +572,7 @@ void Channel::Private::introspectGroupFallbackLocalPendingWithInfo()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetLocalPendingMembersWithInfo()";
+    tpDebug() << "Calling Channel.Interface.Group::GetLocalPendingMembersWithInfo()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetLocalPendingMembersWithInfo(),
                 parent);
@@ -531,7 +585,7 @@ void Channel::Private::introspectGroupFallbackSelfHandle()
 {
     Q_ASSERT(group != 0);
 
-    debug() << "Calling Channel.Interface.Group::GetSelfHandle()";
+    tpDebug() << "Calling Channel.Interface.Group::GetSelfHandle()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(group->GetSelfHandle(), parent);
     parent->connect(watcher,
@@ -544,13 +598,13 @@ void Channel::Private::introspectConference()
     Q_ASSERT(properties != 0);
     Q_ASSERT(conference == 0);
 
-    debug() << "Introspecting Conference interface";
+    tpDebug() << "Introspecting Conference interface";
     conference = parent->interface<Client::ChannelInterfaceConferenceInterface>();
     Q_ASSERT(conference != 0);
 
     introspectingConference = true;
 
-    debug() << "Connecting to Channel.Interface.Conference.ChannelMerged/Removed";
+    tpDebug() << "Connecting to Channel.Interface.Conference.ChannelMerged/Removed";
     parent->connect(conference,
             SIGNAL(ChannelMerged(QDBusObjectPath,uint,QVariantMap)),
             SLOT(onConferenceChannelMerged(QDBusObjectPath,uint,QVariantMap)));
@@ -558,7 +612,7 @@ void Channel::Private::introspectConference()
             SIGNAL(ChannelRemoved(QDBusObjectPath,QVariantMap)),
             SLOT(onConferenceChannelRemoved(QDBusObjectPath,QVariantMap)));
 
-    debug() << "Calling Properties::GetAll(Channel.Interface.Conference)";
+    tpDebug() << "Calling Properties::GetAll(Channel.Interface.Conference)";
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
             properties->GetAll(TP_QT_IFACE_CHANNEL_INTERFACE_CONFERENCE),
             parent);
@@ -582,24 +636,66 @@ void Channel::Private::introspectConferenceInitialInviteeContacts(Private *self)
     }
 }
 
+bool Channel::Private::canIntrospectConcurrently(void (Private::*step)())
+{
+    // The fallback getters for the main properties don't depend on each other, and neither do the
+    // group and conference properties
+    return step == &Private::introspectMainFallbackChannelType ||
+        step == &Private::introspectMainFallbackHandle ||
+        step == &Private::introspectMainFallbackInterfaces ||
+        step == &Private::introspectGroup ||
+        step == &Private::introspectConference;
+}
+
 void Channel::Private::continueIntrospection()
 {
+    if (introspectStepsInFlight > 0) {
+        // the steps still running will continue the introspection once they're done
+        return;
+    }
+
     if (introspectQueue.isEmpty()) {
         // this should always be true, but let's make sure
         if (!parent->isReady(Channel::FeatureCore)) {
             if (groupMembersChangedQueue.isEmpty() && !buildingContacts &&
                 !introspectingConference) {
-                debug() << "Both the IS and the MCD queue empty for the first time. Ready.";
+                tpDebug() << "Both the IS and the MCD queue empty for the first time. Ready.";
                 setReady();
             } else {
-                debug() << "Introspection done before contacts done - contacts sets ready";
+                tpDebug() << "Introspection done before contacts done - contacts sets ready";
             }
         }
     } else {
-        (this->*(introspectQueue.dequeue()))();
+        // Start the next step, along with the ones following it which don't depend on it. Steps
+        // queued while these are running only start after all of them are done.
+        void (Private::*step)() = introspectQueue.dequeue();
+        QList<void (Private::*)()> steps;
+        steps.append(step);
+        while (canIntrospectConcurrently(step) && !introspectQueue.isEmpty() &&
+                canIntrospectConcurrently(introspectQueue.head())) {
+            step = introspectQueue.dequeue();
+            steps.append(step);
+        }
+
+        introspectStepsInFlight = steps.size();
+        foreach (step, steps) {
+            (this->*step)();
+        }
     }
 }
 
+void Channel::Private::introspectStepFinished()
+{
+    Q_ASSERT(introspectStepsInFlight > 0);
+    --introspectStepsInFlight;
+    continueIntrospection();
+}
+
+void Channel::Private::recordAvoidedRoundTrip()
+{
+    ChannelRoundTripCounters::recordAvoided(channelType);
+}
+
 void Channel::Private::extractMainProps(const QVariantMap &props)
 {
     const static QString keyChannelType(QLatin1String("ChannelType"));
@@ -666,7 +762,7 @@ void Channel::Private::extractMainProps(const QVariantMap &props)
         nowHaveInterfaces();
     }
 
-    debug() << "Have initiator handle:" << (initiatorHandle ? "yes" : "no");
+    tpDebug() << "Have initiator handle:" << (initiatorHandle ? "yes" : "no");
 }
 
 void Channel::Private::extract0176GroupProps(const QVariantMap &props)
@@ -697,7 +793,7 @@ void Channel::Private::extract0176GroupProps(const QVariantMap &props)
         introspectQueue.enqueue(&Private::introspectGroupFallbackLocalPendingWithInfo);
         introspectQueue.enqueue(&Private::introspectGroupFallbackSelfHandle);
     } else {
-        debug() << " Found properties specified in 0.17.6";
+        tpDebug() << " Found properties specified in 0.17.6";
 
         groupAreHandleOwnersAvailable = true;
         groupIsSelfHandleTracked = true;
@@ -719,9 +815,72 @@ void Channel::Private::extract0176GroupProps(const QVariantMap &props)
     }
 }
 
+void Channel::Private::extractConferenceProps(const QVariantMap &props)
+{
+    ChannelFactoryConstPtr chanFactory = connection->channelFactory();
+
+    ObjectPathList channels =
+        qdbus_cast<ObjectPathList>(props[QLatin1String("Channels")]);
+    foreach (const QDBusObjectPath &channelPath, channels) {
+        if (conferenceChannels.contains(channelPath.path())) {
+            continue;
+        }
+
+        PendingReady *readyOp = chanFactory->proxy(connection,
+                channelPath.path(), QVariantMap());
+        ChannelPtr channel(ChannelPtr::qObjectCast(readyOp->proxy()));
+        Q_ASSERT(!channel.isNull());
+
+        conferenceChannels.insert(channelPath.path(), channel);
+    }
+
+    ObjectPathList initialChannels =
+        qdbus_cast<ObjectPathList>(props[QLatin1String("InitialChannels")]);
+    foreach (const QDBusObjectPath &channelPath, initialChannels) {
+        if (conferenceInitialChannels.contains(channelPath.path())) {
+            continue;
+        }
+
+        PendingReady *readyOp = chanFactory->proxy(connection,
+                channelPath.path(), QVariantMap());
+        ChannelPtr channel(ChannelPtr::qObjectCast(readyOp->proxy()));
+        Q_ASSERT(!channel.isNull());
+
+        conferenceInitialChannels.insert(channelPath.path(), channel);
+    }
+
+    conferenceInitialInviteeHandles =
+        qdbus_cast<UIntList>(props[QLatin1String("InitialInviteeHandles")]);
+    QStringList conferenceInitialInviteeIds =
+        qdbus_cast<QStringList>(props[QLatin1String("InitialInviteeIDs")]);
+    if (conferenceInitialInviteeHandles.size() == conferenceInitialInviteeIds.size()) {
+        HandleIdentifierMap contactIds;
+        int i = 0;
+        foreach (uint handle, conferenceInitialInviteeHandles) {
+            contactIds.insert(handle, conferenceInitialInviteeIds.at(i++));
+        }
+        connection->lowlevel()->injectContactIds(contactIds);
+    }
+
+    conferenceInvitationMessage =
+        qdbus_cast<QString>(props[QLatin1String("InvitationMessage")]);
+
+    ChannelOriginatorMap originalChannels = qdbus_cast<ChannelOriginatorMap>(
+            props[QLatin1String("OriginalChannels")]);
+    for (ChannelOriginatorMap::const_iterator i = originalChannels.constBegin();
+            i != originalChannels.constEnd(); ++i) {
+        PendingReady *readyOp = chanFactory->proxy(connection,
+                i.value().path(), QVariantMap());
+        ChannelPtr channel(ChannelPtr::qObjectCast(readyOp->proxy()));
+        Q_ASSERT(!channel.isNull());
+
+        conferenceOriginalChannels.insert(i.key(), channel);
+    }
+}
+
 void Channel::Private::nowHaveInterfaces()
 {
-    debug() << "Channel has" << parent->interfaces().size() <<
+    tpDebug() << "Channel has" << parent->interfaces().size() <<
         "optional interfaces:" << parent->interfaces();
 
     QStringList interfaces = parent->interfaces();
@@ -801,7 +960,7 @@ bool Channel::Private::setGroupFlags(uint newGroupFlags)
     if ((groupFlags & ChannelGroupFlagMembersChangedDetailed) &&
         !usingMembersChangedDetailed) {
         usingMembersChangedDetailed = true;
-        debug() << "Starting to exclusively listen to MembersChangedDetailed for" <<
+        tpDebug() << "Starting to exclusively listen to MembersChangedDetailed for" <<
             parent->objectPath();
         parent->disconnect(group,
                            SIGNAL(MembersChanged(QString,Tp::UIntList,
@@ -828,11 +987,8 @@ bool Channel::Private::setGroupFlags(uint newGroupFlags)
     return true;
 }
 
-void Channel::Private::buildContacts()
+UIntList Channel::Private::handlesToBuild() const
 {
-    buildingContacts = true;
-
-    ContactManagerPtr manager = connection->contactManager();
     UIntList toBuild = QSet<uint>(pendingGroupMembers +
             pendingGroupLocalPendingMembers +
             pendingGroupRemotePendingMembers).toList();
@@ -858,6 +1014,16 @@ void Channel::Private::buildContacts()
         toBuild.append(groupSelfHandle);
     }
 
+    return toBuild;
+}
+
+void Channel::Private::buildContacts()
+{
+    buildingContacts = true;
+
+    ContactManagerPtr manager = connection->contactManager();
+    UIntList toBuild = handlesToBuild();
+
     // group self handle changed to 0 <- strange but it may happen, and contacts
     // were being built at the time, so check now
     if (toBuild.isEmpty()) {
@@ -872,6 +1038,21 @@ void Channel::Private::buildContacts()
         return;
     }
 
+    if (groupMembersChangedBatching && !groupMembersChangedQueue.isEmpty()) {
+        // Build the contacts for all the queued MCD signals in the same round-trip, so they can
+        // be applied one after the other without waiting for the connection again
+        foreach (const GroupMembersChangedInfo *info, groupMembersChangedQueue) {
+            toBuild << info->added << info->localPending << info->remotePending;
+            if (info->actor != 0) {
+                toBuild.append(info->actor);
+            }
+        }
+        toBuild = toBuild.toSet().toList();
+
+        tpDebug() << "Building contacts for" << groupMembersChangedQueue.size() + 1 <<
+            "MCD signals at once";
+    }
+
     PendingContacts *pendingContacts = manager->contactsForHandles(
             toBuild);
     parent->connect(pendingContacts,
@@ -879,92 +1060,131 @@ void Channel::Private::buildContacts()
             SLOT(gotContacts(Tp::PendingOperation*)));
 }
 
+bool Channel::Private::lookupPrefetchedContacts(QList<ContactPtr> &contacts) const
+{
+    UIntList toBuild = handlesToBuild();
+    if (toBuild.isEmpty()) {
+        return false;
+    }
+
+    foreach (uint handle, toBuild) {
+        if (groupPrefetchedContacts.contains(handle)) {
+            contacts.append(groupPrefetchedContacts.value(handle));
+        } else if (handle == groupSelfHandle || !groupPrefetchedInvalidHandles.contains(handle)) {
+            // let gotContacts() deal with the self handle being invalid
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void Channel::Private::processMembersChanged()
 {
     Q_ASSERT(!buildingContacts);
 
-    if (groupMembersChangedQueue.isEmpty()) {
-        if (pendingRetrieveGroupSelfContact) {
-            pendingRetrieveGroupSelfContact = false;
-            // nothing queued but selfContact changed
-            buildContacts();
-            return;
-        }
+    while (!groupMembersChangedQueue.isEmpty()) {
+        Q_ASSERT(pendingGroupMembers.isEmpty());
+        Q_ASSERT(pendingGroupLocalPendingMembers.isEmpty());
+        Q_ASSERT(pendingGroupRemotePendingMembers.isEmpty());
 
-        if (!parent->isReady(Channel::FeatureCore)) {
-            if (introspectQueue.isEmpty()) {
-                debug() << "Both the MCD and the introspect queue empty for the first time. Ready!";
+        // always set this to false here, as buildContacts will always try to
+        // retrieve the selfContact and updateContacts will check if the built
+        // contact is the same as the current contact.
+        pendingRetrieveGroupSelfContact = false;
 
-                if (initiatorHandle && !initiatorContact) {
-                    warning() << " Unable to create contact object for initiator with handle" <<
-                        initiatorHandle;
-                }
+        currentGroupMembersChangedInfo = groupMembersChangedQueue.dequeue();
 
-                if (targetHandleType == HandleTypeContact && targetHandle != 0 && !targetContact) {
-                    warning() << " Unable to create contact object for target with handle" <<
-                        targetHandle;
-                }
+        foreach (uint handle, currentGroupMembersChangedInfo->added) {
+            if (!groupContacts.contains(handle)) {
+                pendingGroupMembers.insert(handle);
+            }
 
-                if (groupSelfHandle && !groupSelfContact) {
-                    warning() << " Unable to create contact object for self handle" <<
-                        groupSelfHandle;
-                }
+            // the member was added to current members, check if it was in the
+            // local/pending lists and if true, schedule for removal from that list
+            if (groupLocalPendingContacts.contains(handle)) {
+                groupLocalPendingMembersToRemove.append(handle);
+            } else if(groupRemotePendingContacts.contains(handle)) {
+                groupRemotePendingMembersToRemove.append(handle);
+            }
+        }
 
-                continueIntrospection();
-            } else {
-                debug() << "Contact queue empty but introspect queue isn't. IS will set ready.";
+        foreach (uint handle, currentGroupMembersChangedInfo->localPending) {
+            if (!groupLocalPendingContacts.contains(handle)) {
+                pendingGroupLocalPendingMembers.insert(handle);
+            }
+        }
+
+        foreach (uint handle, currentGroupMembersChangedInfo->remotePending) {
+            if (!groupRemotePendingContacts.contains(handle)) {
+                pendingGroupRemotePendingMembers.insert(handle);
             }
         }
 
+        foreach (uint handle, currentGroupMembersChangedInfo->removed) {
+            groupMembersToRemove.append(handle);
+        }
+
+        QList<ContactPtr> contacts;
+        if (groupMembersChangedBatching && lookupPrefetchedContacts(contacts)) {
+            // All the contacts were built along with an earlier MCD signal
+            applyMembersChanged(contacts);
+            continue;
+        }
+
+        flushGroupMembersChanged();
+
+        // Always go through buildContacts - we might have a self/initiator/whatever handle to build
+        buildContacts();
         return;
     }
 
-    Q_ASSERT(pendingGroupMembers.isEmpty());
-    Q_ASSERT(pendingGroupLocalPendingMembers.isEmpty());
-    Q_ASSERT(pendingGroupRemotePendingMembers.isEmpty());
+    flushGroupMembersChanged();
+    groupPrefetchedContacts.clear();
+    groupPrefetchedInvalidHandles.clear();
 
-    // always set this to false here, as buildContacts will always try to
-    // retrieve the selfContact and updateContacts will check if the built
-    // contact is the same as the current contact.
-    pendingRetrieveGroupSelfContact = false;
+    if (pendingRetrieveGroupSelfContact) {
+        pendingRetrieveGroupSelfContact = false;
+        // nothing queued but selfContact changed
+        buildContacts();
+        return;
+    }
 
-    currentGroupMembersChangedInfo = groupMembersChangedQueue.dequeue();
+    if (!parent->isReady(Channel::FeatureCore)) {
+        if (introspectQueue.isEmpty()) {
+            TP_QT_DEBUG(DebugCategoryChannel) <<
+                "Both the MCD and the introspect queue empty for the first time. Ready!";
 
-    foreach (uint handle, currentGroupMembersChangedInfo->added) {
-        if (!groupContacts.contains(handle)) {
-            pendingGroupMembers.insert(handle);
-        }
+            if (initiatorHandle && !initiatorContact) {
+                warning() << " Unable to create contact object for initiator with handle" <<
+                    initiatorHandle;
+            }
 
-        // the member was added to current members, check if it was in the
-        // local/pending lists and if true, schedule for removal from that list
-        if (groupLocalPendingContacts.contains(handle)) {
-            groupLocalPendingMembersToRemove.append(handle);
-        } else if(groupRemotePendingContacts.contains(handle)) {
-            groupRemotePendingMembersToRemove.append(handle);
-        }
-    }
+            if (targetHandleType == HandleTypeContact && targetHandle != 0 && !targetContact) {
+                warning() << " Unable to create contact object for target with handle" <<
+                    targetHandle;
+            }
 
-    foreach (uint handle, currentGroupMembersChangedInfo->localPending) {
-        if (!groupLocalPendingContacts.contains(handle)) {
-            pendingGroupLocalPendingMembers.insert(handle);
-        }
-    }
+            if (groupSelfHandle && !groupSelfContact) {
+                warning() << " Unable to create contact object for self handle" <<
+                    groupSelfHandle;
+            }
 
-    foreach (uint handle, currentGroupMembersChangedInfo->remotePending) {
-        if (!groupRemotePendingContacts.contains(handle)) {
-            pendingGroupRemotePendingMembers.insert(handle);
+            continueIntrospection();
+        } else {
+            TP_QT_DEBUG(DebugCategoryChannel) <<
+                "Contact queue empty but introspect queue isn't. IS will set ready.";
         }
     }
-
-    foreach (uint handle, currentGroupMembersChangedInfo->removed) {
-        groupMembersToRemove.append(handle);
-    }
-
-    // Always go through buildContacts - we might have a self/initiator/whatever handle to build
-    buildContacts();
 }
 
 void Channel::Private::updateContacts(const QList<ContactPtr> &contacts)
+{
+    applyMembersChanged(contacts);
+    processMembersChanged();
+}
+
+void Channel::Private::applyMembersChanged(const QList<ContactPtr> &contacts)
 {
     Contacts groupContactsAdded;
     Contacts groupLocalPendingContactsAdded;
@@ -972,7 +1192,8 @@ void Channel::Private::updateContacts(const QList<ContactPtr> &contacts)
     ContactPtr actorContact;
     bool selfContactUpdated = false;
 
-    debug() << "Entering Chan::Priv::updateContacts() with" << contacts.size() << "contacts";
+    TP_QT_DEBUG(DebugCategoryChannel) <<
+        "Entering Chan::Priv::updateContacts() with" << contacts.size() << "contacts";
 
     // FIXME: simplify. Some duplication of logic present.
     foreach (ContactPtr contact, contacts) {
@@ -1091,7 +1312,7 @@ void Channel::Private::updateContacts(const QList<ContactPtr> &contacts)
         if (parent->isReady(Channel::FeatureCore)) {
             // Channel is ready, we can signal membership changes to the outside world without
             // confusing anyone's fragile logic.
-            emit parent->groupMembersChanged(
+            emitGroupMembersChanged(
                     groupContactsAdded,
                     groupLocalPendingContactsAdded,
                     groupRemotePendingContactsAdded,
@@ -1103,10 +1324,67 @@ void Channel::Private::updateContacts(const QList<ContactPtr> &contacts)
     currentGroupMembersChangedInfo = 0;
 
     if (selfContactUpdated && parent->isReady(Channel::FeatureCore)) {
+        flushGroupMembersChanged();
         emit parent->groupSelfContactChanged();
     }
+}
 
-    processMembersChanged();
+void Channel::Private::emitGroupMembersChanged(const Contacts &added,
+        const Contacts &localPendingAdded, const Contacts &remotePendingAdded,
+        const Contacts &removed, const GroupMemberChangeDetails &details)
+{
+    if (!groupMembersChangedBatching) {
+        // batching may just have been disabled
+        flushGroupMembersChanged();
+        emit parent->groupMembersChanged(added, localPendingAdded, remotePendingAdded,
+                removed, details);
+        return;
+    }
+
+    if (groupMembersChangedSignalPending) {
+        // Only merge changes made for the same reason which don't touch any of the contacts
+        // already changed, so that no intermediate state is lost
+        Contacts changed = added + localPendingAdded + remotePendingAdded + removed;
+        Contacts alreadyChanged = groupSignalMembersAdded +
+            groupSignalLocalPendingMembersAdded +
+            groupSignalRemotePendingMembersAdded +
+            groupSignalMembersRemoved;
+        if (details.actor() != groupSignalDetails.actor() ||
+            details.allDetails() != groupSignalDetails.allDetails() ||
+            changed.intersect(alreadyChanged).size() > 0) {
+            flushGroupMembersChanged();
+        }
+    }
+
+    groupSignalMembersAdded.unite(added);
+    groupSignalLocalPendingMembersAdded.unite(localPendingAdded);
+    groupSignalRemotePendingMembersAdded.unite(remotePendingAdded);
+    groupSignalMembersRemoved.unite(removed);
+    groupSignalDetails = details;
+    groupMembersChangedSignalPending = true;
+}
+
+void Channel::Private::flushGroupMembersChanged()
+{
+    if (!groupMembersChangedSignalPending) {
+        return;
+    }
+
+    Contacts added = groupSignalMembersAdded;
+    Contacts localPendingAdded = groupSignalLocalPendingMembersAdded;
+    Contacts remotePendingAdded = groupSignalRemotePendingMembersAdded;
+    Contacts removed = groupSignalMembersRemoved;
+    GroupMemberChangeDetails details = groupSignalDetails;
+
+    groupMembersChangedSignalPending = false;
+    groupSignalMembersAdded.clear();
+    groupSignalLocalPendingMembersAdded.clear();
+    groupSignalRemotePendingMembersAdded.clear();
+    groupSignalMembersRemoved.clear();
+    groupSignalDetails = GroupMemberChangeDetails();
+
+    emit parent->groupMembersChanged(added, localPendingAdded, remotePendingAdded,
+            removed, details);
 }
 
 bool Channel::Private::fakeGroupInterfaceIfNeeded()
@@ -1124,7 +1402,7 @@ bool Channel::Private::fakeGroupInterfaceIfNeeded()
         groupSelfHandle = connection->selfHandle();
         groupInitialMembers = UIntList() << groupSelfHandle << targetHandle;
 
-        debug().nospace() << "Faking a group on channel with self handle=" <<
+        tpDebug().nospace() << "Faking a group on channel with self handle=" <<
             groupSelfHandle << " and other handle=" << targetHandle;
 
         nowHaveInitialMembers();
@@ -1140,27 +1418,27 @@ void Channel::Private::setReady()
 {
     Q_ASSERT(!parent->isReady(Channel::FeatureCore));
 
-    debug() << "Channel fully ready";
-    debug() << " Channel type" << channelType;
-    debug() << " Target handle" << targetHandle;
-    debug() << " Target handle type" << targetHandleType;
+    tpDebug() << "Channel fully ready";
+    tpDebug() << " Channel type" << channelType;
+    tpDebug() << " Target handle" << targetHandle;
+    tpDebug() << " Target handle type" << targetHandleType;
 
     if (parent->interfaces().contains(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP)) {
-        debug() << " Group: flags" << groupFlags;
+        tpDebug() << " Group: flags" << groupFlags;
         if (groupAreHandleOwnersAvailable) {
-            debug() << " Group: Number of handle owner mappings" <<
+            tpDebug() << " Group: Number of handle owner mappings" <<
                 groupHandleOwners.size();
         }
         else {
-            debug() << " Group: No handle owners property present";
+            tpDebug() << " Group: No handle owners property present";
         }
-        debug() << " Group: Number of current members" <<
+        tpDebug() << " Group: Number of current members" <<
             groupContacts.size();
-        debug() << " Group: Number of local pending members" <<
+        tpDebug() << " Group: Number of local pending members" <<
             groupLocalPendingContacts.size();
-        debug() << " Group: Number of remote pending members" <<
+        tpDebug() << " Group: Number of remote pending members" <<
             groupRemotePendingContacts.size();
-        debug() << " Group: Self handle" << groupSelfHandle <<
+        tpDebug() << " Group: Self handle" << groupSelfHandle <<
             "tracked:" << (groupIsSelfHandleTracked ? "yes" : "no");
     }
 
@@ -1861,7 +2139,7 @@ void Channel::PendingLeave::onChanInvalidated(Tp::DBusProxy *proxy)
         return;
     }
 
-    debug() << "Finishing PendingLeave successfully as the channel was invalidated";
+    tpDebug() << "Finishing PendingLeave successfully as the channel was invalidated";
 
     setFinished();
 }
@@ -1875,14 +2153,14 @@ void Channel::PendingLeave::onRemoveFinished(Tp::PendingOperation *op)
     ChannelPtr chan = ChannelPtr::staticCast(object());
 
     if (op->isValid()) {
-        debug() << "We left the channel" << chan->objectPath();
+        tpDebug() << "We left the channel" << chan->objectPath();
 
         ContactPtr c = chan->groupSelfContact();
 
         if (chan->groupContacts().contains(c)
                 || chan->groupLocalPendingContacts().contains(c)
                 || chan->groupRemotePendingContacts().contains(c)) {
-            debug() << "Waiting for self remove to be picked up";
+            tpDebug() << "Waiting for self remove to be picked up";
             connect(chan.data(),
                     SIGNAL(groupMembersChanged(Tp::Contacts,Tp::Contacts,Tp::Contacts,Tp::Contacts,
                             Tp::Channel::GroupMemberChangeDetails)),
@@ -1895,8 +2173,8 @@ void Channel::PendingLeave::onRemoveFinished(Tp::PendingOperation *op)
         return;
     }
 
-    debug() << "Leave RemoveMembersWithReason failed with " << op->errorName() << op->errorMessage()
-        << "- falling back to Close";
+    tpDebug() << "Leave RemoveMembersWithReason failed with " << op->errorName() <<
+        op->errorMessage() << "- falling back to Close";
 
     // If the channel has been closed or otherwise invalidated already in this mainloop iteration,
     // the requestClose() operation will early-succeed
@@ -1917,7 +2195,7 @@ void Channel::PendingLeave::onMembersChanged(const Tp::Contacts &, const Tp::Con
     ContactPtr c = chan->groupSelfContact();
 
     if (removed.contains(c)) {
-        debug() << "Leave event picked up for" << chan->objectPath();
+        tpDebug() << "Leave event picked up for" << chan->objectPath();
         setFinished();
     }
 }
@@ -1936,7 +2214,7 @@ void Channel::PendingLeave::onCloseFinished(Tp::PendingOperation *op)
             << op->errorName() << op->errorMessage() << "- so didn't leave";
         setFinishedWithError(op->errorName(), op->errorMessage());
     } else {
-        debug() << "We left (by closing) the channel" << chan->objectPath();
+        tpDebug() << "We left (by closing) the channel" << chan->objectPath();
         setFinished();
     }
 }
@@ -1986,7 +2264,7 @@ PendingOperation *Channel::requestLeave(const QString &message, ChannelGroupChan
 
     if (!groupContacts().contains(self) && !groupLocalPendingContacts().contains(self)
             && !groupRemotePendingContacts().contains(self)) {
-        debug() << "Channel::requestLeave() called for " << objectPath() <<
+        tpDebug() << "Channel::requestLeave() called for " << objectPath() <<
             "which we aren't a member of";
         return new PendingSuccess(ChannelPtr(this));
     }
@@ -2615,6 +2893,41 @@ ContactPtr Channel::groupSelfContact() const
     return mPriv->groupSelfContact;
 }
 
+/**
+ * Return whether group membership changes are processed in batches.
+ *
+ * \return \c true if batching is enabled, \c false otherwise.
+ * \sa setGroupMembersChangedBatchingEnabled()
+ */
+bool Channel::isGroupMembersChangedBatchingEnabled() const
+{
+    return mPriv->groupMembersChangedBatching;
+}
+
+/**
+ * Set whether group membership changes should be processed in batches.
+ *
+ * By default, each membership change signalled by the remote object is processed on its own:
+ * the Contact objects for the handles involved are built, the change is applied and
+ * groupMembersChanged() is emitted, and only then the next change is looked at.
+ *
+ * With batching enabled, the Contact objects for all the queued membership changes are built
+ * at once, and the changes are then applied one after the other without further round-trips.
+ * Consecutive changes made for the same reason (the same actor and details) and involving
+ * different contacts are signalled with a single groupMembersChanged() emission. Changes are
+ * still applied and signalled in the order they were received.
+ *
+ * This is mostly useful for channels with a large number of members and frequent membership
+ * changes, such as big chat rooms.
+ *
+ * \param enabled Whether to enable batching.
+ * \sa groupMembersChanged()
+ */
+void Channel::setGroupMembersChangedBatchingEnabled(bool enabled)
+{
+    mPriv->groupMembersChangedBatching = enabled;
+}
+
 /**
  * Return whether the local user is in the "local pending" state. This
  * indicates that the local user needs to take action to accept an invitation,
@@ -2866,7 +3179,7 @@ void Channel::gotMainProperties(QDBusPendingCallWatcher *watcher)
     QVariantMap props;
 
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(Channel)";
+        tpDebug() << "Got reply to Properties::GetAll(Channel)";
         props = reply.value();
     } else {
         warning().nospace() << "Properties::GetAll(Channel) failed with " <<
@@ -2890,9 +3203,9 @@ void Channel::gotChannelType(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to fallback Channel::GetChannelType()";
+    tpDebug() << "Got reply to fallback Channel::GetChannelType()";
     mPriv->channelType = reply.value();
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotHandle(QDBusPendingCallWatcher *watcher)
@@ -2907,10 +3220,10 @@ void Channel::gotHandle(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to fallback Channel::GetHandle()";
+    tpDebug() << "Got reply to fallback Channel::GetHandle()";
     mPriv->targetHandleType = reply.argumentAt<0>();
     mPriv->targetHandle = reply.argumentAt<1>();
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotInterfaces(QDBusPendingCallWatcher *watcher)
@@ -2925,19 +3238,19 @@ void Channel::gotInterfaces(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to fallback Channel::GetInterfaces()";
+    tpDebug() << "Got reply to fallback Channel::GetInterfaces()";
     setInterfaces(reply.value());
     mPriv->readinessHelper->setInterfaces(interfaces());
     mPriv->nowHaveInterfaces();
 
     mPriv->fakeGroupInterfaceIfNeeded();
 
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::onClosed()
 {
-    debug() << "Got Channel::Closed";
+    tpDebug() << "Got Channel::Closed";
 
     QString error;
     QString message;
@@ -2981,7 +3294,7 @@ void Channel::onConnectionReady(PendingOperation *op)
 
 void Channel::onConnectionInvalidated()
 {
-    debug() << "Owning connection died leaving an orphan Channel, "
+    tpDebug() << "Owning connection died leaving an orphan Channel, "
         "changing to closed";
     invalidate(TP_QT_ERROR_ORPHANED,
                QLatin1String("Connection given as the owner of this channel was invalidated"));
@@ -2993,7 +3306,7 @@ void Channel::gotGroupProperties(QDBusPendingCallWatcher *watcher)
     QVariantMap props;
 
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(Channel.Interface.Group)";
+        tpDebug() << "Got reply to Properties::GetAll(Channel.Interface.Group)";
         props = reply.value();
     }
     else {
@@ -3005,7 +3318,7 @@ void Channel::gotGroupProperties(QDBusPendingCallWatcher *watcher)
     mPriv->extract0176GroupProps(props);
     // Add extraction (and possible fallbacks) in similar functions, called from here
 
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotGroupFlags(QDBusPendingCallWatcher *watcher)
@@ -3017,7 +3330,7 @@ void Channel::gotGroupFlags(QDBusPendingCallWatcher *watcher)
             reply.error().name() << ": " << reply.error().message();
     }
     else {
-        debug() << "Got reply to fallback Channel.Interface.Group::GetGroupFlags()";
+        tpDebug() << "Got reply to fallback Channel.Interface.Group::GetGroupFlags()";
         mPriv->setGroupFlags(reply.value());
 
         if (mPriv->groupFlags & ChannelGroupFlagProperties) {
@@ -3027,7 +3340,7 @@ void Channel::gotGroupFlags(QDBusPendingCallWatcher *watcher)
         }
     }
 
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotAllMembers(QDBusPendingCallWatcher *watcher)
@@ -3038,7 +3351,7 @@ void Channel::gotAllMembers(QDBusPendingCallWatcher *watcher)
         warning().nospace() << "Channel.Interface.Group::GetAllMembers() failed with " <<
             reply.error().name() << ": " << reply.error().message();
     } else {
-        debug() << "Got reply to fallback Channel.Interface.Group::GetAllMembers()";
+        tpDebug() << "Got reply to fallback Channel.Interface.Group::GetAllMembers()";
 
         mPriv->groupInitialMembers = reply.argumentAt<0>();
         mPriv->groupInitialRP = reply.argumentAt<2>();
@@ -3050,7 +3363,7 @@ void Channel::gotAllMembers(QDBusPendingCallWatcher *watcher)
         }
     }
 
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotLocalPendingMembersWithInfo(QDBusPendingCallWatcher *watcher)
@@ -3063,13 +3376,13 @@ void Channel::gotLocalPendingMembersWithInfo(QDBusPendingCallWatcher *watcher)
         warning() << " Falling back to what GetAllMembers returned with no extended info";
     }
     else {
-        debug() << "Got reply to fallback "
+        tpDebug() << "Got reply to fallback "
             "Channel.Interface.Group::GetLocalPendingMembersWithInfo()";
         // Overrides the previous vague list provided by gotAllMembers
         mPriv->groupInitialLP = reply.value();
     }
 
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotSelfHandle(QDBusPendingCallWatcher *watcher)
@@ -3080,7 +3393,7 @@ void Channel::gotSelfHandle(QDBusPendingCallWatcher *watcher)
         warning().nospace() << "Channel.Interface.Group::GetSelfHandle() failed with " <<
             reply.error().name() << ": " << reply.error().message();
     } else {
-        debug() << "Got reply to fallback Channel.Interface.Group::GetSelfHandle()";
+        tpDebug() << "Got reply to fallback Channel.Interface.Group::GetSelfHandle()";
         // Don't overwrite the self handle we got from the connection with 0
         if (reply.value()) {
             mPriv->groupSelfHandle = reply.value();
@@ -3089,7 +3402,7 @@ void Channel::gotSelfHandle(QDBusPendingCallWatcher *watcher)
 
     mPriv->nowHaveInitialMembers();
 
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotContacts(PendingOperation *op)
@@ -3102,6 +3415,22 @@ void Channel::gotContacts(PendingOperation *op)
     if (pending->isValid()) {
         contacts = pending->contacts();
 
+        if (mPriv->groupMembersChangedBatching) {
+            // The contacts for the queued MCD signals were built too, keep them for later and only
+            // apply the ones of the current signal now
+            QSet<uint> currentHandles = mPriv->handlesToBuild().toSet();
+            QList<ContactPtr> currentContacts;
+            foreach (const ContactPtr &contact, contacts) {
+                uint handle = contact->handle()[0];
+                mPriv->groupPrefetchedContacts.insert(handle, contact);
+                if (currentHandles.contains(handle)) {
+                    currentContacts.append(contact);
+                }
+            }
+            mPriv->groupPrefetchedInvalidHandles.unite(pending->invalidHandles().toSet());
+            contacts = currentContacts;
+        }
+
         if (!pending->invalidHandles().isEmpty()) {
             warning() << "Unable to construct Contact objects for handles:" <<
                 pending->invalidHandles();
@@ -3123,13 +3452,13 @@ void Channel::gotContacts(PendingOperation *op)
 
 void Channel::onGroupFlagsChanged(uint added, uint removed)
 {
-    debug().nospace() << "Got Channel.Interface.Group::GroupFlagsChanged(" <<
+    tpDebug().nospace() << "Got Channel.Interface.Group::GroupFlagsChanged(" <<
         hex << added << ", " << removed << ")";
 
     added &= ~(mPriv->groupFlags);
     removed &= mPriv->groupFlags;
 
-    debug().nospace() << "Arguments after filtering (" << hex << added <<
+    tpDebug().nospace() << "Arguments after filtering (" << hex << added <<
         ", " << removed << ")";
 
     uint groupFlags = mPriv->groupFlags;
@@ -3138,26 +3467,26 @@ void Channel::onGroupFlagsChanged(uint added, uint removed)
     // just emit groupFlagsChanged and related signals if the flags really
     // changed and we are ready
     if (mPriv->setGroupFlags(groupFlags) && isReady(Channel::FeatureCore)) {
-        debug() << "Emitting groupFlagsChanged with" << mPriv->groupFlags <<
+        tpDebug() << "Emitting groupFlagsChanged with" << mPriv->groupFlags <<
             "value" << added << "added" << removed << "removed";
         emit groupFlagsChanged((ChannelGroupFlags) mPriv->groupFlags,
                 (ChannelGroupFlags) added, (ChannelGroupFlags) removed);
 
         if (added & ChannelGroupFlagCanAdd ||
             removed & ChannelGroupFlagCanAdd) {
-            debug() << "Emitting groupCanAddContactsChanged";
+            tpDebug() << "Emitting groupCanAddContactsChanged";
             emit groupCanAddContactsChanged(groupCanAddContacts());
         }
 
         if (added & ChannelGroupFlagCanRemove ||
             removed & ChannelGroupFlagCanRemove) {
-            debug() << "Emitting groupCanRemoveContactsChanged";
+            tpDebug() << "Emitting groupCanRemoveContactsChanged";
             emit groupCanRemoveContactsChanged(groupCanRemoveContacts());
         }
 
         if (added & ChannelGroupFlagCanRescind ||
             removed & ChannelGroupFlagCanRescind) {
-            debug() << "Emitting groupCanRescindContactsChanged";
+            tpDebug() << "Emitting groupCanRescindContactsChanged";
             emit groupCanRescindContactsChanged(groupCanRescindContacts());
         }
     }
@@ -3173,11 +3502,11 @@ void Channel::onMembersChanged(const QString &message,
         return;
     }
 
-    debug() << "Got Channel.Interface.Group::MembersChanged with" << added.size() <<
+    tpDebug() << "Got Channel.Interface.Group::MembersChanged with" << added.size() <<
         "added," << removed.size() << "removed," << localPending.size() <<
         "moved to LP," << remotePending.size() << "moved to RP," << actor <<
         "being the actor," << reason << "the reason and" << message << "the message";
-    debug() << " synthesizing a corresponding MembersChangedDetailed signal";
+    tpDebug() << " synthesizing a corresponding MembersChangedDetailed signal";
 
     QVariantMap details;
 
@@ -3204,7 +3533,7 @@ void Channel::onMembersChangedDetailed(
         return;
     }
 
-    debug() << "Got Channel.Interface.Group::MembersChangedDetailed with" << added.size() <<
+    tpDebug() << "Got Channel.Interface.Group::MembersChangedDetailed with" << added.size() <<
         "added," << removed.size() << "removed," << localPending.size() <<
         "moved to LP," << remotePending.size() << "moved to RP and with" << details.size() <<
         "details";
@@ -3218,14 +3547,14 @@ void Channel::Private::doMembersChangedDetailed(
         const QVariantMap &details)
 {
     if (!groupHaveMembers) {
-        debug() << "Still waiting for initial group members, "
+        tpDebug() << "Still waiting for initial group members, "
             "so ignoring delta signal...";
         return;
     }
 
     if (added.isEmpty() && removed.isEmpty() &&
         localPending.isEmpty() && remotePending.isEmpty()) {
-        debug() << "Nothing really changed, so skipping membersChanged";
+        tpDebug() << "Nothing really changed, so skipping membersChanged";
         return;
     }
 
@@ -3282,11 +3611,11 @@ void Channel::Private::doMembersChangedDetailed(
 void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
         const UIntList &removed)
 {
-    debug() << "Got Channel.Interface.Group::HandleOwnersChanged with" <<
+    tpDebug() << "Got Channel.Interface.Group::HandleOwnersChanged with" <<
         added.size() << "added," << removed.size() << "removed";
 
     if (!mPriv->groupAreHandleOwnersAvailable) {
-        debug() << "Still waiting for initial handle owners, so ignoring "
+        tpDebug() << "Still waiting for initial handle owners, so ignoring "
             "delta signal...";
         return;
     }
@@ -3302,7 +3631,7 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
 
         if (!mPriv->groupHandleOwners.contains(handle)
                 || mPriv->groupHandleOwners[handle] != global) {
-            debug() << " +++/changed" << handle << "->" << global;
+            tpDebug() << " +++/changed" << handle << "->" << global;
             mPriv->groupHandleOwners[handle] = global;
             emitAdded.append(handle);
         }
@@ -3310,7 +3639,7 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
 
     foreach (uint handle, removed) {
         if (mPriv->groupHandleOwners.contains(handle)) {
-            debug() << " ---" << handle;
+            tpDebug() << " ---" << handle;
             mPriv->groupHandleOwners.remove(handle);
             emitRemoved.append(handle);
         }
@@ -3319,7 +3648,7 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
     // just emit groupHandleOwnersChanged if it really changed and
     // we are ready
     if ((emitAdded.size() || emitRemoved.size()) && isReady(Channel::FeatureCore)) {
-        debug() << "Emitting groupHandleOwnersChanged with" << emitAdded.size() <<
+        tpDebug() << "Emitting groupHandleOwnersChanged with" << emitAdded.size() <<
             "added" << emitRemoved.size() << "removed";
         emit groupHandleOwnersChanged(mPriv->groupHandleOwners,
                 emitAdded, emitRemoved);
@@ -3328,11 +3657,11 @@ void Channel::onHandleOwnersChanged(const HandleOwnerMap &added,
 
 void Channel::onSelfHandleChanged(uint selfHandle)
 {
-    debug().nospace() << "Got Channel.Interface.Group::SelfHandleChanged";
+    tpDebug().nospace() << "Got Channel.Interface.Group::SelfHandleChanged";
 
     if (selfHandle != mPriv->groupSelfHandle) {
         mPriv->groupSelfHandle = selfHandle;
-        debug() << " Emitting groupSelfHandleChanged with new self handle" <<
+        tpDebug() << " Emitting groupSelfHandleChanged with new self handle" <<
             selfHandle;
 
         // FIXME: fix self contact building with no group
@@ -3343,81 +3672,19 @@ void Channel::onSelfHandleChanged(uint selfHandle)
 void Channel::gotConferenceProperties(QDBusPendingCallWatcher *watcher)
 {
     QDBusPendingReply<QVariantMap> reply = *watcher;
-    QVariantMap props;
 
     mPriv->introspectingConference = false;
 
     if (!reply.isError()) {
-        debug() << "Got reply to Properties::GetAll(Channel.Interface.Conference)";
-        props = reply.value();
-
-        ConnectionPtr conn = connection();
-        ChannelFactoryConstPtr chanFactory = conn->channelFactory();
-
-        ObjectPathList channels =
-            qdbus_cast<ObjectPathList>(props[QLatin1String("Channels")]);
-        foreach (const QDBusObjectPath &channelPath, channels) {
-            if (mPriv->conferenceChannels.contains(channelPath.path())) {
-                continue;
-            }
-
-            PendingReady *readyOp = chanFactory->proxy(conn,
-                    channelPath.path(), QVariantMap());
-            ChannelPtr channel(ChannelPtr::qObjectCast(readyOp->proxy()));
-            Q_ASSERT(!channel.isNull());
-
-            mPriv->conferenceChannels.insert(channelPath.path(), channel);
-        }
-
-        ObjectPathList initialChannels =
-            qdbus_cast<ObjectPathList>(props[QLatin1String("InitialChannels")]);
-        foreach (const QDBusObjectPath &channelPath, initialChannels) {
-            if (mPriv->conferenceInitialChannels.contains(channelPath.path())) {
-                continue;
-            }
-
-            PendingReady *readyOp = chanFactory->proxy(conn,
-                    channelPath.path(), QVariantMap());
-            ChannelPtr channel(ChannelPtr::qObjectCast(readyOp->proxy()));
-            Q_ASSERT(!channel.isNull());
-
-            mPriv->conferenceInitialChannels.insert(channelPath.path(), channel);
-        }
-
-        mPriv->conferenceInitialInviteeHandles =
-            qdbus_cast<UIntList>(props[QLatin1String("InitialInviteeHandles")]);
-        QStringList conferenceInitialInviteeIds =
-            qdbus_cast<QStringList>(props[QLatin1String("InitialInviteeIDs")]);
-        if (mPriv->conferenceInitialInviteeHandles.size() == conferenceInitialInviteeIds.size()) {
-            HandleIdentifierMap contactIds;
-            int i = 0;
-            foreach (uint handle, mPriv->conferenceInitialInviteeHandles) {
-                contactIds.insert(handle, conferenceInitialInviteeIds.at(i++));
-            }
-            mPriv->connection->lowlevel()->injectContactIds(contactIds);
-        }
-
-        mPriv->conferenceInvitationMessage =
-            qdbus_cast<QString>(props[QLatin1String("InvitationMessage")]);
-
-        ChannelOriginatorMap originalChannels = qdbus_cast<ChannelOriginatorMap>(
-                props[QLatin1String("OriginalChannels")]);
-        for (ChannelOriginatorMap::const_iterator i = originalChannels.constBegin();
-                i != originalChannels.constEnd(); ++i) {
-            PendingReady *readyOp = chanFactory->proxy(conn,
-                    i.value().path(), QVariantMap());
-            ChannelPtr channel(ChannelPtr::qObjectCast(readyOp->proxy()));
-            Q_ASSERT(!channel.isNull());
-
-            mPriv->conferenceOriginalChannels.insert(i.key(), channel);
-        }
+        tpDebug() << "Got reply to Properties::GetAll(Channel.Interface.Conference)";
+        mPriv->extractConferenceProps(reply.value());
     } else {
         warning().nospace() << "Properties::GetAll(Channel.Interface.Conference) "
             "failed with " << reply.error().name() << ": " <<
             reply.error().message();
     }
 
-    mPriv->continueIntrospection();
+    mPriv->introspectStepFinished();
 }
 
 void Channel::gotConferenceInitialInviteeContacts(PendingOperation *op)
@@ -151,6 +151,9 @@ public:
     bool groupIsSelfContactTracked() const;
     ContactPtr groupSelfContact() const;
 
+    bool isGroupMembersChangedBatchingEnabled() const;
+    void setGroupMembersChangedBatchingEnabled(bool enabled);
+
     bool isConference() const;
     Contacts conferenceInitialInviteeContacts() const;
     QList<ChannelPtr> conferenceChannels() const;
@@ -24,6 +24,7 @@
 #define _TelepathyQt_client_registrar_internal_h_HEADER_GUARD_
 
 #include <QtCore/QObject>
+#include <QtCore/QTime>
 #include <QtDBus/QtDBus>
 
 #include <TelepathyQt/AbstractClientHandler>
@@ -125,15 +126,20 @@ public Q_SLOTS: // Methods
 
 private Q_SLOTS:
     void onReadyOpFinished(Tp::PendingOperation *);
+    void deliverInvocations();
 
 private:
     struct InvocationData : RefCounted
     {
-        InvocationData() : readyOp(0) {}
+        InvocationData() : readyOp(0), preparationTime(0) { received.start(); }
 
         PendingOperation *readyOp;
         QString error, message;
 
+        QString accountPath;
+        QTime received, ready;
+        int preparationTime;
+
         MethodInvocationContextPtr<> ctx;
         AccountPtr acc;
         ConnectionPtr conn;
@@ -191,15 +197,20 @@ public Q_SLOTS: // Methods
 
 private Q_SLOTS:
     void onReadyOpFinished(Tp::PendingOperation *);
+    void deliverInvocations();
 
 private:
     struct InvocationData : RefCounted
     {
-        InvocationData() : readyOp(0) {}
+        InvocationData() : readyOp(0), preparationTime(0) { received.start(); }
 
         PendingOperation *readyOp;
         QString error, message;
 
+        QString accountPath;
+        QTime received, ready;
+        int preparationTime;
+
         MethodInvocationContextPtr<> ctx;
         QList<ChannelPtr> chans;
         ChannelDispatchOperationPtr dispatchOp;
@@ -281,15 +292,20 @@ public Q_SLOTS: // Methods
 
 private Q_SLOTS:
     void onReadyOpFinished(Tp::PendingOperation *);
+    void deliverInvocations();
 
 private:
     struct InvocationData : RefCounted
     {
-        InvocationData() : readyOp(0) {}
+        InvocationData() : readyOp(0), preparationTime(0) { received.start(); }
 
         PendingOperation *readyOp;
         QString error, message;
 
+        QString accountPath;
+        QTime received, ready;
+        int preparationTime;
+
         MethodInvocationContextPtr<> ctx;
         AccountPtr acc;
         ConnectionPtr conn;
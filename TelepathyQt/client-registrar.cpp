@@ -84,6 +84,53 @@ private:
     void *mFinishedCbData;
 };
 
+// Remove the invocations which can be delivered to the client from the queue and return them, in
+// order. An invocation can be delivered once its proxies are ready, as long as no earlier
+// invocation it must be ordered after is still being prepared.
+template<typename InvocationData>
+static QList<SharedPtr<InvocationData> > takeDispatchableInvocations(
+        QLinkedList<SharedPtr<InvocationData> > &invocations,
+        AbstractClient::DispatchOrdering ordering)
+{
+    QList<SharedPtr<InvocationData> > ret;
+    QSet<QString> blockedAccounts;
+
+    typename QLinkedList<SharedPtr<InvocationData> >::iterator i = invocations.begin();
+    while (i != invocations.end()) {
+        if ((*i)->readyOp) {
+            if (ordering == AbstractClient::DispatchInOrder) {
+                break;
+            } else if (ordering == AbstractClient::DispatchInOrderPerAccount) {
+                blockedAccounts.insert((*i)->accountPath);
+            }
+            ++i;
+        } else if (blockedAccounts.contains((*i)->accountPath)) {
+            ++i;
+        } else {
+            ret.append(*i);
+            i = invocations.erase(i);
+        }
+    }
+
+    return ret;
+}
+
+static bool rejectIfQueueFull(int pendingInvocations, AbstractClient *client,
+        const QDBusConnection &bus, const QDBusMessage &message)
+{
+    int max = client->maxPendingDispatches();
+    if (max <= 0 || pendingInvocations < max) {
+        return false;
+    }
+
+    warning() << "Client" << client << "already has" << pendingInvocations
+        << "pending invocations, rejecting" << message.member();
+    MethodInvocationContextPtr<> ctx(new MethodInvocationContext<>(bus, message));
+    ctx->setFinishedWithError(TP_QT_ERROR_BUSY,
+            QLatin1String("Too many invocations are pending for this client"));
+    return true;
+}
+
 ClientAdaptor::ClientAdaptor(ClientRegistrar *registrar, const QStringList &interfaces,
         QObject *parent)
     : QDBusAbstractAdaptor(parent),
@@ -104,6 +151,7 @@ ClientObserverAdaptor::ClientObserverAdaptor(ClientRegistrar *registrar,
       mBus(registrar->dbusConnection()),
       mClient(client)
 {
+    mClient->addDispatchQueue(this);
 }
 
 ClientObserverAdaptor::~ClientObserverAdaptor()
@@ -118,15 +166,20 @@ void ClientObserverAdaptor::ObserveChannels(const QDBusObjectPath &accountPath,
         const QVariantMap &observerInfo,
         const QDBusMessage &message)
 {
-    debug() << "ObserveChannels: account:" << accountPath.path() <<
+    tpDebug() << "ObserveChannels: account:" << accountPath.path() <<
         ", connection:" << connectionPath.path();
 
+    if (rejectIfQueueFull(mInvocations.size(), mClient, mBus, message)) {
+        return;
+    }
+
     AccountFactoryConstPtr accFactory = mRegistrar->accountFactory();
     ConnectionFactoryConstPtr connFactory = mRegistrar->connectionFactory();
     ChannelFactoryConstPtr chanFactory = mRegistrar->channelFactory();
     ContactFactoryConstPtr contactFactory = mRegistrar->contactFactory();
 
     SharedPtr<InvocationData> invocation(new InvocationData());
+    invocation->accountPath = accountPath.path();
 
     QList<PendingOperation *> readyOps;
 
@@ -208,8 +261,8 @@ void ClientObserverAdaptor::ObserveChannels(const QDBusObjectPath &accountPath,
 
     mInvocations.append(invocation);
 
-    debug() << "Preparing proxies for ObserveChannels of" << channelDetailsList.size() << "channels"
-        << "for client" << mClient;
+    tpDebug() << "Preparing proxies for ObserveChannels of" << channelDetailsList.size() <<
+        "channels" << "for client" << mClient;
 }
 
 void ClientObserverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
@@ -224,6 +277,8 @@ void ClientObserverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
         }
 
         (*i)->readyOp = 0;
+        (*i)->preparationTime = (*i)->received.elapsed();
+        (*i)->ready.start();
 
         if (op->isError()) {
             warning() << "Preparing proxies for ObserveChannels failed with" << op->errorName()
@@ -235,9 +290,13 @@ void ClientObserverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
         break;
     }
 
-    while (!mInvocations.isEmpty() && !mInvocations.first()->readyOp) {
-        SharedPtr<InvocationData> invocation = mInvocations.takeFirst();
+    deliverInvocations();
+}
 
+void ClientObserverAdaptor::deliverInvocations()
+{
+    foreach (const SharedPtr<InvocationData> &invocation,
+            takeDispatchableInvocations(mInvocations, mClient->dispatchOrdering())) {
         if (!invocation->error.isEmpty()) {
             // We guarantee that the proxies were ready - so we can't invoke the client if they
             // weren't made ready successfully. Fix the introspection code if this happens :)
@@ -245,9 +304,14 @@ void ClientObserverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Invoking application observeChannels with" << invocation->chans.size()
+        tpDebug() << "Invoking application observeChannels with" << invocation->chans.size()
             << "channels on" << mClient;
 
+        int queueWaitTime = invocation->ready.elapsed();
+        tpDebug() << "  Proxies took" << invocation->preparationTime << "ms to become ready,"
+            << "waited" << queueWaitTime << "ms for earlier invocations";
+        mClient->recordDispatch(invocation->preparationTime, queueWaitTime);
+
         mClient->observeChannels(invocation->ctx, invocation->acc, invocation->conn,
                 invocation->chans, invocation->dispatchOp, invocation->chanReqs,
                 invocation->observerInfo);
@@ -262,6 +326,7 @@ ClientApproverAdaptor::ClientApproverAdaptor(ClientRegistrar *registrar,
       mBus(registrar->dbusConnection()),
       mClient(client)
 {
+    mClient->addDispatchQueue(this);
 }
 
 ClientApproverAdaptor::~ClientApproverAdaptor()
@@ -278,12 +343,16 @@ void ClientApproverAdaptor::AddDispatchOperation(const Tp::ChannelDetailsList &c
     ChannelFactoryConstPtr chanFactory = mRegistrar->channelFactory();
     ContactFactoryConstPtr contactFactory = mRegistrar->contactFactory();
 
+    if (rejectIfQueueFull(mInvocations.size(), mClient, mBus, message)) {
+        return;
+    }
+
     QList<PendingOperation *> readyOps;
 
     QDBusObjectPath connectionPath = qdbus_cast<QDBusObjectPath>(
             properties.value(
                 TP_QT_IFACE_CHANNEL_DISPATCH_OPERATION + QLatin1String(".Connection")));
-    debug() << "addDispatchOperation: connection:" << connectionPath.path();
+    tpDebug() << "addDispatchOperation: connection:" << connectionPath.path();
     QString connectionBusName = connectionPath.path().mid(1).replace(
             QLatin1String("/"), QLatin1String("."));
     PendingReady *connReady = connFactory->proxy(connectionBusName, connectionPath.path(), chanFactory,
@@ -292,6 +361,9 @@ void ClientApproverAdaptor::AddDispatchOperation(const Tp::ChannelDetailsList &c
     readyOps.append(connReady);
 
     SharedPtr<InvocationData> invocation(new InvocationData);
+    invocation->accountPath = qdbus_cast<QDBusObjectPath>(
+            properties.value(
+                TP_QT_IFACE_CHANNEL_DISPATCH_OPERATION + QLatin1String(".Account"))).path();
 
     foreach (const ChannelDetails &channelDetails, channelDetailsList) {
         PendingReady *chanReady = chanFactory->proxy(connection, channelDetails.channel.path(),
@@ -327,6 +399,8 @@ void ClientApproverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
         }
 
         (*i)->readyOp = 0;
+        (*i)->preparationTime = (*i)->received.elapsed();
+        (*i)->ready.start();
 
         if (op->isError()) {
             warning() << "Preparing proxies for AddDispatchOperation failed with" << op->errorName()
@@ -338,9 +412,13 @@ void ClientApproverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
         break;
     }
 
-    while (!mInvocations.isEmpty() && !mInvocations.first()->readyOp) {
-        SharedPtr<InvocationData> invocation = mInvocations.takeFirst();
+    deliverInvocations();
+}
 
+void ClientApproverAdaptor::deliverInvocations()
+{
+    foreach (const SharedPtr<InvocationData> &invocation,
+            takeDispatchableInvocations(mInvocations, mClient->dispatchOrdering())) {
         if (!invocation->error.isEmpty()) {
             // We guarantee that the proxies were ready - so we can't invoke the client if they
             // weren't made ready successfully. Fix the introspection code if this happens :)
@@ -348,9 +426,14 @@ void ClientApproverAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Invoking application addDispatchOperation with CDO"
+        tpDebug() << "Invoking application addDispatchOperation with CDO"
             << invocation->dispatchOp->objectPath() << "on" << mClient;
 
+        int queueWaitTime = invocation->ready.elapsed();
+        tpDebug() << "  Proxies took" << invocation->preparationTime << "ms to become ready,"
+            << "waited" << queueWaitTime << "ms for earlier invocations";
+        mClient->recordDispatch(invocation->preparationTime, queueWaitTime);
+
         mClient->addDispatchOperation(invocation->ctx, invocation->dispatchOp);
     }
 }
@@ -365,6 +448,8 @@ ClientHandlerAdaptor::ClientHandlerAdaptor(ClientRegistrar *registrar,
       mBus(registrar->dbusConnection()),
       mClient(client)
 {
+    mClient->addDispatchQueue(this);
+
     QList<ClientHandlerAdaptor *> &handlerAdaptors =
         mAdaptorsForConnection[qMakePair(mBus.name(), mBus.baseService())];
     handlerAdaptors.append(this);
@@ -389,20 +474,25 @@ void ClientHandlerAdaptor::HandleChannels(const QDBusObjectPath &accountPath,
         const QVariantMap &handlerInfo,
         const QDBusMessage &message)
 {
-    debug() << "HandleChannels: account:" << accountPath.path() <<
+    tpDebug() << "HandleChannels: account:" << accountPath.path() <<
         ", connection:" << connectionPath.path();
 
+    if (rejectIfQueueFull(mInvocations.size(), mClient, mBus, message)) {
+        return;
+    }
+
     AccountFactoryConstPtr accFactory = mRegistrar->accountFactory();
     ConnectionFactoryConstPtr connFactory = mRegistrar->connectionFactory();
     ChannelFactoryConstPtr chanFactory = mRegistrar->channelFactory();
     ContactFactoryConstPtr contactFactory = mRegistrar->contactFactory();
 
     SharedPtr<InvocationData> invocation(new InvocationData());
+    invocation->accountPath = accountPath.path();
     QList<PendingOperation *> readyOps;
 
     RequestTemporaryHandler *tempHandler = dynamic_cast<RequestTemporaryHandler *>(mClient);
     if (tempHandler) {
-        debug() << "  This is a temporary handler for the Request & Handle API,"
+        tpDebug() << "  This is a temporary handler for the Request & Handle API,"
             << "giving an early signal of the invocation";
         tempHandler->setDBusHandlerInvoked();
     }
@@ -459,8 +549,8 @@ void ClientHandlerAdaptor::HandleChannels(const QDBusObjectPath &accountPath,
 
     mInvocations.append(invocation);
 
-    debug() << "Preparing proxies for HandleChannels of" << channelDetailsList.size() << "channels"
-        << "for client" << mClient;
+    tpDebug() << "Preparing proxies for HandleChannels of" << channelDetailsList.size() <<
+        "channels" << "for client" << mClient;
 }
 
 void ClientHandlerAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
@@ -475,6 +565,8 @@ void ClientHandlerAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
         }
 
         (*i)->readyOp = 0;
+        (*i)->preparationTime = (*i)->received.elapsed();
+        (*i)->ready.start();
 
         if (op->isError()) {
             warning() << "Preparing proxies for HandleChannels failed with" << op->errorName()
@@ -486,13 +578,17 @@ void ClientHandlerAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
         break;
     }
 
-    while (!mInvocations.isEmpty() && !mInvocations.first()->readyOp) {
-        SharedPtr<InvocationData> invocation = mInvocations.takeFirst();
+    deliverInvocations();
+}
 
+void ClientHandlerAdaptor::deliverInvocations()
+{
+    foreach (const SharedPtr<InvocationData> &invocation,
+            takeDispatchableInvocations(mInvocations, mClient->dispatchOrdering())) {
         if (!invocation->error.isEmpty()) {
             RequestTemporaryHandler *tempHandler = dynamic_cast<RequestTemporaryHandler *>(mClient);
             if (tempHandler) {
-                debug() << "  This is a temporary handler for the Request & Handle API, indicating failure";
+                tpDebug() << "  This is a temporary handler for the Request & Handle API, indicating failure";
                 tempHandler->setDBusHandlerErrored(invocation->error, invocation->message);
             }
 
@@ -502,9 +598,14 @@ void ClientHandlerAdaptor::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Invoking application handleChannels with" << invocation->chans.size()
+        tpDebug() << "Invoking application handleChannels with" << invocation->chans.size()
             << "channels on" << mClient;
 
+        int queueWaitTime = invocation->ready.elapsed();
+        tpDebug() << "  Proxies took" << invocation->preparationTime << "ms to become ready,"
+            << "waited" << queueWaitTime << "ms for earlier invocations";
+        mClient->recordDispatch(invocation->preparationTime, queueWaitTime);
+
         mClient->handleChannels(invocation->ctx, invocation->acc, invocation->conn,
                 invocation->chans, invocation->chanReqs, invocation->time, invocation->handlerInfo);
     }
@@ -515,7 +616,7 @@ void ClientHandlerAdaptor::onContextFinished(
         const QList<ChannelPtr> &channels, ClientHandlerAdaptor *self)
 {
     if (!context->isError()) {
-        debug() << "HandleChannels context finished successfully, "
+        tpDebug() << "HandleChannels context finished successfully, "
             "updating handled channels";
 
         // register the channels in FakeHandlerManager so we report HandledChannels correctly
@@ -543,7 +644,7 @@ void ClientHandlerRequestsAdaptor::AddRequest(
         const QVariantMap &requestProperties,
         const QDBusMessage &message)
 {
-    debug() << "AddRequest:" << request.path();
+    tpDebug() << "AddRequest:" << request.path();
     message.setDelayedReply(true);
     mBus.send(message.createReply());
     mClient->addRequest(ChannelRequest::create(mBus,
@@ -559,7 +660,7 @@ void ClientHandlerRequestsAdaptor::RemoveRequest(
         const QString &errorName, const QString &errorMessage,
         const QDBusMessage &message)
 {
-    debug() << "RemoveRequest:" << request.path() << "-" << errorName
+    tpDebug() << "RemoveRequest:" << request.path() << "-" << errorName
         << "-" << errorMessage;
     message.setDelayedReply(true);
     mBus.send(message.createReply());
@@ -875,7 +976,7 @@ bool ClientRegistrar::registerClient(const AbstractClientPtr &client,
     }
 
     if (mPriv->clients.contains(client)) {
-        debug() << "Client already registered";
+        tpDebug() << "Client already registered";
         return true;
     }
 
@@ -961,7 +1062,7 @@ bool ClientRegistrar::registerClient(const AbstractClientPtr &client,
         handler->setRegistered(true);
     }
 
-    debug() << "Client registered - busName:" << busName <<
+    tpDebug() << "Client registered - busName:" << busName <<
         "objectPath:" << objectPath << "interfaces:" << interfaces;
 
     mPriv->services.insert(busName);
@@ -1008,7 +1109,7 @@ bool ClientRegistrar::unregisterClient(const AbstractClientPtr &client)
     mPriv->bus.unregisterService(busName);
     mPriv->services.remove(busName);
 
-    debug() << "Client unregistered - busName:" << busName <<
+    tpDebug() << "Client unregistered - busName:" << busName <<
         "objectPath:" << objectPath;
 
     return true;
@@ -74,6 +74,12 @@ public:
     void injectContactIds(const HandleIdentifierMap &contactIds);
     void injectContactId(uint handle, const QString &contactId);
 
+    int heldHandleCount(HandleType handleType) const;
+    int referencedHandleCount(HandleType handleType) const;
+
+    int handleReleaseGracePeriod() const;
+    void setHandleReleaseGracePeriod(int msec);
+
 private:
     friend class Connection;
     friend class ContactManager;
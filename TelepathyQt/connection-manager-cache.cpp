@@ -0,0 +1,492 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/connection-manager-cache.h"
+
+#include "TelepathyQt/cache-file.h"
+#include "TelepathyQt/debug-internal.h"
+
+#include <TelepathyQt/Constants>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QSet>
+#include <QtCore/QTextStream>
+
+namespace Tp
+{
+
+// Each connection manager has its own file, starting with a magic number and a format version,
+// followed by the files the entry was built from with their stamps, the connection manager
+// interfaces and its protocols
+static const quint32 cacheMagic = 0x5450434d; // "TPCM"
+static const quint32 cacheVersion = 2;
+
+typedef QList<QPair<QString, FileStamp> > Stamp;
+
+struct TP_QT_NO_EXPORT ConnectionManagerCache::Private
+{
+    struct Entry
+    {
+        Stamp stamp;
+        QStringList interfaces;
+        ConnectionManagerCache::ProtocolList protocols;
+    };
+
+    Private(const QString &cacheDir);
+
+    QString fileName(const QString &cmName) const;
+
+    Stamp currentStamp(const QString &cmName) const;
+    bool load(const QString &cmName, Entry *entry) const;
+    void save(const QString &cmName, const Entry &entry) const;
+
+    static bool isStorable(const QVariant &value);
+    static bool isStorable(const ConnectionManagerCache::ProtocolList &protocols);
+
+    QString cacheDir;
+    QHash<QString, Entry> entries;
+    // Connection managers which don't have a valid file in the cache directory, so it's not
+    // looked up again each time they are introspected
+    QSet<QString> missing;
+};
+
+ConnectionManagerCache::Private::Private(const QString &cacheDir)
+    : cacheDir(cacheDir)
+{
+}
+
+QString ConnectionManagerCache::Private::fileName(const QString &cmName) const
+{
+    return QString(QLatin1String("%1/%2.cache")).arg(cacheDir).arg(cmName);
+}
+
+Stamp ConnectionManagerCache::Private::currentStamp(const QString &cmName) const
+{
+    // An entry is only as good as the files describing the connection manager: the .manager
+    // files, which take precedence over introspection, and the executable started on activation,
+    // which is what answers the introspection calls otherwise
+    QStringList fileNames = ConnectionManagerCache::managerFileNames(cmName);
+
+    QString serviceFileName = ConnectionManagerCache::serviceFileName(cmName);
+    if (!serviceFileName.isEmpty()) {
+        fileNames << serviceFileName;
+
+        QFile file(serviceFileName);
+        if (file.open(QFile::ReadOnly)) {
+            QTextStream in(&file);
+            while (!in.atEnd()) {
+                QString line = in.readLine().trimmed();
+                if (line.startsWith(QLatin1String("Exec="))) {
+                    fileNames << line.mid(5).section(QLatin1Char(' '), 0, 0,
+                            QString::SectionSkipEmpty);
+                    break;
+                }
+            }
+        }
+    }
+
+    Stamp stamp;
+    foreach (const QString &fileName, fileNames) {
+        QString absoluteFileName = QFileInfo(fileName).absoluteFilePath();
+        FileStamp fileStamp = FileStamp::forFile(absoluteFileName);
+        if (fileStamp.isValid()) {
+            stamp.append(qMakePair(absoluteFileName, fileStamp));
+        }
+    }
+    return stamp;
+}
+
+static QDataStream &operator<<(QDataStream &out, const ConnectionManagerCache::Protocol &protocol)
+{
+    out << protocol.name;
+
+    out << static_cast<quint32>(protocol.parameters.size());
+    foreach (const ParamSpec &spec, protocol.parameters) {
+        out << spec.name << spec.flags << spec.signature << spec.defaultValue.variant();
+    }
+
+    out << static_cast<quint32>(protocol.requestableChannelClasses.size());
+    foreach (const RequestableChannelClass &rcc, protocol.requestableChannelClasses) {
+        out << rcc.fixedProperties << rcc.allowedProperties;
+    }
+
+    out << protocol.vcardField << protocol.englishName << protocol.iconName;
+
+    out << static_cast<quint32>(protocol.allowedPresenceStatuses.size());
+    for (SimpleStatusSpecMap::const_iterator i = protocol.allowedPresenceStatuses.constBegin();
+            i != protocol.allowedPresenceStatuses.constEnd(); ++i) {
+        out << i.key() << i.value().type << i.value().maySetOnSelf << i.value().canHaveMessage;
+    }
+
+    const AvatarSpec &avatar = protocol.avatarRequirements;
+    out << avatar.supportedMimeTypes() <<
+        avatar.minimumHeight() << avatar.maximumHeight() << avatar.recommendedHeight() <<
+        avatar.minimumWidth() << avatar.maximumWidth() << avatar.recommendedWidth() <<
+        avatar.maximumBytes();
+
+    out << protocol.addressableVCardFields << protocol.addressableUriSchemes;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, ConnectionManagerCache::Protocol &protocol)
+{
+    quint32 count;
+
+    in >> protocol.name;
+
+    in >> count;
+    protocol.parameters.clear();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ParamSpec spec;
+        QVariant defaultValue;
+        in >> spec.name >> spec.flags >> spec.signature >> defaultValue;
+        spec.defaultValue = QDBusVariant(defaultValue);
+        protocol.parameters.append(spec);
+    }
+
+    in >> count;
+    protocol.requestableChannelClasses.clear();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        RequestableChannelClass rcc;
+        in >> rcc.fixedProperties >> rcc.allowedProperties;
+        protocol.requestableChannelClasses.append(rcc);
+    }
+
+    in >> protocol.vcardField >> protocol.englishName >> protocol.iconName;
+
+    in >> count;
+    protocol.allowedPresenceStatuses.clear();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString status;
+        SimpleStatusSpec spec;
+        in >> status >> spec.type >> spec.maySetOnSelf >> spec.canHaveMessage;
+        protocol.allowedPresenceStatuses.insert(status, spec);
+    }
+
+    QStringList supportedMimeTypes;
+    uint minHeight, maxHeight, recommendedHeight;
+    uint minWidth, maxWidth, recommendedWidth;
+    uint maxBytes;
+    in >> supportedMimeTypes >> minHeight >> maxHeight >> recommendedHeight >>
+        minWidth >> maxWidth >> recommendedWidth >> maxBytes;
+    protocol.avatarRequirements = AvatarSpec(supportedMimeTypes,
+            minHeight, maxHeight, recommendedHeight,
+            minWidth, maxWidth, recommendedWidth,
+            maxBytes);
+
+    in >> protocol.addressableVCardFields >> protocol.addressableUriSchemes;
+    return in;
+}
+
+bool ConnectionManagerCache::Private::load(const QString &cmName, Entry *entry) const
+{
+    QFile file(fileName(cmName));
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version, count;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion) {
+        tpDebug() << "Ignoring connection manager cache" << file.fileName() <<
+            "with an invalid header";
+        return false;
+    }
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString fileName;
+        FileStamp fileStamp;
+        in >> fileName >> fileStamp;
+        entry->stamp.append(qMakePair(fileName, fileStamp));
+    }
+
+    in >> entry->interfaces;
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ConnectionManagerCache::Protocol protocol;
+        in >> protocol;
+        entry->protocols.append(protocol);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        tpDebug() << "Ignoring truncated connection manager cache" << file.fileName();
+        return false;
+    }
+
+    return true;
+}
+
+void ConnectionManagerCache::Private::save(const QString &cmName, const Entry &entry) const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << cacheMagic << cacheVersion;
+    out << static_cast<quint32>(entry.stamp.size());
+    foreach (const Stamp::value_type &stampFile, entry.stamp) {
+        out << stampFile.first << stampFile.second;
+    }
+    out << entry.interfaces;
+    out << static_cast<quint32>(entry.protocols.size());
+    foreach (const ConnectionManagerCache::Protocol &protocol, entry.protocols) {
+        out << protocol;
+    }
+
+    if (out.status() != QDataStream::Ok) {
+        warning() << "Error serializing connection manager cache for" << cmName;
+        return;
+    }
+
+    saveCacheFile(fileName(cmName), data);
+}
+
+bool ConnectionManagerCache::Private::isStorable(const QVariant &value)
+{
+    if (!value.isValid()) {
+        // parameters without a default value
+        return true;
+    }
+
+    if (value.userType() >= QVariant::UserType) {
+        return false;
+    }
+
+    if (value.type() == QVariant::Map) {
+        QVariantMap map = value.toMap();
+        for (QVariantMap::const_iterator i = map.constBegin(); i != map.constEnd(); ++i) {
+            if (!isStorable(i.value())) {
+                return false;
+            }
+        }
+    } else if (value.type() == QVariant::List) {
+        foreach (const QVariant &item, value.toList()) {
+            if (!isStorable(item)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ConnectionManagerCache::Private::isStorable(
+        const ConnectionManagerCache::ProtocolList &protocols)
+{
+    foreach (const ConnectionManagerCache::Protocol &protocol, protocols) {
+        foreach (const ParamSpec &spec, protocol.parameters) {
+            if (!isStorable(spec.defaultValue.variant())) {
+                return false;
+            }
+        }
+
+        foreach (const RequestableChannelClass &rcc, protocol.requestableChannelClasses) {
+            if (!isStorable(QVariant(rcc.fixedProperties))) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+ConnectionManagerCache *ConnectionManagerCache::mInstance = 0;
+
+ConnectionManagerCache *ConnectionManagerCache::instance()
+{
+    if (!mInstance) {
+        QString cacheDir = QString(QLatin1String(qgetenv("XDG_CACHE_HOME")));
+        if (cacheDir.isEmpty()) {
+            cacheDir = QString(QLatin1String("%1/.cache")).arg(QLatin1String(qgetenv("HOME")));
+        }
+        mInstance = new ConnectionManagerCache(
+                cacheDir + QLatin1String("/telepathy/connection-managers"));
+    }
+    return mInstance;
+}
+
+ConnectionManagerCache::ConnectionManagerCache(const QString &cacheDir)
+    : mPriv(new Private(cacheDir))
+{
+}
+
+ConnectionManagerCache::~ConnectionManagerCache()
+{
+    delete mPriv;
+}
+
+QString ConnectionManagerCache::cacheDir() const
+{
+    return mPriv->cacheDir;
+}
+
+bool ConnectionManagerCache::lookup(const QString &cmName, ProtocolList *protocols,
+        QStringList *interfaces)
+{
+    Stamp stamp = mPriv->currentStamp(cmName);
+    if (stamp.isEmpty()) {
+        return false;
+    }
+
+    QHash<QString, Private::Entry>::iterator i = mPriv->entries.find(cmName);
+    if (i == mPriv->entries.end()) {
+        if (mPriv->missing.contains(cmName)) {
+            return false;
+        }
+
+        Private::Entry entry;
+        if (!mPriv->load(cmName, &entry)) {
+            mPriv->missing.insert(cmName);
+            return false;
+        }
+        i = mPriv->entries.insert(cmName, entry);
+    }
+
+    if (i.value().stamp != stamp) {
+        tpDebug() << "Connection manager" << cmName << "changed since it was cached";
+        mPriv->entries.erase(i);
+        mPriv->missing.insert(cmName);
+        return false;
+    }
+
+    tpDebug() << "Using cached information for connection manager" << cmName;
+    *protocols = i.value().protocols;
+    if (interfaces) {
+        *interfaces = i.value().interfaces;
+    }
+    return true;
+}
+
+void ConnectionManagerCache::insert(const QString &cmName, const ProtocolList &protocols,
+        const QStringList &interfaces)
+{
+    Private::Entry entry;
+    entry.stamp = mPriv->currentStamp(cmName);
+    if (entry.stamp.isEmpty()) {
+        // nothing to tell whether the entry is still up-to-date later on
+        return;
+    }
+    entry.interfaces = interfaces;
+    entry.protocols = protocols;
+
+    mPriv->entries.insert(cmName, entry);
+    mPriv->missing.remove(cmName);
+
+    // Connection managers with values which can't be saved, such as D-Bus arguments which haven't
+    // been demarshalled, are only cached in memory
+    if (Private::isStorable(protocols)) {
+        mPriv->save(cmName, entry);
+    } else {
+        tpDebug() << "Not caching connection manager" << cmName << "on disk";
+        QFile::remove(mPriv->fileName(cmName));
+    }
+}
+
+void ConnectionManagerCache::remove(const QString &cmName)
+{
+    mPriv->entries.remove(cmName);
+    mPriv->missing.insert(cmName);
+    QFile::remove(mPriv->fileName(cmName));
+}
+
+void ConnectionManagerCache::clear()
+{
+    mPriv->entries.clear();
+    mPriv->missing.clear();
+
+    QDir dir(mPriv->cacheDir);
+    foreach (const QString &fileName, dir.entryList(
+                QStringList() << QLatin1String("*.cache"), QDir::Files)) {
+        dir.remove(fileName);
+    }
+}
+
+QStringList ConnectionManagerCache::managerFileNames(const QString &cmName)
+{
+    QStringList configDirs;
+
+    QString xdgDataHome = QString::fromLocal8Bit(qgetenv("XDG_DATA_HOME"));
+    if (xdgDataHome.isEmpty()) {
+        configDirs << QDir::homePath() + QLatin1String("/.local/share/data/telepathy/managers/");
+    }
+    else {
+        configDirs << xdgDataHome + QLatin1String("/telepathy/managers/");
+    }
+
+    QString xdgDataDirsEnv = QString::fromLocal8Bit(qgetenv("XDG_DATA_DIRS"));
+    if (xdgDataDirsEnv.isEmpty()) {
+        configDirs << QLatin1String("/usr/local/share/telepathy/managers/");
+        configDirs << QLatin1String("/usr/share/telepathy/managers/");
+    }
+    else {
+        QStringList xdgDataDirs = xdgDataDirsEnv.split(QLatin1Char(':'));
+        foreach (const QString xdgDataDir, xdgDataDirs) {
+            configDirs << xdgDataDir + QLatin1String("/telepathy/managers/");
+        }
+    }
+
+    QStringList fileNames;
+    foreach (const QString configDir, configDirs) {
+        fileNames << configDir + cmName + QLatin1String(".manager");
+    }
+    return fileNames;
+}
+
+QString ConnectionManagerCache::serviceFileName(const QString &cmName)
+{
+    QStringList dataDirs;
+
+    QString xdgDataHome = QString::fromLocal8Bit(qgetenv("XDG_DATA_HOME"));
+    if (xdgDataHome.isEmpty()) {
+        dataDirs << QDir::homePath() + QLatin1String("/.local/share");
+    } else {
+        dataDirs << xdgDataHome;
+    }
+
+    QString xdgDataDirsEnv = QString::fromLocal8Bit(qgetenv("XDG_DATA_DIRS"));
+    if (xdgDataDirsEnv.isEmpty()) {
+        dataDirs << QLatin1String("/usr/local/share") << QLatin1String("/usr/share");
+    } else {
+        dataDirs << xdgDataDirsEnv.split(QLatin1Char(':'), QString::SkipEmptyParts);
+    }
+
+    QString baseName = QString(QLatin1String("/dbus-1/services/%1%2.service")).
+        arg(TP_QT_CONNECTION_MANAGER_BUS_NAME_BASE).arg(cmName);
+    foreach (const QString &dataDir, dataDirs) {
+        QString fileName = dataDir + baseName;
+        if (QFile::exists(fileName)) {
+            return fileName;
+        }
+    }
+    return QString();
+}
+
+} // Tp
@@ -0,0 +1,86 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_connection_manager_cache_h_HEADER_GUARD_
+#define _TelepathyQt_connection_manager_cache_h_HEADER_GUARD_
+
+#include <TelepathyQt/AvatarSpec>
+#include <TelepathyQt/Types>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace Tp
+{
+
+class TP_QT_NO_EXPORT ConnectionManagerCache
+{
+public:
+    struct Protocol
+    {
+        QString name;
+        ParamSpecList parameters;
+        RequestableChannelClassList requestableChannelClasses;
+        QString vcardField;
+        QString englishName;
+        QString iconName;
+        SimpleStatusSpecMap allowedPresenceStatuses;
+        AvatarSpec avatarRequirements;
+        QStringList addressableVCardFields;
+        QStringList addressableUriSchemes;
+    };
+    typedef QList<Protocol> ProtocolList;
+
+    static ConnectionManagerCache *instance();
+
+    ConnectionManagerCache(const QString &cacheDir);
+    ~ConnectionManagerCache();
+
+    QString cacheDir() const;
+
+    bool lookup(const QString &cmName, ProtocolList *protocols, QStringList *interfaces = 0);
+    void insert(const QString &cmName, const ProtocolList &protocols,
+            const QStringList &interfaces = QStringList());
+    void remove(const QString &cmName);
+
+    void clear();
+
+    static QStringList managerFileNames(const QString &cmName);
+    static QString serviceFileName(const QString &cmName);
+
+private:
+    Q_DISABLE_COPY(ConnectionManagerCache)
+
+    static ConnectionManagerCache *mInstance;
+
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+}
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+#endif
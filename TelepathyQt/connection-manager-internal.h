@@ -45,6 +45,8 @@ struct TP_QT_NO_EXPORT ConnectionManager::Private
             const ContactFactoryConstPtr &contactFactory);
     ~Private();
 
+    bool loadFromCache();
+    void storeToCache();
     bool parseConfigFile();
 
     static void introspectMain(Private *self);
@@ -101,13 +103,14 @@ public:
 
 private Q_SLOTS:
     void onCallFinished(QDBusPendingCallWatcher *);
-    void continueProcessing();
+    void invokeMethods();
 
 private:
     void invokeMethod(const QLatin1String &method);
     void parseResult(const QStringList &names);
 
     QQueue<QLatin1String> mMethodsQueue;
+    int mPendingCalls;
     QSet<QString> mResult;
     QDBusConnection mBus;
 };
@@ -30,6 +30,7 @@
 #include "TelepathyQt/_gen/connection-manager-internal.moc.hpp"
 #include "TelepathyQt/_gen/connection-manager-lowlevel.moc.hpp"
 
+#include "TelepathyQt/connection-manager-cache.h"
 #include "TelepathyQt/debug-internal.h"
 #include "TelepathyQt/manager-file.h"
 
@@ -52,20 +53,28 @@ namespace Tp
 
 ConnectionManager::Private::PendingNames::PendingNames(const QDBusConnection &bus)
     : PendingStringList(SharedPtr<RefCounted>()),
+      mPendingCalls(0),
       mBus(bus)
 {
     mMethodsQueue.enqueue(QLatin1String("ListNames"));
     mMethodsQueue.enqueue(QLatin1String("ListActivatableNames"));
-    QTimer::singleShot(0, this, SLOT(continueProcessing()));
+    QTimer::singleShot(0, this, SLOT(invokeMethods()));
 }
 
 void ConnectionManager::Private::PendingNames::onCallFinished(QDBusPendingCallWatcher *watcher)
 {
     QDBusPendingReply<QStringList> reply = *watcher;
+    --mPendingCalls;
 
-    if (!reply.isError()) {
+    if (isFinished()) {
+        // the other call failed already
+    } else if (!reply.isError()) {
         parseResult(reply.value());
-        continueProcessing();
+        if (mPendingCalls == 0) {
+            tpDebug() << "Success: list" << mResult;
+            setResult(mResult.toList());
+            setFinished();
+        }
     } else {
         warning() << "Failure: error " << reply.error().name() <<
             ": " << reply.error().message();
@@ -75,16 +84,13 @@ void ConnectionManager::Private::PendingNames::onCallFinished(QDBusPendingCallWa
     watcher->deleteLater();
 }
 
-void ConnectionManager::Private::PendingNames::continueProcessing()
+void ConnectionManager::Private::PendingNames::invokeMethods()
 {
-    if (!mMethodsQueue.isEmpty()) {
-        QLatin1String method = mMethodsQueue.dequeue();
-        invokeMethod(method);
-    }
-    else {
-        debug() << "Success: list" << mResult;
-        setResult(mResult.toList());
-        setFinished();
+    // The bus answers both calls independently, so there is no point in waiting for the running
+    // names before asking for the activatable ones
+    while (!mMethodsQueue.isEmpty()) {
+        invokeMethod(mMethodsQueue.dequeue());
+        ++mPendingCalls;
     }
 }
 
@@ -149,7 +155,7 @@ void ConnectionManager::Private::ProtocolWrapper::introspectMain(
         ConnectionManager::Private::ProtocolWrapper *self)
 {
     if (self->extractImmutableProperties()) {
-        debug() << "Got everything we want from the immutable props for" <<
+        tpDebug() << "Got everything we want from the immutable props for" <<
             self->info().name();
         self->continueIntrospection();
         return;
@@ -169,7 +175,7 @@ void ConnectionManager::Private::ProtocolWrapper::introspectMainProperties()
     Client::ProtocolInterface *protocol = baseInterface();
     Q_ASSERT(protocol != 0);
 
-    debug() << "Calling Properties::GetAll(Protocol) for" << info().name();
+    tpDebug() << "Calling Properties::GetAll(Protocol) for" << info().name();
     PendingVariantMap *pvm = protocol->requestAllProperties();
     connect(pvm,
             SIGNAL(finished(Tp::PendingOperation*)),
@@ -182,7 +188,8 @@ void ConnectionManager::Private::ProtocolWrapper::introspectInterfaces()
         if (hasInterface(TP_QT_IFACE_PROTOCOL_INTERFACE_AVATARS)) {
             introspectQueue.enqueue(&ProtocolWrapper::introspectAvatars);
         } else {
-            debug() << "Full functionality requires CM support for the Protocol.Avatars interface";
+            tpDebug() << "Full functionality requires CM support for the Protocol.Avatars "
+                "interface";
         }
     }
 
@@ -190,7 +197,8 @@ void ConnectionManager::Private::ProtocolWrapper::introspectInterfaces()
         if (hasInterface(TP_QT_IFACE_PROTOCOL_INTERFACE_PRESENCE)) {
             introspectQueue.enqueue(&ProtocolWrapper::introspectPresence);
         } else {
-            debug() << "Full functionality requires CM support for the Protocol.Presence interface";
+            tpDebug() << "Full functionality requires CM support for the Protocol.Presence "
+                "interface";
         }
     }
 
@@ -198,7 +206,7 @@ void ConnectionManager::Private::ProtocolWrapper::introspectInterfaces()
         if (hasInterface(TP_QT_IFACE_PROTOCOL_INTERFACE_ADDRESSING)) {
             introspectQueue.enqueue(&ProtocolWrapper::introspectAddressing);
         } else {
-            debug() << "Full functionality requires CM support for the Protocol.Addressing interface";
+            tpDebug() << "Full functionality requires CM support for the Protocol.Addressing interface";
         }
     }
 }
@@ -208,7 +216,7 @@ void ConnectionManager::Private::ProtocolWrapper::introspectAvatars()
     Client::ProtocolInterfaceAvatarsInterface *avatars = avatarsInterface();
     Q_ASSERT(avatars != 0);
 
-    debug() << "Calling Properties::GetAll(Protocol.Avatars) for" << info().name();
+    tpDebug() << "Calling Properties::GetAll(Protocol.Avatars) for" << info().name();
     PendingVariantMap *pvm = avatars->requestAllProperties();
     connect(pvm,
             SIGNAL(finished(Tp::PendingOperation*)),
@@ -220,7 +228,7 @@ void ConnectionManager::Private::ProtocolWrapper::introspectPresence()
     Client::ProtocolInterfacePresenceInterface *presence = presenceInterface();
     Q_ASSERT(presence != 0);
 
-    debug() << "Calling Properties::GetAll(Protocol.Presence) for" << info().name();
+    tpDebug() << "Calling Properties::GetAll(Protocol.Presence) for" << info().name();
     PendingVariantMap *pvm = presence->requestAllProperties();
     connect(pvm,
             SIGNAL(finished(Tp::PendingOperation*)),
@@ -232,7 +240,7 @@ void ConnectionManager::Private::ProtocolWrapper::introspectAddressing()
     Client::ProtocolInterfaceAddressingInterface *addressing = addressingInterface();
     Q_ASSERT(addressing != 0);
 
-    debug() << "Calling Properties::GetAll(Protocol.Addressing) for" << info().name();
+    tpDebug() << "Calling Properties::GetAll(Protocol.Addressing) for" << info().name();
     PendingVariantMap *pvm = addressing->requestAllProperties();
     connect(pvm,
             SIGNAL(finished(Tp::PendingOperation*)),
@@ -252,7 +260,7 @@ void ConnectionManager::Private::ProtocolWrapper::gotMainProperties(
         Tp::PendingOperation *op)
 {
     if (!op->isError()) {
-        debug() << "Got reply to Properties.GetAll(Protocol)";
+        tpDebug() << "Got reply to Properties.GetAll(Protocol)";
         PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
         QVariantMap unqualifiedProps = pvm->result();
 
@@ -273,7 +281,7 @@ void ConnectionManager::Private::ProtocolWrapper::gotAvatarsProperties(
         Tp::PendingOperation *op)
 {
     if (!op->isError()) {
-        debug() << "Got reply to Properties.GetAll(Protocol.Avatars)";
+        tpDebug() << "Got reply to Properties.GetAll(Protocol.Avatars)";
         PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
         QVariantMap unqualifiedProps = pvm->result();
 
@@ -293,7 +301,7 @@ void ConnectionManager::Private::ProtocolWrapper::gotPresenceProperties(
         Tp::PendingOperation *op)
 {
     if (!op->isError()) {
-        debug() << "Got reply to Properties.GetAll(Protocol.Presence)";
+        tpDebug() << "Got reply to Properties.GetAll(Protocol.Presence)";
         PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
         QVariantMap unqualifiedProps = pvm->result();
 
@@ -315,7 +323,7 @@ void ConnectionManager::Private::ProtocolWrapper::gotAddressingProperties(
     QVariantMap unqualifiedProps;
 
     if (!op->isError()) {
-        debug() << "Got reply to Properties.GetAll(Protocol.Addressing)";
+        tpDebug() << "Got reply to Properties.GetAll(Protocol.Addressing)";
         PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
         QVariantMap unqualifiedProps = pvm->result();
 
@@ -532,7 +540,7 @@ ConnectionManager::Private::Private(ConnectionManager *parent, const QString &na
       chanFactory(chanFactory),
       contactFactory(contactFactory)
 {
-    debug() << "Creating new ConnectionManager:" << parent->busName();
+    tpDebug() << "Creating new ConnectionManager:" << parent->busName();
 
     if (connFactory->dbusConnection().name() != parent->dbusConnection().name()) {
         warning() << "  The D-Bus connection in the connection factory is not the proxy connection";
@@ -561,6 +569,63 @@ ConnectionManager::Private::~Private()
     delete baseInterface;
 }
 
+bool ConnectionManager::Private::loadFromCache()
+{
+    ConnectionManagerCache::ProtocolList cachedProtocols;
+    QStringList cachedInterfaces;
+    if (!ConnectionManagerCache::instance()->lookup(name, &cachedProtocols, &cachedInterfaces)) {
+        return false;
+    }
+
+    if (!cachedInterfaces.isEmpty()) {
+        parent->setInterfaces(cachedInterfaces);
+        readinessHelper->setInterfaces(cachedInterfaces);
+    }
+
+    foreach (const ConnectionManagerCache::Protocol &cached, cachedProtocols) {
+        ProtocolInfo info(ConnectionManagerPtr(parent), cached.name);
+
+        foreach (const ParamSpec &spec, cached.parameters) {
+            info.addParameter(spec);
+        }
+        info.setRequestableChannelClasses(cached.requestableChannelClasses);
+        info.setVCardField(cached.vcardField);
+        info.setEnglishName(cached.englishName);
+        info.setIconName(cached.iconName);
+        info.setAllowedPresenceStatuses(PresenceSpecList(cached.allowedPresenceStatuses));
+        info.setAvatarRequirements(cached.avatarRequirements);
+        info.setAddressableVCardFields(cached.addressableVCardFields);
+        info.setAddressableUriSchemes(cached.addressableUriSchemes);
+
+        protocols.append(info);
+    }
+
+    return true;
+}
+
+void ConnectionManager::Private::storeToCache()
+{
+    ConnectionManagerCache::ProtocolList cachedProtocols;
+    foreach (const ProtocolInfo &info, protocols) {
+        ConnectionManagerCache::Protocol cached;
+        cached.name = info.name();
+        foreach (const ProtocolParameter &param, info.parameters()) {
+            cached.parameters.append(param.bareParameter());
+        }
+        cached.requestableChannelClasses = info.capabilities().allClassSpecs().bareClasses();
+        cached.vcardField = info.vcardField();
+        cached.englishName = info.englishName();
+        cached.iconName = info.iconName();
+        cached.allowedPresenceStatuses = info.allowedPresenceStatuses().bareSpecs();
+        cached.avatarRequirements = info.avatarRequirements();
+        cached.addressableVCardFields = info.addressableVCardFields();
+        cached.addressableUriSchemes = info.addressableUriSchemes();
+        cachedProtocols.append(cached);
+    }
+
+    ConnectionManagerCache::instance()->insert(name, cachedProtocols, parent->interfaces());
+}
+
 bool ConnectionManager::Private::parseConfigFile()
 {
     ManagerFile f(name);
@@ -592,7 +657,15 @@ bool ConnectionManager::Private::parseConfigFile()
 
 void ConnectionManager::Private::introspectMain(ConnectionManager::Private *self)
 {
+    // The information is shared by all the ConnectionManager objects for the same connection
+    // manager, and kept across runs as long as the connection manager is not upgraded
+    if (self->loadFromCache()) {
+        self->readinessHelper->setIntrospectCompleted(FeatureCore, true);
+        return;
+    }
+
     if (self->parseConfigFile()) {
+        self->storeToCache();
         self->readinessHelper->setIntrospectCompleted(FeatureCore, true);
         return;
     }
@@ -600,7 +673,7 @@ void ConnectionManager::Private::introspectMain(ConnectionManager::Private *self
     warning() << "Error parsing config file for connection manager"
         << self->name << "- introspecting";
 
-    debug() << "Calling Properties::GetAll(ConnectionManager)";
+    tpDebug() << "Calling Properties::GetAll(ConnectionManager)";
     PendingVariantMap *pvm = self->baseInterface->requestAllProperties();
     self->parent->connect(pvm,
             SIGNAL(finished(Tp::PendingOperation*)),
@@ -609,7 +682,7 @@ void ConnectionManager::Private::introspectMain(ConnectionManager::Private *self
 
 void ConnectionManager::Private::introspectProtocolsLegacy()
 {
-    debug() << "Calling ConnectionManager::ListProtocols";
+    tpDebug() << "Calling ConnectionManager::ListProtocols";
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
             baseInterface->ListProtocols(), parent);
     parent->connect(watcher,
@@ -620,7 +693,7 @@ void ConnectionManager::Private::introspectProtocolsLegacy()
 void ConnectionManager::Private::introspectParametersLegacy()
 {
     foreach (const QString &protocolName, parametersQueue) {
-        debug() << "Calling ConnectionManager::GetParameters(" << protocolName << ")";
+        tpDebug() << "Calling ConnectionManager::GetParameters(" << protocolName << ")";
         QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
                 baseInterface->GetParameters(protocolName), parent);
         parent->connect(watcher,
@@ -986,7 +1059,7 @@ void ConnectionManager::gotMainProperties(Tp::PendingOperation *op)
     QVariantMap props;
 
     if (!op->isError()) {
-        debug() << "Got reply to Properties.GetAll(ConnectionManager)";
+        tpDebug() << "Got reply to Properties.GetAll(ConnectionManager)";
         PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
 
         props = pvm->result();
@@ -1043,7 +1116,7 @@ void ConnectionManager::gotProtocolsLegacy(QDBusPendingCallWatcher *watcher)
     QStringList protocolsNames;
 
     if (!reply.isError()) {
-        debug() << "Got reply to ConnectionManager.ListProtocols";
+        tpDebug() << "Got reply to ConnectionManager.ListProtocols";
         protocolsNames = reply.value();
 
         if (!protocolsNames.isEmpty()) {
@@ -1086,11 +1159,11 @@ void ConnectionManager::gotParametersLegacy(QDBusPendingCallWatcher *watcher)
     Q_ASSERT(found);
 
     if (!reply.isError()) {
-        debug() << QString(QLatin1String("Got reply to ConnectionManager.GetParameters(%1)")).arg(protocolName);
+        tpDebug() << QString(QLatin1String("Got reply to ConnectionManager.GetParameters(%1)")).arg(protocolName);
         ParamSpecList parameters = reply.value();
         ProtocolInfo &info = mPriv->protocols[pos];
         foreach (const ParamSpec &spec, parameters) {
-            debug() << "Parameter" << spec.name << "has flags" << spec.flags
+            tpDebug() << "Parameter" << spec.name << "has flags" << spec.flags
                 << "and signature" << spec.signature;
 
             info.addParameter(spec);
@@ -1106,6 +1179,7 @@ void ConnectionManager::gotParametersLegacy(QDBusPendingCallWatcher *watcher)
 
     if (mPriv->parametersQueue.isEmpty()) {
         if (!mPriv->protocols.isEmpty()) {
+            mPriv->storeToCache();
             mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
         } else {
             // we could not retrieve the params for any protocol, fail core.
@@ -1134,6 +1208,7 @@ void ConnectionManager::onProtocolReady(Tp::PendingOperation *op)
 
     if (mPriv->wrappers.isEmpty()) {
         if (!mPriv->protocols.isEmpty()) {
+            mPriv->storeToCache();
             mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
         } else {
             // we could not make any Protocol objects ready, fail core.
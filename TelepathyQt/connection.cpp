@@ -50,8 +50,10 @@
 #include <QMutex>
 #include <QMutexLocker>
 #include <QPair>
+#include <QPointer>
 #include <QQueue>
 #include <QString>
+#include <QTime>
 #include <QTimer>
 #include <QtGlobal>
 
@@ -81,6 +83,7 @@ struct TP_QT_NO_EXPORT Connection::Private
     static void introspectConnected(Private *self);
 
     void continueMainIntrospection();
+    void mainIntrospectStepFinished();
     void setCurrentStatus(uint status);
     void forceCurrentStatus(uint status);
     void setInterfaces(const QStringList &interfaces);
@@ -90,6 +93,9 @@ struct TP_QT_NO_EXPORT Connection::Private
 
     struct HandleContext;
 
+    void scheduleReleaseSweep(uint handleType, int delay);
+    void releaseExpiredHandles(uint handleType);
+
     // Public object
     Connection *parent;
     ConnectionLowlevelPtr lowlevel;
@@ -111,6 +117,8 @@ struct TP_QT_NO_EXPORT Connection::Private
 
     // Introspection
     QQueue<void (Private::*)()> introspectMainQueue;
+    int introspectMainStepsInFlight;
+    bool introspectMainFailed;
 
     // FeatureCore
     // keep pendingStatus and pendingStatusReason until we emit statusChanged
@@ -150,6 +158,15 @@ struct TP_QT_NO_EXPORT Connection::Private
     static QMutex handleContextsLock;
     HandleContext *handleContext;
 
+    // HoldHandles calls queued during this mainloop iteration, by handle type
+    struct HoldBatch
+    {
+        UIntList handles;
+        QList<QPointer<PendingHandles> > requests;
+    };
+    QHash<uint, HoldBatch> holdBatches;
+    bool holdBatchesScheduled;
+
     QString cmName;
     QString protocolName;
 };
@@ -171,25 +188,35 @@ struct TP_QT_NO_EXPORT Connection::Private::HandleContext
     struct Type
     {
         QHash<uint, uint> refcounts;
-        QSet<uint> toRelease;
+        // Handles which lost their last reference, with the time that happened. They're only
+        // released once they've been unreferenced for the grace period, so that handles which
+        // come and go repeatedly are revived without a HoldHandles/ReleaseHandles cycle.
+        QHash<uint, QTime> toRelease;
         uint requestsInFlight;
         bool releaseScheduled;
+        // The proxy whose timer runs the scheduled sweep
+        Private *sweeper;
 
         Type()
             : requestsInFlight(0),
-              releaseScheduled(false)
+              releaseScheduled(false),
+              sweeper(0)
         {
         }
     };
 
     HandleContext()
-        : refcount(0)
+        : refcount(0),
+          releaseGracePeriod(0)
     {
     }
 
     int refcount;
+    // The proxies sharing this context, which can take over the sweeps of a proxy going away
+    QList<Private *> users;
     QMutex lock;
     QHash<uint, Type> types;
+    int releaseGracePeriod;
 };
 
 Connection::Private::Private(Connection *parent,
@@ -203,6 +230,8 @@ Connection::Private::Private(Connection *parent,
       properties(parent->interface<Client::DBus::PropertiesInterface>()),
       simplePresence(0),
       readinessHelper(parent->readinessHelper()),
+      introspectMainStepsInFlight(0),
+      introspectMainFailed(false),
       introspectingConnected(false),
       pendingStatus((uint) -1),
       pendingStatusReason(ConnectionStatusReasonNoneSpecified),
@@ -214,7 +243,8 @@ Connection::Private::Private(Connection *parent,
       introspectingSelfContact(false),
       reintrospectSelfContactRequired(false),
       maxPresenceStatusMessageLength(0),
-      handleContext(0)
+      handleContext(0),
+      holdBatchesScheduled(false)
 {
     accountBalance.amount = 0;
     accountBalance.scale = 0;
@@ -339,21 +369,21 @@ Connection::Private::~Private()
     // All handle contexts locked, so safe
     if (!--handleContext->refcount) {
         if (!immortalHandles) {
-            debug() << "Destroying HandleContext";
+            tpDebug() << "Destroying HandleContext";
 
             foreach (uint handleType, handleContext->types.keys()) {
                 HandleContext::Type type = handleContext->types[handleType];
 
                 if (!type.refcounts.empty()) {
-                    debug() << " Still had references to" <<
+                    tpDebug() << " Still had references to" <<
                         type.refcounts.size() << "handles, releasing now";
                     baseInterface->ReleaseHandles(handleType, type.refcounts.keys());
                 }
 
                 if (!type.toRelease.empty()) {
-                    debug() << " Was going to release" <<
+                    tpDebug() << " Was going to release" <<
                         type.toRelease.size() << "handles, doing that now";
-                    baseInterface->ReleaseHandles(handleType, type.toRelease.toList());
+                    baseInterface->ReleaseHandles(handleType, type.toRelease.keys());
                 }
             }
 
@@ -364,20 +394,33 @@ Connection::Private::~Private()
         delete handleContext;
     } else {
         Q_ASSERT(handleContext->refcount > 0);
+
+        // The release sweeps scheduled by this proxy die with it, so let one of the remaining
+        // proxies run them instead
+        QMutexLocker contextLocker(&handleContext->lock);
+        handleContext->users.removeOne(this);
+        Q_ASSERT(!handleContext->users.isEmpty());
+        Private *heir = handleContext->users.first();
+        foreach (uint handleType, handleContext->types.keys()) {
+            const HandleContext::Type &type = handleContext->types[handleType];
+            if (type.releaseScheduled && type.sweeper == this) {
+                heir->scheduleReleaseSweep(handleType, 0);
+            }
+        }
     }
 }
 
 void Connection::Private::init()
 {
-    debug() << "Connecting to ConnectionError()";
+    tpDebug() << "Connecting to ConnectionError()";
     parent->connect(baseInterface,
             SIGNAL(ConnectionError(QString,QVariantMap)),
             SLOT(onConnectionError(QString,QVariantMap)));
-    debug() << "Connecting to StatusChanged()";
+    tpDebug() << "Connecting to StatusChanged()";
     parent->connect(baseInterface,
             SIGNAL(StatusChanged(uint,uint)),
             SLOT(onStatusChanged(uint,uint)));
-    debug() << "Connecting to SelfHandleChanged()";
+    tpDebug() << "Connecting to SelfHandleChanged()";
     parent->connect(baseInterface,
             SIGNAL(SelfHandleChanged(uint)),
             SLOT(onSelfHandleChanged(uint)));
@@ -386,11 +429,11 @@ void Connection::Private::init()
     QString busConnectionName = baseInterface->connection().name();
 
     if (handleContexts.contains(qMakePair(busConnectionName, parent->objectPath()))) {
-        debug() << "Reusing existing HandleContext for" << parent->objectPath();
+        tpDebug() << "Reusing existing HandleContext for" << parent->objectPath();
         handleContext = handleContexts[
             qMakePair(busConnectionName, parent->objectPath())];
     } else {
-        debug() << "Creating new HandleContext for" << parent->objectPath();
+        tpDebug() << "Creating new HandleContext for" << parent->objectPath();
         handleContext = new HandleContext;
         handleContexts[
             qMakePair(busConnectionName, parent->objectPath())] = handleContext;
@@ -398,11 +441,75 @@ void Connection::Private::init()
 
     // All handle contexts locked, so safe
     ++handleContext->refcount;
+
+    QMutexLocker contextLocker(&handleContext->lock);
+    handleContext->users.append(this);
+}
+
+// Must be called with the handle context locked
+void Connection::Private::scheduleReleaseSweep(uint handleType, int delay)
+{
+    HandleContext::Type &type = handleContext->types[handleType];
+    type.releaseScheduled = true;
+    type.sweeper = this;
+    QTimer::singleShot(delay, parent, SLOT(doReleaseSweeps()));
+}
+
+// Must be called with the handle context locked
+void Connection::Private::releaseExpiredHandles(uint handleType)
+{
+    HandleContext::Type &type = handleContext->types[handleType];
+
+    TP_QT_DEBUG(DebugCategoryConnection) << "Entering handle release sweep for type" << handleType;
+    type.releaseScheduled = false;
+    type.sweeper = 0;
+
+    if (type.requestsInFlight > 0) {
+        TP_QT_DEBUG(DebugCategoryConnection) <<
+            " There are requests in flight, deferring sweep to when they have been completed";
+        return;
+    }
+
+    if (type.toRelease.isEmpty()) {
+        TP_QT_DEBUG(DebugCategoryConnection) << " No handles to release - every one has been resurrected";
+        return;
+    }
+
+    int gracePeriod = handleContext->releaseGracePeriod;
+    int nextExpiry = gracePeriod;
+    UIntList expired;
+    QHash<uint, QTime>::iterator i = type.toRelease.begin();
+    while (i != type.toRelease.end()) {
+        int elapsed = i.value().elapsed();
+        // elapsed() wraps around at midnight, in which case the handle is released a bit early
+        if (elapsed >= gracePeriod || elapsed < 0) {
+            expired << i.key();
+            i = type.toRelease.erase(i);
+        } else {
+            nextExpiry = qMin(nextExpiry, gracePeriod - elapsed);
+            ++i;
+        }
+    }
+
+    if (!expired.isEmpty()) {
+        TP_QT_DEBUG(DebugCategoryConnection) << " Releasing" << expired.size() << "handles";
+        baseInterface->ReleaseHandles(handleType, expired);
+    }
+
+    if (!type.toRelease.isEmpty()) {
+        TP_QT_DEBUG(DebugCategoryConnection) << " Keeping" << type.toRelease.size() <<
+            "recently unreferenced handles for" << nextExpiry << "ms more";
+        scheduleReleaseSweep(handleType, nextExpiry);
+    }
 }
 
 void Connection::Private::introspectMain(Connection::Private *self)
 {
-    debug() << "Calling Properties::GetAll(Connection)";
+    self->introspectMainQueue.clear();
+    self->introspectMainStepsInFlight = 0;
+    self->introspectMainFailed = false;
+
+    tpDebug() << "Calling Properties::GetAll(Connection)";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(
                 self->properties->GetAll(TP_QT_IFACE_CONNECTION),
@@ -414,7 +521,7 @@ void Connection::Private::introspectMain(Connection::Private *self)
 
 void Connection::Private::introspectMainFallbackStatus()
 {
-    debug() << "Calling GetStatus()";
+    tpDebug() << "Calling GetStatus()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetStatus(),
                 parent);
@@ -425,7 +532,7 @@ void Connection::Private::introspectMainFallbackStatus()
 
 void Connection::Private::introspectMainFallbackInterfaces()
 {
-    debug() << "Calling GetInterfaces()";
+    tpDebug() << "Calling GetInterfaces()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetInterfaces(),
                 parent);
@@ -436,7 +543,7 @@ void Connection::Private::introspectMainFallbackInterfaces()
 
 void Connection::Private::introspectMainFallbackSelfHandle()
 {
-    debug() << "Calling GetSelfHandle()";
+    tpDebug() << "Calling GetSelfHandle()";
     QDBusPendingCallWatcher *watcher =
         new QDBusPendingCallWatcher(baseInterface->GetSelfHandle(),
                 parent);
@@ -447,7 +554,7 @@ void Connection::Private::introspectMainFallbackSelfHandle()
 
 void Connection::Private::introspectCapabilities()
 {
-    debug() << "Retrieving capabilities";
+    tpDebug() << "Retrieving capabilities";
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
             properties->Get(
                 TP_QT_IFACE_CONNECTION_INTERFACE_REQUESTS,
@@ -459,7 +566,7 @@ void Connection::Private::introspectCapabilities()
 
 void Connection::Private::introspectContactAttributeInterfaces()
 {
-    debug() << "Retrieving contact attribute interfaces";
+    tpDebug() << "Retrieving contact attribute interfaces";
     QDBusPendingCall call =
         properties->Get(
                 TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS,
@@ -473,7 +580,7 @@ void Connection::Private::introspectContactAttributeInterfaces()
 
 void Connection::Private::introspectSelfContact(Connection::Private *self)
 {
-    debug() << "Building self contact";
+    tpDebug() << "Building self contact";
 
     Q_ASSERT(!self->introspectingSelfContact);
 
@@ -491,7 +598,7 @@ void Connection::Private::introspectSimplePresence(Connection::Private *self)
 {
     Q_ASSERT(self->properties != 0);
 
-    debug() << "Calling Properties::Get("
+    tpDebug() << "Calling Properties::Get("
         "Connection.I.SimplePresence.Statuses)";
     QDBusPendingCall call =
         self->properties->GetAll(
@@ -505,7 +612,7 @@ void Connection::Private::introspectSimplePresence(Connection::Private *self)
 
 void Connection::Private::introspectRoster(Connection::Private *self)
 {
-    debug() << "Introspecting roster";
+    tpDebug() << "Introspecting roster";
 
     PendingOperation *op = self->contactManager->introspectRoster();
     self->parent->connect(op,
@@ -515,7 +622,7 @@ void Connection::Private::introspectRoster(Connection::Private *self)
 
 void Connection::Private::introspectRosterGroups(Connection::Private *self)
 {
-    debug() << "Introspecting roster groups";
+    tpDebug() << "Introspecting roster groups";
 
     PendingOperation *op = self->contactManager->introspectRosterGroups();
     self->parent->connect(op,
@@ -525,19 +632,19 @@ void Connection::Private::introspectRosterGroups(Connection::Private *self)
 
 void Connection::Private::introspectBalance(Connection::Private *self)
 {
-    debug() << "Introspecting balance";
+    tpDebug() << "Introspecting balance";
 
     // we already checked if balance interface exists, so bypass requests
     // interface checking
     Client::ConnectionInterfaceBalanceInterface *iface =
         self->parent->interface<Client::ConnectionInterfaceBalanceInterface>();
 
-    debug() << "Connecting to Balance.BalanceChanged";
+    tpDebug() << "Connecting to Balance.BalanceChanged";
     self->parent->connect(iface,
             SIGNAL(BalanceChanged(Tp::CurrencyAmount)),
             SLOT(onBalanceChanged(Tp::CurrencyAmount)));
 
-    debug() << "Retrieving balance";
+    tpDebug() << "Retrieving balance";
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
             self->properties->Get(
                 TP_QT_IFACE_CONNECTION_INTERFACE_BALANCE,
@@ -561,17 +668,35 @@ void Connection::Private::introspectConnected(Connection::Private *self)
 void Connection::Private::continueMainIntrospection()
 {
     if (!parent->isValid()) {
-        debug() << parent << "stopping main introspection, as it has been invalidated";
+        tpDebug() << parent << "stopping main introspection, as it has been invalidated";
+        return;
+    }
+
+    if (introspectMainFailed) {
+        // FeatureCore was already flagged as failed, just let the remaining steps land
         return;
     }
 
-    if (introspectMainQueue.isEmpty()) {
+    if (!introspectMainQueue.isEmpty()) {
+        // None of the main introspection steps depend on each other, so start them all at once
+        QQueue<void (Private::*)()> steps = introspectMainQueue;
+        introspectMainQueue.clear();
+        introspectMainStepsInFlight += steps.size();
+        while (!steps.isEmpty()) {
+            (this->*(steps.dequeue()))();
+        }
+    } else if (introspectMainStepsInFlight == 0) {
         readinessHelper->setIntrospectCompleted(FeatureCore, true);
-    } else {
-        (this->*(introspectMainQueue.dequeue()))();
     }
 }
 
+void Connection::Private::mainIntrospectStepFinished()
+{
+    Q_ASSERT(introspectMainStepsInFlight > 0);
+    --introspectMainStepsInFlight;
+    continueMainIntrospection();
+}
+
 void Connection::Private::setCurrentStatus(uint status)
 {
     // ReadinessHelper waits for all in-flight introspection ops to finish for the current status
@@ -586,7 +711,7 @@ void Connection::Private::setCurrentStatus(uint status)
     if (introspectingConnected) {
         // On the other hand, we have to finish the Connected introspection for now, as
         // ReadinessHelper would otherwise wait indefinitely for it to land
-        debug() << "Finishing FeatureConnected for status" << this->status <<
+        tpDebug() << "Finishing FeatureConnected for status" << this->status <<
             "to allow ReadinessHelper to introspect new status" << status;
         readinessHelper->setIntrospectCompleted(FeatureConnected, true);
         introspectingConnected = false;
@@ -599,7 +724,7 @@ void Connection::Private::forceCurrentStatus(uint status)
 {
     // only update the status if we did not get it from StatusChanged
     if (pendingStatus == (uint) -1) {
-        debug() << "Got status:" << status;
+        tpDebug() << "Got status:" << status;
         pendingStatus = status;
         // No need to re-run introspection as we just received the status. Let
         // the introspection continue normally but update readinessHelper with
@@ -610,7 +735,7 @@ void Connection::Private::forceCurrentStatus(uint status)
 
 void Connection::Private::setInterfaces(const QStringList &interfaces)
 {
-    debug() << "Got interfaces:" << interfaces;
+    tpDebug() << "Got interfaces:" << interfaces;
     parent->setInterfaces(interfaces);
     readinessHelper->setInterfaces(interfaces);
 }
@@ -678,7 +803,7 @@ void Connection::PendingConnect::onConnectReply(QDBusPendingCallWatcher *watcher
     ConnectionPtr connection = ConnectionPtr::qObjectCast(proxy());
 
     if (watcher->isError()) {
-        debug() << "Connect failed with" <<
+        tpDebug() << "Connect failed with" <<
             watcher->error().name() << ": " << watcher->error().message();
         setFinishedWithError(watcher->error());
         connection->disconnect(
@@ -710,7 +835,7 @@ void Connection::PendingConnect::onStatusChanged(ConnectionStatus newStatus)
     ConnectionPtr connection = ConnectionPtr::qObjectCast(proxy());
 
     if (newStatus == ConnectionStatusDisconnected) {
-        debug() << "Connection became disconnected while a PendingConnect was underway";
+        tpDebug() << "Connection became disconnected while a PendingConnect was underway";
         setFinishedWithError(connection->invalidationReason(), connection->invalidationMessage());
 
         connection->disconnect(this,
@@ -739,16 +864,16 @@ void Connection::PendingConnect::onBecomeReadyReply(Tp::PendingOperation *op)
             SLOT(onConnInvalidated(Tp::DBusProxy*,QString,QString)));
 
     if (op->isError()) {
-        debug() << "Connection->becomeReady failed with" <<
+        tpDebug() << "Connection->becomeReady failed with" <<
             op->errorName() << ": " << op->errorMessage();
         setFinishedWithError(op->errorName(), op->errorMessage());
     } else {
-        debug() << "Connected";
+        tpDebug() << "Connected";
 
         if (connection->isValid()) {
             setFinished();
         } else {
-            debug() << "  ... but the Connection was immediately invalidated!";
+            tpDebug() << "  ... but the Connection was immediately invalidated!";
             setFinishedWithError(connection->invalidationReason(), connection->invalidationMessage());
         }
     }
@@ -762,7 +887,7 @@ void Connection::PendingConnect::onConnInvalidated(Tp::DBusProxy *proxy, const Q
     Q_ASSERT(proxy == connection.data());
 
     if (!isFinished()) {
-        debug() << "Unable to connect. Connection invalidated";
+        tpDebug() << "Unable to connect. Connection invalidated";
         setFinishedWithError(error, message);
     }
 
@@ -1461,13 +1586,13 @@ void Connection::onStatusReady(uint status)
     if (isValid()) {
         emit statusChanged((ConnectionStatus) mPriv->status);
     } else {
-        debug() << this << " not emitting statusChanged because it has been invalidated";
+        tpDebug() << this << " not emitting statusChanged because it has been invalidated";
     }
 }
 
 void Connection::onStatusChanged(uint status, uint reason)
 {
-    debug() << "StatusChanged from" << mPriv->pendingStatus
+    tpDebug() << "StatusChanged from" << mPriv->pendingStatus
             << "to" << status << "with reason" << reason;
 
     if (mPriv->pendingStatus == status) {
@@ -1482,7 +1607,7 @@ void Connection::onStatusChanged(uint status, uint reason)
 
     switch (status) {
         case ConnectionStatusConnected:
-            debug() << "Performing introspection for the Connected status";
+            tpDebug() << "Performing introspection for the Connected status";
             mPriv->setCurrentStatus(status);
             break;
 
@@ -1516,7 +1641,7 @@ void Connection::onStatusChanged(uint status, uint reason)
 void Connection::onConnectionError(const QString &error,
         const QVariantMap &details)
 {
-    debug().nospace() << "Connection(" << objectPath() << ") got ConnectionError(" << error
+    tpDebug().nospace() << "Connection(" << objectPath() << ") got ConnectionError(" << error
         << ") with " << details.size() << " details";
 
     mPriv->errorDetails = details;
@@ -1592,10 +1717,12 @@ void Connection::gotStatus(QDBusPendingCallWatcher *watcher)
     if (!reply.isError()) {
         mPriv->forceCurrentStatus(reply.value());
 
-        mPriv->continueMainIntrospection();
+        mPriv->mainIntrospectStepFinished();
     } else {
         warning().nospace() << "GetStatus() failed with " <<
             reply.error().name() << ": " << reply.error().message();
+        mPriv->introspectMainFailed = true;
+        mPriv->mainIntrospectStepFinished();
         mPriv->invalidateResetCaps(reply.error().name(), reply.error().message());
     }
 
@@ -1616,7 +1743,7 @@ void Connection::gotInterfaces(QDBusPendingCallWatcher *watcher)
         // let's not fail if GetInterfaces fail
     }
 
-    mPriv->continueMainIntrospection();
+    mPriv->mainIntrospectStepFinished();
 
     watcher->deleteLater();
 }
@@ -1627,12 +1754,14 @@ void Connection::gotSelfHandle(QDBusPendingCallWatcher *watcher)
 
     if (!reply.isError()) {
         mPriv->selfHandle = reply.value();
-        debug() << "Got self handle:" << mPriv->selfHandle;
+        tpDebug() << "Got self handle:" << mPriv->selfHandle;
 
-        mPriv->continueMainIntrospection();
+        mPriv->mainIntrospectStepFinished();
     } else {
         warning().nospace() << "GetSelfHandle() failed with " <<
             reply.error().name() << ": " << reply.error().message();
+        mPriv->introspectMainFailed = true;
+        mPriv->mainIntrospectStepFinished();
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore,
                 false, reply.error());
     }
@@ -1645,7 +1774,7 @@ void Connection::gotCapabilities(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QDBusVariant> reply = *watcher;
 
     if (!reply.isError()) {
-        debug() << "Got capabilities";
+        tpDebug() << "Got capabilities";
         mPriv->caps.updateRequestableChannelClasses(
                 qdbus_cast<RequestableChannelClassList>(reply.value().variant()));
     } else {
@@ -1654,7 +1783,7 @@ void Connection::gotCapabilities(QDBusPendingCallWatcher *watcher)
         // let's not fail if retrieving capabilities fail
     }
 
-    mPriv->continueMainIntrospection();
+    mPriv->mainIntrospectStepFinished();
 
     watcher->deleteLater();
 }
@@ -1664,7 +1793,7 @@ void Connection::gotContactAttributeInterfaces(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QDBusVariant> reply = *watcher;
 
     if (!reply.isError()) {
-        debug() << "Got contact attribute interfaces";
+        tpDebug() << "Got contact attribute interfaces";
         mPriv->contactAttributeInterfaces = qdbus_cast<QStringList>(reply.value().variant());
     } else {
         warning().nospace() << "Getting contact attribute interfaces failed with " <<
@@ -1673,7 +1802,7 @@ void Connection::gotContactAttributeInterfaces(QDBusPendingCallWatcher *watcher)
         // TODO should we remove Contacts interface from interfaces?
     }
 
-    mPriv->continueMainIntrospection();
+    mPriv->mainIntrospectStepFinished();
 
     watcher->deleteLater();
 }
@@ -1690,7 +1819,7 @@ void Connection::gotSimpleStatuses(QDBusPendingCallWatcher *watcher)
         mPriv->maxPresenceStatusMessageLength = qdbus_cast<uint>(
                 props[QLatin1String("MaximumStatusMessageLength")]);
 
-        debug() << "Got" << mPriv->simplePresenceStatuses.size() <<
+        tpDebug() << "Got" << mPriv->simplePresenceStatuses.size() <<
             "simple presence statuses - max status message length is" <<
             mPriv->maxPresenceStatusMessageLength;
 
@@ -1756,7 +1885,7 @@ void Connection::onIntrospectRosterFinished(PendingOperation *op)
         return;
     }
 
-    debug() << "Introspecting roster finished";
+    tpDebug() << "Introspecting roster finished";
     mPriv->readinessHelper->setIntrospectCompleted(FeatureRoster, true);
 }
 
@@ -1770,7 +1899,7 @@ void Connection::onIntrospectRosterGroupsFinished(PendingOperation *op)
         return;
     }
 
-    debug() << "Introspecting roster groups finished";
+    tpDebug() << "Introspecting roster groups finished";
     mPriv->readinessHelper->setIntrospectCompleted(FeatureRosterGroups, true);
 }
 
@@ -1779,7 +1908,7 @@ void Connection::gotBalance(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QVariant> reply = *watcher;
 
     if (!reply.isError()) {
-        debug() << "Got balance";
+        tpDebug() << "Got balance";
         mPriv->accountBalance = qdbus_cast<CurrencyAmount>(reply.value());
         mPriv->readinessHelper->setIntrospectCompleted(FeatureAccountBalance, true);
     } else {
@@ -1872,7 +2001,7 @@ PendingChannel *ConnectionLowlevel::createChannel(const QVariantMap &request,
                 QLatin1String("Invalid 'request' argument"));
     }
 
-    debug() << "Creating a Channel";
+    tpDebug() << "Creating a Channel";
     PendingChannel *channel = new PendingChannel(conn, request, true, timeout);
     return channel;
 }
@@ -1943,7 +2072,7 @@ PendingChannel *ConnectionLowlevel::ensureChannel(const QVariantMap &request,
                 QLatin1String("Invalid 'request' argument"));
     }
 
-    debug() << "Creating a Channel";
+    tpDebug() << "Creating a Channel";
     PendingChannel *channel = new PendingChannel(conn, request, false, timeout);
     return channel;
 }
@@ -1980,7 +2109,8 @@ PendingChannel *ConnectionLowlevel::ensureChannel(const QVariantMap &request,
  */
 PendingHandles *ConnectionLowlevel::requestHandles(HandleType handleType, const QStringList &names)
 {
-    debug() << "Request for" << names.length() << "handles of type" << handleType;
+    TP_QT_DEBUG(DebugCategoryConnection) << "Request for" << names.length() <<
+        "handles of type" << handleType;
 
     if (!isValid()) {
         return new PendingHandles(TP_QT_ERROR_NOT_AVAILABLE,
@@ -2032,7 +2162,8 @@ PendingHandles *ConnectionLowlevel::requestHandles(HandleType handleType, const
  */
 PendingHandles *ConnectionLowlevel::referenceHandles(HandleType handleType, const UIntList &handles)
 {
-    debug() << "Reference of" << handles.length() << "handles of type" << handleType;
+    TP_QT_DEBUG(DebugCategoryConnection) << "Reference of" << handles.length() <<
+        "handles of type" << handleType;
 
     if (!isValid()) {
         return new PendingHandles(TP_QT_ERROR_NOT_AVAILABLE,
@@ -2056,7 +2187,7 @@ PendingHandles *ConnectionLowlevel::referenceHandles(HandleType handleType, cons
             }
         }
 
-        debug() << " Already holding" << alreadyHeld.size() <<
+        TP_QT_DEBUG(DebugCategoryConnection) << " Already holding" << alreadyHeld.size() <<
             "of the handles -" << notYetHeld.size() << "to go";
     } else {
         alreadyHeld = handles;
@@ -2160,7 +2291,7 @@ PendingOperation *ConnectionLowlevel::requestDisconnect()
 PendingContactAttributes *ConnectionLowlevel::contactAttributes(const UIntList &handles,
         const QStringList &interfaces, bool reference)
 {
-    debug() << "Request for attributes for" << handles.size() << "contacts";
+    tpDebug() << "Request for attributes for" << handles.size() << "contacts";
 
     if (!isValid()) {
         PendingContactAttributes *pending = new PendingContactAttributes(ConnectionPtr(),
@@ -2278,6 +2409,115 @@ bool ConnectionLowlevel::hasImmortalHandles() const
     return connection()->mPriv->immortalHandles;
 }
 
+/**
+ * Return the number of handles of the given type currently held on the connection.
+ *
+ * This includes the handles which are referenced, as well as the ones which lost their last
+ * reference less than handleReleaseGracePeriod() ago and will be revived without any D-Bus call if
+ * they're referenced again.
+ *
+ * If the connection has immortal handles, handles are not tracked and this method returns 0.
+ *
+ * \param handleType Type of the handles, as specified in #HandleType.
+ * \return The number of handles held.
+ * \sa referencedHandleCount()
+ */
+int ConnectionLowlevel::heldHandleCount(HandleType handleType) const
+{
+    if (!isValid() || hasImmortalHandles()) {
+        return 0;
+    }
+
+    ConnectionPtr conn(connection());
+    Connection::Private::HandleContext *handleContext = conn->mPriv->handleContext;
+    QMutexLocker locker(&handleContext->lock);
+
+    Connection::Private::HandleContext::Type type = handleContext->types.value(handleType);
+    return type.refcounts.size() + type.toRelease.size();
+}
+
+/**
+ * Return the number of handles of the given type currently referenced on the connection.
+ *
+ * If the connection has immortal handles, handles are not tracked and this method returns 0.
+ *
+ * \param handleType Type of the handles, as specified in #HandleType.
+ * \return The number of handles referenced.
+ * \sa heldHandleCount()
+ */
+int ConnectionLowlevel::referencedHandleCount(HandleType handleType) const
+{
+    if (!isValid() || hasImmortalHandles()) {
+        return 0;
+    }
+
+    ConnectionPtr conn(connection());
+    Connection::Private::HandleContext *handleContext = conn->mPriv->handleContext;
+    QMutexLocker locker(&handleContext->lock);
+
+    return handleContext->types.value(handleType).refcounts.size();
+}
+
+/**
+ * Return for how long handles are kept after losing their last reference, before being released.
+ *
+ * The default is 0, meaning handles are released as soon as the mainloop is reentered after losing
+ * their last reference.
+ *
+ * \return The grace period in milliseconds.
+ * \sa setHandleReleaseGracePeriod()
+ */
+int ConnectionLowlevel::handleReleaseGracePeriod() const
+{
+    if (!isValid()) {
+        return 0;
+    }
+
+    ConnectionPtr conn(connection());
+    Connection::Private::HandleContext *handleContext = conn->mPriv->handleContext;
+    QMutexLocker locker(&handleContext->lock);
+
+    return handleContext->releaseGracePeriod;
+}
+
+/**
+ * Set for how long handles are kept after losing their last reference, before being released.
+ *
+ * A handle which is referenced again during that period is revived without making any D-Bus call,
+ * which avoids repeated HoldHandles and ReleaseHandles calls for handles which come and go, such as
+ * the ones of contacts being looked up over and over. Setting a grace period of 0 releases handles
+ * as soon as the mainloop is reentered.
+ *
+ * The grace period is shared by all Connection proxies for the same connection.
+ *
+ * \param msec The grace period in milliseconds.
+ * \sa handleReleaseGracePeriod()
+ */
+void ConnectionLowlevel::setHandleReleaseGracePeriod(int msec)
+{
+    if (!isValid()) {
+        return;
+    }
+
+    ConnectionPtr conn(connection());
+    Connection::Private::HandleContext *handleContext = conn->mPriv->handleContext;
+    QMutexLocker locker(&handleContext->lock);
+
+    handleContext->releaseGracePeriod = qMax(msec, 0);
+
+    if (hasImmortalHandles()) {
+        return;
+    }
+
+    // Let the handles waiting to be released be reconsidered with the new grace period
+    foreach (uint handleType, handleContext->types.keys()) {
+        const Connection::Private::HandleContext::Type &type = handleContext->types[handleType];
+        if (!type.toRelease.isEmpty() && !type.requestsInFlight) {
+            conn->mPriv->scheduleReleaseSweep(handleType, 0);
+        }
+    }
+}
+
 /**
  * Return the ContactManager object for this connection.
  *
@@ -2310,9 +2550,8 @@ void Connection::refHandle(HandleType handleType, uint handle)
     Private::HandleContext *handleContext = mPriv->handleContext;
     QMutexLocker locker(&handleContext->lock);
 
-    if (handleContext->types[handleType].toRelease.contains(handle)) {
-        handleContext->types[handleType].toRelease.remove(handle);
-    }
+    // Reviving a handle kept around after losing its last reference doesn't need any D-Bus call
+    handleContext->types[handleType].toRelease.remove(handle);
 
     handleContext->types[handleType].refcounts[handle]++;
 }
@@ -2331,22 +2570,22 @@ void Connection::unrefHandle(HandleType handleType, uint handle)
 
     if (!--handleContext->types[handleType].refcounts[handle]) {
         handleContext->types[handleType].refcounts.remove(handle);
-        handleContext->types[handleType].toRelease.insert(handle);
+        QTime now;
+        now.start();
+        handleContext->types[handleType].toRelease.insert(handle, now);
 
         if (!handleContext->types[handleType].releaseScheduled) {
             if (!handleContext->types[handleType].requestsInFlight) {
-                debug() << "Lost last reference to at least one handle of type" <<
+                TP_QT_DEBUG(DebugCategoryConnection) << "Lost last reference to at least one handle of type" <<
                     handleType <<
                     "and no requests in flight for that type - scheduling a release sweep";
-                QMetaObject::invokeMethod(this, "doReleaseSweep",
-                        Qt::QueuedConnection, Q_ARG(uint, handleType));
-                handleContext->types[handleType].releaseScheduled = true;
+                mPriv->scheduleReleaseSweep(handleType, handleContext->releaseGracePeriod);
             }
         }
     }
 }
 
-void Connection::doReleaseSweep(uint handleType)
+void Connection::doReleaseSweeps()
 {
     if (mPriv->immortalHandles) {
         return;
@@ -2355,26 +2594,11 @@ void Connection::doReleaseSweep(uint handleType)
     Private::HandleContext *handleContext = mPriv->handleContext;
     QMutexLocker locker(&handleContext->lock);
 
-    Q_ASSERT(handleContext->types.contains(handleType));
-    Q_ASSERT(handleContext->types[handleType].releaseScheduled);
-
-    debug() << "Entering handle release sweep for type" << handleType;
-    handleContext->types[handleType].releaseScheduled = false;
-
-    if (handleContext->types[handleType].requestsInFlight > 0) {
-        debug() << " There are requests in flight, deferring sweep to when they have been completed";
-        return;
-    }
-
-    if (handleContext->types[handleType].toRelease.isEmpty()) {
-        debug() << " No handles to release - every one has been resurrected";
-        return;
+    foreach (uint handleType, handleContext->types.keys()) {
+        if (handleContext->types[handleType].releaseScheduled) {
+            mPriv->releaseExpiredHandles(handleType);
+        }
     }
-
-    debug() << " Releasing" << handleContext->types[handleType].toRelease.size() << "handles";
-
-    mPriv->baseInterface->ReleaseHandles(handleType, handleContext->types[handleType].toRelease.toList());
-    handleContext->types[handleType].toRelease.clear();
 }
 
 void Connection::handleRequestLanded(HandleType handleType)
@@ -2392,10 +2616,57 @@ void Connection::handleRequestLanded(HandleType handleType)
     if (!--handleContext->types[handleType].requestsInFlight &&
         !handleContext->types[handleType].toRelease.isEmpty() &&
         !handleContext->types[handleType].releaseScheduled) {
-        debug() << "All handle requests for type" << handleType <<
+        TP_QT_DEBUG(DebugCategoryConnection) << "All handle requests for type" << handleType <<
             "landed and there are handles of that type to release - scheduling a release sweep";
-        QMetaObject::invokeMethod(this, "doReleaseSweep", Qt::QueuedConnection, Q_ARG(uint, handleType));
-        handleContext->types[handleType].releaseScheduled = true;
+        // The sweep only releases the handles which have been unreferenced for long enough
+        mPriv->scheduleReleaseSweep(handleType, 0);
+    }
+}
+
+void Connection::holdHandles(HandleType handleType, const UIntList &handles,
+        PendingHandles *pending)
+{
+    Private::HoldBatch &batch = mPriv->holdBatches[handleType];
+    foreach (uint handle, handles) {
+        if (!batch.handles.contains(handle)) {
+            batch.handles << handle;
+        }
+    }
+    batch.requests << QPointer<PendingHandles>(pending);
+
+    if (!mPriv->holdBatchesScheduled) {
+        QMetaObject::invokeMethod(this, "doHoldHandles", Qt::QueuedConnection);
+        mPriv->holdBatchesScheduled = true;
+    }
+}
+
+void Connection::doHoldHandles()
+{
+    QHash<uint, Private::HoldBatch> batches = mPriv->holdBatches;
+    mPriv->holdBatches.clear();
+    mPriv->holdBatchesScheduled = false;
+
+    for (QHash<uint, Private::HoldBatch>::const_iterator i = batches.constBegin();
+            i != batches.constEnd(); ++i) {
+        const Private::HoldBatch &batch = i.value();
+
+        TP_QT_DEBUG(DebugCategoryConnection) << "Calling HoldHandles for" <<
+            batch.handles.size() << "handles of type" << i.key() << "on behalf of" <<
+            batch.requests.size() << "requests";
+
+        QDBusPendingCallWatcher *watcher =
+            new QDBusPendingCallWatcher(
+                    mPriv->baseInterface->HoldHandles(i.key(), batch.handles),
+                    this);
+        connect(watcher,
+                SIGNAL(finished(QDBusPendingCallWatcher*)),
+                SLOT(deleteLater()));
+
+        foreach (const QPointer<PendingHandles> &pending, batch.requests) {
+            if (pending) {
+                pending->holdHandlesCalled(watcher, batch.requests.size() > 1);
+            }
+        }
     }
 }
 
@@ -2406,11 +2677,11 @@ void Connection::onSelfHandleChanged(uint handle)
     }
 
     if (mPriv->pendingStatus != ConnectionStatusConnected || !mPriv->selfHandle) {
-        debug() << "Got a self handle change before we have the initial self handle, ignoring";
+        tpDebug() << "Got a self handle change before we have the initial self handle, ignoring";
         return;
     }
 
-    debug() << "Connection self handle changed to" << handle;
+    tpDebug() << "Connection self handle changed to" << handle;
     mPriv->selfHandle = handle;
     emit selfHandleChanged(handle);
 
@@ -2418,13 +2689,13 @@ void Connection::onSelfHandleChanged(uint handle)
         // We're currently introspecting the SelfContact feature, but have started building the
         // contact with the old handle, so we need to do it again with the new handle.
 
-        debug() << "The self contact is being built, will rebuild with the new handle shortly";
+        tpDebug() << "The self contact is being built, will rebuild with the new handle shortly";
         mPriv->reintrospectSelfContactRequired = true;
     } else if (isReady(FeatureSelfContact)) {
         // We've already introspected the SelfContact feature, so we can reinvoke the introspection
         // logic directly to rebuild with the new handle.
 
-        debug() << "Re-building self contact for handle" << handle;
+        tpDebug() << "Re-building self contact for handle" << handle;
         Private::introspectSelfContact(mPriv);
     }
 
@@ -216,7 +216,8 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onIntrospectRosterFinished(Tp::PendingOperation *op);
     TP_QT_NO_EXPORT void onIntrospectRosterGroupsFinished(Tp::PendingOperation *op);
 
-    TP_QT_NO_EXPORT void doReleaseSweep(uint handleType);
+    TP_QT_NO_EXPORT void doReleaseSweeps();
+    TP_QT_NO_EXPORT void doHoldHandles();
 
     TP_QT_NO_EXPORT void onSelfHandleChanged(uint);
 
@@ -236,6 +237,8 @@ private:
     TP_QT_NO_EXPORT void refHandle(HandleType handleType, uint handle);
     TP_QT_NO_EXPORT void unrefHandle(HandleType handleType, uint handle);
     TP_QT_NO_EXPORT void handleRequestLanded(HandleType handleType);
+    TP_QT_NO_EXPORT void holdHandles(HandleType handleType, const UIntList &handles,
+            PendingHandles *pending);
 
     struct Private;
     friend struct Private;
@@ -0,0 +1,292 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/contact-attributes-cache.h"
+
+#include "TelepathyQt/cache-file.h"
+#include "TelepathyQt/debug-internal.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+
+namespace Tp
+{
+
+// The file starts with a magic number and a format version, followed by the number of entries
+// and, for each entry, the contact identifier and its attributes
+static const quint32 cacheMagic = 0x54504341; // "TPCA"
+static const quint32 cacheVersion = 1;
+
+struct TP_QT_NO_EXPORT ContactAttributesCache::Private
+{
+    Private();
+    Private(const QString &fName);
+
+    void setError(ContactAttributesCache::Status status, const QString &reason);
+    bool read(const QByteArray &data);
+
+    static bool isStorable(const QVariant &value);
+
+    QString fileName;
+    ContactAttributesCache::Status status;
+    QHash<QString, QVariantMap> entries;
+    bool modified;
+};
+
+ContactAttributesCache::Private::Private()
+    : status(ContactAttributesCache::None),
+      modified(false)
+{
+}
+
+ContactAttributesCache::Private::Private(const QString &fName)
+    : fileName(fName),
+      status(ContactAttributesCache::None),
+      modified(false)
+{
+}
+
+void ContactAttributesCache::Private::setError(ContactAttributesCache::Status st,
+        const QString &reason)
+{
+    tpDebug() << QString(QLatin1String("Contact attributes cache: filename(%1) reason(%2)"))
+                       .arg(fileName).arg(reason);
+    status = st;
+    entries.clear();
+}
+
+bool ContactAttributesCache::Private::read(const QByteArray &data)
+{
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic) {
+        setError(ContactAttributesCache::FormatError, QLatin1String("invalid header"));
+        return false;
+    }
+
+    if (version != cacheVersion) {
+        // not an error as such, the cache will just be rebuilt
+        setError(ContactAttributesCache::FormatError,
+                QString(QLatin1String("unsupported version %1")).arg(version));
+        return false;
+    }
+
+    entries.reserve(count);
+    QString identifier;
+    QVariantMap attributes;
+    for (quint32 i = 0; i < count; ++i) {
+        in >> identifier >> attributes;
+        if (in.status() != QDataStream::Ok) {
+            setError(ContactAttributesCache::FormatError,
+                    QString(QLatin1String("truncated entry %1")).arg(i));
+            return false;
+        }
+        entries.insert(identifier, attributes);
+    }
+
+    return true;
+}
+
+bool ContactAttributesCache::Private::isStorable(const QVariant &value)
+{
+    if (!value.isValid() || value.userType() >= QVariant::UserType) {
+        return false;
+    }
+
+    if (value.type() == QVariant::Map) {
+        QVariantMap map = value.toMap();
+        for (QVariantMap::const_iterator i = map.constBegin(); i != map.constEnd(); ++i) {
+            if (!isStorable(i.value())) {
+                return false;
+            }
+        }
+    } else if (value.type() == QVariant::List) {
+        foreach (const QVariant &item, value.toList()) {
+            if (!isStorable(item)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+ContactAttributesCache::ContactAttributesCache()
+    : mPriv(new Private())
+{
+}
+
+ContactAttributesCache::ContactAttributesCache(const QString &fileName)
+    : mPriv(new Private(fileName))
+{
+    load();
+}
+
+ContactAttributesCache::~ContactAttributesCache()
+{
+    delete mPriv;
+}
+
+void ContactAttributesCache::setFileName(const QString &fileName)
+{
+    mPriv->fileName = fileName;
+    mPriv->status = None;
+    mPriv->entries.clear();
+    mPriv->modified = false;
+    load();
+}
+
+QString ContactAttributesCache::fileName() const
+{
+    return mPriv->fileName;
+}
+
+ContactAttributesCache::Status ContactAttributesCache::status() const
+{
+    return mPriv->status;
+}
+
+bool ContactAttributesCache::load()
+{
+    mPriv->entries.clear();
+    mPriv->modified = false;
+    mPriv->status = NoError;
+
+    QFile file(mPriv->fileName);
+    if (!file.exists()) {
+        mPriv->setError(NotFoundError, QLatin1String("file does not exist"));
+        return false;
+    }
+
+    if (!file.open(QFile::ReadOnly)) {
+        mPriv->setError(AccessError, QLatin1String("cannot open file for readonly access"));
+        return false;
+    }
+
+    // Map the file rather than reading it, so a big cache is paged in as it gets parsed instead
+    // of being copied in full first
+    qint64 size = file.size();
+    uchar *mapped = size > 0 ? file.map(0, size) : 0;
+    if (mapped) {
+        bool ret = mPriv->read(QByteArray::fromRawData(
+                    reinterpret_cast<const char *>(mapped), size));
+        file.unmap(mapped);
+        return ret;
+    }
+
+    return mPriv->read(file.readAll());
+}
+
+bool ContactAttributesCache::save()
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << cacheMagic << cacheVersion << static_cast<quint32>(mPriv->entries.size());
+    for (QHash<QString, QVariantMap>::const_iterator i = mPriv->entries.constBegin();
+            i != mPriv->entries.constEnd(); ++i) {
+        out << i.key() << i.value();
+    }
+
+    if (out.status() != QDataStream::Ok) {
+        warning() << "Error serializing contact attributes cache" << mPriv->fileName;
+        return false;
+    }
+
+    if (!saveCacheFile(mPriv->fileName, data)) {
+        return false;
+    }
+
+    mPriv->status = NoError;
+    mPriv->modified = false;
+    return true;
+}
+
+bool ContactAttributesCache::isModified() const
+{
+    return mPriv->modified;
+}
+
+int ContactAttributesCache::size() const
+{
+    return mPriv->entries.size();
+}
+
+QStringList ContactAttributesCache::identifiers() const
+{
+    return mPriv->entries.keys();
+}
+
+bool ContactAttributesCache::contains(const QString &identifier) const
+{
+    return mPriv->entries.contains(identifier);
+}
+
+QVariantMap ContactAttributesCache::attributes(const QString &identifier) const
+{
+    return mPriv->entries.value(identifier);
+}
+
+void ContactAttributesCache::setAttributes(const QString &identifier,
+        const QVariantMap &attributes)
+{
+    // D-Bus arguments which haven't been demarshalled can't be saved, so they're left out
+    QVariantMap storable;
+    for (QVariantMap::const_iterator i = attributes.constBegin(); i != attributes.constEnd(); ++i) {
+        if (Private::isStorable(i.value())) {
+            storable.insert(i.key(), i.value());
+        } else {
+            tpDebug() << "Not caching contact attribute" << i.key() << "of type" <<
+                i.value().typeName();
+        }
+    }
+
+    QHash<QString, QVariantMap>::iterator i = mPriv->entries.find(identifier);
+    if (i == mPriv->entries.end()) {
+        mPriv->entries.insert(identifier, storable);
+        mPriv->modified = true;
+    } else if (i.value() != storable) {
+        i.value() = storable;
+        mPriv->modified = true;
+    }
+}
+
+void ContactAttributesCache::remove(const QString &identifier)
+{
+    if (mPriv->entries.remove(identifier)) {
+        mPriv->modified = true;
+    }
+}
+
+void ContactAttributesCache::clear()
+{
+    if (!mPriv->entries.isEmpty()) {
+        mPriv->entries.clear();
+        mPriv->modified = true;
+    }
+}
+
+} // Tp
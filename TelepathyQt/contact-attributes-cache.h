@@ -0,0 +1,80 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_contact_attributes_cache_h_HEADER_GUARD_
+#define _TelepathyQt_contact_attributes_cache_h_HEADER_GUARD_
+
+#include <TelepathyQt/Global>
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace Tp
+{
+
+class TP_QT_NO_EXPORT ContactAttributesCache
+{
+public:
+    enum Status {
+        None = 0,
+        NoError,
+        NotFoundError,
+        AccessError,
+        FormatError,
+    };
+
+    ContactAttributesCache();
+    ContactAttributesCache(const QString &fileName);
+    ~ContactAttributesCache();
+
+    void setFileName(const QString &fileName);
+    QString fileName() const;
+
+    Status status() const;
+
+    bool load();
+    bool save();
+    bool isModified() const;
+
+    int size() const;
+    QStringList identifiers() const;
+    bool contains(const QString &identifier) const;
+    QVariantMap attributes(const QString &identifier) const;
+    void setAttributes(const QString &identifier, const QVariantMap &attributes);
+    void remove(const QString &identifier);
+    void clear();
+
+private:
+    Q_DISABLE_COPY(ContactAttributesCache)
+
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+};
+
+}
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+#endif
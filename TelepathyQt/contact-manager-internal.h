@@ -98,6 +98,9 @@ private Q_SLOTS:
 
     void gotContactListProperties(Tp::PendingOperation *op);
     void gotContactListContacts(QDBusPendingCallWatcher *watcher);
+    void gotAttributesCacheSelfId(Tp::PendingOperation *op);
+    void gotUncachedContactListAttributes(Tp::PendingOperation *op);
+    void onAttributesCacheRevalidated(Tp::PendingOperation *op);
     void setStateSuccess();
     void onContactListStateChanged(uint state);
     void onContactListContactsChangedWithId(const Tp::ContactSubscriptionMap &changes,
@@ -174,6 +177,10 @@ private:
     void introspectContactBlockingBlockedContacts();
     void introspectContactList();
     void introspectContactListContacts();
+    void addInitialContactListContacts();
+    void finishInitialContactListContacts();
+    QStringList attributesCacheInterfaces() const;
+    void revalidateAttributesCache(const UIntList &handles);
     void processContactListChanges();
     void processContactListBlockedContactsChanged();
     void processContactListUpdates();
@@ -245,6 +252,13 @@ private:
 
     // Contact list contacts using the Conn.I.ContactList API
     Contacts contactListContacts;
+    // Features taken from the persistent attributes cache instead of being introspected
+    Features attributesCacheFeatures;
+    // The initial contact list, held while the attributes cache is opened and the contacts
+    // missing from it are retrieved
+    ContactAttributesMap initialContactListAttributes;
+    bool addingInitialContactListContacts;
+    bool attributesCacheSelfIdPending;
     // Blocked contacts using the new ContactBlocking API
     Contacts blockedContacts;
 };
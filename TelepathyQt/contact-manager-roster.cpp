@@ -24,12 +24,14 @@
 
 #include "TelepathyQt/_gen/contact-manager-internal.moc.hpp"
 
+#include "TelepathyQt/contact-attributes-cache.h"
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/Connection>
 #include <TelepathyQt/ConnectionLowlevel>
 #include <TelepathyQt/ContactFactory>
 #include <TelepathyQt/PendingChannel>
+#include <TelepathyQt/PendingContactAttributes>
 #include <TelepathyQt/PendingContacts>
 #include <TelepathyQt/PendingFailure>
 #include <TelepathyQt/PendingHandles>
@@ -61,7 +63,9 @@ ContactManager::Roster::Roster(ContactManager *contactManager)
       processingContactListChanges(false),
       contactListChannelsReady(0),
       featureContactListGroupsTodo(0),
-      groupsSetSuccess(false)
+      groupsSetSuccess(false),
+      addingInitialContactListContacts(false),
+      attributesCacheSelfIdPending(false)
 {
 }
 
@@ -79,19 +83,19 @@ PendingOperation *ContactManager::Roster::introspect()
     ConnectionPtr conn(contactManager->connection());
 
     if (conn->hasInterface(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_LIST)) {
-        debug() << "Connection.ContactList found, using it";
+        tpDebug() << "Connection.ContactList found, using it";
 
         usingFallbackContactList = false;
 
         if (conn->hasInterface(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_BLOCKING)) {
-            debug() << "Connection.ContactBlocking found. using it";
+            tpDebug() << "Connection.ContactBlocking found. using it";
             hasContactBlockingInterface = true;
             introspectContactBlocking();
         } else {
-            debug() << "Connection.ContactBlocking not found, falling back "
+            tpDebug() << "Connection.ContactBlocking not found, falling back "
                 "to contact list deny channel";
 
-            debug() << "Requesting handle for deny channel";
+            tpDebug() << "Requesting handle for deny channel";
 
             contactListChannels.insert(ChannelInfo::TypeDeny,
                     ChannelInfo(ChannelInfo::TypeDeny));
@@ -104,7 +108,7 @@ PendingOperation *ContactManager::Roster::introspect()
                     SLOT(gotContactListChannelHandle(Tp::PendingOperation*)));
         }
     } else {
-        debug() << "Connection.ContactList not found, falling back to contact list channels";
+        tpDebug() << "Connection.ContactList not found, falling back to contact list channels";
 
         usingFallbackContactList = true;
 
@@ -112,7 +116,7 @@ PendingOperation *ContactManager::Roster::introspect()
             QString channelId = ChannelInfo::identifierForType(
                     (ChannelInfo::Type) i);
 
-            debug() << "Requesting handle for" << channelId << "channel";
+            tpDebug() << "Requesting handle for" << channelId << "channel";
 
             contactListChannels.insert(i,
                     ChannelInfo((ChannelInfo::Type) i));
@@ -142,10 +146,10 @@ PendingOperation *ContactManager::Roster::introspectGroups()
                     QLatin1String("Roster groups not supported"), conn);
         }
 
-        debug() << "Connection.ContactGroups found, using it";
+        tpDebug() << "Connection.ContactGroups found, using it";
 
         if (!gotContactListInitialContacts) {
-            debug() << "Initial ContactList contacts not retrieved. Postponing introspection";
+            tpDebug() << "Initial ContactList contacts not retrieved. Postponing introspection";
             groupsReintrospectionRequired = true;
             return new PendingSuccess(conn);
         }
@@ -171,7 +175,7 @@ PendingOperation *ContactManager::Roster::introspectGroups()
                 SIGNAL(finished(Tp::PendingOperation*)),
                 SLOT(gotContactListGroupsProperties(Tp::PendingOperation*)));
     } else {
-        debug() << "Connection.ContactGroups not found, falling back to contact list group channels";
+        tpDebug() << "Connection.ContactGroups not found, falling back to contact list group channels";
 
         ++featureContactListGroupsTodo; // decremented in gotChannels
 
@@ -180,12 +184,12 @@ PendingOperation *ContactManager::Roster::introspectGroups()
         Client::ConnectionInterfaceRequestsInterface *iface =
             conn->interface<Client::ConnectionInterfaceRequestsInterface>();
 
-        debug() << "Connecting to Requests.NewChannels";
+        tpDebug() << "Connecting to Requests.NewChannels";
         connect(iface,
                 SIGNAL(NewChannels(Tp::ChannelDetailsList)),
                 SLOT(onNewChannels(Tp::ChannelDetailsList)));
 
-        debug() << "Retrieving channels";
+        tpDebug() << "Retrieving channels";
         Client::DBus::PropertiesInterface *properties =
             contactManager->connection()->interface<Client::DBus::PropertiesInterface>();
         QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
@@ -594,19 +598,19 @@ PendingOperation *ContactManager::Roster::removeContacts(
          */
 
         if (storedChannel && storedChannel->groupCanRemoveContacts()) {
-            debug() << "Removing contacts from stored list";
+            tpDebug() << "Removing contacts from stored list";
             return storedChannel->groupRemoveContacts(contacts, message);
         }
 
         QList<PendingOperation*> operations;
 
         if (canRemovePresenceSubscription()) {
-            debug() << "Removing contacts from subscribe list";
+            tpDebug() << "Removing contacts from subscribe list";
             operations << removePresenceSubscription(contacts, message);
         }
 
         if (canRemovePresencePublication()) {
-            debug() << "Removing contacts from publish list";
+            tpDebug() << "Removing contacts from publish list";
             operations << removePresencePublication(contacts, message);
         }
 
@@ -700,7 +704,7 @@ void ContactManager::Roster::gotContactBlockingCapabilities(PendingOperation *op
         return;
     }
 
-    debug() << "Got ContactBlockingCapabilities property";
+    tpDebug() << "Got ContactBlockingCapabilities property";
 
     PendingVariant *pv = qobject_cast<PendingVariant*>(op);
 
@@ -724,7 +728,7 @@ void ContactManager::Roster::gotContactBlockingBlockedContacts(
         return;
     }
 
-    debug() << "Got initial ContactBlocking blocked contacts";
+    tpDebug() << "Got initial ContactBlocking blocked contacts";
 
     gotContactBlockingInitialBlockedContacts = true;
 
@@ -776,7 +780,7 @@ void ContactManager::Roster::gotContactListProperties(PendingOperation *op)
         return;
     }
 
-    debug() << "Got ContactList properties";
+    tpDebug() << "Got ContactList properties";
 
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
 
@@ -800,7 +804,7 @@ void ContactManager::Roster::gotContactListContacts(QDBusPendingCallWatcher *wat
         warning() << "Failed introspecting ContactList contacts";
 
         contactListState = ContactListStateFailure;
-        debug() << "Setting state to failure";
+        tpDebug() << "Setting state to failure";
         emit contactManager->stateChanged((Tp::ContactListState) contactListState);
 
         // We may have been in state Failure and then Success, and FeatureRoster is already ready
@@ -812,25 +816,162 @@ void ContactManager::Roster::gotContactListContacts(QDBusPendingCallWatcher *wat
         return;
     }
 
-    debug() << "Got initial ContactList contacts";
+    tpDebug() << "Got initial ContactList contacts";
 
+    // The changes signalled from now on apply on top of this contact list. They are queued until
+    // its contacts are all added, which may need more calls when the attributes cache is used
     gotContactListInitialContacts = true;
+    addingInitialContactListContacts = true;
+    initialContactListAttributes = reply.value();
 
+    if (attributesCacheSelfIdPending) {
+        tpDebug() << "Waiting for the self contact identifier to open the attributes cache";
+        return;
+    }
+
+    addInitialContactListContacts();
+}
+
+void ContactManager::Roster::gotAttributesCacheSelfId(PendingOperation *op)
+{
+    attributesCacheSelfIdPending = false;
+
+    if (op->isError()) {
+        // Without the cache, all of the contacts are retrieved with the full set of features
+        warning() << "Retrieving the self contact identifier failed, not using the attributes "
+            "cache:" << op->errorName() << "-" << op->errorMessage();
+    } else {
+        PendingContactAttributes *pa = qobject_cast<PendingContactAttributes *>(op);
+        ContactAttributesMap attrsMap = pa->attributes();
+        if (!attrsMap.isEmpty()) {
+            contactManager->loadContactAttributesCache(qdbus_cast<QString>(
+                        attrsMap.constBegin().value().value(
+                            TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id"))));
+        }
+    }
+
+    if (addingInitialContactListContacts) {
+        addInitialContactListContacts();
+    }
+}
+
+void ContactManager::Roster::addInitialContactListContacts()
+{
     ConnectionPtr conn(contactManager->connection());
-    ContactAttributesMap attrsMap = reply.value();
+    ContactAttributesCache *attributesCache = contactManager->contactAttributesCache();
+    Features features(conn->contactFactory()->features());
+    ContactAttributesMap attrsMap = initialContactListAttributes;
+    initialContactListAttributes.clear();
+
+    // Only the contacts having all of the features in the cache are taken from there, the others
+    // are retrieved with the full set of features before FeatureRoster becomes ready
+    UIntList cachedHandles;
     ContactAttributesMap::const_iterator begin = attrsMap.constBegin();
     ContactAttributesMap::const_iterator end = attrsMap.constEnd();
     for (ContactAttributesMap::const_iterator i = begin; i != end; ++i) {
         uint bareHandle = i.key();
         QVariantMap attrs = i.value();
 
+        if (!attributesCacheFeatures.isEmpty()) {
+            QVariantMap cached;
+            if (attributesCache) {
+                QString id = qdbus_cast<QString>(attrs.value(
+                            TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id")));
+                cached = attributesCache->attributes(id);
+            }
+
+            if (!ContactManager::featuresInCachedAttributes(cached).contains(
+                        attributesCacheFeatures)) {
+                initialContactListAttributes.insert(bareHandle, attrs);
+                continue;
+            }
+
+            QVariantMap cachedAttrs = ContactManager::attributesFromCache(cached);
+            for (QVariantMap::const_iterator j = cachedAttrs.constBegin();
+                    j != cachedAttrs.constEnd(); ++j) {
+                attrs.insert(j.key(), j.value());
+            }
+            cachedHandles << bareHandle;
+        }
+
         ContactPtr contact = contactManager->ensureContact(ReferencedHandles(conn,
                     HandleTypeContact, UIntList() << bareHandle),
-                conn->contactFactory()->features(), attrs);
+                features, attrs);
         cachedAllKnownContacts.insert(contact);
         contactListContacts.insert(contact);
     }
 
+    if (!cachedHandles.isEmpty()) {
+        revalidateAttributesCache(cachedHandles);
+    }
+
+    if (!initialContactListAttributes.isEmpty()) {
+        tpDebug() << "Retrieving the attributes of" << initialContactListAttributes.size() <<
+            "contacts missing from the attributes cache";
+        connect(conn->lowlevel()->contactAttributes(initialContactListAttributes.keys(),
+                    attributesCacheInterfaces(), true),
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(gotUncachedContactListAttributes(Tp::PendingOperation*)));
+        return;
+    }
+
+    finishInitialContactListContacts();
+}
+
+void ContactManager::Roster::gotUncachedContactListAttributes(PendingOperation *op)
+{
+    ConnectionPtr conn(contactManager->connection());
+    ContactAttributesCache *attributesCache = contactManager->contactAttributesCache();
+    Features features(conn->contactFactory()->features());
+    ContactAttributesMap attrsMap;
+
+    if (op->isError()) {
+        // The contacts are still added, but only with the features introspected along with the
+        // contact list
+        warning() << "Retrieving the attributes of contacts missing from the attributes cache "
+            "failed:" << op->errorName() << "-" << op->errorMessage();
+        features.subtract(attributesCacheFeatures);
+    } else {
+        PendingContactAttributes *pa = qobject_cast<PendingContactAttributes *>(op);
+        attrsMap = pa->attributes();
+    }
+
+    ContactAttributesMap::const_iterator begin = initialContactListAttributes.constBegin();
+    ContactAttributesMap::const_iterator end = initialContactListAttributes.constEnd();
+    for (ContactAttributesMap::const_iterator i = begin; i != end; ++i) {
+        uint bareHandle = i.key();
+        QVariantMap attrs = i.value();
+        QVariantMap fetchedAttrs = attrsMap.value(bareHandle);
+        for (QVariantMap::const_iterator j = fetchedAttrs.constBegin();
+                j != fetchedAttrs.constEnd(); ++j) {
+            attrs.insert(j.key(), j.value());
+        }
+
+        ContactPtr contact = contactManager->ensureContact(ReferencedHandles(conn,
+                    HandleTypeContact, UIntList() << bareHandle),
+                features, attrs);
+        cachedAllKnownContacts.insert(contact);
+        contactListContacts.insert(contact);
+
+        if (attributesCache && attrsMap.contains(bareHandle)) {
+            attributesCache->setAttributes(contact->id(),
+                    ContactManager::attributesToCache(fetchedAttrs, attributesCacheFeatures));
+        }
+    }
+    initialContactListAttributes.clear();
+
+    if (attributesCache && attributesCache->isModified()) {
+        tpDebug() << "Saving attributes of" << attributesCache->size() << "contacts to cache";
+        attributesCache->save();
+    }
+
+    finishInitialContactListContacts();
+}
+
+void ContactManager::Roster::finishInitialContactListContacts()
+{
+    addingInitialContactListContacts = false;
+
     if (contactManager->connection()->requestedFeatures().contains(
                 Connection::FeatureRosterGroups)) {
         groupsSetSuccess = true;
@@ -862,12 +1003,78 @@ void ContactManager::Roster::gotContactListContacts(QDBusPendingCallWatcher *wat
     if (groupsReintrospectionRequired) {
         introspectGroups();
     }
+
+    // Apply the changes queued while the contacts were being added
+    processContactListChanges();
+}
+
+QStringList ContactManager::Roster::attributesCacheInterfaces() const
+{
+    QStringList interfaces;
+    foreach (const Feature &feature, attributesCacheFeatures) {
+        interfaces << contactManager->featureToInterface(feature);
+    }
+    return interfaces;
+}
+
+void ContactManager::Roster::revalidateAttributesCache(const UIntList &handles)
+{
+    ConnectionPtr conn(contactManager->connection());
+
+    tpDebug() << "Revalidating cached attributes of" << handles.size() << "contacts";
+    connect(conn->lowlevel()->contactAttributes(handles, attributesCacheInterfaces(), true),
+            SIGNAL(finished(Tp::PendingOperation*)),
+            SLOT(onAttributesCacheRevalidated(Tp::PendingOperation*)));
+}
+
+void ContactManager::Roster::onAttributesCacheRevalidated(PendingOperation *op)
+{
+    ContactAttributesCache *attributesCache = contactManager->contactAttributesCache();
+    if (!attributesCache) {
+        return;
+    }
+
+    if (op->isError()) {
+        warning() << "Revalidating cached contact attributes failed:" <<
+            op->errorName() << "-" << op->errorMessage();
+        return;
+    }
+
+    PendingContactAttributes *pa = qobject_cast<PendingContactAttributes *>(op);
+    ConnectionPtr conn(contactManager->connection());
+    ContactAttributesMap attrsMap = pa->attributes();
+    for (ContactAttributesMap::const_iterator i = attrsMap.constBegin();
+            i != attrsMap.constEnd(); ++i) {
+        // Augmenting the contacts with the current values makes them emit the change
+        // notification signals for the attributes which differ from the cached ones
+        ContactPtr contact = contactManager->ensureContact(ReferencedHandles(conn,
+                    HandleTypeContact, UIntList() << i.key()),
+                attributesCacheFeatures, i.value());
+        attributesCache->setAttributes(contact->id(),
+                ContactManager::attributesToCache(i.value(), attributesCacheFeatures));
+    }
+
+    // Forget about the contacts which are not in the contact list anymore
+    QSet<QString> ids;
+    foreach (const ContactPtr &contact, contactListContacts) {
+        ids.insert(contact->id());
+    }
+    foreach (const QString &id, attributesCache->identifiers()) {
+        if (!ids.contains(id)) {
+            attributesCache->remove(id);
+        }
+    }
+
+    if (attributesCache->isModified()) {
+        tpDebug() << "Saving attributes of" << attributesCache->size() << "contacts to cache";
+        attributesCache->save();
+    }
 }
 
 void ContactManager::Roster::setStateSuccess()
 {
     if (contactManager->connection()->isValid()) {
-        debug() << "State is now success";
+        tpDebug() << "State is now success";
         contactListState = ContactListStateSuccess;
         emit contactManager->stateChanged((Tp::ContactListState) contactListState);
     }
@@ -890,7 +1097,7 @@ void ContactManager::Roster::onContactListStateChanged(uint state)
     contactListState = state;
 
     if (state == ContactListStateFailure) {
-        debug() << "State changed to failure, finishing roster introspection";
+        tpDebug() << "State changed to failure, finishing roster introspection";
     }
 
     emit contactManager->stateChanged((Tp::ContactListState) state);
@@ -907,13 +1114,13 @@ void ContactManager::Roster::onContactListStateChanged(uint state)
 void ContactManager::Roster::onContactListContactsChangedWithId(const Tp::ContactSubscriptionMap &changes,
         const Tp::HandleIdentifierMap &ids, const Tp::HandleIdentifierMap &removals)
 {
-    debug() << "Got ContactList.ContactsChangedWithID with" << changes.size() <<
+    tpDebug() << "Got ContactList.ContactsChangedWithID with" << changes.size() <<
         "changes and" << removals.size() << "removals";
 
     gotContactListContactsChangedWithId = true;
 
     if (!gotContactListInitialContacts) {
-        debug() << "Ignoring ContactList changes until initial contacts are retrieved";
+        tpDebug() << "Ignoring ContactList changes until initial contacts are retrieved";
         return;
     }
 
@@ -932,11 +1139,11 @@ void ContactManager::Roster::onContactListContactsChanged(const Tp::ContactSubsc
         return;
     }
 
-    debug() << "Got ContactList.ContactsChanged with" << changes.size() <<
+    tpDebug() << "Got ContactList.ContactsChanged with" << changes.size() <<
         "changes and" << removals.size() << "removals";
 
     if (!gotContactListInitialContacts) {
-        debug() << "Ignoring ContactList changes until initial contacts are retrieved";
+        tpDebug() << "Ignoring ContactList changes until initial contacts are retrieved";
         return;
     }
 
@@ -977,7 +1184,7 @@ void ContactManager::Roster::onContactListBlockedContactsConstructed(Tp::Pending
             continue;
         }
 
-        debug() << "Contact" << contact->id() << "is now blocked";
+        tpDebug() << "Contact" << contact->id() << "is now blocked";
         blockedContacts.insert(contact);
         newBlockedContacts.insert(contact);
         contact->setBlocked(true);
@@ -994,7 +1201,7 @@ void ContactManager::Roster::onContactListBlockedContactsConstructed(Tp::Pending
             continue;
         }
 
-        debug() << "Contact" << contact->id() << "is now unblocked";
+        tpDebug() << "Contact" << contact->id() << "is now unblocked";
         blockedContacts.remove(contact);
         unblockedContacts.insert(contact);
         contact->setBlocked(false);
@@ -1172,7 +1379,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 
     if (op->isError()) {
         // let's not fail, because the contact lists are not supported
-        debug() << "Unable to retrieve handle for" << channelId << "channel, ignoring";
+        tpDebug() << "Unable to retrieve handle for" << channelId << "channel, ignoring";
         contactListChannels.remove(type);
         onContactListChannelReady();
         return;
@@ -1180,7 +1387,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 
     if (ph->invalidNames().size() == 1) {
         // let's not fail, because the contact lists are not supported
-        debug() << "Unable to retrieve handle for" << channelId << "channel, ignoring";
+        tpDebug() << "Unable to retrieve handle for" << channelId << "channel, ignoring";
         contactListChannels.remove(type);
         onContactListChannelReady();
         return;
@@ -1188,7 +1395,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 
     Q_ASSERT(ph->handles().size() == 1);
 
-    debug() << "Got handle for" << channelId << "channel";
+    tpDebug() << "Got handle for" << channelId << "channel";
 
     if (!usingFallbackContactList) {
         Q_ASSERT(type == ChannelInfo::TypeDeny);
@@ -1199,7 +1406,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
     ReferencedHandles handle = ph->handles();
     contactListChannels[type].handle = handle;
 
-    debug() << "Requesting channel for" << channelId << "channel";
+    tpDebug() << "Requesting channel for" << channelId << "channel";
     QVariantMap request;
     request.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
             TP_QT_IFACE_CHANNEL_TYPE_CONTACT_LIST);
@@ -1219,7 +1426,7 @@ void ContactManager::Roster::gotContactListChannelHandle(PendingOperation *op)
 void ContactManager::Roster::gotContactListChannel(PendingOperation *op)
 {
     if (op->isError()) {
-        debug() << "Unable to create channel, ignoring";
+        tpDebug() << "Unable to create channel, ignoring";
         onContactListChannelReady();
         return;
     }
@@ -1264,7 +1471,7 @@ void ContactManager::Roster::onContactListChannelReady()
     } else if (++contactListChannelsReady == ChannelInfo::LastType) {
         if (contactListChannels.isEmpty()) {
             contactListState = ContactListStateFailure;
-            debug() << "State is failure, roster not supported";
+            tpDebug() << "State is failure, roster not supported";
             emit contactManager->stateChanged((Tp::ContactListState) contactListState);
 
             Q_ASSERT(introspectPendingOp);
@@ -1332,7 +1539,7 @@ void ContactManager::Roster::gotContactListGroupsProperties(PendingOperation *op
         return;
     }
 
-    debug() << "Got contact list groups properties";
+    tpDebug() << "Got contact list groups properties";
     PendingVariantMap *pvm = qobject_cast<PendingVariantMap*>(op);
 
     QVariantMap props = pvm->result();
@@ -1429,7 +1636,7 @@ void ContactManager::Roster::gotChannels(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QVariant> reply = *watcher;
 
     if (!reply.isError()) {
-        debug() << "Got channels";
+        tpDebug() << "Got channels";
         onNewChannels(qdbus_cast<ChannelDetailsList>(reply.value()));
     } else {
         warning().nospace() << "Getting channels failed with " <<
@@ -1459,11 +1666,11 @@ void ContactManager::Roster::onStoredChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "on stored list";
+        tpDebug() << "Contact" << contact->id() << "on stored list";
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from stored list";
+        tpDebug() << "Contact" << contact->id() << "removed from stored list";
     }
 
     // Perform the needed computation for allKnownContactsChanged
@@ -1484,17 +1691,17 @@ void ContactManager::Roster::onSubscribeChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "on subscribe list";
+        tpDebug() << "Contact" << contact->id() << "on subscribe list";
         contact->setSubscriptionState(SubscriptionStateYes);
     }
 
     foreach (ContactPtr contact, groupRemotePendingMembersAdded) {
-        debug() << "Contact" << contact->id() << "added to subscribe list";
+        tpDebug() << "Contact" << contact->id() << "added to subscribe list";
         contact->setSubscriptionState(SubscriptionStateAsk);
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from subscribe list";
+        tpDebug() << "Contact" << contact->id() << "removed from subscribe list";
         contact->setSubscriptionState(SubscriptionStateNo);
     }
 
@@ -1516,17 +1723,17 @@ void ContactManager::Roster::onPublishChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "on publish list";
+        tpDebug() << "Contact" << contact->id() << "on publish list";
         contact->setPublishState(SubscriptionStateYes);
     }
 
     foreach (ContactPtr contact, groupLocalPendingMembersAdded) {
-        debug() << "Contact" << contact->id() << "added to publish list";
+        tpDebug() << "Contact" << contact->id() << "added to publish list";
         contact->setPublishState(SubscriptionStateAsk, details.message());
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from publish list";
+        tpDebug() << "Contact" << contact->id() << "removed from publish list";
         contact->setPublishState(SubscriptionStateNo);
     }
 
@@ -1556,12 +1763,12 @@ void ContactManager::Roster::onDenyChannelMembersChanged(
     }
 
     foreach (ContactPtr contact, groupMembersAdded) {
-        debug() << "Contact" << contact->id() << "added to deny list";
+        tpDebug() << "Contact" << contact->id() << "added to deny list";
         contact->setBlocked(true);
     }
 
     foreach (ContactPtr contact, groupMembersRemoved) {
-        debug() << "Contact" << contact->id() << "removed from deny list";
+        tpDebug() << "Contact" << contact->id() << "removed from deny list";
         contact->setBlocked(false);
     }
 
@@ -1614,7 +1821,7 @@ void ContactManager::Roster::onContactListGroupRemoved(Tp::DBusProxy *proxy,
 
 void ContactManager::Roster::introspectContactBlocking()
 {
-    debug() << "Requesting ContactBlockingCapabilities property";
+    tpDebug() << "Requesting ContactBlockingCapabilities property";
 
     ConnectionPtr conn(contactManager->connection());
 
@@ -1649,7 +1856,7 @@ void ContactManager::Roster::introspectContactBlockingBlockedContacts()
 
 void ContactManager::Roster::introspectContactList()
 {
-    debug() << "Requesting ContactList properties";
+    tpDebug() << "Requesting ContactList properties";
 
     ConnectionPtr conn(contactManager->connection());
 
@@ -1681,11 +1888,35 @@ void ContactManager::Roster::introspectContactListContacts()
 
     Features features(conn->contactFactory()->features());
     Features supportedFeatures(contactManager->supportedFeatures());
+
+    // Features which can be filled in from the attributes cache are revalidated once the
+    // contact list is ready instead
+    attributesCacheFeatures = Features();
+    if (contactManager->isContactAttributesCacheEnabled()) {
+        attributesCacheFeatures = features;
+        attributesCacheFeatures.intersect(ContactManager::cacheableFeatures());
+        attributesCacheFeatures.intersect(supportedFeatures);
+    }
+
+    // The cache is kept per account, which is identified by the self contact identifier. It's
+    // retrieved while the contact list is, unless the self contact is already known.
+    if (!attributesCacheFeatures.isEmpty() && !contactManager->contactAttributesCache()) {
+        if (conn->selfContact()) {
+            contactManager->loadContactAttributesCache(conn->selfContact()->id());
+        } else if (!attributesCacheSelfIdPending) {
+            attributesCacheSelfIdPending = true;
+            connect(conn->lowlevel()->contactAttributes(UIntList() << conn->selfHandle(),
+                        QStringList(), false),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(gotAttributesCacheSelfId(Tp::PendingOperation*)));
+        }
+    }
+
     QSet<QString> interfaces;
     foreach (const Feature &feature, features) {
         contactManager->ensureTracking(feature);
 
-        if (supportedFeatures.contains(feature)) {
+        if (supportedFeatures.contains(feature) && !attributesCacheFeatures.contains(feature)) {
             // Only query interfaces which are reported as supported to not get an error
             interfaces.insert(contactManager->featureToInterface(feature));
         }
@@ -1701,7 +1932,8 @@ void ContactManager::Roster::introspectContactListContacts()
 
 void ContactManager::Roster::processContactListChanges()
 {
-    if (processingContactListChanges || contactListChangesQueue.isEmpty()) {
+    if (processingContactListChanges || addingInitialContactListContacts ||
+            contactListChangesQueue.isEmpty()) {
         return;
     }
 
@@ -25,7 +25,10 @@
 
 #include "TelepathyQt/_gen/contact-manager.moc.hpp"
 
+#include "TelepathyQt/avatar-cache.h"
+#include "TelepathyQt/contact-attributes-cache.h"
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-set.h"
 #include "TelepathyQt/future-internal.h"
 
 #include <TelepathyQt/AvatarData>
@@ -42,6 +45,8 @@
 #include <TelepathyQt/Utils>
 
 #include <QMap>
+#include <QPointer>
+#include <QUrl>
 
 namespace Tp
 {
@@ -52,8 +57,8 @@ struct TP_QT_NO_EXPORT ContactManager::Private
     ~Private();
 
     // avatar specific methods
-    bool buildAvatarFileName(QString token, bool createDir,
-        QString &avatarFileName, QString &mimeTypeFileName);
+    AvatarCache *ensureAvatarCache();
+    QString buildAttributesCacheFileName(const QString &selfId);
     Features realFeatures(const Features &features);
     QSet<QString> interfacesForFeatures(const Features &features);
 
@@ -69,9 +74,32 @@ struct TP_QT_NO_EXPORT ContactManager::Private
     // avatar
     QSet<ContactPtr> requestAvatarsQueue;
     bool requestAvatarsIdle;
+    AvatarCache *avatarCache;
+    qint64 avatarCacheSizeLimit;
+    bool syncAvatarCacheIdle;
 
     // contact info
     PendingRefreshContactInfo *refreshInfoOp;
+
+    // contact attributes request coalescing
+    int attributesBatchInterval;
+    bool attributesBatchScheduled;
+    UIntList attributesBatchHandles;
+    QSet<uint> attributesBatchHandlesSet;
+    QSet<QString> attributesBatchInterfaces;
+    QList<QPointer<PendingContacts> > attributesBatchRequests;
+    uint attributesRequestCount;
+    uint attributesCallCount;
+
+    // persistent contact attributes cache
+    bool attributesCacheEnabled;
+    ContactAttributesCache *attributesCache;
+
+    // contact change notification coalescing
+    int changesBatchInterval;
+    bool changesBatchScheduled;
+    QList<ContactPtr> changedContacts;
+    QHash<Contact *, ContactManager::ContactChanges> contactChanges;
 };
 
 ContactManager::Private::Private(ContactManager *parent, Connection *connection)
@@ -79,19 +107,40 @@ ContactManager::Private::Private(ContactManager *parent, Connection *connection)
       connection(connection),
       roster(new ContactManager::Roster(parent)),
       requestAvatarsIdle(false),
-      refreshInfoOp(0)
+      avatarCache(0),
+      avatarCacheSizeLimit(0),
+      syncAvatarCacheIdle(false),
+      refreshInfoOp(0),
+      attributesBatchInterval(-1),
+      attributesBatchScheduled(false),
+      attributesRequestCount(0),
+      attributesCallCount(0),
+      attributesCacheEnabled(false),
+      attributesCache(0),
+      changesBatchInterval(-1),
+      changesBatchScheduled(false)
 {
 }
 
+// The ContactManagers with an avatar cache. Their contacts' avatars are never evicted, as other
+// caches for the same directory could have handed out the same files.
+static QList<ContactManager::Private *> avatarCacheUsers;
+
 ContactManager::Private::~Private()
 {
+    avatarCacheUsers.removeOne(this);
     delete refreshInfoOp;
     delete roster;
+    delete attributesCache;
+    delete avatarCache;
 }
 
-bool ContactManager::Private::buildAvatarFileName(QString token, bool createDir,
-        QString &avatarFileName, QString &mimeTypeFileName)
+AvatarCache *ContactManager::Private::ensureAvatarCache()
 {
+    if (avatarCache) {
+        return avatarCache;
+    }
+
     QString cacheDir = QString(QLatin1String(qgetenv("XDG_CACHE_HOME")));
     if (cacheDir.isEmpty()) {
         cacheDir = QString(QLatin1String("%1/.cache")).arg(QLatin1String(qgetenv("HOME")));
@@ -101,14 +150,26 @@ bool ContactManager::Private::buildAvatarFileName(QString token, bool createDir,
     QString path = QString(QLatin1String("%1/telepathy/avatars/%2/%3")).
         arg(cacheDir).arg(conn->cmName()).arg(conn->protocolName());
 
-    if (createDir && !QDir().mkpath(path)) {
-        return false;
-    }
+    avatarCache = new AvatarCache(path);
+    avatarCache->setSizeLimit(avatarCacheSizeLimit);
+    avatarCacheUsers.append(this);
+    return avatarCache;
+}
 
-    avatarFileName = QString(QLatin1String("%1/%2")).arg(path).arg(escapeAsIdentifier(token));
-    mimeTypeFileName = QString(QLatin1String("%1.mime")).arg(avatarFileName);
+QString ContactManager::Private::buildAttributesCacheFileName(const QString &selfId)
+{
+    QString cacheDir = QString(QLatin1String(qgetenv("XDG_CACHE_HOME")));
+    if (cacheDir.isEmpty()) {
+        cacheDir = QString(QLatin1String("%1/.cache")).arg(QLatin1String(qgetenv("HOME")));
+    }
 
-    return true;
+    // The self contact identifier is what identifies the account among the connections of the
+    // same protocol, unlike the connection object path, which connection managers are free to
+    // make up
+    ConnectionPtr conn(parent->connection());
+    return QString(QLatin1String("%1/telepathy/contact-attributes/%2/%3/%4")).
+        arg(cacheDir).arg(conn->cmName()).arg(conn->protocolName()).
+        arg(QString::fromLatin1(QUrl::toPercentEncoding(selfId)));
 }
 
 Features ContactManager::Private::realFeatures(const Features &features)
@@ -169,7 +230,7 @@ void ContactManager::PendingRefreshContactInfo::refreshInfo()
         return;
     }
 
-    debug() << "Calling ContactInfo.RefreshContactInfo for" << mToRequest.size() << "handles";
+    tpDebug() << "Calling ContactInfo.RefreshContactInfo for" << mToRequest.size() << "handles";
     Client::ConnectionInterfaceContactInfoInterface *contactInfoInterface =
         mConn->interface<Client::ConnectionInterfaceContactInfoInterface>();
     Q_ASSERT(contactInfoInterface);
@@ -188,7 +249,7 @@ void ContactManager::PendingRefreshContactInfo::onRefreshInfoFinished(PendingOpe
             op->errorName() << "-" << op->errorMessage();
         setFinishedWithError(op->errorName(), op->errorMessage());
     } else {
-        debug() << "Got reply to ContactInfo.RefreshContactInfo";
+        tpDebug() << "Got reply to ContactInfo.RefreshContactInfo";
         setFinished();
     }
 }
@@ -203,6 +264,21 @@ void ContactManager::PendingRefreshContactInfo::onRefreshInfoFinished(PendingOpe
  * See \ref async_model, \ref shared_ptr
  */
 
+/**
+ * \enum ContactManager::ContactChange
+ *
+ * Flags describing which attributes of the contacts reported by contactsChanged() changed.
+ *
+ * \value ContactAliasChanged Contact::alias() changed.
+ * \value ContactAvatarTokenChanged Contact::avatarToken() changed.
+ * \value ContactAvatarDataChanged Contact::avatarData() changed.
+ * \value ContactPresenceChanged Contact::presence() changed.
+ * \value ContactCapabilitiesChanged Contact::capabilities() changed.
+ * \value ContactLocationChanged Contact::location() changed.
+ * \value ContactInfoChanged Contact::infoFields() changed.
+ * \value ContactClientTypesChanged Contact::clientTypes() changed.
+ */
+
 /**
  * Construct a new ContactManager object.
  *
@@ -261,7 +337,7 @@ Features ContactManager::supportedFeatures() const
             }
         }
 
-        debug() << mPriv->supportedFeatures.size() << "contact features supported using" << this;
+        tpDebug() << mPriv->supportedFeatures.size() << "contact features supported using" << this;
     }
 
     return mPriv->supportedFeatures;
@@ -1022,23 +1098,27 @@ PendingContacts *ContactManager::contactsForHandles(const UIntList &handles,
         }
     }
 
+    // Compare the features as bitsets, there may be thousands of contacts to look at
+    FeatureSet realFeatureSet(realFeatures);
+    FeatureSet missingFeatureSet;
     foreach (uint handle, handles) {
         ContactPtr contact = lookupContactByHandle(handle);
         if (contact) {
-            if ((realFeatures - contact->requestedFeatures()).isEmpty()) {
+            if (contact->requestedFeatureSet().contains(realFeatureSet)) {
                 // Contact exists and has all the requested features
                 satisfyingContacts.insert(handle, contact);
             } else {
                 // Contact exists but is missing features
                 otherContacts.insert(handle);
-                missingFeatures.unite(realFeatures - contact->requestedFeatures());
+                missingFeatureSet.unite(realFeatureSet - contact->requestedFeatureSet());
             }
         } else {
             // Contact doesn't exist - we need to get all of the features (same as unite(features))
-            missingFeatures = realFeatures;
+            missingFeatureSet = realFeatureSet;
             otherContacts.insert(handle);
         }
     }
+    missingFeatures = missingFeatureSet.toFeatures();
 
     QSet<QString> interfaces = mPriv->interfacesForFeatures(missingFeatures);
 
@@ -1174,6 +1254,231 @@ PendingContacts *ContactManager::upgradeContacts(const QList<ContactPtr> &contac
     return new PendingContacts(ContactManagerPtr(this), contacts, features);
 }
 
+/**
+ * Return the interval used to coalesce contact attribute requests, in milliseconds.
+ *
+ * \return The coalescing interval, or a negative value if coalescing is disabled.
+ * \sa setContactAttributesCoalescingInterval()
+ */
+int ContactManager::contactAttributesCoalescingInterval() const
+{
+    return mPriv->attributesBatchInterval;
+}
+
+/**
+ * Set the interval used to coalesce contact attribute requests to \a msecs.
+ *
+ * Requests made through contactsForHandles() (and the methods built on top of it, such as
+ * contactsForIdentifiers() and upgradeContacts()) which need to retrieve attributes from the
+ * connection are not sent right away. Instead, all such requests made within the interval are
+ * merged into a single Connection.Interface.Contacts.GetContactAttributes call, whose result is
+ * then shared by all the PendingContacts objects waiting on it.
+ *
+ * A value of 0 merges the requests made within the same main loop iteration. Any non-negative
+ * value delays the call until control returns to the main loop, so enabling coalescing trades some
+ * latency for fewer D-Bus round-trips.
+ *
+ * The default value of -1 disables coalescing, making each request perform its own call right
+ * away.
+ *
+ * \param msecs The coalescing interval in milliseconds.
+ * \sa contactAttributesCoalescingInterval(), contactAttributesRequestCount(),
+ *     mergedContactAttributesRequestCount()
+ */
+void ContactManager::setContactAttributesCoalescingInterval(int msecs)
+{
+    mPriv->attributesBatchInterval = msecs;
+}
+
+/**
+ * Return the number of contact attribute requests made by this ContactManager.
+ *
+ * \return The number of requests that needed to retrieve contact attributes from the
+ *         connection, whether they were merged or not.
+ * \sa mergedContactAttributesRequestCount()
+ */
+uint ContactManager::contactAttributesRequestCount() const
+{
+    return mPriv->attributesRequestCount;
+}
+
+/**
+ * Return the number of contact attribute requests which were merged into a call made on behalf
+ * of another request, and therefore did not cost a D-Bus round-trip of their own.
+ *
+ * \return The number of merged requests.
+ * \sa contactAttributesRequestCount(), setContactAttributesCoalescingInterval()
+ */
+uint ContactManager::mergedContactAttributesRequestCount() const
+{
+    return mPriv->attributesRequestCount - mPriv->attributesCallCount;
+}
+
+/**
+ * Return the maximum size of the avatar cache used by this ContactManager.
+ *
+ * \return The size limit in bytes, or 0 if the cache size is not limited.
+ * \sa setAvatarCacheSizeLimit()
+ */
+qint64 ContactManager::avatarCacheSizeLimit() const
+{
+    return mPriv->avatarCacheSizeLimit;
+}
+
+/**
+ * Set the maximum size of the avatar cache used by this ContactManager to \a bytes.
+ *
+ * The avatars retrieved for Contact::FeatureAvatarData are cached on disk, shared between all
+ * the connections to the same protocol of the same connection manager. The cache is indexed,
+ * so finding an avatar in it only requires checking that its file still exists, the first time
+ * it's found.
+ *
+ * When the total size of the cached avatars exceeds the limit, the least recently used ones
+ * are removed from the cache. As the cache directory is shared with other Telepathy clients,
+ * only the avatars downloaded by this ContactManager are removed, and never those used by a
+ * contact of this process, so the cache can stay over the limit.
+ *
+ * The default value of 0 doesn't limit the cache size.
+ *
+ * \param bytes The size limit in bytes, or 0 to not limit the cache size.
+ * \sa avatarCacheSizeLimit(), Contact::avatarData()
+ */
+void ContactManager::setAvatarCacheSizeLimit(qint64 bytes)
+{
+    mPriv->avatarCacheSizeLimit = bytes;
+    if (mPriv->avatarCache) {
+        mPriv->avatarCache->setSizeLimit(bytes);
+        scheduleAvatarCacheSync();
+    }
+}
+
+/**
+ * Return whether the persistent contact attributes cache is enabled.
+ *
+ * \return \c true if the cache is enabled, \c false otherwise.
+ * \sa setContactAttributesCacheEnabled()
+ */
+bool ContactManager::isContactAttributesCacheEnabled() const
+{
+    return mPriv->attributesCacheEnabled;
+}
+
+/**
+ * Set whether the attributes of the contacts in the contact list should be cached on disk.
+ *
+ * When the cache is enabled, the contacts retrieved when Connection::FeatureRoster is made
+ * ready have their alias, avatar token, capabilities, client types and location (those of them
+ * requested through the ContactFactory) filled in straight from the cache, which is keyed by
+ * the connection manager, protocol and self contact identifier of the account, and by the
+ * contact identifiers. Only the remaining attributes are retrieved before the feature becomes
+ * ready, which makes bringing up connections with big contact lists a lot faster.
+ *
+ * The cached attributes are then revalidated in the background against the connection.
+ * Contacts whose attributes changed in the meantime emit the corresponding change
+ * notification signals (such as Contact::aliasChanged()) for the changed attributes only, and
+ * the cache is updated.
+ *
+ * Contacts which are not in the cache yet, or only with some of the features, are retrieved
+ * with all of the features requested through the ContactFactory before the feature becomes
+ * ready, so the contacts are always complete when Connection::FeatureRoster is ready.
+ *
+ * This method needs to be called before Connection::FeatureRoster is requested to have any
+ * effect. The cache is disabled by default.
+ *
+ * \param enabled Whether to enable the cache.
+ * \sa isContactAttributesCacheEnabled()
+ */
+void ContactManager::setContactAttributesCacheEnabled(bool enabled)
+{
+    mPriv->attributesCacheEnabled = enabled;
+}
+
+/**
+ * Return the interval used to coalesce contact change notifications, in milliseconds.
+ *
+ * \return The coalescing interval, or a negative value if coalescing is disabled.
+ * \sa setContactChangesCoalescingInterval()
+ */
+int ContactManager::contactChangesCoalescingInterval() const
+{
+    return mPriv->changesBatchInterval;
+}
+
+/**
+ * Set the interval used to coalesce contact change notifications to \a msecs.
+ *
+ * When enabled, the changes to the attributes of the contacts of this ContactManager are
+ * collected for the given interval and then reported by a few contactsChanged() signals, one for
+ * each set of changed attributes, instead of by the change notification signals of each contact
+ * only. User interfaces showing many contacts should use this to avoid updating themselves for
+ * every single change when lots of contacts change at once, such as when connecting.
+ *
+ * The contacts' attributes themselves are always updated immediately, and the individual
+ * change notification signals (such as Contact::presenceChanged()) are still emitted.
+ *
+ * A value of 0 reports the changes made within the same main loop iteration. The default
+ * value of -1 disables coalescing, and contactsChanged() is not emitted at all.
+ *
+ * \param msecs The coalescing interval in milliseconds.
+ * \sa contactChangesCoalescingInterval(), contactsChanged()
+ */
+void ContactManager::setContactChangesCoalescingInterval(int msecs)
+{
+    mPriv->changesBatchInterval = msecs;
+    if (msecs < 0) {
+        mPriv->changedContacts.clear();
+        mPriv->contactChanges.clear();
+    }
+}
+
+void ContactManager::queueContactChange(Contact *contact, ContactChanges changes)
+{
+    if (mPriv->changesBatchInterval < 0) {
+        return;
+    }
+
+    QHash<Contact *, ContactChanges>::iterator i = mPriv->contactChanges.find(contact);
+    if (i != mPriv->contactChanges.end()) {
+        i.value() |= changes;
+        return;
+    }
+
+    mPriv->contactChanges.insert(contact, changes);
+    mPriv->changedContacts.append(ContactPtr(contact));
+
+    if (!mPriv->changesBatchScheduled) {
+        mPriv->changesBatchScheduled = true;
+        QTimer::singleShot(mPriv->changesBatchInterval, this, SLOT(doEmitContactsChanged()));
+    }
+}
+
+void ContactManager::doEmitContactsChanged()
+{
+    mPriv->changesBatchScheduled = false;
+
+    QList<ContactPtr> contacts = mPriv->changedContacts;
+    QHash<Contact *, ContactChanges> changes = mPriv->contactChanges;
+    mPriv->changedContacts.clear();
+    mPriv->contactChanges.clear();
+
+    // Emit once for each combination of changes, which is typically a single one (such as the
+    // presence of lots of contacts changing), keeping the order in which contacts first changed
+    QList<int> order;
+    QHash<int, QList<ContactPtr> > contactsByChanges;
+    foreach (const ContactPtr &contact, contacts) {
+        int contactChanges = changes.value(contact.data());
+        if (!contactsByChanges.contains(contactChanges)) {
+            order.append(contactChanges);
+        }
+        contactsByChanges[contactChanges].append(contact);
+    }
+
+    foreach (int contactChanges, order) {
+        emit contactsChanged(contactsByChanges.value(contactChanges),
+                ContactChanges(contactChanges));
+    }
+}
+
 ContactPtr ContactManager::lookupContactByHandle(uint handle)
 {
     ContactPtr contact;
@@ -1244,9 +1549,53 @@ PendingOperation *ContactManager::refreshContactInfo(const QList<ContactPtr> &co
     return mPriv->refreshInfoOp;
 }
 
+void ContactManager::doRequestContactAttributes()
+{
+    Q_ASSERT(mPriv->attributesBatchScheduled);
+
+    UIntList handles = mPriv->attributesBatchHandles;
+    QStringList interfaces = mPriv->attributesBatchInterfaces.toList();
+    QList<QPointer<PendingContacts> > requests = mPriv->attributesBatchRequests;
+
+    mPriv->attributesBatchScheduled = false;
+    mPriv->attributesBatchHandles.clear();
+    mPriv->attributesBatchHandlesSet.clear();
+    mPriv->attributesBatchInterfaces.clear();
+    mPriv->attributesBatchRequests.clear();
+
+    bool anyAlive = false;
+    foreach (const QPointer<PendingContacts> &request, requests) {
+        if (request) {
+            anyAlive = true;
+            break;
+        }
+    }
+    if (!anyAlive) {
+        // Nobody is waiting for the reply any more, so don't count the requests as made either
+        tpDebug() << "Dropping attributes request for" << handles.size() << "contacts, all" <<
+            requests.size() << "requester(s) are gone";
+        mPriv->attributesRequestCount -= requests.size();
+        return;
+    }
+
+    tpDebug() << "Requesting attributes for" << handles.size() << "contacts on behalf of" <<
+        requests.size() << "coalesced request(s)";
+
+    mPriv->attributesCallCount++;
+    PendingContactAttributes *attributes =
+        connection()->lowlevel()->contactAttributes(handles, interfaces, true);
+    foreach (const QPointer<PendingContacts> &request, requests) {
+        if (request) {
+            request->connect(attributes,
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(onAttributesFinished(Tp::PendingOperation*)));
+        }
+    }
+}
+
 void ContactManager::onAliasesChanged(const AliasPairList &aliases)
 {
-    debug() << "Got AliasesChanged for" << aliases.size() << "contacts";
+    tpDebug() << "Got AliasesChanged for" << aliases.size() << "contacts";
 
     foreach (AliasPair pair, aliases) {
         ContactPtr contact = lookupContactByHandle(pair.handle);
@@ -1274,18 +1623,12 @@ void ContactManager::doRequestAvatars()
         }
 
         QString avatarFileName;
-        QString mimeTypeFileName;
-        bool success = (contact->isAvatarTokenKnown() &&
-            mPriv->buildAvatarFileName(contact->avatarToken(), false,
-                avatarFileName, mimeTypeFileName));
+        QString mimeType;
 
         /* Check if the avatar is already in the cache */
-        if (success && QFile::exists(avatarFileName)) {
-            QFile mimeTypeFile(mimeTypeFileName);
-            mimeTypeFile.open(QIODevice::ReadOnly);
-            QString mimeType = QString(QLatin1String(mimeTypeFile.readAll()));
-            mimeTypeFile.close();
-
+        if (contact->isAvatarTokenKnown() &&
+            mPriv->ensureAvatarCache()->lookup(contact->avatarToken(),
+                avatarFileName, mimeType)) {
             found++;
 
             contact->receiveAvatarData(AvatarData(avatarFileName, mimeType));
@@ -1297,14 +1640,15 @@ void ContactManager::doRequestAvatars()
     }
 
     if (found > 0) {
-        debug() << "Avatar(s) found in cache for" << found << "contact(s)";
+        tpDebug() << "Avatar(s) found in cache for" << found << "contact(s)";
+        scheduleAvatarCacheSync();
     }
 
     if (found == contacts.size()) {
         return;
     }
 
-    debug() << "Requesting avatar(s) for" << contacts.size() - found << "contact(s)";
+    tpDebug() << "Requesting avatar(s) for" << contacts.size() - found << "contact(s)";
 
     Client::ConnectionInterfaceAvatarsInterface *avatarsInterface =
         connection()->interface<Client::ConnectionInterfaceAvatarsInterface>();
@@ -1315,9 +1659,45 @@ void ContactManager::doRequestAvatars()
         SLOT(deleteLater()));
 }
 
+void ContactManager::scheduleAvatarCacheSync()
+{
+    if (!mPriv->syncAvatarCacheIdle) {
+        mPriv->syncAvatarCacheIdle = true;
+        QTimer::singleShot(0, this, SLOT(doSyncAvatarCache()));
+    }
+}
+
+void ContactManager::doSyncAvatarCache()
+{
+    mPriv->syncAvatarCacheIdle = false;
+    if (!mPriv->avatarCache) {
+        return;
+    }
+
+    AvatarCache *cache = mPriv->avatarCache;
+    if (cache->sizeLimit() > 0 && cache->size() > cache->sizeLimit()) {
+        QSet<QString> fileNamesInUse;
+        foreach (Private *user, avatarCacheUsers) {
+            if (user->avatarCache->path() != cache->path()) {
+                continue;
+            }
+
+            foreach (const WeakPtr<Contact> &weakContact, user->contacts) {
+                ContactPtr contact(weakContact);
+                if (contact && contact->requestedFeatures().contains(Contact::FeatureAvatarData)) {
+                    fileNamesInUse.insert(contact->avatarData().fileName);
+                }
+            }
+        }
+        cache->evict(fileNamesInUse);
+    }
+
+    cache->sync();
+}
+
 void ContactManager::onAvatarUpdated(uint handle, const QString &token)
 {
-    debug() << "Got AvatarUpdate for contact with handle" << handle;
+    tpDebug() << "Got AvatarUpdate for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
     if (contact) {
@@ -1329,39 +1709,14 @@ void ContactManager::onAvatarRetrieved(uint handle, const QString &token,
     const QByteArray &data, const QString &mimeType)
 {
     QString avatarFileName;
-    QString mimeTypeFileName;
-
-    debug() << "Got AvatarRetrieved for contact with handle" << handle;
-
-    bool success = mPriv->buildAvatarFileName(token, true, avatarFileName,
-        mimeTypeFileName);
 
-    if (success) {
-        debug() << "Write avatar in cache for handle" << handle;
-        debug() << "Filename:" << avatarFileName;
-        debug() << "MimeType:" << mimeType;
+    tpDebug() << "Got AvatarRetrieved for contact with handle" << handle;
 
-        if (!QFile::exists(mimeTypeFileName)) {
-            QTemporaryFile mimeTypeFile(mimeTypeFileName);
-            if (mimeTypeFile.open()) {
-                mimeTypeFile.write(mimeType.toLatin1());
-                mimeTypeFile.setAutoRemove(false);
-                if (!mimeTypeFile.rename(mimeTypeFileName)) {
-                    mimeTypeFile.remove();
-                }
-            }
-        }
-
-        if (!QFile::exists(avatarFileName)) {
-            QTemporaryFile avatarFile(avatarFileName);
-            if (avatarFile.open()) {
-                avatarFile.write(data);
-                avatarFile.setAutoRemove(false);
-                if (!avatarFile.rename(avatarFileName)) {
-                    avatarFile.remove();
-                }
-            }
-        }
+    if (mPriv->ensureAvatarCache()->insert(token, data, mimeType, avatarFileName)) {
+        tpDebug() << "Wrote avatar in cache for handle" << handle;
+        tpDebug() << "Filename:" << avatarFileName;
+        tpDebug() << "MimeType:" << mimeType;
+        scheduleAvatarCacheSync();
     }
 
     ContactPtr contact = lookupContactByHandle(handle);
@@ -1373,7 +1728,7 @@ void ContactManager::onAvatarRetrieved(uint handle, const QString &token,
 
 void ContactManager::onPresencesChanged(const SimpleContactPresences &presences)
 {
-    debug() << "Got PresencesChanged for" << presences.size() << "contacts";
+    tpDebug() << "Got PresencesChanged for" << presences.size() << "contacts";
 
     foreach (uint handle, presences.keys()) {
         ContactPtr contact = lookupContactByHandle(handle);
@@ -1386,7 +1741,7 @@ void ContactManager::onPresencesChanged(const SimpleContactPresences &presences)
 
 void ContactManager::onCapabilitiesChanged(const ContactCapabilitiesMap &caps)
 {
-    debug() << "Got ContactCapabilitiesChanged for" << caps.size() << "contacts";
+    tpDebug() << "Got ContactCapabilitiesChanged for" << caps.size() << "contacts";
 
     foreach (uint handle, caps.keys()) {
         ContactPtr contact = lookupContactByHandle(handle);
@@ -1399,7 +1754,7 @@ void ContactManager::onCapabilitiesChanged(const ContactCapabilitiesMap &caps)
 
 void ContactManager::onLocationUpdated(uint handle, const QVariantMap &location)
 {
-    debug() << "Got LocationUpdated for contact with handle" << handle;
+    tpDebug() << "Got LocationUpdated for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
 
@@ -1410,7 +1765,7 @@ void ContactManager::onLocationUpdated(uint handle, const QVariantMap &location)
 
 void ContactManager::onContactInfoChanged(uint handle, const Tp::ContactInfoFieldList &info)
 {
-    debug() << "Got ContactInfoChanged for contact with handle" << handle;
+    tpDebug() << "Got ContactInfoChanged for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
 
@@ -1421,7 +1776,7 @@ void ContactManager::onContactInfoChanged(uint handle, const Tp::ContactInfoFiel
 
 void ContactManager::onClientTypesUpdated(uint handle, const QStringList &clientTypes)
 {
-    debug() << "Got ClientTypesUpdated for contact with handle" << handle;
+    tpDebug() << "Got ClientTypesUpdated for contact with handle" << handle;
 
     ContactPtr contact = lookupContactByHandle(handle);
 
@@ -1438,6 +1793,37 @@ void ContactManager::doRefreshInfo()
     op->refreshInfo();
 }
 
+void ContactManager::requestContactAttributes(PendingContacts *request,
+        const UIntList &handles, const QStringList &interfaces)
+{
+    mPriv->attributesRequestCount++;
+
+    if (mPriv->attributesBatchInterval < 0) {
+        mPriv->attributesCallCount++;
+        PendingContactAttributes *attributes =
+            connection()->lowlevel()->contactAttributes(handles, interfaces, true);
+        request->connect(attributes,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(onAttributesFinished(Tp::PendingOperation*)));
+        return;
+    }
+
+    foreach (uint handle, handles) {
+        if (!mPriv->attributesBatchHandlesSet.contains(handle)) {
+            mPriv->attributesBatchHandlesSet.insert(handle);
+            mPriv->attributesBatchHandles.append(handle);
+        }
+    }
+    mPriv->attributesBatchInterfaces.unite(interfaces.toSet());
+    mPriv->attributesBatchRequests.append(QPointer<PendingContacts>(request));
+
+    if (!mPriv->attributesBatchScheduled) {
+        mPriv->attributesBatchScheduled = true;
+        QTimer::singleShot(mPriv->attributesBatchInterval, this,
+                SLOT(doRequestContactAttributes()));
+    }
+}
+
 ContactPtr ContactManager::ensureContact(const ReferencedHandles &handle,
         const Features &features, const QVariantMap &attributes)
 {
@@ -1578,6 +1964,138 @@ void ContactManager::ensureTracking(const Feature &feature)
     mPriv->tracking[feature] = true;
 }
 
+ContactAttributesCache *ContactManager::contactAttributesCache()
+{
+    if (!mPriv->attributesCacheEnabled) {
+        return 0;
+    }
+
+    return mPriv->attributesCache;
+}
+
+ContactAttributesCache *ContactManager::loadContactAttributesCache(const QString &selfId)
+{
+    if (!mPriv->attributesCacheEnabled || selfId.isEmpty()) {
+        return 0;
+    }
+
+    QString fileName = mPriv->buildAttributesCacheFileName(selfId);
+    if (!mPriv->attributesCache || mPriv->attributesCache->fileName() != fileName) {
+        delete mPriv->attributesCache;
+        mPriv->attributesCache = new ContactAttributesCache(fileName);
+        tpDebug() << "Loaded" << mPriv->attributesCache->size() <<
+            "contacts from attributes cache" << fileName;
+    }
+
+    return mPriv->attributesCache;
+}
+
+Features ContactManager::cacheableFeatures()
+{
+    // Presence is too short-lived to be worth caching, and groups, addresses and info are
+    // either cheap or not retrieved together with the contact list anyway
+    return Features() << Contact::FeatureAlias <<
+        Contact::FeatureAvatarToken <<
+        Contact::FeatureCapabilities <<
+        Contact::FeatureClientTypes <<
+        Contact::FeatureLocation;
+}
+
+Features ContactManager::featuresInCachedAttributes(const QVariantMap &cached)
+{
+    // Connection managers leave out the attributes they have no value for, so the interfaces
+    // which were asked for are recorded along with the attributes
+    QStringList interfaces = cached.value(QLatin1String("cached-interfaces")).toStringList();
+
+    Features features;
+    foreach (const Feature &feature, cacheableFeatures()) {
+        QString interface = featureToInterface(feature);
+        if (interfaces.contains(interface)) {
+            features.insert(feature);
+            continue;
+        }
+
+        QString prefix = interface + QLatin1Char('/');
+        for (QVariantMap::const_iterator i = cached.constBegin(); i != cached.constEnd(); ++i) {
+            if (i.key().startsWith(prefix)) {
+                features.insert(feature);
+                break;
+            }
+        }
+    }
+    return features;
+}
+
+QVariantMap ContactManager::attributesToCache(const QVariantMap &attributes,
+        const Features &features)
+{
+    QVariantMap cached;
+
+    QStringList interfaces;
+    foreach (const Feature &feature, features) {
+        interfaces << featureToInterface(feature);
+    }
+    cached.insert(QLatin1String("cached-interfaces"), interfaces);
+
+    QString key = TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING + QLatin1String("/alias");
+    if (attributes.contains(key)) {
+        cached.insert(key, qdbus_cast<QString>(attributes.value(key)));
+    }
+
+    key = TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String("/token");
+    if (attributes.contains(key)) {
+        cached.insert(key, qdbus_cast<QString>(attributes.value(key)));
+    }
+
+    key = TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_CAPABILITIES + QLatin1String("/capabilities");
+    if (attributes.contains(key)) {
+        // RequestableChannelClassList can't be streamed, store it as plain maps
+        QVariantList classes;
+        foreach (const RequestableChannelClass &rcc,
+                qdbus_cast<RequestableChannelClassList>(attributes.value(key))) {
+            QVariantMap rccMap;
+            rccMap.insert(QLatin1String("fixed-properties"), rcc.fixedProperties);
+            rccMap.insert(QLatin1String("allowed-properties"), rcc.allowedProperties);
+            classes << rccMap;
+        }
+        cached.insert(key, classes);
+    }
+
+    key = TP_QT_IFACE_CONNECTION_INTERFACE_CLIENT_TYPES + QLatin1String("/client-types");
+    if (attributes.contains(key)) {
+        cached.insert(key, qdbus_cast<QStringList>(attributes.value(key)));
+    }
+
+    key = TP_QT_IFACE_CONNECTION_INTERFACE_LOCATION + QLatin1String("/location");
+    if (attributes.contains(key)) {
+        cached.insert(key, qdbus_cast<QVariantMap>(attributes.value(key)));
+    }
+
+    return cached;
+}
+
+QVariantMap ContactManager::attributesFromCache(const QVariantMap &cached)
+{
+    QVariantMap attributes(cached);
+    attributes.remove(QLatin1String("cached-interfaces"));
+
+    QString key = TP_QT_IFACE_CONNECTION_INTERFACE_CONTACT_CAPABILITIES +
+        QLatin1String("/capabilities");
+    if (cached.contains(key)) {
+        RequestableChannelClassList caps;
+        foreach (const QVariant &rccVariant, cached.value(key).toList()) {
+            QVariantMap rccMap = rccVariant.toMap();
+            RequestableChannelClass rcc;
+            rcc.fixedProperties = rccMap.value(QLatin1String("fixed-properties")).toMap();
+            rcc.allowedProperties = rccMap.value(QLatin1String("allowed-properties")).toStringList();
+            caps << rcc;
+        }
+        attributes.insert(key, QVariant::fromValue(caps));
+    }
+
+    return attributes;
+}
+
 PendingOperation *ContactManager::introspectRoster()
 {
     return mPriv->roster->introspect();
@@ -1664,4 +2182,16 @@ void ContactManager::resetRoster()
  * \sa allKnownContacts()
  */
 
+/**
+ * \fn void ContactManager::contactsChanged(const QList<Tp::ContactPtr> &contacts,
+ *          Tp::ContactManager::ContactChanges changes)
+ *
+ * Emitted when contact change notifications are being coalesced, after the coalescing interval
+ * elapsed, with the contacts whose attributes changed in the meantime.
+ *
+ * \param contacts The contacts which changed.
+ * \param changes The attributes which changed for all of \a contacts.
+ * \sa setContactChangesCoalescingInterval()
+ */
+
 } // Tp
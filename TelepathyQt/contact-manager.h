@@ -44,6 +44,7 @@ namespace Tp
 {
 
 class Connection;
+class ContactAttributesCache;
 class PendingContacts;
 class PendingOperation;
 
@@ -53,6 +54,18 @@ class TP_QT_EXPORT ContactManager : public Object
     Q_DISABLE_COPY(ContactManager)
 
 public:
+    enum ContactChange {
+        ContactAliasChanged = 0x001,
+        ContactAvatarTokenChanged = 0x002,
+        ContactAvatarDataChanged = 0x004,
+        ContactPresenceChanged = 0x008,
+        ContactCapabilitiesChanged = 0x010,
+        ContactLocationChanged = 0x020,
+        ContactInfoChanged = 0x040,
+        ContactClientTypesChanged = 0x080
+    };
+    Q_DECLARE_FLAGS(ContactChanges, ContactChange)
+
     virtual ~ContactManager();
 
     ConnectionPtr connection() const;
@@ -129,6 +142,20 @@ public:
 
     PendingOperation *refreshContactInfo(const QList<ContactPtr> &contact);
 
+    int contactAttributesCoalescingInterval() const;
+    void setContactAttributesCoalescingInterval(int msecs);
+    uint contactAttributesRequestCount() const;
+    uint mergedContactAttributesRequestCount() const;
+
+    qint64 avatarCacheSizeLimit() const;
+    void setAvatarCacheSizeLimit(qint64 bytes);
+
+    bool isContactAttributesCacheEnabled() const;
+    void setContactAttributesCacheEnabled(bool enabled);
+
+    int contactChangesCoalescingInterval() const;
+    void setContactChangesCoalescingInterval(int msecs);
+
 Q_SIGNALS:
     void stateChanged(Tp::ContactListState state);
 
@@ -147,9 +174,13 @@ Q_SIGNALS:
             const Tp::Contacts &contactsRemoved,
             const Tp::Channel::GroupMemberChangeDetails &details);
 
+    void contactsChanged(const QList<Tp::ContactPtr> &contacts,
+            Tp::ContactManager::ContactChanges changes);
+
 private Q_SLOTS:
     TP_QT_NO_EXPORT void onAliasesChanged(const Tp::AliasPairList &);
     TP_QT_NO_EXPORT void doRequestAvatars();
+    TP_QT_NO_EXPORT void doSyncAvatarCache();
     TP_QT_NO_EXPORT void onAvatarUpdated(uint, const QString &);
     TP_QT_NO_EXPORT void onAvatarRetrieved(uint, const QString &, const QByteArray &, const QString &);
     TP_QT_NO_EXPORT void onPresencesChanged(const Tp::SimpleContactPresences &);
@@ -158,12 +189,15 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onContactInfoChanged(uint, const Tp::ContactInfoFieldList &);
     TP_QT_NO_EXPORT void onClientTypesUpdated(uint, const QStringList &);
     TP_QT_NO_EXPORT void doRefreshInfo();
+    TP_QT_NO_EXPORT void doRequestContactAttributes();
+    TP_QT_NO_EXPORT void doEmitContactsChanged();
 
 private:
     class PendingRefreshContactInfo;
     class Roster;
     friend class Channel;
     friend class Connection;
+    friend class Contact;
     friend class PendingContacts;
     friend class PendingRefreshContactInfo;
     friend class Roster;
@@ -172,6 +206,9 @@ private:
 
     TP_QT_NO_EXPORT ContactPtr lookupContactByHandle(uint handle);
 
+    TP_QT_NO_EXPORT void requestContactAttributes(PendingContacts *request,
+            const UIntList &handles, const QStringList &interfaces);
+
     TP_QT_NO_EXPORT ContactPtr ensureContact(const ReferencedHandles &handle,
             const Features &features,
             const QVariantMap &attributes);
@@ -181,12 +218,24 @@ private:
     TP_QT_NO_EXPORT static QString featureToInterface(const Feature &feature);
     TP_QT_NO_EXPORT void ensureTracking(const Feature &feature);
 
+    TP_QT_NO_EXPORT void scheduleAvatarCacheSync();
+
+    TP_QT_NO_EXPORT ContactAttributesCache *contactAttributesCache();
+    TP_QT_NO_EXPORT ContactAttributesCache *loadContactAttributesCache(const QString &selfId);
+    TP_QT_NO_EXPORT static Features cacheableFeatures();
+    TP_QT_NO_EXPORT static Features featuresInCachedAttributes(const QVariantMap &cached);
+    TP_QT_NO_EXPORT static QVariantMap attributesToCache(const QVariantMap &attributes,
+            const Features &features);
+    TP_QT_NO_EXPORT static QVariantMap attributesFromCache(const QVariantMap &cached);
+
     TP_QT_NO_EXPORT PendingOperation *introspectRoster();
     TP_QT_NO_EXPORT PendingOperation *introspectRosterGroups();
     TP_QT_NO_EXPORT void resetRoster();
 
     TP_QT_NO_EXPORT PendingOperation *refreshContactInfo(Contact *contact);
 
+    TP_QT_NO_EXPORT void queueContactChange(Contact *contact, ContactChanges changes);
+
     struct Private;
     friend struct Private;
     Private *mPriv;
@@ -194,4 +243,6 @@ private:
 
 } // Tp
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Tp::ContactManager::ContactChanges)
+
 #endif
@@ -571,7 +571,7 @@ void ContactSearchChannel::gotProperties(QDBusPendingCallWatcher *watcher)
 
         mPriv->searchState = qdbus_cast<uint>(props[QLatin1String("SearchState")]);
 
-        debug() << "Got reply to Properties::GetAll(ContactSearchChannel)";
+        tpDebug() << "Got reply to Properties::GetAll(ContactSearchChannel)";
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
     } else {
         warning().nospace() << "Properties::GetAll(ContactSearchChannel) failed "
@@ -590,7 +590,7 @@ void ContactSearchChannel::gotSearchState(QDBusPendingCallWatcher *watcher)
     if (!reply.isError()) {
         mPriv->searchState = qdbus_cast<uint>(reply.value());
 
-        debug() << "Got reply to Properties::Get(SearchState)";
+        tpDebug() << "Got reply to Properties::Get(SearchState)";
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
     } else {
         warning().nospace() << "Properties::Get(SearchState) failed "
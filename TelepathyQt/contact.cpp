@@ -25,6 +25,7 @@
 #include "TelepathyQt/_gen/contact.moc.hpp"
 
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-set.h"
 #include "TelepathyQt/future-internal.h"
 
 #include <TelepathyQt/AvatarData>
@@ -61,6 +62,7 @@ struct TP_QT_NO_EXPORT Contact::Private
     }
 
     void updateAvatarData();
+    void queueChange(ContactManager::ContactChanges changes);
 
     Contact *parent;
 
@@ -68,8 +70,8 @@ struct TP_QT_NO_EXPORT Contact::Private
     ReferencedHandles handle;
     QString id;
 
-    Features requestedFeatures;
-    Features actualFeatures;
+    FeatureSet requestedFeatures;
+    FeatureSet actualFeatures;
 
     QString alias;
     QMap<QString, QString> vcardAddresses;
@@ -107,15 +109,24 @@ void Contact::Private::updateAvatarData()
 
     /* If token is empty (""), it means the contact has no avatar. */
     if (avatarToken.isEmpty()) {
-        debug() << "Contact" << parent->id() << "has no avatar";
+        tpDebug() << "Contact" << parent->id() << "has no avatar";
         avatarData = AvatarData();
         emit parent->avatarDataChanged(avatarData);
+        queueChange(ContactManager::ContactAvatarDataChanged);
         return;
     }
 
     parent->manager()->requestContactAvatars(QList<ContactPtr>() << ContactPtr(parent));
 }
 
+void Contact::Private::queueChange(ContactManager::ContactChanges changes)
+{
+    ContactManagerPtr contactManager(manager);
+    if (contactManager) {
+        contactManager->queueContactChange(parent, changes);
+    }
+}
+
 struct TP_QT_NO_EXPORT Contact::InfoFields::Private : public QSharedData
 {
     Private(const ContactInfoFieldList &allFields)
@@ -331,7 +342,7 @@ Contact::Contact(ContactManager *manager, const ReferencedHandles &handle,
  */
 Contact::~Contact()
 {
-    debug() << "Contact" << id() << "destroyed";
+    tpDebug() << "Contact" << id() << "destroyed";
     delete mPriv;
 }
 
@@ -372,7 +383,7 @@ QString Contact::id() const
  */
 Features Contact::requestedFeatures() const
 {
-    return mPriv->requestedFeatures;
+    return mPriv->requestedFeatures.toFeatures();
 }
 
 /**
@@ -382,7 +393,12 @@ Features Contact::requestedFeatures() const
  */
 Features Contact::actualFeatures() const
 {
-    return mPriv->actualFeatures;
+    return mPriv->actualFeatures.toFeatures();
+}
+
+const FeatureSet &Contact::requestedFeatureSet() const
+{
+    return mPriv->requestedFeatures;
 }
 
 /**
@@ -1141,6 +1157,7 @@ void Contact::receiveAlias(const QString &alias)
     if (mPriv->alias != alias) {
         mPriv->alias = alias;
         emit aliasChanged(alias);
+        mPriv->queueChange(ContactManager::ContactAliasChanged);
     }
 }
 
@@ -1165,6 +1182,7 @@ void Contact::setAvatarToken(const QString &token)
         mPriv->isAvatarTokenKnown = true;
         mPriv->avatarToken = token;
         emit avatarTokenChanged(mPriv->avatarToken);
+        mPriv->queueChange(ContactManager::ContactAvatarTokenChanged);
     }
 }
 
@@ -1173,6 +1191,7 @@ void Contact::receiveAvatarData(const AvatarData &avatar)
     if (mPriv->avatarData.fileName != avatar.fileName) {
         mPriv->avatarData = avatar;
         emit avatarDataChanged(mPriv->avatarData);
+        mPriv->queueChange(ContactManager::ContactAvatarDataChanged);
     }
 }
 
@@ -1188,6 +1207,7 @@ void Contact::receiveSimplePresence(const SimplePresence &presence)
         mPriv->presence.statusMessage() != presence.statusMessage) {
         mPriv->presence.setStatus(presence);
         emit presenceChanged(mPriv->presence);
+        mPriv->queueChange(ContactManager::ContactPresenceChanged);
     }
 }
 
@@ -1202,6 +1222,7 @@ void Contact::receiveCapabilities(const RequestableChannelClassList &caps)
     if (mPriv->caps.allClassSpecs().bareClasses() != caps) {
         mPriv->caps.updateRequestableChannelClasses(caps);
         emit capabilitiesChanged(mPriv->caps);
+        mPriv->queueChange(ContactManager::ContactCapabilitiesChanged);
     }
 }
 
@@ -1216,6 +1237,7 @@ void Contact::receiveLocation(const QVariantMap &location)
     if (mPriv->location.allDetails() != location) {
         mPriv->location.updateData(location);
         emit locationUpdated(mPriv->location);
+        mPriv->queueChange(ContactManager::ContactLocationChanged);
     }
 }
 
@@ -1231,6 +1253,7 @@ void Contact::receiveInfo(const ContactInfoFieldList &info)
     if (mPriv->info.allFields() != info) {
         mPriv->info = InfoFields(info);
         emit infoFieldsChanged(mPriv->info);
+        mPriv->queueChange(ContactManager::ContactInfoChanged);
     }
 }
 
@@ -1257,6 +1280,7 @@ void Contact::receiveClientTypes(const QStringList &clientTypes)
     if (mPriv->clientTypes != clientTypes) {
         mPriv->clientTypes = clientTypes;
         emit clientTypesChanged(mPriv->clientTypes);
+        mPriv->queueChange(ContactManager::ContactClientTypesChanged);
     }
 }
 
@@ -42,6 +42,7 @@ struct AvatarData;
 class ContactCapabilities;
 class LocationInfo;
 class ContactManager;
+class FeatureSet;
 class PendingContactInfo;
 class PendingOperation;
 class PendingStringList;
@@ -233,6 +234,8 @@ private:
     TP_QT_NO_EXPORT void setAddedToGroup(const QString &group);
     TP_QT_NO_EXPORT void setRemovedFromGroup(const QString &group);
 
+    TP_QT_NO_EXPORT const FeatureSet &requestedFeatureSet() const;
+
     struct Private;
     friend class Connection;
     friend class ContactFactory;
@@ -67,7 +67,7 @@ DBusProxy::Private::Private(const QDBusConnection &dbusConnection,
       busName(busName),
       objectPath(objectPath)
 {
-    debug() << "Creating new DBusProxy";
+    tpDebug() << "Creating new DBusProxy";
 }
 
 /**
@@ -196,7 +196,7 @@ QString DBusProxy::invalidationMessage() const
 void DBusProxy::invalidate(const QString &reason, const QString &message)
 {
     if (!isValid()) {
-        debug().nospace() << "Already invalidated by "
+        tpDebug().nospace() << "Already invalidated by "
             << mPriv->invalidationReason
             << ", not replacing with " << reason
             << " \"" << message << "\"";
@@ -205,7 +205,7 @@ void DBusProxy::invalidate(const QString &reason, const QString &message)
 
     Q_ASSERT(!reason.isEmpty());
 
-    debug().nospace() << "proxy invalidated: " << reason
+    tpDebug().nospace() << "proxy invalidated: " << reason
         << ": " << message;
 
     mPriv->invalidationReason = reason;
@@ -183,7 +183,7 @@ bool DBusService::registerObject(const QString &busName, const QString &objectPa
         return false;
     }
 
-    debug() << "Registered object" << objectPath << "at bus name" << busName;
+    tpDebug() << "Registered object" << objectPath << "at bus name" << busName;
 
     mPriv->busName = busName;
     mPriv->objectPath = objectPath;
@@ -25,6 +25,7 @@
 
 #include <QDebug>
 
+#include <TelepathyQt/Debug>
 #include <TelepathyQt/Global>
 
 namespace Tp
@@ -117,8 +118,34 @@ private:
 TP_QT_EXPORT Debug enabledDebug();
 TP_QT_EXPORT Debug enabledWarning();
 
+// The debug categories compiled in. Builds which want to get rid of the output of some categories
+// altogether, along with the cost of checking whether it's enabled, can define this to a subset of
+// DebugCategory values.
+#ifndef TP_QT_DEBUG_CATEGORIES
+#define TP_QT_DEBUG_CATEGORIES Tp::DebugCategoryAll
+#endif
+
 #ifdef ENABLE_DEBUG
 
+// The categories for which debug output is enabled at runtime, or 0 if debug output is disabled.
+// This is ABI like enabledDebug(), as the service library checks it too.
+extern TP_QT_EXPORT uint activeDebugCategories;
+
+/*
+ * Debug output for the given category, to be used as qDebug() is:
+ *
+ *     TP_QT_DEBUG(DebugCategoryMessages) << "Processing" << queue.size() << "messages";
+ *
+ * The statement is compiled out when the category is not in TP_QT_DEBUG_CATEGORIES, and the
+ * arguments are not evaluated at all when the category is disabled at runtime, so it's suitable for
+ * code which logs on every event.
+ */
+#define TP_QT_DEBUG(category) \
+    if (!((TP_QT_DEBUG_CATEGORIES) & (category)) || \
+            !(Tp::activeDebugCategories & (category))) { \
+    } else \
+        Tp::Debug(QtDebugMsg)
+
 inline Debug debug()
 {
     return enabledDebug();
@@ -165,8 +192,17 @@ inline NoDebug warning()
     return NoDebug();
 }
 
+#define TP_QT_DEBUG(category) \
+    if (true) { \
+    } else \
+        Tp::NoDebug()
+
 #endif /* #ifdef ENABLE_DEBUG */
 
+// Debug output in the general category. The library uses it instead of debug(), so that its
+// arguments aren't evaluated while debug output is disabled.
+#define tpDebug() TP_QT_DEBUG(Tp::DebugCategoryGeneral)
+
 } // Tp
 
 #endif
@@ -26,6 +26,12 @@
 
 #include "config-version.h"
 
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cstring>
+
 /**
  * \defgroup debug Common debug support
  *
@@ -37,6 +43,14 @@
  * warning messages. Normal debug output results in the normal operation of the
  * library, warning messages are output only when something goes wrong. Each
  * category can be invidually enabled.
+ *
+ * Normal debug output is further divided by area, as given by #DebugCategory,
+ * and the areas can be enabled and disabled individually with
+ * enableDebugCategories().
+ *
+ * Instead of being output right away, normal debug output can also be kept in a
+ * fixed-size ring buffer, see setDebugRingBufferSize(), and output on demand
+ * with dumpDebugRingBuffer(), for instance when something went wrong.
  */
 
 namespace Tp
@@ -94,18 +108,186 @@ namespace Tp
  * \sa DebugCallback
  */
 
+/**
+ * \enum DebugCategory
+ * \ingroup debug
+ *
+ * The areas normal debug output is divided into.
+ *
+ * \value DebugCategoryGeneral Debug output not covered by the other categories.
+ * \value DebugCategoryChannel Channel introspection and group membership changes.
+ * \value DebugCategoryMessages Text channel message queue processing.
+ * \value DebugCategoryConnection Connection introspection and handle tracking.
+ * \value DebugCategoryContacts Contact building and updates.
+ * \value DebugCategoryAccounts Account and account manager introspection.
+ * \value DebugCategoryClient Client registration and channel dispatching.
+ * \value DebugCategoryAll All of the above.
+ */
+
+/**
+ * \fn void enableDebugCategories(uint categories, bool enable)
+ * \ingroup debug
+ *
+ * Enable or disable normal debug output for the given categories. This only has
+ * an effect while debug output is enabled with enableDebug().
+ *
+ * All the categories are enabled by default.
+ *
+ * \param categories A bitwise OR of #DebugCategory values.
+ * \param enable Whether debug output should be enabled or not for \a categories.
+ */
+
+/**
+ * \fn uint enabledDebugCategories()
+ * \ingroup debug
+ *
+ * Return the categories normal debug output is enabled for, regardless of
+ * whether debug output is enabled with enableDebug().
+ *
+ * \return A bitwise OR of #DebugCategory values.
+ */
+
+/**
+ * \fn void setDebugRingBufferSize(int messages)
+ * \ingroup debug
+ *
+ * Keep the last \a messages normal debug messages in memory instead of handing
+ * them to the debug callback as they're produced. Warnings are still output
+ * right away. Setting a size of 0, which is the default, disables the ring
+ * buffer.
+ *
+ * Recording into the ring buffer doesn't take a mutex, so it's cheap enough to
+ * leave debug output enabled in production and only look at it when needed.
+ * Writers do wait for each other when the ring buffer wraps around onto a slot
+ * which is still being written, so it's not lock-free. Messages longer than
+ * 512 bytes are truncated, which is marked when they're output.
+ * The size must not be changed while other threads may be producing debug
+ * output.
+ *
+ * \param messages The number of messages to keep.
+ * \sa dumpDebugRingBuffer()
+ */
+
+/**
+ * \fn void dumpDebugRingBuffer()
+ * \ingroup debug
+ *
+ * Hand the debug messages kept in the ring buffer to the debug callback, oldest
+ * first, and empty the ring buffer.
+ *
+ * This can be called while other threads are producing debug output. Messages
+ * being recorded at the same time may be left out.
+ *
+ * \sa setDebugRingBufferSize()
+ */
+
 #ifdef ENABLE_DEBUG
 
 namespace
 {
 bool debugEnabled = false;
 bool warningsEnabled = true;
+uint debugCategories = DebugCategoryAll;
 DebugCallback debugCallback = NULL;
+
+// Each slot is guarded by a sequence number, which is odd while the slot is being written and
+// 2 * index + 2 once the message with the given index is in it. Writers take the next index from the
+// write index, and then claim the slot by switching its sequence number from even to odd, so two
+// writers whose indexes map to the same slot never write it at the same time. Readers copy the
+// slots out and discard the copies whose sequence number changed meanwhile.
+//
+// The indexes wrap around at ringBufferIndexLimit, which is a multiple of the size of the ring
+// buffer so that wrapping doesn't change which slot an index maps to, and small enough for the
+// sequence numbers to fit in an int.
+const int ringBufferMessageLength = 512;
+
+struct RingBufferSlot
+{
+    QAtomicInt sequence;
+    QtMsgType type;
+    int length;
+    bool truncated;
+    char message[ringBufferMessageLength];
+};
+
+RingBufferSlot *ringBuffer = 0;
+int ringBufferSize = 0;
+int ringBufferIndexLimit = 0;
+QAtomicInt ringBufferWriteIndex;
+int ringBufferReadIndex = 0;
+QMutex ringBufferReadLock;
+
+void updateActiveDebugCategories()
+{
+    activeDebugCategories = debugEnabled ? debugCategories : 0;
 }
 
+void outputMessage(QtMsgType type, const QString &msg)
+{
+    if (debugCallback) {
+        debugCallback(QLatin1String("tp-qt"), QLatin1String(PACKAGE_VERSION), type, msg);
+    } else {
+        switch (type) {
+        case QtDebugMsg:
+            qDebug() << "tp-qt " PACKAGE_VERSION " DEBUG:" << qPrintable(msg);
+            break;
+        case QtWarningMsg:
+            qWarning() << "tp-qt " PACKAGE_VERSION " WARN:" << qPrintable(msg);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int nextRingBufferIndex()
+{
+    int index;
+    do {
+        index = ringBufferWriteIndex.fetchAndAddOrdered(0);
+    } while (!ringBufferWriteIndex.testAndSetOrdered(index,
+                (index + 1) % ringBufferIndexLimit));
+    return index;
+}
+
+void recordMessage(QtMsgType type, const QString &msg)
+{
+    QByteArray utf8 = msg.toUtf8();
+    int length = utf8.size();
+    bool truncated = false;
+    if (length > ringBufferMessageLength) {
+        // don't cut a character in half
+        length = ringBufferMessageLength;
+        while (length > 0 && (utf8.at(length) & 0xc0) == 0x80) {
+            --length;
+        }
+        truncated = true;
+    }
+
+    int index = nextRingBufferIndex();
+    RingBufferSlot &slot = ringBuffer[index % ringBufferSize];
+
+    // The previous writer of the slot may still be at it if the ring buffer wrapped around
+    // meanwhile, in which case wait for it to be done
+    int sequence;
+    do {
+        sequence = slot.sequence.fetchAndAddOrdered(0);
+    } while ((sequence & 1) || !slot.sequence.testAndSetOrdered(sequence, index * 2 + 1));
+
+    slot.type = type;
+    slot.length = length;
+    slot.truncated = truncated;
+    memcpy(slot.message, utf8.constData(), length);
+    slot.sequence.fetchAndStoreOrdered(index * 2 + 2);
+}
+}
+
+uint activeDebugCategories = 0;
+
 void enableDebug(bool enable)
 {
     debugEnabled = enable;
+    updateActiveDebugCategories();
 }
 
 void enableWarnings(bool enable)
@@ -118,9 +300,82 @@ void setDebugCallback(DebugCallback cb)
     debugCallback = cb;
 }
 
+void enableDebugCategories(uint categories, bool enable)
+{
+    if (enable) {
+        debugCategories |= categories;
+    } else {
+        debugCategories &= ~categories;
+    }
+    updateActiveDebugCategories();
+}
+
+uint enabledDebugCategories()
+{
+    return debugCategories;
+}
+
+void setDebugRingBufferSize(int messages)
+{
+    delete [] ringBuffer;
+    ringBuffer = 0;
+    ringBufferSize = 0;
+    ringBufferIndexLimit = 0;
+    ringBufferWriteIndex.fetchAndStoreOrdered(0);
+    ringBufferReadIndex = 0;
+
+    if (messages > 0) {
+        ringBuffer = new RingBufferSlot[messages];
+        for (int i = 0; i < messages; ++i) {
+            ringBuffer[i].sequence.fetchAndStoreOrdered(0);
+        }
+        ringBufferSize = messages;
+        ringBufferIndexLimit = qMax((0x3fffffff / messages) * messages, messages);
+    }
+}
+
+void dumpDebugRingBuffer()
+{
+    if (!ringBuffer) {
+        return;
+    }
+
+    QMutexLocker locker(&ringBufferReadLock);
+
+    int end = ringBufferWriteIndex.fetchAndAddOrdered(0);
+    int count = qMin((end - ringBufferReadIndex + ringBufferIndexLimit) % ringBufferIndexLimit,
+            ringBufferSize);
+    char message[ringBufferMessageLength];
+    for (int i = count; i > 0; --i) {
+        int index = (end - i + ringBufferIndexLimit) % ringBufferIndexLimit;
+        RingBufferSlot &slot = ringBuffer[index % ringBufferSize];
+
+        int sequence = slot.sequence.fetchAndAddOrdered(0);
+        if (sequence != index * 2 + 2) {
+            // still being written, or already overwritten by a newer message
+            continue;
+        }
+        QtMsgType type = slot.type;
+        int length = qBound(0, slot.length, ringBufferMessageLength);
+        bool truncated = slot.truncated;
+        memcpy(message, slot.message, length);
+        if (slot.sequence.fetchAndAddOrdered(0) != sequence) {
+            // a writer got to the slot while it was being copied
+            continue;
+        }
+
+        QString msg = QString::fromUtf8(message, length);
+        if (truncated) {
+            msg += QLatin1String(" [truncated]");
+        }
+        outputMessage(type, msg);
+    }
+    ringBufferReadIndex = end;
+}
+
 Debug enabledDebug()
 {
-    if (debugEnabled) {
+    if (activeDebugCategories & DebugCategoryGeneral) {
         return Debug(QtDebugMsg);
     } else {
         return Debug();
@@ -138,19 +393,10 @@ Debug enabledWarning()
 
 void Debug::invokeDebugCallback()
 {
-    if (debugCallback) {
-        debugCallback(QLatin1String("tp-qt"), QLatin1String(PACKAGE_VERSION), type, msg);
+    if (ringBuffer && type == QtDebugMsg) {
+        recordMessage(type, msg);
     } else {
-        switch (type) {
-        case QtDebugMsg:
-            qDebug() << "tp-qt " PACKAGE_VERSION " DEBUG:" << qPrintable(msg);
-            break;
-        case QtWarningMsg:
-            qWarning() << "tp-qt " PACKAGE_VERSION " WARN:" << qPrintable(msg);
-            break;
-        default:
-            break;
-        }
+        outputMessage(type, msg);
     }
 }
 
@@ -168,6 +414,23 @@ void setDebugCallback(DebugCallback cb)
 {
 }
 
+void enableDebugCategories(uint categories, bool enable)
+{
+}
+
+uint enabledDebugCategories()
+{
+    return 0;
+}
+
+void setDebugRingBufferSize(int messages)
+{
+}
+
+void dumpDebugRingBuffer()
+{
+}
+
 Debug enabledDebug()
 {
     return Debug();
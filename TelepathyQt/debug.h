@@ -41,6 +41,23 @@ typedef void (*DebugCallback)(const QString &libraryName,
                               const QString &msg);
 TP_QT_EXPORT void setDebugCallback(DebugCallback cb);
 
+enum DebugCategory {
+    DebugCategoryGeneral = 0x0001,
+    DebugCategoryChannel = 0x0002,
+    DebugCategoryMessages = 0x0004,
+    DebugCategoryConnection = 0x0008,
+    DebugCategoryContacts = 0x0010,
+    DebugCategoryAccounts = 0x0020,
+    DebugCategoryClient = 0x0040,
+    DebugCategoryAll = 0xffff
+};
+
+TP_QT_EXPORT void enableDebugCategories(uint categories, bool enable);
+TP_QT_EXPORT uint enabledDebugCategories();
+
+TP_QT_EXPORT void setDebugRingBufferSize(int messages);
+TP_QT_EXPORT void dumpDebugRingBuffer();
+
 } // Tp
 
 #endif
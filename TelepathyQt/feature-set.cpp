@@ -0,0 +1,187 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/feature-set.h"
+
+namespace Tp
+{
+
+// FeatureSet stores a bit per Feature, at the position the Feature got in the process-wide feature
+// registry. There are only a few hundred features in total, so a set is a handful of words, and
+// checks and set operations don't need to hash or compare the class names.
+
+static int countBits(quint32 word)
+{
+    int count = 0;
+    while (word) {
+        word &= word - 1;
+        ++count;
+    }
+    return count;
+}
+
+FeatureSet::FeatureSet(const Features &features)
+    : mFeaturesValid(false)
+{
+    foreach (const Feature &feature, features) {
+        insert(feature);
+    }
+}
+
+bool FeatureSet::isEmpty() const
+{
+    for (int i = 0; i < mBits.size(); ++i) {
+        if (mBits.at(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int FeatureSet::size() const
+{
+    int ret = 0;
+    for (int i = 0; i < mBits.size(); ++i) {
+        ret += countBits(mBits.at(i));
+    }
+    return ret;
+}
+
+bool FeatureSet::contains(const FeatureSet &other) const
+{
+    for (int i = 0; i < other.mBits.size(); ++i) {
+        quint32 mine = i < mBits.size() ? mBits.at(i) : 0;
+        if (other.mBits.at(i) & ~mine) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FeatureSet::intersects(const FeatureSet &other) const
+{
+    int count = qMin(mBits.size(), other.mBits.size());
+    for (int i = 0; i < count; ++i) {
+        if (mBits.at(i) & other.mBits.at(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FeatureSet::insert(const Feature &feature)
+{
+    mFeaturesValid = false;
+    uint index = feature.index();
+    int word = index / 32;
+    if (word >= mBits.size()) {
+        mBits.resize(word + 1);
+    }
+    mBits[word] |= 1u << (index % 32);
+}
+
+void FeatureSet::remove(const Feature &feature)
+{
+    mFeaturesValid = false;
+    uint index = feature.index();
+    int word = index / 32;
+    if (word < mBits.size()) {
+        mBits[word] &= ~(1u << (index % 32));
+    }
+}
+
+FeatureSet &FeatureSet::unite(const FeatureSet &other)
+{
+    mFeaturesValid = false;
+    if (other.mBits.size() > mBits.size()) {
+        mBits.resize(other.mBits.size());
+    }
+    for (int i = 0; i < other.mBits.size(); ++i) {
+        mBits[i] |= other.mBits.at(i);
+    }
+    return *this;
+}
+
+FeatureSet &FeatureSet::subtract(const FeatureSet &other)
+{
+    mFeaturesValid = false;
+    int count = qMin(mBits.size(), other.mBits.size());
+    for (int i = 0; i < count; ++i) {
+        mBits[i] &= ~other.mBits.at(i);
+    }
+    return *this;
+}
+
+FeatureSet &FeatureSet::intersect(const FeatureSet &other)
+{
+    mFeaturesValid = false;
+    if (mBits.size() > other.mBits.size()) {
+        mBits.resize(other.mBits.size());
+    }
+    for (int i = 0; i < mBits.size(); ++i) {
+        mBits[i] &= other.mBits.at(i);
+    }
+    return *this;
+}
+
+bool FeatureSet::operator==(const FeatureSet &other) const
+{
+    // the vectors may have different sizes and only differ in trailing empty words
+    int count = qMax(mBits.size(), other.mBits.size());
+    for (int i = 0; i < count; ++i) {
+        quint32 mine = i < mBits.size() ? mBits.at(i) : 0;
+        quint32 theirs = i < other.mBits.size() ? other.mBits.at(i) : 0;
+        if (mine != theirs) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<Feature> FeatureSet::toList() const
+{
+    QList<uint> indexes;
+    for (int i = 0; i < mBits.size(); ++i) {
+        quint32 word = mBits.at(i);
+        for (int bit = 0; word; ++bit, word >>= 1) {
+            if (word & 1) {
+                indexes << i * 32 + bit;
+            }
+        }
+    }
+    return Feature::fromIndexes(indexes);
+}
+
+Features FeatureSet::toFeatures() const
+{
+    // The public accessors return the sets they keep as Features, usually without them having
+    // changed since the last call, so the conversion is only done again after a change
+    if (!mFeaturesValid) {
+        mFeatures.clear();
+        foreach (const Feature &feature, toList()) {
+            mFeatures.insert(feature);
+        }
+        mFeaturesValid = true;
+    }
+    return mFeatures;
+}
+
+} // Tp
@@ -0,0 +1,83 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_feature_set_h_HEADER_GUARD_
+#define _TelepathyQt_feature_set_h_HEADER_GUARD_
+
+#include <TelepathyQt/Feature>
+
+#include <QList>
+#include <QVector>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace Tp
+{
+
+class TP_QT_NO_EXPORT FeatureSet
+{
+public:
+    FeatureSet() : mFeaturesValid(false) { }
+    FeatureSet(const Feature &feature) : mFeaturesValid(false) { insert(feature); }
+    FeatureSet(const Features &features);
+
+    bool isEmpty() const;
+    int size() const;
+
+    bool contains(const Feature &feature) const
+    {
+        uint index = feature.index();
+        int word = index / 32;
+        return word < mBits.size() && (mBits.at(word) & (1u << (index % 32)));
+    }
+    bool contains(const FeatureSet &other) const;
+    bool intersects(const FeatureSet &other) const;
+
+    void insert(const Feature &feature);
+    void remove(const Feature &feature);
+    void clear() { mBits.clear(); mFeaturesValid = false; }
+
+    FeatureSet &unite(const FeatureSet &other);
+    FeatureSet &subtract(const FeatureSet &other);
+    FeatureSet &intersect(const FeatureSet &other);
+
+    FeatureSet &operator+=(const FeatureSet &other) { return unite(other); }
+    FeatureSet &operator-=(const FeatureSet &other) { return subtract(other); }
+    FeatureSet operator-(const FeatureSet &other) const { return FeatureSet(*this).subtract(other); }
+
+    bool operator==(const FeatureSet &other) const;
+    bool operator!=(const FeatureSet &other) const { return !(*this == other); }
+
+    QList<Feature> toList() const;
+    Features toFeatures() const;
+
+private:
+    QVector<quint32> mBits;
+    // The Features view handed out by toFeatures(), built on first use after each change
+    mutable Features mFeatures;
+    mutable bool mFeaturesValid;
+};
+
+} // Tp
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+#endif
@@ -22,16 +22,49 @@
 
 #include <TelepathyQt/Feature>
 
+#include <QHash>
+#include <QList>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QWriteLocker>
+
 namespace Tp
 {
 
 struct TP_QT_NO_EXPORT Feature::Private : public QSharedData
 {
-    Private(bool critical) : critical(critical) {}
+    Private(bool critical, uint index) : critical(critical), index(index) {}
+
+    const bool critical;
+    // Position of the feature in the registry, so sets of features can be represented as bitsets
+    // and compared without looking at the class names
+    const uint index;
+};
+
+namespace
+{
+
+// Maps each (class name, id) pair to a small integer, the first time a Feature is constructed for
+// it. The features are mostly constructed once, when the static Feature members are defined, and
+// copied from then on, so the registry is only looked up again for features built on the fly.
+struct FeatureRegistry
+{
+    FeatureRegistry()
+    {
+        // the invalid feature always has index 0, so it never needs to be looked up
+        indexes.insert(QPair<QString, uint>(), 0);
+        features.append(Feature());
+    }
 
-    bool critical;
+    QReadWriteLock lock;
+    QHash<QPair<QString, uint>, uint> indexes;
+    QList<Feature> features;
 };
 
+}
+
+Q_GLOBAL_STATIC(FeatureRegistry, featureRegistry)
+
 /**
  * \class Feature
  * \ingroup utils
@@ -48,7 +81,13 @@ Feature::Feature()
 
 Feature::Feature(const QString &className, uint id, bool critical)
     : QPair<QString, uint>(className, id),
-      mPriv(new Private(critical))
+      mPriv(new Private(critical, internFeature(className, id, critical)))
+{
+}
+
+Feature::Feature(const QString &className, uint id, bool critical, uint index)
+    : QPair<QString, uint>(className, id),
+      mPriv(new Private(critical, index))
 {
 }
 
@@ -64,7 +103,7 @@ Feature::~Feature()
 
 Feature &Feature::operator=(const Feature &other)
 {
-    *this = other;
+    QPair<QString, uint>::operator=(other);
     this->mPriv = other.mPriv;
     return *this;
 }
@@ -78,6 +117,57 @@ bool Feature::isCritical() const
     return mPriv->critical;
 }
 
+uint Feature::index() const
+{
+    if (!isValid()) {
+        return 0;
+    }
+
+    return mPriv->index;
+}
+
+uint Feature::internFeature(const QString &className, uint id, bool critical)
+{
+    FeatureRegistry *registry = featureRegistry();
+    QPair<QString, uint> key(className, id);
+
+    {
+        QReadLocker locker(&registry->lock);
+        QHash<QPair<QString, uint>, uint>::const_iterator i = registry->indexes.constFind(key);
+        if (i != registry->indexes.constEnd() &&
+                (!critical || registry->features.at(i.value()).isCritical())) {
+            return i.value();
+        }
+    }
+
+    QWriteLocker locker(&registry->lock);
+    uint index;
+    QHash<QPair<QString, uint>, uint>::const_iterator i = registry->indexes.constFind(key);
+    if (i != registry->indexes.constEnd()) {
+        index = i.value();
+        // keep the critical flag around for the features built back from their index
+        if (critical && !registry->features.at(index).isCritical()) {
+            registry->features[index] = Feature(className, id, true, index);
+        }
+    } else {
+        index = registry->features.size();
+        registry->indexes.insert(key, index);
+        registry->features.append(Feature(className, id, critical, index));
+    }
+    return index;
+}
+
+QList<Feature> Feature::fromIndexes(const QList<uint> &indexes)
+{
+    FeatureRegistry *registry = featureRegistry();
+    QReadLocker locker(&registry->lock);
+    QList<Feature> ret;
+    foreach (uint index, indexes) {
+        ret << registry->features.value(index);
+    }
+    return ret;
+}
+
 /**
  * \class Features
  * \ingroup utils
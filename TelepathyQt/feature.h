@@ -29,6 +29,7 @@
 
 #include <TelepathyQt/Global>
 
+#include <QList>
 #include <QMetaType>
 #include <QPair>
 #include <QSet>
@@ -53,6 +54,14 @@ public:
     bool isCritical() const;
 
 private:
+    friend class FeatureSet;
+
+    Feature(const QString &className, uint id, bool critical, uint index);
+
+    uint index() const;
+    static uint internFeature(const QString &className, uint id, bool critical);
+    static QList<Feature> fromIndexes(const QList<uint> &indexes);
+
     struct Private;
     friend struct Private;
     QSharedDataPointer<Private> mPriv;
@@ -68,6 +68,9 @@ struct TP_QT_NO_EXPORT FileTransferChannel::Private
 
     bool connected;
     bool finished;
+
+    bool threadedTransfer;
+    bool localTransferredBytes;
 };
 
 FileTransferChannel::Private::Private(FileTransferChannel *parent)
@@ -84,7 +87,9 @@ FileTransferChannel::Private::Private(FileTransferChannel *parent)
       size(0),
       transferredBytes(0),
       connected(false),
-      finished(false)
+      finished(false),
+      threadedTransfer(false),
+      localTransferredBytes(false)
 {
     parent->connect(fileTransferInterface,
             SIGNAL(InitialOffsetDefined(qulonglong)),
@@ -467,6 +472,46 @@ qulonglong FileTransferChannel::transferredBytes() const
     return mPriv->transferredBytes;
 }
 
+/**
+ * Return whether the data of this transfer is sent or received from a worker
+ * thread.
+ *
+ * \return \c true if threaded transfers are enabled, \c false otherwise.
+ * \sa setThreadedTransferEnabled()
+ */
+bool FileTransferChannel::isThreadedTransferEnabled() const
+{
+    return mPriv->threadedTransfer;
+}
+
+/**
+ * Set whether the data of this transfer should be sent or received from a
+ * worker thread instead of the thread this channel belongs to.
+ *
+ * By default all socket and device I/O happens in the thread this channel
+ * belongs to, which is usually the main thread. When several transfers are
+ * running at the same time this may keep its event loop busy. Threaded
+ * transfers move that I/O to a small pool of threads shared by all channels.
+ *
+ * This only has an effect if called before
+ * OutgoingFileTransferChannel::provideFile() or
+ * IncomingFileTransferChannel::acceptFile(), and only when the device passed
+ * to them is a QFile, as other devices usually depend on the event loop of
+ * their own thread. The device must not be used by the application until the
+ * transfer is finished.
+ *
+ * When enabled, transferredBytesChanged() is also emitted as data is
+ * transferred, at most every 100 milliseconds, without waiting for the
+ * connection manager to report progress.
+ *
+ * \param enabled Whether to enable threaded transfers.
+ * \sa isThreadedTransferEnabled()
+ */
+void FileTransferChannel::setThreadedTransferEnabled(bool enabled)
+{
+    mPriv->threadedTransfer = enabled;
+}
+
 /**
  * Return a mapping from address types (members of #SocketAddressType) to arrays
  * of access-control type (members of #SocketAccessControl) that the CM
@@ -573,6 +618,28 @@ void FileTransferChannel::setFinished()
     changeState();
 }
 
+/**
+ * Update the number of bytes transferred with progress observed locally.
+ *
+ * Specialized classes that know how much data went through the socket may
+ * call this method so that transferredBytesChanged() doesn't only depend on
+ * the connection manager. From then on, values reported by the connection
+ * manager which are behind the local progress are ignored.
+ *
+ * \param count The number of bytes transferred.
+ * \sa transferredBytes()
+ */
+void FileTransferChannel::setTransferredBytes(qulonglong count)
+{
+    mPriv->localTransferredBytes = true;
+    if (count <= mPriv->transferredBytes) {
+        return;
+    }
+
+    mPriv->transferredBytes = count;
+    emit transferredBytesChanged(count);
+}
+
 void FileTransferChannel::gotProperties(QDBusPendingCallWatcher *watcher)
 {
     QDBusPendingReply<QVariantMap> reply = *watcher;
@@ -580,7 +647,7 @@ void FileTransferChannel::gotProperties(QDBusPendingCallWatcher *watcher)
     if (!reply.isError()) {
         QVariantMap props = reply.value();
         mPriv->extractProperties(props);
-        debug() << "Got reply to Properties::GetAll(FileTransferChannel)";
+        tpDebug() << "Got reply to Properties::GetAll(FileTransferChannel)";
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
     }
     else {
@@ -609,7 +676,7 @@ void FileTransferChannel::onStateChanged(uint state, uint stateReason)
         return;
     }
 
-    debug() << "File transfer state changed to" << state <<
+    tpDebug() << "File transfer state changed to" << state <<
         "with reason" << stateReason;
     mPriv->pendingState = (FileTransferState) state;
     mPriv->pendingStateReason = (FileTransferStateChangeReason) stateReason;
@@ -660,6 +727,10 @@ void FileTransferChannel::onInitialOffsetDefined(qulonglong initialOffset)
 
 void FileTransferChannel::onTransferredBytesChanged(qulonglong count)
 {
+    if (mPriv->localTransferredBytes && count <= mPriv->transferredBytes) {
+        return;
+    }
+
     mPriv->transferredBytes = count;
     emit transferredBytesChanged(count);
 }
@@ -64,6 +64,9 @@ public:
 
     qulonglong transferredBytes() const;
 
+    bool isThreadedTransferEnabled() const;
+    void setThreadedTransferEnabled(bool enabled);
+
     PendingOperation *cancel();
 
 Q_SIGNALS:
@@ -86,6 +89,8 @@ protected:
     bool isFinished() const;
     virtual void setFinished();
 
+    void setTransferredBytes(qulonglong count);
+
 private Q_SLOTS:
     TP_QT_NO_EXPORT void gotProperties(QDBusPendingCallWatcher *watcher);
 
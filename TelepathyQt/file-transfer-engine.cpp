@@ -0,0 +1,292 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/file-transfer-engine.h"
+
+#include "config.h"
+
+#include "TelepathyQt/debug-internal.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+#include <QtNetwork/QAbstractSocket>
+
+#ifdef HAVE_SENDFILE
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <sys/types.h>
+#endif
+
+namespace Tp
+{
+
+// Size of the buffer used when the data has to go through user space
+static const int FT_BLOCK_SIZE = 64 * 1024;
+// Don't queue more than this in the socket write buffer, so memory usage stays bounded no matter
+// how much faster the input is than the socket
+static const qint64 FT_MAX_PENDING_BYTES = 4 * FT_BLOCK_SIZE;
+// Maximum amount of data sent by a single sendfile() call
+static const qint64 FT_SENDFILE_CHUNK_SIZE = 1024 * 1024;
+
+struct TP_QT_NO_EXPORT FileTransferEngine::Private
+{
+    Private(QAbstractSocket *socket, QIODevice *device)
+        : socket(socket),
+          device(device),
+          pos(0),
+          offset(0),
+          zeroCopy(false)
+    {
+    }
+
+    QAbstractSocket *socket;
+    QIODevice *device;
+    qint64 pos;
+    qint64 offset;
+    bool zeroCopy;
+    QByteArray buffer;
+};
+
+FileTransferEngine::FileTransferEngine(QAbstractSocket *socket, QIODevice *device)
+    : mPriv(new Private(socket, device))
+{
+}
+
+FileTransferEngine::~FileTransferEngine()
+{
+    delete mPriv;
+}
+
+qint64 FileTransferEngine::position() const
+{
+    return mPriv->pos;
+}
+
+bool FileTransferEngine::isZeroCopy() const
+{
+    return mPriv->zeroCopy;
+}
+
+void FileTransferEngine::setZeroCopyEnabled(bool enabled)
+{
+    if (!enabled) {
+        if (mPriv->zeroCopy) {
+            // keep the device position in sync for the buffered path
+            mPriv->device->seek(mPriv->pos);
+        }
+        mPriv->zeroCopy = false;
+        return;
+    }
+
+#ifdef HAVE_SENDFILE
+    // Only a regular file can be sent directly from the kernel, and only from the sending side,
+    // as QAbstractSocket reads incoming data into its own buffer
+    QFile *file = qobject_cast<QFile *>(mPriv->device);
+    mPriv->zeroCopy = (file && file->handle() != -1 && !file->isSequential() &&
+            mPriv->socket->socketDescriptor() != -1 &&
+            (file->openMode() & QIODevice::ReadOnly) &&
+            (mPriv->socket->openMode() & QIODevice::WriteOnly));
+#endif
+}
+
+char *FileTransferEngine::buffer()
+{
+    if (mPriv->buffer.isEmpty()) {
+        // allocated once and reused, its content never needs to be cleared
+        mPriv->buffer.resize(FT_BLOCK_SIZE);
+    }
+    return mPriv->buffer.data();
+}
+
+int FileTransferEngine::bufferSize() const
+{
+    return FT_BLOCK_SIZE;
+}
+
+FileTransferSender::FileTransferSender(QIODevice *input, QAbstractSocket *output)
+    : FileTransferEngine(output, input)
+{
+    setZeroCopyEnabled(true);
+}
+
+FileTransferSender::~FileTransferSender()
+{
+}
+
+void FileTransferSender::setOffset(qint64 offset)
+{
+    mPriv->offset = offset;
+
+    // for non sequential devices, seek to the offset instead of reading up to it
+    if (!mPriv->device->isSequential() && mPriv->device->seek(offset)) {
+        mPriv->pos = offset;
+    }
+}
+
+FileTransferEngine::Status FileTransferSender::transfer()
+{
+    if (mPriv->pos < mPriv->offset) {
+        return skip();
+    }
+
+    if (mPriv->zeroCopy) {
+        return sendFile();
+    }
+
+    if (mPriv->socket->bytesToWrite() >= FT_MAX_PENDING_BYTES) {
+        return WouldBlock;
+    }
+
+    qint64 len = mPriv->device->read(buffer(), bufferSize());
+    if (len < 0) {
+        warning() << "Error reading file transfer input:" << mPriv->device->errorString();
+        return Error;
+    }
+
+    if (len > 0) {
+        if (mPriv->socket->write(buffer(), len) != len) {
+            warning() << "Error writing file transfer data:" << mPriv->socket->errorString();
+            return Error;
+        }
+        mPriv->pos += len;
+    }
+
+    if (!mPriv->device->isSequential() && mPriv->device->atEnd()) {
+        return Finished;
+    }
+
+    return len > 0 ? Progress : NeedData;
+}
+
+FileTransferEngine::Status FileTransferSender::skip()
+{
+    // only sequential devices (or those we failed to seek) get here
+    qint64 len = mPriv->device->read(buffer(), qMin(mPriv->offset - mPriv->pos,
+                static_cast<qint64>(bufferSize())));
+    if (len < 0) {
+        warning() << "Error reading file transfer input:" << mPriv->device->errorString();
+        return Error;
+    }
+
+    tpDebug() << "skipping" << len << "bytes";
+    mPriv->pos += len;
+
+    if (len == 0) {
+        return (!mPriv->device->isSequential() && mPriv->device->atEnd()) ? Finished : NeedData;
+    }
+
+    return Progress;
+}
+
+FileTransferEngine::Status FileTransferSender::sendFile()
+{
+#ifdef HAVE_SENDFILE
+    if (mPriv->socket->bytesToWrite() > 0) {
+        // whatever was written through the socket needs to go first
+        return WouldBlock;
+    }
+
+    QFile *file = static_cast<QFile *>(mPriv->device);
+    off_t offset = mPriv->pos;
+    ssize_t len = ::sendfile(mPriv->socket->socketDescriptor(), file->handle(), &offset,
+            FT_SENDFILE_CHUNK_SIZE);
+    if (len > 0) {
+        mPriv->pos += len;
+        return Progress;
+    } else if (len == 0) {
+        mPriv->device->seek(mPriv->pos);
+        return Finished;
+    }
+
+    switch (errno) {
+        case EAGAIN:
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+        case EWOULDBLOCK:
+#endif
+            return WouldBlock;
+        case EINTR:
+            return Progress;
+        case EINVAL:
+        case ENOSYS:
+            tpDebug() << "sendfile() not usable for this transfer, falling back to buffered copy";
+            setZeroCopyEnabled(false);
+            return Progress;
+        default:
+            warning() << "Error sending file transfer data, errno:" << errno;
+            return Error;
+    }
+#else
+    setZeroCopyEnabled(false);
+    return Progress;
+#endif
+}
+
+FileTransferReceiver::FileTransferReceiver(QAbstractSocket *input, QIODevice *output)
+    : FileTransferEngine(input, output)
+{
+}
+
+FileTransferReceiver::~FileTransferReceiver()
+{
+}
+
+void FileTransferReceiver::setOffset(qint64 position, qint64 requestedOffset)
+{
+    mPriv->pos = position;
+    mPriv->offset = requestedOffset;
+}
+
+FileTransferEngine::Status FileTransferReceiver::transfer()
+{
+    qint64 available = mPriv->socket->bytesAvailable();
+    if (available <= 0) {
+        return NeedData;
+    }
+
+    qint64 len = mPriv->socket->read(buffer(), qMin(available,
+                static_cast<qint64>(bufferSize())));
+    if (len < 0) {
+        warning() << "Error reading file transfer data:" << mPriv->socket->errorString();
+        return Error;
+    }
+
+    // skip until we reach the requested offset and start writing from there
+    const char *data = buffer();
+    if (mPriv->pos < mPriv->offset) {
+        qint64 skip = qMin(mPriv->offset - mPriv->pos, len);
+        mPriv->pos += skip;
+        data += skip;
+        len -= skip;
+    }
+
+    if (len > 0) {
+        if (mPriv->device->write(data, len) != len) {
+            warning() << "Error writing file transfer output:" << mPriv->device->errorString();
+            return Error;
+        }
+        mPriv->pos += len;
+    }
+
+    return Progress;
+}
+
+} // Tp
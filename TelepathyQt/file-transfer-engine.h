@@ -0,0 +1,105 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_file_transfer_engine_h_HEADER_GUARD_
+#define _TelepathyQt_file_transfer_engine_h_HEADER_GUARD_
+
+#include <TelepathyQt/Global>
+
+#include <QtGlobal>
+
+class QAbstractSocket;
+class QIODevice;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace Tp
+{
+
+class TP_QT_NO_EXPORT FileTransferEngine
+{
+public:
+    enum Status {
+        // Some data was transferred, more may be transferred right away
+        Progress = 0,
+        // The destination can't take more data for now
+        WouldBlock,
+        // The source has no data available for now
+        NeedData,
+        // All the data was transferred
+        Finished,
+        Error
+    };
+
+    virtual ~FileTransferEngine();
+
+    qint64 position() const;
+
+    bool isZeroCopy() const;
+    void setZeroCopyEnabled(bool enabled);
+
+    virtual Status transfer() = 0;
+
+protected:
+    FileTransferEngine(QAbstractSocket *socket, QIODevice *device);
+
+    char *buffer();
+    int bufferSize() const;
+
+    struct Private;
+    friend struct Private;
+    Private *mPriv;
+
+private:
+    Q_DISABLE_COPY(FileTransferEngine)
+};
+
+class TP_QT_NO_EXPORT FileTransferSender : public FileTransferEngine
+{
+public:
+    FileTransferSender(QIODevice *input, QAbstractSocket *output);
+    ~FileTransferSender();
+
+    void setOffset(qint64 offset);
+
+    Status transfer();
+
+private:
+    Status sendFile();
+    Status skip();
+};
+
+class TP_QT_NO_EXPORT FileTransferReceiver : public FileTransferEngine
+{
+public:
+    FileTransferReceiver(QAbstractSocket *input, QIODevice *output);
+    ~FileTransferReceiver();
+
+    void setOffset(qint64 position, qint64 requestedOffset);
+
+    Status transfer();
+};
+
+}
+
+#endif /* DOXYGEN_SHOULD_SKIP_THIS */
+
+#endif
@@ -0,0 +1,413 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/file-transfer-worker-internal.h"
+
+#include "TelepathyQt/_gen/file-transfer-worker-internal.moc.hpp"
+
+#include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/file-transfer-engine.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QMutexLocker>
+#include <QSocketNotifier>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+namespace Tp
+{
+
+// Maximum number of transfer steps done before returning to the main loop
+static const int FT_MAX_STEPS = 16;
+// Minimum interval between two progress notifications, in milliseconds
+static const int FT_PROGRESS_INTERVAL = 100;
+// Maximum number of threads shared by all the threaded transfers, the transfers are mostly
+// I/O bound so there is no point in having one thread per transfer
+static const int FT_MAX_POOL_THREADS = 4;
+
+static QMutex workerPoolLock;
+static QList<QThread *> workerPoolThreads;
+static QHash<QThread *, int> workerPoolLoad;
+
+static void stopWorkerPool()
+{
+    QMutexLocker locker(&workerPoolLock);
+    foreach (QThread *thread, workerPoolThreads) {
+        thread->quit();
+    }
+    foreach (QThread *thread, workerPoolThreads) {
+        thread->wait();
+        delete thread;
+    }
+    workerPoolThreads.clear();
+    workerPoolLoad.clear();
+}
+
+FileTransferWorker::FileTransferWorker(Direction direction, QIODevice *device)
+    : mDirection(direction),
+      mDevice(device),
+      mPort(0),
+      mPosition(0),
+      mRequestedOffset(0),
+      mThreaded(false),
+      mFinished(false),
+      mStopped(false),
+      mSocket(0),
+      mEngine(0),
+      mWriteNotifier(0),
+      mTransferScheduled(false),
+      mProgress(0),
+      mProgressPending(false),
+      mProgressFlushScheduled(false)
+{
+}
+
+FileTransferWorker::~FileTransferWorker()
+{
+    if (mThreaded) {
+        QMutexLocker locker(&workerPoolLock);
+        QHash<QThread *, int>::iterator i = workerPoolLoad.find(thread());
+        if (i != workerPoolLoad.end()) {
+            --i.value();
+        }
+    }
+
+    delete mEngine;
+}
+
+bool FileTransferWorker::canRunInThread(QIODevice *device)
+{
+    // Only regular files are safe to be used from another thread, other devices usually rely
+    // on the event loop of the thread they belong to
+    return qobject_cast<QFile *>(device) && !device->isSequential();
+}
+
+void FileTransferWorker::moveToPool()
+{
+    QMutexLocker locker(&workerPoolLock);
+
+    if (workerPoolThreads.isEmpty()) {
+        int count = qBound(1, QThread::idealThreadCount(), FT_MAX_POOL_THREADS);
+        for (int i = 0; i < count; ++i) {
+            QThread *thread = new QThread;
+            thread->setObjectName(QLatin1String("Tp::FileTransferWorker"));
+            thread->start();
+            workerPoolThreads.append(thread);
+            workerPoolLoad.insert(thread, 0);
+        }
+        qAddPostRoutine(stopWorkerPool);
+    }
+
+    QThread *leastLoaded = workerPoolThreads.first();
+    foreach (QThread *thread, workerPoolThreads) {
+        if (workerPoolLoad.value(thread) < workerPoolLoad.value(leastLoaded)) {
+            leastLoaded = thread;
+        }
+    }
+    ++workerPoolLoad[leastLoaded];
+
+    mThreaded = true;
+    moveToThread(leastLoaded);
+}
+
+void FileTransferWorker::setOffset(qint64 position, qint64 requestedOffset)
+{
+    mPosition = position;
+    mRequestedOffset = requestedOffset;
+}
+
+void FileTransferWorker::connectToHost(const QString &address, quint16 port)
+{
+    mAddress = address;
+    mPort = port;
+
+    if (mThreaded) {
+        QMetaObject::invokeMethod(this, "doConnectToHost", Qt::QueuedConnection);
+    } else {
+        doConnectToHost();
+    }
+}
+
+void FileTransferWorker::finishInput()
+{
+    invoke("doFinishInput");
+}
+
+void FileTransferWorker::stop()
+{
+    invoke("doStop");
+}
+
+qint64 FileTransferWorker::takeProgress()
+{
+    QMutexLocker locker(&mProgressLock);
+    mProgressPending = false;
+    return mProgress;
+}
+
+void FileTransferWorker::invoke(const char *method)
+{
+    // the worker thread never waits for the channel's thread, so blocking here is safe
+    Qt::ConnectionType type = Qt::DirectConnection;
+    if (thread() != QThread::currentThread() && thread()->isRunning()) {
+        type = Qt::BlockingQueuedConnection;
+    }
+    QMetaObject::invokeMethod(this, method, type);
+}
+
+void FileTransferWorker::doConnectToHost()
+{
+    mSocket = new QTcpSocket(this);
+
+    connect(mSocket, SIGNAL(connected()),
+            SLOT(onSocketConnected()));
+    connect(mSocket, SIGNAL(disconnected()),
+            SLOT(onSocketDisconnected()));
+    connect(mSocket, SIGNAL(error(QAbstractSocket::SocketError)),
+            SLOT(onSocketError(QAbstractSocket::SocketError)));
+
+    if (mDirection == Send) {
+        connect(mSocket, SIGNAL(bytesWritten(qint64)),
+                SLOT(doTransfer()));
+    } else {
+        connect(mSocket, SIGNAL(readyRead()),
+                SLOT(doTransfer()));
+
+        FileTransferReceiver *receiver = new FileTransferReceiver(mSocket, mDevice);
+        receiver->setOffset(mPosition, mRequestedOffset);
+        mEngine = receiver;
+    }
+
+    tpDebug().nospace() << "Connecting to host " << mAddress << ":" << mPort <<
+        (mThreaded ? " from a worker thread..." : "...");
+    mSocket->connectToHost(mAddress, mPort);
+}
+
+void FileTransferWorker::onSocketConnected()
+{
+    tpDebug() << "Connected to host";
+    emit connected();
+
+    if (mDirection == Send) {
+        connect(mDevice, SIGNAL(readyRead()),
+                SLOT(doTransfer()));
+
+        FileTransferSender *sender = new FileTransferSender(mDevice, mSocket);
+        sender->setOffset(mPosition);
+        mEngine = sender;
+
+        if (sender->isZeroCopy()) {
+            mWriteNotifier = new QSocketNotifier(mSocket->socketDescriptor(),
+                    QSocketNotifier::Write, this);
+            mWriteNotifier->setEnabled(false);
+            connect(mWriteNotifier, SIGNAL(activated(int)),
+                    SLOT(doTransfer()));
+        }
+
+        tpDebug() << "Starting transfer..." << (sender->isZeroCopy() ?
+                "(sending file directly)" : "");
+    }
+
+    doTransfer();
+}
+
+void FileTransferWorker::onSocketDisconnected()
+{
+    tpDebug() << "Disconnected from host";
+    setFinished();
+}
+
+void FileTransferWorker::onSocketError(QAbstractSocket::SocketError error)
+{
+    tpDebug() << "Socket error" << error;
+    setFinished();
+}
+
+void FileTransferWorker::doTransfer()
+{
+    mTransferScheduled = false;
+    if (!mEngine || mFinished || mStopped) {
+        return;
+    }
+
+    if (mDirection == Send) {
+        send();
+    } else {
+        receive();
+    }
+}
+
+void FileTransferWorker::send()
+{
+    if (mWriteNotifier) {
+        mWriteNotifier->setEnabled(false);
+    }
+
+    // transfer a bounded amount of data each time, as input can be a QFile, we don't want to
+    // block reading the whole file
+    FileTransferEngine::Status status = FileTransferEngine::Progress;
+    for (int i = 0; i < FT_MAX_STEPS && status == FileTransferEngine::Progress; ++i) {
+        status = mEngine->transfer();
+    }
+
+    switch (status) {
+        case FileTransferEngine::Finished:
+        case FileTransferEngine::Error:
+            setFinished();
+            return;
+        case FileTransferEngine::WouldBlock:
+            // if data is pending in the socket, bytesWritten() will be emitted once it's
+            // written, otherwise wait until the socket can take more data
+            if (mWriteNotifier && mSocket->bytesToWrite() == 0) {
+                mWriteNotifier->setEnabled(true);
+            }
+            break;
+        case FileTransferEngine::NeedData:
+            // readyRead() will be emitted when more data is available
+            break;
+        case FileTransferEngine::Progress:
+            // more data may be readily available, but give the main loop a chance to run first,
+            // as readyRead may never be emitted and bytesWritten may not be either
+            if (!mTransferScheduled) {
+                mTransferScheduled = true;
+                QMetaObject::invokeMethod(this, "doTransfer", Qt::QueuedConnection);
+            }
+            break;
+    }
+
+    updateProgress(false);
+}
+
+void FileTransferWorker::receive()
+{
+    // write whatever is available, a buffer at a time
+    FileTransferEngine::Status status;
+    do {
+        status = mEngine->transfer();
+    } while (status == FileTransferEngine::Progress);
+
+    if (status == FileTransferEngine::Error) {
+        setFinished();
+        return;
+    }
+
+    updateProgress(false);
+}
+
+void FileTransferWorker::doFinishInput()
+{
+    if (!mEngine || mStopped) {
+        return;
+    }
+
+    // makes sure the input position is where the transfer got to
+    mEngine->setZeroCopyEnabled(false);
+
+    // read all remaining data from input device and write to output device
+    QByteArray data;
+    data = mDevice->readAll();
+    mSocket->write(data); // never fails
+}
+
+void FileTransferWorker::doStop()
+{
+    if (mStopped) {
+        return;
+    }
+
+    mStopped = true;
+    mFinished = true;
+
+    if (mSocket) {
+        disconnect(mSocket, 0, this, 0);
+        mSocket->close();
+    }
+
+    if (mWriteNotifier) {
+        mWriteNotifier->setEnabled(false);
+    }
+
+    disconnect(mDevice, 0, this, 0);
+}
+
+void FileTransferWorker::updateProgress(bool force)
+{
+    // progress is only reported from here for threaded transfers, the connection manager
+    // reports it otherwise
+    if (!mThreaded || !mEngine) {
+        return;
+    }
+
+    QMutexLocker locker(&mProgressLock);
+    mProgress = mEngine->position();
+
+    if (mProgressPending) {
+        // the previous notification wasn't handled yet, it will pick the new value up
+        return;
+    }
+
+    if (!force && !mProgressTime.isNull()) {
+        int elapsed = mProgressTime.elapsed();
+        if (elapsed < FT_PROGRESS_INTERVAL) {
+            if (!mProgressFlushScheduled) {
+                mProgressFlushScheduled = true;
+                QTimer::singleShot(FT_PROGRESS_INTERVAL - elapsed, this, SLOT(flushProgress()));
+            }
+            return;
+        }
+    }
+
+    mProgressPending = true;
+    mProgressTime.start();
+    locker.unlock();
+
+    emit progressChanged();
+}
+
+void FileTransferWorker::flushProgress()
+{
+    mProgressFlushScheduled = false;
+
+    // the end of the transfer was already reported, and nothing is reported once stopped
+    if (mFinished) {
+        return;
+    }
+
+    updateProgress(true);
+}
+
+void FileTransferWorker::setFinished()
+{
+    if (mFinished) {
+        return;
+    }
+
+    mFinished = true;
+    updateProgress(true);
+    emit finished();
+}
+
+} // Tp
@@ -0,0 +1,125 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _TelepathyQt_file_transfer_worker_internal_h_HEADER_GUARD_
+#define _TelepathyQt_file_transfer_worker_internal_h_HEADER_GUARD_
+
+#include <TelepathyQt/Global>
+
+#include <QAbstractSocket>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTime>
+
+class QIODevice;
+class QSocketNotifier;
+class QTcpSocket;
+
+namespace Tp
+{
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+class FileTransferEngine;
+
+// Does the socket and device I/O of a file transfer channel, either from the thread owning the
+// channel or from a thread of a shared pool
+class TP_QT_NO_EXPORT FileTransferWorker : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(FileTransferWorker)
+
+public:
+    enum Direction {
+        Send,
+        Receive
+    };
+
+    FileTransferWorker(Direction direction, QIODevice *device);
+    ~FileTransferWorker();
+
+    static bool canRunInThread(QIODevice *device);
+
+    bool isThreaded() const { return mThreaded; }
+    void moveToPool();
+
+    void setOffset(qint64 position, qint64 requestedOffset);
+    void connectToHost(const QString &address, quint16 port);
+
+    // Both block until the worker thread is done with them, after which the device can be used
+    // again from the calling thread
+    void finishInput();
+    void stop();
+
+    qint64 takeProgress();
+
+Q_SIGNALS:
+    void connected();
+    void finished();
+    void progressChanged();
+
+private Q_SLOTS:
+    void doConnectToHost();
+    void onSocketConnected();
+    void onSocketDisconnected();
+    void onSocketError(QAbstractSocket::SocketError error);
+    void doTransfer();
+    void doFinishInput();
+    void doStop();
+    void flushProgress();
+
+private:
+    void invoke(const char *method);
+    void send();
+    void receive();
+    void updateProgress(bool force);
+    void setFinished();
+
+    Direction mDirection;
+    QIODevice *mDevice;
+    QString mAddress;
+    quint16 mPort;
+    qint64 mPosition;
+    qint64 mRequestedOffset;
+    bool mThreaded;
+    bool mFinished;
+    bool mStopped;
+
+    QTcpSocket *mSocket;
+    FileTransferEngine *mEngine;
+    // Used to know when the socket is writable again when sending the file directly, as
+    // QTcpSocket::bytesWritten() is only emitted for data written through it
+    QSocketNotifier *mWriteNotifier;
+    bool mTransferScheduled;
+
+    QMutex mProgressLock;
+    qint64 mProgress;
+    bool mProgressPending;
+    bool mProgressFlushScheduled;
+    QTime mProgressTime;
+};
+
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+} // Tp
+
+#endif
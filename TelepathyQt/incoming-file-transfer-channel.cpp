@@ -32,8 +32,9 @@
 #include <TelepathyQt/Types>
 #include <TelepathyQt/types-internal.h>
 
+#include "TelepathyQt/file-transfer-worker-internal.h"
+
 #include <QIODevice>
-#include <QTcpSocket>
 
 namespace Tp
 {
@@ -49,20 +50,18 @@ struct TP_QT_NO_EXPORT IncomingFileTransferChannel::Private
     Client::ChannelTypeFileTransferInterface *fileTransferInterface;
 
     QIODevice *output;
-    QTcpSocket *socket;
     SocketAddressIPv4 addr;
 
     qulonglong requestedOffset;
-    qint64 pos;
+    FileTransferWorker *worker;
 };
 
 IncomingFileTransferChannel::Private::Private(IncomingFileTransferChannel *parent)
     : parent(parent),
       fileTransferInterface(parent->interface<Client::ChannelTypeFileTransferInterface>()),
       output(0),
-      socket(0),
       requestedOffset(0),
-      pos(0)
+      worker(0)
 {
     parent->connect(fileTransferInterface,
             SIGNAL(URIDefined(QString)),
@@ -74,6 +73,14 @@ IncomingFileTransferChannel::Private::Private(IncomingFileTransferChannel *paren
 
 IncomingFileTransferChannel::Private::~Private()
 {
+    if (worker) {
+        worker->stop();
+        if (worker->isThreaded()) {
+            worker->deleteLater();
+        } else {
+            delete worker;
+        }
+    }
 }
 
 /**
@@ -266,7 +273,7 @@ void IncomingFileTransferChannel::onAcceptFileFinished(PendingOperation *op)
 
     PendingVariant *pv = qobject_cast<PendingVariant *>(op);
     mPriv->addr = qdbus_cast<SocketAddressIPv4>(pv->result());
-    debug().nospace() << "Got address " << mPriv->addr.address <<
+    tpDebug().nospace() << "Got address " << mPriv->addr.address <<
         ":" << mPriv->addr.port;
 
     if (state() == FileTransferStateOpen) {
@@ -278,7 +285,7 @@ void IncomingFileTransferChannel::onAcceptFileFinished(PendingOperation *op)
 
 void IncomingFileTransferChannel::connectToHost()
 {
-    if (isConnected() || mPriv->addr.address.isNull()) {
+    if (mPriv->worker || mPriv->addr.address.isNull()) {
         return;
     }
 
@@ -295,61 +302,41 @@ void IncomingFileTransferChannel::connectToHost()
         return;
     }
 
-    mPriv->pos = initialOffset();
-
-    mPriv->socket = new QTcpSocket(this);
-
-    connect(mPriv->socket, SIGNAL(connected()),
-            SLOT(onSocketConnected()));
-    connect(mPriv->socket, SIGNAL(disconnected()),
-            SLOT(onSocketDisconnected()));
-    connect(mPriv->socket, SIGNAL(error(QAbstractSocket::SocketError)),
-            SLOT(onSocketError(QAbstractSocket::SocketError)));
-    connect(mPriv->socket, SIGNAL(readyRead()),
-            SLOT(doTransfer()));
+    mPriv->worker = new FileTransferWorker(FileTransferWorker::Receive, mPriv->output);
+    mPriv->worker->setOffset(initialOffset(), mPriv->requestedOffset);
+
+    connect(mPriv->worker, SIGNAL(connected()),
+            SLOT(onTransferConnected()));
+    connect(mPriv->worker, SIGNAL(finished()),
+            SLOT(onTransferFinished()));
+
+    if (isThreadedTransferEnabled()) {
+        if (FileTransferWorker::canRunInThread(mPriv->output)) {
+            connect(mPriv->worker, SIGNAL(progressChanged()),
+                    SLOT(onTransferProgress()));
+            mPriv->worker->moveToPool();
+        } else {
+            tpDebug() << "Output device can't be used from a worker thread, "
+                "receiving from the channel's thread";
+        }
+    }
 
-    debug().nospace() << "Connecting to host " <<
-        mPriv->addr.address << ":" << mPriv->addr.port << "...";
-    mPriv->socket->connectToHost(mPriv->addr.address, mPriv->addr.port);
+    mPriv->worker->connectToHost(mPriv->addr.address, mPriv->addr.port);
 }
 
-void IncomingFileTransferChannel::onSocketConnected()
+void IncomingFileTransferChannel::onTransferConnected()
 {
-    debug() << "Connected to host";
     setConnected();
-
-    doTransfer();
 }
 
-void IncomingFileTransferChannel::onSocketDisconnected()
+void IncomingFileTransferChannel::onTransferFinished()
 {
-    debug() << "Disconnected from host";
     setFinished();
 }
 
-void IncomingFileTransferChannel::onSocketError(QAbstractSocket::SocketError error)
+void IncomingFileTransferChannel::onTransferProgress()
 {
-    setFinished();
-}
-
-void IncomingFileTransferChannel::doTransfer()
-{
-    QByteArray data;
-    while (mPriv->socket->bytesAvailable()) {
-        data = mPriv->socket->readAll();
-
-        // skip until we reach requetedOffset and start writing from there
-        if ((qulonglong) mPriv->pos < mPriv->requestedOffset) {
-            if ((qulonglong) data.length() <= (mPriv->requestedOffset - mPriv->pos)) {
-                break;
-            }
-            data = data.mid(mPriv->requestedOffset - mPriv->pos);
-        }
-
-        mPriv->output->write(data); // never fails
-    }
-
-    mPriv->pos += data.length();
+    setTransferredBytes(mPriv->worker->takeProgress());
 }
 
 void IncomingFileTransferChannel::setFinished()
@@ -359,16 +346,9 @@ void IncomingFileTransferChannel::setFinished()
         return;
     }
 
-    if (mPriv->socket) {
-        disconnect(mPriv->socket, SIGNAL(connected()),
-                   this, SLOT(onSocketConnected()));
-        disconnect(mPriv->socket, SIGNAL(disconnected()),
-                   this, SLOT(onSocketDisconnected()));
-        disconnect(mPriv->socket, SIGNAL(error(QAbstractSocket::SocketError)),
-                   this, SLOT(onSocketError(QAbstractSocket::SocketError)));
-        disconnect(mPriv->socket, SIGNAL(readyRead()),
-                   this, SLOT(doTransfer()));
-        mPriv->socket->close();
+    if (mPriv->worker) {
+        // waits for the worker to be done with the output, so it can be closed
+        mPriv->worker->stop();
     }
 
     if (mPriv->output) {
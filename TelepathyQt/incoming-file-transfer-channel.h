@@ -62,10 +62,9 @@ protected:
 private Q_SLOTS:
     TP_QT_NO_EXPORT void onAcceptFileFinished(Tp::PendingOperation *op);
 
-    TP_QT_NO_EXPORT void onSocketConnected();
-    TP_QT_NO_EXPORT void onSocketDisconnected();
-    TP_QT_NO_EXPORT void onSocketError(QAbstractSocket::SocketError error);
-    TP_QT_NO_EXPORT void doTransfer();
+    TP_QT_NO_EXPORT void onTransferConnected();
+    TP_QT_NO_EXPORT void onTransferFinished();
+    TP_QT_NO_EXPORT void onTransferProgress();
 
 private:
     TP_QT_NO_EXPORT void connectToHost();
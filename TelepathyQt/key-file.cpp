@@ -22,19 +22,59 @@
 
 #include "TelepathyQt/key-file.h"
 
+#include "TelepathyQt/cache-file.h"
 #include "TelepathyQt/debug-internal.h"
 
 #include <TelepathyQt/Utils>
 
 #include <QtCore/QByteArray>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 
+#include <string.h>
+
 namespace Tp
 {
 
+namespace
+{
+
+// The position of a value in the file contents, unescaped only when it's asked for
+struct Slice
+{
+    Slice() : from(0), to(0) { }
+    Slice(int from, int to) : from(from), to(to) { }
+
+    int from;
+    int to;
+};
+
+typedef QHash<QString, Slice> Group;
+
+// Files which were already parsed by the process, as long as they don't change on disk.
+// The same .manager files end up being read over and over, for each ConnectionManager.
+struct KeyFileCache
+{
+    struct Entry
+    {
+        FileStamp stamp;
+        QByteArray contents;
+        QHash<QString, Group> groups;
+    };
+
+    QMutex lock;
+    QHash<QString, Entry> entries;
+};
+
+}
+
+Q_GLOBAL_STATIC(KeyFileCache, keyFileCache)
+
 struct TP_QT_NO_EXPORT KeyFile::Private
 {
     Private();
@@ -43,6 +83,7 @@ struct TP_QT_NO_EXPORT KeyFile::Private
     void setFileName(const QString &fName);
     void setError(KeyFile::Status status, const QString &reason);
     bool read();
+    bool parse();
 
     bool validateKey(const QByteArray &data, int from, int to, QString &result);
 
@@ -56,10 +97,16 @@ struct TP_QT_NO_EXPORT KeyFile::Private
 
     QString fileName;
     KeyFile::Status status;
-    QHash<QString, QHash<QString, QByteArray> > groups;
+    QByteArray contents;
+    QHash<QString, Group> groups;
     QString currentGroup;
 };
 
+static inline bool isSpace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r';
+}
+
 KeyFile::Private::Private()
     : status(KeyFile::None)
 {
@@ -77,6 +124,7 @@ void KeyFile::Private::setFileName(const QString &fName)
     fileName = fName;
     status = KeyFile::NoError;
     currentGroup = QString();
+    contents.clear();
     groups.clear();
     read();
 }
@@ -86,53 +134,101 @@ void KeyFile::Private::setError(KeyFile::Status st, const QString &reason)
     warning() << QString(QLatin1String("ERROR: filename(%1) reason(%2)"))
                          .arg(fileName).arg(reason);
     status = st;
+    contents.clear();
     groups.clear();
 }
 
 bool KeyFile::Private::read()
 {
-    QFile file(fileName);
-    if (!file.exists()) {
+    QFileInfo fileInfo(fileName);
+    if (!fileInfo.exists()) {
         setError(KeyFile::NotFoundError,
                  QLatin1String("file does not exist"));
         return false;
     }
 
+    QString key = fileInfo.absoluteFilePath();
+    FileStamp stamp = FileStamp::forFile(key);
+
+    KeyFileCache *cache = keyFileCache();
+    if (cache) {
+        QMutexLocker locker(&cache->lock);
+        QHash<QString, KeyFileCache::Entry>::const_iterator i = cache->entries.constFind(key);
+        if (i != cache->entries.constEnd() && stamp.isValid() && i->stamp == stamp) {
+            contents = i->contents;
+            groups = i->groups;
+            return true;
+        }
+    }
+
+    QFile file(fileName);
     if (!file.open(QFile::ReadOnly)) {
         setError(KeyFile::AccessError,
                  QLatin1String("cannot open file for readonly access"));
         return false;
     }
 
-    QByteArray data;
-    QByteArray group;
-    QString currentGroup;
-    QHash<QString, QByteArray> groupMap;
-    QByteArray rawValue;
+    contents = file.readAll();
+    file.close();
+
+    if (!parse()) {
+        return false;
+    }
+
+    if (cache) {
+        QMutexLocker locker(&cache->lock);
+        KeyFileCache::Entry &entry = cache->entries[key];
+        entry.stamp = stamp;
+        entry.contents = contents;
+        entry.groups = groups;
+    }
+
+    return true;
+}
+
+bool KeyFile::Private::parse()
+{
+    // Parse the whole file in one go, only remembering where the values are
+    const char *data = contents.constData();
+    int size = contents.size();
+    QString group;
+    Group groupMap;
     int line = 0;
-    int idx;
-    while (!file.atEnd()) {
-        data = file.readLine().trimmed();
+    int lineStart = 0;
+    while (lineStart < size) {
+        const char *newline = static_cast<const char *>(
+                memchr(data + lineStart, '\n', size - lineStart));
+        int lineEnd = newline ? newline - data : size;
+        int from = lineStart;
+        int to = lineEnd;
+        lineStart = lineEnd + 1;
         line++;
 
-        if (data.size() == 0) {
+        while (from < to && isSpace(data[from])) {
+            ++from;
+        }
+        while (to > from && isSpace(data[to - 1])) {
+            --to;
+        }
+
+        if (from == to) {
             // skip empty lines
             continue;
         }
 
-        char ch = data.at(0);
+        char ch = data[from];
         if (ch == '#') {
             // skip comments
             continue;
         }
         else if (ch == '[') {
             if (groupMap.size()) {
-                groups[currentGroup] = groupMap;
+                groups[group] = groupMap;
                 groupMap.clear();
             }
 
-            idx = data.indexOf(']');
-            if (idx == -1) {
+            const char *bracket = static_cast<const char *>(memchr(data + from, ']', to - from));
+            if (!bracket) {
                 // line starts with [ and it's not a group
                 setError(KeyFile::FormatError,
                          QString(QLatin1String("invalid group at line %2 - missing ']'"))
@@ -140,25 +236,33 @@ bool KeyFile::Private::read()
                 return false;
             }
 
-            group = data.mid(1, idx - 1).trimmed();
-            if (groups.contains(QLatin1String(group))) {
+            int groupFrom = from + 1;
+            int groupTo = bracket - data;
+            while (groupFrom < groupTo && isSpace(data[groupFrom])) {
+                ++groupFrom;
+            }
+            while (groupTo > groupFrom && isSpace(data[groupTo - 1])) {
+                --groupTo;
+            }
+
+            group = QLatin1String("");
+            if (!unescapeString(contents, groupFrom, groupTo, group)) {
                 setError(KeyFile::FormatError,
-                         QString(QLatin1String("duplicated group '%1' at line %2"))
-                                 .arg(QLatin1String(group)).arg(line));
+                         QString(QLatin1String("invalid group '%1' at line %2"))
+                                 .arg(group).arg(line));
                 return false;
             }
 
-            currentGroup = QLatin1String("");
-            if (!unescapeString(group, 0, group.size(), currentGroup)) {
+            if (groups.contains(group)) {
                 setError(KeyFile::FormatError,
-                         QString(QLatin1String("invalid group '%1' at line %2"))
-                                 .arg(currentGroup).arg(line));
+                         QString(QLatin1String("duplicated group '%1' at line %2"))
+                                 .arg(group).arg(line));
                 return false;
             }
         }
         else {
-            idx = data.indexOf('=');
-            if (idx == -1) {
+            const char *equals = static_cast<const char *>(memchr(data + from, '=', to - from));
+            if (!equals) {
                 setError(KeyFile::FormatError,
                          QString(QLatin1String("format error at line %1 - missing '='"))
                                  .arg(line));
@@ -166,14 +270,14 @@ bool KeyFile::Private::read()
             }
 
             // remove trailing spaces
-            char ch;
+            int idx = equals - data;
             int idxKeyEnd = idx;
-            while ((ch = data.at(idxKeyEnd - 1)) == ' ' || ch == '\t') {
+            while (idxKeyEnd > from && ((ch = data[idxKeyEnd - 1]) == ' ' || ch == '\t')) {
                 --idxKeyEnd;
             }
 
             QString key;
-            if (!validateKey(data, 0, idxKeyEnd, key)) {
+            if (!validateKey(contents, from, idxKeyEnd, key)) {
                 setError(KeyFile::FormatError,
                          QString(QLatin1String("invalid key '%1' at line %2"))
                                  .arg(key).arg(line));
@@ -183,18 +287,20 @@ bool KeyFile::Private::read()
             if (groupMap.contains(key)) {
                 setError(KeyFile::FormatError,
                          QString(QLatin1String("duplicated key '%1' on group '%2' at line %3"))
-                                 .arg(key).arg(currentGroup).arg(line));
+                                 .arg(key).arg(group).arg(line));
                 return false;
             }
 
-            data = data.mid(idx + 1).trimmed();
-            rawValue = data.mid(0, data.size());
-            groupMap[key] = rawValue;
+            int valueFrom = idx + 1;
+            while (valueFrom < to && isSpace(data[valueFrom])) {
+                ++valueFrom;
+            }
+            groupMap.insert(key, Slice(valueFrom, to));
         }
     }
 
     if (groupMap.size()) {
-        groups[currentGroup] = groupMap;
+        groups[group] = groupMap;
         groupMap.clear();
     }
 
@@ -232,7 +338,7 @@ QStringList KeyFile::Private::allGroups() const
 QStringList KeyFile::Private::allKeys() const
 {
     QStringList keys;
-    QHash<QString, QHash<QString, QByteArray> >::const_iterator itrGroups = groups.begin();
+    QHash<QString, Group>::const_iterator itrGroups = groups.begin();
     while (itrGroups != groups.end()) {
         keys << itrGroups.value().keys();
         ++itrGroups;
@@ -242,29 +348,26 @@ QStringList KeyFile::Private::allKeys() const
 
 QStringList KeyFile::Private::keys() const
 {
-    QHash<QString, QByteArray> groupMap = groups[currentGroup];
-    return groupMap.keys();
+    return groups.value(currentGroup).keys();
 }
 
 bool KeyFile::Private::contains(const QString &key) const
 {
-    QHash<QString, QByteArray> groupMap = groups[currentGroup];
-    return groupMap.contains(key);
+    QHash<QString, Group>::const_iterator i = groups.constFind(currentGroup);
+    return i != groups.constEnd() && i->contains(key);
 }
 
 QString KeyFile::Private::rawValue(const QString &key) const
 {
-    QHash<QString, QByteArray> groupMap = groups[currentGroup];
-    QByteArray rawValue = groupMap.value(key);
-    return QLatin1String(rawValue);
+    Slice slice = groups.value(currentGroup).value(key);
+    return QString::fromLatin1(contents.constData() + slice.from, slice.to - slice.from);
 }
 
 QString KeyFile::Private::value(const QString &key) const
 {
-    QHash<QString, QByteArray> groupMap = groups[currentGroup];
+    Slice slice = groups.value(currentGroup).value(key);
     QString result;
-    QByteArray rawValue = groupMap.value(key);
-    if (unescapeString(rawValue, 0, rawValue.size(), result)) {
+    if (unescapeString(contents, slice.from, slice.to, result)) {
         return result;
     }
     return QString();
@@ -272,10 +375,9 @@ QString KeyFile::Private::value(const QString &key) const
 
 QStringList KeyFile::Private::valueAsStringList(const QString &key) const
 {
-    QHash<QString, QByteArray> groupMap = groups[currentGroup];
+    Slice slice = groups.value(currentGroup).value(key);
     QStringList result;
-    QByteArray rawValue = groupMap.value(key);
-    if (unescapeStringList(rawValue, 0, rawValue.size(), result)) {
+    if (unescapeStringList(contents, slice.from, slice.to, result)) {
         return result;
     }
     return QStringList();
@@ -322,6 +424,7 @@ KeyFile::KeyFile(const KeyFile &other)
 {
     mPriv->fileName = other.mPriv->fileName;
     mPriv->status = other.mPriv->status;
+    mPriv->contents = other.mPriv->contents;
     mPriv->groups = other.mPriv->groups;
     mPriv->currentGroup = other.mPriv->currentGroup;
 }
@@ -338,6 +441,7 @@ KeyFile &KeyFile::operator=(const KeyFile &other)
 {
     mPriv->fileName = other.mPriv->fileName;
     mPriv->status = other.mPriv->status;
+    mPriv->contents = other.mPriv->contents;
     mPriv->groups = other.mPriv->groups;
     mPriv->currentGroup = other.mPriv->currentGroup;
     return *this;
@@ -492,6 +596,22 @@ QStringList KeyFile::valueAsStringList(const QString &key) const
     return mPriv->valueAsStringList(key);
 }
 
+/**
+ * Forget about all the files parsed so far, so that they are read again from disk even if they
+ * didn't change.
+ *
+ * Files are normally only parsed again when they change on disk. Note that ManagerFile keeps its
+ * own cache of parsed manager files on top of this one, see ManagerFile::clearCache().
+ */
+void KeyFile::clearCache()
+{
+    KeyFileCache *cache = keyFileCache();
+    if (cache) {
+        QMutexLocker locker(&cache->lock);
+        cache->entries.clear();
+    }
+}
+
 bool KeyFile::unescapeString(const QByteArray &data, int from, int to, QString &result)
 {
     int i = from;
@@ -71,6 +71,8 @@ public:
     QString value(const QString &key) const;
     QStringList valueAsStringList(const QString &key) const;
 
+    static void clearCache();
+
     static bool unescapeString(const QByteArray &data, int from, int to,
         QString &result);
     static bool unescapeStringList(const QByteArray &data, int from, int to,
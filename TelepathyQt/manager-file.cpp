@@ -22,14 +22,19 @@
 
 #include "TelepathyQt/manager-file.h"
 
+#include "TelepathyQt/cache-file.h"
+#include "TelepathyQt/connection-manager-cache.h"
 #include "TelepathyQt/debug-internal.h"
 #include "TelepathyQt/key-file.h"
 
 #include <TelepathyQt/Constants>
 #include <TelepathyQt/Utils>
 
-#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtDBus/QDBusVariant>
@@ -91,41 +96,64 @@ ManagerFile::Private::Private(const QString &cmName)
     init();
 }
 
-void ManagerFile::Private::init()
+namespace
 {
-    // TODO: should we cache the configDirs anywhere?
-    QStringList configDirs;
 
-    QString xdgDataHome = QString::fromLocal8Bit(qgetenv("XDG_DATA_HOME"));
-    if (xdgDataHome.isEmpty()) {
-        configDirs << QDir::homePath() + QLatin1String("/.local/share/data/telepathy/managers/");
-    }
-    else {
-        configDirs << xdgDataHome + QLatin1String("/telepathy/managers/");
-    }
+// Manager files which were already parsed by the process, as long as they don't change on disk
+struct ManagerFileCache
+{
+    struct Entry
+    {
+        FileStamp stamp;
+        ManagerFile managerFile;
+    };
 
-    QString xdgDataDirsEnv = QString::fromLocal8Bit(qgetenv("XDG_DATA_DIRS"));
-    if (xdgDataDirsEnv.isEmpty()) {
-        configDirs << QLatin1String("/usr/local/share/telepathy/managers/");
-        configDirs << QLatin1String("/usr/share/telepathy/managers/");
-    }
-    else {
-        QStringList xdgDataDirs = xdgDataDirsEnv.split(QLatin1Char(':'));
-        foreach (const QString xdgDataDir, xdgDataDirs) {
-            configDirs << xdgDataDir + QLatin1String("/telepathy/managers/");
-        }
-    }
+    QMutex lock;
+    QHash<QString, Entry> entries;
+};
+
+}
 
-    foreach (const QString configDir, configDirs) {
-        QString fileName = configDir + cmName + QLatin1String(".manager");
-        if (QFile::exists(fileName)) {
-            debug() << "parsing manager file" << fileName;
+Q_GLOBAL_STATIC(ManagerFileCache, managerFileCache)
+
+void ManagerFile::Private::init()
+{
+    foreach (const QString &fileName, ConnectionManagerCache::managerFileNames(cmName)) {
+        QFileInfo fileInfo(fileName);
+        if (fileInfo.exists()) {
+            QString key = fileInfo.absoluteFilePath();
+            FileStamp stamp = FileStamp::forFile(key);
+            ManagerFileCache *cache = managerFileCache();
+            if (cache) {
+                QMutexLocker locker(&cache->lock);
+                QHash<QString, ManagerFileCache::Entry>::const_iterator i =
+                    cache->entries.constFind(key);
+                if (i != cache->entries.constEnd() && stamp.isValid() && i->stamp == stamp) {
+                    tpDebug() << "using the already parsed manager file" << fileName;
+                    keyFile = i->managerFile.mPriv->keyFile;
+                    protocolsMap = i->managerFile.mPriv->protocolsMap;
+                    valid = true;
+                    return;
+                }
+            }
+
+            tpDebug() << "parsing manager file" << fileName;
             protocolsMap.clear();
             if (!parse(fileName)) {
                 warning() << "error parsing manager file" << fileName;
                 continue;
             }
             valid = true;
+
+            if (cache) {
+                QMutexLocker locker(&cache->lock);
+                ManagerFileCache::Entry &entry = cache->entries[key];
+                entry.stamp = stamp;
+                entry.managerFile.mPriv->cmName = cmName;
+                entry.managerFile.mPriv->keyFile = keyFile;
+                entry.managerFile.mPriv->protocolsMap = protocolsMap;
+                entry.managerFile.mPriv->valid = true;
+            }
             return;
         }
     }
@@ -558,4 +586,23 @@ AvatarSpec ManagerFile::avatarRequirements(const QString &protocol) const
     return mPriv->protocolsMap.value(protocol).avatarRequirements;
 }
 
+/**
+ * Forget about all the manager files parsed so far, so that they are read again from disk even if
+ * they didn't change.
+ *
+ * This also clears the underlying KeyFile cache.
+ *
+ * \sa KeyFile::clearCache()
+ */
+void ManagerFile::clearCache()
+{
+    ManagerFileCache *cache = managerFileCache();
+    if (cache) {
+        QMutexLocker locker(&cache->lock);
+        cache->entries.clear();
+    }
+
+    KeyFile::clearCache();
+}
+
 } // Tp
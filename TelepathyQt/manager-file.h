@@ -60,6 +60,8 @@ public:
     QStringList addressableVCardFields(const QString &protocol) const;
     QStringList addressableUriSchemes(const QString &protocol) const;
 
+    static void clearCache();
+
 private:
     struct Private;
     friend struct Private;
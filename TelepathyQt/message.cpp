@@ -393,7 +393,7 @@ QString Message::text() const
                 text += content.toString();
             } else {
                 // O RLY?
-                debug() << "allegedly text/plain part wasn't";
+                tpDebug() << "allegedly text/plain part wasn't";
             }
         }
     }
@@ -32,14 +32,13 @@
 #include <TelepathyQt/Types>
 #include <TelepathyQt/types-internal.h>
 
+#include "TelepathyQt/file-transfer-worker-internal.h"
+
 #include <QIODevice>
-#include <QTcpSocket>
 
 namespace Tp
 {
 
-static const int FT_BLOCK_SIZE = 16 * 1024;
-
 struct TP_QT_NO_EXPORT OutgoingFileTransferChannel::Private
 {
     Private(OutgoingFileTransferChannel *parent);
@@ -52,23 +51,29 @@ struct TP_QT_NO_EXPORT OutgoingFileTransferChannel::Private
 
     // Introspection
     QIODevice *input;
-    QTcpSocket *socket;
     SocketAddressIPv4 addr;
 
-    qint64 pos;
+    FileTransferWorker *worker;
 };
 
 OutgoingFileTransferChannel::Private::Private(OutgoingFileTransferChannel *parent)
     : parent(parent),
       fileTransferInterface(parent->interface<Client::ChannelTypeFileTransferInterface>()),
       input(0),
-      socket(0),
-      pos(0)
+      worker(0)
 {
 }
 
 OutgoingFileTransferChannel::Private::~Private()
 {
+    if (worker) {
+        worker->stop();
+        if (worker->isThreaded()) {
+            worker->deleteLater();
+        } else {
+            delete worker;
+        }
+    }
 }
 
 /**
@@ -216,7 +221,7 @@ void OutgoingFileTransferChannel::onProvideFileFinished(PendingOperation *op)
 
     PendingVariant *pv = qobject_cast<PendingVariant *>(op);
     mPriv->addr = qdbus_cast<SocketAddressIPv4>(pv->result());
-    debug().nospace() << "Got address " << mPriv->addr.address <<
+    tpDebug().nospace() << "Got address " << mPriv->addr.address <<
         ":" << mPriv->addr.port;
 
     if (state() == FileTransferStateOpen) {
@@ -226,118 +231,59 @@ void OutgoingFileTransferChannel::onProvideFileFinished(PendingOperation *op)
 
 void OutgoingFileTransferChannel::connectToHost()
 {
-    if (isConnected() || mPriv->addr.address.isNull()) {
+    if (mPriv->worker || mPriv->addr.address.isNull()) {
         return;
     }
 
-    mPriv->socket = new QTcpSocket(this);
-
-    connect(mPriv->socket, SIGNAL(connected()),
-            SLOT(onSocketConnected()));
-    connect(mPriv->socket, SIGNAL(disconnected()),
-            SLOT(onSocketDisconnected()));
-    connect(mPriv->socket, SIGNAL(error(QAbstractSocket::SocketError)),
-            SLOT(onSocketError(QAbstractSocket::SocketError)));
-    connect(mPriv->socket, SIGNAL(bytesWritten(qint64)),
-            SLOT(doTransfer()));
+    mPriv->worker = new FileTransferWorker(FileTransferWorker::Send, mPriv->input);
+    mPriv->worker->setOffset(initialOffset(), initialOffset());
+
+    connect(mPriv->worker, SIGNAL(connected()),
+            SLOT(onTransferConnected()));
+    connect(mPriv->worker, SIGNAL(finished()),
+            SLOT(onTransferFinished()));
+
+    if (isThreadedTransferEnabled()) {
+        if (FileTransferWorker::canRunInThread(mPriv->input)) {
+            connect(mPriv->worker, SIGNAL(progressChanged()),
+                    SLOT(onTransferProgress()));
+            mPriv->worker->moveToPool();
+        } else {
+            tpDebug() << "Input device can't be used from a worker thread, "
+                "sending from the channel's thread";
+        }
+    }
 
-    debug().nospace() << "Connecting to host " <<
-        mPriv->addr.address << ":" << mPriv->addr.port << "...";
-    mPriv->socket->connectToHost(mPriv->addr.address, mPriv->addr.port);
+    mPriv->worker->connectToHost(mPriv->addr.address, mPriv->addr.port);
 }
 
-void OutgoingFileTransferChannel::onSocketConnected()
+void OutgoingFileTransferChannel::onTransferConnected()
 {
-    debug() << "Connected to host";
     setConnected();
-
-    connect(mPriv->input, SIGNAL(readyRead()),
-            SLOT(doTransfer()));
-
-    // for non sequential devices, let's seek to the initialOffset
-    if (!mPriv->input->isSequential()) {
-        if (mPriv->input->seek(initialOffset())) {
-            mPriv->pos = initialOffset();
-        }
-    }
-
-    debug() << "Starting transfer...";
-    doTransfer();
 }
 
-void OutgoingFileTransferChannel::onSocketDisconnected()
+void OutgoingFileTransferChannel::onTransferFinished()
 {
-    debug() << "Disconnected from host";
     setFinished();
 }
 
-void OutgoingFileTransferChannel::onSocketError(QAbstractSocket::SocketError error)
+void OutgoingFileTransferChannel::onTransferProgress()
 {
-    debug() << "Socket error" << error;
-    setFinished();
+    setTransferredBytes(mPriv->worker->takeProgress());
 }
 
 void OutgoingFileTransferChannel::onInputAboutToClose()
 {
-    debug() << "Input closed";
+    tpDebug() << "Input closed";
 
     // read all remaining data from input device and write to output device
-    if (isConnected()) {
-        QByteArray data;
-        data = mPriv->input->readAll();
-        mPriv->socket->write(data); // never fails
+    if (mPriv->worker) {
+        mPriv->worker->finishInput();
     }
 
     setFinished();
 }
 
-void OutgoingFileTransferChannel::doTransfer()
-{
-    // read FT_BLOCK_SIZE each time, as input can be a QFile, we don't want to
-    // block reading the whole file
-    char buffer[FT_BLOCK_SIZE];
-    char *p = buffer;
-
-    memset(buffer, 0, sizeof(buffer));
-    qint64 len = mPriv->input->read(buffer, sizeof(buffer));
-
-    bool scheduleTransfer = false;
-    if (((qulonglong) mPriv->pos < initialOffset()) && (len > 0)) {
-        qint64 skip = (qint64) qMin(initialOffset() - mPriv->pos,
-                (qulonglong) len);
-
-        debug() << "skipping" << skip << "bytes";
-        if (skip == len) {
-            // nothing to write, all data read was skipped
-            // schedule a transfer, as readyRead may never be called and
-            // bytesWriiten will not
-            scheduleTransfer = true;
-            goto end;
-        }
-
-        p += skip;
-        len -= skip;
-    }
-
-    if (len > 0) {
-        mPriv->socket->write(p, len); // never fails
-    }
-
-end:
-    if (len == -1 || (!mPriv->input->isSequential() && mPriv->input->atEnd())) {
-        // error or EOF
-        setFinished();
-        return;
-    }
-
-    mPriv->pos += len;
-
-    if (scheduleTransfer) {
-        QMetaObject::invokeMethod(this, SLOT(doTransfer()),
-                Qt::QueuedConnection);
-    }
-}
-
 void OutgoingFileTransferChannel::setFinished()
 {
     if (isFinished()) {
@@ -345,23 +291,14 @@ void OutgoingFileTransferChannel::setFinished()
         return;
     }
 
-    if (mPriv->socket) {
-        disconnect(mPriv->socket, SIGNAL(connected()),
-                   this, SLOT(onSocketConnected()));
-        disconnect(mPriv->socket, SIGNAL(disconnected()),
-                   this, SLOT(onSocketDisconnected()));
-        disconnect(mPriv->socket, SIGNAL(error(QAbstractSocket::SocketError)),
-                   this, SLOT(onSocketError(QAbstractSocket::SocketError)));
-        disconnect(mPriv->socket, SIGNAL(bytesWritten(qint64)),
-                   this, SLOT(doTransfer()));
-        mPriv->socket->close();
+    if (mPriv->worker) {
+        // waits for the worker to be done with the input, so it can be closed
+        mPriv->worker->stop();
     }
 
     if (mPriv->input) {
         disconnect(mPriv->input, SIGNAL(aboutToClose()),
                    this, SLOT(onInputAboutToClose()));
-        disconnect(mPriv->input, SIGNAL(readyRead()),
-                   this, SLOT(doTransfer()));
         mPriv->input->close();
     }
 
@@ -58,11 +58,10 @@ protected:
 private Q_SLOTS:
     TP_QT_NO_EXPORT void onProvideFileFinished(Tp::PendingOperation *op);
 
-    TP_QT_NO_EXPORT void onSocketConnected();
-    TP_QT_NO_EXPORT void onSocketDisconnected();
-    TP_QT_NO_EXPORT void onSocketError(QAbstractSocket::SocketError error);
+    TP_QT_NO_EXPORT void onTransferConnected();
+    TP_QT_NO_EXPORT void onTransferFinished();
+    TP_QT_NO_EXPORT void onTransferProgress();
     TP_QT_NO_EXPORT void onInputAboutToClose();
-    TP_QT_NO_EXPORT void doTransfer();
 
 private:
     TP_QT_NO_EXPORT void connectToHost();
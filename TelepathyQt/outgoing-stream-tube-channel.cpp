@@ -58,7 +58,7 @@ PendingOpenTube::PendingOpenTube(
 
     // FIXME: connect to channel invalidation here also
 
-    debug() << "Calling StreamTube.Offer";
+    tpDebug() << "Calling StreamTube.Offer";
     if (offerOperation->isFinished()) {
         onOfferFinished(offerOperation);
     } else {
@@ -82,11 +82,11 @@ void PendingOpenTube::onOfferFinished(PendingOperation *op)
         return;
     }
 
-    debug() << "StreamTube.Offer returned successfully";
+    tpDebug() << "StreamTube.Offer returned successfully";
 
     // It might have been already opened - check
     if (mPriv->tube->state() != TubeChannelStateOpen) {
-        debug() << "Awaiting tube to be opened";
+        tpDebug() << "Awaiting tube to be opened";
         // Wait until the tube gets opened on the other side
         connect(mPriv->tube.data(),
                 SIGNAL(stateChanged(Tp::TubeChannelState)),
@@ -99,7 +99,7 @@ void PendingOpenTube::onOfferFinished(PendingOperation *op)
 void PendingOpenTube::onTubeStateChanged(TubeChannelState state)
 {
     if (state == TubeChannelStateOpen) {
-        debug() << "Tube is now opened";
+        tpDebug() << "Tube is now opened";
         // Inject the parameters into the tube
         mPriv->tube->setParameters(mPriv->parameters);
         // The tube is ready: let's notify
@@ -111,7 +111,7 @@ void PendingOpenTube::onTubeStateChanged(TubeChannelState state)
             setFinishedWithError(TP_QT_ERROR_CONNECTION_REFUSED,
                     QLatin1String("The connection to this tube was refused"));
         } else {
-            debug() << "Awaiting remote to accept the tube";
+            tpDebug() << "Awaiting remote to accept the tube";
         }
     }
 }
@@ -734,7 +734,7 @@ void OutgoingStreamTubeChannel::onContactsRetrieved(
         const QList<Tp::ContactPtr> &contacts)
 {
     if (!isValid()) {
-        debug() << "Invalidated OutgoingStreamTubeChannel not emitting queued connection event";
+        tpDebug() << "Invalidated OutgoingStreamTubeChannel not emitting queued connection event";
         return;
     }
 
@@ -126,7 +126,7 @@ void PendingAccount::onCallFinished(QDBusPendingCallWatcher *watcher)
     if (!reply.isError()) {
         QString objectPath = reply.value().path();
 
-        debug() << "Got reply to AccountManager.CreateAccount - object path:" << objectPath;
+        tpDebug() << "Got reply to AccountManager.CreateAccount - object path:" << objectPath;
 
         PendingReady *readyOp = manager()->accountFactory()->proxy(manager()->busName(),
                 objectPath, manager()->connectionFactory(),
@@ -136,7 +136,7 @@ void PendingAccount::onCallFinished(QDBusPendingCallWatcher *watcher)
                 SIGNAL(finished(Tp::PendingOperation*)),
                 SLOT(onAccountBuilt(Tp::PendingOperation*)));
     } else {
-        debug().nospace() <<
+        tpDebug().nospace() <<
             "CreateAccount failed: " <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
@@ -160,7 +160,7 @@ void PendingAccount::onAccountBuilt(Tp::PendingOperation *op)
 
         if (manager()->allAccounts().contains(mPriv->account)) {
             setFinished();
-            debug() << "New account" << mPriv->account->objectPath() << "built";
+            tpDebug() << "New account" << mPriv->account->objectPath() << "built";
         } else {
             // Have to wait for the AM to pick up the change and signal it so the world can be
             // assumed to be ~round when we finish
@@ -177,7 +177,7 @@ void PendingAccount::onNewAccount(const AccountPtr &account)
         return;
     }
 
-    debug() << "Account" << account->objectPath() << "added to AM, finishing PendingAccount";
+    tpDebug() << "Account" << account->objectPath() << "added to AM, finishing PendingAccount";
     setFinished();
 }
 
@@ -180,14 +180,14 @@ void PendingCaptchas::onGetCaptchasWatcherFinished(QDBusPendingCallWatcher *watc
     QDBusPendingReply<Tp::CaptchaInfoList, uint, QString> reply = *watcher;
 
     if (reply.isError()) {
-        debug().nospace() << "PendingDBusCall failed: " <<
+        tpDebug().nospace() << "PendingDBusCall failed: " <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
         watcher->deleteLater();
         return;
     }
 
-    debug() << "Got reply to PendingDBusCall";
+    tpDebug() << "Got reply to PendingDBusCall";
     Tp::CaptchaInfoList list = qdbus_cast<Tp::CaptchaInfoList>(reply.argumentAt(0));
     int howManyRequired = reply.argumentAt(1).toUInt();
 
@@ -289,14 +289,14 @@ void PendingCaptchas::onGetCaptchaDataWatcherFinished(QDBusPendingCallWatcher *w
     QDBusPendingReply<QByteArray> reply = *watcher;
 
     if (reply.isError()) {
-        debug().nospace() << "PendingDBusCall failed: " <<
+        tpDebug().nospace() << "PendingDBusCall failed: " <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
         watcher->deleteLater();
         return;
     }
 
-    debug() << "Got reply to PendingDBusCall";
+    tpDebug() << "Got reply to PendingDBusCall";
 
     // Add to the list
     mPriv->appendCaptchaResult(watcher->property("__Tp_Qt_CaptchaMimeType").toString(),
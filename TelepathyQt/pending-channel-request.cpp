@@ -224,7 +224,7 @@ void PendingChannelRequest::onWatcherFinished(QDBusPendingCallWatcher *watcher)
 
     if (!reply.isError()) {
         QDBusObjectPath objectPath = reply.argumentAt<0>();
-        debug() << "Got reply to ChannelDispatcher.Ensure/CreateChannel "
+        tpDebug() << "Got reply to ChannelDispatcher.Ensure/CreateChannel "
             "- object path:" << objectPath.path();
 
         if (!account().isNull()) {
@@ -249,7 +249,7 @@ void PendingChannelRequest::onWatcherFinished(QDBusPendingCallWatcher *watcher)
                     SLOT(onProceedOperationFinished(Tp::PendingOperation*)));
         }
     } else {
-        debug().nospace() << "Ensure/CreateChannel failed:" <<
+        tpDebug().nospace() << "Ensure/CreateChannel failed:" <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
     }
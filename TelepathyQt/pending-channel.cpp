@@ -211,7 +211,7 @@ PendingChannel::PendingChannel(const AccountPtr &account,
 
     handlerName = QString(QLatin1String("org.freedesktop.Telepathy.Client.%1")).arg(handlerName);
 
-    debug() << "Requesting channel through account using handler" << handlerName;
+    tpDebug() << "Requesting channel through account using handler" << handlerName;
     PendingChannelRequest *pcr;
     if (create) {
         pcr = account->createChannel(request, userActionTime, handlerName, ChannelRequestHints());
@@ -345,7 +345,7 @@ QVariantMap PendingChannel::immutableProperties() const
     // This is a reasonable guess - if it's Yours it's guaranteedly Requested by us, and if it's not
     // it could be either Requested by somebody else but also an incoming channel just as well.
     if (!props.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".Requested"))) {
-        debug() << "CM didn't provide Requested in channel immutable props, guessing"
+        tpDebug() << "CM didn't provide Requested in channel immutable props, guessing"
             << mPriv->yours;
         props[TP_QT_IFACE_CHANNEL + QLatin1String(".Requested")] =
             mPriv->yours;
@@ -356,7 +356,7 @@ QVariantMap PendingChannel::immutableProperties() const
     if (!props.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorHandle"))) {
         if (qdbus_cast<bool>(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".Requested")))) {
             if (connection() && connection()->isReady(Connection::FeatureCore)) {
-                debug() << "CM didn't provide InitiatorHandle in channel immutable props, but we "
+                tpDebug() << "CM didn't provide InitiatorHandle in channel immutable props, but we "
                     "know it's the conn's self handle (and have it)";
                 props[TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorHandle")] =
                     connection()->selfHandle();
@@ -415,7 +415,7 @@ void PendingChannel::onConnectionCreateChannelFinished(QDBusPendingCallWatcher *
         QString objectPath = reply.argumentAt<0>().path();
         QVariantMap map = reply.argumentAt<1>();
 
-        debug() << "Got reply to Connection.CreateChannel - object path:" << objectPath;
+        tpDebug() << "Got reply to Connection.CreateChannel - object path:" << objectPath;
 
         PendingReady *channelReady =
             connection()->channelFactory()->proxy(connection(), objectPath, map);
@@ -430,7 +430,7 @@ void PendingChannel::onConnectionCreateChannelFinished(QDBusPendingCallWatcher *
                 SIGNAL(finished(Tp::PendingOperation*)),
                 SLOT(onChannelReady(Tp::PendingOperation*)));
     } else {
-        debug().nospace() << "CreateChannel failed:" <<
+        tpDebug().nospace() << "CreateChannel failed:" <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
     }
@@ -447,7 +447,7 @@ void PendingChannel::onConnectionEnsureChannelFinished(QDBusPendingCallWatcher *
         QString objectPath = reply.argumentAt<1>().path();
         QVariantMap map = reply.argumentAt<2>();
 
-        debug() << "Got reply to Connection.EnsureChannel - object path:" << objectPath;
+        tpDebug() << "Got reply to Connection.EnsureChannel - object path:" << objectPath;
 
         PendingReady *channelReady =
             connection()->channelFactory()->proxy(connection(), objectPath, map);
@@ -462,7 +462,7 @@ void PendingChannel::onConnectionEnsureChannelFinished(QDBusPendingCallWatcher *
                 SIGNAL(finished(Tp::PendingOperation*)),
                 SLOT(onChannelReady(Tp::PendingOperation*)));
     } else {
-        debug().nospace() << "EnsureChannel failed:" <<
+        tpDebug().nospace() << "EnsureChannel failed:" <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
     }
@@ -475,7 +475,7 @@ void PendingChannel::onChannelReady(PendingOperation *op)
     if (!op->isError()) {
         setFinished();
     } else {
-        debug() << "Making the channel ready for" << this << "failed with" << op->errorName()
+        tpDebug() << "Making the channel ready for" << this << "failed with" << op->errorName()
             << ":" << op->errorMessage();
         setFinishedWithError(op->errorName(), op->errorMessage());
     }
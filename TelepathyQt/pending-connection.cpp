@@ -135,7 +135,7 @@ void PendingConnection::onCallFinished(QDBusPendingCallWatcher *watcher)
         QString busName = reply.argumentAt<0>();
         QString objectPath = reply.argumentAt<1>().path();
 
-        debug() << "Got reply to ConnectionManager.CreateConnection - bus name:" <<
+        tpDebug() << "Got reply to ConnectionManager.CreateConnection - bus name:" <<
             busName << "- object path:" << objectPath;
 
         PendingReady *readyOp = manager()->connectionFactory()->proxy(busName,
@@ -145,7 +145,7 @@ void PendingConnection::onCallFinished(QDBusPendingCallWatcher *watcher)
                 SIGNAL(finished(Tp::PendingOperation*)),
                 SLOT(onConnectionBuilt(Tp::PendingOperation*)));
     } else {
-        debug().nospace() <<
+        tpDebug().nospace() <<
             "CreateConnection failed: " <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
@@ -164,7 +164,7 @@ void PendingConnection::onConnectionBuilt(Tp::PendingOperation *op)
         setFinishedWithError(op->errorName(), op->errorMessage());
     } else {
         setFinished();
-        debug() << "New connection" << mPriv->connection->objectPath() << "built";
+        tpDebug() << "New connection" << mPriv->connection->objectPath() << "built";
     }
 }
 
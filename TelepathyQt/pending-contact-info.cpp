@@ -113,10 +113,10 @@ void PendingContactInfo::onCallFinished(QDBusPendingCallWatcher *watcher)
 
     if (!reply.isError()) {
         mPriv->info = Contact::InfoFields(reply.value());
-        debug() << "Got reply to ContactInfo.RequestContactInfo";
+        tpDebug() << "Got reply to ContactInfo.RequestContactInfo";
         setFinished();
     } else {
-        debug().nospace() <<
+        tpDebug().nospace() <<
             "ContactInfo.RequestContactInfo failed: " <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
@@ -196,13 +196,9 @@ PendingContacts::PendingContacts(const ContactManagerPtr &manager,
     if (!otherContacts.isEmpty()) {
         ConnectionPtr conn = manager->connection();
         if (conn->interfaces().contains(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS)) {
-            PendingContactAttributes *attributes =
-                conn->lowlevel()->contactAttributes(otherContacts.toList(),
-                        interfaces, true);
-
-            connect(attributes,
-                    SIGNAL(finished(Tp::PendingOperation*)),
-                    SLOT(onAttributesFinished(Tp::PendingOperation*)));
+            // The call may be shared with other requests made around the same time, in which
+            // case the reply will contain more handles and attributes than we asked for
+            manager->requestContactAttributes(this, otherContacts.toList(), interfaces);
         } else {
             // fallback to just create the contacts
             PendingHandles *handles = conn->lowlevel()->referenceHandles(HandleTypeContact,
@@ -485,7 +481,7 @@ void PendingContacts::onAttributesFinished(PendingOperation *operation)
         qobject_cast<PendingContactAttributes *>(operation);
 
     if (pendingAttributes->isError()) {
-        debug() << "PendingAttrs error" << pendingAttributes->errorName()
+        tpDebug() << "PendingAttrs error" << pendingAttributes->errorName()
                 << "message" << pendingAttributes->errorMessage();
         setFinishedWithError(pendingAttributes->errorName(), pendingAttributes->errorMessage());
         return;
@@ -519,7 +515,7 @@ void PendingContacts::onRequestHandlesFinished(PendingOperation *operation)
     mPriv->invalidIds = pendingHandles->invalidNames();
 
     if (pendingHandles->isError()) {
-        debug() << "RequestHandles error" << operation->errorName()
+        tpDebug() << "RequestHandles error" << operation->errorName()
                 << "message" << operation->errorMessage();
         setFinishedWithError(operation->errorName(), operation->errorMessage());
         return;
@@ -567,7 +563,7 @@ void PendingContacts::onReferenceHandlesFinished(PendingOperation *operation)
     PendingHandles *pendingHandles = qobject_cast<PendingHandles *>(operation);
 
     if (pendingHandles->isError()) {
-        debug() << "ReferenceHandles error" << operation->errorName()
+        tpDebug() << "ReferenceHandles error" << operation->errorName()
                 << "message" << operation->errorMessage();
         setFinishedWithError(operation->errorName(), operation->errorMessage());
         return;
@@ -604,7 +600,7 @@ void PendingContacts::onNestedFinished(PendingOperation *operation)
     Q_ASSERT(operation == mPriv->nested);
 
     if (operation->isError()) {
-        debug() << " error" << operation->errorName()
+        tpDebug() << " error" << operation->errorName()
                 << "message" << operation->errorMessage();
         setFinishedWithError(operation->errorName(), operation->errorMessage());
         return;
@@ -620,7 +616,7 @@ void PendingContacts::onInspectHandlesFinished(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<QStringList> reply = *watcher;
 
     if (reply.isError()) {
-        debug().nospace() << "InspectHandles: error " << reply.error().name() << ": "
+        tpDebug().nospace() << "InspectHandles: error " << reply.error().name() << ": "
             << reply.error().message();
         setFinishedWithError(reply.error());
         return;
@@ -712,7 +708,7 @@ void PendingAddressingGetContacts::onGetContactsFinished(QDBusPendingCallWatcher
         mAttributes = reply.argumentAt<1>();
         setFinished();
     } else {
-        debug().nospace() << "GetContactsBy* failed: " <<
+        tpDebug().nospace() << "GetContactsBy* failed: " <<
             reply.error().name() << ": " << reply.error().message();
         setFinishedWithError(reply.error());
     }
@@ -49,6 +49,9 @@ struct TP_QT_NO_EXPORT PendingHandles::Private
     QHash<QDBusPendingCallWatcher *, QString> idsForWatchers;
     QHash<QString, uint> handlesForIds;
     int requestsFinished;
+
+    // whether the HoldHandles call was batched with the ones of other requests
+    bool sharedHold;
 };
 
 /**
@@ -70,7 +73,7 @@ PendingHandles::PendingHandles(const ConnectionPtr &connection, HandleType handl
     : PendingOperation(connection),
       mPriv(new Private)
 {
-    debug() << "PendingHandles(request)";
+    tpDebug() << "PendingHandles(request)";
 
     mPriv->handleType = handleType;
     mPriv->isRequest = true;
@@ -93,28 +96,24 @@ PendingHandles::PendingHandles(const ConnectionPtr &connection, HandleType handl
     : PendingOperation(connection),
       mPriv(new Private)
 {
-    debug() << "PendingHandles(reference)";
+    tpDebug() << "PendingHandles(reference)";
 
     mPriv->handleType = handleType;
     mPriv->isRequest = false;
     mPriv->handlesToReference = handles;
     mPriv->alreadyHeld = ReferencedHandles(connection, mPriv->handleType, alreadyHeld);
     mPriv->requestsFinished = 0;
+    mPriv->sharedHold = false;
 
     if (notYetHeld.isEmpty()) {
-        debug() << " All handles already held, finishing up instantly";
+        tpDebug() << " All handles already held, finishing up instantly";
         mPriv->handles = mPriv->alreadyHeld;
         setFinished();
     } else {
-        debug() << " Calling HoldHandles";
-
-        QDBusPendingCallWatcher *watcher =
-            new QDBusPendingCallWatcher(
-                    connection->baseInterface()->HoldHandles(mPriv->handleType, notYetHeld),
-                    this);
-        connect(watcher,
-                SIGNAL(finished(QDBusPendingCallWatcher*)),
-                SLOT(onHoldHandlesFinished(QDBusPendingCallWatcher*)));
+        // The connection makes a single HoldHandles call for all the references requested during
+        // this mainloop iteration
+        tpDebug() << " Queueing HoldHandles";
+        connection->holdHandles(mPriv->handleType, notYetHeld, this);
     }
 }
 
@@ -124,6 +123,14 @@ PendingHandles::PendingHandles(const QString &errorName, const QString &errorMes
     setFinishedWithError(errorName, errorMessage);
 }
 
+void PendingHandles::holdHandlesCalled(QDBusPendingCallWatcher *watcher, bool shared)
+{
+    mPriv->sharedHold = shared;
+    connect(watcher,
+            SIGNAL(finished(QDBusPendingCallWatcher*)),
+            SLOT(onHoldHandlesFinished(QDBusPendingCallWatcher*)));
+}
+
 /**
  * Class destructor.
  */
@@ -279,7 +286,7 @@ void PendingHandles::onRequestHandlesFinished(QDBusPendingCallWatcher *watcher)
         }
 
         if (mPriv->namesRequested.size() == 1) {
-            debug().nospace() << " Failure: error " <<
+            tpDebug().nospace() << " Failure: error " <<
                 reply.error().name() << ": " <<
                 reply.error().message();
 
@@ -306,7 +313,7 @@ void PendingHandles::onRequestHandlesFinished(QDBusPendingCallWatcher *watcher)
             mPriv->idsForWatchers.insert(watcher, name);
         }
     } else {
-        debug() << "Received reply to RequestHandles";
+        tpDebug() << "Received reply to RequestHandles";
         mPriv->handles = ReferencedHandles(connection(),
                 mPriv->handleType, reply.value());
         mPriv->validNames.append(mPriv->namesRequested);
@@ -319,10 +326,10 @@ void PendingHandles::onHoldHandlesFinished(QDBusPendingCallWatcher *watcher)
 {
     QDBusPendingReply<void> reply = *watcher;
 
-    debug() << "Received reply to HoldHandles";
+    tpDebug() << "Received reply to HoldHandles";
 
     if (reply.isError()) {
-        debug().nospace() << " Failure: error " <<
+        tpDebug().nospace() << " Failure: error " <<
             reply.error().name() << ": " <<
             reply.error().message();
 
@@ -333,18 +340,18 @@ void PendingHandles::onHoldHandlesFinished(QDBusPendingCallWatcher *watcher)
             // do not fallback
             mPriv->invalidHandles = mPriv->handlesToReference;
             setFinishedWithError(error);
-            watcher->deleteLater();
             return;
         }
 
-        if (mPriv->handlesToReference.size() == 1) {
-            debug().nospace() << " Failure: error " <<
+        // If the call was shared with other requests, the handle which made it fail might not be
+        // ours, so only conclude ours is invalid if we were alone
+        if (mPriv->handlesToReference.size() == 1 && !mPriv->sharedHold) {
+            tpDebug().nospace() << " Failure: error " <<
                 reply.error().name() << ": " <<
                 reply.error().message();
 
             mPriv->invalidHandles = mPriv->handlesToReference;
             setFinished();
-            watcher->deleteLater();
             return;
         }
 
@@ -367,7 +374,7 @@ void PendingHandles::onHoldHandlesFinished(QDBusPendingCallWatcher *watcher)
         setFinished();
     }
 
-    watcher->deleteLater();
+    // the watcher is shared with the other requests in the batch and deleted by the connection
 }
 
 void PendingHandles::onRequestHandlesFallbackFinished(QDBusPendingCallWatcher *watcher)
@@ -377,10 +384,10 @@ void PendingHandles::onRequestHandlesFallbackFinished(QDBusPendingCallWatcher *w
     Q_ASSERT(mPriv->idsForWatchers.contains(watcher));
     QString id = mPriv->idsForWatchers.value(watcher);
 
-    debug() << "Received reply to RequestHandles(" << id << ")";
+    tpDebug() << "Received reply to RequestHandles(" << id << ")";
 
     if (reply.isError()) {
-        debug().nospace() << " Failure: error " << reply.error().name() << ": "
+        tpDebug().nospace() << " Failure: error " << reply.error().name() << ": "
             << reply.error().message();
 
         // if the error is disconnected for example, fail immediately
@@ -430,9 +437,9 @@ void PendingHandles::onRequestHandlesFallbackFinished(QDBusPendingCallWatcher *w
             setFinished();
         }
 
-        debug() << " namesRequested:" << mPriv->namesRequested;
-        debug() << " invalidNames  :" << mPriv->invalidNames;
-        debug() << " validNames    :" << mPriv->validNames;
+        tpDebug() << " namesRequested:" << mPriv->namesRequested;
+        tpDebug() << " invalidNames  :" << mPriv->invalidNames;
+        tpDebug() << " validNames    :" << mPriv->validNames;
 
         connection()->handleRequestLanded(mPriv->handleType);
     }
@@ -447,10 +454,10 @@ void PendingHandles::onHoldHandlesFallbackFinished(QDBusPendingCallWatcher *watc
     Q_ASSERT(mPriv->handlesForWatchers.contains(watcher));
     uint handle = mPriv->handlesForWatchers.value(watcher);
 
-    debug() << "Received reply to HoldHandles(" << handle << ")";
+    tpDebug() << "Received reply to HoldHandles(" << handle << ")";
 
     if (reply.isError()) {
-        debug().nospace() << " Failure: error " << reply.error().name() << ": "
+        tpDebug().nospace() << " Failure: error " << reply.error().name() << ": "
             << reply.error().message();
 
         // if the error is disconnected for example, fail immediately
@@ -467,7 +474,7 @@ void PendingHandles::onHoldHandlesFallbackFinished(QDBusPendingCallWatcher *watc
         mPriv->invalidHandles.append(handle);
     }
 
-    if (++mPriv->requestsFinished == mPriv->namesRequested.size()) {
+    if (++mPriv->requestsFinished == mPriv->handlesToReference.size()) {
         // we need to return the handles in the same order as requested
         UIntList handles;
         foreach (uint handle, mPriv->handlesToReference) {
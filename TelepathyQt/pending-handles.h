@@ -78,6 +78,7 @@ private Q_SLOTS:
     TP_QT_NO_EXPORT void onHoldHandlesFallbackFinished(QDBusPendingCallWatcher *watcher);
 
 private:
+    friend class Connection;
     friend class ConnectionLowlevel;
 
     TP_QT_NO_EXPORT PendingHandles(const ConnectionPtr &connection, HandleType handleType,
@@ -86,6 +87,8 @@ private:
             const UIntList &handles, const UIntList &alreadyHeld, const UIntList &notYetHeld);
     TP_QT_NO_EXPORT PendingHandles(const QString &errorName, const QString &errorMessage);
 
+    TP_QT_NO_EXPORT void holdHandlesCalled(QDBusPendingCallWatcher *watcher, bool shared);
+
     struct Private;
     friend struct Private;
     Private *mPriv;
@@ -0,0 +1,313 @@
+/**
+ * This file is part of TelepathyQt
+ *
+ * @copyright Copyright (C) 2012 Collabora Ltd. <http://www.collabora.co.uk/>
+ * @license LGPL 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TelepathyQt/profile-cache.h"
+
+#include "TelepathyQt/cache-file.h"
+#include "TelepathyQt/debug-internal.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QPair>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+namespace Tp
+{
+
+// The compiled profiles are kept in a single file, starting with a magic number and a format
+// version, followed by the search directories and profile files the profiles were loaded from with
+// their stamps, and the profiles themselves, in search order
+static const quint32 cacheMagic = 0x54505052; // "TPPR"
+static const quint32 cacheVersion = 2;
+
+typedef QList<QPair<QString, FileStamp> > Stamp;
+
+namespace
+{
+
+class ProfileLoader : public QRunnable
+{
+public:
+    ProfileLoader(const QString &fileName, ProfilePtr *profile)
+        : mFileName(fileName), mProfile(profile)
+    {
+    }
+
+    void run()
+    {
+        // Each loader has its own slot in the result vector, so nothing is shared between the
+        // threads apart from the (thread-safe) reference counting
+        *mProfile = Profile::createForFileName(mFileName);
+    }
+
+private:
+    QString mFileName;
+    ProfilePtr *mProfile;
+};
+
+}
+
+struct TP_QT_NO_EXPORT ProfileCache::Private
+{
+    Private(const QString &cacheDir);
+
+    QString fileName() const;
+
+    static Stamp currentStamp(const QStringList &searchDirs, QFileInfoList *profileFiles);
+    bool load(Stamp *stamp, QList<ProfilePtr> *profiles) const;
+    void save(const Stamp &stamp, const QList<ProfilePtr> &profiles) const;
+
+    static QList<ProfilePtr> loadProfiles(const QFileInfoList &profileFiles);
+
+    QString cacheDir;
+    Stamp stamp;
+    QList<ProfilePtr> profiles;
+};
+
+ProfileCache::Private::Private(const QString &cacheDir)
+    : cacheDir(cacheDir)
+{
+}
+
+QString ProfileCache::Private::fileName() const
+{
+    return cacheDir + QLatin1String("/profiles.cache");
+}
+
+Stamp ProfileCache::Private::currentStamp(const QStringList &searchDirs,
+        QFileInfoList *profileFiles)
+{
+    // Adding, removing or renaming a profile changes the modification time of its directory, and
+    // the files themselves are stamped as well so that profiles rewritten in place are noticed.
+    // Missing directories are part of the stamp too, with an invalid stamp, as creating one may add
+    // profiles.
+    Stamp stamp;
+    foreach (const QString &searchDir, searchDirs) {
+        QFileInfo dirInfo(searchDir);
+        if (!dirInfo.isDir()) {
+            stamp.append(qMakePair(searchDir, FileStamp()));
+            continue;
+        }
+        stamp.append(qMakePair(searchDir, FileStamp::forFile(searchDir)));
+
+        QDir dir(searchDir);
+        QFileInfoList list = dir.entryInfoList(QStringList() << QLatin1String("*.profile"),
+                QDir::Files, QDir::Name);
+        foreach (const QFileInfo &fi, list) {
+            if (fi.completeSuffix() != QLatin1String("profile")) {
+                continue;
+            }
+            stamp.append(qMakePair(fi.absoluteFilePath(),
+                        FileStamp::forFile(fi.absoluteFilePath())));
+            profileFiles->append(fi);
+        }
+    }
+    return stamp;
+}
+
+bool ProfileCache::Private::load(Stamp *stamp, QList<ProfilePtr> *profiles) const
+{
+    QFile file(fileName());
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version, count;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion) {
+        tpDebug() << "Ignoring profile cache" << file.fileName() << "with an invalid header";
+        return false;
+    }
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString fileName;
+        FileStamp fileStamp;
+        in >> fileName >> fileStamp;
+        stamp->append(qMakePair(fileName, fileStamp));
+    }
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ProfilePtr profile = Profile::readFromStream(in);
+        if (profile) {
+            profiles->append(profile);
+        }
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        tpDebug() << "Ignoring truncated profile cache" << file.fileName();
+        return false;
+    }
+
+    return true;
+}
+
+void ProfileCache::Private::save(const Stamp &stamp, const QList<ProfilePtr> &profiles) const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << cacheMagic << cacheVersion;
+    out << static_cast<quint32>(stamp.size());
+    foreach (const Stamp::value_type &stampFile, stamp) {
+        out << stampFile.first << stampFile.second;
+    }
+    out << static_cast<quint32>(profiles.size());
+    foreach (const ProfilePtr &profile, profiles) {
+        if (!profile->writeToStream(out)) {
+            tpDebug() << "Not caching profiles on disk, profile for service" <<
+                profile->serviceName() << "can't be stored";
+            QFile::remove(fileName());
+            return;
+        }
+    }
+
+    if (out.status() != QDataStream::Ok) {
+        warning() << "Error serializing profile cache" << fileName();
+        return;
+    }
+
+    saveCacheFile(fileName(), data);
+}
+
+QList<ProfilePtr> ProfileCache::Private::loadProfiles(const QFileInfoList &profileFiles)
+{
+    QStringList fileNames;
+    foreach (const QFileInfo &fi, profileFiles) {
+        fileNames << fi.absoluteFilePath();
+    }
+
+    // Parsing is independent for each file, so spread it over the available cores. A profile which
+    // turns out to be invalid doesn't hide the ones for the same service in later search
+    // directories, so all of them are parsed.
+    QVector<ProfilePtr> results(fileNames.size());
+    if (fileNames.size() > 1) {
+        QThreadPool pool;
+        for (int i = 0; i < fileNames.size(); ++i) {
+            pool.start(new ProfileLoader(fileNames.at(i), &results[i]));
+        }
+        pool.waitForDone();
+    } else if (fileNames.size() == 1) {
+        ProfileLoader(fileNames.first(), &results[0]).run();
+    }
+
+    // The first search directory containing a valid profile for a service wins
+    QList<ProfilePtr> profiles;
+    QSet<QString> serviceNames;
+    for (int i = 0; i < results.size(); ++i) {
+        QString serviceName = profileFiles.at(i).baseName();
+        if (serviceNames.contains(serviceName)) {
+            tpDebug() << "Profile for service" << serviceName << "already "
+                "exists. Ignoring profile file:" << fileNames.at(i);
+            continue;
+        }
+
+        const ProfilePtr &profile = results.at(i);
+        if (!profile->isValid()) {
+            continue;
+        }
+
+        if (profile->type() != QLatin1String("IM")) {
+            tpDebug() << "Ignoring profile for service" << serviceName <<
+                ": type != IM. Profile file:" << fileNames.at(i);
+            continue;
+        }
+
+        tpDebug() << "Found profile for service" << serviceName <<
+            "- profile file:" << fileNames.at(i);
+        serviceNames.insert(serviceName);
+        profiles << profile;
+    }
+    return profiles;
+}
+
+ProfileCache *ProfileCache::mInstance = 0;
+
+ProfileCache *ProfileCache::instance()
+{
+    if (!mInstance) {
+        QString cacheDir = QString(QLatin1String(qgetenv("XDG_CACHE_HOME")));
+        if (cacheDir.isEmpty()) {
+            cacheDir = QString(QLatin1String("%1/.cache")).arg(QLatin1String(qgetenv("HOME")));
+        }
+        mInstance = new ProfileCache(cacheDir + QLatin1String("/telepathy/profiles"));
+    }
+    return mInstance;
+}
+
+ProfileCache::ProfileCache(const QString &cacheDir)
+    : mPriv(new Private(cacheDir))
+{
+}
+
+ProfileCache::~ProfileCache()
+{
+    delete mPriv;
+}
+
+QString ProfileCache::cacheDir() const
+{
+    return mPriv->cacheDir;
+}
+
+QList<ProfilePtr> ProfileCache::profiles(const QStringList &searchDirs)
+{
+    QFileInfoList profileFiles;
+    Stamp stamp = Private::currentStamp(searchDirs, &profileFiles);
+
+    if (!mPriv->stamp.isEmpty() && mPriv->stamp == stamp) {
+        return mPriv->profiles;
+    }
+
+    Stamp cachedStamp;
+    QList<ProfilePtr> cachedProfiles;
+    if (mPriv->load(&cachedStamp, &cachedProfiles) && cachedStamp == stamp) {
+        tpDebug() << "Using cached profiles from" << mPriv->fileName();
+        mPriv->stamp = stamp;
+        mPriv->profiles = cachedProfiles;
+        return cachedProfiles;
+    }
+
+    tpDebug() << "Profiles changed since they were cached, loading them again";
+    mPriv->stamp = stamp;
+    mPriv->profiles = Private::loadProfiles(profileFiles);
+    mPriv->save(stamp, mPriv->profiles);
+    return mPriv->profiles;
+}
+
+void ProfileCache::clear()
+{
+    mPriv->stamp.clear();
+    mPriv->profiles.clear();
+    QFile::remove(mPriv->fileName());
+}
+
+} // Tp
@@ -24,6 +24,7 @@
 
 #include "TelepathyQt/_gen/profile-manager.moc.hpp"
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/profile-cache.h"
 
 #include <TelepathyQt/ConnectionManager>
 #include <TelepathyQt/PendingComposite>
@@ -32,8 +33,6 @@
 #include <TelepathyQt/Profile>
 #include <TelepathyQt/ReadinessHelper>
 
-#include <QFile>
-#include <QFileInfo>
 #include <QString>
 #include <QStringList>
 
@@ -47,10 +46,15 @@ struct TP_QT_NO_EXPORT ProfileManager::Private
     static void introspectMain(Private *self);
     static void introspectFakeProfiles(Private *self);
 
+    void addProfile(const ProfilePtr &profile);
+
     ProfileManager *parent;
     ReadinessHelper *readinessHelper;
     QDBusConnection bus;
     QHash<QString, ProfilePtr> profiles;
+    // Indexes on profiles, so the lookups don't need to go through all of them
+    QHash<QString, QList<ProfilePtr> > profilesByCM;
+    QHash<QString, QList<ProfilePtr> > profilesByProtocol;
     QList<ConnectionManagerPtr> cms;
 };
 
@@ -82,44 +86,10 @@ ProfileManager::Private::Private(ProfileManager *parent, const QDBusConnection &
 
 void ProfileManager::Private::introspectMain(ProfileManager::Private *self)
 {
-    QStringList searchDirs = Profile::searchDirs();
-
-    foreach (const QString searchDir, searchDirs) {
-        QDir dir(searchDir);
-        dir.setFilter(QDir::Files);
-
-        QFileInfoList list = dir.entryInfoList();
-        for (int i = 0; i < list.size(); ++i) {
-            QFileInfo fi = list.at(i);
-
-            if (fi.completeSuffix() !=  QLatin1String("profile")) {
-                continue;
-            }
-
-            QString fileName = fi.absoluteFilePath();
-            QString serviceName = fi.baseName();
-
-            if (self->profiles.contains(serviceName)) {
-                debug() << "Profile for service" << serviceName << "already "
-                    "exists. Ignoring profile file:" << fileName;
-                continue;
-            }
-
-            ProfilePtr profile = Profile::createForFileName(fileName);
-            if (!profile->isValid()) {
-                continue;
-            }
-
-            if (profile->type() != QLatin1String("IM")) {
-                debug() << "Ignoring profile for service" << serviceName <<
-                    ": type != IM. Profile file:" << fileName;
-                continue;
-            }
-
-            debug() << "Found profile for service" << serviceName <<
-                "- profile file:" << fileName;
-            self->profiles.insert(serviceName, profile);
-        }
+    // The profile files are only parsed again if they changed since they were last loaded, by
+    // this or any other process
+    foreach (const ProfilePtr &profile, ProfileCache::instance()->profiles(Profile::searchDirs())) {
+        self->addProfile(profile);
     }
 
     self->readinessHelper->setIntrospectCompleted(FeatureCore, true);
@@ -133,6 +103,13 @@ void ProfileManager::Private::introspectFakeProfiles(ProfileManager::Private *se
             SLOT(onCmNamesRetrieved(Tp::PendingOperation *)));
 }
 
+void ProfileManager::Private::addProfile(const ProfilePtr &profile)
+{
+    profiles.insert(profile->serviceName(), profile);
+    profilesByCM[profile->cmName()].append(profile);
+    profilesByProtocol[profile->protocolName()].append(profile);
+}
+
 /**
  * \class ProfileManager
  * \headerfile TelepathyQt/profile-manager.h <TelepathyQt/ProfileManager>
@@ -222,13 +199,7 @@ QList<ProfilePtr> ProfileManager::profiles() const
  */
 QList<ProfilePtr> ProfileManager::profilesForCM(const QString &cmName) const
 {
-    QList<ProfilePtr> ret;
-    foreach (const ProfilePtr &profile, mPriv->profiles) {
-        if (profile->cmName() == cmName) {
-            ret << profile;
-        }
-    }
-    return ret;
+    return mPriv->profilesByCM.value(cmName);
 }
 
 /**
@@ -240,13 +211,7 @@ QList<ProfilePtr> ProfileManager::profilesForCM(const QString &cmName) const
 QList<ProfilePtr> ProfileManager::profilesForProtocol(
         const QString &protocolName) const
 {
-    QList<ProfilePtr> ret;
-    foreach (const ProfilePtr &profile, mPriv->profiles) {
-        if (profile->protocolName() == protocolName) {
-            ret << profile;
-        }
-    }
-    return ret;
+    return mPriv->profilesByProtocol.value(protocolName);
 }
 
 /**
@@ -322,7 +287,7 @@ void ProfileManager::onCMsReady(Tp::PendingOperation *op)
                         cm->name(),
                         protocolName,
                         cm->protocol(protocolName)));
-            mPriv->profiles.insert(serviceName, profile);
+            mPriv->addProfile(profile);
         }
     }
 
@@ -29,13 +29,13 @@
 #include <TelepathyQt/ProtocolParameter>
 #include <TelepathyQt/Utils>
 
+#include <QDataStream>
 #include <QFile>
 #include <QFileInfo>
+#include <QStack>
 #include <QStringList>
-#include <QXmlAttributes>
-#include <QXmlDefaultHandler>
-#include <QXmlInputSource>
-#include <QXmlSimpleReader>
+#include <QXmlStreamAttributes>
+#include <QXmlStreamReader>
 
 namespace Tp
 {
@@ -69,7 +69,7 @@ struct TP_QT_NO_EXPORT Profile::Private
         RequestableChannelClassSpecList unsupportedChannelClassSpecs;
     };
 
-    class XmlHandler;
+    class XmlReader;
 
     QString serviceName;
     bool valid;
@@ -97,22 +97,21 @@ void Profile::Private::Data::clear()
 }
 
 
-class TP_QT_NO_EXPORT Profile::Private::XmlHandler :
-                public QXmlDefaultHandler
+class TP_QT_NO_EXPORT Profile::Private::XmlReader
 {
 public:
-    XmlHandler(const QString &serviceName, bool allowNonIMType, Profile::Private::Data *outputData);
+    XmlReader(const QString &serviceName, bool allowNonIMType, Profile::Private::Data *outputData);
 
-    bool startElement(const QString &namespaceURI, const QString &localName,
-            const QString &qName, const QXmlAttributes &attributes);
-    bool endElement(const QString &namespaceURI, const QString &localName,
-            const QString &qName);
-    bool characters(const QString &str);
-    bool fatalError(const QXmlParseException &exception);
+    bool read(QIODevice *device);
     QString errorString() const;
 
 private:
-    bool attributeValueAsBoolean(const QXmlAttributes &attributes,
+    bool startElement(const QString &namespaceURI, const QString &qName,
+            const QXmlStreamAttributes &attributes);
+    bool endElement(const QString &namespaceURI, const QString &qName);
+    QString attributeValue(const QXmlStreamAttributes &attributes,
+            const QString &qName);
+    bool attributeValueAsBoolean(const QXmlStreamAttributes &attributes,
             const QString &qName);
 
     QString mServiceName;
@@ -153,32 +152,32 @@ private:
     static const QString elemAttrDisabled;
 };
 
-const QString Profile::Private::XmlHandler::xmlNs = QLatin1String("http://telepathy.freedesktop.org/wiki/service-profile-v1");
-
-const QString Profile::Private::XmlHandler::elemService = QLatin1String("service");
-const QString Profile::Private::XmlHandler::elemName = QLatin1String("name");
-const QString Profile::Private::XmlHandler::elemParams = QLatin1String("parameters");
-const QString Profile::Private::XmlHandler::elemParam = QLatin1String("parameter");
-const QString Profile::Private::XmlHandler::elemPresences = QLatin1String("presences");
-const QString Profile::Private::XmlHandler::elemPresence = QLatin1String("presence");
-const QString Profile::Private::XmlHandler::elemUnsupportedCCs = QLatin1String("unsupported-channel-classes");
-const QString Profile::Private::XmlHandler::elemCC = QLatin1String("channel-class");
-const QString Profile::Private::XmlHandler::elemProperty = QLatin1String("property");
-
-const QString Profile::Private::XmlHandler::elemAttrId = QLatin1String("id");
-const QString Profile::Private::XmlHandler::elemAttrName = QLatin1String("name");
-const QString Profile::Private::XmlHandler::elemAttrType = QLatin1String("type");
-const QString Profile::Private::XmlHandler::elemAttrProvider = QLatin1String("provider");
-const QString Profile::Private::XmlHandler::elemAttrManager = QLatin1String("manager");
-const QString Profile::Private::XmlHandler::elemAttrProtocol = QLatin1String("protocol");
-const QString Profile::Private::XmlHandler::elemAttrLabel = QLatin1String("label");
-const QString Profile::Private::XmlHandler::elemAttrMandatory = QLatin1String("mandatory");
-const QString Profile::Private::XmlHandler::elemAttrAllowOthers = QLatin1String("allow-others");
-const QString Profile::Private::XmlHandler::elemAttrIcon = QLatin1String("icon");
-const QString Profile::Private::XmlHandler::elemAttrMessage = QLatin1String("message");
-const QString Profile::Private::XmlHandler::elemAttrDisabled = QLatin1String("disabled");
-
-Profile::Private::XmlHandler::XmlHandler(const QString &serviceName,
+const QString Profile::Private::XmlReader::xmlNs = QLatin1String("http://telepathy.freedesktop.org/wiki/service-profile-v1");
+
+const QString Profile::Private::XmlReader::elemService = QLatin1String("service");
+const QString Profile::Private::XmlReader::elemName = QLatin1String("name");
+const QString Profile::Private::XmlReader::elemParams = QLatin1String("parameters");
+const QString Profile::Private::XmlReader::elemParam = QLatin1String("parameter");
+const QString Profile::Private::XmlReader::elemPresences = QLatin1String("presences");
+const QString Profile::Private::XmlReader::elemPresence = QLatin1String("presence");
+const QString Profile::Private::XmlReader::elemUnsupportedCCs = QLatin1String("unsupported-channel-classes");
+const QString Profile::Private::XmlReader::elemCC = QLatin1String("channel-class");
+const QString Profile::Private::XmlReader::elemProperty = QLatin1String("property");
+
+const QString Profile::Private::XmlReader::elemAttrId = QLatin1String("id");
+const QString Profile::Private::XmlReader::elemAttrName = QLatin1String("name");
+const QString Profile::Private::XmlReader::elemAttrType = QLatin1String("type");
+const QString Profile::Private::XmlReader::elemAttrProvider = QLatin1String("provider");
+const QString Profile::Private::XmlReader::elemAttrManager = QLatin1String("manager");
+const QString Profile::Private::XmlReader::elemAttrProtocol = QLatin1String("protocol");
+const QString Profile::Private::XmlReader::elemAttrLabel = QLatin1String("label");
+const QString Profile::Private::XmlReader::elemAttrMandatory = QLatin1String("mandatory");
+const QString Profile::Private::XmlReader::elemAttrAllowOthers = QLatin1String("allow-others");
+const QString Profile::Private::XmlReader::elemAttrIcon = QLatin1String("icon");
+const QString Profile::Private::XmlReader::elemAttrMessage = QLatin1String("message");
+const QString Profile::Private::XmlReader::elemAttrDisabled = QLatin1String("disabled");
+
+Profile::Private::XmlReader::XmlReader(const QString &serviceName,
         bool allowNonIMType,
         Profile::Private::Data *outputData)
     : mServiceName(serviceName),
@@ -188,9 +187,45 @@ Profile::Private::XmlHandler::XmlHandler(const QString &serviceName,
 {
 }
 
-bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
-        const QString &localName, const QString &qName,
-        const QXmlAttributes &attributes)
+bool Profile::Private::XmlReader::read(QIODevice *device)
+{
+    QXmlStreamReader reader(device);
+    while (!reader.atEnd()) {
+        switch (reader.readNext()) {
+            case QXmlStreamReader::StartElement:
+                if (!startElement(reader.namespaceUri().toString(),
+                            reader.qualifiedName().toString(), reader.attributes())) {
+                    return false;
+                }
+                break;
+            case QXmlStreamReader::EndElement:
+                if (!endElement(reader.namespaceUri().toString(),
+                            reader.qualifiedName().toString())) {
+                    return false;
+                }
+                break;
+            case QXmlStreamReader::Characters:
+                mCurrentText += reader.text().toString();
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (reader.hasError()) {
+        mErrorString = QString(QLatin1String("parse error at line %1, column %2: "
+                    "%3"))
+            .arg(reader.lineNumber())
+            .arg(reader.columnNumber())
+            .arg(reader.errorString());
+        return false;
+    }
+
+    return true;
+}
+
+bool Profile::Private::XmlReader::startElement(const QString &namespaceURI,
+        const QString &qName, const QXmlStreamAttributes &attributes)
 {
     if (!mMetServiceTag && qName != elemService) {
         mErrorString = QLatin1String("the file is not a profile file");
@@ -199,7 +234,7 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
 
     if (namespaceURI != xmlNs) {
         // ignore all elements with unknown xmlns
-        debug() << "Ignoring unknown xmlns" << namespaceURI;
+        tpDebug() << "Ignoring unknown xmlns" << namespaceURI;
         return true;
     }
 
@@ -220,7 +255,7 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
         return false; \
     }
 #define CHECK_ELEMENT_HAS_ATTRIBUTE(attribute) \
-    if (attributes.index(attribute) == -1) { \
+    if (!attributes.hasAttribute(attribute)) { \
         mErrorString = QString(QLatin1String("mandatory attribute '%1' " \
                     "missing on element '%2'")) \
             .arg(attribute) \
@@ -230,7 +265,7 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
 #define CHECK_ELEMENT_ATTRIBUTES(allowedAttrs) \
     for (int i = 0; i < attributes.count(); ++i) { \
         bool valid = false; \
-        QString attrName = attributes.qName(i); \
+        QString attrName = attributes.at(i).qualifiedName().toString(); \
         foreach (const QString &allowedAttr, allowedAttrs) { \
             if (attrName == allowedAttr) { \
                 valid = true; \
@@ -257,7 +292,7 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
             elemAttrProtocol << elemAttrProvider << elemAttrIcon;
         CHECK_ELEMENT_ATTRIBUTES(allowedAttrs);
 
-        if (attributes.value(elemAttrId) != mServiceName) {
+        if (attributeValue(attributes, elemAttrId) != mServiceName) {
             mErrorString = QString(QLatin1String("the '%1' attribute of the "
                         "element '%2' does not match the file name"))
                 .arg(elemAttrId)
@@ -266,17 +301,17 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
         }
 
         mMetServiceTag = true;
-        mData->type = attributes.value(elemAttrType);
+        mData->type = attributeValue(attributes, elemAttrType);
         if (mData->type != QLatin1String("IM") && !allowNonIMType) {
             mErrorString = QString(QLatin1String("unknown value of element "
                         "'type': %1"))
                 .arg(mCurrentText);
             return false;
         }
-        mData->provider = attributes.value(elemAttrProvider);
-        mData->cmName = attributes.value(elemAttrManager);
-        mData->protocolName = attributes.value(elemAttrProtocol);
-        mData->iconName = attributes.value(elemAttrIcon);
+        mData->provider = attributeValue(attributes, elemAttrProvider);
+        mData->cmName = attributeValue(attributes, elemAttrManager);
+        mData->protocolName = attributeValue(attributes, elemAttrProtocol);
+        mData->iconName = attributeValue(attributes, elemAttrIcon);
     } else if (qName == elemParams) {
         CHECK_ELEMENT_IS_CHILD_OF(elemService);
         CHECK_ELEMENT_ATTRIBUTES_COUNT(0);
@@ -287,13 +322,13 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
             elemAttrType << elemAttrMandatory << elemAttrLabel;
         CHECK_ELEMENT_ATTRIBUTES(allowedAttrs);
 
-        QString paramType = attributes.value(elemAttrType);
+        QString paramType = attributeValue(attributes, elemAttrType);
         if (paramType.isEmpty()) {
             paramType = QLatin1String("s");
         }
-        mCurrentParameter.setName(attributes.value(elemAttrName));
+        mCurrentParameter.setName(attributeValue(attributes, elemAttrName));
         mCurrentParameter.setDBusSignature(QDBusSignature(paramType));
-        mCurrentParameter.setLabel(attributes.value(elemAttrLabel));
+        mCurrentParameter.setLabel(attributeValue(attributes, elemAttrLabel));
         mCurrentParameter.setMandatory(attributeValueAsBoolean(attributes,
                     elemAttrMandatory));
     } else if (qName == elemPresences) {
@@ -312,10 +347,10 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
         CHECK_ELEMENT_ATTRIBUTES(allowedAttrs);
 
         mData->presences.append(Profile::Presence(
-                    attributes.value(elemAttrId),
-                    attributes.value(elemAttrLabel),
-                    attributes.value(elemAttrIcon),
-                    attributes.value(elemAttrMessage),
+                    attributeValue(attributes, elemAttrId),
+                    attributeValue(attributes, elemAttrLabel),
+                    attributeValue(attributes, elemAttrIcon),
+                    attributeValue(attributes, elemAttrMessage),
                     attributeValueAsBoolean(attributes, elemAttrDisabled)));
     } else if (qName == elemUnsupportedCCs) {
         CHECK_ELEMENT_IS_CHILD_OF(elemService);
@@ -329,8 +364,8 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
         CHECK_ELEMENT_HAS_ATTRIBUTE(elemAttrName);
         CHECK_ELEMENT_HAS_ATTRIBUTE(elemAttrType);
 
-        mCurrentPropertyName = attributes.value(elemAttrName);
-        mCurrentPropertyType = attributes.value(elemAttrType);
+        mCurrentPropertyName = attributeValue(attributes, elemAttrName);
+        mCurrentPropertyType = attributeValue(attributes, elemAttrType);
     } else {
         if (qName != elemName) {
             Tp::warning() << "Ignoring unknown element" << qName;
@@ -352,12 +387,12 @@ bool Profile::Private::XmlHandler::startElement(const QString &namespaceURI,
     return true;
 }
 
-bool Profile::Private::XmlHandler::endElement(const QString &namespaceURI,
-        const QString &localName, const QString &qName)
+bool Profile::Private::XmlReader::endElement(const QString &namespaceURI,
+        const QString &qName)
 {
     if (namespaceURI != xmlNs) {
         // ignore all elements with unknown xmlns
-        debug() << "Ignoring unknown xmlns" << namespaceURI;
+        tpDebug() << "Ignoring unknown xmlns" << namespaceURI;
         return true;
     } else if (qName == elemName) {
         mData->name = mCurrentText;
@@ -378,32 +413,21 @@ bool Profile::Private::XmlHandler::endElement(const QString &namespaceURI,
     return true;
 }
 
-bool Profile::Private::XmlHandler::characters(const QString &str)
+QString Profile::Private::XmlReader::errorString() const
 {
-    mCurrentText += str;
-    return true;
+    return mErrorString;
 }
 
-bool Profile::Private::XmlHandler::fatalError(
-        const QXmlParseException &exception)
+QString Profile::Private::XmlReader::attributeValue(
+        const QXmlStreamAttributes &attributes, const QString &qName)
 {
-    mErrorString = QString(QLatin1String("parse error at line %1, column %2: "
-                "%3"))
-        .arg(exception.lineNumber())
-        .arg(exception.columnNumber())
-        .arg(exception.message());
-    return false;
+    return attributes.value(qName).toString();
 }
 
-QString Profile::Private::XmlHandler::errorString() const
+bool Profile::Private::XmlReader::attributeValueAsBoolean(
+        const QXmlStreamAttributes &attributes, const QString &qName)
 {
-    return mErrorString;
-}
-
-bool Profile::Private::XmlHandler::attributeValueAsBoolean(
-        const QXmlAttributes &attributes, const QString &qName)
-{
-    QString tmpStr = attributes.value(qName);
+    QString tmpStr = attributeValue(attributes, qName);
     if (tmpStr == QLatin1String("1") ||
         tmpStr == QLatin1String("true")) {
         return true;
@@ -437,7 +461,7 @@ void Profile::Private::setFileName(const QString &fileName)
     QFileInfo fi(fileName);
     serviceName = fi.baseName();
 
-    debug() << "Loading profile file" << fileName;
+    tpDebug() << "Loading profile file" << fileName;
 
     QFile file(fileName);
     if (!file.exists()) {
@@ -454,13 +478,13 @@ void Profile::Private::setFileName(const QString &fileName)
     }
 
     if (parse(&file)) {
-        debug() << "Profile file" << fileName << "loaded successfully";
+        tpDebug() << "Profile file" << fileName << "loaded successfully";
     }
 }
 
 void Profile::Private::lookupProfile()
 {
-    debug() << "Searching profile for service" << serviceName;
+    tpDebug() << "Searching profile for service" << serviceName;
 
     QStringList searchDirs = Profile::searchDirs();
     bool found = false;
@@ -477,14 +501,14 @@ void Profile::Private::lookupProfile()
         }
 
         if (parse(&file)) {
-            debug() << "Profile for service" << serviceName << "found:" << fileName;
+            tpDebug() << "Profile for service" << serviceName << "found:" << fileName;
             found = true;
             break;
         }
     }
 
     if (!found) {
-        debug() << "Cannot find valid profile for service" << serviceName;
+        tpDebug() << "Cannot find valid profile for service" << serviceName;
     }
 }
 
@@ -494,17 +518,12 @@ bool Profile::Private::parse(QFile *file)
 
     fake = false;
     QFileInfo fi(file->fileName());
-    XmlHandler xmlHandler(serviceName, allowNonIMType, &data);
-
-    QXmlSimpleReader xmlReader;
-    xmlReader.setContentHandler(&xmlHandler);
-    xmlReader.setErrorHandler(&xmlHandler);
+    XmlReader xmlReader(serviceName, allowNonIMType, &data);
 
-    QXmlInputSource xmlInputSource(file);
-    if (!xmlReader.parse(xmlInputSource)) {
+    if (!xmlReader.read(file)) {
         warning() << QString(QLatin1String("Error parsing profile file %1: %2"))
             .arg(file->fileName())
-            .arg(xmlHandler.errorString());
+            .arg(xmlReader.errorString());
         invalidate();
         return false;
     }
@@ -869,6 +888,117 @@ QStringList Profile::searchDirs()
     return ret;
 }
 
+static bool isStorable(const QVariant &value)
+{
+    // QDataStream only knows about the builtin types
+    if (!value.isValid()) {
+        return true;
+    }
+
+    if (value.userType() >= QVariant::UserType) {
+        return false;
+    }
+
+    if (value.type() == QVariant::Map) {
+        QVariantMap map = value.toMap();
+        for (QVariantMap::const_iterator i = map.constBegin(); i != map.constEnd(); ++i) {
+            if (!isStorable(i.value())) {
+                return false;
+            }
+        }
+    } else if (value.type() == QVariant::List) {
+        foreach (const QVariant &item, value.toList()) {
+            if (!isStorable(item)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool Profile::writeToStream(QDataStream &out) const
+{
+    const Private::Data &data = mPriv->data;
+
+    foreach (const Parameter &param, data.parameters) {
+        if (!isStorable(param.value())) {
+            return false;
+        }
+    }
+    foreach (const RequestableChannelClassSpec &spec, data.unsupportedChannelClassSpecs) {
+        if (!isStorable(QVariant(spec.fixedProperties()))) {
+            return false;
+        }
+    }
+
+    out << mPriv->serviceName << data.type << data.provider << data.name << data.iconName <<
+        data.cmName << data.protocolName;
+
+    out << static_cast<quint32>(data.parameters.size());
+    foreach (const Parameter &param, data.parameters) {
+        out << param.name() << param.dbusSignature().signature() << param.value() <<
+            param.label() << param.isMandatory();
+    }
+
+    out << data.allowOtherPresences;
+    out << static_cast<quint32>(data.presences.size());
+    foreach (const Presence &presence, data.presences) {
+        out << presence.id() << presence.label() << presence.iconName() << presence.message() <<
+            presence.isDisabled();
+    }
+
+    out << static_cast<quint32>(data.unsupportedChannelClassSpecs.size());
+    foreach (const RequestableChannelClassSpec &spec, data.unsupportedChannelClassSpecs) {
+        out << spec.fixedProperties() << spec.allowedProperties();
+    }
+
+    return true;
+}
+
+ProfilePtr Profile::readFromStream(QDataStream &in)
+{
+    ProfilePtr profile = ProfilePtr(new Profile());
+    Private::Data &data = profile->mPriv->data;
+    quint32 count;
+
+    in >> profile->mPriv->serviceName >> data.type >> data.provider >> data.name >>
+        data.iconName >> data.cmName >> data.protocolName;
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString name, signature, label;
+        QVariant value;
+        bool mandatory;
+        in >> name >> signature >> value >> label >> mandatory;
+        data.parameters.append(Parameter(name, QDBusSignature(signature), value, label,
+                    mandatory));
+    }
+
+    in >> data.allowOtherPresences;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString id, label, iconName, message;
+        bool disabled;
+        in >> id >> label >> iconName >> message >> disabled;
+        data.presences.append(Presence(id, label, iconName, message, disabled));
+    }
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        RequestableChannelClass rcc;
+        in >> rcc.fixedProperties >> rcc.allowedProperties;
+        data.unsupportedChannelClassSpecs.append(RequestableChannelClassSpec(rcc));
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        return ProfilePtr();
+    }
+
+    profile->mPriv->valid = true;
+    return profile;
+}
+
 
 struct TP_QT_NO_EXPORT Profile::Parameter::Private
 {
@@ -35,6 +35,8 @@
 #include <QString>
 #include <QVariant>
 
+class QDataStream;
+
 namespace Tp
 {
 
@@ -151,6 +153,7 @@ public:
 
 private:
     friend class Account;
+    friend class ProfileCache;
     friend class ProfileManager;
 
     TP_QT_NO_EXPORT Profile();
@@ -162,6 +165,9 @@ private:
 
     TP_QT_NO_EXPORT static QStringList searchDirs();
 
+    TP_QT_NO_EXPORT bool writeToStream(QDataStream &out) const;
+    TP_QT_NO_EXPORT static ProfilePtr readFromStream(QDataStream &in);
+
     struct Private;
     friend struct Private;
     Private *mPriv;
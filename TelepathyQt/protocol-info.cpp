@@ -51,6 +51,27 @@ struct TP_QT_NO_EXPORT ProtocolInfo::Private : public QSharedData
         objectPath = QString(QLatin1String("%1/%2")).arg(cm->objectPath()).arg(escapedProtocolName);
     }
 
+    Private(const Private &other)
+        : QSharedData(other),
+          dbusConnection(other.dbusConnection),
+          busName(other.busName),
+          objectPath(other.objectPath),
+          cmName(other.cmName),
+          name(other.name),
+          params(other.params),
+          caps(other.caps),
+          vcardField(other.vcardField),
+          englishName(other.englishName),
+          iconName(other.iconName),
+          statuses(other.statuses),
+          avatarRequirements(other.avatarRequirements),
+          addressableVCardFields(other.addressableVCardFields),
+          addressableUriSchemes(other.addressableUriSchemes),
+          // the interface is owned by the original, a detached copy creates its own on demand
+          addressingIface(0)
+    {
+    }
+
     ~Private()
     {
         delete addressingIface;
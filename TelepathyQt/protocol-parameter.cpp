@@ -64,7 +64,7 @@ struct TP_QT_NO_EXPORT ProtocolParameter::Private : public QSharedData
             if (spec.defaultValue.variant() != QVariant::Invalid) {
                 // flags does not contain HasDefault but a default value is passed,
                 // lets add HasDefault to flags
-                debug() << "Building ProtocolParameter with flags not containing ConnMgrParamFlagHasDefault"
+                tpDebug() << "Building ProtocolParameter with flags not containing ConnMgrParamFlagHasDefault"
                     " and a default value, updating flags to contain ConnMgrParamFlagHasDefault";
                 spec.flags |= ConnMgrParamFlagHasDefault;
             }
@@ -25,6 +25,7 @@
 #include "TelepathyQt/_gen/readiness-helper.moc.hpp"
 
 #include "TelepathyQt/debug-internal.h"
+#include "TelepathyQt/feature-set.h"
 
 #include <TelepathyQt/Constants>
 #include <TelepathyQt/DBusProxy>
@@ -34,6 +35,7 @@
 
 #include <QDBusError>
 #include <QSharedData>
+#include <QTime>
 #include <QTimer>
 
 namespace Tp
@@ -49,6 +51,7 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Introspectable::Private : public QShared
             bool critical)
         : makesSenseForStatuses(makesSenseForStatuses),
         dependsOnFeatures(dependsOnFeatures),
+        dependsOnFeatureSet(dependsOnFeatures),
         dependsOnInterfaces(dependsOnInterfaces),
         introspectFunc(introspectFunc),
         introspectFuncData(introspectFuncData),
@@ -56,6 +59,7 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Introspectable::Private : public QShared
 
     QSet<uint> makesSenseForStatuses;
     Features dependsOnFeatures;
+    FeatureSet dependsOnFeatureSet;
     QStringList dependsOnInterfaces;
     IntrospectFunc introspectFunc;
     void *introspectFuncData;
@@ -93,6 +97,14 @@ ReadinessHelper::Introspectable &ReadinessHelper::Introspectable::operator=(
 
 struct TP_QT_NO_EXPORT ReadinessHelper::Private
 {
+    struct Timing
+    {
+        Timing() : started(-1), finished(-1) {}
+
+        int started;
+        int finished;
+    };
+
     Private(ReadinessHelper *parent,
             RefCounted *object,
             uint currentStatus,
@@ -103,12 +115,17 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Private
             const Introspectables &introspectables);
     ~Private();
 
+    void addIntrospectable(const Feature &feature, const Introspectable &introspectable);
+
     void setCurrentStatus(uint newStatus);
     void setIntrospectCompleted(const Feature &feature, bool success,
             const QString &errorName = QString(),
             const QString &errorMessage = QString());
+    void scheduleIteration(bool fullScan);
     void iterateIntrospection();
-    Features depsFor(const Feature &feature); // Recursive dependencies for a feature
+    void flagMissingDependents(FeatureSet &candidates);
+    FeatureSet depsFor(const Feature &feature); // Recursive dependencies for a feature
+    QList<Feature> criticalPath() const;
 
     void abortOperations(const QString &errorName, const QString &errorMessage);
 
@@ -119,15 +136,30 @@ struct TP_QT_NO_EXPORT ReadinessHelper::Private
     QStringList interfaces;
     Introspectables introspectables;
     QSet<uint> supportedStatuses;
-    Features supportedFeatures;
-    Features satisfiedFeatures;
-    Features requestedFeatures;
-    Features missingFeatures;
-    Features pendingFeatures;
-    Features inFlightFeatures;
+    // Kept as bitsets, as they are checked each time the object is asked whether it's ready
+    FeatureSet supportedFeatures;
+    FeatureSet satisfiedFeatures;
+    FeatureSet requestedFeatures;
+    FeatureSet missingFeatures;
+    FeatureSet completedFeatures; // satisfiedFeatures + missingFeatures
+    FeatureSet pendingFeatures;
+    FeatureSet inFlightFeatures;
     QHash<Feature, QPair<QString, QString> > missingFeaturesErrors;
     QList<PendingReady *> pendingOperations;
 
+    // The features directly depending on each feature, and the recursive dependencies of each
+    // feature, so an introspection finishing only needs to look at the features it affects
+    QHash<Feature, FeatureSet> dependents;
+    QHash<Feature, FeatureSet> depsCache;
+
+    // Pending features to look at in the next iteration, or all of them if fullScan is set
+    FeatureSet dirtyFeatures;
+    bool fullScan;
+    bool iterationScheduled;
+
+    QTime clock;
+    QHash<Feature, Timing> timings;
+
     bool pendingStatusChange;
     uint pendingStatus;
 };
@@ -141,18 +173,17 @@ ReadinessHelper::Private::Private(
       object(object),
       proxy(0),
       currentStatus(currentStatus),
-      introspectables(introspectables),
+      fullScan(false),
+      iterationScheduled(false),
       pendingStatusChange(false),
       pendingStatus(-1)
 {
     for (Introspectables::const_iterator i = introspectables.constBegin();
             i != introspectables.constEnd(); ++i) {
-        Feature feature = i.key();
-        Introspectable introspectable = i.value();
-        Q_ASSERT(introspectable.mPriv->introspectFunc != 0);
-        supportedStatuses += introspectable.mPriv->makesSenseForStatuses;
-        supportedFeatures += feature;
+        addIntrospectable(i.key(), i.value());
     }
+
+    clock.start();
 }
 
 ReadinessHelper::Private::Private(
@@ -164,7 +195,8 @@ ReadinessHelper::Private::Private(
       object(proxy),
       proxy(proxy),
       currentStatus(currentStatus),
-      introspectables(introspectables),
+      fullScan(false),
+      iterationScheduled(false),
       pendingStatusChange(false),
       pendingStatus(-1)
 {
@@ -172,12 +204,10 @@ ReadinessHelper::Private::Private(
 
     for (Introspectables::const_iterator i = introspectables.constBegin();
             i != introspectables.constEnd(); ++i) {
-        Feature feature = i.key();
-        Introspectable introspectable = i.value();
-        Q_ASSERT(introspectable.mPriv->introspectFunc != 0);
-        supportedStatuses += introspectable.mPriv->makesSenseForStatuses;
-        supportedFeatures += feature;
+        addIntrospectable(i.key(), i.value());
     }
+
+    clock.start();
 }
 
 ReadinessHelper::Private::~Private()
@@ -187,6 +217,21 @@ ReadinessHelper::Private::~Private()
     abortOperations(TP_QT_ERROR_CANCELLED, messageDestroyed);
 }
 
+void ReadinessHelper::Private::addIntrospectable(const Feature &feature,
+        const Introspectable &introspectable)
+{
+    Q_ASSERT(introspectable.mPriv->introspectFunc != 0);
+
+    introspectables.insert(feature, introspectable);
+    supportedStatuses += introspectable.mPriv->makesSenseForStatuses;
+    supportedFeatures += feature;
+
+    foreach (const Feature &dep, introspectable.mPriv->dependsOnFeatures) {
+        dependents[dep].insert(feature);
+    }
+    depsCache.clear();
+}
+
 void ReadinessHelper::Private::setCurrentStatus(uint newStatus)
 {
     if (currentStatus == newStatus) {
@@ -197,6 +242,7 @@ void ReadinessHelper::Private::setCurrentStatus(uint newStatus)
         currentStatus = newStatus;
         satisfiedFeatures.clear();
         missingFeatures.clear();
+        completedFeatures.clear();
 
         // Make all features that were requested for the new status pending again
         pendingFeatures = requestedFeatures;
@@ -205,12 +251,12 @@ void ReadinessHelper::Private::setCurrentStatus(uint newStatus)
         // in the requested set, so we don't have to re-add them here
 
         if (supportedStatuses.contains(currentStatus)) {
-            QTimer::singleShot(0, parent, SLOT(iterateIntrospection()));
+            scheduleIteration(true);
         } else {
             emit parent->statusReady(currentStatus);
         }
     } else {
-        debug() << "status changed while introspection process was running";
+        tpDebug() << "status changed while introspection process was running";
         pendingStatusChange = true;
         pendingStatus = newStatus;
     }
@@ -219,10 +265,10 @@ void ReadinessHelper::Private::setCurrentStatus(uint newStatus)
 void ReadinessHelper::Private::setIntrospectCompleted(const Feature &feature,
         bool success, const QString &errorName, const QString &errorMessage)
 {
-    debug() << "ReadinessHelper::setIntrospectCompleted: feature:" << feature <<
+    tpDebug() << "ReadinessHelper::setIntrospectCompleted: feature:" << feature <<
         "- success:" << success;
     if (pendingStatusChange) {
-        debug() << "ReadinessHelper::setIntrospectCompleted called while there is "
+        tpDebug() << "ReadinessHelper::setIntrospectCompleted called while there is "
             "a pending status change - ignoring";
 
         inFlightFeatures.remove(feature);
@@ -252,16 +298,37 @@ void ReadinessHelper::Private::setIntrospectCompleted(const Feature &feature,
         }
     }
 
+    completedFeatures.insert(feature);
     pendingFeatures.remove(feature);
     inFlightFeatures.remove(feature);
 
-    QTimer::singleShot(0, parent, SLOT(iterateIntrospection()));
+    timings[feature].finished = clock.elapsed();
+
+    // only the features depending on this one may be ready to introspect (or known to be missing)
+    // now
+    dirtyFeatures += dependents.value(feature);
+    scheduleIteration(false);
+}
+
+void ReadinessHelper::Private::scheduleIteration(bool fullScan)
+{
+    if (fullScan) {
+        this->fullScan = true;
+    }
+
+    // several introspections finishing in a row are all handled by the same iteration
+    if (!iterationScheduled) {
+        iterationScheduled = true;
+        QTimer::singleShot(0, parent, SLOT(iterateIntrospection()));
+    }
 }
 
 void ReadinessHelper::Private::iterateIntrospection()
 {
+    iterationScheduled = false;
+
     if (proxy && !proxy->isValid()) {
-        debug() << "ReadinessHelper: not iterating as the proxy is invalidated";
+        tpDebug() << "ReadinessHelper: not iterating as the proxy is invalidated";
         return;
     }
 
@@ -276,22 +343,26 @@ void ReadinessHelper::Private::iterateIntrospection()
     //
     //  So we can safely skip the rest of this function here.
     if (pendingStatusChange) {
-        debug() << "ReadinessHelper: not iterating as a status change is pending";
+        tpDebug() << "ReadinessHelper: not iterating as a status change is pending";
         return;
     }
 
-    // Flag the currently pending reverse dependencies of any previously discovered missing features
-    // as missing
-    foreach (const Feature &feature, pendingFeatures) {
-        if (!depsFor(feature).intersect(missingFeatures).isEmpty()) {
-            missingFeatures.insert(feature);
-            missingFeaturesErrors.insert(feature,
-                    QPair<QString, QString>(TP_QT_ERROR_NOT_AVAILABLE,
-                        QLatin1String("Feature depends on other features that are not available")));
-        }
+    // Only look at the features whose dependencies changed since the last iteration, unless new
+    // features were requested or the status changed
+    FeatureSet candidates;
+    if (fullScan) {
+        fullScan = false;
+        // newly requested features may have been completed already
+        pendingFeatures -= completedFeatures;
+        candidates = pendingFeatures;
+    } else {
+        candidates = dirtyFeatures;
+        candidates.intersect(pendingFeatures);
     }
+    dirtyFeatures.clear();
 
-    const Features completedFeatures = satisfiedFeatures + missingFeatures;
+    // Flag the pending reverse dependencies of any missing features as missing
+    flagMissingDependents(candidates);
 
     // check if any pending operations for becomeReady should finish now
     // based on their requested features having nothing more than what
@@ -299,7 +370,7 @@ void ReadinessHelper::Private::iterateIntrospection()
     QString errorName;
     QString errorMessage;
     foreach (PendingReady *operation, pendingOperations) {
-        if ((operation->requestedFeatures() - completedFeatures).isEmpty()) {
+        if (completedFeatures.contains(operation->requestedFeatures())) {
             if (parent->isReady(operation->requestedFeatures(), &errorName, &errorMessage)) {
                 operation->setFinished();
             } else {
@@ -314,7 +385,7 @@ void ReadinessHelper::Private::iterateIntrospection()
         }
     }
 
-    if ((requestedFeatures - completedFeatures).isEmpty()) {
+    if (completedFeatures.contains(requestedFeatures)) {
         // Otherwise, we'd emit statusReady with currentStatus although we are supposed to be
         // introspecting the pendingStatus and only when that is complete, emit statusReady
         Q_ASSERT(!pendingStatusChange);
@@ -324,51 +395,51 @@ void ReadinessHelper::Private::iterateIntrospection()
         return;
     }
 
-    // update pendingFeatures with the difference of requested and
-    // satisfied + missing
-    pendingFeatures -= completedFeatures;
-
-    // find out which features don't have dependencies that are still pending
-    Features readyToIntrospect;
-    foreach (const Feature &feature, pendingFeatures) {
-        // missing doesn't have to be considered here anymore
-        if ((introspectables[feature].mPriv->dependsOnFeatures - satisfiedFeatures).isEmpty()) {
-            readyToIntrospect.insert(feature);
+    // find out which features don't have dependencies that are still pending, and introspect
+    // them
+    foreach (const Feature &feature, candidates.toList()) {
+        if (inFlightFeatures.contains(feature) || !pendingFeatures.contains(feature)) {
+            continue;
         }
-    }
 
-    // now readyToIntrospect should contain all the features which have
-    // all their feature dependencies satisfied
-    foreach (const Feature &feature, readyToIntrospect) {
-        if (inFlightFeatures.contains(feature)) {
+        Introspectable introspectable = introspectables[feature];
+
+        // missing doesn't have to be considered here anymore
+        if (!satisfiedFeatures.contains(introspectable.mPriv->dependsOnFeatureSet)) {
             continue;
         }
 
         inFlightFeatures.insert(feature);
-
-        Introspectable introspectable = introspectables[feature];
+        timings[feature] = Timing();
+        timings[feature].started = clock.elapsed();
 
         if (!introspectable.mPriv->makesSenseForStatuses.contains(currentStatus)) {
             // No-op satisfy features for which nothing has to be done in
             // the current state
             setIntrospectCompleted(feature, true);
-            return; // will be called with a single-shot soon again
+            continue;
         }
 
+        bool hasInterfaces = true;
         foreach (const QString &interface, introspectable.mPriv->dependsOnInterfaces) {
             if (!interfaces.contains(interface)) {
                 // If a feature is ready to introspect and depends on a interface
                 // that is not present the feature can't possibly be satisfied
-                debug() << "feature" << feature << "depends on interfaces" <<
+                tpDebug() << "feature" << feature << "depends on interfaces" <<
                     introspectable.mPriv->dependsOnInterfaces << ", but interface" << interface <<
                     "is not present";
                 setIntrospectCompleted(feature, false,
                         TP_QT_ERROR_NOT_AVAILABLE,
                         QLatin1String("Feature depend on interfaces that are not available"));
-                return; // will be called with a single-shot soon again
+                hasInterfaces = false;
+                break;
             }
         }
 
+        if (!hasInterfaces) {
+            continue;
+        }
+
         // yes, with the dependency info, we can even parallelize
         // introspection of several features at once, reducing total round trip
         // time considerably with many independent features!
@@ -376,18 +447,93 @@ void ReadinessHelper::Private::iterateIntrospection()
     }
 }
 
-Features ReadinessHelper::Private::depsFor(const Feature &feature)
+void ReadinessHelper::Private::flagMissingDependents(FeatureSet &candidates)
+{
+    if (missingFeatures.isEmpty()) {
+        return;
+    }
+
+    QList<Feature> toCheck = candidates.toList();
+    while (!toCheck.isEmpty()) {
+        Feature feature = toCheck.takeFirst();
+        if (!pendingFeatures.contains(feature) || inFlightFeatures.contains(feature)) {
+            continue;
+        }
+
+        if (!depsFor(feature).intersects(missingFeatures)) {
+            continue;
+        }
+
+        missingFeatures.insert(feature);
+        missingFeaturesErrors.insert(feature,
+                QPair<QString, QString>(TP_QT_ERROR_NOT_AVAILABLE,
+                    QLatin1String("Feature depends on other features that are not available")));
+        completedFeatures.insert(feature);
+        pendingFeatures.remove(feature);
+        candidates.remove(feature);
+
+        // the features depending on this one are now missing too
+        foreach (const Feature &dependent, dependents.value(feature).toList()) {
+            if (pendingFeatures.contains(dependent)) {
+                toCheck.append(dependent);
+            }
+        }
+    }
+}
+
+FeatureSet ReadinessHelper::Private::depsFor(const Feature &feature)
 {
-    Features deps;
+    QHash<Feature, FeatureSet>::const_iterator i = depsCache.constFind(feature);
+    if (i != depsCache.constEnd()) {
+        return i.value();
+    }
+
+    FeatureSet deps;
 
     foreach (Feature dep, introspectables[feature].mPriv->dependsOnFeatures) {
         deps += dep;
         deps += depsFor(dep);
     }
 
+    depsCache.insert(feature, deps);
     return deps;
 }
 
+QList<Feature> ReadinessHelper::Private::criticalPath() const
+{
+    // Start from the feature which finished last, and walk back through the dependency which
+    // finished last each time, as that's the one which held the feature back
+    QList<Feature> path;
+    Feature current;
+    int currentFinished = -1;
+    for (QHash<Feature, Timing>::const_iterator i = timings.constBegin();
+            i != timings.constEnd(); ++i) {
+        if (i.value().finished > currentFinished) {
+            current = i.key();
+            currentFinished = i.value().finished;
+        }
+    }
+
+    while (currentFinished >= 0) {
+        path.prepend(current);
+
+        Feature next;
+        int nextFinished = -1;
+        foreach (const Feature &dep, introspectables.value(current).mPriv->dependsOnFeatures) {
+            int finished = timings.value(dep).finished;
+            if (finished > nextFinished) {
+                next = dep;
+                nextFinished = finished;
+            }
+        }
+
+        current = next;
+        currentFinished = nextFinished;
+    }
+
+    return path;
+}
+
 void ReadinessHelper::Private::abortOperations(const QString &errorName,
         const QString &errorMessage)
 {
@@ -450,15 +596,13 @@ void ReadinessHelper::addIntrospectables(const Introspectables &introspectables)
                 "introspectable for feature" << feature << "but introspectable "
                 "for this feature already exists";
         } else {
-            Introspectable introspectable = i.value();
-            mPriv->introspectables.insert(feature, introspectable);
-            mPriv->supportedStatuses += introspectable.mPriv->makesSenseForStatuses;
-            mPriv->supportedFeatures += feature;
+            mPriv->addIntrospectable(feature, i.value());
         }
     }
 
-    debug() << "ReadinessHelper: new supportedStatuses =" << mPriv->supportedStatuses;
-    debug() << "ReadinessHelper: new supportedFeatures =" << mPriv->supportedFeatures;
+    tpDebug() << "ReadinessHelper: new supportedStatuses =" << mPriv->supportedStatuses;
+    tpDebug() << "ReadinessHelper: new supportedFeatures =" <<
+        mPriv->supportedFeatures.toFeatures();
 }
 
 uint ReadinessHelper::currentStatus() const
@@ -500,17 +644,17 @@ void ReadinessHelper::setInterfaces(const QStringList &interfaces)
 
 Features ReadinessHelper::requestedFeatures() const
 {
-    return mPriv->requestedFeatures;
+    return mPriv->requestedFeatures.toFeatures();
 }
 
 Features ReadinessHelper::actualFeatures() const
 {
-    return mPriv->satisfiedFeatures;
+    return mPriv->satisfiedFeatures.toFeatures();
 }
 
 Features ReadinessHelper::missingFeatures() const
 {
-    return mPriv->missingFeatures;
+    return mPriv->missingFeatures.toFeatures();
 }
 
 bool ReadinessHelper::isReady(const Feature &feature,
@@ -604,10 +748,9 @@ PendingReady *ReadinessHelper::becomeReady(const Features &requestedFeatures)
         }
     }
 
-    Features supportedFeatures = mPriv->supportedFeatures;
-    if (supportedFeatures.intersect(requestedFeatures) != requestedFeatures) {
+    if (!mPriv->supportedFeatures.contains(FeatureSet(requestedFeatures))) {
         warning() << "ReadinessHelper::becomeReady called with invalid features: requestedFeatures =" <<
-            requestedFeatures << "- supportedFeatures =" << mPriv->supportedFeatures;
+            requestedFeatures << "- supportedFeatures =" << mPriv->supportedFeatures.toFeatures();
         PendingReady *operation = new PendingReady(SharedPtr<RefCounted>(mPriv->object),
                 requestedFeatures);
         operation->setFinishedWithError(
@@ -632,7 +775,7 @@ PendingReady *ReadinessHelper::becomeReady(const Features &requestedFeatures)
     }
 
     // Insert the dependencies of the requested features too
-    Features requestedWithDeps = requestedFeatures;
+    FeatureSet requestedWithDeps(requestedFeatures);
     foreach (const Feature &feature, requestedFeatures) {
         requestedWithDeps.unite(mPriv->depsFor(feature));
     }
@@ -645,7 +788,7 @@ PendingReady *ReadinessHelper::becomeReady(const Features &requestedFeatures)
     // Only we finish these PendingReadys, so we don't need destroyed or finished handling for them
     // - we already know when that happens, as we caused it!
 
-    QTimer::singleShot(0, this, SLOT(iterateIntrospection()));
+    mPriv->scheduleIteration(true);
 
     return operation;
 }
@@ -666,6 +809,81 @@ void ReadinessHelper::setIntrospectCompleted(const Feature &feature, bool succes
     setIntrospectCompleted(feature, success, error.name(), error.message());
 }
 
+/**
+ * Return how long the introspection of the given \a feature took, the last
+ * time it was introspected.
+ *
+ * \param feature The feature to query.
+ * \return The time spent introspecting \a feature in milliseconds, or -1 if it
+ *         hasn't been introspected yet.
+ */
+int ReadinessHelper::introspectionTime(const Feature &feature) const
+{
+    Private::Timing timing = mPriv->timings.value(feature);
+    if (timing.finished < 0) {
+        return -1;
+    }
+    return timing.finished - timing.started;
+}
+
+/**
+ * Return the chain of features which determined how long the introspection
+ * took.
+ *
+ * The chain ends with the feature which finished introspecting last, and each
+ * feature before it is the dependency of the next one which finished last.
+ * Speeding up the introspection of any other feature wouldn't make the object
+ * ready any sooner.
+ *
+ * \return The features on the critical path, dependencies first.
+ * \sa dumpTimings()
+ */
+QList<Feature> ReadinessHelper::criticalPath() const
+{
+    return mPriv->criticalPath();
+}
+
+/**
+ * Print the introspection timings of all features, followed by the critical
+ * path, as warnings.
+ *
+ * This is meant to be called explicitly while profiling, so the output does
+ * not depend on debug output being enabled with Tp::enableDebug().
+ *
+ * The times are in milliseconds since this object was created.
+ *
+ * \sa criticalPath(), introspectionTime()
+ */
+void ReadinessHelper::dumpTimings() const
+{
+    if (mPriv->proxy) {
+        warning() << "Introspection timings for" << mPriv->proxy->objectPath();
+    } else {
+        warning() << "Introspection timings for" << mPriv->object;
+    }
+    for (QHash<Feature, Private::Timing>::const_iterator i = mPriv->timings.constBegin();
+            i != mPriv->timings.constEnd(); ++i) {
+        if (i.value().finished < 0) {
+            warning().nospace() << "  " << i.key() << ": started at " << i.value().started <<
+                ", in flight";
+        } else {
+            warning().nospace() << "  " << i.key() << ": started at " << i.value().started <<
+                ", took " << (i.value().finished - i.value().started);
+        }
+    }
+
+    QList<Feature> path = mPriv->criticalPath();
+    warning() << "Critical path:";
+    int previousFinished = 0;
+    foreach (const Feature &feature, path) {
+        Private::Timing timing = mPriv->timings.value(feature);
+        warning().nospace() << "  " << feature << ": waited " <<
+            qMax(0, timing.started - previousFinished) << ", took " <<
+            (timing.finished - timing.started);
+        previousFinished = timing.finished;
+    }
+}
+
 void ReadinessHelper::iterateIntrospection()
 {
     mPriv->iterateIntrospection();
@@ -677,6 +895,7 @@ void ReadinessHelper::onProxyInvalidated(DBusProxy *proxy,
     // clear satisfied and missing features as we have public methods to get them
     mPriv->satisfiedFeatures.clear();
     mPriv->missingFeatures.clear();
+    mPriv->completedFeatures.clear();
 
     mPriv->abortOperations(errorName, errorMessage);
 }
@@ -110,6 +110,10 @@ public:
     void setIntrospectCompleted(const Feature &feature, bool success,
             const QDBusError &error);
 
+    int introspectionTime(const Feature &feature) const;
+    QList<Feature> criticalPath() const;
+    void dumpTimings() const;
+
 Q_SIGNALS:
     void statusReady(uint status);
 
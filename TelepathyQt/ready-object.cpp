@@ -153,6 +153,48 @@ Features ReadyObject::missingFeatures() const
     return mPriv->readinessHelper->missingFeatures();
 }
 
+/**
+ * Return how long the introspection of the given \a feature took, the last
+ * time it was introspected.
+ *
+ * \param feature The feature to query.
+ * \return The time spent introspecting \a feature in milliseconds, or -1 if it
+ *         hasn't been introspected yet.
+ * \sa introspectionCriticalPath()
+ */
+int ReadyObject::introspectionTime(const Feature &feature) const
+{
+    return mPriv->readinessHelper->introspectionTime(feature);
+}
+
+/**
+ * Return the chain of features which determined how long this object took to
+ * become ready.
+ *
+ * See ReadinessHelper::criticalPath() for details.
+ *
+ * \return The features on the critical path, dependencies first.
+ * \sa dumpIntrospectionTimings()
+ */
+QList<Feature> ReadyObject::introspectionCriticalPath() const
+{
+    return mPriv->readinessHelper->criticalPath();
+}
+
+/**
+ * Print the introspection timings of all the features of this object, followed
+ * by the critical path, as warnings.
+ *
+ * The output does not depend on debug output being enabled with
+ * Tp::enableDebug().
+ *
+ * \sa introspectionCriticalPath(), introspectionTime()
+ */
+void ReadyObject::dumpIntrospectionTimings() const
+{
+    mPriv->readinessHelper->dumpTimings();
+}
+
 ReadinessHelper *ReadyObject::readinessHelper() const
 {
     return mPriv->readinessHelper;
@@ -55,6 +55,10 @@ public:
     virtual Features actualFeatures() const;
     virtual Features missingFeatures() const;
 
+    int introspectionTime(const Feature &feature) const;
+    QList<Feature> introspectionCriticalPath() const;
+    void dumpIntrospectionTimings() const;
+
 protected:
     ReadinessHelper *readinessHelper() const;
 
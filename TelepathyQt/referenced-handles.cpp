@@ -63,7 +63,7 @@ struct TP_QT_NO_EXPORT ReferencedHandles::Private : public QSharedData
         if (!handles.isEmpty()) {
             ConnectionPtr conn(connection);
             if (!conn) {
-                debug() << "  Destroyed after Connection, so the Connection "
+                tpDebug() << "  Destroyed after Connection, so the Connection "
                     "has already released the handles";
                 return;
             }
@@ -79,7 +79,7 @@ struct TP_QT_NO_EXPORT ReferencedHandles::Private : public QSharedData
         if (!handles.isEmpty()) {
             ConnectionPtr conn(connection);
             if (!conn) {
-                debug() << "  Destroyed after Connection, so the Connection "
+                tpDebug() << "  Destroyed after Connection, so the Connection "
                     "has already released the handles";
                 return;
             }
@@ -221,7 +221,7 @@ void ServerAuthenticationChannel::gotCaptchaAuthenticationProperties(Tp::Pending
 
         mPriv->captchaAuthentication->mPriv->extractCaptchaAuthenticationProperties(pvm->result());
 
-        debug() << "Got reply to Properties::GetAll(CaptchaAuthentication)";
+        tpDebug() << "Got reply to Properties::GetAll(CaptchaAuthentication)";
         mPriv->readinessHelper->setIntrospectCompleted(ServerAuthenticationChannel::FeatureCore, true);
     } else {
         warning().nospace() << "Properties::GetAll(CaptchaAuthentication) failed "
@@ -236,7 +236,7 @@ void ServerAuthenticationChannel::gotServerAuthenticationProperties(Tp::PendingO
     if (!op->isError()) {
         PendingVariantMap *pvm = qobject_cast<PendingVariantMap *>(op);
 
-        debug() << "Got reply to Properties::GetAll(ServerAuthentication)";
+        tpDebug() << "Got reply to Properties::GetAll(ServerAuthentication)";
         mPriv->authMethod = qdbus_cast<QString>(pvm->result()[QLatin1String("AuthenticationMethod")]);
 
         if (mPriv->authMethod == TP_QT_IFACE_CHANNEL_INTERFACE_CAPTCHA_AUTHENTICATION) {
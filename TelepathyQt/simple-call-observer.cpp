@@ -65,7 +65,7 @@ SimpleCallObserver::Private::Private(SimpleCallObserver *parent,
       contactIdentifier(contactIdentifier),
       direction(direction)
 {
-    debug() << "Creating a new SimpleCallObserver";
+    tpDebug() << "Creating a new SimpleCallObserver";
     ChannelClassSpec channelFilterSMC = ChannelClassSpec::streamedMediaCall();
     ChannelClassSpec channelFilterCall = ChannelClassSpec::mediaCall();
     if (direction == CallDirectionIncoming) {
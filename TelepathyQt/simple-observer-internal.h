@@ -29,6 +29,8 @@
 #include <TelepathyQt/ClientRegistrar>
 #include <TelepathyQt/Types>
 
+#include "TelepathyQt/channel-class-matcher.h"
+
 namespace Tp
 {
 
@@ -153,6 +155,7 @@ public:
     void registerExtraChannelFeatures(const QList<ChannelClassFeatures> &features)
     {
         mExtraChannelFeatures.unite(features.toSet());
+        mFeaturesIndexDirty = true;
     }
 
     QSet<AccountPtr> accounts() const { return mAccounts; }
@@ -184,12 +187,15 @@ private Q_SLOTS:
     void onChannelsReady(Tp::PendingOperation *op);
 
 private:
-    Features featuresFor(const ChannelClassSpec &channelClass) const;
+    Features featuresFor(const QVariantMap &immutableProperties);
 
     WeakPtr<ClientRegistrar> mCr;
     SharedPtr<FakeAccountFactory> mFakeAccountFactory;
     QString mObserverName;
     QSet<ChannelClassFeatures> mExtraChannelFeatures;
+    QList<ChannelClassFeatures> mIndexedFeatures;
+    ChannelClassMatcher mFeaturesIndex;
+    bool mFeaturesIndexDirty;
     QSet<AccountPtr> mAccounts;
     QHash<ChannelPtr, ChannelWrapper*> mChannels;
     QHash<ChannelPtr, ChannelWrapper*> mIncompleteChannels;
@@ -84,10 +84,10 @@ SimpleObserver::Private::Private(SimpleObserver *parent,
             return;
         }
 
-        debug() << "Observer" << observerName << "registered";
+        tpDebug() << "Observer" << observerName << "registered";
         observers.insert(observerUniqueId, observer);
     } else {
-        debug() << "Observer" << observer->observerName() <<
+        tpDebug() << "Observer" << observer->observerName() <<
             "already registered and matches filter, using it";
         cr = ClientRegistrarPtr(observer->clientRegistrar());
     }
@@ -193,7 +193,8 @@ SimpleObserver::Private::Observer::Observer(const WeakPtr<ClientRegistrar> &cr,
       AbstractClientObserver(channelFilter, true),
       mCr(cr),
       mFakeAccountFactory(fakeAccountFactory),
-      mObserverName(observerName)
+      mObserverName(observerName),
+      mFeaturesIndexDirty(true)
 {
 }
 
@@ -241,7 +242,7 @@ void SimpleObserver::Private::Observer::observeChannels(
 
         SimpleObserver::Private::ChannelWrapper *wrapper =
             new SimpleObserver::Private::ChannelWrapper(account, channel,
-                featuresFor(ChannelClassSpec(channel->immutableProperties())), this);
+                featuresFor(channel->immutableProperties()), this);
         mIncompleteChannels.insert(channel, wrapper);
         connect(wrapper,
                 SIGNAL(channelInvalidated(Tp::AccountPtr,Tp::ChannelPtr,QString,QString)),
@@ -303,15 +304,22 @@ void SimpleObserver::Private::Observer::onChannelsReady(PendingOperation *op)
     delete info;
 }
 
-Features SimpleObserver::Private::Observer::featuresFor(
-        const ChannelClassSpec &channelClass) const
+Features SimpleObserver::Private::Observer::featuresFor(const QVariantMap &immutableProperties)
 {
+    if (mFeaturesIndexDirty) {
+        mIndexedFeatures = mExtraChannelFeatures.toList();
+        QList<ChannelClassSpec> specs;
+        foreach (const ChannelClassFeatures &spec, mIndexedFeatures) {
+            specs << spec.first;
+        }
+        mFeaturesIndex = ChannelClassMatcher(specs);
+        mFeaturesIndexDirty = false;
+    }
+
     Features features;
 
-    foreach (const ChannelClassFeatures &spec, mExtraChannelFeatures) {
-        if (spec.first.isSubsetOf(channelClass)) {
-            features.unite(spec.second);
-        }
+    foreach (int i, mFeaturesIndex.matchesChannel(immutableProperties)) {
+        features.unite(mIndexedFeatures.at(i).second);
     }
 
     return features;
@@ -477,7 +485,7 @@ SimpleObserver::SimpleObserver(const AccountPtr &account,
         }
 
         if (requiresNormalization) {
-            debug() << "Contact id requires normalization. "
+            tpDebug() << "Contact id requires normalization. "
                 "Queueing events until it is normalized";
             onAccountConnectionChanged(account->connection());
         }
@@ -561,7 +569,7 @@ void SimpleObserver::onAccountConnectionConnected()
         return;
     }
 
-    debug() << "Normalizing contact id" << mPriv->contactIdentifier;
+    tpDebug() << "Normalizing contact id" << mPriv->contactIdentifier;
     ContactManagerPtr contactManager = conn->contactManager();
     connect(contactManager->contactsForIdentifiers(QStringList() << mPriv->contactIdentifier),
             SIGNAL(finished(Tp::PendingOperation*)),
@@ -586,7 +594,7 @@ void SimpleObserver::onContactConstructed(Tp::PendingOperation *op)
     }
 
     ContactPtr contact = pc->contacts().first();
-    debug() << "Contact id" << mPriv->contactIdentifier <<
+    tpDebug() << "Contact id" << mPriv->contactIdentifier <<
         "normalized to" << contact->id();
     mPriv->normalizedContactIdentifier = contact->id();
     mPriv->processChannelsQueue();
@@ -94,7 +94,7 @@ SimpleStreamTubeHandler::SimpleStreamTubeHandler(
 SimpleStreamTubeHandler::~SimpleStreamTubeHandler()
 {
     if (!mTubes.empty()) {
-        debug() << "~SSTubeHandler(): Closing" << mTubes.size() << "leftover tubes";
+        tpDebug() << "~SSTubeHandler(): Closing" << mTubes.size() << "leftover tubes";
 
         foreach (const StreamTubeChannelPtr &tube, mTubes.keys()) {
             tube->requestClose();
@@ -111,7 +111,7 @@ void SimpleStreamTubeHandler::handleChannels(
         const QDateTime &userActionTime,
         const HandlerInfo &handlerInfo)
 {
-    debug() << "SimpleStreamTubeHandler::handleChannels() invoked for " <<
+    tpDebug() << "SimpleStreamTubeHandler::handleChannels() invoked for " <<
         channels.size() << "channels on account" << account->objectPath();
 
     SharedPtr<InvocationData> invocation(new InvocationData());
@@ -127,7 +127,7 @@ void SimpleStreamTubeHandler::handleChannels(
                 chan->immutableProperties()[TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")].toString();
 
             if (channelType != TP_QT_IFACE_CHANNEL_TYPE_STREAM_TUBE) {
-                debug() << "We got a non-StreamTube channel" << chan->objectPath() <<
+                tpDebug() << "We got a non-StreamTube channel" << chan->objectPath() <<
                     "of type" << channelType << ", ignoring";
             } else {
                 warning() << "The channel factory used for a simple StreamTube handler must" <<
@@ -202,12 +202,12 @@ void SimpleStreamTubeHandler::onReadyOpFinished(Tp::PendingOperation *op)
             continue;
         }
 
-        debug() << "Emitting SSTubeHandler::invokedForTube for" << invocation->tubes.size()
+        tpDebug() << "Emitting SSTubeHandler::invokedForTube for" << invocation->tubes.size()
             << "tubes";
 
         foreach (const StreamTubeChannelPtr &tube, invocation->tubes) {
             if (!tube->isValid()) {
-                debug() << "Skipping already invalidated tube" << tube->objectPath();
+                tpDebug() << "Skipping already invalidated tube" << tube->objectPath();
                 continue;
             }
 
@@ -238,7 +238,8 @@ void SimpleStreamTubeHandler::onTubeInvalidated(DBusProxy *proxy,
     Q_ASSERT(!tube.isNull());
     Q_ASSERT(mTubes.contains(tube));
 
-    debug() << "Tube" << tube->objectPath() << "invalidated - " << errorName << ':' << errorMessage;
+    tpDebug() << "Tube" << tube->objectPath() << "invalidated - " << errorName << ':' <<
+        errorMessage;
 
     AccountPtr acc = mTubes.value(tube);
     mTubes.remove(tube);
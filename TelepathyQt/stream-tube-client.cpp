@@ -221,7 +221,7 @@ struct TP_QT_NO_EXPORT StreamTubeClient::Private
             return;
         }
 
-        debug() << "Register StreamTubeClient with name " << clientName;
+        tpDebug() << "Register StreamTubeClient with name " << clientName;
 
         if (registrar->registerClient(handler, clientName)) {
             isRegistered = true;
@@ -265,7 +265,7 @@ StreamTubeClient::TubeWrapper::TubeWrapper(
                     !tube->supportsIPv4SocketsWithSpecifiedAddress()) ||
                 (hostAddress.protocol() == QAbstractSocket::IPv6Protocol &&
                  !tube->supportsIPv6SocketsWithSpecifiedAddress())) {
-            debug() << "StreamTubeClient falling back to Localhost AC for tube" <<
+            tpDebug() << "StreamTubeClient falling back to Localhost AC for tube" <<
                 tube->objectPath();
             mSourceAddress = sourceAddress.protocol() == QAbstractSocket::IPv4Protocol ?
                  QHostAddress::Any : QHostAddress::AnyIPv6;
@@ -292,7 +292,7 @@ StreamTubeClient::TubeWrapper::TubeWrapper(
     : QObject(parent), mAcc(acc), mTube(tube), mSourcePort(0)
 {
     if (requireCredentials && !tube->supportsUnixSocketsWithCredentials()) {
-        debug() << "StreamTubeClient falling back to Localhost AC for tube" << tube->objectPath();
+        tpDebug() << "StreamTubeClient falling back to Localhost AC for tube" << tube->objectPath();
         requireCredentials = false;
     }
 
@@ -813,7 +813,7 @@ void StreamTubeClient::onInvokedForTube(
     Q_ASSERT(tube->isValid()); // SSTH won't emit invalid tubes
 
     if (mPriv->tubes.contains(tube)) {
-        debug() << "Ignoring StreamTubeClient reinvocation for tube" << tube->objectPath();
+        tpDebug() << "Ignoring StreamTubeClient reinvocation for tube" << tube->objectPath();
         return;
     }
 
@@ -869,7 +869,7 @@ void StreamTubeClient::onAcceptFinished(TubeWrapper *wrapper, PendingStreamTubeC
     Q_ASSERT(conn != NULL);
 
     if (!mPriv->tubes.contains(wrapper->mTube)) {
-        debug() << "StreamTubeClient ignoring Accept result for invalidated tube"
+        tpDebug() << "StreamTubeClient ignoring Accept result for invalidated tube"
             << wrapper->mTube->objectPath();
         return;
     }
@@ -889,7 +889,7 @@ void StreamTubeClient::onAcceptFinished(TubeWrapper *wrapper, PendingStreamTubeC
         return;
     }
 
-    debug() << "StreamTubeClient accepted tube" << wrapper->mTube->objectPath();
+    tpDebug() << "StreamTubeClient accepted tube" << wrapper->mTube->objectPath();
 
     if (conn->addressType() == SocketAddressTypeIPv4
             || conn->addressType() == SocketAddressTypeIPv6) {
@@ -914,7 +914,7 @@ void StreamTubeClient::onTubeInvalidated(Tp::DBusProxy *proxy, const QString &er
         return;
     }
 
-    debug() << "Client StreamTube" << tube->objectPath() << "invalidated - " << error << ':'
+    tpDebug() << "Client StreamTube" << tube->objectPath() << "invalidated - " << error << ':'
         << message;
 
     emit tubeClosed(wrapper->mAcc, wrapper->mTube, error, message);
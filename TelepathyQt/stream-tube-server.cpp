@@ -317,7 +317,7 @@ struct StreamTubeServer::Private
             return;
         }
 
-        debug() << "Register StreamTubeServer with name " << clientName;
+        tpDebug() << "Register StreamTubeServer with name " << clientName;
 
         if (registrar->registerClient(handler, clientName)) {
             isRegistered = true;
@@ -943,8 +943,8 @@ void StreamTubeServer::onInvokedForTube(
     }
 
     if (!mPriv->tubes.contains(tube)) {
-        debug().nospace() << "Offering socket " << mPriv->exportedAddr << ":" << mPriv->exportedPort
-            << " on tube " << tube->objectPath();
+        tpDebug().nospace() << "Offering socket " << mPriv->exportedAddr << ":" <<
+            mPriv->exportedPort << " on tube " << tube->objectPath();
 
         QVariantMap params;
         if (mPriv->generator) {
@@ -995,7 +995,7 @@ void StreamTubeServer::onOfferFinished(
         mPriv->tubes.remove(wrapper->mTube);
         wrapper->deleteLater();
     } else {
-        debug() << "Tube" << tube->objectPath() << "offered successfully";
+        tpDebug() << "Tube" << tube->objectPath() << "offered successfully";
     }
 }
 
@@ -1013,7 +1013,7 @@ void StreamTubeServer::onTubeInvalidated(
         return;
     }
 
-    debug() << "Tube" << tube->objectPath() << "invalidated with" << error << ':' << message;
+    tpDebug() << "Tube" << tube->objectPath() << "invalidated with" << error << ':' << message;
 
     emit tubeClosed(wrapper->mAcc, wrapper->mTube, error, message);
     mPriv->tubes.remove(tube);
@@ -143,7 +143,7 @@ void PendingStreamedMediaStreams::gotStreams(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to StreamedMedia::RequestStreams()";
+    tpDebug() << "Got reply to StreamedMedia::RequestStreams()";
 
     MediaStreamInfoList list = reply.value();
     foreach (const MediaStreamInfo &streamInfo, list) {
@@ -194,11 +194,11 @@ void PendingStreamedMediaStreams::onStreamReady(PendingOperation *op)
     }
 
     mPriv->streamsReady++;
-    debug() << "PendingStreamedMediaStreams:";
-    debug() << "  Streams count:" << mPriv->numStreams;
-    debug() << "  Streams ready:" << mPriv->streamsReady;
+    tpDebug() << "PendingStreamedMediaStreams:";
+    tpDebug() << "  Streams count:" << mPriv->numStreams;
+    tpDebug() << "  Streams ready:" << mPriv->streamsReady;
     if (mPriv->streamsReady == mPriv->numStreams) {
-        debug() << "All streams are ready";
+        tpDebug() << "All streams are ready";
         setFinished();
     }
 }
@@ -256,17 +256,17 @@ StreamedMediaStream::Private::Private(StreamedMediaStream *parent,
 
 void StreamedMediaStream::Private::introspectContact(StreamedMediaStream::Private *self)
 {
-    debug() << "Introspecting stream";
+    tpDebug() << "Introspecting stream";
     if (self->contactHandle == 0) {
-        debug() << "Stream ready";
+        tpDebug() << "Stream ready";
         self->readinessHelper->setIntrospectCompleted(FeatureCore, true);
         return;
     }
 
-    debug() << "Introspecting stream contact";
+    tpDebug() << "Introspecting stream contact";
     ContactManagerPtr contactManager =
         self->parent->channel()->connection()->contactManager();
-    debug() << "contact manager" << contactManager;
+    tpDebug() << "contact manager" << contactManager;
     // TODO: pass id hints to ContactManager if we ever gain support to retrieve contact ids
     //       from MediaStreamInfo or something similar.
     self->parent->connect(contactManager->contactsForHandles(
@@ -693,8 +693,8 @@ void StreamedMediaStream::gotContact(PendingOperation *op)
         Q_ASSERT(invalidHandles.size() == 0);
         mPriv->contact = contacts.first();
 
-        debug() << "Got stream contact";
-        debug() << "Stream ready";
+        tpDebug() << "Got stream contact";
+        tpDebug() << "Stream ready";
         mPriv->readinessHelper->setIntrospectCompleted(FeatureCore, true);
     } else {
         Q_ASSERT(invalidHandles.size() == 1);
@@ -1334,7 +1334,7 @@ void StreamedMediaChannel::gotStreams(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to StreamedMedia::ListStreams()";
+    tpDebug() << "Got reply to StreamedMedia::ListStreams()";
 
     MediaStreamInfoList streamInfoList = reply.value();
     if (streamInfoList.size() > 0) {
@@ -1361,7 +1361,7 @@ void StreamedMediaChannel::onStreamAdded(uint streamId,
         uint contactHandle, uint streamType)
 {
     if (lookupStreamById(streamId)) {
-        debug() << "Received StreamedMedia.StreamAdded for an existing "
+        tpDebug() << "Received StreamedMedia.StreamAdded for an existing "
             "stream, ignoring";
         return;
     }
@@ -1379,7 +1379,7 @@ void StreamedMediaChannel::onStreamAdded(uint streamId,
 
 void StreamedMediaChannel::onStreamRemoved(uint streamId)
 {
-    debug() << "Received StreamedMedia.StreamRemoved for stream" <<
+    tpDebug() << "Received StreamedMedia.StreamRemoved for stream" <<
         streamId;
 
     StreamedMediaStreamPtr stream = lookupStreamById(streamId);
@@ -1408,7 +1408,7 @@ void StreamedMediaChannel::onStreamRemoved(uint streamId)
 void StreamedMediaChannel::onStreamDirectionChanged(uint streamId,
         uint streamDirection, uint streamPendingFlags)
 {
-    debug() << "Received StreamedMedia.StreamDirectionChanged for stream" <<
+    tpDebug() << "Received StreamedMedia.StreamDirectionChanged for stream" <<
         streamId << "with direction changed to" << streamDirection;
 
     StreamedMediaStreamPtr stream = lookupStreamById(streamId);
@@ -1432,7 +1432,7 @@ void StreamedMediaChannel::onStreamDirectionChanged(uint streamId,
 void StreamedMediaChannel::onStreamStateChanged(uint streamId,
         uint streamState)
 {
-    debug() << "Received StreamedMedia.StreamStateChanged for stream" <<
+    tpDebug() << "Received StreamedMedia.StreamStateChanged for stream" <<
         streamId << "with state changed to" << streamState;
 
     StreamedMediaStreamPtr stream = lookupStreamById(streamId);
@@ -1452,7 +1452,7 @@ void StreamedMediaChannel::onStreamStateChanged(uint streamId,
 void StreamedMediaChannel::onStreamError(uint streamId,
         uint errorCode, const QString &errorMessage)
 {
-    debug() << "Received StreamedMedia.StreamError for stream" <<
+    tpDebug() << "Received StreamedMedia.StreamError for stream" <<
         streamId << "with error code" << errorCode <<
         "and message:" << errorMessage;
 
@@ -1472,7 +1472,7 @@ void StreamedMediaChannel::gotLocalHoldState(QDBusPendingCallWatcher *watcher)
             " failed with " << reply.error().name() << ": " <<
             reply.error().message();
 
-        debug() << "Ignoring error getting hold state and assuming we're not "
+        tpDebug() << "Ignoring error getting hold state and assuming we're not "
             "on hold";
         onLocalHoldStateChanged(mPriv->localHoldState,
                 mPriv->localHoldStateReason);
@@ -1480,7 +1480,7 @@ void StreamedMediaChannel::gotLocalHoldState(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Got reply to StreamedMedia::Hold::GetHoldState()";
+    tpDebug() << "Got reply to StreamedMedia::Hold::GetHoldState()";
     onLocalHoldStateChanged(reply.argumentAt<0>(), reply.argumentAt<1>());
     watcher->deleteLater();
 }
@@ -37,12 +37,17 @@
 #include <TelepathyQt/ReferencedHandles>
 
 #include <QDateTime>
+#include <QMap>
+
+#include <algorithm>
 
 namespace Tp
 {
 
 struct TP_QT_NO_EXPORT TextChannel::Private
 {
+    struct MessageEvent;
+
     Private(TextChannel *parent);
     ~Private();
 
@@ -55,8 +60,14 @@ struct TP_QT_NO_EXPORT TextChannel::Private
     void updateCapabilities();
 
     void processMessageQueue();
+    void processMessageQueueIncrementally();
     void processChatStateQueue();
 
+    void queueMessageEvent(MessageEvent *e);
+    void appendMessage(const ReceivedMessage &message);
+    void removeMessages(uint pendingId);
+    bool removeMessage(const ReceivedMessage &message);
+
     void contactLost(uint handle);
     void contactFound(ContactPtr contact);
 
@@ -95,8 +106,24 @@ struct TP_QT_NO_EXPORT TextChannel::Private
         ReceivedMessage message;
         uint removed;
     };
-    QList<ReceivedMessage> messages;
+    // Received messages, in the order they were received, indexed by pending message ID. IDs
+    // are not necessarily unique, so several messages may share the same ID
+    QMap<quint64, ReceivedMessage> messages;
+    QMultiHash<uint, quint64> messagesByPendingId;
+    quint64 nextMessageSerial;
+    mutable QList<ReceivedMessage> messageQueueCache;
+    mutable bool messageQueueCacheValid;
+
     QList<MessageEvent *> incompleteMessages;
+    // The events of incompleteMessages whose sender Contact hasn't been retrieved yet, by sender
+    // handle
+    QMultiHash<uint, MessageEvent *> messagesAwaitingSender;
+    // Number of events at the end of incompleteMessages not yet looked at
+    int unprocessedMessageEvents;
+    bool incrementalMessageDelivery;
+    bool messageContactsChanged;
+    // Pending message IDs of the events held back in incremental delivery mode
+    QSet<uint> heldMessageIds;
     QHash<QDBusPendingCallWatcher *, UIntList> acknowledgeBatches;
 
     // FeatureChatState
@@ -125,7 +152,12 @@ TextChannel::Private::Private(TextChannel *parent)
       gotProperties(false),
       messagePartSupport(0),
       deliveryReportingSupport(0),
-      initialMessagesReceived(false)
+      initialMessagesReceived(false),
+      nextMessageSerial(0),
+      messageQueueCacheValid(true),
+      unprocessedMessageEvents(0),
+      incrementalMessageDelivery(false),
+      messageContactsChanged(false)
 {
     ReadinessHelper::Introspectables introspectables;
 
@@ -301,7 +333,7 @@ void TextChannel::Private::updateInitialMessages()
     MessagePartListList messages = qdbus_cast<MessagePartListList>(
             props[QLatin1String("PendingMessages")]);
     if (messages.isEmpty()) {
-        debug() << "Message queue empty: FeatureMessageQueue is now ready";
+        tpDebug() << "Message queue empty: FeatureMessageQueue is now ready";
         readinessHelper->setIntrospectCompleted(FeatureMessageQueue, true);
     } else {
         foreach (const MessagePartList &message, messages) {
@@ -344,46 +376,44 @@ void TextChannel::Private::processMessageQueue()
     // and message-removal events; message IDs aren't necessarily globally
     // unique, so we need to process them in the correct order relative
     // to incoming messages
-    while (!incompleteMessages.isEmpty()) {
-        const MessageEvent *e = incompleteMessages.first();
-        debug() << "MessageEvent:" << reinterpret_cast<const void *>(e);
+    if (incrementalMessageDelivery) {
+        processMessageQueueIncrementally();
+    } else {
+        while (!incompleteMessages.isEmpty()) {
+            const MessageEvent *e = incompleteMessages.first();
+            TP_QT_DEBUG(DebugCategoryMessages) <<
+                "MessageEvent:" << reinterpret_cast<const void *>(e);
+
+            if (e->isMessage) {
+                if (e->message.senderHandle() != 0 &&
+                        !e->message.sender()) {
+                    // the message doesn't have a sender Contact, but needs one.
+                    // We'll have to stop processing here, and come back to it
+                    // when we have more Contact objects
+                    break;
+                }
 
-        if (e->isMessage) {
-            if (e->message.senderHandle() != 0 &&
-                    !e->message.sender()) {
-                // the message doesn't have a sender Contact, but needs one.
-                // We'll have to stop processing here, and come back to it
-                // when we have more Contact objects
-                break;
+                // if we reach here, the message is ready
+                TP_QT_DEBUG(DebugCategoryMessages) << "Message is usable, copying to main queue";
+                appendMessage(e->message);
+                emit parent->messageReceived(e->message);
+            } else {
+                // forget about the message(s) with ID e->removed (there should be
+                // at most one under normal circumstances)
+                removeMessages(e->removed);
             }
 
-            // if we reach here, the message is ready
-            debug() << "Message is usable, copying to main queue";
-            messages << e->message;
-            emit parent->messageReceived(e->message);
-        } else {
-            // forget about the message(s) with ID e->removed (there should be
-            // at most one under normal circumstances)
-            int i = 0;
-            while (i < messages.size()) {
-                if (messages.at(i).pendingId() == e->removed) {
-                    ReceivedMessage removedMessage = messages.at(i);
-                    messages.removeAt(i);
-                    emit parent->pendingMessageRemoved(removedMessage);
-                } else {
-                    i++;
-                }
-            }
+            TP_QT_DEBUG(DebugCategoryMessages) << "Dropping first event";
+            delete incompleteMessages.takeFirst();
         }
-
-        debug() << "Dropping first event";
-        delete incompleteMessages.takeFirst();
     }
+    messageContactsChanged = false;
 
     if (incompleteMessages.isEmpty()) {
+        unprocessedMessageEvents = 0;
         if (readinessHelper->requestedFeatures().contains(FeatureMessageQueue) &&
             !readinessHelper->isReady(Features() << FeatureMessageQueue)) {
-            debug() << "incompleteMessages empty for the first time: "
+            TP_QT_DEBUG(DebugCategoryMessages) << "incompleteMessages empty for the first time: "
                 "FeatureMessageQueue is now ready";
             readinessHelper->setIntrospectCompleted(FeatureMessageQueue, true);
         }
@@ -391,9 +421,14 @@ void TextChannel::Private::processMessageQueue()
     }
 
     // What Contact objects do we need in order to proceed, ignoring those
-    // for which we've already sent a request?
+    // for which we've already sent a request? The events which were already in the queue the
+    // last time we got here have had their contacts requested already, so only look at the
+    // new ones
     HandleIdentifierMap contactsRequired;
-    foreach (const MessageEvent *e, incompleteMessages) {
+    int first = qMax(0, incompleteMessages.size() - unprocessedMessageEvents);
+    unprocessedMessageEvents = 0;
+    for (int i = first; i < incompleteMessages.size(); ++i) {
+        const MessageEvent *e = incompleteMessages.at(i);
         if (e->isMessage) {
             uint handle = e->message.senderHandle();
             if (handle != 0 && !e->message.sender()
@@ -418,11 +453,122 @@ void TextChannel::Private::processMessageQueue()
     awaitingContacts |= contactsRequired.keys().toSet();
 }
 
+void TextChannel::Private::processMessageQueueIncrementally()
+{
+    // Deliver every message whose sender is known, holding back only those still waiting for
+    // their sender, along with anything later in the queue using the same pending message ID.
+    // Unless new contacts arrived, the events already held back are still blocked, so only the
+    // new events need to be looked at.
+    int first = 0;
+    if (messageContactsChanged) {
+        heldMessageIds.clear();
+    } else {
+        first = qMax(0, incompleteMessages.size() - unprocessedMessageEvents);
+    }
+
+    int kept = first;
+    int keptNew = 0;
+    for (int i = first; i < incompleteMessages.size(); ++i) {
+        MessageEvent *e = incompleteMessages.at(i);
+        bool isNew = (i >= incompleteMessages.size() - unprocessedMessageEvents);
+
+        if (e->isMessage) {
+            uint pendingId = e->message.pendingId();
+            if ((e->message.senderHandle() != 0 && !e->message.sender()) ||
+                    heldMessageIds.contains(pendingId)) {
+                heldMessageIds.insert(pendingId);
+                incompleteMessages[kept++] = e;
+                if (isNew) {
+                    keptNew++;
+                }
+                continue;
+            }
+
+            TP_QT_DEBUG(DebugCategoryMessages) << "Message is usable, copying to main queue";
+            appendMessage(e->message);
+            emit parent->messageReceived(e->message);
+        } else {
+            if (heldMessageIds.contains(e->removed)) {
+                // the message being removed is still held back
+                incompleteMessages[kept++] = e;
+                if (isNew) {
+                    keptNew++;
+                }
+                continue;
+            }
+
+            removeMessages(e->removed);
+        }
+
+        delete e;
+    }
+
+    incompleteMessages.erase(incompleteMessages.begin() + kept, incompleteMessages.end());
+    if (incompleteMessages.isEmpty()) {
+        heldMessageIds.clear();
+    }
+
+    // the held back new events still need their contacts to be requested
+    unprocessedMessageEvents = messageContactsChanged ? incompleteMessages.size() : keptNew;
+}
+
+void TextChannel::Private::queueMessageEvent(MessageEvent *e)
+{
+    incompleteMessages << e;
+    if (e->isMessage && e->message.senderHandle() != 0 && !e->message.sender()) {
+        messagesAwaitingSender.insert(e->message.senderHandle(), e);
+    }
+    unprocessedMessageEvents++;
+}
+
+void TextChannel::Private::appendMessage(const ReceivedMessage &message)
+{
+    quint64 serial = nextMessageSerial++;
+    messages.insert(serial, message);
+    messagesByPendingId.insert(message.pendingId(), serial);
+    messageQueueCacheValid = false;
+}
+
+void TextChannel::Private::removeMessages(uint pendingId)
+{
+    QList<quint64> serials = messagesByPendingId.values(pendingId);
+    if (serials.isEmpty()) {
+        return;
+    }
+
+    messagesByPendingId.remove(pendingId);
+    messageQueueCacheValid = false;
+
+    // QMultiHash::values() returns the most recently inserted first
+    std::sort(serials.begin(), serials.end());
+    foreach (quint64 serial, serials) {
+        ReceivedMessage removedMessage = messages.take(serial);
+        emit parent->pendingMessageRemoved(removedMessage);
+    }
+}
+
+bool TextChannel::Private::removeMessage(const ReceivedMessage &message)
+{
+    uint pendingId = message.pendingId();
+    QList<quint64> serials = messagesByPendingId.values(pendingId);
+    std::sort(serials.begin(), serials.end());
+    foreach (quint64 serial, serials) {
+        if (messages.value(serial) == message) {
+            messages.remove(serial);
+            messagesByPendingId.remove(pendingId, serial);
+            messageQueueCacheValid = false;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void TextChannel::Private::processChatStateQueue()
 {
     while (!chatStateQueue.isEmpty()) {
         const ChatStateEvent *e = chatStateQueue.first();
-        debug() << "ChatStateEvent:" << reinterpret_cast<const void *>(e);
+        tpDebug() << "ChatStateEvent:" << reinterpret_cast<const void *>(e);
 
         if (e->contact.isNull()) {
             // the chat state Contact object wasn't retrieved yet, but needs
@@ -436,7 +582,7 @@ void TextChannel::Private::processChatStateQueue()
         // if we reach here, the Contact object is ready
         emit parent->chatStateChanged(e->contact, (ChannelChatState) e->state);
 
-        debug() << "Dropping first event";
+        tpDebug() << "Dropping first event";
         delete chatStateQueue.takeFirst();
     }
 
@@ -468,12 +614,10 @@ void TextChannel::Private::contactLost(uint handle)
 {
     // we're not going to get a Contact object for this handle, so mark the
     // messages from that handle as "unknown sender"
-    foreach (MessageEvent *e, incompleteMessages) {
-        if (e->isMessage && e->message.senderHandle() == handle
-                && !e->message.sender()) {
-            e->message.clearSenderHandle();
-        }
+    foreach (MessageEvent *e, messagesAwaitingSender.values(handle)) {
+        e->message.clearSenderHandle();
     }
+    messagesAwaitingSender.remove(handle);
 
     // there is no point in sending chat state notifications for unknown
     // contacts, removing chat state events from queue that refer to this handle
@@ -489,12 +633,10 @@ void TextChannel::Private::contactFound(ContactPtr contact)
 {
     uint handle = contact->handle().at(0);
 
-    foreach (MessageEvent *e, incompleteMessages) {
-        if (e->isMessage && e->message.senderHandle() == handle
-                && !e->message.sender()) {
-            e->message.setSender(contact);
-        }
+    foreach (MessageEvent *e, messagesAwaitingSender.values(handle)) {
+        e->message.setSender(contact);
     }
+    messagesAwaitingSender.remove(handle);
 
     foreach (ChatStateEvent *e, chatStateQueue) {
         if (e->contactHandle == handle) {
@@ -825,7 +967,57 @@ DeliveryReportingSupportFlags TextChannel::deliveryReportingSupport() const
  */
 QList<ReceivedMessage> TextChannel::messageQueue() const
 {
-    return mPriv->messages;
+    if (!mPriv->messageQueueCacheValid) {
+        mPriv->messageQueueCache = mPriv->messages.values();
+        mPriv->messageQueueCacheValid = true;
+    }
+
+    return mPriv->messageQueueCache;
+}
+
+/**
+ * Return whether received messages are delivered as soon as their own sender is known.
+ *
+ * \return \c true if incremental delivery is enabled, \c false otherwise.
+ * \sa setIncrementalMessageDeliveryEnabled()
+ */
+bool TextChannel::isIncrementalMessageDeliveryEnabled() const
+{
+    return mPriv->incrementalMessageDelivery;
+}
+
+/**
+ * Set whether received messages should be delivered as soon as their own sender is known.
+ *
+ * By default, the relative ordering of all the messages in the channel is preserved: a
+ * message whose sender Contact object is still being retrieved holds back every message
+ * received after it.
+ *
+ * With incremental delivery enabled, only the messages from senders still being retrieved
+ * (and any later event referring to the same pending message ID) are held back, and the
+ * others are added to messageQueue() and signalled with messageReceived() right away. Messages
+ * from the same sender are still delivered in the order they were received.
+ *
+ * This is mostly useful for busy group chats, where many different senders may need to be
+ * retrieved at the same time.
+ *
+ * \param enabled Whether to enable incremental delivery.
+ * \sa messageQueue(), messageReceived()
+ */
+void TextChannel::setIncrementalMessageDeliveryEnabled(bool enabled)
+{
+    if (mPriv->incrementalMessageDelivery == enabled) {
+        return;
+    }
+
+    mPriv->incrementalMessageDelivery = enabled;
+    // the events held back need to be looked at again
+    mPriv->heldMessageIds.clear();
+    mPriv->messageContactsChanged = true;
+    if (mPriv->initialMessagesReceived) {
+        // before that, processing the (empty) queue would make FeatureMessageQueue ready too early
+        mPriv->processMessageQueue();
+    }
 }
 
 /**
@@ -861,7 +1053,7 @@ void TextChannel::onAcknowledgePendingMessagesReply(
     if (reply.isError()) {
         // One of the IDs was bad, and we can't know which one. Recover by
         // doing as much as possible, and hope for the best...
-        debug() << "Recovering from AcknowledgePendingMessages failure for: "
+        tpDebug() << "Recovering from AcknowledgePendingMessages failure for: "
             << ids;
         foreach (uint id, ids) {
             mPriv->textInterface->AcknowledgePendingMessages(UIntList() << id);
@@ -936,7 +1128,7 @@ void TextChannel::forget(const QList<ReceivedMessage> &messages)
     foreach (const ReceivedMessage &m, messages) {
         if (!m.isFromChannel(TextChannelPtr(this))) {
             warning() << "message did not come from this channel, ignoring";
-        } else if (mPriv->messages.removeOne(m)) {
+        } else if (mPriv->removeMessage(m)) {
             emit pendingMessageRemoved(m);
         }
     }
@@ -1098,6 +1290,7 @@ void TextChannel::onContactsFinished(PendingOperation *op)
 
     // all contacts for messages and chat state events we were asking about
     // should now be ready
+    mPriv->messageContactsChanged = true;
     mPriv->processMessageQueue();
     mPriv->processChatStateQueue();
 }
@@ -1108,8 +1301,8 @@ void TextChannel::onMessageReceived(const MessagePartList &parts)
         return;
     }
 
-    mPriv->incompleteMessages << new Private::MessageEvent(
-            ReceivedMessage(parts, TextChannelPtr(this)));
+    mPriv->queueMessageEvent(new Private::MessageEvent(
+            ReceivedMessage(parts, TextChannelPtr(this))));
     mPriv->processMessageQueue();
 }
 
@@ -1119,7 +1312,7 @@ void TextChannel::onPendingMessagesRemoved(const UIntList &ids)
         return;
     }
     foreach (uint id, ids) {
-        mPriv->incompleteMessages << new Private::MessageEvent(id);
+        mPriv->queueMessageEvent(new Private::MessageEvent(id));
     }
     mPriv->processMessageQueue();
 }
@@ -1177,7 +1370,7 @@ void TextChannel::onTextReceived(uint id, uint timestamp, uint sender,
         m.setForceNonText();
     }
 
-    mPriv->incompleteMessages << new Private::MessageEvent(m);
+    mPriv->queueMessageEvent(new Private::MessageEvent(m));
     mPriv->processMessageQueue();
 }
 
@@ -1268,7 +1461,7 @@ void TextChannel::gotProperties(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Properties::GetAll(Channel.Interface.Messages) returned";
+    tpDebug() << "Properties::GetAll(Channel.Interface.Messages) returned";
     mPriv->props = reply.value();
 
     mPriv->updateInitialMessages();
@@ -1293,7 +1486,7 @@ void TextChannel::gotPendingMessages(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    debug() << "Text::ListPendingMessages returned";
+    tpDebug() << "Text::ListPendingMessages returned";
     PendingTextMessageList list = reply.value();
 
     if (!list.isEmpty()) {
@@ -68,6 +68,9 @@ public:
     // requires FeatureMessageQueue
     QList<ReceivedMessage> messageQueue() const;
 
+    bool isIncrementalMessageDeliveryEnabled() const;
+    void setIncrementalMessageDeliveryEnabled(bool enabled);
+
     // requires FeatureChatState
     ChannelChatState chatState(const ContactPtr &contact) const;
 
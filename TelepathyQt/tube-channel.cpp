@@ -70,7 +70,7 @@ void TubeChannel::Private::introspectTube(TubeChannel::Private *self)
 {
     TubeChannel *parent = self->parent;
 
-    debug() << "Introspecting tube properties";
+    tpDebug() << "Introspecting tube properties";
     Client::ChannelInterfaceTubeInterface *tubeInterface =
             parent->interface<Client::ChannelInterfaceTubeInterface>();
 
@@ -215,7 +215,7 @@ void TubeChannel::onTubeChannelStateChanged(uint newState)
 
     uint oldState = mPriv->state;
 
-    debug() << "Tube state changed to" << newState;
+    tpDebug() << "Tube state changed to" << newState;
     mPriv->state = (Tp::TubeChannelState) newState;
 
     /* only emit stateChanged if we already received the state from initial introspection */
@@ -231,7 +231,7 @@ void TubeChannel::gotTubeProperties(PendingOperation *op)
 
         mPriv->extractTubeProperties(pvm->result());
 
-        debug() << "Got reply to Properties::GetAll(TubeChannel)";
+        tpDebug() << "Got reply to Properties::GetAll(TubeChannel)";
         mPriv->readinessHelper->setIntrospectCompleted(TubeChannel::FeatureCore, true);
     } else {
         warning().nospace() << "Properties::GetAll(TubeChannel) failed "
@@ -0,0 +1,234 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/avatar-cache.h"
+
+#include <TelepathyQt/Utils>
+
+using namespace Tp;
+
+class TestAvatarCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testInsertLookup();
+    void testRemovedFile();
+    void testMigration();
+    void testEviction();
+    void testLookupDoesNotRewriteIndex();
+
+    void cleanup();
+
+private:
+    void writeFile(const QString &fileName, const QByteArray &data);
+    void removeDir();
+
+    QString mDir;
+};
+
+void TestAvatarCache::writeFile(const QString &fileName, const QByteArray &data)
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write(data);
+    file.close();
+}
+
+void TestAvatarCache::removeDir()
+{
+    QDir dir(mDir);
+    foreach (const QString &name, dir.entryList(QDir::Files | QDir::Hidden)) {
+        dir.remove(name);
+    }
+    QDir().rmdir(mDir);
+}
+
+void TestAvatarCache::init()
+{
+    mDir = QDir::tempPath() + QString(QLatin1String("/avatar-cache-%1"))
+        .arg(QCoreApplication::applicationPid());
+    removeDir();
+}
+
+void TestAvatarCache::testInsertLookup()
+{
+    QString fileName;
+    QString mimeType;
+
+    AvatarCache *cache = new AvatarCache(mDir);
+    QCOMPARE(cache->count(), 0);
+    QVERIFY(!cache->lookup(QLatin1String("token-1"), fileName, mimeType));
+
+    QVERIFY(cache->insert(QLatin1String("token-1"), QByteArray("avatar"),
+                QLatin1String("image/png"), fileName));
+    QCOMPARE(fileName, mDir + QLatin1Char('/') + escapeAsIdentifier(QLatin1String("token-1")));
+    QVERIFY(QFile::exists(fileName));
+    QVERIFY(QFile::exists(fileName + QLatin1String(".mime")));
+    QCOMPARE(cache->count(), 1);
+    QCOMPARE(cache->size(), static_cast<qint64>(6));
+
+    fileName.clear();
+    QVERIFY(cache->lookup(QLatin1String("token-1"), fileName, mimeType));
+    QCOMPARE(mimeType, QLatin1String("image/png"));
+
+    QVERIFY(cache->isModified());
+    QVERIFY(cache->sync());
+    QVERIFY(!cache->isModified());
+    delete cache;
+
+    // the index is used when available
+    QFile::remove(fileName + QLatin1String(".mime"));
+    cache = new AvatarCache(mDir);
+    QCOMPARE(cache->count(), 1);
+    mimeType.clear();
+    QVERIFY(cache->lookup(QLatin1String("token-1"), fileName, mimeType));
+    QCOMPARE(mimeType, QLatin1String("image/png"));
+    delete cache;
+}
+
+void TestAvatarCache::testRemovedFile()
+{
+    QString fileName;
+    QString mimeType;
+
+    AvatarCache *writer = new AvatarCache(mDir);
+    QVERIFY(writer->insert(QLatin1String("token-1"), QByteArray("avatar"),
+                QLatin1String("image/png"), fileName));
+    QVERIFY(writer->insert(QLatin1String("token-2"), QByteArray("other"),
+                QLatin1String("image/png"), fileName));
+    QCOMPARE(writer->count(), 2);
+    QVERIFY(writer->sync());
+    delete writer;
+
+    // an avatar removed behind the cache's back is not handed out, and its entry is dropped
+    AvatarCache cache(mDir);
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(QFile::remove(fileName));
+    QVERIFY(!cache.lookup(QLatin1String("token-2"), fileName, mimeType));
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.size(), static_cast<qint64>(6));
+    QVERIFY(cache.isModified());
+    QVERIFY(cache.lookup(QLatin1String("token-1"), fileName, mimeType));
+
+    // and it can be inserted again
+    QVERIFY(cache.insert(QLatin1String("token-2"), QByteArray("other"),
+                QLatin1String("image/png"), fileName));
+    QVERIFY(QFile::exists(fileName));
+    QVERIFY(cache.lookup(QLatin1String("token-2"), fileName, mimeType));
+    QCOMPARE(cache.count(), 2);
+}
+
+void TestAvatarCache::testMigration()
+{
+    // avatars stored by older versions, one file per token plus a file with the MIME type
+    QVERIFY(QDir().mkpath(mDir));
+    QString base = mDir + QLatin1Char('/');
+    writeFile(base + escapeAsIdentifier(QLatin1String("old-1")), QByteArray("first"));
+    writeFile(base + escapeAsIdentifier(QLatin1String("old-1")) + QLatin1String(".mime"),
+            QByteArray("image/jpeg"));
+    writeFile(base + escapeAsIdentifier(QLatin1String("old-2")), QByteArray("second"));
+    writeFile(base + escapeAsIdentifier(QLatin1String("old-2")) + QLatin1String(".mime"),
+            QByteArray("image/png"));
+    // incomplete entry, ignored
+    writeFile(base + escapeAsIdentifier(QLatin1String("old-3")), QByteArray("third"));
+
+    AvatarCache cache(mDir);
+    QCOMPARE(cache.count(), 2);
+    QCOMPARE(cache.size(), static_cast<qint64>(11));
+
+    QString fileName;
+    QString mimeType;
+    QVERIFY(cache.lookup(QLatin1String("old-1"), fileName, mimeType));
+    QCOMPARE(mimeType, QLatin1String("image/jpeg"));
+    QVERIFY(cache.lookup(QLatin1String("old-2"), fileName, mimeType));
+    QCOMPARE(mimeType, QLatin1String("image/png"));
+    QVERIFY(!cache.lookup(QLatin1String("old-3"), fileName, mimeType));
+}
+
+void TestAvatarCache::testEviction()
+{
+    // an avatar stored by another client, which is never evicted
+    QVERIFY(QDir().mkpath(mDir));
+    QString foreignFileName = mDir + QLatin1Char('/') +
+        escapeAsIdentifier(QLatin1String("foreign"));
+    writeFile(foreignFileName, QByteArray(4, 'f'));
+    writeFile(foreignFileName + QLatin1String(".mime"), QByteArray("image/png"));
+
+    AvatarCache cache(mDir);
+    cache.setSizeLimit(10);
+
+    QString fileName1, fileName2, fileName3;
+    QVERIFY(cache.insert(QLatin1String("token-1"), QByteArray(4, 'a'),
+                QLatin1String("image/png"), fileName1));
+    QVERIFY(cache.insert(QLatin1String("token-2"), QByteArray(4, 'b'),
+                QLatin1String("image/png"), fileName2));
+    QVERIFY(cache.insert(QLatin1String("token-3"), QByteArray(8, 'c'),
+                QLatin1String("image/png"), fileName3));
+    QCOMPARE(cache.count(), 4);
+    QCOMPARE(cache.size(), static_cast<qint64>(20));
+
+    // inserting never evicts by itself, and neither does syncing
+    QVERIFY(cache.sync());
+    QCOMPARE(cache.count(), 4);
+
+    // going over the limit evicts the avatars written by the cache, but never those in use
+    cache.evict(QSet<QString>() << fileName3);
+    QCOMPARE(cache.count(), 2);
+    QCOMPARE(cache.size(), static_cast<qint64>(12));
+    QVERIFY(!QFile::exists(fileName1));
+    QVERIFY(!QFile::exists(fileName1 + QLatin1String(".mime")));
+    QVERIFY(!QFile::exists(fileName2));
+    QVERIFY(QFile::exists(fileName3));
+    QVERIFY(QFile::exists(foreignFileName));
+
+    // and it stays over the limit rather than touching them
+    cache.evict(QSet<QString>() << fileName3);
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(QFile::exists(fileName3));
+    QVERIFY(QFile::exists(foreignFileName));
+
+    QString fileName;
+    QString mimeType;
+    QVERIFY(cache.lookup(QLatin1String("token-3"), fileName, mimeType));
+    QVERIFY(cache.lookup(QLatin1String("foreign"), fileName, mimeType));
+    QVERIFY(!cache.lookup(QLatin1String("token-1"), fileName, mimeType));
+
+    // once no longer in use, it can go
+    cache.evict(QSet<QString>());
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(!QFile::exists(fileName3));
+    QVERIFY(QFile::exists(foreignFileName));
+}
+
+void TestAvatarCache::testLookupDoesNotRewriteIndex()
+{
+    QString fileName;
+    QString mimeType;
+
+    AvatarCache *cache = new AvatarCache(mDir);
+    QVERIFY(cache->insert(QLatin1String("token-1"), QByteArray("avatar"),
+                QLatin1String("image/png"), fileName));
+    QVERIFY(cache->sync());
+    delete cache;
+
+    // a lookup right after the avatar was stored doesn't make the index need saving
+    cache = new AvatarCache(mDir);
+    QVERIFY(cache->lookup(QLatin1String("token-1"), fileName, mimeType));
+    QVERIFY(!cache->isModified());
+
+    // and the file is only checked for the first time the avatar is found
+    QVERIFY(QFile::remove(fileName));
+    QVERIFY(cache->lookup(QLatin1String("token-1"), fileName, mimeType));
+    delete cache;
+}
+
+void TestAvatarCache::cleanup()
+{
+    removeDir();
+}
+
+QTEST_MAIN(TestAvatarCache)
+
+#include "_gen/avatar-cache.cpp.moc.hpp"
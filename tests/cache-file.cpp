@@ -0,0 +1,107 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/cache-file.h"
+
+using namespace Tp;
+
+class TestCacheFile : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testSave();
+    void testReplace();
+    void testFailure();
+
+    void cleanup();
+
+private:
+    QByteArray readFile(const QString &fileName);
+    void removeDir();
+
+    QString mDir;
+};
+
+QByteArray TestCacheFile::readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void TestCacheFile::removeDir()
+{
+    QDir dir(mDir + QLatin1String("/sub"));
+    Q_FOREACH (const QString &name, dir.entryList(QDir::Files | QDir::Hidden)) {
+        dir.remove(name);
+    }
+    QDir().rmpath(mDir + QLatin1String("/sub"));
+    QFile::remove(mDir + QLatin1String("/file"));
+    QDir().rmdir(mDir);
+}
+
+void TestCacheFile::init()
+{
+    mDir = QDir::tempPath() + QString(QLatin1String("/cache-file-%1"))
+        .arg(QCoreApplication::applicationPid());
+    removeDir();
+}
+
+void TestCacheFile::testSave()
+{
+    // the directory is created as needed
+    QString fileName = mDir + QLatin1String("/sub/test.cache");
+    QVERIFY(saveCacheFile(fileName, QByteArray("contents")));
+    QCOMPARE(readFile(fileName), QByteArray("contents"));
+
+    // no temporary file is left behind
+    QCOMPARE(QDir(mDir + QLatin1String("/sub")).entryList(QDir::Files | QDir::Hidden),
+            QStringList() << QLatin1String("test.cache"));
+
+    QVERIFY(saveCacheFile(fileName, QByteArray()));
+    QVERIFY(QFile::exists(fileName));
+    QCOMPARE(readFile(fileName), QByteArray());
+}
+
+void TestCacheFile::testReplace()
+{
+    QString fileName = mDir + QLatin1String("/sub/test.cache");
+    QVERIFY(saveCacheFile(fileName, QByteArray("old contents, longer than the new ones")));
+
+    // a reader which opened the old cache keeps seeing all of it
+    QFile reader(fileName);
+    QVERIFY(reader.open(QFile::ReadOnly));
+
+    QVERIFY(saveCacheFile(fileName, QByteArray("new")));
+    QCOMPARE(readFile(fileName), QByteArray("new"));
+    QCOMPARE(reader.readAll(), QByteArray("old contents, longer than the new ones"));
+    reader.close();
+
+    QCOMPARE(QDir(mDir + QLatin1String("/sub")).entryList(QDir::Files | QDir::Hidden),
+            QStringList() << QLatin1String("test.cache"));
+}
+
+void TestCacheFile::testFailure()
+{
+    // the directory can't be created where a file is in the way
+    QVERIFY(QDir().mkpath(mDir));
+    QFile file(mDir + QLatin1String("/file"));
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.close();
+
+    QVERIFY(!saveCacheFile(mDir + QLatin1String("/file/test.cache"), QByteArray("contents")));
+    QVERIFY(!QFile::exists(mDir + QLatin1String("/file/test.cache")));
+}
+
+void TestCacheFile::cleanup()
+{
+    removeDir();
+}
+
+QTEST_MAIN(TestCacheFile)
+
+#include "_gen/cache-file.cpp.moc.hpp"
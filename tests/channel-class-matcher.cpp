@@ -0,0 +1,221 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/channel-class-matcher.h"
+
+#include <TelepathyQt/ChannelClassSpec>
+#include <TelepathyQt/Constants>
+
+using namespace Tp;
+
+namespace
+{
+
+const int numSpecs = 500;
+const int numChannels = 200;
+
+QString property(const char *name)
+{
+    return TP_QT_IFACE_CHANNEL + QLatin1String(name);
+}
+
+// Roughly what a process with many observers and factory settings ends up registering: most
+// specs fix the channel type and handle type, some add Requested or a type-specific property
+QList<ChannelClassSpec> manySpecs()
+{
+    QList<ChannelClassSpec> ret;
+    QStringList types;
+    for (int i = 0; i < numSpecs / 5; ++i) {
+        types << QString(QLatin1String("org.example.Channel.Type.Foo%1")).arg(i);
+    }
+
+    for (int i = 0; i < numSpecs; ++i) {
+        QVariantMap extra;
+        if (i % 3 == 0) {
+            extra.insert(property(".Requested"), (i % 2) == 0);
+        }
+        if (i % 7 == 0) {
+            extra.insert(types.at(i % types.size()) + QLatin1String(".Bar"), i % 4);
+        }
+        ret << ChannelClassSpec(types.at(i % types.size()), (HandleType) (1 + i % 3), extra);
+    }
+    return ret;
+}
+
+QList<QVariantMap> manyChannels()
+{
+    QList<QVariantMap> ret;
+    for (int i = 0; i < numChannels; ++i) {
+        QVariantMap props;
+        QString type = QString(QLatin1String("org.example.Channel.Type.Foo%1"))
+            .arg((i * 7) % (numSpecs / 5));
+        props.insert(property(".ChannelType"), type);
+        props.insert(property(".TargetHandleType"), (uint) (1 + i % 3));
+        props.insert(property(".TargetHandle"), (uint) i);
+        props.insert(property(".TargetID"), QString(QLatin1String("contact%1")).arg(i));
+        props.insert(property(".Requested"), (i % 2) == 0);
+        props.insert(property(".InitiatorHandle"), (uint) i);
+        props.insert(type + QLatin1String(".Bar"), i % 4);
+        ret << props;
+    }
+    return ret;
+}
+
+QList<int> linearMatches(const QList<ChannelClassSpec> &specs, const QVariantMap &props)
+{
+    QList<int> ret;
+    for (int i = 0; i < specs.size(); ++i) {
+        if (specs.at(i).matches(props)) {
+            ret << i;
+        }
+    }
+    return ret;
+}
+
+}
+
+class TestChannelClassMatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testMatches();
+    void testWildcards();
+    void testSpecs();
+
+    void benchmarkMatches_data();
+    void benchmarkMatches();
+};
+
+void TestChannelClassMatcher::testMatches()
+{
+    QList<ChannelClassSpec> specs = manySpecs();
+    ChannelClassMatcher matcher(specs);
+    QCOMPARE(matcher.size(), numSpecs);
+
+    int matched = 0;
+    Q_FOREACH (const QVariantMap &props, manyChannels()) {
+        QList<int> expected = linearMatches(specs, props);
+        QCOMPARE(matcher.matchesChannel(props), expected);
+        QCOMPARE(matcher.firstMatchForChannel(props), expected.isEmpty() ? -1 : expected.first());
+        matched += expected.size();
+    }
+    QVERIFY(matched > 0);
+
+    QVERIFY(ChannelClassMatcher().isEmpty());
+    QCOMPARE(ChannelClassMatcher().firstMatchForChannel(manyChannels().first()), -1);
+}
+
+void TestChannelClassMatcher::testWildcards()
+{
+    QList<ChannelClassSpec> specs;
+    specs << ChannelClassSpec::textChat();
+    ChannelClassSpec requested;
+    requested.setRequested(true);
+    specs << requested;
+    specs << ChannelClassSpec();
+    ChannelClassSpec anyText;
+    anyText.setChannelType(TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+    specs << anyText;
+    ChannelClassSpec anyContact;
+    anyContact.setTargetHandleType(HandleTypeContact);
+    specs << anyContact;
+    ChannelClassSpec oddType;
+    oddType.setProperty(property(".ChannelType"), QVariant::fromValue(QStringList()));
+    specs << oddType;
+    specs << ChannelClassSpec(QString(), HandleTypeNone);
+
+    ChannelClassMatcher matcher(specs);
+
+    QVariantMap text;
+    text.insert(property(".ChannelType"), TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+    text.insert(property(".TargetHandleType"), (uint) HandleTypeContact);
+    text.insert(property(".Requested"), true);
+    QCOMPARE(matcher.matchesChannel(text), QList<int>() << 0 << 1 << 2 << 3 << 4);
+    QCOMPARE(matcher.matchesChannel(text), linearMatches(specs, text));
+    QCOMPARE(matcher.firstMatchForChannel(text), 0);
+
+    QVariantMap room(text);
+    room.insert(property(".TargetHandleType"), (uint) HandleTypeRoom);
+    room.insert(property(".Requested"), false);
+    QCOMPARE(matcher.matchesChannel(room), QList<int>() << 2 << 3);
+    QCOMPARE(matcher.firstMatchForChannel(room), 2);
+
+    // A missing ChannelType and TargetHandleType are taken to be empty, like ChannelClassSpec does
+    QVariantMap empty;
+    QCOMPARE(matcher.matchesChannel(empty), QList<int>() << 2 << 6);
+    QCOMPARE(matcher.matchesChannel(empty), linearMatches(specs, empty));
+
+    // Values of unexpected types are still compared
+    QVariantMap odd(text);
+    odd.insert(property(".ChannelType"), QVariant::fromValue(QStringList()));
+    QCOMPARE(matcher.matchesChannel(odd), linearMatches(specs, odd));
+    QVERIFY(matcher.matchesChannel(odd).contains(5));
+}
+
+void TestChannelClassMatcher::testSpecs()
+{
+    // Matching against another spec doesn't fill in the ChannelType and TargetHandleType
+    QList<ChannelClassSpec> specs;
+    specs << ChannelClassSpec::textChat() << ChannelClassSpec::textChatroom()
+        << ChannelClassSpec() << ChannelClassSpec(QString(), HandleTypeNone);
+    ChannelClassMatcher matcher(specs);
+
+    for (int i = 0; i < specs.size(); ++i) {
+        QList<int> expected;
+        for (int j = 0; j < specs.size(); ++j) {
+            if (specs.at(j).isSubsetOf(specs.at(i))) {
+                expected << j;
+            }
+        }
+        QCOMPARE(matcher.matches(specs.at(i)), expected);
+        QCOMPARE(matcher.firstMatch(specs.at(i)), expected.first());
+    }
+
+    QVariantMap requested;
+    requested.insert(property(".Requested"), true);
+    ChannelClassSpec requestedTextChat = ChannelClassSpec::textChat(requested);
+    QCOMPARE(matcher.matches(requestedTextChat), QList<int>() << 0 << 2);
+    QCOMPARE(matcher.firstMatch(ChannelClassSpec::streamedMediaCall()), 2);
+}
+
+void TestChannelClassMatcher::benchmarkMatches_data()
+{
+    QTest::addColumn<bool>("indexed");
+
+    QTest::newRow("linear") << false;
+    QTest::newRow("indexed") << true;
+}
+
+void TestChannelClassMatcher::benchmarkMatches()
+{
+    QFETCH(bool, indexed);
+
+    // what ChannelFactory::featuresFor() does for every channel it makes ready
+    QList<ChannelClassSpec> specs = manySpecs();
+    QList<QVariantMap> channels = manyChannels();
+    ChannelClassMatcher matcher(specs);
+
+    int matched = 0;
+    if (indexed) {
+        QBENCHMARK {
+            Q_FOREACH (const QVariantMap &props, channels) {
+                matched += matcher.matchesChannel(props).size();
+            }
+        }
+    } else {
+        QBENCHMARK {
+            Q_FOREACH (const QVariantMap &props, channels) {
+                Q_FOREACH (const ChannelClassSpec &spec, specs) {
+                    if (spec.isSubsetOf(ChannelClassSpec(props))) {
+                        ++matched;
+                    }
+                }
+            }
+        }
+    }
+    QVERIFY(matched > 0);
+}
+
+QTEST_MAIN(TestChannelClassMatcher)
+
+#include "_gen/channel-class-matcher.cpp.moc.hpp"
@@ -0,0 +1,246 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/connection-manager-cache.h"
+
+#include <TelepathyQt/Constants>
+
+using namespace Tp;
+
+class TestConnectionManagerCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testRoundTrip();
+    void testInvalidation();
+    void testNotStorable();
+
+    void cleanupTestCase();
+
+private:
+    void writeFile(const QString &fileName, const QByteArray &contents);
+    ConnectionManagerCache::ProtocolList makeProtocols();
+    void compareProtocols(const ConnectionManagerCache::ProtocolList &protocols,
+            const ConnectionManagerCache::ProtocolList &expected);
+
+    QString mDir;
+    QString mCacheDir;
+    QStringList mFiles;
+};
+
+void TestConnectionManagerCache::writeFile(const QString &fileName, const QByteArray &contents)
+{
+    QVERIFY(QDir().mkpath(QFileInfo(fileName).absolutePath()));
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    file.write(contents);
+    file.close();
+    mFiles << fileName;
+}
+
+ConnectionManagerCache::ProtocolList TestConnectionManagerCache::makeProtocols()
+{
+    ConnectionManagerCache::Protocol protocol;
+    protocol.name = QLatin1String("foo");
+
+    ParamSpec account;
+    account.name = QLatin1String("account");
+    account.flags = ConnMgrParamFlagRequired;
+    account.signature = QLatin1String("s");
+    protocol.parameters << account;
+
+    ParamSpec port;
+    port.name = QLatin1String("port");
+    port.flags = ConnMgrParamFlagHasDefault;
+    port.signature = QLatin1String("q");
+    port.defaultValue = QDBusVariant(QVariant(5222u));
+    protocol.parameters << port;
+
+    RequestableChannelClass rcc;
+    rcc.fixedProperties.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType"),
+            TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+    rcc.fixedProperties.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType"),
+            static_cast<uint>(HandleTypeContact));
+    rcc.allowedProperties << TP_QT_IFACE_CHANNEL + QLatin1String(".TargetID");
+    protocol.requestableChannelClasses << rcc;
+
+    protocol.vcardField = QLatin1String("x-foo");
+    protocol.englishName = QLatin1String("Foo");
+    protocol.iconName = QLatin1String("im-foo");
+
+    SimpleStatusSpec available;
+    available.type = ConnectionPresenceTypeAvailable;
+    available.maySetOnSelf = true;
+    available.canHaveMessage = true;
+    protocol.allowedPresenceStatuses.insert(QLatin1String("available"), available);
+
+    protocol.avatarRequirements = AvatarSpec(QStringList() << QLatin1String("image/png"),
+            16, 96, 64, 16, 96, 64, 8192);
+    protocol.addressableVCardFields << QLatin1String("x-foo");
+    protocol.addressableUriSchemes << QLatin1String("foo");
+
+    return ConnectionManagerCache::ProtocolList() << protocol;
+}
+
+void TestConnectionManagerCache::compareProtocols(
+        const ConnectionManagerCache::ProtocolList &protocols,
+        const ConnectionManagerCache::ProtocolList &expected)
+{
+    QCOMPARE(protocols.size(), expected.size());
+    for (int i = 0; i < protocols.size(); ++i) {
+        const ConnectionManagerCache::Protocol &protocol = protocols[i];
+        const ConnectionManagerCache::Protocol &other = expected[i];
+
+        QCOMPARE(protocol.name, other.name);
+        QCOMPARE(protocol.parameters.size(), other.parameters.size());
+        for (int j = 0; j < protocol.parameters.size(); ++j) {
+            QCOMPARE(protocol.parameters[j].name, other.parameters[j].name);
+            QCOMPARE(protocol.parameters[j].flags, other.parameters[j].flags);
+            QCOMPARE(protocol.parameters[j].signature, other.parameters[j].signature);
+            QCOMPARE(protocol.parameters[j].defaultValue.variant(),
+                    other.parameters[j].defaultValue.variant());
+        }
+        QVERIFY(protocol.requestableChannelClasses == other.requestableChannelClasses);
+        QCOMPARE(protocol.vcardField, other.vcardField);
+        QCOMPARE(protocol.englishName, other.englishName);
+        QCOMPARE(protocol.iconName, other.iconName);
+        QVERIFY(protocol.allowedPresenceStatuses == other.allowedPresenceStatuses);
+        QCOMPARE(protocol.avatarRequirements.supportedMimeTypes(),
+                other.avatarRequirements.supportedMimeTypes());
+        QCOMPARE(protocol.avatarRequirements.recommendedHeight(),
+                other.avatarRequirements.recommendedHeight());
+        QCOMPARE(protocol.avatarRequirements.maximumBytes(),
+                other.avatarRequirements.maximumBytes());
+        QCOMPARE(protocol.addressableVCardFields, other.addressableVCardFields);
+        QCOMPARE(protocol.addressableUriSchemes, other.addressableUriSchemes);
+    }
+}
+
+void TestConnectionManagerCache::initTestCase()
+{
+    mDir = QDir::tempPath() + QString(QLatin1String("/connection-manager-cache-%1"))
+        .arg(QCoreApplication::applicationPid());
+    mCacheDir = mDir + QLatin1String("/cache");
+
+    // only look for the connection managers installed by the test
+    qputenv("XDG_DATA_HOME", QFile::encodeName(mDir + QLatin1String("/home")));
+    qputenv("XDG_DATA_DIRS", QFile::encodeName(mDir + QLatin1String("/system")));
+}
+
+void TestConnectionManagerCache::testRoundTrip()
+{
+    ConnectionManagerCache::ProtocolList protocols;
+    QStringList interfaces;
+
+    // nothing describes a connection manager which isn't installed, so it's never cached
+    ConnectionManagerCache cache(mCacheDir);
+    cache.insert(QLatin1String("missing"), makeProtocols());
+    QVERIFY(!cache.lookup(QLatin1String("missing"), &protocols));
+
+    writeFile(mDir + QLatin1String("/system/telepathy/managers/foo.manager"),
+            "[ConnectionManager]\nName=foo\n");
+    QVERIFY(!cache.lookup(QLatin1String("foo"), &protocols));
+
+    QStringList cmInterfaces;
+    cmInterfaces << QLatin1String("org.freedesktop.Telepathy.ConnectionManager.Interface.Foo");
+    cache.insert(QLatin1String("foo"), makeProtocols(), cmInterfaces);
+    QVERIFY(QFile::exists(mCacheDir + QLatin1String("/foo.cache")));
+
+    QVERIFY(cache.lookup(QLatin1String("foo"), &protocols, &interfaces));
+    compareProtocols(protocols, makeProtocols());
+    QCOMPARE(interfaces, cmInterfaces);
+
+    // another process reads it back from disk
+    ConnectionManagerCache loaded(mCacheDir);
+    protocols.clear();
+    interfaces.clear();
+    QVERIFY(loaded.lookup(QLatin1String("foo"), &protocols, &interfaces));
+    compareProtocols(protocols, makeProtocols());
+    QCOMPARE(interfaces, cmInterfaces);
+
+    loaded.remove(QLatin1String("foo"));
+    QVERIFY(!loaded.lookup(QLatin1String("foo"), &protocols));
+    QVERIFY(!QFile::exists(mCacheDir + QLatin1String("/foo.cache")));
+}
+
+void TestConnectionManagerCache::testInvalidation()
+{
+    ConnectionManagerCache::ProtocolList protocols;
+
+    writeFile(mDir + QLatin1String("/system/telepathy/managers/bar.manager"),
+            "[ConnectionManager]\nName=bar\n");
+
+    ConnectionManagerCache cache(mCacheDir);
+    cache.insert(QLatin1String("bar"), makeProtocols());
+    QVERIFY(cache.lookup(QLatin1String("bar"), &protocols));
+
+    // a .manager file taking precedence over the cached one
+    writeFile(mDir + QLatin1String("/home/telepathy/managers/bar.manager"),
+            "[ConnectionManager]\nName=bar\n");
+    QVERIFY(!cache.lookup(QLatin1String("bar"), &protocols));
+    QVERIFY(!ConnectionManagerCache(mCacheDir).lookup(QLatin1String("bar"), &protocols));
+
+    // the connection manager being installed
+    QString binary = mDir + QLatin1String("/bin/telepathy-bar");
+    writeFile(binary, "#!/bin/sh\n");
+    writeFile(mDir + QLatin1String("/system/dbus-1/services/") +
+            TP_QT_CONNECTION_MANAGER_BUS_NAME_BASE + QLatin1String("bar.service"),
+            QByteArray("[D-BUS Service]\nName=") +
+                QString(TP_QT_CONNECTION_MANAGER_BUS_NAME_BASE).toLatin1() +
+                QByteArray("bar\nExec=") + QFile::encodeName(binary) + QByteArray("\n"));
+    QCOMPARE(ConnectionManagerCache::serviceFileName(QLatin1String("bar")),
+            mDir + QLatin1String("/system/dbus-1/services/") +
+                TP_QT_CONNECTION_MANAGER_BUS_NAME_BASE + QLatin1String("bar.service"));
+    QVERIFY(!cache.lookup(QLatin1String("bar"), &protocols));
+
+    cache.insert(QLatin1String("bar"), makeProtocols());
+    QVERIFY(cache.lookup(QLatin1String("bar"), &protocols));
+    QVERIFY(ConnectionManagerCache(mCacheDir).lookup(QLatin1String("bar"), &protocols));
+
+    // and uninstalled
+    QFile::remove(binary);
+    QVERIFY(!cache.lookup(QLatin1String("bar"), &protocols));
+}
+
+void TestConnectionManagerCache::testNotStorable()
+{
+    ConnectionManagerCache::ProtocolList protocols;
+
+    writeFile(mDir + QLatin1String("/system/telepathy/managers/baz.manager"),
+            "[ConnectionManager]\nName=baz\n");
+
+    // D-Bus arguments can't be streamed, so the entry is only kept in memory
+    ConnectionManagerCache::ProtocolList notStorable = makeProtocols();
+    notStorable[0].requestableChannelClasses[0].fixedProperties.insert(QLatin1String("opaque"),
+            QVariant::fromValue(QDBusArgument()));
+
+    ConnectionManagerCache cache(mCacheDir);
+    cache.insert(QLatin1String("baz"), notStorable);
+    QVERIFY(cache.lookup(QLatin1String("baz"), &protocols));
+    QVERIFY(!QFile::exists(mCacheDir + QLatin1String("/baz.cache")));
+    QVERIFY(!ConnectionManagerCache(mCacheDir).lookup(QLatin1String("baz"), &protocols));
+
+    // a corrupt file is ignored
+    writeFile(mCacheDir + QLatin1String("/baz.cache"), "this is not a cache");
+    QVERIFY(!ConnectionManagerCache(mCacheDir).lookup(QLatin1String("baz"), &protocols));
+
+    cache.clear();
+    QVERIFY(!cache.lookup(QLatin1String("baz"), &protocols));
+    QVERIFY(!QFile::exists(mCacheDir + QLatin1String("/baz.cache")));
+}
+
+void TestConnectionManagerCache::cleanupTestCase()
+{
+    ConnectionManagerCache(mCacheDir).clear();
+    QDir().rmpath(mCacheDir);
+    Q_FOREACH (const QString &fileName, mFiles) {
+        QFile::remove(fileName);
+        QDir().rmpath(QFileInfo(fileName).absolutePath());
+    }
+}
+
+QTEST_MAIN(TestConnectionManagerCache)
+
+#include "_gen/connection-manager-cache.cpp.moc.hpp"
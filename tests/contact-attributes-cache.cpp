@@ -0,0 +1,127 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/contact-attributes-cache.h"
+
+using namespace Tp;
+
+struct NotStreamable
+{
+};
+
+Q_DECLARE_METATYPE(NotStreamable)
+
+class TestContactAttributesCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testRoundTrip();
+    void testFormatError();
+
+    void cleanupTestCase();
+
+private:
+    QString mDir;
+};
+
+void TestContactAttributesCache::initTestCase()
+{
+    mDir = QDir::tempPath() + QString(QLatin1String("/contact-attributes-cache-%1"))
+        .arg(QCoreApplication::applicationPid());
+}
+
+void TestContactAttributesCache::testRoundTrip()
+{
+    ContactAttributesCache defaultCache;
+    QCOMPARE(defaultCache.status(), ContactAttributesCache::None);
+
+    QString fileName = mDir + QLatin1String("/gabble/jabber/me_40example_2ecom");
+    ContactAttributesCache cache(fileName);
+    QCOMPARE(cache.status(), ContactAttributesCache::NotFoundError);
+    QCOMPARE(cache.size(), 0);
+    QVERIFY(!cache.isModified());
+
+    QVariantMap location;
+    location.insert(QLatin1String("country"), QLatin1String("Finland"));
+    location.insert(QLatin1String("lat"), 60.17);
+
+    QVariantMap alice;
+    alice.insert(QLatin1String("alias"), QLatin1String("Alice"));
+    alice.insert(QLatin1String("client-types"),
+            QStringList() << QLatin1String("pc") << QLatin1String("phone"));
+    alice.insert(QLatin1String("location"), location);
+    // not a plain Qt type, so it can't be stored
+    alice.insert(QLatin1String("opaque"), QVariant::fromValue(NotStreamable()));
+
+    QVariantMap bob;
+    bob.insert(QLatin1String("alias"), QLatin1String("Bob"));
+
+    cache.setAttributes(QLatin1String("alice@example.com"), alice);
+    cache.setAttributes(QLatin1String("bob@example.com"), bob);
+    QVERIFY(cache.isModified());
+    QCOMPARE(cache.size(), 2);
+    QVERIFY(!cache.attributes(QLatin1String("alice@example.com")).contains(
+                QLatin1String("opaque")));
+    alice.remove(QLatin1String("opaque"));
+
+    QVERIFY(cache.save());
+    QVERIFY(!cache.isModified());
+
+    // setting the same attributes again doesn't modify the cache
+    cache.setAttributes(QLatin1String("bob@example.com"), bob);
+    QVERIFY(!cache.isModified());
+
+    ContactAttributesCache loaded(fileName);
+    QCOMPARE(loaded.status(), ContactAttributesCache::NoError);
+    QCOMPARE(loaded.size(), 2);
+    QStringList ids = loaded.identifiers();
+    ids.sort();
+    QCOMPARE(ids, QStringList() << QLatin1String("alice@example.com") <<
+            QLatin1String("bob@example.com"));
+    QCOMPARE(loaded.attributes(QLatin1String("alice@example.com")), alice);
+    QCOMPARE(loaded.attributes(QLatin1String("bob@example.com")), bob);
+    QVERIFY(!loaded.contains(QLatin1String("carol@example.com")));
+    QCOMPARE(loaded.attributes(QLatin1String("carol@example.com")), QVariantMap());
+
+    loaded.remove(QLatin1String("bob@example.com"));
+    QVERIFY(loaded.isModified());
+    QVERIFY(loaded.save());
+
+    cache.setFileName(fileName);
+    QCOMPARE(cache.status(), ContactAttributesCache::NoError);
+    QCOMPARE(cache.identifiers(), QStringList() << QLatin1String("alice@example.com"));
+}
+
+void TestContactAttributesCache::testFormatError()
+{
+    QString fileName = mDir + QLatin1String("/garbage");
+    QVERIFY(QDir().mkpath(mDir));
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write("this is not a contact attributes cache");
+    file.close();
+
+    ContactAttributesCache cache(fileName);
+    QCOMPARE(cache.status(), ContactAttributesCache::FormatError);
+    QCOMPARE(cache.size(), 0);
+
+    // a broken cache is simply overwritten
+    cache.setAttributes(QLatin1String("alice@example.com"), QVariantMap());
+    QVERIFY(cache.save());
+    QVERIFY(cache.load());
+    QCOMPARE(cache.status(), ContactAttributesCache::NoError);
+    QCOMPARE(cache.size(), 1);
+}
+
+void TestContactAttributesCache::cleanupTestCase()
+{
+    QFile::remove(mDir + QLatin1String("/gabble/jabber/me_40example_2ecom"));
+    QFile::remove(mDir + QLatin1String("/garbage"));
+    QDir().rmpath(mDir + QLatin1String("/gabble/jabber"));
+}
+
+QTEST_MAIN(TestContactAttributesCache)
+
+#include "_gen/contact-attributes-cache.cpp.moc.hpp"
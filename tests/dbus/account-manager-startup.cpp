@@ -0,0 +1,95 @@
+#include <tests/lib/test.h>
+
+#include <TelepathyQt/Account>
+#include <TelepathyQt/AccountFactory>
+#include <TelepathyQt/AccountManager>
+#include <TelepathyQt/PendingOperation>
+#include <TelepathyQt/PendingReady>
+
+using namespace Tp;
+
+static const int numAccounts = 200;
+
+class TestAccountManagerStartup : public Test
+{
+    Q_OBJECT
+
+public:
+    TestAccountManagerStartup(QObject *parent = 0)
+        : Test(parent)
+    { }
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testStartup();
+
+    void cleanup();
+    void cleanupTestCase();
+};
+
+void TestAccountManagerStartup::initTestCase()
+{
+    initTestCaseImpl();
+
+    // create the accounts directly, so they are all there when the AccountManager starts up
+    for (int i = 0; i < numAccounts; ++i) {
+        QVariantMap parameters;
+        parameters[QLatin1String("account")] = QString(QLatin1String("account%1")).arg(i);
+
+        QDBusMessage msg = QDBusMessage::createMethodCall(TP_QT_ACCOUNT_MANAGER_BUS_NAME,
+                TP_QT_ACCOUNT_MANAGER_OBJECT_PATH, TP_QT_IFACE_ACCOUNT_MANAGER,
+                QLatin1String("CreateAccount"));
+        msg << QLatin1String("foo") << QLatin1String("bar") <<
+            QString(QLatin1String("Account %1")).arg(i) << parameters << QVariantMap();
+        QDBusMessage reply = QDBusConnection::sessionBus().call(msg);
+        QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    }
+}
+
+void TestAccountManagerStartup::init()
+{
+    initImpl();
+}
+
+void TestAccountManagerStartup::testStartup()
+{
+    QTime timer;
+    timer.start();
+
+    AccountManagerPtr am;
+    QBENCHMARK {
+        // a new factory each time, so the accounts are introspected again
+        am = AccountManager::create(AccountFactory::create(QDBusConnection::sessionBus(),
+                    Account::FeatureCore));
+        QVERIFY(connect(am->becomeReady(),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+        QCOMPARE(mLoop->exec(), 0);
+    }
+    qDebug() << "Started up with" << numAccounts << "accounts in" << timer.elapsed() << "ms";
+
+    QCOMPARE(am->allAccounts().size(), numAccounts);
+    Q_FOREACH (const AccountPtr &account, am->allAccounts()) {
+        QVERIFY(account->isReady(Account::FeatureCore));
+        QVERIFY(account->isValidAccount());
+        QCOMPARE(account->cmName(), QString(QLatin1String("foo")));
+        QVERIFY(account->displayName().startsWith(QLatin1String("Account ")));
+        QVERIFY(account->parameters().value(QLatin1String("account")).toString().startsWith(
+                    QLatin1String("account")));
+    }
+}
+
+void TestAccountManagerStartup::cleanup()
+{
+    cleanupImpl();
+}
+
+void TestAccountManagerStartup::cleanupTestCase()
+{
+    cleanupTestCaseImpl();
+}
+
+QTEST_MAIN(TestAccountManagerStartup)
+#include "_gen/account-manager-startup.cpp.moc.hpp"
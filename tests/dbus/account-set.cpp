@@ -21,6 +21,34 @@
 
 using namespace Tp;
 
+// A filter the account set index can't look into, so the sets using it need to be re-evaluated on
+// any change
+class NicknamePrefixFilter : public Filter<Account>
+{
+public:
+    static AccountFilterConstPtr create(const QString &prefix)
+    {
+        return AccountFilterConstPtr(new NicknamePrefixFilter(prefix));
+    }
+
+    bool isValid() const
+    {
+        return true;
+    }
+
+    bool matches(const AccountPtr &account) const
+    {
+        return account->nickname().startsWith(mPrefix);
+    }
+
+private:
+    NicknamePrefixFilter(const QString &prefix)
+        : mPrefix(prefix)
+    { }
+
+    QString mPrefix;
+};
+
 class TestAccountSet : public Test
 {
     Q_OBJECT
@@ -35,6 +63,8 @@ protected Q_SLOTS:
     void onAccountAdded(const Tp::AccountPtr &);
     void onAccountRemoved(const Tp::AccountPtr &);
     void onCreateAccountFinished(Tp::PendingOperation *op);
+    void onAccountsChanged(const QList<Tp::AccountPtr> &accounts,
+            const QStringList &propertyNames);
 
 private Q_SLOTS:
     void initTestCase();
@@ -42,6 +72,8 @@ private Q_SLOTS:
 
     void testBasics();
     void testFilters();
+    void testIndexedSets();
+    void testCoalescedChanges();
 
     void cleanup();
     void cleanupTestCase();
@@ -50,6 +82,7 @@ private:
     void createAccount(const char *cmName, const char *protocolName,
             const char *displayName, const QVariantMap &parameters);
     void removeAccount(const AccountPtr &acc);
+    void setNickname(const AccountPtr &acc, const QString &nickname);
     QStringList pathsForAccounts(const QList<Tp::AccountPtr> &list);
     QStringList pathsForAccounts(const Tp::AccountSetPtr &set);
 
@@ -58,6 +91,8 @@ private:
     AccountPtr mAccountCreated;
     AccountPtr mAccountAdded;
     AccountPtr mAccountRemoved;
+    QList<QList<AccountPtr> > mChangedAccounts;
+    QList<QStringList> mChangedPropertyNames;
 };
 
 void TestAccountSet::onAccountAdded(const Tp::AccountPtr &acc)
@@ -91,6 +126,13 @@ void TestAccountSet::onCreateAccountFinished(PendingOperation *op)
     mLoop->exit(0);
 }
 
+void TestAccountSet::onAccountsChanged(const QList<Tp::AccountPtr> &accounts,
+        const QStringList &propertyNames)
+{
+    mChangedAccounts.append(accounts);
+    mChangedPropertyNames.append(propertyNames);
+}
+
 void TestAccountSet::createAccount(const char *cmName, const char *protocolName,
         const char *displayName, const QVariantMap &parameters)
 {
@@ -154,6 +196,20 @@ void TestAccountSet::removeAccount(const AccountPtr &acc)
     QCOMPARE(acc->invalidationReason(), TP_QT_ERROR_OBJECT_REMOVED);
 }
 
+void TestAccountSet::setNickname(const AccountPtr &acc, const QString &nickname)
+{
+    QVERIFY(connect(acc->setNickname(nickname),
+                SIGNAL(finished(Tp::PendingOperation *)),
+                SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+
+    while (acc->nickname() != nickname) {
+        mLoop->processEvents();
+    }
+
+    processDBusQueue(mConn->client().data());
+}
+
 QStringList TestAccountSet::pathsForAccounts(const QList<Tp::AccountPtr> &list)
 {
     QStringList ret;
@@ -356,6 +412,14 @@ void TestAccountSet::testFilters()
         QCOMPARE(enabledAccounts->accounts().size(), 2);
         QCOMPARE(disabledAccounts->accounts().size(), 0);
 
+        // sets with identical filters are separate objects with the same accounts
+        AccountSetPtr otherEnabledAccounts = mAM->enabledAccounts();
+        QVERIFY(otherEnabledAccounts != enabledAccounts);
+        QCOMPARE(otherEnabledAccounts->accounts().toSet(), enabledAccounts->accounts().toSet());
+        QVariantMap enabledFilter;
+        enabledFilter.insert(QLatin1String("enabled"), true);
+        QVERIFY(mAM->filterAccounts(enabledFilter) != enabledAccounts);
+
         QVERIFY(connect(fooAcc->setEnabled(false),
                     SIGNAL(finished(Tp::PendingOperation*)),
                     SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
@@ -397,6 +461,151 @@ void TestAccountSet::testFilters()
     }
 }
 
+void TestAccountSet::testIndexedSets()
+{
+    QCOMPARE(mAM->accountsByProtocol(QLatin1String("bar"))->accounts().size(), 1);
+    AccountPtr fooAcc = mAM->accountsByProtocol(QLatin1String("bar"))->accounts().first();
+    QCOMPARE(mAM->accountsByProtocol(QLatin1String("normal"))->accounts().size(), 1);
+    AccountPtr spuriousAcc = mAM->accountsByProtocol(QLatin1String("normal"))->accounts().first();
+
+    AccountPropertyFilterPtr protocolFilter = AccountPropertyFilter::create();
+    protocolFilter->addProperty(QLatin1String("protocolName"), QLatin1String("bar"));
+
+    // sets indexed by the properties their filter looks at
+    AccountPropertyFilterPtr nicknameFilter = AccountPropertyFilter::create();
+    nicknameFilter->addProperty(QLatin1String("nickname"), QLatin1String("indexed"));
+    AccountSetPtr nicknameAccounts = AccountSetPtr(new AccountSet(mAM, nicknameFilter));
+    AccountSetPtr fooNicknameAccounts = AccountSetPtr(new AccountSet(mAM,
+                AndFilter<Account>::create(QList<AccountFilterConstPtr>()
+                    << protocolFilter << nicknameFilter)));
+
+    // sets which can't be indexed, alone and as part of a filter which could otherwise be
+    AccountSetPtr customAccounts = AccountSetPtr(new AccountSet(mAM,
+                NicknamePrefixFilter::create(QLatin1String("custom"))));
+    AccountSetPtr fooCustomAccounts = AccountSetPtr(new AccountSet(mAM,
+                AndFilter<Account>::create(QList<AccountFilterConstPtr>()
+                    << protocolFilter << NicknamePrefixFilter::create(QLatin1String("custom")))));
+
+    // a set which doesn't depend on the nickname at all
+    AccountSetPtr enabledAccounts = mAM->enabledAccounts();
+    QStringList enabledPaths = pathsForAccounts(enabledAccounts);
+
+    QCOMPARE(pathsForAccounts(nicknameAccounts), QStringList());
+    QCOMPARE(pathsForAccounts(fooNicknameAccounts), QStringList());
+    QCOMPARE(pathsForAccounts(customAccounts), QStringList());
+    QCOMPARE(pathsForAccounts(fooCustomAccounts), QStringList());
+
+    setNickname(fooAcc, QLatin1String("indexed"));
+    QCOMPARE(pathsForAccounts(nicknameAccounts), QStringList() << fooAcc->objectPath());
+    QCOMPARE(pathsForAccounts(fooNicknameAccounts), QStringList() << fooAcc->objectPath());
+    QCOMPARE(pathsForAccounts(customAccounts), QStringList());
+    QCOMPARE(pathsForAccounts(fooCustomAccounts), QStringList());
+    QCOMPARE(pathsForAccounts(enabledAccounts), enabledPaths);
+
+    setNickname(spuriousAcc, QLatin1String("indexed"));
+    QCOMPARE(nicknameAccounts->accounts().size(), 2);
+    QVERIFY(nicknameAccounts->accounts().contains(fooAcc));
+    QVERIFY(nicknameAccounts->accounts().contains(spuriousAcc));
+    QCOMPARE(pathsForAccounts(fooNicknameAccounts), QStringList() << fooAcc->objectPath());
+
+    // the custom filters are re-evaluated on the same change which takes the account out of the
+    // indexed sets
+    setNickname(fooAcc, QLatin1String("custom nickname"));
+    QCOMPARE(pathsForAccounts(nicknameAccounts), QStringList() << spuriousAcc->objectPath());
+    QCOMPARE(pathsForAccounts(fooNicknameAccounts), QStringList());
+    QCOMPARE(pathsForAccounts(customAccounts), QStringList() << fooAcc->objectPath());
+    QCOMPARE(pathsForAccounts(fooCustomAccounts), QStringList() << fooAcc->objectPath());
+    QCOMPARE(pathsForAccounts(enabledAccounts), enabledPaths);
+
+    setNickname(spuriousAcc, QLatin1String("custom too"));
+    QCOMPARE(pathsForAccounts(nicknameAccounts), QStringList());
+    QCOMPARE(customAccounts->accounts().size(), 2);
+    QVERIFY(customAccounts->accounts().contains(fooAcc));
+    QVERIFY(customAccounts->accounts().contains(spuriousAcc));
+    QCOMPARE(pathsForAccounts(fooCustomAccounts), QStringList() << fooAcc->objectPath());
+
+    // the remaining sets keep being updated once the other ones sharing the index are gone
+    nicknameAccounts.reset();
+    fooNicknameAccounts.reset();
+    fooCustomAccounts.reset();
+
+    setNickname(fooAcc, QString());
+    QCOMPARE(pathsForAccounts(customAccounts), QStringList() << spuriousAcc->objectPath());
+    setNickname(spuriousAcc, QString());
+    QCOMPARE(pathsForAccounts(customAccounts), QStringList());
+    QCOMPARE(pathsForAccounts(enabledAccounts), enabledPaths);
+}
+
+void TestAccountSet::testCoalescedChanges()
+{
+    QCOMPARE(mAM->accountsByProtocol(QLatin1String("bar"))->accounts().size(), 1);
+    AccountPtr fooAcc = mAM->accountsByProtocol(QLatin1String("bar"))->accounts().first();
+    QCOMPARE(mAM->accountsByProtocol(QLatin1String("normal"))->accounts().size(), 1);
+    AccountPtr spuriousAcc = mAM->accountsByProtocol(QLatin1String("normal"))->accounts().first();
+    QString fooDisplayName = fooAcc->displayName();
+
+    // Coalescing is disabled by default
+    QCOMPARE(mAM->accountChangesCoalescingInterval(), -1);
+    // Use an interval long enough for all the changes below to be made before it elapses
+    mAM->setAccountChangesCoalescingInterval(2000);
+    QCOMPARE(mAM->accountChangesCoalescingInterval(), 2000);
+    QVERIFY(connect(mAM.data(),
+                SIGNAL(accountsChanged(QList<Tp::AccountPtr>,QStringList)),
+                SLOT(onAccountsChanged(QList<Tp::AccountPtr>,QStringList))));
+    mChangedAccounts.clear();
+    mChangedPropertyNames.clear();
+
+    // Repeated changes of the same property of several accounts are reported once, with the
+    // accounts in the order they first changed in
+    setNickname(fooAcc, QLatin1String("first"));
+    setNickname(spuriousAcc, QLatin1String("second"));
+    setNickname(fooAcc, QLatin1String("third"));
+    QCOMPARE(mChangedAccounts.size(), 0);
+    while (mChangedAccounts.size() < 1) {
+        mLoop->processEvents();
+    }
+
+    QCOMPARE(mChangedAccounts.size(), 1);
+    QCOMPARE(mChangedAccounts[0], QList<AccountPtr>() << fooAcc << spuriousAcc);
+    QCOMPARE(mChangedPropertyNames[0], QStringList() << QLatin1String("nickname"));
+
+    // The changes were applied right away nevertheless
+    QCOMPARE(fooAcc->nickname(), QString(QLatin1String("third")));
+    QCOMPARE(spuriousAcc->nickname(), QString(QLatin1String("second")));
+
+    // Changes of different properties of the same account are merged
+    QVERIFY(connect(fooAcc->setDisplayName(QLatin1String("Coalesced")),
+                SIGNAL(finished(Tp::PendingOperation *)),
+                SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+    setNickname(fooAcc, QLatin1String("fourth"));
+    QCOMPARE(mChangedAccounts.size(), 1);
+    while (mChangedAccounts.size() < 2) {
+        mLoop->processEvents();
+    }
+
+    QCOMPARE(mChangedAccounts.size(), 2);
+    QCOMPARE(mChangedAccounts[1], QList<AccountPtr>() << fooAcc);
+    QCOMPARE(mChangedPropertyNames[1], QStringList() << QLatin1String("displayName")
+            << QLatin1String("nickname"));
+
+    // Nothing is reported once coalescing is disabled again
+    mAM->setAccountChangesCoalescingInterval(-1);
+    setNickname(fooAcc, QString());
+    setNickname(spuriousAcc, QString());
+    QVERIFY(connect(fooAcc->setDisplayName(fooDisplayName),
+                SIGNAL(finished(Tp::PendingOperation *)),
+                SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+    processDBusQueue(mConn->client().data());
+    QCOMPARE(mChangedAccounts.size(), 2);
+
+    QVERIFY(disconnect(mAM.data(),
+                SIGNAL(accountsChanged(QList<Tp::AccountPtr>,QStringList)),
+                this,
+                SLOT(onAccountsChanged(QList<Tp::AccountPtr>,QStringList))));
+}
+
 void TestAccountSet::cleanup()
 {
     cleanupImpl();
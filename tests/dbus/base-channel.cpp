@@ -0,0 +1,526 @@
+#include <tests/lib/test.h>
+#include <tests/lib/test-thread-helper.h>
+
+#include <TelepathyQt/BaseChannel>
+#include <TelepathyQt/BaseConnection>
+#include <TelepathyQt/Channel>
+#include <TelepathyQt/Constants>
+#include <TelepathyQt/DBusError>
+
+#include <QTime>
+
+using namespace Tp;
+
+namespace
+{
+
+// The load test pushes this many messages through the bus, which connection managers for busy
+// protocols should be able to do in about a second
+const int numLoadMessages = 100000;
+
+QString connBusName()
+{
+    return TP_QT_CONNECTION_BUS_NAME_BASE + QLatin1String("testcm.example.testconn");
+}
+
+QString chanObjectPath()
+{
+    return TP_QT_CONNECTION_OBJECT_PATH_BASE +
+        QLatin1String("testcm/example/testconn/TextChannel");
+}
+
+MessagePartList textMessage(uint sender, const QString &text)
+{
+    MessagePart header;
+    header.insert(QLatin1String("message-sender"), QDBusVariant(sender));
+    header.insert(QLatin1String("message-received"), QDBusVariant(qlonglong(1234)));
+    MessagePart body;
+    body.insert(QLatin1String("content-type"), QDBusVariant(QLatin1String("text/plain")));
+    body.insert(QLatin1String("content"), QDBusVariant(text));
+    return MessagePartList() << header << body;
+}
+
+}
+
+class TestConnection : public BaseConnection
+{
+public:
+    TestConnection(const QDBusConnection &dbusConnection, const QString &cmName,
+            const QString &protocolName, const QVariantMap &parameters)
+        : BaseConnection(dbusConnection, cmName, protocolName, parameters)
+    { }
+
+    QString uniqueName() const { return QLatin1String("testconn"); }
+};
+
+class TestTextChannel : public BaseChannel
+{
+public:
+    TestTextChannel(const QDBusConnection &dbusConnection, BaseConnection *connection,
+            const QString &channelType, uint targetHandle, HandleType targetHandleType)
+        : BaseChannel(dbusConnection, connection, channelType, targetHandle, targetHandleType)
+    { }
+
+    QString uniqueName() const { return QLatin1String("TextChannel"); }
+};
+
+struct TextChannelService
+{
+    BaseConnectionPtr connection;
+    BaseChannelPtr channel;
+    BaseChannelTextTypePtr textType;
+};
+
+class TestBaseChannel : public Test
+{
+    Q_OBJECT
+public:
+    TestBaseChannel(QObject *parent = 0)
+        : Test(parent),
+          mThreadHelper(0),
+          mExpectedReceived(0)
+    { }
+
+private:
+    static void createChannelCb(TextChannelService &svc);
+    static void channelSvcSideCb(TextChannelService &svc);
+    static void receiveMessagesCb(TextChannelService &svc);
+    static void receiveManyMessagesCb(TextChannelService &svc);
+    static void receivePinnedMessagesCb(TextChannelService &svc);
+    static void noPendingMessagesCb(TextChannelService &svc);
+    static QString sendMessageCb(const MessagePartList &message, uint flags,
+            Tp::DBusError *error);
+
+protected Q_SLOTS:
+    void onReceived(uint id, uint timestamp, uint sender, uint type, uint flags,
+            const QString &text);
+    void onMessageReceived(const Tp::MessagePartList &message);
+    void onPendingMessagesRemoved(const Tp::UIntList &ids);
+    void onMessageSent(const Tp::MessagePartList &content, uint flags,
+            const QString &messageToken);
+    void onClosed();
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testChannelSvcSide();
+    void testChannelClientSide();
+    void testReceive();
+    void testSend();
+    void testClose();
+    void testReceiveLoad();
+    void testReceivePinnedLoad();
+
+    void cleanup();
+    void cleanupTestCase();
+
+private:
+    void waitForReceived(int count);
+
+    TestThreadHelper<TextChannelService> *mThreadHelper;
+    Client::ChannelInterface *mChanIface;
+    Client::ChannelTypeTextInterface *mTextIface;
+    Client::ChannelInterfaceMessagesInterface *mMessagesIface;
+
+    int mExpectedReceived;
+    QList<PendingTextMessage> mReceived;
+    MessagePartListList mMessagesReceived;
+    UIntList mRemoved;
+    QStringList mSentTokens;
+    bool mClosed;
+};
+
+void TestBaseChannel::createChannelCb(TextChannelService &svc)
+{
+    svc.connection = BaseConnection::create<TestConnection>(QLatin1String("testcm"),
+            QLatin1String("example"), QVariantMap());
+    Tp::DBusError err;
+    QVERIFY(svc.connection->registerObject(&err));
+    QVERIFY(!err.isValid());
+    QCOMPARE(svc.connection->busName(), connBusName());
+
+    svc.channel = BaseChannel::create<TestTextChannel>(svc.connection.data(),
+            TP_QT_IFACE_CHANNEL_TYPE_TEXT, 42, HandleTypeContact);
+    svc.channel->setTargetID(QLatin1String("alice"));
+    svc.channel->setRequested(false);
+    svc.channel->setInitiatorHandle(42);
+    svc.channel->setInitiatorID(QLatin1String("alice"));
+
+    svc.textType = BaseChannelTextType::create();
+    svc.textType->setSendMessageCallback(ptrFun(&TestBaseChannel::sendMessageCb));
+    QVERIFY(svc.channel->plugInterface(svc.textType));
+
+    BaseChannelMessagesInterfacePtr messagesIface =
+        BaseChannelMessagesInterface::create(svc.textType);
+    messagesIface->setSupportedContentTypes(QStringList() << QLatin1String("text/plain"));
+    messagesIface->setDeliveryReportingSupport(DeliveryReportingSupportFlagReceiveFailures);
+    QVERIFY(svc.channel->plugInterface(messagesIface));
+
+    QVERIFY(svc.channel->registerObject(&err));
+    QVERIFY(!err.isValid());
+    QCOMPARE(svc.channel->objectPath(), chanObjectPath());
+
+    // immutable properties and interfaces are fixed from now on
+    svc.channel->setTargetID(QLatin1String("bob"));
+    QCOMPARE(svc.channel->targetID(), QLatin1String("alice"));
+    QVERIFY(!svc.channel->plugInterface(BaseChannelTextType::create()));
+}
+
+QString TestBaseChannel::sendMessageCb(const MessagePartList &message, uint flags,
+        Tp::DBusError *error)
+{
+    Q_UNUSED(flags);
+
+    QString text = message.value(1).value(QLatin1String("content")).variant().toString();
+    if (text == QLatin1String("fail")) {
+        error->set(TP_QT_ERROR_NETWORK_ERROR, QLatin1String("Couldn't send the message"));
+        return QString();
+    }
+    return QLatin1String("token-") + text;
+}
+
+void TestBaseChannel::channelSvcSideCb(TextChannelService &svc)
+{
+    QVariantMap props = svc.channel->immutableProperties();
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".ChannelType")).toString(),
+            TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandle")).toUInt(), 42U);
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetHandleType")).toUInt(),
+            (uint) HandleTypeContact);
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".TargetID")).toString(),
+            QLatin1String("alice"));
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".Requested")).toBool(), false);
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorID")).toString(),
+            QLatin1String("alice"));
+    // the channel type is not one of the interfaces
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL + QLatin1String(".Interfaces")).toStringList(),
+            QStringList() << TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES);
+
+    //interface immutable properties should also be here
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES +
+                QLatin1String(".SupportedContentTypes")).toStringList(),
+            QStringList() << QLatin1String("text/plain"));
+    QCOMPARE(props.value(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES +
+                QLatin1String(".DeliveryReportingSupport")).toUInt(),
+            (uint) DeliveryReportingSupportFlagReceiveFailures);
+    QCOMPARE(qdbus_cast<UIntList>(props.value(TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES +
+                QLatin1String(".MessageTypes"))),
+            UIntList() << ChannelTextMessageTypeNormal << ChannelTextMessageTypeAction <<
+                ChannelTextMessageTypeNotice);
+
+    QCOMPARE(svc.channel->interfaces().size(), 2);
+    QVERIFY(svc.channel->interface(TP_QT_IFACE_CHANNEL_TYPE_TEXT) == svc.textType);
+}
+
+void TestBaseChannel::receiveMessagesCb(TextChannelService &svc)
+{
+    QCOMPARE(svc.textType->addReceivedMessage(textMessage(42, QLatin1String("one"))), 0U);
+    QCOMPARE(svc.textType->addReceivedMessage(textMessage(42, QLatin1String("two"))), 1U);
+    QCOMPARE(svc.textType->addReceivedMessage(textMessage(43, QLatin1String("three"))), 2U);
+    QCOMPARE(svc.textType->pendingMessageCount(), 3);
+}
+
+void TestBaseChannel::receiveManyMessagesCb(TextChannelService &svc)
+{
+    for (int i = 0; i < numLoadMessages; ++i) {
+        svc.textType->addReceivedMessage(textMessage(42, QLatin1String("hi")));
+    }
+}
+
+void TestBaseChannel::receivePinnedMessagesCb(TextChannelService &svc)
+{
+    // one message stays pending while lots of newer ones come and go
+    uint oldId = svc.textType->addReceivedMessage(textMessage(42, QLatin1String("old")));
+    for (int i = 0; i < numLoadMessages; ++i) {
+        uint id = svc.textType->addReceivedMessage(textMessage(43, QLatin1String("hi")));
+        QVERIFY(svc.textType->acknowledgePendingMessages(UIntList() << id, 0));
+    }
+
+    QCOMPARE(svc.textType->pendingMessageCount(), 1);
+    MessagePartListList pending = svc.textType->pendingMessages();
+    QCOMPARE(pending.size(), 1);
+    QCOMPARE(pending.at(0).at(0).value(
+                QLatin1String("pending-message-id")).variant().toUInt(), oldId);
+    QVERIFY(!svc.textType->pendingMessage(oldId).isEmpty());
+    QVERIFY(svc.textType->pendingMessage(oldId + 1).isEmpty());
+}
+
+void TestBaseChannel::noPendingMessagesCb(TextChannelService &svc)
+{
+    QCOMPARE(svc.textType->pendingMessageCount(), 0);
+    QVERIFY(svc.textType->pendingMessages().isEmpty());
+}
+
+void TestBaseChannel::onReceived(uint id, uint timestamp, uint sender, uint type, uint flags,
+        const QString &text)
+{
+    PendingTextMessage message;
+    message.identifier = id;
+    message.unixTimestamp = timestamp;
+    message.sender = sender;
+    message.messageType = type;
+    message.flags = flags;
+    message.text = text;
+    mReceived << message;
+}
+
+void TestBaseChannel::onMessageReceived(const Tp::MessagePartList &message)
+{
+    // don't keep all of them around in the load test
+    if (mMessagesReceived.size() < 10) {
+        mMessagesReceived << message;
+    }
+    if (--mExpectedReceived == 0) {
+        mLoop->exit(0);
+    }
+}
+
+void TestBaseChannel::onPendingMessagesRemoved(const Tp::UIntList &ids)
+{
+    mRemoved << ids;
+    mLoop->exit(0);
+}
+
+void TestBaseChannel::onMessageSent(const Tp::MessagePartList &content, uint flags,
+        const QString &messageToken)
+{
+    Q_UNUSED(content);
+    Q_UNUSED(flags);
+
+    mSentTokens << messageToken;
+    mLoop->exit(0);
+}
+
+void TestBaseChannel::onClosed()
+{
+    mClosed = true;
+    mLoop->exit(0);
+}
+
+void TestBaseChannel::waitForReceived(int count)
+{
+    mExpectedReceived = count;
+    QCOMPARE(mLoop->exec(), 0);
+}
+
+void TestBaseChannel::initTestCase()
+{
+    initTestCaseImpl();
+}
+
+void TestBaseChannel::init()
+{
+    initImpl();
+
+    mReceived.clear();
+    mMessagesReceived.clear();
+    mRemoved.clear();
+    mSentTokens.clear();
+    mClosed = false;
+
+    mThreadHelper = new TestThreadHelper<TextChannelService>();
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseChannel::createChannelCb);
+
+    mChanIface = new Client::ChannelInterface(connBusName(), chanObjectPath(), this);
+    mTextIface = new Client::ChannelTypeTextInterface(connBusName(), chanObjectPath(), this);
+    mMessagesIface = new Client::ChannelInterfaceMessagesInterface(connBusName(),
+            chanObjectPath(), this);
+
+    connect(mTextIface, SIGNAL(Received(uint,uint,uint,uint,uint,QString)),
+            SLOT(onReceived(uint,uint,uint,uint,uint,QString)));
+    connect(mMessagesIface, SIGNAL(MessageReceived(Tp::MessagePartList)),
+            SLOT(onMessageReceived(Tp::MessagePartList)));
+    connect(mMessagesIface, SIGNAL(PendingMessagesRemoved(Tp::UIntList)),
+            SLOT(onPendingMessagesRemoved(Tp::UIntList)));
+    connect(mMessagesIface, SIGNAL(MessageSent(Tp::MessagePartList,uint,QString)),
+            SLOT(onMessageSent(Tp::MessagePartList,uint,QString)));
+    connect(mChanIface, SIGNAL(Closed()), SLOT(onClosed()));
+}
+
+void TestBaseChannel::testChannelSvcSide()
+{
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseChannel::channelSvcSideCb);
+}
+
+void TestBaseChannel::testChannelClientSide()
+{
+    QDBusPendingReply<QString> type = mChanIface->GetChannelType();
+    type.waitForFinished();
+    QVERIFY(type.isValid());
+    QCOMPARE(type.value(), TP_QT_IFACE_CHANNEL_TYPE_TEXT);
+
+    QDBusPendingReply<uint, uint> handle = mChanIface->GetHandle();
+    handle.waitForFinished();
+    QVERIFY(handle.isValid());
+    QCOMPARE(handle.argumentAt<0>(), (uint) HandleTypeContact);
+    QCOMPARE(handle.argumentAt<1>(), 42U);
+
+    QDBusPendingReply<QStringList> interfaces = mChanIface->GetInterfaces();
+    interfaces.waitForFinished();
+    QVERIFY(interfaces.isValid());
+    QCOMPARE(interfaces.value(), QStringList() << TP_QT_IFACE_CHANNEL_INTERFACE_MESSAGES);
+
+    QDBusPendingReply<UIntList> types = mTextIface->GetMessageTypes();
+    types.waitForFinished();
+    QVERIFY(types.isValid());
+    QCOMPARE(types.value().size(), 3);
+}
+
+void TestBaseChannel::testReceive()
+{
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseChannel::receiveMessagesCb);
+    waitForReceived(3);
+
+    QCOMPARE(mMessagesReceived.size(), 3);
+    QCOMPARE(mMessagesReceived.at(1).at(0).value(
+                QLatin1String("pending-message-id")).variant().toUInt(), 1U);
+    QCOMPARE(mReceived.size(), 3);
+    QCOMPARE(mReceived.at(2).identifier, 2U);
+    QCOMPARE(mReceived.at(2).sender, 43U);
+    QCOMPARE(mReceived.at(2).unixTimestamp, 1234U);
+    QCOMPARE(mReceived.at(2).text, QLatin1String("three"));
+
+    QDBusPendingReply<PendingTextMessageList> pending = mTextIface->ListPendingMessages(false);
+    pending.waitForFinished();
+    QVERIFY(pending.isValid());
+    QCOMPARE(pending.value().size(), 3);
+    QCOMPARE(pending.value().at(0).text, QLatin1String("one"));
+
+    QDBusPendingReply<MessagePartContentMap> content =
+        mMessagesIface->GetPendingMessageContent(1, UIntList() << 1);
+    content.waitForFinished();
+    QVERIFY(content.isValid());
+    QCOMPARE(content.value().value(1).variant().toString(), QLatin1String("two"));
+
+    content = mMessagesIface->GetPendingMessageContent(1, UIntList() << 0);
+    content.waitForFinished();
+    QVERIFY(content.isError());
+    QCOMPARE(content.error().name(), TP_QT_ERROR_INVALID_ARGUMENT);
+
+    // an unknown id fails the whole call
+    QDBusPendingReply<> ack = mTextIface->AcknowledgePendingMessages(UIntList() << 0 << 999);
+    ack.waitForFinished();
+    QVERIFY(ack.isError());
+    QCOMPARE(ack.error().name(), TP_QT_ERROR_INVALID_ARGUMENT);
+
+    // acknowledging out of order
+    ack = mTextIface->AcknowledgePendingMessages(UIntList() << 1);
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mRemoved, UIntList() << 1);
+    ack.waitForFinished();
+    QVERIFY(ack.isValid());
+
+    pending = mTextIface->ListPendingMessages(false);
+    pending.waitForFinished();
+    QCOMPARE(pending.value().size(), 2);
+    QCOMPARE(pending.value().at(1).identifier, 2U);
+
+    ack = mTextIface->AcknowledgePendingMessages(UIntList() << 1);
+    ack.waitForFinished();
+    QVERIFY(ack.isError());
+
+    ack = mTextIface->AcknowledgePendingMessages(UIntList() << 2 << 0);
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mRemoved, UIntList() << 1 << 2 << 0);
+    ack.waitForFinished();
+    QVERIFY(ack.isValid());
+
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseChannel::noPendingMessagesCb);
+}
+
+void TestBaseChannel::testSend()
+{
+    MessagePartList message = textMessage(0, QLatin1String("hello"));
+    QDBusPendingReply<QString> sent = mMessagesIface->SendMessage(message, 0);
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mSentTokens, QStringList() << QLatin1String("token-hello"));
+    sent.waitForFinished();
+    QVERIFY(sent.isValid());
+    QCOMPARE(sent.value(), QLatin1String("token-hello"));
+
+    QDBusPendingReply<> legacySent = mTextIface->Send(ChannelTextMessageTypeNormal,
+            QLatin1String("fail"));
+    legacySent.waitForFinished();
+    QVERIFY(legacySent.isError());
+    QCOMPARE(legacySent.error().name(), TP_QT_ERROR_NETWORK_ERROR);
+    QCOMPARE(mSentTokens.size(), 1);
+}
+
+void TestBaseChannel::testClose()
+{
+    QDBusPendingReply<> closed = mChanIface->Close();
+    QCOMPARE(mLoop->exec(), 0);
+    QVERIFY(mClosed);
+    closed.waitForFinished();
+    QVERIFY(closed.isValid());
+}
+
+void TestBaseChannel::testReceiveLoad()
+{
+    QTime time;
+    time.start();
+
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseChannel::receiveManyMessagesCb);
+    waitForReceived(numLoadMessages);
+
+    int elapsed = qMax(time.elapsed(), 1);
+    qDebug() << numLoadMessages << "messages received in" << elapsed << "ms," <<
+        (numLoadMessages * 1000LL / elapsed) << "messages/s";
+    QCOMPARE(mReceived.size(), numLoadMessages);
+    for (int i = 0; i < numLoadMessages; ++i) {
+        QCOMPARE(mReceived.at(i).identifier, static_cast<uint>(i));
+    }
+
+    UIntList ids;
+    for (int i = 0; i < numLoadMessages; ++i) {
+        ids << i;
+    }
+    time.restart();
+    QDBusPendingReply<> ack = mTextIface->AcknowledgePendingMessages(ids);
+    QCOMPARE(mLoop->exec(), 0);
+    qDebug() << numLoadMessages << "messages acknowledged in" << time.elapsed() << "ms";
+    QCOMPARE(mRemoved.size(), numLoadMessages);
+    ack.waitForFinished();
+    QVERIFY(ack.isValid());
+
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseChannel::noPendingMessagesCb);
+}
+
+void TestBaseChannel::testReceivePinnedLoad()
+{
+    // only the final state matters here, not the signals for every message
+    mTextIface->disconnect(this);
+    mMessagesIface->disconnect(this);
+
+    QTime time;
+    time.start();
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseChannel::receivePinnedMessagesCb);
+    qDebug() << numLoadMessages << "messages received and acknowledged behind a pending one in" <<
+        time.elapsed() << "ms";
+
+    // the reply comes after all the signals sent in the meantime
+    QDBusPendingReply<PendingTextMessageList> pending = mTextIface->ListPendingMessages(false);
+    pending.waitForFinished();
+    QVERIFY(pending.isValid());
+    QCOMPARE(pending.value().size(), 1);
+    QCOMPARE(pending.value().at(0).identifier, 0U);
+    QCOMPARE(pending.value().at(0).text, QLatin1String("old"));
+}
+
+void TestBaseChannel::cleanup()
+{
+    delete mMessagesIface;
+    delete mTextIface;
+    delete mChanIface;
+    delete mThreadHelper;
+    cleanupImpl();
+}
+
+void TestBaseChannel::cleanupTestCase()
+{
+    cleanupTestCaseImpl();
+}
+
+QTEST_MAIN(TestBaseChannel)
+#include "_gen/base-channel.cpp.moc.hpp"
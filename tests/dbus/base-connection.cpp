@@ -0,0 +1,732 @@
+#include <tests/lib/test.h>
+#include <tests/lib/test-thread-helper.h>
+
+#include <TelepathyQt/BaseConnection>
+#include <TelepathyQt/Connection>
+#include <TelepathyQt/Constants>
+#include <TelepathyQt/DBusError>
+
+using namespace Tp;
+
+namespace
+{
+
+// How many times the normalization callback has been called
+int normalizeCount = 0;
+
+// The last presence set with SetPresence
+QString selfStatus;
+QString selfStatusMessage;
+
+QString connBusName()
+{
+    return TP_QT_CONNECTION_BUS_NAME_BASE + QLatin1String("testcm.example.testconn");
+}
+
+QString connObjectPath()
+{
+    return TP_QT_CONNECTION_OBJECT_PATH_BASE + QLatin1String("testcm/example/testconn");
+}
+
+QString aliasAttribute()
+{
+    return TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING + QLatin1String("/alias");
+}
+
+QString contactIdAttribute()
+{
+    return TP_QT_IFACE_CONNECTION + QLatin1String("/contact-id");
+}
+
+}
+
+class TestConnection : public BaseConnection
+{
+public:
+    TestConnection(const QDBusConnection &dbusConnection, const QString &cmName,
+            const QString &protocolName, const QVariantMap &parameters)
+        : BaseConnection(dbusConnection, cmName, protocolName, parameters)
+    { }
+
+    QString uniqueName() const { return QLatin1String("testconn"); }
+};
+
+class TestBaseConnection : public Test
+{
+    Q_OBJECT
+public:
+    TestBaseConnection(QObject *parent = 0)
+        : Test(parent),
+          mThreadHelper(0),
+          mSelfHandle(0),
+          mExpectedAvatarUpdates(0)
+    { }
+
+private:
+    static void createConnectionCb(BaseConnectionPtr &connection);
+    static void connectionSvcSideCb(BaseConnectionPtr &connection);
+    static void setAttributesCb(BaseConnectionPtr &connection);
+    static void setSelfHandleCb(BaseConnectionPtr &connection);
+    static void updatePresencesCb(BaseConnectionPtr &connection);
+    static void checkPresenceStatsCb(BaseConnectionPtr &connection);
+    static void updateAliasesCb(BaseConnectionPtr &connection);
+    static void updateAvatarTokensCb(BaseConnectionPtr &connection);
+    static QString normalizeContactCb(const QString &contactId, Tp::DBusError *error);
+    static void setPresenceCb(const QString &status, const QString &statusMessage,
+            Tp::DBusError *error);
+
+protected Q_SLOTS:
+    void onSelfHandleChanged(uint selfHandle);
+    void onPresencesChanged(const Tp::SimpleContactPresences &presences);
+    void onAliasesChanged(const Tp::AliasPairList &aliases);
+    void onAvatarUpdated(uint contact, const QString &token);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testConnectionSvcSide();
+    void testProperties();
+    void testRequestHandles();
+    void testInvalidHandles();
+    void testRoomHandles();
+    void testContactAttributes();
+    void testSetPresence();
+    void testPresences();
+    void testAliases();
+    void testAvatarTokens();
+
+    void cleanup();
+    void cleanupTestCase();
+
+private:
+    TestThreadHelper<BaseConnectionPtr> *mThreadHelper;
+    Client::ConnectionInterface *mConnIface;
+    Client::ConnectionInterfaceContactsInterface *mContactsIface;
+    Client::ConnectionInterfaceSimplePresenceInterface *mPresenceIface;
+    Client::ConnectionInterfaceAliasingInterface *mAliasingIface;
+    Client::ConnectionInterfaceAvatarsInterface *mAvatarsIface;
+    uint mSelfHandle;
+    QList<SimpleContactPresences> mPresencesChanged;
+    QList<AliasPairList> mAliasesChanged;
+    AvatarTokenMap mAvatarsUpdated;
+    int mExpectedAvatarUpdates;
+};
+
+void TestBaseConnection::createConnectionCb(BaseConnectionPtr &connection)
+{
+    connection = BaseConnection::create<TestConnection>(QLatin1String("testcm"),
+            QLatin1String("example"), QVariantMap());
+    connection->setNormalizeContactCallback(ptrFun(&TestBaseConnection::normalizeContactCb));
+    connection->setContactAttributeInterfaces(QStringList() <<
+            TP_QT_IFACE_CONNECTION << TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING);
+    QVERIFY(connection->plugInterface(BaseConnectionContactsInterface::create()));
+
+    BaseConnectionSimplePresenceInterfacePtr presenceIface =
+        BaseConnectionSimplePresenceInterface::create();
+    presenceIface->setStatuses(PresenceSpecList() << PresenceSpec::available() <<
+            PresenceSpec::away() << PresenceSpec::offline());
+    presenceIface->setSetPresenceCallback(ptrFun(&TestBaseConnection::setPresenceCb));
+    QVERIFY(connection->plugInterface(presenceIface));
+
+    BaseConnectionAliasingInterfacePtr aliasingIface = BaseConnectionAliasingInterface::create();
+    aliasingIface->setAliasFlags(ConnectionAliasFlagUserSet);
+    // announce the aliases as soon as possible
+    aliasingIface->setEmissionWindow(0);
+    QVERIFY(connection->plugInterface(aliasingIface));
+
+    QVERIFY(connection->plugInterface(BaseConnectionAvatarsInterface::create()));
+
+    Tp::DBusError err;
+    QVERIFY(connection->registerObject(&err));
+    QVERIFY(!err.isValid());
+    QCOMPARE(connection->busName(), connBusName());
+    QCOMPARE(connection->objectPath(), connObjectPath());
+
+    // interfaces are fixed from now on
+    QVERIFY(!connection->plugInterface(BaseConnectionContactsInterface::create()));
+    connection->setContactAttributeInterfaces(QStringList());
+    QCOMPARE(connection->contactAttributeInterfaces().size(), 2);
+}
+
+QString TestBaseConnection::normalizeContactCb(const QString &contactId,
+        Tp::DBusError *error)
+{
+    ++normalizeCount;
+    if (contactId.contains(QLatin1Char(' '))) {
+        error->set(TP_QT_ERROR_INVALID_HANDLE, QLatin1String("Spaces are not allowed"));
+        return QString();
+    }
+    return contactId.toLower();
+}
+
+void TestBaseConnection::setPresenceCb(const QString &status, const QString &statusMessage,
+        Tp::DBusError *error)
+{
+    Q_UNUSED(error);
+
+    selfStatus = status;
+    selfStatusMessage = statusMessage;
+}
+
+void TestBaseConnection::connectionSvcSideCb(BaseConnectionPtr &connection)
+{
+    Tp::DBusError err;
+    normalizeCount = 0;
+    UIntList handles = connection->ensureHandles(HandleTypeContact,
+            QStringList() << QLatin1String("Alice") << QLatin1String("ALICE") <<
+                QLatin1String("bob") << QLatin1String("Alice"), &err);
+    QVERIFY(!err.isValid());
+    QCOMPARE(handles, UIntList() << 1 << 1 << 2 << 1);
+    // once per identifier which has no handle yet
+    QCOMPARE(normalizeCount, 3);
+
+    // normalized identifiers are found without normalizing them again
+    QCOMPARE(connection->ensureHandle(HandleTypeContact, QLatin1String("alice"), &err), 1U);
+    QCOMPARE(normalizeCount, 3);
+
+    QCOMPARE(connection->inspectHandles(HandleTypeContact, UIntList() << 2 << 1, &err),
+            QStringList() << QLatin1String("bob") << QLatin1String("alice"));
+    QVERIFY(connection->checkHandles(HandleTypeContact, UIntList() << 1 << 2, &err));
+    QVERIFY(!err.isValid());
+
+    QVERIFY(!connection->checkHandles(HandleTypeContact, UIntList() << 1 << 3, &err));
+    QCOMPARE(err.name(), TP_QT_ERROR_INVALID_HANDLE);
+
+    QCOMPARE(connection->interfaces().size(), 4);
+    QVERIFY(!connection->interface(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS).isNull());
+    QCOMPARE(connection->interface(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS)->connection(),
+            connection.data());
+
+    QVariantMap props = connection->immutableProperties();
+    QCOMPARE(props.value(TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS +
+                QLatin1String(".ContactAttributeInterfaces")).toStringList(),
+            connection->contactAttributeInterfaces());
+}
+
+void TestBaseConnection::setAttributesCb(BaseConnectionPtr &connection)
+{
+    Tp::DBusError err;
+    UIntList handles = connection->ensureHandles(HandleTypeContact,
+            QStringList() << QLatin1String("alice") << QLatin1String("bob") <<
+                QLatin1String("carol"), &err);
+    QVERIFY(!err.isValid());
+
+    QVariantMap attributes;
+    attributes.insert(aliasAttribute(), QLatin1String("Alice"));
+    attributes.insert(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS + QLatin1String("/token"),
+            QLatin1String("abc"));
+    connection->setContactAttributes(handles[0], attributes);
+    connection->setContactAttribute(handles[1], aliasAttribute(), QLatin1String("Bob"));
+    // unset again
+    connection->setContactAttribute(handles[1], aliasAttribute(), QVariant());
+
+    // neither of these is stored
+    connection->setContactAttribute(handles[2], QLatin1String("alias"), QLatin1String("Carol"));
+    connection->setContactAttribute(42, aliasAttribute(), QLatin1String("Nobody"));
+}
+
+void TestBaseConnection::setSelfHandleCb(BaseConnectionPtr &connection)
+{
+    Tp::DBusError err;
+    uint handle = connection->ensureHandle(HandleTypeContact, QLatin1String("Me"), &err);
+    QVERIFY(!err.isValid());
+    connection->setSelfHandle(handle);
+    QCOMPARE(connection->selfHandle(), handle);
+}
+
+void TestBaseConnection::updatePresencesCb(BaseConnectionPtr &connection)
+{
+    Tp::DBusError err;
+    UIntList handles = connection->ensureHandles(HandleTypeContact,
+            QStringList() << QLatin1String("alice") << QLatin1String("bob"), &err);
+    QVERIFY(!err.isValid());
+
+    BaseConnectionSimplePresenceInterfacePtr iface =
+        BaseConnectionSimplePresenceInterfacePtr::qObjectCast(
+                connection->interface(TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE));
+    QVERIFY(!iface.isNull());
+    QCOMPARE(iface->emissionWindow(), 100);
+
+    // a contact going back and forth, as seen when a client reconnects a lot
+    for (int i = 0; i < 100; ++i) {
+        SimpleContactPresences presences;
+        presences.insert(handles[0], PresenceSpec::available().presence(
+                    QString::number(i)).barePresence());
+        iface->updatePresences(presences);
+    }
+    SimpleContactPresences presences;
+    presences.insert(handles[1], PresenceSpec::away().presence().barePresence());
+    iface->updatePresences(presences);
+
+    // stored straight away
+    QCOMPARE(iface->presences(handles).value(handles[0]).statusMessage, QLatin1String("99"));
+
+    ContactChangeStats stats = iface->changeStats();
+    QCOMPARE(stats.updates, 101U);
+    QCOMPARE(stats.mergedUpdates, 99U);
+    QCOMPARE(stats.batches, 0U);
+}
+
+void TestBaseConnection::checkPresenceStatsCb(BaseConnectionPtr &connection)
+{
+    BaseConnectionSimplePresenceInterfacePtr iface =
+        BaseConnectionSimplePresenceInterfacePtr::qObjectCast(
+                connection->interface(TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE));
+    ContactChangeStats stats = iface->changeStats();
+    QCOMPARE(stats.updates, 101U);
+    QCOMPARE(stats.batches, 1U);
+}
+
+void TestBaseConnection::updateAliasesCb(BaseConnectionPtr &connection)
+{
+    Tp::DBusError err;
+    UIntList handles = connection->ensureHandles(HandleTypeContact,
+            QStringList() << QLatin1String("alice") << QLatin1String("bob") <<
+                QLatin1String("carol"), &err);
+    QVERIFY(!err.isValid());
+
+    BaseConnectionAliasingInterfacePtr iface =
+        BaseConnectionAliasingInterfacePtr::qObjectCast(
+                connection->interface(TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING));
+    QVERIFY(!iface.isNull());
+
+    AliasMap aliases;
+    aliases.insert(handles[1], QLatin1String("Bobby"));
+    iface->updateAliases(aliases);
+    aliases.clear();
+    aliases.insert(handles[0], QLatin1String("Alice"));
+    aliases.insert(handles[1], QLatin1String("Bob"));
+    iface->updateAliases(aliases);
+    // invalid handles are not announced
+    aliases.clear();
+    aliases.insert(42, QLatin1String("Nobody"));
+    iface->updateAliases(aliases);
+
+    ContactChangeStats stats = iface->changeStats();
+    QCOMPARE(stats.updates, 3U);
+    QCOMPARE(stats.mergedUpdates, 1U);
+}
+
+void TestBaseConnection::updateAvatarTokensCb(BaseConnectionPtr &connection)
+{
+    Tp::DBusError err;
+    UIntList handles = connection->ensureHandles(HandleTypeContact,
+            QStringList() << QLatin1String("alice") << QLatin1String("bob"), &err);
+    QVERIFY(!err.isValid());
+
+    BaseConnectionAvatarsInterfacePtr iface =
+        BaseConnectionAvatarsInterfacePtr::qObjectCast(
+                connection->interface(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS));
+    QVERIFY(!iface.isNull());
+
+    AvatarTokenMap tokens;
+    tokens.insert(handles[0], QLatin1String("a"));
+    iface->updateAvatarTokens(tokens);
+    tokens.insert(handles[0], QLatin1String("b"));
+    tokens.insert(handles[1], QLatin1String("c"));
+    iface->updateAvatarTokens(tokens);
+
+    QCOMPARE(iface->changeStats().mergedUpdates, 1U);
+}
+
+void TestBaseConnection::onSelfHandleChanged(uint selfHandle)
+{
+    mSelfHandle = selfHandle;
+    mLoop->exit(0);
+}
+
+void TestBaseConnection::onPresencesChanged(const Tp::SimpleContactPresences &presences)
+{
+    mPresencesChanged << presences;
+    mLoop->exit(0);
+}
+
+void TestBaseConnection::onAliasesChanged(const Tp::AliasPairList &aliases)
+{
+    mAliasesChanged << aliases;
+    mLoop->exit(0);
+}
+
+void TestBaseConnection::onAvatarUpdated(uint contact, const QString &token)
+{
+    mAvatarsUpdated.insert(contact, token);
+    if (--mExpectedAvatarUpdates == 0) {
+        mLoop->exit(0);
+    }
+}
+
+void TestBaseConnection::initTestCase()
+{
+    initTestCaseImpl();
+}
+
+void TestBaseConnection::init()
+{
+    initImpl();
+
+    mSelfHandle = 0;
+    mPresencesChanged.clear();
+    mAliasesChanged.clear();
+    mAvatarsUpdated.clear();
+    mExpectedAvatarUpdates = 0;
+    selfStatus.clear();
+    selfStatusMessage.clear();
+
+    mThreadHelper = new TestThreadHelper<BaseConnectionPtr>();
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::createConnectionCb);
+
+    mConnIface = new Client::ConnectionInterface(connBusName(), connObjectPath(), this);
+    mContactsIface = new Client::ConnectionInterfaceContactsInterface(connBusName(),
+            connObjectPath(), this);
+
+    mPresenceIface = new Client::ConnectionInterfaceSimplePresenceInterface(connBusName(),
+            connObjectPath(), this);
+    mAliasingIface = new Client::ConnectionInterfaceAliasingInterface(connBusName(),
+            connObjectPath(), this);
+    mAvatarsIface = new Client::ConnectionInterfaceAvatarsInterface(connBusName(),
+            connObjectPath(), this);
+
+    connect(mConnIface, SIGNAL(SelfHandleChanged(uint)), SLOT(onSelfHandleChanged(uint)));
+    connect(mPresenceIface, SIGNAL(PresencesChanged(Tp::SimpleContactPresences)),
+            SLOT(onPresencesChanged(Tp::SimpleContactPresences)));
+    connect(mAliasingIface, SIGNAL(AliasesChanged(Tp::AliasPairList)),
+            SLOT(onAliasesChanged(Tp::AliasPairList)));
+    connect(mAvatarsIface, SIGNAL(AvatarUpdated(uint,QString)),
+            SLOT(onAvatarUpdated(uint,QString)));
+}
+
+void TestBaseConnection::testConnectionSvcSide()
+{
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::connectionSvcSideCb);
+}
+
+void TestBaseConnection::testProperties()
+{
+    QStringList interfaces;
+    QVERIFY(waitForProperty(mConnIface->requestPropertyInterfaces(), &interfaces));
+    QCOMPARE(interfaces.toSet(), QSet<QString>() <<
+            TP_QT_IFACE_CONNECTION_INTERFACE_CONTACTS <<
+            TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE <<
+            TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING <<
+            TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS);
+
+    bool immortal = false;
+    QVERIFY(waitForProperty(mConnIface->requestPropertyHasImmortalHandles(), &immortal));
+    QVERIFY(immortal);
+
+    QStringList attributeInterfaces;
+    QVERIFY(waitForProperty(mContactsIface->requestPropertyContactAttributeInterfaces(),
+                &attributeInterfaces));
+    QCOMPARE(attributeInterfaces, QStringList() <<
+            TP_QT_IFACE_CONNECTION << TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING);
+
+    QDBusPendingReply<QString> protocol = mConnIface->GetProtocol();
+    protocol.waitForFinished();
+    QVERIFY(protocol.isValid());
+    QCOMPARE(protocol.value(), QLatin1String("example"));
+
+    QDBusPendingReply<uint> selfHandle = mConnIface->GetSelfHandle();
+    selfHandle.waitForFinished();
+    QVERIFY(selfHandle.isValid());
+    QCOMPARE(selfHandle.value(), 0U);
+
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::setSelfHandleCb);
+    if (!mSelfHandle) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+    QCOMPARE(mSelfHandle, 1U);
+
+    QDBusPendingReply<QStringList> ids = mConnIface->InspectHandles(HandleTypeContact,
+            UIntList() << mSelfHandle);
+    ids.waitForFinished();
+    QVERIFY(ids.isValid());
+    QCOMPARE(ids.value(), QStringList() << QLatin1String("me"));
+}
+
+void TestBaseConnection::testRequestHandles()
+{
+    QDBusPendingReply<UIntList> handles = mConnIface->RequestHandles(HandleTypeContact,
+            QStringList() << QLatin1String("Alice") << QLatin1String("Bob") <<
+                QLatin1String("alice"));
+    handles.waitForFinished();
+    QVERIFY(handles.isValid());
+    QCOMPARE(handles.value(), UIntList() << 1 << 2 << 1);
+
+    // the same identifiers always get the same handles
+    handles = mConnIface->RequestHandles(HandleTypeContact,
+            QStringList() << QLatin1String("bob") << QLatin1String("carol"));
+    handles.waitForFinished();
+    QVERIFY(handles.isValid());
+    QCOMPARE(handles.value(), UIntList() << 2 << 3);
+
+    QDBusPendingReply<QStringList> ids = mConnIface->InspectHandles(HandleTypeContact,
+            UIntList() << 3 << 1 << 2);
+    ids.waitForFinished();
+    QVERIFY(ids.isValid());
+    QCOMPARE(ids.value(), QStringList() << QLatin1String("carol") <<
+            QLatin1String("alice") << QLatin1String("bob"));
+
+    QDBusPendingReply<> hold = mConnIface->HoldHandles(HandleTypeContact, UIntList() << 1 << 2);
+    hold.waitForFinished();
+    QVERIFY(hold.isValid());
+
+    QDBusPendingReply<> release = mConnIface->ReleaseHandles(HandleTypeContact,
+            UIntList() << 1 << 2);
+    release.waitForFinished();
+    QVERIFY(release.isValid());
+
+    // handles are immortal
+    ids = mConnIface->InspectHandles(HandleTypeContact, UIntList() << 1);
+    ids.waitForFinished();
+    QVERIFY(ids.isValid());
+    QCOMPARE(ids.value(), QStringList() << QLatin1String("alice"));
+}
+
+void TestBaseConnection::testInvalidHandles()
+{
+    QDBusPendingReply<UIntList> handles = mConnIface->RequestHandles(HandleTypeContact,
+            QStringList() << QLatin1String("alice") << QLatin1String("not valid"));
+    handles.waitForFinished();
+    QVERIFY(handles.isError());
+    QCOMPARE(handles.error().name(), TP_QT_ERROR_INVALID_HANDLE);
+
+    handles = mConnIface->RequestHandles(HandleTypeContact, QStringList() << QString());
+    handles.waitForFinished();
+    QVERIFY(handles.isError());
+    QCOMPARE(handles.error().name(), TP_QT_ERROR_INVALID_HANDLE);
+
+    handles = mConnIface->RequestHandles(HandleTypeGroup,
+            QStringList() << QLatin1String("friends"));
+    handles.waitForFinished();
+    QVERIFY(handles.isError());
+    QCOMPARE(handles.error().name(), TP_QT_ERROR_INVALID_ARGUMENT);
+
+    QDBusPendingReply<QStringList> ids = mConnIface->InspectHandles(HandleTypeContact,
+            UIntList() << 1 << 42);
+    ids.waitForFinished();
+    QVERIFY(ids.isError());
+    QCOMPARE(ids.error().name(), TP_QT_ERROR_INVALID_HANDLE);
+
+    QDBusPendingReply<> hold = mConnIface->HoldHandles(HandleTypeContact, UIntList() << 42);
+    hold.waitForFinished();
+    QVERIFY(hold.isError());
+    QCOMPARE(hold.error().name(), TP_QT_ERROR_INVALID_HANDLE);
+}
+
+void TestBaseConnection::testRoomHandles()
+{
+    QDBusPendingReply<UIntList> handles = mConnIface->RequestHandles(HandleTypeRoom,
+            QStringList() << QLatin1String("Lobby") << QLatin1String("lobby"));
+    handles.waitForFinished();
+    QVERIFY(handles.isValid());
+    // room identifiers are not normalized, and have handles of their own
+    QCOMPARE(handles.value(), UIntList() << 1 << 2);
+
+    QDBusPendingReply<QStringList> ids = mConnIface->InspectHandles(HandleTypeRoom,
+            UIntList() << 1 << 2);
+    ids.waitForFinished();
+    QVERIFY(ids.isValid());
+    QCOMPARE(ids.value(), QStringList() << QLatin1String("Lobby") << QLatin1String("lobby"));
+
+    ids = mConnIface->InspectHandles(HandleTypeContact, UIntList() << 1);
+    ids.waitForFinished();
+    QVERIFY(ids.isError());
+    QCOMPARE(ids.error().name(), TP_QT_ERROR_INVALID_HANDLE);
+}
+
+void TestBaseConnection::testContactAttributes()
+{
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::setAttributesCb);
+
+    QDBusPendingReply<ContactAttributesMap> attrs = mContactsIface->GetContactAttributes(
+            UIntList() << 1 << 2 << 3 << 42,
+            QStringList() << TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING, true);
+    attrs.waitForFinished();
+    QVERIFY(attrs.isValid());
+
+    ContactAttributesMap map = attrs.value();
+    // invalid handles are left out
+    QCOMPARE(map.size(), 3);
+    QCOMPARE(map.value(1).size(), 2);
+    QCOMPARE(map.value(1).value(contactIdAttribute()).toString(), QLatin1String("alice"));
+    QCOMPARE(map.value(1).value(aliasAttribute()).toString(), QLatin1String("Alice"));
+    QCOMPARE(map.value(2).size(), 1);
+    QCOMPARE(map.value(2).value(contactIdAttribute()).toString(), QLatin1String("bob"));
+    QCOMPARE(map.value(3).size(), 1);
+    QCOMPARE(map.value(3).value(contactIdAttribute()).toString(), QLatin1String("carol"));
+
+    // the contact identifiers are always there
+    attrs = mContactsIface->GetContactAttributes(UIntList() << 1, QStringList(), false);
+    attrs.waitForFinished();
+    QVERIFY(attrs.isValid());
+    map = attrs.value();
+    QCOMPARE(map.size(), 1);
+    QCOMPARE(map.value(1).size(), 1);
+    QCOMPARE(map.value(1).value(contactIdAttribute()).toString(), QLatin1String("alice"));
+
+    attrs = mContactsIface->GetContactAttributes(UIntList() << 1,
+            QStringList() << TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS <<
+                TP_QT_IFACE_CONNECTION_INTERFACE_ALIASING, false);
+    attrs.waitForFinished();
+    QVERIFY(attrs.isValid());
+    map = attrs.value();
+    QCOMPARE(map.value(1).size(), 3);
+    QCOMPARE(map.value(1).value(TP_QT_IFACE_CONNECTION_INTERFACE_AVATARS +
+                QLatin1String("/token")).toString(), QLatin1String("abc"));
+}
+
+void TestBaseConnection::testSetPresence()
+{
+    SimpleStatusSpecMap statuses;
+    QVERIFY(waitForProperty(mPresenceIface->requestPropertyStatuses(), &statuses));
+    QCOMPARE(statuses.size(), 3);
+    QVERIFY(statuses.contains(QLatin1String("away")));
+
+    QDBusPendingReply<> reply = mPresenceIface->SetPresence(QLatin1String("away"),
+            QLatin1String("back soon"));
+    reply.waitForFinished();
+    QVERIFY(reply.isValid());
+    QCOMPARE(selfStatus, QLatin1String("away"));
+    QCOMPARE(selfStatusMessage, QLatin1String("back soon"));
+
+    // offline can't be set on the user, and busy is not supported at all
+    reply = mPresenceIface->SetPresence(QLatin1String("offline"), QString());
+    reply.waitForFinished();
+    QVERIFY(reply.isError());
+    QCOMPARE(reply.error().name(), TP_QT_ERROR_INVALID_ARGUMENT);
+
+    reply = mPresenceIface->SetPresence(QLatin1String("busy"), QString());
+    reply.waitForFinished();
+    QVERIFY(reply.isError());
+    QCOMPARE(reply.error().name(), TP_QT_ERROR_INVALID_ARGUMENT);
+    QCOMPARE(selfStatus, QLatin1String("away"));
+}
+
+void TestBaseConnection::testPresences()
+{
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::updatePresencesCb);
+
+    // all the changes come in one signal, with the latest presence of each contact
+    while (mPresencesChanged.isEmpty()) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+    QCOMPARE(mPresencesChanged.size(), 1);
+    SimpleContactPresences presences = mPresencesChanged.first();
+    QCOMPARE(presences.size(), 2);
+    QCOMPARE(presences.value(1).status, QLatin1String("available"));
+    QCOMPARE(presences.value(1).statusMessage, QLatin1String("99"));
+    QCOMPARE(presences.value(2).status, QLatin1String("away"));
+
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::checkPresenceStatsCb);
+
+    QDBusPendingReply<UIntList> handles = mConnIface->RequestHandles(HandleTypeContact,
+            QStringList() << QLatin1String("carol"));
+    handles.waitForFinished();
+    QVERIFY(handles.isValid());
+
+    QDBusPendingReply<SimpleContactPresences> reply = mPresenceIface->GetPresences(
+            UIntList() << 1 << handles.value());
+    reply.waitForFinished();
+    QVERIFY(reply.isValid());
+    presences = reply.value();
+    QCOMPARE(presences.value(1).statusMessage, QLatin1String("99"));
+    QCOMPARE(presences.value(handles.value().first()).type,
+            (uint) ConnectionPresenceTypeUnknown);
+
+    reply = mPresenceIface->GetPresences(UIntList() << 42);
+    reply.waitForFinished();
+    QVERIFY(reply.isError());
+    QCOMPARE(reply.error().name(), TP_QT_ERROR_INVALID_HANDLE);
+
+    QDBusPendingReply<ContactAttributesMap> attrs = mContactsIface->GetContactAttributes(
+            UIntList() << 2,
+            QStringList() << TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE, false);
+    attrs.waitForFinished();
+    QVERIFY(attrs.isValid());
+    SimplePresence presence = qdbus_cast<SimplePresence>(attrs.value().value(2).value(
+                TP_QT_IFACE_CONNECTION_INTERFACE_SIMPLE_PRESENCE + QLatin1String("/presence")));
+    QCOMPARE(presence.status, QLatin1String("away"));
+}
+
+void TestBaseConnection::testAliases()
+{
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::updateAliasesCb);
+
+    while (mAliasesChanged.isEmpty()) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+    QCOMPARE(mAliasesChanged.size(), 1);
+    // in the order of the first change of each contact
+    AliasPairList aliases = mAliasesChanged.first();
+    QCOMPARE(aliases.size(), 2);
+    QCOMPARE(aliases[0].handle, 2U);
+    QCOMPARE(aliases[0].alias, QLatin1String("Bob"));
+    QCOMPARE(aliases[1].handle, 1U);
+    QCOMPARE(aliases[1].alias, QLatin1String("Alice"));
+
+    QDBusPendingReply<uint> flags = mAliasingIface->GetAliasFlags();
+    flags.waitForFinished();
+    QVERIFY(flags.isValid());
+    QCOMPARE(flags.value(), (uint) ConnectionAliasFlagUserSet);
+
+    // contacts without an alias get their identifier
+    QDBusPendingReply<QStringList> requested = mAliasingIface->RequestAliases(
+            UIntList() << 3 << 1);
+    requested.waitForFinished();
+    QVERIFY(requested.isValid());
+    QCOMPARE(requested.value(), QStringList() << QLatin1String("carol") <<
+            QLatin1String("Alice"));
+
+    QDBusPendingReply<AliasMap> reply = mAliasingIface->GetAliases(UIntList() << 2);
+    reply.waitForFinished();
+    QVERIFY(reply.isValid());
+    QCOMPARE(reply.value().value(2), QLatin1String("Bob"));
+
+    // no callback to set aliases
+    AliasMap newAliases;
+    newAliases.insert(1, QLatin1String("Al"));
+    QDBusPendingReply<> set = mAliasingIface->SetAliases(newAliases);
+    set.waitForFinished();
+    QVERIFY(set.isError());
+    QCOMPARE(set.error().name(), TP_QT_ERROR_NOT_IMPLEMENTED);
+}
+
+void TestBaseConnection::testAvatarTokens()
+{
+    mExpectedAvatarUpdates = 2;
+    TEST_THREAD_HELPER_EXECUTE(mThreadHelper, &TestBaseConnection::updateAvatarTokensCb);
+    if (mExpectedAvatarUpdates > 0) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+
+    // one signal per contact, with its latest token
+    QCOMPARE(mAvatarsUpdated.size(), 2);
+    QCOMPARE(mAvatarsUpdated.value(1), QLatin1String("b"));
+    QCOMPARE(mAvatarsUpdated.value(2), QLatin1String("c"));
+
+    QDBusPendingReply<AvatarTokenMap> tokens = mAvatarsIface->GetKnownAvatarTokens(
+            UIntList() << 1 << 2);
+    tokens.waitForFinished();
+    QVERIFY(tokens.isValid());
+    QCOMPARE(tokens.value(), mAvatarsUpdated);
+}
+
+void TestBaseConnection::cleanup()
+{
+    delete mAvatarsIface;
+    delete mAliasingIface;
+    delete mPresenceIface;
+    delete mContactsIface;
+    delete mConnIface;
+    delete mThreadHelper;
+    cleanupImpl();
+}
+
+void TestBaseConnection::cleanupTestCase()
+{
+    cleanupTestCaseImpl();
+}
+
+QTEST_MAIN(TestBaseConnection)
+#include "_gen/base-connection.cpp.moc.hpp"
@@ -7,6 +7,7 @@
 #include <tests/lib/glib/textchan-null.h>
 
 #include <TelepathyQt/Channel>
+#include <TelepathyQt/ChannelFactory>
 #include <TelepathyQt/Connection>
 #include <TelepathyQt/ContactManager>
 #include <TelepathyQt/PendingChannel>
@@ -28,7 +29,8 @@ public:
           mGotGroupFlagsChanged(false),
           mGroupFlags((ChannelGroupFlags) 0),
           mGroupFlagsAdded((ChannelGroupFlags) 0),
-          mGroupFlagsRemoved((ChannelGroupFlags) 0)
+          mGroupFlagsRemoved((ChannelGroupFlags) 0),
+          mGroupMembersChangedCount(0)
     { }
 
 protected Q_SLOTS:
@@ -51,6 +53,8 @@ private Q_SLOTS:
     void testLeave();
     void testLeaveWithFallback();
     void testGroupFlagsChange();
+    void testBatchedMembersChanged();
+    void testSuppliedProperties();
 
     void cleanup();
     void cleanupTestCase();
@@ -75,6 +79,7 @@ private:
     ChannelGroupFlags mGroupFlags;
     ChannelGroupFlags mGroupFlagsAdded;
     ChannelGroupFlags mGroupFlagsRemoved;
+    int mGroupMembersChangedCount;
 };
 
 void TestChanGroup::onGroupMembersChanged(
@@ -85,6 +90,7 @@ void TestChanGroup::onGroupMembersChanged(
         const Channel::GroupMemberChangeDetails &details)
 {
     qDebug() << "group members changed";
+    mGroupMembersChangedCount++;
     mChangedCurrent = groupMembersAdded;
     mChangedLP = groupLocalPendingMembersAdded;
     mChangedRP = groupRemotePendingMembersAdded;
@@ -161,6 +167,7 @@ void TestChanGroup::init()
     mGroupFlags = (ChannelGroupFlags) 0;
     mGroupFlagsAdded = (ChannelGroupFlags) 0;
     mGroupFlagsRemoved = (ChannelGroupFlags) 0;
+    mGroupMembersChangedCount = 0;
 }
 
 void TestChanGroup::testCreateChannel()
@@ -484,6 +491,204 @@ void TestChanGroup::testGroupFlagsChange()
     QCOMPARE(mGroupFlagsRemoved, (ChannelGroupFlags) 0);
 }
 
+void TestChanGroup::testBatchedMembersChanged()
+{
+    mChanObjectPath = QString(QLatin1String("%1/ChannelForTpQtBatchedMCDTest"))
+        .arg(mConn->objectPath());
+    QByteArray chanPathLatin1(mChanObjectPath.toLatin1());
+
+    mChanService = TP_TESTS_TEXT_CHANNEL_GROUP(g_object_new(
+                TP_TESTS_TYPE_TEXT_CHANNEL_GROUP,
+                "connection", mConn->service(),
+                "object-path", chanPathLatin1.data(),
+                "detailed", TRUE,
+                "properties", TRUE,
+                NULL));
+    QVERIFY(mChanService != 0);
+
+    mChan = Channel::create(mConn->client(), mChanObjectPath, QVariantMap());
+    QVERIFY(mChan);
+    QVERIFY(!mChan->isGroupMembersChangedBatchingEnabled());
+    mChan->setGroupMembersChangedBatchingEnabled(true);
+    QVERIFY(mChan->isGroupMembersChangedBatchingEnabled());
+
+    QVERIFY(connect(mChan->becomeReady(),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mChan->isReady(), true);
+
+    QVERIFY(connect(mChan.data(),
+                    SIGNAL(groupMembersChanged(
+                            const Tp::Contacts &,
+                            const Tp::Contacts &,
+                            const Tp::Contacts &,
+                            const Tp::Contacts &,
+                            const Tp::Channel::GroupMemberChangeDetails &)),
+                    SLOT(onGroupMembersChanged(
+                            const Tp::Contacts &,
+                            const Tp::Contacts &,
+                            const Tp::Contacts &,
+                            const Tp::Contacts &,
+                            const Tp::Channel::GroupMemberChangeDetails &))));
+
+    TpHandleRepoIface *contactRepo = tp_base_connection_get_handles(
+            TP_BASE_CONNECTION(mConn->service()), TP_HANDLE_TYPE_CONTACT);
+
+    // A storm of joins, each one signalled on its own, followed by one of them leaving again
+    QStringList ids;
+    UIntList handles;
+    for (int i = 0; i < 10; ++i) {
+        QString id = QString(QLatin1String("joiner%1@example.com")).arg(i);
+        TpHandle handle = tp_handle_ensure(contactRepo, id.toLatin1().constData(), NULL, NULL);
+        QVERIFY(handle != 0);
+        ids << id;
+        handles << handle;
+
+        TpIntSet *add = tp_intset_new_containing(handle);
+        QVERIFY(tp_group_mixin_change_members(G_OBJECT(mChanService), "",
+                    add, NULL, NULL, NULL, 0, TP_CHANNEL_GROUP_CHANGE_REASON_NONE));
+        tp_intset_destroy(add);
+    }
+
+    TpIntSet *remove = tp_intset_new_containing(handles[0]);
+    QVERIFY(tp_group_mixin_change_members(G_OBJECT(mChanService), "",
+                NULL, remove, NULL, NULL, 0, TP_CHANNEL_GROUP_CHANGE_REASON_NONE));
+    tp_intset_destroy(remove);
+
+    while (mChangedRemoved.isEmpty()) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+
+    // The joins were merged, but the leave must have been signalled after the join of the same
+    // contact, and on its own
+    QVERIFY(mGroupMembersChangedCount >= 2);
+    QVERIFY(mGroupMembersChangedCount < 11);
+    QCOMPARE(mChangedRemoved.size(), 1);
+    QCOMPARE((*mChangedRemoved.begin())->id(), ids[0]);
+    QVERIFY(mChangedCurrent.isEmpty());
+
+    QStringList memberIds;
+    Q_FOREACH (const ContactPtr &contact, mChan->groupContacts()) {
+        memberIds << contact->id();
+    }
+    QVERIFY(!memberIds.contains(ids[0]));
+    for (int i = 1; i < 10; ++i) {
+        QVERIFY(memberIds.contains(ids[i]));
+    }
+
+    // The details of a local pending member must not be touched by an MCD signal which doesn't
+    // concern it, even if it was built along with the contacts of a later signal which does
+    TpHandle pending = tp_handle_ensure(contactRepo, "pending@example.com", NULL, NULL);
+    TpIntSet *set = tp_intset_new_containing(pending);
+    QVERIFY(tp_group_mixin_change_members(G_OBJECT(mChanService), "original",
+                NULL, NULL, set, NULL, 0, TP_CHANNEL_GROUP_CHANGE_REASON_NONE));
+    tp_intset_destroy(set);
+    while (mChan->groupLocalPendingContacts().isEmpty()) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+    ContactPtr pendingContact = *mChan->groupLocalPendingContacts().begin();
+    QCOMPARE(mChan->groupLocalPendingContactChangeInfo(pendingContact).message(),
+            QLatin1String("original"));
+
+    // The first join is built on its own, the other two together while it's being built
+    QStringList joinerIds = QStringList() << QLatin1String("first@example.com") <<
+        QLatin1String("second@example.com") << QLatin1String("third@example.com");
+    for (int i = 0; i < joinerIds.size(); ++i) {
+        TpHandle handle = tp_handle_ensure(contactRepo, joinerIds[i].toLatin1().constData(),
+                NULL, NULL);
+        set = tp_intset_new_containing(handle);
+        QVERIFY(tp_group_mixin_change_members(G_OBJECT(mChanService),
+                    joinerIds[i].toLatin1().constData(), set, NULL, NULL, NULL,
+                    i == 2 ? pending : 0, TP_CHANNEL_GROUP_CHANGE_REASON_NONE));
+        tp_intset_destroy(set);
+    }
+
+    bool joined = false;
+    while (!joined) {
+        Q_FOREACH (const ContactPtr &contact, mChan->groupContacts()) {
+            if (contact->id() == joinerIds[2]) {
+                joined = true;
+            }
+        }
+        if (!joined) {
+            QCOMPARE(mLoop->exec(), 0);
+        }
+    }
+    QCOMPARE(mChan->groupLocalPendingContactChangeInfo(pendingContact).message(),
+            QLatin1String("original"));
+}
+
+void TestChanGroup::testSuppliedProperties()
+{
+    mChanObjectPath = QString(QLatin1String("%1/ChannelForTpQtSuppliedPropsTest"))
+        .arg(mConn->objectPath());
+    QByteArray chanPathLatin1(mChanObjectPath.toLatin1());
+
+    mChanService = TP_TESTS_TEXT_CHANNEL_GROUP(g_object_new(
+                TP_TESTS_TYPE_TEXT_CHANNEL_GROUP,
+                "connection", mConn->service(),
+                "object-path", chanPathLatin1.data(),
+                "detailed", TRUE,
+                "properties", TRUE,
+                NULL));
+    QVERIFY(mChanService != 0);
+
+    uint selfHandle = mConn->client()->selfHandle();
+    TpIntSet *members = tp_intset_new_containing(selfHandle);
+    QVERIFY(tp_group_mixin_change_members(G_OBJECT(mChanService), "",
+                members, NULL, NULL, NULL, 0, TP_CHANNEL_GROUP_CHANGE_REASON_NONE));
+    tp_intset_destroy(members);
+
+    // Introspect the channel once to get hold of its properties, as a dispatcher would signal them
+    ChannelPtr introspected = Channel::create(mConn->client(), mChanObjectPath, QVariantMap());
+    QVERIFY(connect(introspected->becomeReady(),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+
+    QVariantMap props = introspected->immutableProperties();
+    if (!props.contains(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorID"))) {
+        props.insert(TP_QT_IFACE_CHANNEL + QLatin1String(".InitiatorID"), QString());
+    }
+    // Group properties which went stale after the channel was announced
+    props.insert(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP + QLatin1String(".GroupFlags"), 0U);
+    props.insert(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP + QLatin1String(".HandleOwners"),
+            QVariant::fromValue(HandleOwnerMap()));
+    props.insert(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP + QLatin1String(".LocalPendingMembers"),
+            QVariant::fromValue(LocalPendingInfoList()));
+    props.insert(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP + QLatin1String(".Members"),
+            QVariant::fromValue(UIntList()));
+    props.insert(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP + QLatin1String(".RemotePendingMembers"),
+            QVariant::fromValue(UIntList()));
+    props.insert(TP_QT_IFACE_CHANNEL_INTERFACE_GROUP + QLatin1String(".SelfHandle"), 0U);
+
+    // The Channel properties don't need to be retrieved again, but the mutable Group ones do
+    ChannelFactory::resetAvoidedRoundTrips();
+    mChan = Channel::create(mConn->client(), mChanObjectPath, props);
+    QVERIFY(connect(mChan->becomeReady(),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mChan->isReady(), true);
+
+    QCOMPARE(ChannelFactory::avoidedRoundTrips().value(TP_QT_IFACE_CHANNEL_TYPE_TEXT), 1U);
+    QCOMPARE(mChan->channelType(), introspected->channelType());
+    QCOMPARE(mChan->groupFlags(), introspected->groupFlags());
+    QCOMPARE(mChan->groupContacts().size(), 1);
+    QCOMPARE((*mChan->groupContacts().begin())->handle()[0], selfHandle);
+    QCOMPARE(mChan->groupSelfContact()->handle()[0], selfHandle);
+
+    // Without them, the channel is introspected as usual
+    ChannelFactory::resetAvoidedRoundTrips();
+    introspected = Channel::create(mConn->client(), mChanObjectPath, QVariantMap());
+    QVERIFY(connect(introspected->becomeReady(),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QVERIFY(ChannelFactory::avoidedRoundTrips().isEmpty());
+}
+
 void TestChanGroup::cleanup()
 {
     if (mChanService) {
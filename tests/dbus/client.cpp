@@ -2,25 +2,30 @@
 
 #include <tests/lib/glib-helpers/test-conn-helper.h>
 
+#include <tests/lib/glib/bug16307-conn.h>
 #include <tests/lib/glib/contacts-conn.h>
 #include <tests/lib/glib/echo/chan.h>
 
 #define TP_QT_ENABLE_LOWLEVEL_API
 
 #include <TelepathyQt/Account>
+#include <TelepathyQt/AccountFactory>
 #include <TelepathyQt/AccountManager>
 #include <TelepathyQt/AbstractClientHandler>
 #include <TelepathyQt/AbstractClientObserver>
 #include <TelepathyQt/Channel>
 #include <TelepathyQt/ChannelClassSpec>
 #include <TelepathyQt/ChannelDispatchOperation>
+#include <TelepathyQt/ChannelFactory>
 #include <TelepathyQt/ChannelRequest>
 #include <TelepathyQt/ClientHandlerInterface>
 #include <TelepathyQt/ClientInterfaceRequestsInterface>
 #include <TelepathyQt/ClientObserverInterface>
 #include <TelepathyQt/ClientRegistrar>
 #include <TelepathyQt/Connection>
+#include <TelepathyQt/ConnectionFactory>
 #include <TelepathyQt/ConnectionLowlevel>
+#include <TelepathyQt/ContactFactory>
 #include <TelepathyQt/MethodInvocationContext>
 #include <TelepathyQt/PendingAccount>
 #include <TelepathyQt/PendingReady>
@@ -354,6 +359,8 @@ public:
 
     void testObserveChannelsCommon(const AbstractClientPtr &clientObject,
             const QString &clientBusName, const QString &clientObjectPath);
+    void createSlowConnection(const char *account,
+            TpTestsBug16307Connection **service, QString *objectPath);
 
 protected Q_SLOTS:
     void expectSignalEmission();
@@ -368,6 +375,7 @@ private Q_SLOTS:
     void testObserveChannels();
     void testAddDispatchOperation();
     void testRequests();
+    void testDispatchOrdering();
     void testHandleChannels();
 
     void cleanup();
@@ -749,6 +757,212 @@ void TestClient::testAddDispatchOperation()
     QCOMPARE(handledChannels, expectedHandledChannels);
 }
 
+void TestClient::createSlowConnection(const char *account,
+        TpTestsBug16307Connection **service, QString *objectPath)
+{
+    gchar *name;
+    gchar *connPath;
+    GError *error = 0;
+
+    // The GetStatus reply of this connection is only sent once
+    // tp_tests_bug16307_connection_inject_get_status_return() is called, so making it ready stalls
+    *service = TP_TESTS_BUG16307_CONNECTION(g_object_new(
+                TP_TESTS_TYPE_BUG16307_CONNECTION,
+                "account", account,
+                "protocol", "simple",
+                NULL));
+    QVERIFY(*service != 0);
+
+    QVERIFY(tp_base_connection_register(TP_BASE_CONNECTION(*service), "simple",
+                &name, &connPath, &error));
+    QVERIFY(error == 0);
+
+    *objectPath = QLatin1String(connPath);
+
+    g_free(name);
+    g_free(connPath);
+}
+
+void TestClient::testDispatchOrdering()
+{
+    QDBusConnection bus = mClientRegistrar->dbusConnection();
+
+    QVariantMap parameters;
+    parameters[QLatin1String("account")] = QLatin1String("foobaz");
+    PendingAccount *pacc = mAM->createAccount(QLatin1String("foo"),
+            QLatin1String("bar"), QLatin1String("foobaz"), parameters);
+    QVERIFY(connect(pacc,
+                    SIGNAL(finished(Tp::PendingOperation *)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+    QVERIFY(pacc->account());
+    AccountPtr otherAccount = pacc->account();
+
+    // Unlike mClientRegistrar, make connections ready before invoking the client, so that the
+    // invocations for the slow connections stay queued
+    ClientRegistrarPtr registrar = ClientRegistrar::create(bus,
+            AccountFactory::create(bus),
+            ConnectionFactory::create(bus, Connection::FeatureCore),
+            ChannelFactory::create(bus),
+            ContactFactory::create());
+
+    ChannelClassSpecList filters;
+    filters.append(ChannelClassSpec::textChat());
+    AbstractClientPtr clientObject = MyClient::create(filters, mClientCapabilities);
+    QVERIFY(registrar->registerClient(clientObject, QLatin1String("ordering")));
+    MyClient *client = dynamic_cast<MyClient*>(clientObject.data());
+    connect(client,
+            SIGNAL(observeChannelsFinished()),
+            SLOT(expectSignalEmission()));
+
+    ClientObserverInterface *observeIface = new ClientObserverInterface(bus,
+            QLatin1String("org.freedesktop.Telepathy.Client.ordering"),
+            QLatin1String("/org/freedesktop/Telepathy/Client/ordering"), this);
+
+    // Unordered: an invocation doesn't wait for an earlier one which is still being prepared
+    TpTestsBug16307Connection *slowConn1Service = 0;
+    QString slowConn1Path;
+    createSlowConnection("slow1@example.com", &slowConn1Service, &slowConn1Path);
+    QVERIFY(slowConn1Service != 0);
+
+    client->setDispatchOrdering(AbstractClient::DispatchUnordered);
+    QDBusPendingReply<> slowReply = observeIface->ObserveChannels(
+            QDBusObjectPath(mAccount->objectPath()),
+            QDBusObjectPath(slowConn1Path),
+            ChannelDetailsList(),
+            QDBusObjectPath("/"),
+            ObjectPathList(),
+            QVariantMap());
+    QDBusPendingReply<> reply = observeIface->ObserveChannels(
+            QDBusObjectPath(mAccount->objectPath()),
+            QDBusObjectPath(mConn->objectPath()),
+            ChannelDetailsList(),
+            QDBusObjectPath("/"),
+            ObjectPathList(),
+            QVariantMap());
+    QCOMPARE(mLoop->exec(), 0);
+
+    QCOMPARE(client->mObserveChannelsConnection->objectPath(), mConn->objectPath());
+    QCOMPARE(client->dispatchCount(), 1U);
+    QVERIFY(!slowReply.isFinished());
+
+    tp_tests_bug16307_connection_inject_get_status_return(slowConn1Service);
+    QCOMPARE(mLoop->exec(), 0);
+    while (!slowReply.isFinished()) {
+        mLoop->processEvents();
+    }
+
+    QVERIFY(!slowReply.isError());
+    QCOMPARE(client->mObserveChannelsConnection->objectPath(), slowConn1Path);
+    QCOMPARE(client->dispatchCount(), 2U);
+
+    // Per account: only the invocations for the account of the slow one are held back
+    TpTestsBug16307Connection *slowConn2Service = 0;
+    QString slowConn2Path;
+    createSlowConnection("slow2@example.com", &slowConn2Service, &slowConn2Path);
+    QVERIFY(slowConn2Service != 0);
+
+    client->setDispatchOrdering(AbstractClient::DispatchInOrderPerAccount);
+    slowReply = observeIface->ObserveChannels(
+            QDBusObjectPath(mAccount->objectPath()),
+            QDBusObjectPath(slowConn2Path),
+            ChannelDetailsList(),
+            QDBusObjectPath("/"),
+            ObjectPathList(),
+            QVariantMap());
+    QDBusPendingReply<> blockedReply = observeIface->ObserveChannels(
+            QDBusObjectPath(mAccount->objectPath()),
+            QDBusObjectPath(mConn->objectPath()),
+            ChannelDetailsList(),
+            QDBusObjectPath("/"),
+            ObjectPathList(),
+            QVariantMap());
+    reply = observeIface->ObserveChannels(
+            QDBusObjectPath(otherAccount->objectPath()),
+            QDBusObjectPath(mConn->objectPath()),
+            ChannelDetailsList(),
+            QDBusObjectPath("/"),
+            ObjectPathList(),
+            QVariantMap());
+    QCOMPARE(mLoop->exec(), 0);
+    while (!reply.isFinished()) {
+        mLoop->processEvents();
+    }
+
+    QVERIFY(!reply.isError());
+    QCOMPARE(client->mObserveChannelsAccount->objectPath(), otherAccount->objectPath());
+    QCOMPARE(client->dispatchCount(), 3U);
+    QVERIFY(!blockedReply.isFinished());
+    QVERIFY(!slowReply.isFinished());
+
+    // Relaxing the ordering delivers the invocation which is ready but was held back by the slow
+    // one, without waiting for another invocation to become ready
+    client->setDispatchOrdering(AbstractClient::DispatchUnordered);
+    QCOMPARE(mLoop->exec(), 0);
+    while (!blockedReply.isFinished()) {
+        mLoop->processEvents();
+    }
+
+    QVERIFY(!blockedReply.isError());
+    QCOMPARE(client->mObserveChannelsAccount->objectPath(), mAccount->objectPath());
+    QCOMPARE(client->mObserveChannelsConnection->objectPath(), mConn->objectPath());
+    QCOMPARE(client->dispatchCount(), 4U);
+    QVERIFY(!slowReply.isFinished());
+
+    // With the queue full, further invocations are rejected instead of being queued
+    client->setMaxPendingDispatches(1);
+    QCOMPARE(client->maxPendingDispatches(), 1);
+    reply = observeIface->ObserveChannels(
+            QDBusObjectPath(otherAccount->objectPath()),
+            QDBusObjectPath(mConn->objectPath()),
+            ChannelDetailsList(),
+            QDBusObjectPath("/"),
+            ObjectPathList(),
+            QVariantMap());
+    while (!reply.isFinished()) {
+        mLoop->processEvents();
+    }
+
+    QVERIFY(reply.isError());
+    QCOMPARE(reply.error().name(), TP_QT_ERROR_BUSY);
+    QCOMPARE(client->dispatchCount(), 4U);
+
+    tp_tests_bug16307_connection_inject_get_status_return(slowConn2Service);
+    QCOMPARE(mLoop->exec(), 0);
+    while (!slowReply.isFinished()) {
+        mLoop->processEvents();
+    }
+
+    QVERIFY(!slowReply.isError());
+    QCOMPARE(client->mObserveChannelsConnection->objectPath(), slowConn2Path);
+    QCOMPARE(client->dispatchCount(), 5U);
+
+    // The queue has room again
+    reply = observeIface->ObserveChannels(
+            QDBusObjectPath(otherAccount->objectPath()),
+            QDBusObjectPath(mConn->objectPath()),
+            ChannelDetailsList(),
+            QDBusObjectPath("/"),
+            ObjectPathList(),
+            QVariantMap());
+    QCOMPARE(mLoop->exec(), 0);
+    while (!reply.isFinished()) {
+        mLoop->processEvents();
+    }
+
+    QVERIFY(!reply.isError());
+    QCOMPARE(client->dispatchCount(), 6U);
+
+    QVERIFY(registrar->unregisterClient(clientObject));
+
+    tp_base_connection_change_status(TP_BASE_CONNECTION(slowConn1Service),
+            TP_CONNECTION_STATUS_DISCONNECTED, TP_CONNECTION_STATUS_REASON_REQUESTED);
+    g_object_unref(slowConn1Service);
+    tp_base_connection_change_status(TP_BASE_CONNECTION(slowConn2Service),
+            TP_CONNECTION_STATUS_DISCONNECTED, TP_CONNECTION_STATUS_REASON_REQUESTED);
+    g_object_unref(slowConn2Service);
+}
+
 void TestClient::testHandleChannels()
 {
     QDBusConnection bus = mClientRegistrar->dbusConnection();
@@ -757,6 +971,7 @@ void TestClient::testHandleChannels()
     ClientHandlerInterface *handler1Iface = new ClientHandlerInterface(bus,
             mClientObject1BusName, mClientObject1Path, this);
     MyClient *client1 = dynamic_cast<MyClient*>(mClientObject1.data());
+    client1->resetDispatchStatistics();
     connect(client1,
             SIGNAL(handleChannelsFinished()),
             SLOT(expectSignalEmission()));
@@ -776,6 +991,7 @@ void TestClient::testHandleChannels()
     QCOMPARE(client1->mHandleChannelsChannels.first()->objectPath(), mText1ChanPath);
     QCOMPARE(client1->mHandleChannelsRequestsSatisfied.first()->objectPath(), mChannelRequestPath);
     QCOMPARE(client1->mHandleChannelsUserActionTime.toTime_t(), mUserActionTime);
+    QCOMPARE(client1->dispatchCount(), 1U);
 
     Tp::ObjectPathList handledChannels;
     QVERIFY(waitForProperty(handler1Iface->requestPropertyHandledChannels(), &handledChannels));
@@ -785,6 +1001,9 @@ void TestClient::testHandleChannels()
     ClientHandlerInterface *handler2Iface = new ClientHandlerInterface(bus,
             mClientObject2BusName, mClientObject2Path, this);
     MyClient *client2 = dynamic_cast<MyClient*>(mClientObject2.data());
+    client2->resetDispatchStatistics();
+    client2->setDispatchOrdering(AbstractClient::DispatchUnordered);
+    QCOMPARE(client2->dispatchOrdering(), AbstractClient::DispatchUnordered);
     connect(client2,
             SIGNAL(handleChannelsFinished()),
             SLOT(expectSignalEmission()));
@@ -804,6 +1023,8 @@ void TestClient::testHandleChannels()
     QCOMPARE(client2->mHandleChannelsChannels.first()->objectPath(), mText2ChanPath);
     QCOMPARE(client2->mHandleChannelsRequestsSatisfied.first()->objectPath(), mChannelRequestPath);
     QCOMPARE(client2->mHandleChannelsUserActionTime.toTime_t(), mUserActionTime);
+    QCOMPARE(client2->dispatchCount(), 1U);
+    client2->setDispatchOrdering(AbstractClient::DispatchInOrder);
 
     QVERIFY(waitForProperty(handler1Iface->requestPropertyHandledChannels(), &handledChannels));
     QVERIFY(handledChannels.contains(QDBusObjectPath(mText1ChanPath)));
@@ -41,6 +41,7 @@ private Q_SLOTS:
     void init();
 
     void testRoster();
+    void testRosterAttributesCache();
 
     void cleanup();
     void cleanupTestCase();
@@ -479,6 +480,63 @@ void TestConnRoster::testRoster()
     }
 }
 
+void TestConnRoster::testRosterAttributesCache()
+{
+    // Use a cache directory of our own, so that the first connection starts with a cold cache
+    QByteArray oldCacheHome = qgetenv("XDG_CACHE_HOME");
+    QString cacheDir = QString(QLatin1String("%1/conn-roster-cache-%2")).
+        arg(QDir::tempPath()).arg(QCoreApplication::applicationPid());
+    setenv("XDG_CACHE_HOME", cacheDir.toLatin1().constData(), true);
+
+    QHash<QString, QString> aliases;
+    QString cacheFileName;
+    for (int run = 0; run < 2; ++run) {
+        TestConnHelper *conn = new TestConnHelper(this,
+                ChannelFactory::create(QDBusConnection::sessionBus()),
+                ContactFactory::create(Contact::FeatureAlias),
+                EXAMPLE_TYPE_CONTACT_LIST_CONNECTION,
+                "account", "cached@example.com",
+                "protocol", "contactlist",
+                "simulation-delay", 1,
+                NULL);
+        QCOMPARE(conn->connect(), true);
+
+        ContactManagerPtr contactManager = conn->client()->contactManager();
+        contactManager->setContactAttributesCacheEnabled(true);
+        QCOMPARE(conn->enableFeatures(Features() << Connection::FeatureRoster), true);
+        QCOMPARE(contactManager->state(), ContactListStateSuccess);
+
+        // Whether they were taken from the cache or not, the contacts have all of the features
+        // of the factory once the roster is ready
+        QVERIFY(!contactManager->allKnownContacts().isEmpty());
+        Q_FOREACH (const ContactPtr &contact, contactManager->allKnownContacts()) {
+            QVERIFY(contact->actualFeatures().contains(Contact::FeatureAlias));
+            if (run == 0) {
+                aliases.insert(contact->id(), contact->alias());
+            } else {
+                QCOMPARE(contact->alias(), aliases.value(contact->id()));
+            }
+        }
+        QCOMPARE(contactManager->allKnownContacts().size(), aliases.size());
+
+        // The cache is kept per account, named after the self contact identifier
+        cacheFileName = QString(QLatin1String("%1/telepathy/contact-attributes/%2/%3/%4")).
+            arg(cacheDir).arg(conn->client()->cmName()).arg(conn->client()->protocolName()).
+            arg(QLatin1String("cached%40example.com"));
+        QVERIFY(QFile::exists(cacheFileName));
+
+        QCOMPARE(conn->disconnect(), true);
+        delete conn;
+    }
+
+    QFile::remove(cacheFileName);
+    if (oldCacheHome.isEmpty()) {
+        unsetenv("XDG_CACHE_HOME");
+    } else {
+        setenv("XDG_CACHE_HOME", oldCacheHome.constData(), true);
+    }
+}
+
 void TestConnRoster::cleanup()
 {
     cleanupImpl();
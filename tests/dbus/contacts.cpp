@@ -43,6 +43,8 @@ protected Q_SLOTS:
     void expectConnReady(Tp::ConnectionStatus, Tp::ConnectionStatusReason);
     void expectConnInvalidated();
     void expectPendingContactsFinished(Tp::PendingOperation *);
+    void onContactsChanged(const QList<Tp::ContactPtr> &contacts,
+            Tp::ContactManager::ContactChanges changes);
 
 private Q_SLOTS:
     void initTestCase();
@@ -55,6 +57,8 @@ private Q_SLOTS:
     void testFeatures();
     void testFeaturesNotRequested();
     void testUpgrade();
+    void testCoalescedRequests();
+    void testCoalescedChanges();
     void testSelfContactFallback();
 
     void cleanup();
@@ -66,6 +70,8 @@ private:
     ConnectionPtr mConn;
     QList<ContactPtr> mContacts;
     Tp::UIntList mInvalidHandles;
+    QList<QList<ContactPtr> > mChangedContacts;
+    QList<ContactManager::ContactChanges> mContactChanges;
 };
 
 void TestContacts::expectConnReady(Tp::ConnectionStatus newStatus,
@@ -110,6 +116,13 @@ void TestContacts::expectPendingContactsFinished(PendingOperation *op)
     mLoop->exit(0);
 }
 
+void TestContacts::onContactsChanged(const QList<Tp::ContactPtr> &contacts,
+        Tp::ContactManager::ContactChanges changes)
+{
+    mChangedContacts.append(contacts);
+    mContactChanges.append(changes);
+}
+
 void TestContacts::initTestCase()
 {
     initTestCaseImpl();
@@ -717,6 +730,202 @@ void TestContacts::testUpgrade()
     processDBusQueue(mConn.data());
 }
 
+void TestContacts::testCoalescedRequests()
+{
+    QStringList ids = QStringList() << QLatin1String("edward")
+        << QLatin1String("frank") << QLatin1String("gloria");
+    const char *aliases[] = {
+        "Edward Scissorhands",
+        "Frank Poole",
+        "Gloria Swanson"
+    };
+    TpHandleRepoIface *serviceRepo =
+        tp_base_connection_get_handles(TP_BASE_CONNECTION(mConnService), TP_HANDLE_TYPE_CONTACT);
+
+    Tp::UIntList handles;
+    for (int i = 0; i < 3; i++) {
+        handles.push_back(tp_handle_ensure(serviceRepo, ids[i].toLatin1().constData(), NULL, NULL));
+        QVERIFY(handles[i] != 0);
+    }
+
+    tp_tests_contacts_connection_change_aliases(mConnService, 3, handles.toVector().constData(), aliases);
+
+    ContactManagerPtr manager = mConn->contactManager();
+    // Coalescing is disabled by default
+    QCOMPARE(manager->contactAttributesCoalescingInterval(), -1);
+    manager->setContactAttributesCoalescingInterval(0);
+    QCOMPARE(manager->contactAttributesCoalescingInterval(), 0);
+    uint requestCount = manager->contactAttributesRequestCount();
+    uint mergedCount = manager->mergedContactAttributesRequestCount();
+
+    // Three overlapping requests with different features in the same main loop iteration
+    PendingContacts *first = manager->contactsForHandles(
+            Tp::UIntList() << handles[0] << handles[1]);
+    PendingContacts *second = manager->contactsForHandles(
+            Tp::UIntList() << handles[1] << handles[2],
+            Features() << Contact::FeatureAlias);
+    PendingContacts *third = manager->contactsForHandles(
+            Tp::UIntList() << handles[2] << handles[0]);
+
+    // All of them share the same call, so they finish in the order they were made
+    QVERIFY(connect(third,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+
+    QVERIFY(first->isFinished());
+    QVERIFY(first->isValid());
+    QVERIFY(second->isFinished());
+    QVERIFY(second->isValid());
+
+    QCOMPARE(manager->contactAttributesRequestCount(), requestCount + 3);
+    QCOMPARE(manager->mergedContactAttributesRequestCount(), mergedCount + 2);
+
+    QList<ContactPtr> firstContacts = first->contacts();
+    QList<ContactPtr> secondContacts = second->contacts();
+    QCOMPARE(firstContacts.size(), 2);
+    QCOMPARE(secondContacts.size(), 2);
+    QCOMPARE(mContacts.size(), 2);
+
+    // The same Contact objects are shared between the requests
+    QCOMPARE(firstContacts[1], secondContacts[0]);
+    QCOMPARE(secondContacts[1], mContacts[0]);
+    QCOMPARE(mContacts[1], firstContacts[0]);
+
+    for (int i = 0; i < 2; i++) {
+        QCOMPARE(secondContacts[i]->handle()[0], handles[i + 1]);
+        QCOMPARE(secondContacts[i]->id(), ids[i + 1]);
+        QVERIFY(secondContacts[i]->actualFeatures().contains(Contact::FeatureAlias));
+        QCOMPARE(secondContacts[i]->alias(), QString(QLatin1String(aliases[i + 1])));
+    }
+
+    // With coalescing disabled every request does its own round-trip
+    manager->setContactAttributesCoalescingInterval(-1);
+    mergedCount = manager->mergedContactAttributesRequestCount();
+
+    first = manager->contactsForHandles(handles, Features() << Contact::FeatureAvatarToken);
+    second = manager->contactsForHandles(handles, Features() << Contact::FeatureSimplePresence);
+    QVERIFY(connect(second,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 3);
+    QCOMPARE(manager->mergedContactAttributesRequestCount(), mergedCount);
+
+    // A batch whose requesters are all gone by the time it's due isn't sent at all
+    manager->setContactAttributesCoalescingInterval(0);
+    requestCount = manager->contactAttributesRequestCount();
+    mergedCount = manager->mergedContactAttributesRequestCount();
+    Tp::UIntList otherHandles;
+    otherHandles.push_back(tp_handle_ensure(serviceRepo, "dora", NULL, NULL));
+    otherHandles.push_back(tp_handle_ensure(serviceRepo, "eve", NULL, NULL));
+    first = manager->contactsForHandles(Tp::UIntList() << otherHandles[0]);
+    second = manager->contactsForHandles(otherHandles);
+    QCOMPARE(manager->contactAttributesRequestCount(), requestCount + 2);
+    delete first;
+    delete second;
+    mLoop->processEvents();
+    QCOMPARE(manager->contactAttributesRequestCount(), requestCount);
+    QCOMPARE(manager->mergedContactAttributesRequestCount(), mergedCount);
+
+    manager->setContactAttributesCoalescingInterval(-1);
+
+    firstContacts.clear();
+    secondContacts.clear();
+    mContacts.clear();
+    mLoop->processEvents();
+    processDBusQueue(mConn.data());
+}
+
+void TestContacts::testCoalescedChanges()
+{
+    QStringList ids = QStringList() << QLatin1String("alice")
+        << QLatin1String("bob") << QLatin1String("chris");
+    const char *aliases[] = {
+        "Alice in Wonderland",
+        "Bob the Builder"
+    };
+    static TpTestsContactsConnectionPresenceStatusIndex statuses[] = {
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_AWAY,
+        TP_TESTS_CONTACTS_CONNECTION_STATUS_BUSY
+    };
+    const char *messages[] = {
+        "Having some carrots",
+        "Fixing it"
+    };
+    const char *latterAliases[] = {
+        "Chris Sawyer"
+    };
+    Features features = Features()
+        << Contact::FeatureAlias
+        << Contact::FeatureSimplePresence;
+    TpHandleRepoIface *serviceRepo =
+        tp_base_connection_get_handles(TP_BASE_CONNECTION(mConnService), TP_HANDLE_TYPE_CONTACT);
+
+    Tp::UIntList handles;
+    for (int i = 0; i < 3; i++) {
+        handles.push_back(tp_handle_ensure(serviceRepo, ids[i].toLatin1().constData(), NULL, NULL));
+        QVERIFY(handles[i] != 0);
+    }
+
+    ContactManagerPtr manager = mConn->contactManager();
+    PendingContacts *pending = manager->contactsForHandles(handles, features);
+    QVERIFY(connect(pending,
+                SIGNAL(finished(Tp::PendingOperation*)),
+                SLOT(expectPendingContactsFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(mContacts.size(), 3);
+
+    // Coalescing is disabled by default
+    QCOMPARE(manager->contactChangesCoalescingInterval(), -1);
+    // Use an interval long enough for all the changes below to be received before it elapses
+    manager->setContactChangesCoalescingInterval(500);
+    QVERIFY(connect(manager.data(),
+                SIGNAL(contactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ContactChanges)),
+                SLOT(onContactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ContactChanges))));
+    mChangedContacts.clear();
+    mContactChanges.clear();
+
+    // The alias and presence changes of the first two contacts are reported together, the alias
+    // change of the third one separately
+    tp_tests_contacts_connection_change_aliases(mConnService, 2, handles.toVector().constData(),
+            aliases);
+    tp_tests_contacts_connection_change_presences(mConnService, 2, handles.toVector().constData(),
+            statuses, messages);
+    tp_tests_contacts_connection_change_aliases(mConnService, 1,
+            handles.toVector().constData() + 2, latterAliases);
+    processDBusQueue(mConn.data());
+    while (mContactChanges.size() < 2) {
+        mLoop->processEvents();
+    }
+
+    QCOMPARE(mContactChanges.size(), 2);
+    QCOMPARE(mContactChanges[0], ContactManager::ContactChanges(
+                ContactManager::ContactAliasChanged | ContactManager::ContactPresenceChanged));
+    QCOMPARE(mChangedContacts[0].size(), 2);
+    QVERIFY(mChangedContacts[0].contains(mContacts[0]));
+    QVERIFY(mChangedContacts[0].contains(mContacts[1]));
+    QCOMPARE(mContactChanges[1], ContactManager::ContactChanges(
+                ContactManager::ContactAliasChanged));
+    QCOMPARE(mChangedContacts[1], QList<ContactPtr>() << mContacts[2]);
+
+    // The changes were applied right away nevertheless
+    QCOMPARE(mContacts[0]->alias(), QString(QLatin1String(aliases[0])));
+    QCOMPARE(mContacts[1]->presence().statusMessage(), QString(QLatin1String(messages[1])));
+    QCOMPARE(mContacts[2]->alias(), QString(QLatin1String(latterAliases[0])));
+
+    manager->setContactChangesCoalescingInterval(-1);
+    QVERIFY(disconnect(manager.data(),
+                SIGNAL(contactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ContactChanges)),
+                this,
+                SLOT(onContactsChanged(QList<Tp::ContactPtr>,Tp::ContactManager::ContactChanges))));
+    mChangedContacts.clear();
+
+    mContacts.clear();
+    mLoop->processEvents();
+    processDBusQueue(mConn.data());
+}
+
 void TestContacts::testSelfContactFallback()
 {
     gchar *name;
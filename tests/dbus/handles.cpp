@@ -2,11 +2,14 @@
 
 #include <tests/lib/glib-helpers/test-conn-helper.h>
 
+#include <tests/lib/glib/contacts-conn.h>
 #include <tests/lib/glib/simple-conn.h>
 
 #define TP_QT_ENABLE_LOWLEVEL_API
 
+#include <TelepathyQt/ChannelFactory>
 #include <TelepathyQt/Connection>
+#include <TelepathyQt/ContactFactory>
 #include <TelepathyQt/ConnectionLowlevel>
 #include <TelepathyQt/PendingHandles>
 #include <TelepathyQt/ReferencedHandles>
@@ -32,6 +35,8 @@ private Q_SLOTS:
     void init();
 
     void testRequestAndRelease();
+    void testLazyRelease();
+    void testReleaseAfterProxyDestroyed();
 
     void cleanup();
     void cleanupTestCase();
@@ -111,6 +116,139 @@ void TestHandles::testRequestAndRelease()
     processDBusQueue(mConn->client().data());
 }
 
+void TestHandles::testLazyRelease()
+{
+    // The legacy connection doesn't have immortal handles, so the handles are tracked
+    TestConnHelper *conn = new TestConnHelper(this,
+            TP_TESTS_TYPE_LEGACY_CONTACTS_CONNECTION,
+            "account", "me@example.com",
+            "protocol", "foo",
+            NULL);
+    QCOMPARE(conn->connect(), true);
+    ConnectionLowlevelPtr lowlevel = conn->client()->lowlevel();
+    // Handles are released right away unless a grace period is set
+    QCOMPARE(lowlevel->handleReleaseGracePeriod(), 0);
+    lowlevel->setHandleReleaseGracePeriod(5000);
+    QCOMPARE(lowlevel->handleReleaseGracePeriod(), 5000);
+
+    int referenced = lowlevel->referencedHandleCount(HandleTypeContact);
+    int held = lowlevel->heldHandleCount(HandleTypeContact);
+
+    QStringList ids = QStringList() << QLatin1String("alice")
+        << QLatin1String("bob") << QLatin1String("chris");
+    PendingHandles *pending = lowlevel->requestHandles(HandleTypeContact, ids);
+    QVERIFY(connect(pending,
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectPendingHandlesFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    ReferencedHandles handles = mHandles;
+    mHandles = ReferencedHandles();
+    UIntList saveHandles = handles.toList();
+
+    QCOMPARE(lowlevel->referencedHandleCount(HandleTypeContact), referenced + 3);
+    QCOMPARE(lowlevel->heldHandleCount(HandleTypeContact), held + 3);
+
+    // Unreferenced handles are kept for the grace period...
+    handles = ReferencedHandles();
+    mLoop->processEvents();
+    processDBusQueue(conn->client().data());
+    QCOMPARE(lowlevel->referencedHandleCount(HandleTypeContact), referenced);
+    QCOMPARE(lowlevel->heldHandleCount(HandleTypeContact), held + 3);
+
+    // ...and revived without holding them again
+    pending = lowlevel->referenceHandles(HandleTypeContact, saveHandles);
+    QVERIFY(pending->isFinished());
+    QVERIFY(pending->isValid());
+    QCOMPARE(pending->handles().size(), 3);
+    QCOMPARE(lowlevel->referencedHandleCount(HandleTypeContact), referenced + 3);
+    pending->deleteLater();
+    pending = 0;
+    mLoop->processEvents();
+
+    // Without a grace period, they're released right away
+    lowlevel->setHandleReleaseGracePeriod(0);
+    mLoop->processEvents();
+    processDBusQueue(conn->client().data());
+    QCOMPARE(lowlevel->referencedHandleCount(HandleTypeContact), referenced);
+    QCOMPARE(lowlevel->heldHandleCount(HandleTypeContact), held);
+
+    // References requested during the same mainloop iteration are all satisfied by one call
+    PendingHandles *first = lowlevel->referenceHandles(HandleTypeContact, saveHandles);
+    PendingHandles *second = lowlevel->referenceHandles(HandleTypeContact,
+            UIntList() << saveHandles[0]);
+    QVERIFY(!first->isFinished());
+    QVERIFY(!second->isFinished());
+    QVERIFY(connect(second,
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectPendingHandlesFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QVERIFY(first->isFinished());
+    QVERIFY(first->isValid());
+    QCOMPARE(first->handles().toList(), saveHandles);
+    QCOMPARE(mHandles.toList(), UIntList() << saveHandles[0]);
+    QCOMPARE(lowlevel->referencedHandleCount(HandleTypeContact), referenced + 3);
+    mHandles = ReferencedHandles();
+    first->deleteLater();
+    second->deleteLater();
+    mLoop->processEvents();
+    processDBusQueue(conn->client().data());
+    QCOMPARE(lowlevel->heldHandleCount(HandleTypeContact), held);
+
+    lowlevel.reset();
+    QCOMPARE(conn->disconnect(), true);
+    delete conn;
+}
+
+void TestHandles::testReleaseAfterProxyDestroyed()
+{
+    TestConnHelper *conn = new TestConnHelper(this,
+            TP_TESTS_TYPE_LEGACY_CONTACTS_CONNECTION,
+            "account", "me@example.com",
+            "protocol", "foo",
+            NULL);
+    QCOMPARE(conn->connect(), true);
+    ConnectionLowlevelPtr lowlevel = conn->client()->lowlevel();
+    int held = lowlevel->heldHandleCount(HandleTypeContact);
+
+    // A second proxy for the same connection shares the handles of the first one
+    ConnectionPtr other = Connection::create(conn->client()->busName(),
+            conn->client()->objectPath(),
+            ChannelFactory::create(QDBusConnection::sessionBus()),
+            ContactFactory::create());
+    QVERIFY(connect(other->becomeReady(),
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    other->lowlevel()->setHandleReleaseGracePeriod(100);
+    QCOMPARE(lowlevel->handleReleaseGracePeriod(), 100);
+
+    PendingHandles *pending = other->lowlevel()->requestHandles(HandleTypeContact,
+            QStringList() << QLatin1String("dave") << QLatin1String("eve"));
+    QVERIFY(connect(pending,
+                    SIGNAL(finished(Tp::PendingOperation*)),
+                    SLOT(expectPendingHandlesFinished(Tp::PendingOperation*))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(lowlevel->heldHandleCount(HandleTypeContact), held + 2);
+
+    // Losing the last reference schedules a release sweep on the second proxy, which then goes
+    // away before the grace period is over
+    mHandles = ReferencedHandles();
+    pending->deleteLater();
+    mLoop->processEvents();
+    other.reset();
+    QCOMPARE(lowlevel->heldHandleCount(HandleTypeContact), held + 2);
+
+    // The first proxy takes over the sweep, so the handles are still released
+    QTimer::singleShot(300, mLoop, SLOT(quit()));
+    QCOMPARE(mLoop->exec(), 0);
+    processDBusQueue(conn->client().data());
+    QCOMPARE(lowlevel->heldHandleCount(HandleTypeContact), held);
+
+    lowlevel.reset();
+    QCOMPARE(conn->disconnect(), true);
+    delete conn;
+}
+
 void TestHandles::cleanup()
 {
     cleanupImpl();
@@ -34,6 +34,27 @@ void TestProfileManager::testProfileManager()
     QCOMPARE(pm->profilesForProtocol(QLatin1String("testprofileproto")).isEmpty(), false);
     QCOMPARE(pm->profilesForProtocol(QLatin1String("testprofileproto")).count(), 2);
 
+    // a second manager gets the same profiles, without parsing the files again
+    ProfileManagerPtr cachedPm = ProfileManager::create(QDBusConnection::sessionBus());
+    QVERIFY(connect(cachedPm->becomeReady(),
+                    SIGNAL(finished(Tp::PendingOperation *)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+    QCOMPARE(cachedPm->profiles().count(), 2);
+    QCOMPARE(cachedPm->profilesForCM(QLatin1String("testprofilecm")).count(), 2);
+    QCOMPARE(cachedPm->profilesForProtocol(QLatin1String("testprofileproto")).count(), 2);
+    ProfilePtr original = pm->profileForService(QLatin1String("test-profile"));
+    ProfilePtr cached = cachedPm->profileForService(QLatin1String("test-profile"));
+    QVERIFY(!cached.isNull());
+    QCOMPARE(cached->isValid(), true);
+    QCOMPARE(cached->provider(), original->provider());
+    QCOMPARE(cached->name(), original->name());
+    QCOMPARE(cached->iconName(), original->iconName());
+    QCOMPARE(cached->parameters().count(), original->parameters().count());
+    QCOMPARE(cached->presences().count(), original->presences().count());
+    QCOMPARE(cached->unsupportedChannelClassSpecs().count(),
+             original->unsupportedChannelClassSpecs().count());
+
     QVERIFY(connect(pm->becomeReady(ProfileManager::FeatureFakeProfiles),
                     SIGNAL(finished(Tp::PendingOperation *)),
                     SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
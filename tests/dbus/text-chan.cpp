@@ -57,6 +57,12 @@ private Q_SLOTS:
 
     void testMessages();
     void testLegacyText();
+    void testDeliveryOrder_data();
+    void testDeliveryOrder();
+#ifdef ENABLE_BENCHMARKS
+    void testMessageQueueBenchmark_data();
+    void testMessageQueueBenchmark();
+#endif
 
     void cleanup();
     void cleanupTestCase();
@@ -64,6 +70,7 @@ private Q_SLOTS:
 private:
     void commonTest(bool withMessages);
     void sendText(const char *text);
+    void queueMessage(ExampleEcho2Channel *chanService, TpHandle sender, int number);
 
     TestConnHelper *mConn;
     TpHandleRepoIface *mContactRepo;
@@ -120,6 +127,17 @@ void TestTextChan::sendText(const char *text)
     qDebug() << "message send mainloop finished";
 }
 
+void TestTextChan::queueMessage(ExampleEcho2Channel *chanService, TpHandle sender, int number)
+{
+    TpMessage *message = tp_cm_message_new(TP_BASE_CONNECTION(mConn->service()), 2);
+    tp_cm_message_set_sender(message, sender);
+    tp_message_set_uint32(message, 0, "message-type", TP_CHANNEL_TEXT_MESSAGE_TYPE_NORMAL);
+    tp_message_set_string(message, 1, "content-type", "text/plain");
+    QByteArray text = QByteArray::number(number);
+    tp_message_set_string(message, 1, "content", text.constData());
+    tp_message_mixin_take_received(G_OBJECT(chanService), message);
+}
+
 void TestTextChan::initTestCase()
 {
     initTestCaseImpl();
@@ -534,6 +552,180 @@ void TestTextChan::testLegacyText()
     commonTest(false);
 }
 
+void TestTextChan::testDeliveryOrder_data()
+{
+    QTest::addColumn<bool>("incremental");
+
+    QTest::newRow("in order") << false;
+    QTest::newRow("incremental") << true;
+}
+
+void TestTextChan::testDeliveryOrder()
+{
+    QFETCH(bool, incremental);
+
+    const int numInitial = 6;
+    const int numLate = 20;
+    const int numSenders = 4;
+
+    QString chanPath = mConn->objectPath() + QLatin1String("/DeliveryOrderChannel") +
+        QLatin1String(incremental ? "Incremental" : "InOrder");
+    QByteArray chanPathLatin1(chanPath.toAscii());
+    guint handle = tp_handle_ensure(mContactRepo, "someone@localhost", 0, 0);
+    ExampleEcho2Channel *chanService = EXAMPLE_ECHO_2_CHANNEL(g_object_new(
+                EXAMPLE_TYPE_ECHO_2_CHANNEL,
+                "connection", mConn->service(),
+                "object-path", chanPathLatin1.data(),
+                "handle", handle,
+                NULL));
+
+    QStringList senderIds;
+    QVector<TpHandle> senders;
+    for (int i = 0; i < numSenders * 2; ++i) {
+        senderIds << QString(QLatin1String("order-sender%1@localhost")).arg(i);
+        senders << tp_handle_ensure(mContactRepo, senderIds.last().toAscii().constData(), 0, 0);
+    }
+
+    for (int i = 0; i < numInitial; ++i) {
+        queueMessage(chanService, senders.at(i % numSenders), i);
+    }
+
+    mChan = TextChannel::create(mConn->client(), chanPath, QVariantMap());
+    PendingReady *pr = mChan->becomeReady(TextChannel::FeatureMessageQueue);
+    // Changing the delivery mode while the pending messages are still being fetched must not
+    // make the message queue ready without them
+    mChan->setIncrementalMessageDeliveryEnabled(true);
+    mChan->setIncrementalMessageDeliveryEnabled(incremental);
+    QVERIFY(!mChan->isReady(TextChannel::FeatureMessageQueue));
+    QVERIFY(connect(pr,
+                SIGNAL(finished(Tp::PendingOperation *)),
+                SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+    QCOMPARE(mLoop->exec(), 0);
+    QVERIFY(mChan->isReady(TextChannel::FeatureMessageQueue));
+
+    QList<ReceivedMessage> queue = mChan->messageQueue();
+    QCOMPARE(queue.size(), numInitial);
+    for (int i = 0; i < numInitial; ++i) {
+        QCOMPARE(queue[i].text(), QString::number(i));
+        QVERIFY(!queue[i].sender().isNull());
+        QCOMPARE(queue[i].sender()->id(), senderIds[i % numSenders]);
+    }
+
+    QVERIFY(connect(mChan.data(),
+                SIGNAL(messageReceived(const Tp::ReceivedMessage &)),
+                SLOT(onMessageReceived(const Tp::ReceivedMessage &))));
+
+    // New messages, half of them from senders which haven't been retrieved yet
+    for (int i = numInitial; i < numInitial + numLate; ++i) {
+        queueMessage(chanService, senders.at(i % (numSenders * 2)), i);
+    }
+    while (received.size() < numLate) {
+        QCOMPARE(mLoop->exec(), 0);
+    }
+    QCOMPARE(received.size(), numLate);
+
+    // Messages are only delivered once their sender is known, and the messages of each sender
+    // arrive in order. Without incremental delivery, the overall order is kept too.
+    QHash<QString, int> lastFromSender;
+    QList<int> deliveryOrder;
+    for (int i = 0; i < numLate; ++i) {
+        const ReceivedMessage &message = received[i];
+        int number = message.text().toInt();
+        deliveryOrder << number;
+        QVERIFY(!message.sender().isNull());
+        QCOMPARE(message.sender()->id(), senderIds[number % (numSenders * 2)]);
+        QVERIFY(lastFromSender.value(message.sender()->id(), -1) < number);
+        lastFromSender.insert(message.sender()->id(), number);
+        if (!incremental) {
+            QCOMPARE(number, numInitial + i);
+        }
+    }
+
+    // With incremental delivery, the messages from the senders which were already known don't
+    // wait for the ones still being retrieved: the first late message is from a new sender, and
+    // the one two places after it, from a known sender, overtakes it
+    QVERIFY(numInitial % (numSenders * 2) >= numSenders);
+    QVERIFY((numInitial + 2) % (numSenders * 2) < numSenders);
+    if (incremental) {
+        QVERIFY(deliveryOrder.indexOf(numInitial + 2) < deliveryOrder.indexOf(numInitial));
+    } else {
+        QVERIFY(deliveryOrder.indexOf(numInitial + 2) > deliveryOrder.indexOf(numInitial));
+    }
+
+    // The message queue has them in the order they were delivered
+    queue = mChan->messageQueue();
+    QCOMPARE(queue.size(), numInitial + numLate);
+    for (int i = 0; i < numLate; ++i) {
+        QCOMPARE(queue[numInitial + i].text(), received[i].text());
+    }
+
+    mChan.reset();
+    g_object_unref(chanService);
+}
+
+#ifdef ENABLE_BENCHMARKS
+void TestTextChan::testMessageQueueBenchmark_data()
+{
+    QTest::addColumn<bool>("incremental");
+
+    QTest::newRow("in order") << false;
+    QTest::newRow("incremental") << true;
+}
+
+void TestTextChan::testMessageQueueBenchmark()
+{
+    QFETCH(bool, incremental);
+
+    const int numMessages = 100000;
+    const int numSenders = 100;
+
+    // use a fresh channel so the queue only contains the messages queued here
+    QString chanPath = mConn->objectPath() + QLatin1String("/BenchmarkChannel") +
+        QLatin1String(incremental ? "Incremental" : "InOrder");
+    QByteArray chanPathLatin1(chanPath.toAscii());
+    guint handle = tp_handle_ensure(mContactRepo, "someone@localhost", 0, 0);
+    ExampleEcho2Channel *chanService = EXAMPLE_ECHO_2_CHANNEL(g_object_new(
+                EXAMPLE_TYPE_ECHO_2_CHANNEL,
+                "connection", mConn->service(),
+                "object-path", chanPathLatin1.data(),
+                "handle", handle,
+                NULL));
+
+    QVector<TpHandle> senders;
+    for (int i = 0; i < numSenders; ++i) {
+        QByteArray id = QString(QLatin1String("sender%1@localhost")).arg(i).toAscii();
+        senders << tp_handle_ensure(mContactRepo, id.constData(), 0, 0);
+    }
+
+    for (int i = 0; i < numMessages; ++i) {
+        queueMessage(chanService, senders.at(i % numSenders), i);
+    }
+
+    QBENCHMARK_ONCE {
+        mChan = TextChannel::create(mConn->client(), chanPath, QVariantMap());
+        mChan->setIncrementalMessageDeliveryEnabled(incremental);
+        QVERIFY(connect(mChan->becomeReady(TextChannel::FeatureMessageQueue),
+                    SIGNAL(finished(Tp::PendingOperation *)),
+                    SLOT(expectSuccessfulCall(Tp::PendingOperation *))));
+        QCOMPARE(mLoop->exec(), 0);
+        QVERIFY(mChan->isReady(TextChannel::FeatureMessageQueue));
+        QCOMPARE(mChan->messageQueue().size(), numMessages);
+
+        mChan->acknowledge(mChan->messageQueue());
+        QCOMPARE(mChan->messageQueue().size(), 0);
+        processDBusQueue(mChan.data());
+        while (tp_message_mixin_has_pending_messages(G_OBJECT(chanService), 0)) {
+            QTest::qWait(1);
+        }
+    }
+
+    QVERIFY(!tp_message_mixin_has_pending_messages(G_OBJECT(chanService), 0));
+
+    mChan.reset();
+    g_object_unref(chanService);
+}
+#endif
+
 void TestTextChan::cleanup()
 {
     received.clear();
@@ -0,0 +1,221 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/debug-internal.h"
+
+#include <TelepathyQt/Debug>
+
+using namespace Tp;
+
+class TestDebug : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testCategories();
+    void testRingBuffer();
+    void testRingBufferTruncation();
+    void testRingBufferConcurrency();
+
+    void cleanup();
+};
+
+static QList<QPair<QtMsgType, QString> > messages;
+
+#ifdef ENABLE_DEBUG
+class DebugWriter : public QThread
+{
+public:
+    DebugWriter(char letter, int count)
+        : mLetter(letter), mCount(count)
+    { }
+
+protected:
+    void run()
+    {
+        // long enough for torn copies to be likely if slots were written concurrently
+        QString text(300, QLatin1Char(mLetter));
+        for (int i = 0; i < mCount; ++i) {
+            enabledDebug() << text;
+        }
+    }
+
+private:
+    char mLetter;
+    int mCount;
+};
+
+static bool isIntact(const QString &msg)
+{
+    // each message is a single letter repeated, maybe quoted
+    QString text = msg;
+    text.remove(QLatin1Char('"'));
+    text = text.trimmed();
+    return text.size() == 300 && text.count(text.at(0)) == 300;
+}
+#endif
+
+static void recordMessage(const QString &libraryName, const QString &libraryVersion,
+        QtMsgType type, const QString &msg)
+{
+    Q_UNUSED(libraryName);
+    Q_UNUSED(libraryVersion);
+    messages << qMakePair(type, msg);
+}
+
+void TestDebug::init()
+{
+    messages.clear();
+    setDebugCallback(recordMessage);
+    enableDebug(true);
+    enableWarnings(true);
+}
+
+void TestDebug::testCategories()
+{
+#ifdef ENABLE_DEBUG
+    QCOMPARE(enabledDebugCategories(), static_cast<uint>(DebugCategoryAll));
+
+    enabledDebug() << "first";
+    QCOMPARE(messages.size(), 1);
+    QCOMPARE(messages[0].first, QtDebugMsg);
+    QVERIFY(messages[0].second.contains(QLatin1String("first")));
+
+    // debug() is in the general category
+    enableDebugCategories(DebugCategoryGeneral, false);
+    QCOMPARE(enabledDebugCategories(),
+            static_cast<uint>(DebugCategoryAll & ~DebugCategoryGeneral));
+    enabledDebug() << "second";
+    QCOMPARE(messages.size(), 1);
+
+    // warnings are not affected by the categories
+    enabledWarning() << "warning";
+    QCOMPARE(messages.size(), 2);
+    QCOMPARE(messages[1].first, QtWarningMsg);
+
+    enableDebugCategories(DebugCategoryGeneral, true);
+    enabledDebug() << "third";
+    QCOMPARE(messages.size(), 3);
+
+    // nor is anything output with debug output disabled, whatever the categories
+    enableDebug(false);
+    enabledDebug() << "fourth";
+    QCOMPARE(messages.size(), 3);
+#endif
+}
+
+void TestDebug::testRingBuffer()
+{
+#ifdef ENABLE_DEBUG
+    setDebugRingBufferSize(3);
+
+    for (int i = 0; i < 5; ++i) {
+        enabledDebug() << "message" << i;
+    }
+    enabledWarning() << "warning";
+
+    // debug messages are kept until they're asked for, warnings are output right away
+    QCOMPARE(messages.size(), 1);
+    QCOMPARE(messages[0].first, QtWarningMsg);
+
+    // only the last ones fit
+    dumpDebugRingBuffer();
+    QCOMPARE(messages.size(), 4);
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(messages[i + 1].first, QtDebugMsg);
+        QVERIFY(messages[i + 1].second.contains(QString(QLatin1String("message %1")).arg(i + 2)));
+    }
+
+    // and dumped only once
+    dumpDebugRingBuffer();
+    QCOMPARE(messages.size(), 4);
+
+    enabledDebug() << "message" << 5;
+    dumpDebugRingBuffer();
+    QCOMPARE(messages.size(), 5);
+    QVERIFY(messages[4].second.contains(QLatin1String("message 5")));
+
+    setDebugRingBufferSize(0);
+    enabledDebug() << "message" << 6;
+    QCOMPARE(messages.size(), 6);
+#endif
+}
+
+void TestDebug::testRingBufferTruncation()
+{
+#ifdef ENABLE_DEBUG
+    setDebugRingBufferSize(2);
+
+    enabledDebug() << QString(1000, QLatin1Char('x'));
+    enabledDebug() << "short";
+    dumpDebugRingBuffer();
+
+    // long messages are cut, but it shows
+    QCOMPARE(messages.size(), 2);
+    QVERIFY(messages[0].second.endsWith(QLatin1String(" [truncated]")));
+    QVERIFY(messages[0].second.size() < 1000);
+    QVERIFY(!messages[1].second.endsWith(QLatin1String(" [truncated]")));
+#endif
+}
+
+void TestDebug::testRingBufferConcurrency()
+{
+#ifdef ENABLE_DEBUG
+    // a size which isn't a power of two
+    setDebugRingBufferSize(7);
+
+    QList<DebugWriter *> writers;
+    for (int i = 0; i < 4; ++i) {
+        writers << new DebugWriter('a' + i, 20000);
+    }
+    Q_FOREACH (DebugWriter *writer, writers) {
+        writer->start();
+    }
+
+    // dump while the writers are busy, only whole messages must come out
+    bool running = true;
+    while (running) {
+        dumpDebugRingBuffer();
+        running = false;
+        Q_FOREACH (DebugWriter *writer, writers) {
+            if (!writer->isFinished()) {
+                running = true;
+            }
+        }
+    }
+    dumpDebugRingBuffer();
+
+    Q_FOREACH (DebugWriter *writer, writers) {
+        writer->wait();
+        delete writer;
+    }
+
+    QVERIFY(!messages.isEmpty());
+    for (int i = 0; i < messages.size(); ++i) {
+        QCOMPARE(messages[i].first, QtDebugMsg);
+        QVERIFY2(isIntact(messages[i].second), qPrintable(messages[i].second));
+    }
+
+    // once the writers are done, the last messages are all there
+    messages.clear();
+    for (int i = 0; i < 10; ++i) {
+        enabledDebug() << "message" << i;
+    }
+    dumpDebugRingBuffer();
+    QCOMPARE(messages.size(), 7);
+    QVERIFY(messages[6].second.contains(QLatin1String("message 9")));
+#endif
+}
+
+void TestDebug::cleanup()
+{
+    setDebugRingBufferSize(0);
+    enableDebugCategories(DebugCategoryAll, true);
+    enableDebug(false);
+    setDebugCallback(0);
+}
+
+QTEST_MAIN(TestDebug)
+
+#include "_gen/debug.cpp.moc.hpp"
@@ -1,5 +1,7 @@
 #include <QtTest/QtTest>
 
+#include "TelepathyQt/feature-set.h"
+
 #include <TelepathyQt/Constants>
 #include <TelepathyQt/Debug>
 #include <TelepathyQt/Feature>
@@ -29,6 +31,12 @@ public:
 
 private Q_SLOTS:
     void testFeaturesHash();
+    void testFeatureSet();
+
+    void benchmarkContains_data();
+    void benchmarkContains();
+    void benchmarkMissingFeatures_data();
+    void benchmarkMissingFeatures();
 };
 
 TestFeatures::TestFeatures(QObject *parent)
@@ -68,6 +76,165 @@ void TestFeatures::testFeaturesHash()
     QVERIFY(qHash(fs1.toSet()) != qHash(fs2.toSet()));
 }
 
+void TestFeatures::testFeatureSet()
+{
+    Feature a(QLatin1String("TestFeatureSet"), 0);
+    Feature b(QLatin1String("TestFeatureSet"), 1, true);
+    Feature c(QLatin1String("TestFeatureSet"), 2);
+    // features are told apart by their class name and id, not by the object
+    Feature otherA(QLatin1String("TestFeatureSet"), 0);
+
+    FeatureSet set;
+    QVERIFY(set.isEmpty());
+    QCOMPARE(set.size(), 0);
+
+    set.insert(a);
+    set.insert(b);
+    QVERIFY(!set.isEmpty());
+    QCOMPARE(set.size(), 2);
+    QVERIFY(set.contains(a));
+    QVERIFY(set.contains(otherA));
+    QVERIFY(set.contains(b));
+    QVERIFY(!set.contains(c));
+
+    QCOMPARE(set.toFeatures(), Features() << a << b);
+    Q_FOREACH (const Feature &feature, set.toList()) {
+        QCOMPARE(feature.isCritical(), feature == b);
+    }
+
+    FeatureSet other(Features() << b << c);
+    QVERIFY(set.intersects(other));
+    QVERIFY(!set.contains(other));
+    QCOMPARE((set - other).toFeatures(), Features() << a);
+    QCOMPARE(FeatureSet(set).intersect(other).toFeatures(), Features() << b);
+    QCOMPARE(FeatureSet(set).unite(other).toFeatures(), Features() << a << b << c);
+    QVERIFY(FeatureSet(set).unite(other).contains(other));
+
+    set.remove(b);
+    QVERIFY(!set.intersects(other));
+    // the view returned before the change is not reused
+    QCOMPARE(set.toFeatures(), Features() << a);
+    QVERIFY(set == FeatureSet(otherA));
+    set.remove(a);
+    QVERIFY(set.isEmpty());
+    QVERIFY(set == FeatureSet());
+
+    // a feature registered after others doesn't affect comparisons with smaller sets
+    Feature late(QLatin1String("TestFeatureSetLate"), 100);
+    FeatureSet withLate(late);
+    withLate.remove(late);
+    QVERIFY(withLate == FeatureSet());
+    QVERIFY(FeatureSet().contains(withLate));
+}
+
+namespace {
+
+// A contact manager with 1000 contacts, which have been requested with some of the 12 contact
+// features each
+const int numFeatures = 12;
+const int numContacts = 1000;
+
+QList<Feature> contactFeatures()
+{
+    QList<Feature> ret;
+    for (int i = 0; i < numFeatures; ++i) {
+        ret << Feature(QLatin1String("Tp::Contact"), i);
+    }
+    return ret;
+}
+
+}
+
+void TestFeatures::benchmarkContains_data()
+{
+    QTest::addColumn<bool>("bitset");
+
+    QTest::newRow("QSet") << false;
+    QTest::newRow("bitset") << true;
+}
+
+void TestFeatures::benchmarkContains()
+{
+    QFETCH(bool, bitset);
+
+    QList<Feature> all = contactFeatures();
+    Features features = Features() << all[0] << all[2] << all[5] << all[7];
+    FeatureSet featureSet(features);
+
+    int found = 0;
+    if (bitset) {
+        QBENCHMARK {
+            Q_FOREACH (const Feature &feature, all) {
+                if (featureSet.contains(feature)) {
+                    ++found;
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            Q_FOREACH (const Feature &feature, all) {
+                if (features.contains(feature)) {
+                    ++found;
+                }
+            }
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void TestFeatures::benchmarkMissingFeatures_data()
+{
+    QTest::addColumn<bool>("bitset");
+
+    QTest::newRow("QSet") << false;
+    QTest::newRow("bitset") << true;
+}
+
+void TestFeatures::benchmarkMissingFeatures()
+{
+    QFETCH(bool, bitset);
+
+    // what ContactManager::contactsForHandles() does for contacts it already knows about
+    QList<Feature> all = contactFeatures();
+    QList<Features> contacts;
+    QList<FeatureSet> contactSets;
+    for (int i = 0; i < numContacts; ++i) {
+        Features requested;
+        for (int j = 0; j < numFeatures; ++j) {
+            if ((i + j) % 3) {
+                requested << all[j];
+            }
+        }
+        contacts << requested;
+        contactSets << FeatureSet(requested);
+    }
+    Features wanted = Features() << all[0] << all[1] << all[2];
+
+    Features missing;
+    if (bitset) {
+        QBENCHMARK {
+            FeatureSet wantedSet(wanted);
+            FeatureSet missingSet;
+            Q_FOREACH (const FeatureSet &requested, contactSets) {
+                if (!requested.contains(wantedSet)) {
+                    missingSet.unite(wantedSet - requested);
+                }
+            }
+            missing = missingSet.toFeatures();
+        }
+    } else {
+        QBENCHMARK {
+            missing.clear();
+            Q_FOREACH (const Features &requested, contacts) {
+                if (!(wanted - requested).isEmpty()) {
+                    missing.unite(wanted - requested);
+                }
+            }
+        }
+    }
+    QCOMPARE(missing, wanted);
+}
+
 QTEST_MAIN(TestFeatures)
 
 #include "_gen/features.cpp.moc.hpp"
@@ -0,0 +1,181 @@
+#include <QtTest/QtTest>
+
+#include <QBuffer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryFile>
+
+#include "TelepathyQt/file-transfer-engine.h"
+
+using namespace Tp;
+
+class TestFileTransferEngine : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testOffsets();
+    void testThroughput_data();
+    void testThroughput();
+
+    void cleanup();
+    void cleanupTestCase();
+
+private:
+    bool transfer(FileTransferSender *sender, FileTransferReceiver *receiver, qint64 until);
+
+    QTemporaryFile *mFile;
+    QByteArray mData;
+    QTcpServer *mServer;
+    QTcpSocket *mClient;
+    QTcpSocket *mPeer;
+};
+
+bool TestFileTransferEngine::transfer(FileTransferSender *sender,
+        FileTransferReceiver *receiver, qint64 until)
+{
+    QTime timer;
+    timer.start();
+
+    bool sending = true;
+    while (receiver->position() < until) {
+        if (timer.elapsed() > 60 * 1000) {
+            qWarning() << "Transfer timed out at" << receiver->position();
+            return false;
+        }
+
+        FileTransferEngine::Status status = FileTransferEngine::Progress;
+        while (sending && status == FileTransferEngine::Progress) {
+            status = sender->transfer();
+        }
+        if (status == FileTransferEngine::Error) {
+            return false;
+        } else if (status == FileTransferEngine::Finished) {
+            sending = false;
+        }
+
+        // hand whatever got buffered by the socket to the kernel, and read it on the other end
+        mClient->flush();
+        mPeer->waitForReadyRead(10);
+
+        do {
+            status = receiver->transfer();
+        } while (status == FileTransferEngine::Progress);
+        if (status == FileTransferEngine::Error) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TestFileTransferEngine::initTestCase()
+{
+    // 32 MiB of data which isn't just the same byte over and over
+    mData.resize(32 * 1024 * 1024);
+    for (int i = 0; i < mData.size(); ++i) {
+        mData[i] = static_cast<char>((i * 31) ^ (i >> 12));
+    }
+
+    mFile = new QTemporaryFile();
+    QVERIFY(mFile->open());
+    QCOMPARE(mFile->write(mData), static_cast<qint64>(mData.size()));
+    mFile->close();
+}
+
+void TestFileTransferEngine::init()
+{
+    mServer = new QTcpServer();
+    QVERIFY(mServer->listen(QHostAddress::LocalHost));
+
+    mClient = new QTcpSocket();
+    mClient->connectToHost(QHostAddress::LocalHost, mServer->serverPort());
+    QVERIFY(mClient->waitForConnected());
+    QVERIFY(mServer->waitForNewConnection(5000));
+    mPeer = mServer->nextPendingConnection();
+    QVERIFY(mPeer);
+}
+
+void TestFileTransferEngine::testOffsets()
+{
+    QFile input(mFile->fileName());
+    QVERIFY(input.open(QIODevice::ReadOnly));
+
+    QBuffer output;
+    QVERIFY(output.open(QIODevice::WriteOnly));
+
+    // the sender starts at 1000 (by seeking), the receiver only wants data from 1500 onwards
+    const qint64 total = 1024 * 1024;
+    FileTransferSender sender(&input, mClient);
+    sender.setOffset(1000);
+    QCOMPARE(sender.position(), static_cast<qint64>(1000));
+
+    FileTransferReceiver receiver(mPeer, &output);
+    receiver.setOffset(1000, 1500);
+
+    QVERIFY(transfer(&sender, &receiver, total));
+    QVERIFY(receiver.position() >= total);
+    QCOMPARE(output.data().left(total - 1500), mData.mid(1500, total - 1500));
+}
+
+void TestFileTransferEngine::testThroughput_data()
+{
+    QTest::addColumn<bool>("zeroCopy");
+
+    QTest::newRow("buffered") << false;
+    QTest::newRow("zero-copy") << true;
+}
+
+void TestFileTransferEngine::testThroughput()
+{
+    QFETCH(bool, zeroCopy);
+
+    QFile input(mFile->fileName());
+    QVERIFY(input.open(QIODevice::ReadOnly));
+
+    QBuffer output;
+    QVERIFY(output.open(QIODevice::WriteOnly));
+
+    FileTransferSender sender(&input, mClient);
+    sender.setZeroCopyEnabled(zeroCopy);
+    if (zeroCopy && !sender.isZeroCopy()) {
+        qDebug() << "Zero-copy transfers are not supported on this platform, skipping";
+        return;
+    }
+
+    FileTransferReceiver receiver(mPeer, &output);
+
+    QTime timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        QVERIFY(transfer(&sender, &receiver, mData.size()));
+    }
+    int elapsed = qMax(timer.elapsed(), 1);
+    qDebug() << "Transferred" << mData.size() / (1024 * 1024) << "MiB in" << elapsed << "ms -" <<
+        (mData.size() / 1024.0 / 1024.0) / (elapsed / 1000.0) << "MiB/s";
+
+    QCOMPARE(receiver.position(), static_cast<qint64>(mData.size()));
+    QVERIFY(output.data() == mData);
+}
+
+void TestFileTransferEngine::cleanup()
+{
+    delete mPeer;
+    mPeer = 0;
+    delete mClient;
+    mClient = 0;
+    delete mServer;
+    mServer = 0;
+}
+
+void TestFileTransferEngine::cleanupTestCase()
+{
+    delete mFile;
+}
+
+QTEST_MAIN(TestFileTransferEngine)
+
+#include "_gen/file-transfer-engine.cpp.moc.hpp"
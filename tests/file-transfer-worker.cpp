@@ -0,0 +1,368 @@
+#include <QtTest/QtTest>
+
+#include <QBuffer>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryFile>
+#include <QThread>
+
+#include "TelepathyQt/file-transfer-worker-internal.h"
+
+using namespace Tp;
+
+// Same as the interval used by the worker
+static const int PROGRESS_INTERVAL = 100;
+static const int TIMEOUT = 60 * 1000;
+
+class TestFileTransferWorker : public QObject
+{
+    Q_OBJECT
+
+protected Q_SLOTS:
+    void onConnected();
+    void onFinished();
+    void onProgressChanged();
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testCanRunInThread();
+    void testThreadedSend();
+    void testThreadedReceive();
+    void testProgressRateLimit();
+    void testFinishInputBlocks();
+    void testStopBlocks();
+
+    void cleanup();
+    void cleanupTestCase();
+
+private:
+    bool openInput();
+    void startWorker(FileTransferWorker::Direction direction, QIODevice *device);
+    bool waitFor(const bool &condition);
+    bool readAll(qint64 size, bool processEvents);
+    void deleteWorker();
+
+    QTemporaryFile *mFile;
+    QByteArray mData;
+    QTcpServer *mServer;
+    QTcpSocket *mPeer;
+    QByteArray mReceived;
+
+    // deleted after the worker, which may still be using it if a test failed
+    QIODevice *mDevice;
+    QFile *mInput;
+    QPointer<FileTransferWorker> mWorker;
+    bool mConnected;
+    bool mFinished;
+    QList<qint64> mProgress;
+};
+
+void TestFileTransferWorker::onConnected()
+{
+    mConnected = true;
+}
+
+void TestFileTransferWorker::onFinished()
+{
+    mFinished = true;
+}
+
+void TestFileTransferWorker::onProgressChanged()
+{
+    mProgress.append(mWorker->takeProgress());
+}
+
+bool TestFileTransferWorker::openInput()
+{
+    mInput = new QFile(mFile->fileName());
+    mDevice = mInput;
+    return mInput->open(QIODevice::ReadOnly);
+}
+
+void TestFileTransferWorker::startWorker(FileTransferWorker::Direction direction,
+        QIODevice *device)
+{
+    mWorker = new FileTransferWorker(direction, device);
+    connect(mWorker, SIGNAL(connected()), SLOT(onConnected()));
+    connect(mWorker, SIGNAL(finished()), SLOT(onFinished()));
+    connect(mWorker, SIGNAL(progressChanged()), SLOT(onProgressChanged()));
+
+    QVERIFY(FileTransferWorker::canRunInThread(device));
+    mWorker->moveToPool();
+    QVERIFY(mWorker->isThreaded());
+    QVERIFY(mWorker->thread() != QThread::currentThread());
+
+    mWorker->connectToHost(QLatin1String("127.0.0.1"), mServer->serverPort());
+    QVERIFY(mServer->waitForNewConnection(5000));
+    mPeer = mServer->nextPendingConnection();
+    QVERIFY(mPeer);
+}
+
+bool TestFileTransferWorker::waitFor(const bool &condition)
+{
+    QTime timer;
+    timer.start();
+    while (!condition) {
+        if (timer.elapsed() > TIMEOUT) {
+            return false;
+        }
+        QTest::qWait(10);
+    }
+    return true;
+}
+
+bool TestFileTransferWorker::readAll(qint64 size, bool processEvents)
+{
+    QTime timer;
+    timer.start();
+    while (mReceived.size() < size) {
+        if (timer.elapsed() > TIMEOUT) {
+            qWarning() << "Transfer timed out at" << mReceived.size();
+            return false;
+        }
+
+        if (processEvents) {
+            QTest::qWait(10);
+        } else {
+            mPeer->waitForReadyRead(10);
+        }
+        mReceived += mPeer->readAll();
+    }
+    return true;
+}
+
+void TestFileTransferWorker::deleteWorker()
+{
+    if (!mWorker) {
+        return;
+    }
+
+    mWorker->stop();
+    mWorker->deleteLater();
+
+    // deleted from the worker thread
+    QTime timer;
+    timer.start();
+    while (mWorker && timer.elapsed() < TIMEOUT) {
+        QTest::qWait(10);
+    }
+    QVERIFY(!mWorker);
+}
+
+void TestFileTransferWorker::initTestCase()
+{
+    // 32 MiB of data which isn't just the same byte over and over, enough to fill the socket
+    // buffers so that the worker has to wait for the peer
+    mData.resize(32 * 1024 * 1024);
+    for (int i = 0; i < mData.size(); ++i) {
+        mData[i] = static_cast<char>((i * 31) ^ (i >> 12));
+    }
+
+    mFile = new QTemporaryFile();
+    QVERIFY(mFile->open());
+    QCOMPARE(mFile->write(mData), static_cast<qint64>(mData.size()));
+    mFile->close();
+}
+
+void TestFileTransferWorker::init()
+{
+    mServer = new QTcpServer();
+    QVERIFY(mServer->listen(QHostAddress::LocalHost));
+    mPeer = 0;
+    mReceived.clear();
+    mDevice = 0;
+    mInput = 0;
+
+    mConnected = false;
+    mFinished = false;
+    mProgress.clear();
+}
+
+void TestFileTransferWorker::testCanRunInThread()
+{
+    QFile file(mFile->fileName());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(FileTransferWorker::canRunInThread(&file));
+
+    // other devices stay in the thread they belong to
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(!FileTransferWorker::canRunInThread(&buffer));
+}
+
+void TestFileTransferWorker::testThreadedSend()
+{
+    QVERIFY(openInput());
+
+    startWorker(FileTransferWorker::Send, mInput);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    // don't run the main loop while the data is pumped, so none of the progress notifications
+    // can be handled in the meantime
+    QVERIFY(readAll(mData.size(), false));
+    QVERIFY(mReceived == mData);
+
+    QVERIFY(waitFor(mFinished));
+
+    // the notifications which weren't handled were updated in place rather than queued again,
+    // the first one may have been taken before the transfer finished, in which case the end of
+    // the transfer was reported in one or two more
+    QTest::qWait(PROGRESS_INTERVAL * 2);
+    QVERIFY(!mProgress.isEmpty());
+    QVERIFY(mProgress.size() <= 3);
+    QCOMPARE(mProgress.last(), static_cast<qint64>(mData.size()));
+    QCOMPARE(mWorker->takeProgress(), static_cast<qint64>(mData.size()));
+
+    deleteWorker();
+}
+
+void TestFileTransferWorker::testThreadedReceive()
+{
+    QTemporaryFile *output = new QTemporaryFile();
+    mDevice = output;
+    QVERIFY(output->open());
+
+    startWorker(FileTransferWorker::Receive, output);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    QVERIFY(waitFor(mConnected));
+    const QByteArray data = mData.left(4 * 1024 * 1024);
+    QCOMPARE(mPeer->write(data), static_cast<qint64>(data.size()));
+    while (mPeer->bytesToWrite() > 0) {
+        QVERIFY(mPeer->waitForBytesWritten(5000));
+    }
+    mPeer->disconnectFromHost();
+
+    QVERIFY(waitFor(mFinished));
+    QCOMPARE(mWorker->takeProgress(), static_cast<qint64>(data.size()));
+
+    // once stopped, the output can be used from this thread again
+    mWorker->stop();
+    QVERIFY(output->flush());
+    QVERIFY(output->seek(0));
+    QVERIFY(output->readAll() == data);
+
+    deleteWorker();
+}
+
+void TestFileTransferWorker::testProgressRateLimit()
+{
+    QVERIFY(openInput());
+
+    startWorker(FileTransferWorker::Send, mInput);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    // read slowly, so the transfer lasts for a while
+    mPeer->setReadBufferSize(64 * 1024);
+
+    QTime timer;
+    timer.start();
+    const qint64 size = 4 * 1024 * 1024;
+    QVERIFY(readAll(size, true));
+    mPeer->setReadBufferSize(0);
+    QVERIFY(readAll(mData.size(), false));
+    QVERIFY(waitFor(mFinished));
+    QTest::qWait(PROGRESS_INTERVAL * 2);
+    int elapsed = timer.elapsed();
+
+    // one notification per interval at most, plus the final one when the transfer finishes
+    qDebug() << mProgress.size() << "progress notifications in" << elapsed << "ms";
+    QVERIFY(!mProgress.isEmpty());
+    QVERIFY(mProgress.size() <= elapsed / PROGRESS_INTERVAL + 2);
+    for (int i = 1; i < mProgress.size(); ++i) {
+        QVERIFY(mProgress[i] >= mProgress[i - 1]);
+    }
+    QCOMPARE(mProgress.last(), static_cast<qint64>(mData.size()));
+
+    deleteWorker();
+}
+
+void TestFileTransferWorker::testFinishInputBlocks()
+{
+    QVERIFY(openInput());
+
+    startWorker(FileTransferWorker::Send, mInput);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    // don't take the data, so the worker is left waiting for the socket
+    mPeer->setReadBufferSize(64 * 1024);
+    QVERIFY(waitFor(mConnected));
+
+    // the remaining input has been read by the time finishInput() returns
+    mWorker->finishInput();
+    QCOMPARE(mInput->pos(), static_cast<qint64>(mData.size()));
+    QVERIFY(mInput->atEnd());
+
+    mPeer->setReadBufferSize(0);
+    QVERIFY(readAll(mData.size(), false));
+    QVERIFY(mReceived == mData);
+
+    deleteWorker();
+}
+
+void TestFileTransferWorker::testStopBlocks()
+{
+    QVERIFY(openInput());
+
+    startWorker(FileTransferWorker::Send, mInput);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    mPeer->setReadBufferSize(64 * 1024);
+    QVERIFY(waitFor(mConnected));
+    QVERIFY(readAll(1024 * 1024, true));
+
+    // once stop() returns the worker is done with the input, so it can be used straight away
+    mWorker->stop();
+    QVERIFY(mInput->seek(0));
+    QVERIFY(mInput->read(1024) == mData.left(1024));
+
+    // and nothing touches it or reports progress anymore
+    QCoreApplication::processEvents();
+    int notifications = mProgress.size();
+    mWorker->finishInput();
+    QCOMPARE(mInput->pos(), static_cast<qint64>(1024));
+    QTest::qWait(PROGRESS_INTERVAL * 2);
+    QCOMPARE(mProgress.size(), notifications);
+    QVERIFY(!mFinished);
+
+    // stopping again is fine
+    mWorker->stop();
+    mInput->close();
+
+    deleteWorker();
+}
+
+void TestFileTransferWorker::cleanup()
+{
+    deleteWorker();
+    delete mDevice;
+    mDevice = 0;
+    mInput = 0;
+
+    delete mPeer;
+    mPeer = 0;
+    delete mServer;
+    mServer = 0;
+}
+
+void TestFileTransferWorker::cleanupTestCase()
+{
+    delete mFile;
+}
+
+QTEST_MAIN(TestFileTransferWorker)
+
+#include "_gen/file-transfer-worker.cpp.moc.hpp"
@@ -9,16 +9,44 @@ class TestKeyFile : public QObject
     Q_OBJECT
 
 private Q_SLOTS:
+    void initTestCase();
+
     void testKeyFile();
+    void testCache();
+    void testFuzz();
+
+    void benchmarkParse_data();
+    void benchmarkParse();
+
+    void cleanupTestCase();
+
+private:
+    void writeFile(const QByteArray &contents);
+
+    QString mTempFileName;
 };
 
-void TestKeyFile::testKeyFile()
+void TestKeyFile::initTestCase()
 {
     QString top_srcdir = QString::fromLocal8Bit(::getenv("abs_top_srcdir"));
     if (!top_srcdir.isEmpty()) {
         QDir::setCurrent(top_srcdir + QLatin1String("/tests"));
     }
 
+    mTempFileName = QDir::tempPath() + QString(QLatin1String("/key-file-%1.ini"))
+        .arg(QCoreApplication::applicationPid());
+}
+
+void TestKeyFile::writeFile(const QByteArray &contents)
+{
+    QFile file(mTempFileName);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    file.write(contents);
+    file.close();
+}
+
+void TestKeyFile::testKeyFile()
+{
     KeyFile defaultKeyFile;
     QCOMPARE(defaultKeyFile.status(), KeyFile::None);
 
@@ -106,6 +134,155 @@ void TestKeyFile::testKeyFile()
     QCOMPARE(keyFile.value(QLatin1String("default-escaped-semicolon")), QString(QLatin1String("foo;bar")));
 }
 
+void TestKeyFile::testCache()
+{
+    writeFile("[group]\nkey=first\n");
+    KeyFile keyFile(mTempFileName);
+    QCOMPARE(keyFile.status(), KeyFile::NoError);
+    keyFile.setGroup(QLatin1String("group"));
+    QCOMPARE(keyFile.value(QLatin1String("key")), QString(QLatin1String("first")));
+
+    // parsed again once the file changes
+    writeFile("[group]\nkey=second\\sone\nother=x\n");
+    keyFile.setFileName(mTempFileName);
+    keyFile.setGroup(QLatin1String("group"));
+    QCOMPARE(keyFile.value(QLatin1String("key")), QString(QLatin1String("second one")));
+    QCOMPARE(keyFile.rawValue(QLatin1String("key")), QString(QLatin1String("second\\sone")));
+    QVERIFY(keyFile.contains(QLatin1String("other")));
+
+    // copies and cached instances don't depend on the original object
+    KeyFile copy(keyFile);
+    KeyFile cached(mTempFileName);
+    keyFile.setFileName(QLatin1String("test-key-file-not-found.ini"));
+    QCOMPARE(keyFile.status(), KeyFile::NotFoundError);
+    QVERIFY(keyFile.allGroups().isEmpty());
+    QCOMPARE(copy.value(QLatin1String("key")), QString(QLatin1String("second one")));
+    cached.setGroup(QLatin1String("group"));
+    QCOMPARE(cached.value(QLatin1String("key")), QString(QLatin1String("second one")));
+
+    // a file of the same size renamed over the cached one, within the resolution of the
+    // modification time
+    writeFile("[group]\nkey=AAAA\n");
+    QCOMPARE(KeyFile(mTempFileName).status(), KeyFile::NoError);
+    QString newFileName = mTempFileName + QLatin1String(".new");
+    QFile newFile(newFileName);
+    QVERIFY(newFile.open(QFile::WriteOnly | QFile::Truncate));
+    newFile.write("[group]\nkey=BBBB\n");
+    newFile.close();
+    QVERIFY(QFile::remove(mTempFileName));
+    QVERIFY(QFile::rename(newFileName, mTempFileName));
+    keyFile.setFileName(mTempFileName);
+    keyFile.setGroup(QLatin1String("group"));
+    QCOMPARE(keyFile.value(QLatin1String("key")), QString(QLatin1String("BBBB")));
+
+    // errors aren't cached
+    writeFile("[group]\nkey=second one\nkey=again\n");
+    QCOMPARE(KeyFile(mTempFileName).status(), KeyFile::FormatError);
+    writeFile("[group]\nkey=third one\nkey2=again\n");
+    cached.setFileName(mTempFileName);
+    QCOMPARE(cached.status(), KeyFile::NoError);
+    cached.setGroup(QLatin1String("group"));
+    QCOMPARE(cached.value(QLatin1String("key2")), QString(QLatin1String("again")));
+}
+
+void TestKeyFile::testFuzz()
+{
+    QList<QByteArray> seeds;
+    Q_FOREACH (const QString &fileName, QStringList() << QLatin1String("test-key-file.ini") <<
+            QLatin1String("test-key-file-format-error.ini") <<
+            QLatin1String("telepathy/managers/test-manager-file.manager")) {
+        QFile file(fileName);
+        QVERIFY(file.open(QFile::ReadOnly));
+        seeds << file.readAll();
+    }
+
+    static const char interesting[] = "[]=#\\;\n\r\t ";
+
+    qsrand(42);
+    for (int round = 0; round < 500; ++round) {
+        QByteArray contents = seeds.at(round % seeds.size());
+
+        // flip, insert, remove and truncate some bytes
+        int mutations = 1 + qrand() % 8;
+        for (int i = 0; i < mutations && !contents.isEmpty(); ++i) {
+            int pos = qrand() % contents.size();
+            switch (qrand() % 4) {
+                case 0:
+                    contents[pos] = interesting[qrand() % (sizeof(interesting) - 1)];
+                    break;
+                case 1:
+                    contents.insert(pos, static_cast<char>(qrand() % 256));
+                    break;
+                case 2:
+                    contents.remove(pos, 1 + qrand() % 16);
+                    break;
+                default:
+                    contents.truncate(pos);
+                    break;
+            }
+        }
+
+        writeFile(contents);
+        KeyFile::clearCache();
+
+        KeyFile keyFile(mTempFileName);
+        QVERIFY2(keyFile.status() == KeyFile::NoError || keyFile.status() == KeyFile::FormatError,
+                contents.constData());
+        if (keyFile.status() != KeyFile::NoError) {
+            QVERIFY(keyFile.allGroups().isEmpty());
+            continue;
+        }
+
+        // everything which was parsed can be read back, and the same from the cache
+        KeyFile cached(mTempFileName);
+        QCOMPARE(cached.allGroups(), keyFile.allGroups());
+        Q_FOREACH (const QString &group, keyFile.allGroups()) {
+            keyFile.setGroup(group);
+            cached.setGroup(group);
+            QCOMPARE(cached.keys(), keyFile.keys());
+            Q_FOREACH (const QString &key, keyFile.keys()) {
+                QVERIFY(keyFile.contains(key));
+                QCOMPARE(cached.rawValue(key), keyFile.rawValue(key));
+                QCOMPARE(cached.value(key), keyFile.value(key));
+                QCOMPARE(cached.valueAsStringList(key), keyFile.valueAsStringList(key));
+            }
+        }
+    }
+}
+
+void TestKeyFile::benchmarkParse_data()
+{
+    QTest::addColumn<bool>("cached");
+
+    QTest::newRow("uncached") << false;
+    QTest::newRow("cached") << true;
+}
+
+void TestKeyFile::benchmarkParse()
+{
+    QFETCH(bool, cached);
+
+    QString fileName = QLatin1String("telepathy/managers/test-manager-file.manager");
+    KeyFile::clearCache();
+
+    QBENCHMARK {
+        if (!cached) {
+            KeyFile::clearCache();
+        }
+
+        KeyFile keyFile(fileName);
+        keyFile.setGroup(QLatin1String("Protocol somewhat-pathological"));
+        Q_FOREACH (const QString &key, keyFile.keys()) {
+            keyFile.value(key);
+        }
+    }
+}
+
+void TestKeyFile::cleanupTestCase()
+{
+    QFile::remove(mTempFileName);
+}
+
 QTEST_MAIN(TestKeyFile)
 
 #include "_gen/key-file.cpp.moc.hpp"
@@ -225,6 +225,16 @@ void TestManagerFile::testManagerFile()
     QCOMPARE(param->signature, QString(QLatin1String("as")));
     QCOMPARE(param->defaultValue.variant().toStringList(),
              QStringList() << QString());
+
+    // parsed again from scratch once the cache is cleared
+    ManagerFile::clearCache();
+    ManagerFile reparsed(QLatin1String("test-manager-file"));
+    QCOMPARE(reparsed.isValid(), true);
+    QStringList reparsedProtocols = reparsed.protocols();
+    reparsedProtocols.sort();
+    QCOMPARE(reparsedProtocols, protocols);
+    QCOMPARE(reparsed.parameters(QLatin1String("foo")).size(),
+             managerFile.parameters(QLatin1String("foo")).size());
 }
 
 QTEST_MAIN(TestManagerFile)
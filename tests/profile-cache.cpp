@@ -0,0 +1,110 @@
+#include <QtTest/QtTest>
+
+#include "TelepathyQt/profile-cache.h"
+
+using namespace Tp;
+
+class TestProfileCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testFirstValidProfileWins();
+
+    void cleanupTestCase();
+
+private:
+    void writeProfile(const QString &dir, const QString &serviceName, const QByteArray &type,
+            const QByteArray &provider);
+
+    QString mDir;
+    QString mCacheDir;
+    QStringList mFiles;
+};
+
+void TestProfileCache::writeProfile(const QString &dir, const QString &serviceName,
+        const QByteArray &type, const QByteArray &provider)
+{
+    QString fileName = dir + QLatin1Char('/') + serviceName + QLatin1String(".profile");
+    QVERIFY(QDir().mkpath(dir));
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    file.write("<service xmlns=\"http://telepathy.freedesktop.org/wiki/service-profile-v1\"\n"
+            "         id=\"" + serviceName.toLatin1() + "\"\n"
+            "         type=\"" + type + "\"\n"
+            "         provider=\"" + provider + "\"\n"
+            "         manager=\"testprofilecm\"\n"
+            "         protocol=\"testprofileproto\">\n"
+            "  <name>" + serviceName.toLatin1() + "</name>\n"
+            "</service>\n");
+    file.close();
+    mFiles << fileName;
+}
+
+void TestProfileCache::initTestCase()
+{
+    mDir = QDir::tempPath() + QString(QLatin1String("/profile-cache-%1"))
+        .arg(QCoreApplication::applicationPid());
+    mCacheDir = mDir + QLatin1String("/cache");
+}
+
+void TestProfileCache::testFirstValidProfileWins()
+{
+    QString first = mDir + QLatin1String("/first");
+    QString second = mDir + QLatin1String("/second");
+
+    // profiles which are rejected don't hide the ones for the same service further down the
+    // search path
+    writeProfile(first, QLatin1String("foo"), "AnotherType", "First");
+    writeProfile(second, QLatin1String("foo"), "IM", "Second");
+    writeProfile(first, QLatin1String("bar"), "IM", "First");
+    writeProfile(second, QLatin1String("bar"), "IM", "Second");
+
+    QString malformed = first + QLatin1String("/baz.profile");
+    QFile file(malformed);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    file.write("<service");
+    file.close();
+    mFiles << malformed;
+    writeProfile(second, QLatin1String("baz"), "IM", "Second");
+
+    QStringList searchDirs;
+    searchDirs << first + QLatin1Char('/') << second + QLatin1Char('/');
+
+    ProfileCache cache(mCacheDir);
+    QList<ProfilePtr> profiles = cache.profiles(searchDirs);
+    QCOMPARE(profiles.size(), 3);
+
+    QMap<QString, QString> providers;
+    Q_FOREACH (const ProfilePtr &profile, profiles) {
+        QVERIFY(profile->isValid());
+        QVERIFY(!providers.contains(profile->serviceName()));
+        providers.insert(profile->serviceName(), profile->provider());
+    }
+    QCOMPARE(providers.value(QLatin1String("foo")), QLatin1String("Second"));
+    QCOMPARE(providers.value(QLatin1String("bar")), QLatin1String("First"));
+    QCOMPARE(providers.value(QLatin1String("baz")), QLatin1String("Second"));
+
+    // the same profiles are read back from disk
+    profiles = ProfileCache(mCacheDir).profiles(searchDirs);
+    QCOMPARE(profiles.size(), 3);
+    Q_FOREACH (const ProfilePtr &profile, profiles) {
+        QCOMPARE(profile->provider(), providers.value(profile->serviceName()));
+    }
+}
+
+void TestProfileCache::cleanupTestCase()
+{
+    ProfileCache(mCacheDir).clear();
+    QDir().rmpath(mCacheDir);
+    Q_FOREACH (const QString &fileName, mFiles) {
+        QFile::remove(fileName);
+        QDir().rmpath(QFileInfo(fileName).absolutePath());
+    }
+}
+
+QTEST_MAIN(TestProfileCache)
+
+#include "_gen/profile-cache.cpp.moc.hpp"
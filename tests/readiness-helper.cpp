@@ -0,0 +1,205 @@
+#include <QtTest/QtTest>
+
+#include <TelepathyQt/Feature>
+#include <TelepathyQt/PendingReady>
+#include <TelepathyQt/ReadinessHelper>
+#include <TelepathyQt/RefCounted>
+#include <TelepathyQt/SharedPtr>
+
+using namespace Tp;
+
+namespace {
+
+class TestObject : public RefCounted
+{
+};
+
+typedef SharedPtr<TestObject> TestObjectPtr;
+
+const Feature FeatureA(QLatin1String("TestObject"), 0);
+const Feature FeatureB(QLatin1String("TestObject"), 1);
+const Feature FeatureC(QLatin1String("TestObject"), 2);
+const Feature FeatureD(QLatin1String("TestObject"), 3);
+
+}
+
+class TestReadinessHelper : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestReadinessHelper(QObject *parent = 0);
+
+    struct IntrospectData
+    {
+        TestReadinessHelper *test;
+        Feature feature;
+    };
+
+private Q_SLOTS:
+    void init();
+
+    void testIncrementalIntrospection();
+    void testFailedDependency();
+
+    void benchmarkIsReady();
+
+    void cleanup();
+
+private:
+    static void introspect(void *data);
+    void complete(const Feature &feature, bool success = true);
+
+    TestObjectPtr mObject;
+    ReadinessHelper *mHelper;
+    QList<IntrospectData *> mData;
+    QList<Feature> mStarted;
+};
+
+TestReadinessHelper::TestReadinessHelper(QObject *parent)
+    : QObject(parent),
+      mHelper(0)
+{
+}
+
+void TestReadinessHelper::introspect(void *data)
+{
+    IntrospectData *introspectData = static_cast<IntrospectData *>(data);
+    introspectData->test->mStarted.append(introspectData->feature);
+}
+
+void TestReadinessHelper::complete(const Feature &feature, bool success)
+{
+    mHelper->setIntrospectCompleted(feature, success,
+            success ? QString() : QLatin1String("org.freedesktop.Telepathy.Error.NotAvailable"),
+            success ? QString() : QLatin1String("Introspection failed"));
+    // let the helper iterate
+    QCoreApplication::processEvents();
+}
+
+void TestReadinessHelper::init()
+{
+    mObject = TestObjectPtr(new TestObject);
+
+    // A <- B, A <- C, (B, C) <- D
+    QList<Feature> features;
+    QList<Features> deps;
+    features << FeatureA << FeatureB << FeatureC << FeatureD;
+    deps << Features() << (Features() << FeatureA) << (Features() << FeatureA) <<
+        (Features() << FeatureB << FeatureC);
+
+    ReadinessHelper::Introspectables introspectables;
+    for (int i = 0; i < features.size(); ++i) {
+        IntrospectData *data = new IntrospectData;
+        data->test = this;
+        data->feature = features[i];
+        mData.append(data);
+
+        introspectables[features[i]] = ReadinessHelper::Introspectable(
+                QSet<uint>() << 0,
+                deps[i],
+                QStringList(),
+                &TestReadinessHelper::introspect,
+                data);
+    }
+
+    mHelper = new ReadinessHelper(mObject.data(), 0, introspectables);
+    mStarted.clear();
+}
+
+void TestReadinessHelper::testIncrementalIntrospection()
+{
+    PendingReady *pr = mHelper->becomeReady(Features() << FeatureD);
+    QCoreApplication::processEvents();
+
+    // only the feature without dependencies can be introspected first
+    QCOMPARE(mStarted, QList<Feature>() << FeatureA);
+
+    // both B and C only depend on A, so they are introspected at the same time
+    complete(FeatureA);
+    QCOMPARE(mStarted.size(), 3);
+    QVERIFY(mStarted.contains(FeatureB));
+    QVERIFY(mStarted.contains(FeatureC));
+
+    // D has to wait for C as well
+    complete(FeatureB);
+    QCOMPARE(mStarted.size(), 3);
+    QVERIFY(!pr->isFinished());
+
+    complete(FeatureC);
+    QCOMPARE(mStarted.size(), 4);
+    QCOMPARE(mStarted.last(), FeatureD);
+
+    complete(FeatureD);
+    QVERIFY(pr->isFinished());
+    QVERIFY(pr->isValid());
+    QVERIFY(mHelper->isReady(Features() << FeatureA << FeatureB << FeatureC << FeatureD));
+
+    // C finished after B, so it's the one D was waiting for
+    QCOMPARE(mHelper->criticalPath(),
+            QList<Feature>() << FeatureA << FeatureC << FeatureD);
+    QVERIFY(mHelper->introspectionTime(FeatureD) >= 0);
+    mHelper->dumpTimings();
+
+    // nothing is introspected again for features which are already ready
+    pr = mHelper->becomeReady(Features() << FeatureB);
+    QCoreApplication::processEvents();
+    QVERIFY(pr->isFinished());
+    QCOMPARE(mStarted.size(), 4);
+}
+
+void TestReadinessHelper::testFailedDependency()
+{
+    PendingReady *pr = mHelper->becomeReady(Features() << FeatureD);
+    QCoreApplication::processEvents();
+
+    QCOMPARE(mStarted, QList<Feature>() << FeatureA);
+    QCOMPARE(mHelper->introspectionTime(FeatureA), -1);
+
+    complete(FeatureA);
+    complete(FeatureB, false);
+
+    // D can't be introspected anymore, it's not critical so it doesn't fail the operation
+    QVERIFY(pr->isFinished());
+    QVERIFY(pr->isValid());
+    QVERIFY(!mStarted.contains(FeatureD));
+    QVERIFY(mHelper->missingFeatures().contains(FeatureB));
+    QVERIFY(mHelper->missingFeatures().contains(FeatureD));
+
+    // C is still being introspected
+    QVERIFY(!mHelper->isReady(FeatureC));
+    complete(FeatureC);
+    QVERIFY(mHelper->isReady(FeatureC));
+    QCOMPARE(mStarted.size(), 3);
+}
+
+void TestReadinessHelper::benchmarkIsReady()
+{
+    mHelper->becomeReady(Features() << FeatureD);
+    QCoreApplication::processEvents();
+    complete(FeatureA);
+    complete(FeatureB);
+    complete(FeatureC);
+    complete(FeatureD);
+
+    // what every ready object accessor ends up doing
+    Features all = Features() << FeatureA << FeatureB << FeatureC << FeatureD;
+    bool ready = true;
+    QBENCHMARK {
+        ready = ready && mHelper->isReady(FeatureB) && mHelper->isReady(all);
+    }
+    QVERIFY(ready);
+}
+
+void TestReadinessHelper::cleanup()
+{
+    delete mHelper;
+    mHelper = 0;
+    mObject.reset();
+    qDeleteAll(mData);
+    mData.clear();
+}
+
+QTEST_MAIN(TestReadinessHelper)
+
+#include "_gen/readiness-helper.cpp.moc.hpp"